@@ -0,0 +1,95 @@
+//! Micro benchmarks for the userspace side of a TCP SYN lookup: the in-process [`SynCache`]
+//! the proxy reads in ring-buffer lookup mode (standing in for the pinned BPF map, which needs
+//! `CAP_BPF` and a loaded program), and turning the hit into a `TcpObservation`. Pure CPU - no
+//! `bpf()` syscalls, no network.
+//!
+//! Like `bench_forwarding`, every case also prints its heap allocations per lookup, counted by
+//! a wrapping global allocator.
+//!
+//! ```bash
+//! cargo bench -p huginn-ebpf --bench bench_ebpf
+//! ```
+
+use std::hint::black_box;
+use std::net::Ipv4Addr;
+
+use criterion::{criterion_group, criterion_main, Criterion};
+use huginn_ebpf::{parse_syn_v4, SynCache, SynRawDataV4, DEFAULT_SYN_MAP_MAX_ENTRIES};
+
+mod common;
+
+use common::alloc::report_allocations_per;
+
+/// A Linux SYN from `ip:port` captured at `tick`: MSS, NOP, WS, NOP NOP, timestamps, SACK.
+fn syn_v4(ip: Ipv4Addr, port: u16, tick: u64) -> SynRawDataV4 {
+    #[rustfmt::skip]
+    let options: [u8; 40] = [
+        2, 4, 0x05, 0xb4,
+        1,
+        3, 3, 7,
+        1, 1,
+        8, 10, 0x12, 0x34, 0x56, 0x78, 0, 0, 0, 0,
+        4, 2,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    ];
+    SynRawDataV4 {
+        src_addr: u32::from_ne_bytes(ip.octets()),
+        src_port: port.to_be(),
+        window: 64240u16.to_be(),
+        optlen: 22,
+        ip_ttl: 64,
+        options,
+        tick,
+        ..SynRawDataV4::default()
+    }
+}
+
+/// A cache at steady state: as many records as the default SYN map holds, from distinct ports.
+fn filled_cache() -> SynCache {
+    let cache = SynCache::new(DEFAULT_SYN_MAP_MAX_ENTRIES);
+    let client = Ipv4Addr::new(198, 51, 100, 7);
+    for tick in 0..u64::from(DEFAULT_SYN_MAP_MAX_ENTRIES) {
+        let port = u16::try_from(tick % 60_000)
+            .unwrap_or(0)
+            .saturating_add(1024);
+        cache.insert_v4(syn_v4(client, port, tick));
+    }
+    cache
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark 1: SYN lookup after accept()
+// `hit` stores a record and takes it back, as one connection does (the ring
+// drain inserts, accept takes); `miss` looks up a client never captured
+// (keep-alive or SYN lost). `parse` builds the observation from a hit.
+// ---------------------------------------------------------------------------
+fn bench_syn_lookup(c: &mut Criterion) {
+    let cache = filled_cache();
+    let client = Ipv4Addr::new(192, 0, 2, 10);
+    let raw = syn_v4(client, 40000, u64::from(DEFAULT_SYN_MAP_MAX_ENTRIES));
+    let hit = || {
+        cache.insert_v4(black_box(raw));
+        cache.take_v4(black_box(client), 40000)
+    };
+    let miss = || cache.take_v4(black_box(Ipv4Addr::new(203, 0, 113, 1)), 40000);
+    let parse = || parse_syn_v4(black_box(&raw));
+
+    report_allocations_per("lookup", "syn_lookup/hit", || {
+        black_box(hit());
+    });
+    report_allocations_per("lookup", "syn_lookup/miss", || {
+        black_box(miss());
+    });
+    report_allocations_per("lookup", "syn_lookup/parse", || {
+        black_box(parse());
+    });
+
+    let mut group = c.benchmark_group("syn_lookup");
+    group.bench_function("hit", |b| b.iter(hit));
+    group.bench_function("miss", |b| b.iter(miss));
+    group.bench_function("parse", |b| b.iter(parse));
+    group.finish();
+}
+
+criterion_group!(ebpf_benches, bench_syn_lookup);
+criterion_main!(ebpf_benches);
@@ -0,0 +1,90 @@
+//! Micro benchmarks for the per-request rewrite work of `forward()`: upstream URI construction
+//! and X-Forwarded-* headers. Pure CPU - no network, no IO.
+//!
+//! Besides Criterion timings, every case reports its heap allocations per call, counted by the
+//! wrapping global allocator of `common::alloc`. Allocation counts are deterministic, so a
+//! change in the printed number is a regression (or win) regardless of machine noise.
+//!
+//! ```bash
+//! cargo bench --bench bench_forwarding
+//! ```
+
+use std::hint::black_box;
+use std::net::SocketAddr;
+
+use criterion::{criterion_group, criterion_main, Criterion};
+use http::uri::Authority;
+use http::{Request, Uri};
+use huginn_proxy_lib::proxy::forwarding::upstream_uri;
+use huginn_proxy_lib::proxy::handler::add_forwarded_headers;
+
+mod common;
+
+use common::alloc::report_allocations;
+
+// ---------------------------------------------------------------------------
+// Benchmark 1: upstream URI construction
+// `passthrough` reuses the request's path and query; `replace_path` swaps
+// the matched prefix, as a route with `replace_path` does.
+// ---------------------------------------------------------------------------
+fn bench_upstream_uri(c: &mut Criterion) {
+    // Parsed once per backend in the routing snapshot; cloned per request.
+    let authority = Authority::from_static("backend.internal:9000");
+    let original: Uri = "/api/users/42?fields=name,email&page=2"
+        .parse()
+        .unwrap_or_else(|e| panic!("invalid bench URI: {e}"));
+
+    let mut group = c.benchmark_group("upstream_uri");
+    for (name, replace_path) in [("passthrough", None), ("replace_path", Some("/v2"))] {
+        let run = || {
+            upstream_uri(authority.clone(), black_box(&original), "/api", replace_path)
+                .unwrap_or_else(|e| panic!("rewrite failed: {e}"))
+        };
+        report_allocations(&format!("upstream_uri/{name}"), || {
+            black_box(run());
+        });
+        group.bench_function(name, |b| b.iter(run));
+    }
+    group.finish();
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark 2: X-Forwarded-* headers
+// `new` sets X-Forwarded-For from scratch; `append` extends a value set by
+// a downstream proxy. Includes building the request, which is reported as a
+// separate baseline so its allocations can be subtracted.
+// ---------------------------------------------------------------------------
+fn bench_forwarded_headers(c: &mut Criterion) {
+    let peer: SocketAddr = "[2001:db8:85a3::8a2e:370:7334]:51234"
+        .parse()
+        .unwrap_or_else(|e| panic!("invalid bench peer: {e}"));
+    let request = |existing_for: Option<&'static str>| {
+        let mut builder = Request::get("/");
+        if let Some(value) = existing_for {
+            builder = builder.header("x-forwarded-for", value);
+        }
+        builder
+            .body(())
+            .unwrap_or_else(|e| panic!("invalid bench request: {e}"))
+    };
+
+    let mut group = c.benchmark_group("forwarded_headers");
+    for (name, existing_for) in [("new", None), ("append", Some("198.51.100.1, 203.0.113.9"))] {
+        report_allocations(&format!("forwarded_headers/{name}/request_only"), || {
+            black_box(request(existing_for));
+        });
+        let run = || {
+            let mut req = request(existing_for);
+            add_forwarded_headers(&mut req, black_box(peer), true, "api.example.com");
+            req
+        };
+        report_allocations(&format!("forwarded_headers/{name}"), || {
+            black_box(run());
+        });
+        group.bench_function(name, |b| b.iter(run));
+    }
+    group.finish();
+}
+
+criterion_group!(forwarding_benches, bench_upstream_uri, bench_forwarded_headers);
+criterion_main!(forwarding_benches);
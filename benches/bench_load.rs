@@ -0,0 +1,393 @@
+//! Pinned load scenarios through a real proxy instance: fixed concurrency, fixed request
+//! counts, so runs on the same machine are comparable.
+//!
+//! - `connection_storm`: every request is a new client, so a new TCP connection and TLS
+//!   handshake (HTTP/1.1) - the shape of scanners, bots and clients without keep-alive.
+//! - `h2_long_lived`: one HTTP/2 connection, opened once, multiplexing every request - the shape
+//!   of browsers and service meshes.
+//!
+//! Besides the Criterion timings, each scenario prints the **allocations per request** next to
+//! its p50/p99 latency over a pinned run, counted by a wrapping global allocator. The count is
+//! process-wide: it includes the reqwest client and the embedded backend, which do the same work
+//! on every run, so a change between two commits is the proxy's.
+//!
+//! Setup as in `bench_proxy`: rcgen self-signed cert, embedded Hyper HTTP/1.1 backend, TLS and
+//! HTTP fingerprinting on, TCP SYN (eBPF) fingerprinting off.
+//!
+//! ```bash
+//! cargo bench --bench bench_load
+//! ```
+
+use std::convert::Infallible;
+use std::future::Future;
+use std::net::SocketAddr;
+use std::sync::{Arc, OnceLock};
+use std::time::{Duration, Instant};
+
+use arc_swap::ArcSwap;
+use bytes::Bytes;
+use criterion::{criterion_group, criterion_main, Criterion, Throughput};
+use http_body_util::Full;
+use huginn_proxy_lib::config::{
+    Backend, Domain, FingerprintConfig, KeepAliveConfig, ListenConfig, LoggingConfig, Route,
+    SecurityConfig, TelemetryConfig, TimeoutConfig,
+};
+use huginn_proxy_lib::{Config, TlsConfig};
+use hyper::service::service_fn;
+use hyper::Response;
+use hyper_util::rt::{TokioExecutor, TokioIo};
+use hyper_util::server::conn::auto::Builder as ConnBuilder;
+use tokio::net::TcpListener;
+use tokio::runtime::Runtime;
+
+mod common;
+
+use common::alloc::allocations;
+
+/// Requests in flight at once, in both scenarios.
+const CONCURRENCY: usize = 16;
+/// Requests of the pinned run that reports allocations and latency percentiles.
+const PINNED_REQUESTS: usize = 2_048;
+
+/// Run `batch` (one round of `CONCURRENCY` requests, returning their latencies) until
+/// `PINNED_REQUESTS` requests completed, then print allocations per request and p50/p99.
+fn report_scenario(name: &str, mut batch: impl FnMut() -> Vec<Duration>) {
+    batch(); // Warm up pools, TLS session state and lazily initialised statics.
+    let mut latencies = Vec::with_capacity(PINNED_REQUESTS);
+    let before = allocations();
+    while latencies.len() < PINNED_REQUESTS {
+        latencies.extend(batch());
+    }
+    let total = allocations().saturating_sub(before);
+    latencies.sort_unstable();
+    let percentile = |p: usize| {
+        let index = latencies
+            .len()
+            .saturating_mul(p)
+            .checked_div(100)
+            .unwrap_or(0);
+        latencies
+            .get(index.min(latencies.len().saturating_sub(1)))
+            .copied()
+            .unwrap_or_default()
+    };
+    println!(
+        "{name}: {:.2} allocations/request, p50 {:?}, p99 {:?} over {} requests",
+        total as f64 / latencies.len() as f64,
+        percentile(50),
+        percentile(99),
+        latencies.len(),
+    );
+}
+
+/// Run `CONCURRENCY` copies of `request` at once; each resolves to its own latency.
+async fn concurrent<F, Fut>(request: F) -> Vec<Duration>
+where
+    F: Fn() -> Fut,
+    Fut: Future<Output = Duration> + Send + 'static,
+{
+    let handles: Vec<_> = (0..CONCURRENCY).map(|_| tokio::spawn(request())).collect();
+    let mut latencies = Vec::with_capacity(CONCURRENCY);
+    for handle in handles {
+        latencies.push(
+            handle
+                .await
+                .unwrap_or_else(|e| panic!("request task failed: {e}")),
+        );
+    }
+    latencies
+}
+
+/// Send one GET with `client` and read the whole response.
+async fn timed_get(client: &reqwest::Client, url: &str) -> Duration {
+    let start = Instant::now();
+    let resp = client
+        .get(url)
+        .send()
+        .await
+        .unwrap_or_else(|e| panic!("request failed: {e}"));
+    assert!(resp.status().is_success(), "proxy returned non-2xx: {}", resp.status());
+    resp.bytes()
+        .await
+        .unwrap_or_else(|e| panic!("failed to read response body: {e}"));
+    start.elapsed()
+}
+
+// ---------------------------------------------------------------------------
+// Scenario 1: connection storm
+// Each request builds its own HTTP/1.1 client: a TCP connect, a full TLS
+// handshake and JA4 extraction per request, CONCURRENCY at a time.
+// ---------------------------------------------------------------------------
+fn bench_connection_storm(c: &mut Criterion) {
+    let rt = runtime();
+    let fixture = rt.block_on(LoadFixture::setup());
+    let url: Arc<str> = format!("https://{}/", fixture.proxy_addr).into();
+
+    let batch = || {
+        rt.block_on(concurrent(|| {
+            let url = Arc::clone(&url);
+            async move {
+                let client = reqwest::Client::builder()
+                    .danger_accept_invalid_certs(true)
+                    .http1_only()
+                    .timeout(Duration::from_secs(10))
+                    .build()
+                    .unwrap_or_else(|e| panic!("failed to build H1 client: {e}"));
+                timed_get(&client, &url).await
+            }
+        }))
+    };
+    report_scenario("load/connection_storm", &batch);
+
+    let mut group = c.benchmark_group("load");
+    group.sample_size(20);
+    group.measurement_time(Duration::from_secs(20));
+    group.throughput(Throughput::Elements(CONCURRENCY as u64));
+    group.bench_function("connection_storm", |b| b.iter(&batch));
+    group.finish();
+    fixture.teardown();
+}
+
+// ---------------------------------------------------------------------------
+// Scenario 2: long-lived HTTP/2
+// One client, one TLS connection for the whole run: CONCURRENCY streams at a
+// time multiplexed over it, so per-request cost excludes the handshake.
+// ---------------------------------------------------------------------------
+fn bench_h2_long_lived(c: &mut Criterion) {
+    let rt = runtime();
+    let fixture = rt.block_on(LoadFixture::setup());
+    let url: Arc<str> = format!("https://{}/", fixture.proxy_addr).into();
+    let client = reqwest::Client::builder()
+        .danger_accept_invalid_certs(true)
+        .http2_prior_knowledge()
+        .timeout(Duration::from_secs(10))
+        .build()
+        .unwrap_or_else(|e| panic!("failed to build H2 client: {e}"));
+
+    let batch = || {
+        rt.block_on(concurrent(|| {
+            let (client, url) = (client.clone(), Arc::clone(&url));
+            async move { timed_get(&client, &url).await }
+        }))
+    };
+    report_scenario("load/h2_long_lived", &batch);
+
+    let mut group = c.benchmark_group("load");
+    group.sample_size(50);
+    group.measurement_time(Duration::from_secs(15));
+    group.throughput(Throughput::Elements(CONCURRENCY as u64));
+    group.bench_function("h2_long_lived", |b| b.iter(&batch));
+    group.finish();
+    fixture.teardown();
+}
+
+// ---------------------------------------------------------------------------
+// Fixture: a TLS proxy with one fingerprinted catch-all route to an embedded
+// backend, alive for the duration of one scenario.
+// ---------------------------------------------------------------------------
+struct LoadFixture {
+    proxy_addr: SocketAddr,
+    backend_task: tokio::task::JoinHandle<()>,
+    proxy_task: tokio::task::JoinHandle<()>,
+    /// Temp files must stay alive as long as the proxy reads them.
+    _cert_file: tempfile::NamedTempFile,
+    _key_file: tempfile::NamedTempFile,
+}
+
+impl LoadFixture {
+    async fn setup() -> Self {
+        ensure_crypto_provider();
+        let (backend_task, backend_addr) = start_backend().await;
+        let (cert_file, key_file) = generate_cert_files();
+        let proxy_addr: SocketAddr = format!("127.0.0.1:{}", free_port())
+            .parse()
+            .unwrap_or_else(|e| panic!("invalid proxy addr: {e}"));
+        let backend_address = backend_addr.to_string();
+
+        let config = Config {
+            listen: ListenConfig { addrs: vec![proxy_addr], ..Default::default() },
+            backends: vec![Backend {
+                address: backend_address.clone(),
+                http_version: None,
+                health_check: None,
+            }],
+            domains: vec![Domain {
+                host: None,
+                cert_path: Some(cert_file.path().to_string_lossy().into_owned()),
+                key_path: Some(key_file.path().to_string_lossy().into_owned()),
+                headers: None,
+                security: None,
+                fingerprinting: None,
+                routes: vec![Route {
+                    prefix: "/".to_string(),
+                    backend: backend_address,
+                    fingerprinting: Some(true),
+                    force_new_connection: false,
+                    load_balance: Default::default(),
+                    replace_path: None,
+                    security: None,
+                    headers: None,
+                    cache: None,
+                    coalesce: None,
+                }],
+            }],
+            tls: Some(TlsConfig {
+                alpn: vec!["h2".to_string(), "http/1.1".to_string()],
+                options: Default::default(),
+                client_auth: Default::default(),
+                session_resumption: Default::default(),
+            }),
+            fingerprint: FingerprintConfig {
+                tls_enabled: true,
+                http_enabled: true,
+                tcp_enabled: false,
+                max_capture: 64 * 1024,
+            },
+            logging: LoggingConfig { level: "warn".to_string(), show_target: false },
+            timeout: TimeoutConfig {
+                upstream_connect_ms: Some(5000),
+                proxy_idle_ms: 600_000,
+                shutdown_secs: 5,
+                tls_handshake_secs: 10,
+                connection_handling_secs: 600, // the long-lived H2 connection spans the scenario
+                keep_alive: KeepAliveConfig::default(),
+            },
+            security: SecurityConfig::default(),
+            telemetry: TelemetryConfig {
+                metrics_port: None,
+                otel_log_level: "warn".to_string(),
+                timing: Default::default(),
+                debug: Default::default(),
+                fingerprint_export: Default::default(),
+            },
+            reload: huginn_proxy_lib::config::ReloadConfig::default(),
+            headers: None,
+            preserve_host: false,
+            backend_pool: Default::default(),
+        };
+
+        let huginn_proxy_lib::config::ConfigParts { static_cfg, dynamic_cfg } = config.into_parts();
+        let static_cfg = Arc::new(static_cfg);
+        let dynamic_cfg = Arc::new(ArcSwap::from_pointee(dynamic_cfg));
+        let proxy_task = tokio::spawn(async move {
+            let (shutdown_tx, _) = huginn_proxy_lib::shutdown_channel();
+            let _ = huginn_proxy_lib::run(
+                static_cfg,
+                dynamic_cfg,
+                huginn_proxy_lib::Metrics::new_noop(),
+                None,
+                huginn_proxy_lib::WatchOptions::default(),
+                shutdown_tx,
+                huginn_proxy_lib::Readiness::new(),
+            )
+            .await;
+        });
+        wait_for_ready(proxy_addr).await;
+
+        LoadFixture {
+            proxy_addr,
+            backend_task,
+            proxy_task,
+            _cert_file: cert_file,
+            _key_file: key_file,
+        }
+    }
+
+    fn teardown(self) {
+        self.proxy_task.abort();
+        self.backend_task.abort();
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+
+fn runtime() -> Runtime {
+    Runtime::new().unwrap_or_else(|e| panic!("failed to create tokio runtime: {e}"))
+}
+
+/// Rustls crypto provider must be installed once per process before any TLS handshake.
+fn ensure_crypto_provider() {
+    static INIT: OnceLock<()> = OnceLock::new();
+    INIT.get_or_init(|| {
+        let _ = tokio_rustls::rustls::crypto::aws_lc_rs::default_provider().install_default();
+    });
+}
+
+/// Start a plain HTTP/1.1 Hyper backend that answers every request with `200 OK "ok"`.
+async fn start_backend() -> (tokio::task::JoinHandle<()>, SocketAddr) {
+    let listener = TcpListener::bind("127.0.0.1:0")
+        .await
+        .unwrap_or_else(|e| panic!("failed to bind backend listener: {e}"));
+    let addr = listener
+        .local_addr()
+        .unwrap_or_else(|e| panic!("failed to get backend addr: {e}"));
+
+    let task = tokio::spawn(async move {
+        loop {
+            let Ok((stream, _)) = listener.accept().await else {
+                break;
+            };
+            tokio::spawn(async move {
+                let svc = service_fn(|_req: hyper::Request<hyper::body::Incoming>| async move {
+                    Ok::<_, Infallible>(Response::new(Full::new(Bytes::from_static(b"ok"))))
+                });
+                let _ = ConnBuilder::new(TokioExecutor::new())
+                    .serve_connection(TokioIo::new(stream), svc)
+                    .await;
+            });
+        }
+    });
+
+    (task, addr)
+}
+
+/// Find a free TCP port by binding to :0, reading the port, then releasing it.
+fn free_port() -> u16 {
+    let l = std::net::TcpListener::bind("127.0.0.1:0")
+        .unwrap_or_else(|e| panic!("failed to bind for port probe: {e}"));
+    l.local_addr()
+        .unwrap_or_else(|e| panic!("failed to get port: {e}"))
+        .port()
+}
+
+/// Generate a self-signed TLS cert/key pair and write them to temp files.
+fn generate_cert_files() -> (tempfile::NamedTempFile, tempfile::NamedTempFile) {
+    let rcgen::CertifiedKey { cert, signing_key } =
+        rcgen::generate_simple_self_signed(vec!["localhost".to_string()])
+            .unwrap_or_else(|e| panic!("failed to generate self-signed cert: {e}"));
+
+    let cert_file = tempfile::NamedTempFile::new()
+        .unwrap_or_else(|e| panic!("failed to create cert tempfile: {e}"));
+    let key_file = tempfile::NamedTempFile::new()
+        .unwrap_or_else(|e| panic!("failed to create key tempfile: {e}"));
+
+    std::fs::write(cert_file.path(), cert.pem())
+        .unwrap_or_else(|e| panic!("failed to write cert: {e}"));
+    std::fs::write(key_file.path(), signing_key.serialize_pem())
+        .unwrap_or_else(|e| panic!("failed to write key: {e}"));
+
+    (cert_file, key_file)
+}
+
+/// Poll the proxy until it accepts a TCP connection, up to 5 seconds.
+async fn wait_for_ready(addr: SocketAddr) {
+    let deadline = tokio::time::Instant::now()
+        .checked_add(Duration::from_secs(5))
+        .unwrap_or_else(|| panic!("deadline arithmetic overflow"));
+    loop {
+        if tokio::net::TcpStream::connect(addr).await.is_ok() {
+            // Give TLS acceptor a moment to initialize
+            tokio::time::sleep(Duration::from_millis(50)).await;
+            return;
+        }
+        if tokio::time::Instant::now() > deadline {
+            panic!("proxy at {addr} did not become ready within 5 seconds");
+        }
+        tokio::time::sleep(Duration::from_millis(50)).await;
+    }
+}
+
+criterion_group!(load_benches, bench_connection_storm, bench_h2_long_lived);
+criterion_main!(load_benches);
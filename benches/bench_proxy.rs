@@ -97,9 +97,10 @@ impl BenchFixture {
             .unwrap_or_else(|e| panic!("invalid proxy addr: {e}"));
         let backend_address = backend_addr.to_string();
 
-        // 4. Build proxy config with two routes:
+        // 4. Build proxy config with three routes:
         //    /bench/fp  → fingerprinting ON  (measures overhead)
         //    /bench/nofp → fingerprinting OFF (baseline)
+        //    /bench/fresh → fingerprinting OFF, new upstream connection per request
         let config = Config {
             listen: ListenConfig { addrs: vec![proxy_addr], ..Default::default() },
             backends: vec![Backend {
@@ -120,27 +121,48 @@ impl BenchFixture {
                         backend: backend_address.clone(),
                         fingerprinting: Some(true),
                         force_new_connection: false,
+                        load_balance: Default::default(),
                         replace_path: Some("/".to_string()),
                         security: None,
                         headers: None,
+                        cache: None,
+                        coalesce: None,
                     },
                     Route {
                         prefix: "/bench/nofp".to_string(),
                         backend: backend_address.clone(),
                         fingerprinting: Some(false),
                         force_new_connection: false,
+                        load_balance: Default::default(),
                         replace_path: Some("/".to_string()),
                         security: None,
                         headers: None,
+                        cache: None,
+                        coalesce: None,
+                    },
+                    Route {
+                        prefix: "/bench/fresh".to_string(),
+                        backend: backend_address.clone(),
+                        fingerprinting: Some(false),
+                        force_new_connection: true,
+                        load_balance: Default::default(),
+                        replace_path: Some("/".to_string()),
+                        security: None,
+                        headers: None,
+                        cache: None,
+                        coalesce: None,
                     },
                     Route {
                         prefix: "/".to_string(),
                         backend: backend_address,
                         fingerprinting: Some(true),
                         force_new_connection: false,
+                        load_balance: Default::default(),
                         replace_path: None,
                         security: None,
                         headers: None,
+                        cache: None,
+                        coalesce: None,
                     },
                 ],
             }],
@@ -166,7 +188,13 @@ impl BenchFixture {
                 keep_alive: KeepAliveConfig::default(),
             },
             security: SecurityConfig::default(),
-            telemetry: TelemetryConfig { metrics_port: None, otel_log_level: "warn".to_string() },
+            telemetry: TelemetryConfig {
+                metrics_port: None,
+                otel_log_level: "warn".to_string(),
+                timing: Default::default(),
+                debug: Default::default(),
+                fingerprint_export: Default::default(),
+            },
             reload: huginn_proxy_lib::config::ReloadConfig::default(),
             headers: None,
             preserve_host: false,
@@ -459,6 +487,49 @@ fn bench_concurrency(c: &mut Criterion) {
     fixture.teardown();
 }
 
+// ---------------------------------------------------------------------------
+// Benchmark 5: Upstream connection reuse
+// Compares /bench/nofp (pooled upstream connections) vs /bench/fresh
+// (force_new_connection: one TCP connect + HTTP/1.1 handshake to the backend
+// per request) over the same warm client connection. The delta is the cost
+// of the non-pooling upstream send path.
+// ---------------------------------------------------------------------------
+fn bench_upstream_connection(c: &mut Criterion) {
+    let rt = tokio::runtime::Runtime::new()
+        .unwrap_or_else(|e| panic!("failed to create tokio runtime: {e}"));
+    let fixture = rt.block_on(BenchFixture::setup());
+    let proxy_addr = fixture.proxy_addr;
+
+    let client = reqwest::Client::builder()
+        .danger_accept_invalid_certs(true)
+        .timeout(Duration::from_secs(10))
+        .build()
+        .unwrap_or_else(|e| panic!("failed to build client: {e}"));
+
+    let mut group = c.benchmark_group("upstream_connection");
+    group.sample_size(50);
+    group.measurement_time(Duration::from_secs(15));
+    group.throughput(Throughput::Elements(1));
+
+    for (name, path) in [("pooled", "/bench/nofp"), ("force_new_connection", "/bench/fresh")] {
+        let url = format!("https://{proxy_addr}{path}");
+        group.bench_function(name, |b| {
+            b.iter(|| {
+                rt.block_on(async {
+                    client
+                        .get(&url)
+                        .send()
+                        .await
+                        .unwrap_or_else(|e| panic!("request failed: {e}"))
+                })
+            })
+        });
+    }
+
+    group.finish();
+    fixture.teardown();
+}
+
 // ---------------------------------------------------------------------------
 // Fingerprint assertion helpers
 //
@@ -599,5 +670,6 @@ criterion_group!(
     bench_http2_latency,
     bench_fingerprinting_overhead,
     bench_concurrency,
+    bench_upstream_connection,
 );
 criterion_main!(proxy_benches);
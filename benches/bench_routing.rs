@@ -0,0 +1,229 @@
+//! Micro benchmarks for request routing at scale: domain and route lookup over 10k entries
+//! (the linear reference functions next to the compiled [`RoutingTable`]), and backend
+//! selection with every available core picking from the same route. Pure CPU - no network,
+//! no IO.
+//!
+//! Like `bench_forwarding`, the single-threaded lookups also print their heap allocations per
+//! request, counted by a wrapping global allocator.
+//!
+//! ```bash
+//! cargo bench --bench bench_routing
+//! ```
+
+use std::hint::black_box;
+use std::net::{IpAddr, Ipv4Addr};
+use std::sync::Arc;
+use std::time::{Duration, Instant};
+
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion, Throughput};
+use huginn_proxy_lib::backend::ClientKey;
+use huginn_proxy_lib::config::{sort_domain_routes, Domain, LoadBalance, Route};
+use huginn_proxy_lib::proxy::router::{pick_domain, pick_route_with_fingerprinting, RoutingTable};
+use huginn_proxy_lib::{BackendSelector, HealthRegistry};
+
+mod common;
+
+use common::alloc::report_allocations;
+
+/// Domains (and routes) in the large tables: the scale of a multi-tenant edge config.
+const ENTRIES: usize = 10_000;
+
+/// Wall time of `iters` calls of `op` on each of `threads` threads started together.
+fn contended(threads: usize, iters: u64, op: impl Fn() + Sync) -> Duration {
+    let start = Instant::now();
+    std::thread::scope(|s| {
+        for _ in 0..threads {
+            s.spawn(|| {
+                for _ in 0..iters {
+                    op();
+                }
+            });
+        }
+    });
+    start.elapsed()
+}
+
+/// 1, 2, 4, ... threads, up to the cores available to the process.
+fn thread_counts() -> Vec<usize> {
+    let cores = std::thread::available_parallelism().map_or(1, |n| n.get());
+    std::iter::successors(Some(1usize), |&n| n.checked_mul(2))
+        .take_while(|&n| n <= cores)
+        .collect()
+}
+
+fn route(prefix: String, backend: &str) -> Route {
+    Route {
+        prefix,
+        backend: backend.to_string(),
+        fingerprinting: None,
+        force_new_connection: false,
+        load_balance: Default::default(),
+        replace_path: None,
+        security: None,
+        headers: None,
+        cache: None,
+        coalesce: None,
+    }
+}
+
+fn domain(host: Option<String>, routes: Vec<Route>) -> Domain {
+    Domain {
+        host,
+        cert_path: None,
+        key_path: None,
+        headers: None,
+        security: None,
+        fingerprinting: None,
+        routes,
+    }
+}
+
+/// `ENTRIES` domains: exact hosts, every tenth one a wildcard, then a catch-all.
+fn many_domains() -> Vec<Domain> {
+    let mut domains: Vec<Domain> = (0..ENTRIES)
+        .map(|i| {
+            let host = if i % 10 == 9 {
+                format!("*.tenant-{i}.example.net")
+            } else {
+                format!("host-{i}.example.com")
+            };
+            domain(Some(host), vec![route("/".to_string(), "backend:9000")])
+        })
+        .collect();
+    domains.push(domain(None, vec![route("/".to_string(), "fallback:9000")]));
+    sort_domain_routes(&mut domains);
+    domains
+}
+
+/// One catch-all domain with `ENTRIES` service prefixes plus `/`.
+fn many_routes() -> Vec<Domain> {
+    let mut routes: Vec<Route> = (0..ENTRIES)
+        .map(|i| route(format!("/svc-{i}/v1"), "backend:9000"))
+        .collect();
+    routes.push(route("/".to_string(), "fallback:9000"));
+    let mut domains = vec![domain(None, routes)];
+    sort_domain_routes(&mut domains);
+    domains
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark 1: domain lookup over 10k domains
+// `exact` is a host declared near the end (the linear scan's worst hit), `wildcard`
+// one matched by `*.tenant-*`, `catch_all` a host no entry declares.
+// ---------------------------------------------------------------------------
+fn bench_domain_lookup(c: &mut Criterion) {
+    let domains = Arc::new(many_domains());
+    let table = RoutingTable::new(Arc::clone(&domains));
+    let hosts = [
+        ("exact", format!("host-{}.example.com", ENTRIES.saturating_sub(2))),
+        ("wildcard", format!("api.tenant-{}.example.net", ENTRIES.saturating_sub(1))),
+        ("catch_all", "unknown.example.org".to_string()),
+    ];
+
+    let mut group = c.benchmark_group("domain_lookup");
+    for (name, host) in &hosts {
+        report_allocations(&format!("domain_lookup/table/{name}"), || {
+            black_box(table.pick_domain(black_box(host)));
+        });
+        group.bench_with_input(BenchmarkId::new("table", name), host, |b, host| {
+            b.iter(|| table.pick_domain(black_box(host)).map(|(index, _)| index))
+        });
+        group.bench_with_input(BenchmarkId::new("linear", name), host, |b, host| {
+            b.iter(|| pick_domain(&domains, black_box(host)).is_some())
+        });
+    }
+    group.finish();
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark 2: route lookup over 10k prefixes
+// `deep` matches a service prefix, `fallback` only `/` (every prefix is
+// tried by the linear scan).
+// ---------------------------------------------------------------------------
+fn bench_route_lookup(c: &mut Criterion) {
+    let domains = Arc::new(many_routes());
+    let table = RoutingTable::new(Arc::clone(&domains));
+    let routes = &domains[0].routes;
+    let paths = [
+        ("deep", format!("/svc-{}/v1/users/42", ENTRIES.saturating_sub(1))),
+        ("fallback", "/static/app.js".to_string()),
+    ];
+
+    let mut group = c.benchmark_group("route_lookup");
+    for (name, path) in &paths {
+        report_allocations(&format!("route_lookup/table/{name}"), || {
+            black_box(table.pick_route(0, black_box(path)));
+        });
+        group.bench_with_input(BenchmarkId::new("table", name), path, |b, path| {
+            b.iter(|| table.pick_route(0, black_box(path)).map(|m| m.route_index))
+        });
+        group.bench_with_input(BenchmarkId::new("linear", name), path, |b, path| {
+            b.iter(|| {
+                pick_route_with_fingerprinting(black_box(path), routes).map(|m| m.route_index)
+            })
+        });
+    }
+    group.finish();
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark 3: backend selection across cores
+// Every thread selects for the same four-backend route, so they share its
+// cursor: the contended case. `round_robin` and `p2c_ewma` go through the
+// published snapshot (`select_route`); `by_address` is the fallback for
+// requests on a stale config generation (`select`).
+// ---------------------------------------------------------------------------
+fn bench_backend_select(c: &mut Criterion) {
+    let backends = ["10.0.0.1:9000", "10.0.0.2:9000", "10.0.0.3:9000", "10.0.0.4:9000"];
+    let balanced = |load_balance: LoadBalance| {
+        let routes = backends
+            .iter()
+            .map(|backend| Route { load_balance, ..route("/api".to_string(), backend) })
+            .collect();
+        let mut domains = vec![domain(None, routes)];
+        sort_domain_routes(&mut domains);
+        Arc::new(RoutingTable::new(Arc::new(domains)))
+    };
+    let registry = HealthRegistry::new();
+    let client = ClientKey::new(IpAddr::V4(Ipv4Addr::new(192, 0, 2, 1)), None);
+
+    let mut group = c.benchmark_group("backend_select");
+    for threads in thread_counts() {
+        group.throughput(Throughput::Elements(threads as u64));
+        for (name, load_balance) in
+            [("round_robin", LoadBalance::RoundRobin), ("p2c_ewma", LoadBalance::P2cEwma)]
+        {
+            let routing = balanced(load_balance);
+            let selector = BackendSelector::new();
+            selector.publish(&routing, &registry);
+            let route_match = routing
+                .pick_route(0, "/api/users")
+                .unwrap_or_else(|| panic!("bench route does not match"));
+            group.bench_with_input(BenchmarkId::new(name, threads), &threads, |b, &threads| {
+                b.iter_custom(|iters| {
+                    contended(threads, iters, || {
+                        black_box(selector.select_route(
+                            &routing,
+                            0,
+                            &route_match,
+                            &client,
+                            &registry,
+                        ));
+                    })
+                })
+            });
+        }
+        let selector = BackendSelector::new();
+        group.bench_with_input(BenchmarkId::new("by_address", threads), &threads, |b, &threads| {
+            b.iter_custom(|iters| {
+                contended(threads, iters, || {
+                    black_box(selector.select("/api", black_box(&backends), &registry));
+                })
+            })
+        });
+    }
+    group.finish();
+}
+
+criterion_group!(routing_benches, bench_domain_lookup, bench_route_lookup, bench_backend_select);
+criterion_main!(routing_benches);
@@ -0,0 +1,169 @@
+//! Micro benchmarks for the per-request security checks: IP filtering against a 100k-prefix
+//! list (the linear reference [`is_ip_allowed`] next to the compiled [`CompiledIpFilter`]), and
+//! [`RateLimitManager::check`] with every available core checking at once. Pure CPU - no
+//! network, no IO.
+//!
+//! Like `bench_forwarding`, the single-threaded lookups also print their heap allocations per
+//! request, counted by a wrapping global allocator.
+//!
+//! ```bash
+//! cargo bench --bench bench_security
+//! ```
+
+use std::hint::black_box;
+use std::net::{IpAddr, Ipv4Addr, Ipv6Addr};
+use std::time::{Duration, Instant};
+
+use criterion::{criterion_group, criterion_main, BenchmarkId, Criterion, Throughput};
+use huginn_proxy_lib::config::{IpFilterConfig, IpFilterMode, RateLimitConfig};
+use huginn_proxy_lib::security::{is_ip_allowed, CompiledIpFilter, RateLimitManager};
+use ipnet::{IpNet, Ipv4Net, Ipv6Net};
+
+mod common;
+
+use common::alloc::report_allocations;
+
+/// Prefixes in the filter list: the size of a merged threat-intel denylist.
+const CIDRS: u32 = 100_000;
+
+/// Wall time of `iters` calls of `op` on each of `threads` threads started together; `op` gets
+/// the index of its thread and of the call.
+fn contended(threads: usize, iters: u64, op: impl Fn(usize, u64) + Sync) -> Duration {
+    let start = Instant::now();
+    std::thread::scope(|s| {
+        for thread in 0..threads {
+            let op = &op;
+            s.spawn(move || {
+                for call in 0..iters {
+                    op(thread, call);
+                }
+            });
+        }
+    });
+    start.elapsed()
+}
+
+/// 1, 2, 4, ... threads, up to the cores available to the process.
+fn thread_counts() -> Vec<usize> {
+    let cores = std::thread::available_parallelism().map_or(1, |n| n.get());
+    std::iter::successors(Some(1usize), |&n| n.checked_mul(2))
+        .take_while(|&n| n <= cores)
+        .collect()
+}
+
+/// Network of the `i`-th IPv4 prefix: `/24`s from `11.0.0.0` with a `/24` gap after each.
+fn v4_prefix(i: u32) -> u32 {
+    0x0b00_0000_u32.saturating_add(i.saturating_mul(512))
+}
+
+/// Network of the `i`-th IPv6 prefix: `/64`s under `2001:db8::/32`, every other one.
+fn v6_prefix(i: u32) -> Ipv6Addr {
+    let n = i.saturating_mul(2);
+    let high = u16::try_from(n >> 16).unwrap_or(u16::MAX);
+    let low = u16::try_from(n & 0xffff).unwrap_or(u16::MAX);
+    Ipv6Addr::new(0x2001, 0x0db8, high, low, 0, 0, 0, 0)
+}
+
+/// `CIDRS` disjoint, non-adjacent prefixes, half per family, so merging cannot collapse them.
+fn denylist() -> IpFilterConfig {
+    let v4 = (0..CIDRS / 2).filter_map(|i| {
+        Ipv4Net::new(Ipv4Addr::from(v4_prefix(i)), 24)
+            .ok()
+            .map(IpNet::V4)
+    });
+    let v6 = (0..CIDRS / 2).filter_map(|i| Ipv6Net::new(v6_prefix(i), 64).ok().map(IpNet::V6));
+    IpFilterConfig {
+        mode: IpFilterMode::Denylist,
+        allowlist: Vec::new(),
+        denylist: v4.chain(v6).collect(),
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark 1: IP filter over 100k prefixes
+// `v4_hit` / `v6_hit` fall in the last prefix of their family (the linear
+// scan's worst hit), `v4_miss` in a gap (every prefix is tried).
+// ---------------------------------------------------------------------------
+fn bench_ip_filter(c: &mut Criterion) {
+    let config = denylist();
+    let compiled = CompiledIpFilter::compile(&config);
+    let last = (CIDRS / 2).saturating_sub(1);
+    let last_v6 = u128::from(v6_prefix(last));
+    let ips = [
+        ("v4_hit", IpAddr::V4(Ipv4Addr::from(v4_prefix(last) | 0x42))),
+        ("v4_miss", IpAddr::V4(Ipv4Addr::from(v4_prefix(last) | 0x0142))),
+        ("v6_hit", IpAddr::V6(Ipv6Addr::from(last_v6 | 1))),
+    ];
+
+    let mut group = c.benchmark_group("ip_filter");
+    for (name, ip) in ips {
+        report_allocations(&format!("ip_filter/compiled/{name}"), || {
+            black_box(compiled.allows(black_box(ip)));
+        });
+        group.bench_with_input(BenchmarkId::new("compiled", name), &ip, |b, &ip| {
+            b.iter(|| compiled.allows(black_box(ip)))
+        });
+        group.bench_with_input(BenchmarkId::new("linear", name), &ip, |b, &ip| {
+            b.iter(|| is_ip_allowed(black_box(ip), &config))
+        });
+    }
+    group.finish();
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark 2: rate limit check across cores
+// `shared_key` has every thread check the same client (one hot bucket),
+// `distinct_keys` has each thread walk a pool of 4096 clients from its own
+// offset.
+// The burst is deep enough that every check is admitted.
+// ---------------------------------------------------------------------------
+fn bench_rate_limit(c: &mut Criterion) {
+    let config = RateLimitConfig {
+        enabled: true,
+        requests_per_second: 1_000_000,
+        burst: u32::MAX,
+        ..Default::default()
+    };
+    let manager = RateLimitManager::new(&config, &[]);
+    let keys: Vec<String> = (0..4096u32)
+        .map(|i| Ipv4Addr::from(0xc633_6400_u32.wrapping_add(i)).to_string())
+        .collect();
+
+    report_allocations("rate_limit/shared_key", || {
+        black_box(manager.check("198.51.100.7", "api.example.com", Some("/api")));
+    });
+
+    let mut group = c.benchmark_group("rate_limit");
+    for threads in thread_counts() {
+        group.throughput(Throughput::Elements(threads as u64));
+        group.bench_with_input(BenchmarkId::new("shared_key", threads), &threads, |b, &threads| {
+            b.iter_custom(|iters| {
+                contended(threads, iters, |_, _| {
+                    black_box(manager.check(
+                        black_box("198.51.100.7"),
+                        "api.example.com",
+                        Some("/api"),
+                    ));
+                })
+            })
+        });
+        group.bench_with_input(
+            BenchmarkId::new("distinct_keys", threads),
+            &threads,
+            |b, &threads| {
+                b.iter_custom(|iters| {
+                    contended(threads, iters, |thread, call| {
+                        // Threads walk the pool from different offsets.
+                        let next = (call as usize).wrapping_add(thread.wrapping_mul(1024));
+                        let key = &keys[next.checked_rem(keys.len()).unwrap_or(0)];
+                        black_box(manager.check(key, "api.example.com", Some("/api")));
+                    })
+                })
+            },
+        );
+    }
+    group.finish();
+}
+
+criterion_group!(security_benches, bench_ip_filter, bench_rate_limit);
+criterion_main!(security_benches);
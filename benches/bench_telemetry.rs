@@ -0,0 +1,100 @@
+//! Micro benchmark for the telemetry recorded by one proxied request: every `record_*` call
+//! `handle_proxy_request` and `forward()` make on the success path, with metrics off (no-op
+//! meter) and on (the Prometheus exporter the proxy installs). Pure CPU - no network, no IO.
+//!
+//! Like `bench_forwarding`, every case also prints its heap allocations per request, counted by
+//! a wrapping global allocator.
+//!
+//! ```bash
+//! cargo bench --bench bench_telemetry
+//! ```
+
+use std::hint::black_box;
+use std::sync::Arc;
+
+use criterion::{criterion_group, criterion_main, Criterion};
+use http::{Method, Version};
+use huginn_proxy_lib::config::{sort_domain_routes, Domain, Route};
+use huginn_proxy_lib::proxy::router::RoutingTable;
+use huginn_proxy_lib::telemetry::attributes::backend_address;
+use huginn_proxy_lib::telemetry::{
+    init_metrics, values, Metrics, RequestAttributes, RouteAttributes,
+};
+
+mod common;
+
+use common::alloc::report_allocations;
+
+fn routing_table() -> RoutingTable {
+    let mut domains = vec![Domain {
+        host: Some("api.example.com".to_string()),
+        cert_path: None,
+        key_path: None,
+        headers: None,
+        security: None,
+        fingerprinting: None,
+        routes: vec![Route {
+            prefix: "/api".to_string(),
+            backend: "backend.internal:9000".to_string(),
+            fingerprinting: None,
+            force_new_connection: false,
+            load_balance: Default::default(),
+            replace_path: None,
+            security: None,
+            headers: None,
+            cache: None,
+            coalesce: None,
+        }],
+    }];
+    sort_domain_routes(&mut domains);
+    RoutingTable::new(Arc::new(domains))
+}
+
+/// The telemetry of one rate-limited-but-allowed request proxied with a 200, in handler order.
+fn record_request(metrics: &Metrics, route: &RouteAttributes, backend: &Arc<str>) {
+    let request = RequestAttributes::new(black_box(&Method::GET), Version::HTTP_11);
+    let protocol = "HTTP/1.1";
+    metrics.record_bytes_received(512, protocol);
+    metrics.record_ip_filter_allowed();
+    metrics.record_backend_selection(backend);
+    metrics.record_rate_limit_request("ip", route);
+    metrics.record_rate_limit_allowed("ip", route);
+    metrics.record_headers_added(1, values::CONTEXT_REQUEST);
+
+    let backend = backend_address(backend);
+    metrics.record_backend_bytes_sent(512, &backend, route);
+    metrics.record_backend_in_flight(&backend, 1);
+    metrics.record_backend_in_flight(&backend, -1);
+    metrics.record_backend_bytes_received(2048, &backend, route);
+    metrics.record_backend_response(0.004, &backend, 200, &request, route);
+    metrics.record_backend_latency_ewma(0.004, &backend);
+
+    metrics.record_bytes_sent(2048, protocol);
+    metrics.record_entrypoint_request(&request, 200);
+    metrics.record_request(0.005, 200, &request, route);
+}
+
+fn bench_request_telemetry(c: &mut Criterion) {
+    // The no-op instance must be built before `init_metrics` installs the global provider.
+    let noop = Metrics::new_noop();
+    let (prometheus, _registry) =
+        init_metrics().unwrap_or_else(|e| panic!("failed to init metrics: {e}"));
+
+    let routing = routing_table();
+    let route = routing
+        .route_attributes(0, 0)
+        .cloned()
+        .unwrap_or_else(|| panic!("bench route has no attributes"));
+    let backend: Arc<str> = Arc::from("backend.internal:9000");
+
+    let mut group = c.benchmark_group("request_telemetry");
+    for (name, metrics) in [("metrics_off", &noop), ("metrics_on", &prometheus)] {
+        let run = || record_request(metrics, &route, &backend);
+        report_allocations(&format!("request_telemetry/{name}"), run);
+        group.bench_function(name, |b| b.iter(run));
+    }
+    group.finish();
+}
+
+criterion_group!(telemetry_benches, bench_request_telemetry);
+criterion_main!(telemetry_benches);
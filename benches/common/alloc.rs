@@ -0,0 +1,60 @@
+//! Allocation counter: a global allocator that forwards to the system allocator and counts
+//! every allocation (reallocations included) made by the process. Including this module
+//! installs it; allocation counts are deterministic, so a change in a printed number is a
+//! regression (or win) regardless of machine noise.
+
+use std::alloc::{GlobalAlloc, Layout, System};
+use std::sync::atomic::{AtomicU64, Ordering};
+
+struct CountingAllocator;
+
+static ALLOCATIONS: AtomicU64 = AtomicU64::new(0);
+
+// SAFETY: every call is forwarded unchanged to `System`, which upholds the `GlobalAlloc`
+// contract; the counter has no effect on the returned memory.
+unsafe impl GlobalAlloc for CountingAllocator {
+    unsafe fn alloc(&self, layout: Layout) -> *mut u8 {
+        ALLOCATIONS.fetch_add(1, Ordering::Relaxed);
+        System.alloc(layout)
+    }
+
+    unsafe fn dealloc(&self, ptr: *mut u8, layout: Layout) {
+        System.dealloc(ptr, layout)
+    }
+
+    unsafe fn alloc_zeroed(&self, layout: Layout) -> *mut u8 {
+        ALLOCATIONS.fetch_add(1, Ordering::Relaxed);
+        System.alloc_zeroed(layout)
+    }
+
+    unsafe fn realloc(&self, ptr: *mut u8, layout: Layout, new_size: usize) -> *mut u8 {
+        ALLOCATIONS.fetch_add(1, Ordering::Relaxed);
+        System.realloc(ptr, layout, new_size)
+    }
+}
+
+#[global_allocator]
+static GLOBAL: CountingAllocator = CountingAllocator;
+
+/// Allocations made by the process so far; subtract two readings to count a section.
+pub fn allocations() -> u64 {
+    ALLOCATIONS.load(Ordering::Relaxed)
+}
+
+/// Average allocations of one `f` call over a fixed number of runs, printed next to the
+/// Criterion output as `allocations/request`.
+pub fn report_allocations(name: &str, f: impl FnMut()) {
+    report_allocations_per("request", name, f);
+}
+
+/// [`report_allocations`], printed as `allocations/<unit>`.
+pub fn report_allocations_per(unit: &str, name: &str, mut f: impl FnMut()) {
+    const RUNS: u64 = 1_000;
+    f(); // Warm up lazily initialised state outside the measurement.
+    let before = allocations();
+    for _ in 0..RUNS {
+        f();
+    }
+    let total = allocations().saturating_sub(before);
+    println!("{name}: {:.2} allocations/{unit}", total as f64 / RUNS as f64);
+}
@@ -0,0 +1,5 @@
+//! Helpers shared by the bench targets, included with `mod common;` from each bench file.
+//! A bench uses only part of them.
+#![allow(dead_code)]
+
+pub mod alloc;
@@ -2,7 +2,9 @@ use huginn_ebpf::pin;
 use std::net::{Ipv4Addr, Ipv6Addr};
 
 pub const DEFAULT_PIN_PATH: &str = pin::DEFAULT_PIN_BASE;
-pub use huginn_ebpf::{CaptureBackend, EbpfLogLevel, XdpAttachMode};
+/// Shortest accepted `HUGINN_EBPF_DEBUG_TOKEN`.
+pub const MIN_DEBUG_TOKEN_LEN: usize = 16;
+pub use huginn_ebpf::{CaptureBackend, EbpfLogLevel, SynRateLimit, XdpAttachMode};
 
 #[derive(Debug, Clone)]
 pub struct Config {
@@ -16,6 +18,10 @@ pub struct Config {
     pub metrics_listen_addr: String,
     pub metrics_port: u16,
     pub log_level: EbpfLogLevel,
+    /// Bearer token of the `/debug/` endpoints; `None` leaves them disabled.
+    pub debug_token: Option<String>,
+    /// Per-source SYN rate limit enforced in the kernel; `None` leaves it off.
+    pub syn_rate_limit: Option<SynRateLimit>,
 }
 
 #[derive(Debug, thiserror::Error)]
@@ -88,6 +94,10 @@ pub fn from_env(get_var: impl Fn(&str) -> Option<String>) -> Result<Config, Conf
 
     let log_level = resolve_log_level(&get_var)?;
 
+    let debug_token = resolve_debug_token(&get_var)?;
+
+    let syn_rate_limit = resolve_syn_rate_limit(&get_var)?;
+
     Ok(Config {
         interface,
         dst_ip_v4,
@@ -99,9 +109,70 @@ pub fn from_env(get_var: impl Fn(&str) -> Option<String>) -> Result<Config, Conf
         metrics_listen_addr,
         metrics_port,
         log_level,
+        debug_token,
+        syn_rate_limit,
     })
 }
 
+/// Resolve `HUGINN_EBPF_SYN_RATE_LIMIT` (SYNs per second per source address; unset or `0` = off)
+/// and `HUGINN_EBPF_SYN_RATE_BURST` (SYNs a source may send at once; default: the rate).
+fn resolve_syn_rate_limit(
+    get_var: &impl Fn(&str) -> Option<String>,
+) -> Result<Option<SynRateLimit>, ConfigError> {
+    let per_second = parse_u32(get_var, "HUGINN_EBPF_SYN_RATE_LIMIT")?.unwrap_or(0);
+    let burst = parse_u32(get_var, "HUGINN_EBPF_SYN_RATE_BURST")?;
+    let invalid_burst = |reason: &str| ConfigError::Invalid {
+        name: "HUGINN_EBPF_SYN_RATE_BURST".to_string(),
+        value: burst.unwrap_or_default().to_string(),
+        reason: reason.to_string(),
+    };
+    if per_second == 0 {
+        return match burst {
+            Some(_) => Err(invalid_burst("requires a non-zero HUGINN_EBPF_SYN_RATE_LIMIT")),
+            None => Ok(None),
+        };
+    }
+    if burst == Some(0) {
+        return Err(invalid_burst("must be a positive integer"));
+    }
+    Ok(Some(SynRateLimit { per_second, burst: burst.unwrap_or(per_second) }))
+}
+
+fn parse_u32(
+    get_var: &impl Fn(&str) -> Option<String>,
+    name: &str,
+) -> Result<Option<u32>, ConfigError> {
+    get_var(name)
+        .map(|s| {
+            s.parse().map_err(|_| ConfigError::Invalid {
+                name: name.to_string(),
+                value: s.clone(),
+                reason: "must be a non-negative integer".to_string(),
+            })
+        })
+        .transpose()
+}
+
+/// Resolve `HUGINN_EBPF_DEBUG_TOKEN`, the bearer token that enables the runtime endpoint under
+/// `/debug/`. Unset means disabled; set, it must be at least
+/// [`MIN_DEBUG_TOKEN_LEN`] bytes.
+fn resolve_debug_token(
+    get_var: &impl Fn(&str) -> Option<String>,
+) -> Result<Option<String>, ConfigError> {
+    let Some(token) = get_var("HUGINN_EBPF_DEBUG_TOKEN") else {
+        return Ok(None);
+    };
+    if token.len() < MIN_DEBUG_TOKEN_LEN {
+        return Err(ConfigError::Invalid {
+            name: "HUGINN_EBPF_DEBUG_TOKEN".to_string(),
+            // The value is a secret: do not echo it back.
+            value: "<redacted>".to_string(),
+            reason: format!("must be at least {MIN_DEBUG_TOKEN_LEN} bytes"),
+        });
+    }
+    Ok(Some(token))
+}
+
 fn resolve_log_level(
     get_var: &impl Fn(&str) -> Option<String>,
 ) -> Result<EbpfLogLevel, ConfigError> {
@@ -3,6 +3,7 @@
 use huginn_ebpf::{EbpfLogLevel, EbpfLogPoller, EbpfProbe};
 use huginn_ebpf_agent::config::from_env;
 use huginn_ebpf_agent::error::Result;
+use huginn_ebpf_agent::telemetry::DebugEndpoints;
 use std::env;
 use std::sync::Arc;
 use tokio::io::unix::AsyncFd;
@@ -82,6 +83,7 @@ async fn main() -> Result<()> {
         cfg.capture,
         cfg.log_level,
         &cfg.pin_path,
+        cfg.syn_rate_limit,
     )?;
 
     if let Some(poller) = probe.take_debug_log_poller()? {
@@ -96,12 +98,14 @@ async fn main() -> Result<()> {
     let pin_path_str = cfg.pin_path.clone();
     let listen_addr = cfg.metrics_listen_addr.clone();
     let port = cfg.metrics_port;
+    let debug = cfg.debug_token.clone().map(DebugEndpoints::new);
     tokio::spawn(async move {
         let _ = huginn_ebpf_agent::telemetry::start_observability_server(
             &listen_addr,
             port,
             registry,
             pin_path_str,
+            debug,
         )
         .await;
     });
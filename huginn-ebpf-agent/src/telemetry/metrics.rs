@@ -1,7 +1,9 @@
 use huginn_ebpf::{
-    syn_captured_count_from_path, syn_captured_v6_count_from_path,
-    syn_insert_failures_count_from_path, syn_insert_failures_v6_count_from_path,
-    syn_malformed_count_from_path, syn_malformed_v6_count_from_path,
+    syn_captured_count_from_path, syn_captured_v6_count_from_path, syn_denied_count_from_path,
+    syn_denied_v6_count_from_path, syn_insert_failures_count_from_path,
+    syn_insert_failures_v6_count_from_path, syn_malformed_count_from_path,
+    syn_malformed_v6_count_from_path, syn_rate_limited_count_from_path,
+    syn_rate_limited_v6_count_from_path,
 };
 use opentelemetry::global;
 use opentelemetry::metrics::{Gauge, Meter};
@@ -17,6 +19,10 @@ pub mod labels {
     pub const FAMILY: &str = "family";
     pub const FAMILY_V4: &str = "ipv4";
     pub const FAMILY_V6: &str = "ipv6";
+    /// Why the capture program dropped a SYN: `denylist` or `rate_limit`.
+    pub const REASON: &str = "reason";
+    pub const REASON_DENYLIST: &str = "denylist";
+    pub const REASON_RATE_LIMIT: &str = "rate_limit";
 }
 
 #[derive(Clone)]
@@ -75,6 +81,7 @@ pub fn init_metrics(pin_path: Arc<String>) -> crate::error::Result<(Registry, Me
 
     let pin_path_captured = pin_path.clone();
     let pin_path_failures = pin_path.clone();
+    let pin_path_dropped = pin_path.clone();
 
     let _ = meter
         .u64_observable_counter("tcp_syn_captured_total")
@@ -99,6 +106,33 @@ pub fn init_metrics(pin_path: Arc<String>) -> crate::error::Result<(Registry, Me
         })
         .build();
 
+    let _ = meter
+        .u64_observable_counter("tcp_syn_dropped_total")
+        .with_description("Number of TCP SYNs dropped in the kernel by the denylist or rate limit")
+        .with_callback(move |observer| {
+            let path = pin_path_dropped.as_str();
+            for (family, reason, count) in [
+                (labels::FAMILY_V4, labels::REASON_DENYLIST, syn_denied_count_from_path(path)),
+                (labels::FAMILY_V6, labels::REASON_DENYLIST, syn_denied_v6_count_from_path(path)),
+                (
+                    labels::FAMILY_V4,
+                    labels::REASON_RATE_LIMIT,
+                    syn_rate_limited_count_from_path(path),
+                ),
+                (
+                    labels::FAMILY_V6,
+                    labels::REASON_RATE_LIMIT,
+                    syn_rate_limited_v6_count_from_path(path),
+                ),
+            ] {
+                observer.observe(
+                    count.unwrap_or(0),
+                    &[KeyValue::new(labels::FAMILY, family), KeyValue::new(labels::REASON, reason)],
+                );
+            }
+        })
+        .build();
+
     let _ = meter
         .u64_observable_counter("tcp_syn_malformed_total")
         .with_description(
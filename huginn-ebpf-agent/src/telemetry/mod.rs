@@ -1,3 +1,4 @@
+pub mod debug;
 pub mod health;
 pub mod http;
 pub mod metrics;
@@ -5,5 +6,6 @@ pub mod metrics_handler;
 pub mod router;
 pub mod server;
 pub mod status;
+pub use debug::DebugEndpoints;
 pub use metrics::init_metrics;
 pub use server::start_observability_server;
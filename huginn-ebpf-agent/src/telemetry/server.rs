@@ -1,3 +1,4 @@
+use crate::telemetry::debug::{DebugEndpoints, DEBUG_PREFIX};
 use crate::telemetry::router::dispatch;
 use hyper::body::Incoming;
 use hyper::Request;
@@ -13,7 +14,9 @@ pub async fn start_observability_server(
     port: u16,
     registry: Arc<Registry>,
     pin_path: String,
+    debug: Option<DebugEndpoints>,
 ) -> crate::error::Result<()> {
+    let debug = debug.map(Arc::new);
     let addr = format!("{}:{}", listen_addr, port);
     let listener = TcpListener::bind(&addr).await?;
     info!(%addr, "Observability server started (health, ready, live, metrics)");
@@ -29,11 +32,22 @@ pub async fn start_observability_server(
 
         let registry = Arc::clone(&registry);
         let pin_path = pin_path.clone();
+        let debug = debug.clone();
         tokio::spawn(async move {
             let svc = hyper::service::service_fn(move |req: Request<Incoming>| {
                 let registry = registry.clone();
                 let pin_path = pin_path.clone();
-                async move { Ok::<_, hyper::Error>(dispatch(req.uri().path(), &registry, &pin_path)) }
+                let debug = debug.clone();
+                async move {
+                    let path = req.uri().path();
+                    let response = match debug.as_deref() {
+                        Some(debug) if path.starts_with(DEBUG_PREFIX) => {
+                            debug.handle(path, req.uri().query(), req.headers()).await
+                        }
+                        _ => dispatch(path, &registry, &pin_path),
+                    };
+                    Ok::<_, hyper::Error>(response)
+                }
             });
 
             let builder = ConnBuilder::new(TokioExecutor::new());
@@ -2,8 +2,8 @@ use std::collections::HashMap;
 use std::net::{Ipv4Addr, Ipv6Addr};
 
 use huginn_ebpf_agent::config::{
-    from_env, resolve_capture_backend, CaptureBackend, ConfigError, EbpfLogLevel, XdpAttachMode,
-    DEFAULT_PIN_PATH,
+    from_env, resolve_capture_backend, CaptureBackend, ConfigError, EbpfLogLevel, SynRateLimit,
+    XdpAttachMode, DEFAULT_PIN_PATH,
 };
 
 /// Build a `get_var` closure from a list of (name, value) pairs.
@@ -107,6 +107,8 @@ fn from_env_minimal_applies_defaults() {
     assert_eq!(cfg.syn_map_max_entries, huginn_ebpf::DEFAULT_SYN_MAP_MAX_ENTRIES);
     assert!(matches!(cfg.capture, CaptureBackend::Xdp(XdpAttachMode::Native)));
     assert_eq!(cfg.log_level, EbpfLogLevel::Off, "log level must default to off");
+    assert!(cfg.debug_token.is_none(), "debug endpoints must default to off");
+    assert!(cfg.syn_rate_limit.is_none(), "SYN rate limiting must default to off");
 }
 
 #[test]
@@ -117,6 +119,9 @@ fn from_env_full_overrides_every_optional() {
         ("HUGINN_EBPF_SYN_MAP_MAX_ENTRIES", "16384"),
         ("HUGINN_EBPF_CAPTURE", "tc"),
         ("HUGINN_EBPF_LOG_LEVEL", "debug"),
+        ("HUGINN_EBPF_DEBUG_TOKEN", "0123456789abcdef"),
+        ("HUGINN_EBPF_SYN_RATE_LIMIT", "50"),
+        ("HUGINN_EBPF_SYN_RATE_BURST", "200"),
     ]));
     assert_eq!(cfg.dst_ip_v6, Ipv6Addr::new(0x2001, 0x0db8, 0, 0, 0, 0, 0, 1));
     assert_eq!(cfg.pin_path, "/run/bpf/huginn");
@@ -127,6 +132,16 @@ fn from_env_full_overrides_every_optional() {
         EbpfLogLevel::Debug,
         "HUGINN_EBPF_LOG_LEVEL=debug should be parsed"
     );
+    assert_eq!(cfg.debug_token.as_deref(), Some("0123456789abcdef"));
+    assert_eq!(cfg.syn_rate_limit, Some(SynRateLimit { per_second: 50, burst: 200 }));
+}
+
+#[test]
+fn syn_rate_burst_defaults_to_the_rate() {
+    let cfg = parse_ok(required_with(&[("HUGINN_EBPF_SYN_RATE_LIMIT", "20")]));
+    assert_eq!(cfg.syn_rate_limit, Some(SynRateLimit { per_second: 20, burst: 20 }));
+    let cfg = parse_ok(required_with(&[("HUGINN_EBPF_SYN_RATE_LIMIT", "0")]));
+    assert!(cfg.syn_rate_limit.is_none(), "a zero rate turns the limit off");
 }
 
 #[test]
@@ -175,6 +190,9 @@ fn from_env_invalid_values_are_reported() {
         ("HUGINN_EBPF_METRICS_PORT", "-1"),
         ("HUGINN_EBPF_SYN_MAP_MAX_ENTRIES", "lots"),
         ("HUGINN_EBPF_LOG_LEVEL", "verbose"),
+        ("HUGINN_EBPF_DEBUG_TOKEN", "too-short"),
+        ("HUGINN_EBPF_SYN_RATE_LIMIT", "-5"),
+        ("HUGINN_EBPF_SYN_RATE_BURST", "10"),
     ] {
         let result = from_env(required_with(&[(name, bad)]));
         assert!(
@@ -40,6 +40,25 @@ pub const TCPOPT_MAXLEN: usize = 40;
 pub const TCP_SYN_MAP_V4_MAX_ENTRIES: u32 = 8192;
 pub const TCP_SYN_MAP_V6_MAX_ENTRIES: u32 = 8192;
 
+// ── SYN enforcement maps ───────────────────────────────────────────────────────
+//
+// Denylist LPM tries are created with `BPF_F_NO_PREALLOC`, so the capacity costs nothing until
+// the proxy fills them. The rate-limit buckets are per-CPU LRU hashes: one 16-byte bucket per
+// source per CPU, so their memory grows with the CPU count.
+
+pub const SYN_DENY_V4_MAX_ENTRIES: u32 = 262_144;
+pub const SYN_DENY_V6_MAX_ENTRIES: u32 = 262_144;
+pub const SYN_RATE_V4_MAX_ENTRIES: u32 = 16_384;
+pub const SYN_RATE_V6_MAX_ENTRIES: u32 = 16_384;
+
+// ── SYN event ring buffer ─────────────────────────────────────────────────────
+//
+// `syn_events` byte size: a power of two and a multiple of the page size. Holds roughly 3000
+// records (64-byte IPv4 / 80-byte IPv6 samples plus an 8-byte header each) between two drains
+// by the proxy's consumer.
+
+pub const SYN_EVENTS_RING_BYTES: u32 = 256 * 1024;
+
 // BPF program entry-point names. Kernel `main.rs` asserts these match the fn identifiers.
 pub const XDP_SYN_PROGRAM: &str = "huginn_xdp_syn";
 pub const TC_SYN_PROGRAM: &str = "huginn_tc_syn";
@@ -10,13 +10,19 @@ pub mod constants;
 pub mod headers;
 pub mod keys;
 pub mod quirk_bits;
+mod record;
+pub mod syn_guard;
 pub mod syn_raw_v4;
 pub mod syn_raw_v6;
 
 pub use keys::{make_key_v4, make_key_v6};
+pub use syn_guard::SynBucket;
 pub use syn_raw_v4::SynRawDataV4;
 pub use syn_raw_v6::SynRawDataV6;
 
+// `syn_events` ring-buffer samples are told apart by length alone.
+const _: () = assert!(core::mem::size_of::<SynRawDataV4>() != core::mem::size_of::<SynRawDataV6>());
+
 /// Compile-time string equality for BPF entry-point name assertions.
 #[inline]
 #[must_use]
@@ -0,0 +1,33 @@
+//! Field readers for decoding SYN records copied out of a BPF ring buffer.
+//!
+//! Ring-buffer samples arrive as plain byte slices in the producer's layout; these helpers read a
+//! field at its `offset_of!` position so decoding stays in safe code and tracks the `#[repr(C)]`
+//! struct definitions automatically.
+
+use core::mem::size_of;
+
+/// `N` bytes starting at `offset`, or `None` when the slice is too short.
+#[inline]
+pub(crate) fn array_at<const N: usize>(bytes: &[u8], offset: usize) -> Option<[u8; N]> {
+    bytes.get(offset..offset.checked_add(N)?)?.try_into().ok()
+}
+
+#[inline]
+pub(crate) fn u8_at(bytes: &[u8], offset: usize) -> Option<u8> {
+    bytes.get(offset).copied()
+}
+
+#[inline]
+pub(crate) fn u16_at(bytes: &[u8], offset: usize) -> Option<u16> {
+    array_at::<{ size_of::<u16>() }>(bytes, offset).map(u16::from_ne_bytes)
+}
+
+#[inline]
+pub(crate) fn u32_at(bytes: &[u8], offset: usize) -> Option<u32> {
+    array_at::<{ size_of::<u32>() }>(bytes, offset).map(u32::from_ne_bytes)
+}
+
+#[inline]
+pub(crate) fn u64_at(bytes: &[u8], offset: usize) -> Option<u64> {
+    array_at::<{ size_of::<u64>() }>(bytes, offset).map(u64::from_ne_bytes)
+}
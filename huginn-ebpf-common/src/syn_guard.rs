@@ -0,0 +1,52 @@
+//! Per-source SYN token bucket, shared by the BPF programs (which keep one bucket per source in
+//! `syn_rate_v4`/`syn_rate_v6`) and userspace (which derives the loader-patched parameters).
+//!
+//! The bucket holds credit in nanoseconds rather than tokens: it refills by one nanosecond per
+//! nanosecond up to `burst_ns`, and each SYN costs `cost_ns = 1e9 / per_second`. That keeps the
+//! datapath free of divisions and floating point.
+
+/// Nanoseconds per second, the unit the bucket refills in.
+const NANOS_PER_SEC: u64 = 1_000_000_000;
+
+#[repr(C)]
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct SynBucket {
+    /// Unspent credit in nanoseconds, at most `burst_ns`.
+    pub credit_ns: u64,
+    /// Monotonic time (`bpf_ktime_get_ns`) of the last refill.
+    pub last_ns: u64,
+}
+
+impl SynBucket {
+    /// Bucket of a source first seen at `now_ns`, with its first SYN already spent.
+    #[inline(always)]
+    pub fn first(now_ns: u64, cost_ns: u64, burst_ns: u64) -> Self {
+        Self { credit_ns: burst_ns.saturating_sub(cost_ns), last_ns: now_ns }
+    }
+
+    /// Refill up to `now_ns` and spend one SYN; `false` (nothing spent) when the credit is short.
+    #[inline(always)]
+    pub fn take(&mut self, now_ns: u64, cost_ns: u64, burst_ns: u64) -> bool {
+        let elapsed = now_ns.saturating_sub(self.last_ns);
+        let credit = self.credit_ns.saturating_add(elapsed).min(burst_ns);
+        self.last_ns = now_ns;
+        if credit < cost_ns {
+            self.credit_ns = credit;
+            return false;
+        }
+        self.credit_ns = credit.saturating_sub(cost_ns);
+        true
+    }
+}
+
+/// `(cost_ns, burst_ns)` for a limit of `per_second` SYNs with bursts of `burst`; `(0, 0)` (rate
+/// limiting off) when `per_second` is 0. A zero `burst` is taken as 1.
+#[must_use]
+pub fn rate_limit_ns(per_second: u32, burst: u32) -> (u64, u64) {
+    let Some(cost_ns) = NANOS_PER_SEC.checked_div(u64::from(per_second)) else {
+        return (0, 0);
+    };
+    // Above 1e9/s the cost would round to zero, which the programs read as "off".
+    let cost_ns = cost_ns.max(1);
+    (cost_ns, cost_ns.saturating_mul(u64::from(burst.max(1))))
+}
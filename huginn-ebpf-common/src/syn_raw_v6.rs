@@ -1,4 +1,5 @@
-//! Raw data extracted from an IPv6 TCP SYN packet, stored in the BPF LRU map.
+//! Raw data extracted from an IPv6 TCP SYN packet, stored in the BPF LRU map and pushed to the
+//! `syn_events` ring buffer.
 //!
 //! Layout is the single source of truth for both `huginn-ebpf-programs` and `huginn-ebpf`.
 //!
@@ -16,6 +17,10 @@
 //! total: 76 bytes
 //! ```
 
+use core::mem::{offset_of, size_of};
+
+use crate::record::{array_at, u16_at, u32_at, u64_at, u8_at};
+
 #[repr(C)]
 #[derive(Clone, Copy, Debug)]
 pub struct SynRawDataV6 {
@@ -48,6 +53,29 @@ impl Default for SynRawDataV6 {
     }
 }
 
+impl SynRawDataV6 {
+    /// Decode a record from its in-memory bytes (e.g. a `syn_events` ring-buffer sample).
+    ///
+    /// Returns `None` unless `bytes` is exactly `size_of::<SynRawDataV6>()` long.
+    pub fn from_ne_bytes(bytes: &[u8]) -> Option<Self> {
+        if bytes.len() != size_of::<Self>() {
+            return None;
+        }
+        Some(Self {
+            src_addr: array_at(bytes, offset_of!(Self, src_addr))?,
+            src_port: u16_at(bytes, offset_of!(Self, src_port))?,
+            window: u16_at(bytes, offset_of!(Self, window))?,
+            optlen: u8_at(bytes, offset_of!(Self, optlen))?,
+            ip_tos: u8_at(bytes, offset_of!(Self, ip_tos))?,
+            ip_ttl: u8_at(bytes, offset_of!(Self, ip_ttl))?,
+            _pad: u8_at(bytes, offset_of!(Self, _pad))?,
+            options: array_at(bytes, offset_of!(Self, options))?,
+            quirks: u32_at(bytes, offset_of!(Self, quirks))?,
+            tick: u64_at(bytes, offset_of!(Self, tick))?,
+        })
+    }
+}
+
 /// SAFETY: `SynRawDataV6` is `#[repr(C)]`, `Copy`, fully initialized with no implicit padding.
 #[cfg(feature = "aya")]
 #[allow(unsafe_code)]
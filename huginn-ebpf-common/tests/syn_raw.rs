@@ -0,0 +1,64 @@
+//! `from_ne_bytes` decodes `syn_events` ring-buffer samples. The byte layout is whatever the BPF
+//! program copies out of the `#[repr(C)]` struct, so these tests build samples field by field at
+//! their `offset_of!` positions and check the round trip.
+
+use core::mem::{offset_of, size_of};
+
+use huginn_ebpf_common::{SynRawDataV4, SynRawDataV6};
+
+type TestResult = Result<(), Box<dyn std::error::Error + Send + Sync>>;
+
+fn put(buf: &mut [u8], offset: usize, bytes: &[u8]) {
+    buf[offset..][..bytes.len()].copy_from_slice(bytes);
+}
+
+#[test]
+fn v4_sample_round_trips() -> TestResult {
+    let mut buf = vec![0u8; size_of::<SynRawDataV4>()];
+    put(&mut buf, offset_of!(SynRawDataV4, src_addr), &0x0100_000Au32.to_ne_bytes());
+    put(&mut buf, offset_of!(SynRawDataV4, src_port), &443u16.to_be().to_ne_bytes());
+    put(&mut buf, offset_of!(SynRawDataV4, window), &65535u16.to_ne_bytes());
+    put(&mut buf, offset_of!(SynRawDataV4, optlen), &[20]);
+    put(&mut buf, offset_of!(SynRawDataV4, ip_ttl), &[64]);
+    put(&mut buf, offset_of!(SynRawDataV4, options), &[2, 4, 5, 180]);
+    put(&mut buf, offset_of!(SynRawDataV4, quirks), &0b101u32.to_ne_bytes());
+    put(&mut buf, offset_of!(SynRawDataV4, tick), &42u64.to_ne_bytes());
+
+    let raw = SynRawDataV4::from_ne_bytes(&buf).ok_or("valid v4 sample rejected")?;
+    assert_eq!(raw.src_addr, 0x0100_000A);
+    assert_eq!(u16::from_be(raw.src_port), 443);
+    assert_eq!(raw.window, 65535);
+    assert_eq!(raw.optlen, 20);
+    assert_eq!(raw.ip_ttl, 64);
+    assert_eq!(raw.options[..4], [2, 4, 5, 180]);
+    assert_eq!(raw.quirks, 0b101);
+    assert_eq!(raw.tick, 42);
+    Ok(())
+}
+
+#[test]
+fn v6_sample_round_trips() -> TestResult {
+    let addr = [0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1];
+    let mut buf = vec![0u8; size_of::<SynRawDataV6>()];
+    put(&mut buf, offset_of!(SynRawDataV6, src_addr), &addr);
+    put(&mut buf, offset_of!(SynRawDataV6, src_port), &8443u16.to_be().to_ne_bytes());
+    put(&mut buf, offset_of!(SynRawDataV6, ip_ttl), &[57]);
+    put(&mut buf, offset_of!(SynRawDataV6, tick), &7u64.to_ne_bytes());
+
+    let raw = SynRawDataV6::from_ne_bytes(&buf).ok_or("valid v6 sample rejected")?;
+    assert_eq!(raw.src_addr, addr);
+    assert_eq!(u16::from_be(raw.src_port), 8443);
+    assert_eq!(raw.ip_ttl, 57);
+    assert_eq!(raw.tick, 7);
+    Ok(())
+}
+
+#[test]
+fn wrong_length_is_rejected() {
+    let v4 = vec![0u8; size_of::<SynRawDataV4>()];
+    let v6 = vec![0u8; size_of::<SynRawDataV6>()];
+    assert!(SynRawDataV4::from_ne_bytes(&v4[1..]).is_none());
+    assert!(SynRawDataV4::from_ne_bytes(&v6).is_none());
+    assert!(SynRawDataV6::from_ne_bytes(&v4).is_none());
+    assert!(SynRawDataV6::from_ne_bytes(&[]).is_none());
+}
@@ -1,4 +1,4 @@
-//! TCP SYN capture: XDP and TC clsact hooks in one ELF.
+//! TCP SYN capture and enforcement: XDP and TC clsact hooks in one ELF.
 #![no_std]
 #![no_main]
 #![deny(unsafe_code)]
@@ -15,14 +15,12 @@ mod xdp;
 
 #[xdp]
 pub fn huginn_xdp_syn(ctx: XdpContext) -> u32 {
-    let _ = xdp::try_xdp_syn(&ctx);
-    XDP_PASS
+    xdp::try_xdp_syn(&ctx).unwrap_or(XDP_PASS)
 }
 
 #[classifier]
 pub fn huginn_tc_syn(ctx: TcContext) -> i32 {
-    let _ = tc::try_tc_syn(&ctx);
-    TC_ACT_OK
+    tc::try_tc_syn(&ctx).unwrap_or(TC_ACT_OK)
 }
 
 // Entry-point names must match huginn_ebpf_common::constants::{XDP_SYN_PROGRAM, TC_SYN_PROGRAM}.
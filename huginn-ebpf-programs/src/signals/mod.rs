@@ -1,3 +1,4 @@
 //! Capture signals dispatched from the datapath pipelines.
 
+pub mod syn_guard;
 pub mod tcp_syn;
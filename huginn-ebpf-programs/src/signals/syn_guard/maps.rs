@@ -0,0 +1,153 @@
+use aya_ebpf::{
+    bindings::BPF_F_NO_PREALLOC,
+    helpers::bpf_ktime_get_ns,
+    macros::map,
+    maps::{lpm_trie::Key, LpmTrie, LruPerCpuHashMap, PerCpuArray},
+};
+
+use huginn_ebpf_common::constants::{
+    SYN_DENY_V4_MAX_ENTRIES, SYN_DENY_V6_MAX_ENTRIES, SYN_RATE_V4_MAX_ENTRIES,
+    SYN_RATE_V6_MAX_ENTRIES,
+};
+use huginn_ebpf_common::SynBucket;
+
+// Source prefixes whose SYNs are dropped, written by the proxy from its global
+// `[security.ip_filter]` denylist. Keys are in wire byte order; the value is unused.
+#[map]
+#[allow(non_upper_case_globals)]
+pub static syn_deny_v4: LpmTrie<[u8; 4], u8> =
+    LpmTrie::with_max_entries(SYN_DENY_V4_MAX_ENTRIES, BPF_F_NO_PREALLOC);
+
+#[map]
+#[allow(non_upper_case_globals)]
+pub static syn_deny_v6: LpmTrie<[u8; 16], u8> =
+    LpmTrie::with_max_entries(SYN_DENY_V6_MAX_ENTRIES, BPF_F_NO_PREALLOC);
+
+// Token buckets per source address. Per-CPU, so updates need no atomics; the limit therefore
+// applies per receive queue, and a source whose SYNs RSS spreads over N queues gets up to N times
+// the configured rate.
+#[map]
+#[allow(non_upper_case_globals)]
+pub static syn_rate_v4: LruPerCpuHashMap<u32, SynBucket> =
+    LruPerCpuHashMap::with_max_entries(SYN_RATE_V4_MAX_ENTRIES, 0);
+
+#[map]
+#[allow(non_upper_case_globals)]
+pub static syn_rate_v6: LruPerCpuHashMap<[u8; 16], SynBucket> =
+    LruPerCpuHashMap::with_max_entries(SYN_RATE_V6_MAX_ENTRIES, 0);
+
+#[map]
+#[allow(non_upper_case_globals)]
+pub static syn_denied_v4: PerCpuArray<u64> = PerCpuArray::with_max_entries(1, 0);
+
+#[map]
+#[allow(non_upper_case_globals)]
+pub static syn_rate_limited_v4: PerCpuArray<u64> = PerCpuArray::with_max_entries(1, 0);
+
+#[map]
+#[allow(non_upper_case_globals)]
+pub static syn_denied_v6: PerCpuArray<u64> = PerCpuArray::with_max_entries(1, 0);
+
+#[map]
+#[allow(non_upper_case_globals)]
+pub static syn_rate_limited_v6: PerCpuArray<u64> = PerCpuArray::with_max_entries(1, 0);
+
+#[inline(always)]
+pub fn deny_v4_contains(addr: [u8; 4]) -> bool {
+    syn_deny_v4.get(&Key::new(32, addr)).is_some()
+}
+
+#[inline(always)]
+pub fn deny_v6_contains(addr: [u8; 16]) -> bool {
+    syn_deny_v6.get(&Key::new(128, addr)).is_some()
+}
+
+#[inline(always)]
+pub fn rate_v4_take(saddr: u32) -> bool {
+    rate_take(&syn_rate_v4, &saddr)
+}
+
+#[inline(always)]
+pub fn rate_v6_take(saddr: [u8; 16]) -> bool {
+    rate_take(&syn_rate_v6, &saddr)
+}
+
+/// Spend one SYN from the source's bucket; `true` when rate limiting is off. A full LRU evicts the
+/// least recently seen source, whose next SYN then starts from a full bucket.
+#[allow(unsafe_code)]
+#[inline(always)]
+fn rate_take<K>(buckets: &LruPerCpuHashMap<K, SynBucket>, key: &K) -> bool {
+    let cost_ns = rate_cost_ns();
+    if cost_ns == 0 {
+        return true;
+    }
+    let burst_ns = rate_burst_ns();
+    // SAFETY: bpf_ktime_get_ns has no preconditions.
+    let now_ns = unsafe { bpf_ktime_get_ns() };
+    match buckets.get_ptr_mut(key) {
+        // SAFETY: ptr from get_ptr_mut(Some) is this CPU's slot of a live map entry.
+        Some(bucket) => unsafe { (*bucket).take(now_ns, cost_ns, burst_ns) },
+        None => {
+            // An insert failure passes the SYN: enforcement never fails closed.
+            let _ = buckets.insert(key, &SynBucket::first(now_ns, cost_ns, burst_ns), 0);
+            true
+        }
+    }
+}
+
+#[allow(unsafe_code)]
+#[inline(always)]
+fn increment(counter: &PerCpuArray<u64>) {
+    if let Some(ptr) = counter.get_ptr_mut(0) {
+        // SAFETY: ptr from get_ptr_mut(Some) is a valid map slot.
+        unsafe {
+            let v = *ptr;
+            *ptr = v.wrapping_add(1);
+        }
+    }
+}
+
+#[inline(always)]
+pub fn increment_syn_denied_v4() {
+    increment(&syn_denied_v4);
+}
+
+#[inline(always)]
+pub fn increment_syn_rate_limited_v4() {
+    increment(&syn_rate_limited_v4);
+}
+
+#[inline(always)]
+pub fn increment_syn_denied_v6() {
+    increment(&syn_denied_v6);
+}
+
+#[inline(always)]
+pub fn increment_syn_rate_limited_v6() {
+    increment(&syn_rate_limited_v6);
+}
+
+// Loader-patched globals: nanoseconds of bucket credit per SYN and the bucket size (see
+// `huginn_ebpf_common::syn_guard`). A zero cost turns rate limiting off.
+
+#[allow(unsafe_code)]
+#[export_name = "syn_rate_cost_ns"]
+static SYN_RATE_COST_NS: u64 = 0;
+
+#[allow(unsafe_code)]
+#[export_name = "syn_rate_burst_ns"]
+static SYN_RATE_BURST_NS: u64 = 0;
+
+#[allow(unsafe_code)]
+#[inline(always)]
+fn rate_cost_ns() -> u64 {
+    // SAFETY: read_volatile of a loader-patched global.
+    unsafe { core::ptr::read_volatile(&SYN_RATE_COST_NS) }
+}
+
+#[allow(unsafe_code)]
+#[inline(always)]
+fn rate_burst_ns() -> u64 {
+    // SAFETY: read_volatile of a loader-patched global.
+    unsafe { core::ptr::read_volatile(&SYN_RATE_BURST_NS) }
+}
@@ -0,0 +1,66 @@
+//! SYN enforcement ahead of capture: a source denylist filled by the proxy and a per-source token
+//! bucket configured by the agent. Map names and key encoding must match `huginn-ebpf`.
+
+mod maps;
+
+use maps::{
+    deny_v4_contains, deny_v6_contains, increment_syn_denied_v4, increment_syn_denied_v6,
+    increment_syn_rate_limited_v4, increment_syn_rate_limited_v6, rate_v4_take, rate_v6_take,
+};
+
+/// What to do with a SYN that reached the destination filter.
+#[derive(Clone, Copy, PartialEq, Eq)]
+pub enum Verdict {
+    Pass,
+    /// Source on the denylist.
+    Denied,
+    /// Source over its SYN rate.
+    RateLimited,
+}
+
+impl Verdict {
+    #[inline(always)]
+    pub fn is_drop(self) -> bool {
+        self != Verdict::Pass
+    }
+
+    /// Drop reason for the datapath logs.
+    #[inline(always)]
+    pub fn as_str(self) -> &'static str {
+        match self {
+            Verdict::Pass => "pass",
+            Verdict::Denied => "denylist",
+            Verdict::RateLimited => "rate_limit",
+        }
+    }
+}
+
+/// Check an IPv4 source (`saddr` in network byte order as read on a LE CPU). The denylist is
+/// checked first so denied sources don't spend rate-limit tokens.
+#[inline(always)]
+pub fn check_v4(saddr: u32) -> Verdict {
+    let addr = saddr.to_ne_bytes();
+    if deny_v4_contains(addr) {
+        increment_syn_denied_v4();
+        return Verdict::Denied;
+    }
+    if !rate_v4_take(saddr) {
+        increment_syn_rate_limited_v4();
+        return Verdict::RateLimited;
+    }
+    Verdict::Pass
+}
+
+/// Check an IPv6 source (wire byte order).
+#[inline(always)]
+pub fn check_v6(saddr: [u8; 16]) -> Verdict {
+    if deny_v6_contains(saddr) {
+        increment_syn_denied_v6();
+        return Verdict::Denied;
+    }
+    if !rate_v6_take(saddr) {
+        increment_syn_rate_limited_v6();
+        return Verdict::RateLimited;
+    }
+    Verdict::Pass
+}
@@ -1,6 +1,6 @@
 use super::maps::{
     increment_syn_captured_v4, increment_syn_captured_v6, increment_syn_insert_failures_v4,
-    increment_syn_insert_failures_v6, read_and_increment_syn_counter, tcp_syn_map_v4,
+    increment_syn_insert_failures_v6, read_and_increment_syn_counter, syn_events, tcp_syn_map_v4,
     tcp_syn_map_v6,
 };
 use aya_ebpf::programs::XdpContext;
@@ -74,6 +74,9 @@ pub fn finish_tcp_syn_v4(
         tick,
     };
 
+    // Best effort: a full ring (no consumer, or one falling behind) only loses the event.
+    let _ = syn_events.output(&syn_raw_data, 0);
+
     let key = make_key_v4(ip.saddr, tcp.source);
     if tcp_syn_map_v4.insert(key, syn_raw_data, 0).is_err() {
         increment_syn_insert_failures_v4();
@@ -131,6 +134,9 @@ pub fn finish_tcp_syn_v6(
         tick,
     };
 
+    // Best effort, as for IPv4.
+    let _ = syn_events.output(&syn_raw_data, 0);
+
     let key = make_key_v6(ip6.saddr, tcp.source);
     if tcp_syn_map_v6.insert(key, syn_raw_data, 0).is_err() {
         increment_syn_insert_failures_v6();
@@ -1,9 +1,11 @@
 use aya_ebpf::{
     macros::map,
-    maps::{Array, LruHashMap, PerCpuArray},
+    maps::{Array, LruHashMap, PerCpuArray, RingBuf},
 };
 
-use huginn_ebpf_common::constants::{TCP_SYN_MAP_V4_MAX_ENTRIES, TCP_SYN_MAP_V6_MAX_ENTRIES};
+use huginn_ebpf_common::constants::{
+    SYN_EVENTS_RING_BYTES, TCP_SYN_MAP_V4_MAX_ENTRIES, TCP_SYN_MAP_V6_MAX_ENTRIES,
+};
 use huginn_ebpf_common::{SynRawDataV4, SynRawDataV6};
 
 #[map]
@@ -27,6 +29,13 @@ pub static syn_counter: Array<u64> = Array::with_max_entries(1, 0);
 #[allow(non_upper_case_globals)]
 pub static syn_meta: Array<u64> = Array::with_max_entries(1, 0);
 
+// Every captured SYN (both families) is also pushed here for proxies that consume events instead
+// of looking up the LRU maps. Samples are told apart by length (`SynRawDataV4` vs `V6`). A full
+// ring drops the sample; the LRU entry is still written.
+#[map]
+#[allow(non_upper_case_globals)]
+pub static syn_events: RingBuf = RingBuf::with_byte_size(SYN_EVENTS_RING_BYTES, 0);
+
 #[map]
 #[allow(non_upper_case_globals)]
 pub static syn_insert_failures_v4: PerCpuArray<u64> = PerCpuArray::with_max_entries(1, 0);
@@ -1,14 +1,17 @@
 //! TC clsact ingress capture. GRO-safe alternative to XDP on VLAN/bond edges.
+//!
+//! Enforces the same [`syn_guard`] verdicts as XDP, dropping with `TC_ACT_SHOT`.
 
+use aya_ebpf::bindings::{TC_ACT_OK, TC_ACT_SHOT};
 use aya_ebpf::programs::TcContext;
 use aya_log_ebpf::{debug, warn};
 use core::mem;
 
-use crate::signals::tcp_syn;
+use crate::signals::{syn_guard, tcp_syn};
 use huginn_ebpf_common::constants::*;
 use huginn_ebpf_common::headers::{EthHdr, Ip4Hdr, Ip6Hdr, TcpHdr, VlanHdr};
 
-pub fn try_tc_syn(ctx: &TcContext) -> Result<(), ()> {
+pub fn try_tc_syn(ctx: &TcContext) -> Result<i32, ()> {
     let mut offset = 0usize;
 
     let eth: EthHdr = ctx.load(offset).map_err(|_| ())?;
@@ -34,29 +37,29 @@ pub fn try_tc_syn(ctx: &TcContext) -> Result<(), ()> {
         return handle_ipv6(ctx, offset);
     }
 
-    Ok(())
+    Ok(TC_ACT_OK)
 }
 
-fn handle_ipv4(ctx: &TcContext, offset: usize) -> Result<(), ()> {
+fn handle_ipv4(ctx: &TcContext, offset: usize) -> Result<i32, ()> {
     let ip: Ip4Hdr = ctx.load(offset).map_err(|_| ())?;
 
     let ip_hdr_len = usize::from(ip.ihl()).saturating_mul(4);
     if ip_hdr_len < mem::size_of::<Ip4Hdr>() {
-        return Ok(());
+        return Ok(TC_ACT_OK);
     }
 
     let frag_off = ip.frag_off;
     if frag_off & (IP_MF | IP_OFFSET) != 0 {
-        return Ok(());
+        return Ok(TC_ACT_OK);
     }
 
     if ip.protocol != IPPROTO_TCP {
-        return Ok(());
+        return Ok(TC_ACT_OK);
     }
 
     let dst_ip_v4_val = tcp_syn::dst_ip_v4();
     if dst_ip_v4_val != 0 && ip.daddr != dst_ip_v4_val {
-        return Ok(());
+        return Ok(TC_ACT_OK);
     }
 
     let tcp_offset = offset.saturating_add(ip_hdr_len);
@@ -65,16 +68,29 @@ fn handle_ipv4(ctx: &TcContext, offset: usize) -> Result<(), ()> {
     let tcp_hdr_len = usize::from(tcp.doff()).saturating_mul(4);
     if tcp_hdr_len < mem::size_of::<TcpHdr>() {
         tcp_syn::increment_syn_malformed_v4();
-        return Ok(());
+        return Ok(TC_ACT_OK);
     }
 
     let dst_port_val = tcp_syn::dst_port();
     if dst_port_val != 0 && tcp.dest != dst_port_val {
-        return Ok(());
+        return Ok(TC_ACT_OK);
     }
 
     if !tcp.syn() || tcp.ack() {
-        return Ok(());
+        return Ok(TC_ACT_OK);
+    }
+
+    let verdict = syn_guard::check_v4(ip.saddr);
+    if verdict.is_drop() {
+        if tcp_syn::log_level() >= tcp_syn::level::DEBUG {
+            debug!(
+                ctx,
+                "tc: dropped TCP SYN v4 sport={} reason={}",
+                u16::from_be(tcp.source),
+                verdict.as_str()
+            );
+        }
+        return Ok(TC_ACT_SHOT);
     }
 
     let opts_offset = tcp_offset.saturating_add(mem::size_of::<TcpHdr>());
@@ -93,21 +109,21 @@ fn handle_ipv4(ctx: &TcContext, offset: usize) -> Result<(), ()> {
         }
         _ => {}
     }
-    result.map_err(|_| ())
+    result.map(|()| TC_ACT_OK).map_err(|_| ())
 }
 
 // Only fixed-header nexthdr == TCP is fingerprinted; extension headers before TCP are skipped.
-fn handle_ipv6(ctx: &TcContext, offset: usize) -> Result<(), ()> {
+fn handle_ipv6(ctx: &TcContext, offset: usize) -> Result<i32, ()> {
     let ip6: Ip6Hdr = ctx.load(offset).map_err(|_| ())?;
 
     if ip6.nexthdr != IPPROTO_TCP {
-        return Ok(());
+        return Ok(TC_ACT_OK);
     }
 
     let dst_ip_v6_val = tcp_syn::dst_ip_v6();
     let is_zero = dst_ip_v6_val.iter().all(|&b| b == 0);
     if !is_zero && ip6.daddr != dst_ip_v6_val {
-        return Ok(());
+        return Ok(TC_ACT_OK);
     }
 
     let tcp_offset = offset.saturating_add(mem::size_of::<Ip6Hdr>());
@@ -116,16 +132,29 @@ fn handle_ipv6(ctx: &TcContext, offset: usize) -> Result<(), ()> {
     let tcp_hdr_len = usize::from(tcp.doff()).saturating_mul(4);
     if tcp_hdr_len < mem::size_of::<TcpHdr>() {
         tcp_syn::increment_syn_malformed_v6();
-        return Ok(());
+        return Ok(TC_ACT_OK);
     }
 
     let dst_port_val = tcp_syn::dst_port();
     if dst_port_val != 0 && tcp.dest != dst_port_val {
-        return Ok(());
+        return Ok(TC_ACT_OK);
     }
 
     if !tcp.syn() || tcp.ack() {
-        return Ok(());
+        return Ok(TC_ACT_OK);
+    }
+
+    let verdict = syn_guard::check_v6(ip6.saddr);
+    if verdict.is_drop() {
+        if tcp_syn::log_level() >= tcp_syn::level::DEBUG {
+            debug!(
+                ctx,
+                "tc: dropped TCP SYN v6 sport={} reason={}",
+                u16::from_be(tcp.source),
+                verdict.as_str()
+            );
+        }
+        return Ok(TC_ACT_SHOT);
     }
 
     let opts_offset = tcp_offset.saturating_add(mem::size_of::<TcpHdr>());
@@ -144,7 +173,7 @@ fn handle_ipv6(ctx: &TcContext, offset: usize) -> Result<(), ()> {
         }
         _ => {}
     }
-    result.map_err(|_| ())
+    result.map(|()| TC_ACT_OK).map_err(|_| ())
 }
 
 // load::<u8> per byte: bpf_skb_load_bytes rejects zero-length reads; the verifier accepts constant 1-byte loads.
@@ -1,7 +1,11 @@
 //! XDP capture pipeline. Direct packet access; use TC on VLAN/bond edges.
+//!
+//! SYNs to the proxy that fail [`syn_guard`] are dropped here, before the kernel allocates any
+//! connection state; everything else passes.
 
 mod packet;
 
+use aya_ebpf::bindings::xdp_action::{XDP_DROP, XDP_PASS};
 use aya_ebpf::programs::XdpContext;
 use aya_log_ebpf::{debug, warn};
 use core::mem;
@@ -10,10 +14,10 @@ use huginn_ebpf_common::constants::*;
 use huginn_ebpf_common::headers::{EthHdr, Ip4Hdr, Ip6Hdr, TcpHdr, VlanHdr};
 use packet::ptr_at;
 
-use crate::signals::tcp_syn;
+use crate::signals::{syn_guard, tcp_syn};
 
 #[allow(unsafe_code)]
-pub fn try_xdp_syn(ctx: &XdpContext) -> Result<(), ()> {
+pub fn try_xdp_syn(ctx: &XdpContext) -> Result<u32, ()> {
     let mut offset = 0usize;
 
     // SAFETY: ptr_at checked bounds; we only deref when Some.
@@ -40,32 +44,32 @@ pub fn try_xdp_syn(ctx: &XdpContext) -> Result<(), ()> {
         return handle_ipv6(ctx, offset);
     }
 
-    Ok(())
+    Ok(XDP_PASS)
 }
 
 #[allow(unsafe_code)]
-fn handle_ipv4(ctx: &XdpContext, mut offset: usize) -> Result<(), ()> {
+fn handle_ipv4(ctx: &XdpContext, mut offset: usize) -> Result<u32, ()> {
     // SAFETY: ptr_at checked bounds.
     let ip = unsafe { ptr_at::<Ip4Hdr>(ctx, offset).ok_or(())? };
 
     let ip_hdr_len = unsafe { usize::from((*ip).ihl()).saturating_mul(4) };
     if ip_hdr_len < mem::size_of::<Ip4Hdr>() {
-        return Ok(());
+        return Ok(XDP_PASS);
     }
     offset = offset.saturating_add(mem::size_of::<Ip4Hdr>());
 
     let frag_off = unsafe { (*ip).frag_off };
     if frag_off & (IP_MF | IP_OFFSET) != 0 {
-        return Ok(());
+        return Ok(XDP_PASS);
     }
 
     if unsafe { (*ip).protocol } != IPPROTO_TCP {
-        return Ok(());
+        return Ok(XDP_PASS);
     }
 
     let dst_ip_v4_val = tcp_syn::dst_ip_v4();
     if dst_ip_v4_val != 0 && unsafe { (*ip).daddr } != dst_ip_v4_val {
-        return Ok(());
+        return Ok(XDP_PASS);
     }
 
     offset = offset.saturating_add(ip_hdr_len.saturating_sub(mem::size_of::<Ip4Hdr>()));
@@ -76,16 +80,29 @@ fn handle_ipv4(ctx: &XdpContext, mut offset: usize) -> Result<(), ()> {
     let tcp_hdr_len = unsafe { usize::from((*tcp).doff()).saturating_mul(4) };
     if tcp_hdr_len < mem::size_of::<TcpHdr>() {
         tcp_syn::increment_syn_malformed_v4();
-        return Ok(());
+        return Ok(XDP_PASS);
     }
 
     let dst_port_val = tcp_syn::dst_port();
     if dst_port_val != 0 && unsafe { (*tcp).dest } != dst_port_val {
-        return Ok(());
+        return Ok(XDP_PASS);
     }
 
     if unsafe { !(*tcp).syn() || (*tcp).ack() } {
-        return Ok(());
+        return Ok(XDP_PASS);
+    }
+
+    let verdict = syn_guard::check_v4(unsafe { (*ip).saddr });
+    if verdict.is_drop() {
+        if tcp_syn::log_level() >= tcp_syn::level::DEBUG {
+            debug!(
+                ctx,
+                "xdp: dropped TCP SYN v4 sport={} reason={}",
+                u16::from_be(unsafe { (*tcp).source }),
+                verdict.as_str()
+            );
+        }
+        return Ok(XDP_DROP);
     }
 
     // SAFETY: ip and tcp validated by ptr_at; valid for the duration of this call.
@@ -105,18 +122,18 @@ fn handle_ipv4(ctx: &XdpContext, mut offset: usize) -> Result<(), ()> {
         }
         _ => {}
     }
-    result.map_err(|_| ())
+    result.map(|()| XDP_PASS).map_err(|_| ())
 }
 
 // Only fixed-header nexthdr == TCP is fingerprinted; extension headers before TCP can bypass capture.
 #[allow(unsafe_code)]
-fn handle_ipv6(ctx: &XdpContext, mut offset: usize) -> Result<(), ()> {
+fn handle_ipv6(ctx: &XdpContext, mut offset: usize) -> Result<u32, ()> {
     // SAFETY: ptr_at checked bounds.
     let ip6 = unsafe { ptr_at::<Ip6Hdr>(ctx, offset).ok_or(())? };
     offset = offset.saturating_add(mem::size_of::<Ip6Hdr>());
 
     if unsafe { (*ip6).nexthdr } != IPPROTO_TCP {
-        return Ok(());
+        return Ok(XDP_PASS);
     }
 
     let dst_ip_v6_val = tcp_syn::dst_ip_v6();
@@ -124,7 +141,7 @@ fn handle_ipv6(ctx: &XdpContext, mut offset: usize) -> Result<(), ()> {
     if !is_zero {
         let daddr = unsafe { (*ip6).daddr };
         if daddr != dst_ip_v6_val {
-            return Ok(());
+            return Ok(XDP_PASS);
         }
     }
 
@@ -134,16 +151,29 @@ fn handle_ipv6(ctx: &XdpContext, mut offset: usize) -> Result<(), ()> {
     let tcp_hdr_len = unsafe { usize::from((*tcp).doff()).saturating_mul(4) };
     if tcp_hdr_len < mem::size_of::<TcpHdr>() {
         tcp_syn::increment_syn_malformed_v6();
-        return Ok(());
+        return Ok(XDP_PASS);
     }
 
     let dst_port_val = tcp_syn::dst_port();
     if dst_port_val != 0 && unsafe { (*tcp).dest } != dst_port_val {
-        return Ok(());
+        return Ok(XDP_PASS);
     }
 
     if unsafe { !(*tcp).syn() || (*tcp).ack() } {
-        return Ok(());
+        return Ok(XDP_PASS);
+    }
+
+    let verdict = syn_guard::check_v6(unsafe { (*ip6).saddr });
+    if verdict.is_drop() {
+        if tcp_syn::log_level() >= tcp_syn::level::DEBUG {
+            debug!(
+                ctx,
+                "xdp: dropped TCP SYN v6 sport={} reason={}",
+                u16::from_be(unsafe { (*tcp).source }),
+                verdict.as_str()
+            );
+        }
+        return Ok(XDP_DROP);
     }
 
     // SAFETY: ip6 and tcp validated by ptr_at; valid for the duration of this call.
@@ -163,5 +193,5 @@ fn handle_ipv6(ctx: &XdpContext, mut offset: usize) -> Result<(), ()> {
         }
         _ => {}
     }
-    result.map_err(|_| ())
+    result.map(|()| XDP_PASS).map_err(|_| ())
 }
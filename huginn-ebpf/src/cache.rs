@@ -0,0 +1,185 @@
+//! In-process cache of captured SYNs, filled from the `syn_events` ring buffer.
+
+use std::collections::{HashMap, VecDeque};
+use std::hash::{BuildHasher, Hash, RandomState};
+use std::net::{Ipv4Addr, Ipv6Addr};
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::Mutex;
+
+use crate::probe::{is_stale, make_bpf_key_v4, make_bpf_key_v6};
+use crate::types::{SynRawDataV4, SynRawDataV6};
+
+/// Number of independently locked shards per IP family (a power of two).
+const SHARDS: usize = 16;
+const SHARD_MASK: u64 = 15;
+
+/// Captured SYNs keyed like the BPF maps, so a lookup after `accept()` is a memory lookup with
+/// no `bpf()` syscall.
+///
+/// Filled by [`SynEventReader::drain`](crate::SynEventReader::drain). Each family keeps its
+/// newest `2 x syn_map_max_entries` records (oldest evicted first, per shard), and a hit older
+/// than that many SYNs relative to the newest record consumed is discarded as stale, the same
+/// bound [`EbpfProbe`](crate::EbpfProbe) applies to LRU map entries. Unlike the LRU maps, a
+/// record is only evicted by newer ones, never by hash-bucket pressure.
+pub struct SynCache {
+    v4: Shards<u64, SynRawDataV4>,
+    v6: Shards<[u8; 18], SynRawDataV6>,
+    syn_map_max_entries: u32,
+    /// Highest capture tick consumed so far (the ring's view of the global SYN counter).
+    latest_tick: AtomicU64,
+}
+
+impl SynCache {
+    pub fn new(syn_map_max_entries: u32) -> Self {
+        let capacity = usize::try_from(syn_map_max_entries)
+            .unwrap_or(usize::MAX)
+            .saturating_mul(2);
+        Self {
+            v4: Shards::new(capacity),
+            v6: Shards::new(capacity),
+            syn_map_max_entries,
+            latest_tick: AtomicU64::new(0),
+        }
+    }
+
+    /// Store one ring-buffer sample, telling the family apart by its length.
+    ///
+    /// Returns `false` (and stores nothing) when the sample matches neither record layout.
+    pub fn insert_sample(&self, sample: &[u8]) -> bool {
+        if let Some(raw) = SynRawDataV4::from_ne_bytes(sample) {
+            self.insert_v4(raw);
+            true
+        } else if let Some(raw) = SynRawDataV6::from_ne_bytes(sample) {
+            self.insert_v6(raw);
+            true
+        } else {
+            false
+        }
+    }
+
+    pub fn insert_v4(&self, raw: SynRawDataV4) {
+        self.latest_tick.fetch_max(raw.tick, Ordering::Relaxed);
+        let key = huginn_ebpf_common::make_key_v4(raw.src_addr, raw.src_port);
+        self.v4.insert(key, raw, raw.tick);
+    }
+
+    pub fn insert_v6(&self, raw: SynRawDataV6) {
+        self.latest_tick.fetch_max(raw.tick, Ordering::Relaxed);
+        let key = huginn_ebpf_common::make_key_v6(raw.src_addr, raw.src_port);
+        self.v6.insert(key, raw, raw.tick);
+    }
+
+    /// Remove and return the SYN captured for an IPv4 client, unless missing or stale.
+    ///
+    /// A connection's SYN is looked up once, at accept, so the record is not kept afterwards.
+    pub fn take_v4(&self, src_ip: Ipv4Addr, src_port: u16) -> Option<SynRawDataV4> {
+        let raw = self.v4.take(&make_bpf_key_v4(src_ip, src_port))?;
+        self.fresh(raw.tick).then_some(raw)
+    }
+
+    /// Remove and return the SYN captured for an IPv6 client, unless missing or stale.
+    pub fn take_v6(&self, src_ip: Ipv6Addr, src_port: u16) -> Option<SynRawDataV6> {
+        let raw = self.v6.take(&make_bpf_key_v6(src_ip, src_port))?;
+        self.fresh(raw.tick).then_some(raw)
+    }
+
+    /// Records currently held, both families.
+    pub fn len(&self) -> usize {
+        self.v4.len().saturating_add(self.v6.len())
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    fn fresh(&self, tick: u64) -> bool {
+        let latest = self.latest_tick.load(Ordering::Relaxed);
+        !is_stale(tick, latest, self.syn_map_max_entries)
+    }
+}
+
+/// One family's records, split across [`SHARDS`] mutexes so the ring consumer and concurrent
+/// accepts rarely contend.
+struct Shards<K, V> {
+    shards: [Mutex<Shard<K, V>>; SHARDS],
+    hasher: RandomState,
+    per_shard: usize,
+}
+
+struct Shard<K, V> {
+    entries: HashMap<K, V>,
+    /// Insertion order as `(key, tick)`. A re-inserted key leaves its older pair behind;
+    /// evicting that pair only removes the entry if it still carries the same tick.
+    order: VecDeque<(K, u64)>,
+}
+
+impl<K: Copy + Eq + Hash, V: Copy + Tick> Shards<K, V> {
+    fn new(capacity: usize) -> Self {
+        let per_shard = capacity.div_ceil(SHARDS).max(1);
+        let shards = std::array::from_fn(|_| {
+            Mutex::new(Shard {
+                entries: HashMap::with_capacity(per_shard),
+                order: VecDeque::with_capacity(per_shard),
+            })
+        });
+        Self { shards, hasher: RandomState::new(), per_shard }
+    }
+
+    fn shard(&self, key: &K) -> &Mutex<Shard<K, V>> {
+        // Masked to SHARDS - 1, so always in range.
+        let index = usize::try_from(self.hasher.hash_one(key) & SHARD_MASK).unwrap_or(0);
+        &self.shards[index]
+    }
+
+    fn insert(&self, key: K, value: V, tick: u64) {
+        let mut shard = self.shard(&key).lock().unwrap_or_else(|e| e.into_inner());
+        shard.entries.insert(key, value);
+        shard.order.push_back((key, tick));
+        while shard.order.len() > self.per_shard {
+            let Some((old_key, old_tick)) = shard.order.pop_front() else {
+                break;
+            };
+            if shard
+                .entries
+                .get(&old_key)
+                .is_some_and(|v| v.tick() == old_tick)
+            {
+                shard.entries.remove(&old_key);
+            }
+        }
+    }
+
+    fn take(&self, key: &K) -> Option<V> {
+        let mut shard = self.shard(key).lock().unwrap_or_else(|e| e.into_inner());
+        shard.entries.remove(key)
+    }
+
+    fn len(&self) -> usize {
+        self.shards
+            .iter()
+            .map(|shard| {
+                shard
+                    .lock()
+                    .unwrap_or_else(|e| e.into_inner())
+                    .entries
+                    .len()
+            })
+            .fold(0, usize::saturating_add)
+    }
+}
+
+trait Tick {
+    fn tick(&self) -> u64;
+}
+
+impl Tick for SynRawDataV4 {
+    fn tick(&self) -> u64 {
+        self.tick
+    }
+}
+
+impl Tick for SynRawDataV6 {
+    fn tick(&self) -> u64 {
+        self.tick
+    }
+}
@@ -1,4 +1,4 @@
-//! Capture backend and XDP attach mode configuration.
+//! Capture backend, XDP attach mode and SYN enforcement configuration.
 
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
 pub enum XdpAttachMode {
@@ -27,3 +27,36 @@ impl CaptureBackend {
         }
     }
 }
+
+/// Per-source SYN rate limit enforced by the capture program.
+///
+/// Each source address gets a token bucket of `burst` SYNs refilled at `per_second`; SYNs from an
+/// empty bucket are dropped in the kernel. Buckets are kept per CPU, so the limit applies per
+/// receive queue.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct SynRateLimit {
+    pub per_second: u32,
+    pub burst: u32,
+}
+
+/// How the proxy reads the global SYN tick used for staleness checks on a SYN map hit.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum LookupMode {
+    /// Read the tick map on every hit (one extra `bpf()` syscall per fingerprinted accept).
+    #[default]
+    Direct,
+    /// Reuse one tick read for every hit within the window, so a burst of accepts shares a single
+    /// tick syscall. The tick can lag by at most the SYNs that arrive during one window, a small
+    /// fraction of the `2 x syn_map_max_entries` staleness threshold for sub-millisecond windows.
+    Coalesced(std::time::Duration),
+}
+
+impl LookupMode {
+    /// `mode` metric label (e.g. `huginn_tcp_syn_fingerprint_duration_seconds{mode}`).
+    pub fn as_str(self) -> &'static str {
+        match self {
+            LookupMode::Direct => "direct",
+            LookupMode::Coalesced(_) => "coalesced",
+        }
+    }
+}
@@ -36,6 +36,13 @@ pub enum EbpfError {
         source: aya::maps::MapError,
     },
 
+    #[error("failed to update BPF map '{name}': {source}")]
+    MapUpdate {
+        name: String,
+        #[source]
+        source: aya::maps::MapError,
+    },
+
     #[error("BPF map '{name}' not found in loaded object")]
     MapNotFound { name: String },
 
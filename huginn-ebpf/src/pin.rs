@@ -8,24 +8,40 @@ pub const SYN_META_NAME: &str = "syn_meta";
 pub const SYN_INSERT_FAILURES_V4_NAME: &str = "syn_insert_failures_v4";
 pub const SYN_CAPTURED_V4_NAME: &str = "syn_captured_v4";
 pub const SYN_MALFORMED_V4_NAME: &str = "syn_malformed_v4";
+pub const SYN_EVENTS_NAME: &str = "syn_events";
 
 pub const SYN_MAP_V6_NAME: &str = "tcp_syn_map_v6";
 pub const SYN_INSERT_FAILURES_V6_NAME: &str = "syn_insert_failures_v6";
 pub const SYN_CAPTURED_V6_NAME: &str = "syn_captured_v6";
 pub const SYN_MALFORMED_V6_NAME: &str = "syn_malformed_v6";
 
-/// Every map the agent pins and the proxy opens, in no particular order.
-pub const ALL_NAMES: [&str; 10] = [
+pub const SYN_DENY_V4_NAME: &str = "syn_deny_v4";
+pub const SYN_DENY_V6_NAME: &str = "syn_deny_v6";
+pub const SYN_DENIED_V4_NAME: &str = "syn_denied_v4";
+pub const SYN_DENIED_V6_NAME: &str = "syn_denied_v6";
+pub const SYN_RATE_LIMITED_V4_NAME: &str = "syn_rate_limited_v4";
+pub const SYN_RATE_LIMITED_V6_NAME: &str = "syn_rate_limited_v6";
+
+/// Every map the agent pins and the proxy opens, in no particular order. The per-source rate
+/// buckets (`syn_rate_v4`/`syn_rate_v6`) are agent-private and not pinned.
+pub const ALL_NAMES: [&str; 17] = [
     SYN_MAP_V4_NAME,
     SYN_MAP_V6_NAME,
     COUNTER_NAME,
     SYN_META_NAME,
+    SYN_EVENTS_NAME,
     SYN_INSERT_FAILURES_V4_NAME,
     SYN_CAPTURED_V4_NAME,
     SYN_MALFORMED_V4_NAME,
     SYN_INSERT_FAILURES_V6_NAME,
     SYN_CAPTURED_V6_NAME,
     SYN_MALFORMED_V6_NAME,
+    SYN_DENY_V4_NAME,
+    SYN_DENY_V6_NAME,
+    SYN_DENIED_V4_NAME,
+    SYN_DENIED_V6_NAME,
+    SYN_RATE_LIMITED_V4_NAME,
+    SYN_RATE_LIMITED_V6_NAME,
 ];
 
 pub fn syn_map_v4_path(base: &str) -> PathBuf {
@@ -40,6 +56,10 @@ pub fn syn_meta_path(base: &str) -> PathBuf {
     Path::new(base).join(SYN_META_NAME)
 }
 
+pub fn syn_events_path(base: &str) -> PathBuf {
+    Path::new(base).join(SYN_EVENTS_NAME)
+}
+
 pub fn insert_failures_v4_path(base: &str) -> PathBuf {
     Path::new(base).join(SYN_INSERT_FAILURES_V4_NAME)
 }
@@ -67,3 +87,27 @@ pub fn syn_captured_v6_path(base: &str) -> PathBuf {
 pub fn syn_malformed_v6_path(base: &str) -> PathBuf {
     Path::new(base).join(SYN_MALFORMED_V6_NAME)
 }
+
+pub fn syn_deny_v4_path(base: &str) -> PathBuf {
+    Path::new(base).join(SYN_DENY_V4_NAME)
+}
+
+pub fn syn_deny_v6_path(base: &str) -> PathBuf {
+    Path::new(base).join(SYN_DENY_V6_NAME)
+}
+
+pub fn syn_denied_v4_path(base: &str) -> PathBuf {
+    Path::new(base).join(SYN_DENIED_V4_NAME)
+}
+
+pub fn syn_denied_v6_path(base: &str) -> PathBuf {
+    Path::new(base).join(SYN_DENIED_V6_NAME)
+}
+
+pub fn syn_rate_limited_v4_path(base: &str) -> PathBuf {
+    Path::new(base).join(SYN_RATE_LIMITED_V4_NAME)
+}
+
+pub fn syn_rate_limited_v6_path(base: &str) -> PathBuf {
+    Path::new(base).join(SYN_RATE_LIMITED_V6_NAME)
+}
@@ -1,13 +1,72 @@
+use std::borrow::Borrow;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::time::{Duration, Instant};
+
 use aya::maps::{Array, Map, MapData, PerCpuArray};
 
 use crate::pin;
+use crate::LookupMode;
 
 /// Read slot 0 of a single-entry `Array<u64>` counter map (used for the global tick).
 pub(super) fn read_array_counter(map: &Map) -> Option<u64> {
     let array = Array::<_, u64>::try_from(map).ok()?;
+    read_array_slot(&array)
+}
+
+/// Read slot 0 of an already typed `Array<u64>` handle.
+pub(super) fn read_array_slot<T: Borrow<MapData>>(array: &Array<T, u64>) -> Option<u64> {
     array.get(&0, 0).ok()
 }
 
+/// Last global tick read, shared by the lookups of one probe under [`LookupMode::Coalesced`].
+pub(super) struct TickCache {
+    /// `None` = [`LookupMode::Direct`] (never cached).
+    window: Option<Duration>,
+    epoch: Instant,
+    tick: AtomicU64,
+    /// Nanoseconds since `epoch` at which `tick` was read, plus one; 0 = never read.
+    read_at: AtomicU64,
+}
+
+impl TickCache {
+    pub(super) fn new(mode: LookupMode) -> Self {
+        let window = match mode {
+            LookupMode::Direct => None,
+            LookupMode::Coalesced(window) => Some(window),
+        };
+        Self {
+            window,
+            epoch: Instant::now(),
+            tick: AtomicU64::new(0),
+            read_at: AtomicU64::new(0),
+        }
+    }
+
+    /// The current tick: the cached value while it is younger than the window, otherwise
+    /// `read()`, which then refreshes the cache.
+    pub(super) fn get(&self, read: impl FnOnce() -> Option<u64>) -> Option<u64> {
+        let Some(window) = self.window else {
+            return read();
+        };
+        let now = self.now_nanos();
+        let read_at = self.read_at.load(Ordering::Acquire);
+        let window = u64::try_from(window.as_nanos()).unwrap_or(u64::MAX);
+        if read_at != 0 && now.saturating_sub(read_at) < window {
+            return Some(self.tick.load(Ordering::Relaxed));
+        }
+        let tick = read()?;
+        // A racing refresh may interleave; either tick was read within the window.
+        self.tick.store(tick, Ordering::Relaxed);
+        self.read_at.store(now, Ordering::Release);
+        Some(tick)
+    }
+
+    fn now_nanos(&self) -> u64 {
+        let elapsed = u64::try_from(self.epoch.elapsed().as_nanos()).unwrap_or(u64::MAX);
+        elapsed.saturating_add(1)
+    }
+}
+
 /// Read slot 0 of a single-entry `PerCpuArray<u64>` counter map, summing the per-CPU values.
 ///
 /// The kernel increments a per-CPU slot (race-free); the meaningful total is the sum across CPUs.
@@ -55,3 +114,19 @@ pub fn syn_captured_v6_count_from_path(base_path: &str) -> Option<u64> {
 pub fn syn_malformed_v6_count_from_path(base_path: &str) -> Option<u64> {
     read_percpu_counter_from_path(pin::syn_malformed_v6_path(base_path))
 }
+
+pub fn syn_denied_count_from_path(base_path: &str) -> Option<u64> {
+    read_percpu_counter_from_path(pin::syn_denied_v4_path(base_path))
+}
+
+pub fn syn_denied_v6_count_from_path(base_path: &str) -> Option<u64> {
+    read_percpu_counter_from_path(pin::syn_denied_v6_path(base_path))
+}
+
+pub fn syn_rate_limited_count_from_path(base_path: &str) -> Option<u64> {
+    read_percpu_counter_from_path(pin::syn_rate_limited_v4_path(base_path))
+}
+
+pub fn syn_rate_limited_v6_count_from_path(base_path: &str) -> Option<u64> {
+    read_percpu_counter_from_path(pin::syn_rate_limited_v6_path(base_path))
+}
@@ -0,0 +1,122 @@
+use std::collections::HashSet;
+use std::hash::Hash;
+use std::net::{Ipv4Addr, Ipv6Addr};
+
+use aya::maps::lpm_trie::{Key, LpmTrie};
+use aya::maps::{Map, MapData};
+use aya::Pod;
+
+use crate::pin;
+use crate::EbpfError;
+
+use super::keys::{deny_key_v4, deny_key_v6};
+use super::{maps, PinnedMapIds};
+
+/// Writer for the agent's pinned `syn_deny_v4`/`syn_deny_v6` LPM tries: the capture program drops
+/// SYNs from any source they contain, before the kernel allocates connection state.
+///
+/// Used by the proxy to mirror its global `[security.ip_filter]` denylist into the kernel. The
+/// tries survive agent restarts like the other pins; when the agent recreates them they come back
+/// empty, which callers detect through [`map_ids`](Self::map_ids).
+pub struct SynDenylist {
+    v4: LpmTrie<MapData, [u8; 4], u8>,
+    v6: LpmTrie<MapData, [u8; 16], u8>,
+    ids: PinnedMapIds,
+}
+
+/// Prefixes changed by one [`SynDenylist::replace`].
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct DenylistUpdate {
+    pub added: usize,
+    pub removed: usize,
+    /// Prefixes in the tries afterwards, both families.
+    pub entries: usize,
+}
+
+impl SynDenylist {
+    /// Open the denylist tries pinned under `base_path` by the agent.
+    pub fn from_pinned(base_path: &str) -> Result<Self, EbpfError> {
+        let path_v4 = pin::syn_deny_v4_path(base_path);
+        let path_v6 = pin::syn_deny_v6_path(base_path);
+        let data_v4 = maps::open_pinned_map(path_v4.clone())?;
+        let data_v6 = maps::open_pinned_map(path_v6.clone())?;
+        let ids = PinnedMapIds {
+            ipv4: maps::open_map_id(&data_v4, path_v4)?,
+            ipv6: maps::open_map_id(&data_v6, path_v6)?,
+        };
+        Ok(Self {
+            v4: maps::typed_map(Map::LpmTrie(data_v4), pin::SYN_DENY_V4_NAME)?,
+            v6: maps::typed_map(Map::LpmTrie(data_v6), pin::SYN_DENY_V6_NAME)?,
+            ids,
+        })
+    }
+
+    /// Kernel identities of the tries currently published at `base_path`.
+    pub fn map_ids_from_path(base_path: &str) -> Result<PinnedMapIds, EbpfError> {
+        Ok(PinnedMapIds {
+            ipv4: maps::pinned_map_id(pin::syn_deny_v4_path(base_path))?,
+            ipv6: maps::pinned_map_id(pin::syn_deny_v6_path(base_path))?,
+        })
+    }
+
+    /// Kernel identities of the tries this writer opened.
+    pub fn map_ids(&self) -> PinnedMapIds {
+        self.ids
+    }
+
+    /// Make the tries hold exactly the given prefixes. Only the difference is written, new
+    /// prefixes before stale ones are removed, so unchanged sources stay blocked throughout.
+    ///
+    /// A failed write (e.g. a full trie) stops the update and leaves the tries partly updated; a
+    /// later call with the same input completes it.
+    pub fn replace(
+        &mut self,
+        v4: &[(Ipv4Addr, u8)],
+        v6: &[(Ipv6Addr, u8)],
+    ) -> Result<DenylistUpdate, EbpfError> {
+        let wanted_v4 = v4
+            .iter()
+            .map(|&(addr, len)| deny_key_v4(addr, len))
+            .collect();
+        let wanted_v6 = v6
+            .iter()
+            .map(|&(addr, len)| deny_key_v6(addr, len))
+            .collect();
+        let a = sync_trie(&mut self.v4, wanted_v4, pin::SYN_DENY_V4_NAME)?;
+        let b = sync_trie(&mut self.v6, wanted_v6, pin::SYN_DENY_V6_NAME)?;
+        Ok(DenylistUpdate {
+            added: a.added.saturating_add(b.added),
+            removed: a.removed.saturating_add(b.removed),
+            entries: a.entries.saturating_add(b.entries),
+        })
+    }
+}
+
+fn sync_trie<K>(
+    trie: &mut LpmTrie<MapData, K, u8>,
+    wanted: HashSet<(u32, K)>,
+    name: &str,
+) -> Result<DenylistUpdate, EbpfError>
+where
+    K: Pod + Eq + Hash,
+{
+    let update_err = |source| EbpfError::MapUpdate { name: name.to_string(), source };
+    let present = trie
+        .keys()
+        .map(|key| key.map(|key| (key.prefix_len(), key.data())))
+        .collect::<Result<HashSet<_>, _>>()
+        .map_err(update_err)?;
+
+    let mut update = DenylistUpdate { entries: wanted.len(), ..DenylistUpdate::default() };
+    for &(prefix_len, data) in wanted.difference(&present) {
+        trie.insert(&Key::new(prefix_len, data), 1, 0)
+            .map_err(update_err)?;
+        update.added = update.added.saturating_add(1);
+    }
+    for &(prefix_len, data) in present.difference(&wanted) {
+        trie.remove(&Key::new(prefix_len, data))
+            .map_err(update_err)?;
+        update.removed = update.removed.saturating_add(1);
+    }
+    Ok(update)
+}
@@ -0,0 +1,51 @@
+use std::os::fd::{AsFd, AsRawFd, BorrowedFd, RawFd};
+
+use aya::maps::{Map, MapData, RingBuf};
+
+use crate::cache::SynCache;
+use crate::pin;
+use crate::EbpfError;
+
+use super::maps;
+
+/// Consumer of the agent's pinned `syn_events` ring buffer, the push alternative to looking up
+/// the SYN LRU maps per connection.
+///
+/// The kernel keeps a single consumer position per ring, shared by every process that opens the
+/// pin, so exactly one reader per pin directory should drain it. Register the fd with an async
+/// reactor (e.g. `tokio::io::unix::AsyncFd`) and call [`drain`](Self::drain) on readability.
+pub struct SynEventReader {
+    ring: RingBuf<MapData>,
+}
+
+impl SynEventReader {
+    /// Open the `syn_events` ring pinned under `base_path` by the agent.
+    pub fn from_pinned(base_path: &str) -> Result<Self, EbpfError> {
+        let data = maps::open_pinned_map(pin::syn_events_path(base_path))?;
+        let ring = maps::typed_map(Map::RingBuf(data), pin::SYN_EVENTS_NAME)?;
+        Ok(Self { ring })
+    }
+
+    /// Move every pending sample into `cache`. Returns the number of samples consumed,
+    /// undecodable ones included.
+    pub fn drain(&mut self, cache: &SynCache) -> usize {
+        let mut consumed: usize = 0;
+        while let Some(sample) = self.ring.next() {
+            cache.insert_sample(&sample);
+            consumed = consumed.saturating_add(1);
+        }
+        consumed
+    }
+}
+
+impl AsFd for SynEventReader {
+    fn as_fd(&self) -> BorrowedFd<'_> {
+        self.ring.as_fd()
+    }
+}
+
+impl AsRawFd for SynEventReader {
+    fn as_raw_fd(&self) -> RawFd {
+        self.ring.as_fd().as_raw_fd()
+    }
+}
@@ -18,3 +18,22 @@ pub fn make_bpf_key_v6(src_ip: Ipv6Addr, src_port: u16) -> [u8; 18] {
     key[17] = port_be[1];
     key
 }
+
+/// `syn_deny_v4` LPM key for `addr/prefix_len`: the prefix length (clamped to 32) and the network
+/// address in wire byte order, with the host bits cleared so equal prefixes share one key.
+pub fn deny_key_v4(addr: Ipv4Addr, prefix_len: u8) -> (u32, [u8; 4]) {
+    let prefix_len = u32::from(prefix_len.min(32));
+    let mask = u32::MAX
+        .checked_shl(32u32.saturating_sub(prefix_len))
+        .unwrap_or(0);
+    (prefix_len, (u32::from(addr) & mask).to_be_bytes())
+}
+
+/// `syn_deny_v6` LPM key for `addr/prefix_len`; see [`deny_key_v4`].
+pub fn deny_key_v6(addr: Ipv6Addr, prefix_len: u8) -> (u32, [u8; 16]) {
+    let prefix_len = u32::from(prefix_len.min(128));
+    let mask = u128::MAX
+        .checked_shl(128u32.saturating_sub(prefix_len))
+        .unwrap_or(0);
+    (prefix_len, (u128::from(addr) & mask).to_be_bytes())
+}
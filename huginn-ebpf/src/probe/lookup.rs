@@ -1,6 +1,5 @@
 use std::net::{Ipv4Addr, Ipv6Addr};
 
-use aya::maps::HashMap;
 use tracing::{debug, warn};
 
 use crate::types::{SynRawDataV4, SynRawDataV6};
@@ -17,13 +16,10 @@ impl EbpfProbe {
     /// - the SYN was not captured (program just started, map entry evicted), or
     /// - the entry is stale (more than 2x `syn_map_max_entries` SYNs have arrived since capture).
     pub fn lookup_v6(&self, src_ip: Ipv6Addr, src_port: u16) -> Option<SynRawDataV6> {
-        let syn_map = self.syn_map_v6()?;
-        let map = HashMap::<_, [u8; 18], SynRawDataV6>::try_from(syn_map).ok()?;
-
         let key = make_bpf_key_v6(src_ip, src_port);
-        let val = match map.get(&key, 0) {
-            Ok(v) => v,
-            Err(_) => {
+        let val = match self.get_syn_v6(&key) {
+            Some(v) => v,
+            None => {
                 debug!(?src_ip, src_port, "SYN v6 map miss - no entry");
                 return None;
             }
@@ -63,13 +59,10 @@ impl EbpfProbe {
     /// - the SYN was not captured (program just started, map entry evicted), or
     /// - the entry is stale (more than 2x `syn_map_max_entries` SYNs have arrived since capture).
     pub fn lookup(&self, src_ip: Ipv4Addr, src_port: u16) -> Option<SynRawDataV4> {
-        let syn_map = self.syn_map_v4()?;
-        let map = HashMap::<_, u64, SynRawDataV4>::try_from(syn_map).ok()?;
-
         let key = make_bpf_key_v4(src_ip, src_port);
-        let val = match map.get(&key, 0) {
-            Ok(v) => v,
-            Err(_) => {
+        let val = match self.get_syn_v4(&key) {
+            Some(v) => v,
+            None => {
                 debug!(?src_ip, src_port, "SYN map miss - no entry (keep-alive or not captured)");
                 return None;
             }
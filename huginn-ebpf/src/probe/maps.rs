@@ -84,6 +84,15 @@ pub(super) fn open_pinned_map(path: PathBuf) -> Result<MapData, EbpfError> {
         .map_err(|e| EbpfError::FromPin { path: path.display().to_string(), source: e })
 }
 
+/// Convert an opened map into its typed handle once, mapping a type mismatch to
+/// [`EbpfError::FromPin`].
+pub(super) fn typed_map<T>(map: Map, name: &str) -> Result<T, EbpfError>
+where
+    T: TryFrom<Map, Error = aya::maps::MapError>,
+{
+    T::try_from(map).map_err(|source| EbpfError::FromPin { path: name.to_string(), source })
+}
+
 /// Return the kernel ID of the BPF map currently pinned at `path`.
 pub(super) fn pinned_map_id(path: PathBuf) -> Result<u32, EbpfError> {
     MapInfo::from_pin(&path)
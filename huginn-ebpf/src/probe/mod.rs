@@ -2,29 +2,39 @@ use std::net::{Ipv4Addr, Ipv6Addr};
 use std::os::fd::{AsFd, AsRawFd, BorrowedFd, RawFd};
 use std::path::{Path, PathBuf};
 
-use aya::maps::Map;
+use aya::maps::{Array, HashMap, Map, MapData};
 use aya::{Ebpf, EbpfLoader};
 use aya_log::EbpfLogger;
+use huginn_ebpf_common::syn_guard::rate_limit_ns;
 use log::Log;
 use tracing::info;
 
 use crate::pin;
+use crate::types::{SynRawDataV4, SynRawDataV6};
 use crate::CaptureBackend;
 use crate::EbpfError;
 use crate::EbpfLogLevel;
+use crate::LookupMode;
+use crate::SynRateLimit;
 
 mod attach;
 mod counters;
+mod denylist;
+mod events;
 mod keys;
 mod lookup;
 mod maps;
 
 pub use counters::{
     is_stale, syn_captured_count_from_path, syn_captured_v6_count_from_path,
-    syn_insert_failures_count_from_path, syn_insert_failures_v6_count_from_path,
-    syn_malformed_count_from_path, syn_malformed_v6_count_from_path,
+    syn_denied_count_from_path, syn_denied_v6_count_from_path, syn_insert_failures_count_from_path,
+    syn_insert_failures_v6_count_from_path, syn_malformed_count_from_path,
+    syn_malformed_v6_count_from_path, syn_rate_limited_count_from_path,
+    syn_rate_limited_v6_count_from_path,
 };
-pub use keys::{make_bpf_key_v4, make_bpf_key_v6};
+pub use denylist::{DenylistUpdate, SynDenylist};
+pub use events::SynEventReader;
+pub use keys::{deny_key_v4, deny_key_v6, make_bpf_key_v4, make_bpf_key_v6};
 
 /// Raw bytes of the compiled BPF object (XDP + TC programs), embedded at compile time.
 /// `include_bytes_aligned!` ensures 8-byte alignment required by aya's ELF parser.
@@ -44,15 +54,18 @@ enum ProbeInner {
 }
 
 /// Maps opened from the agent's pins for the proxy side.
+///
+/// The SYN maps and the tick are held as typed handles, converted once here rather than on every
+/// lookup.
 struct PinnedMaps {
-    ipv4: PinnedFamilyMaps,
-    ipv6: PinnedFamilyMaps,
-    counter: Map,
+    ipv4: PinnedFamilyMaps<u64, SynRawDataV4>,
+    ipv6: PinnedFamilyMaps<[u8; 18], SynRawDataV6>,
+    counter: Array<MapData, u64>,
 }
 
 /// Pinned SYN data and telemetry maps belonging to one IP family.
-struct PinnedFamilyMaps {
-    syn: Map,
+struct PinnedFamilyMaps<K, V> {
+    syn: HashMap<MapData, K, V>,
     id: u32,
     insert_failures: Map,
     captured: Map,
@@ -72,6 +85,8 @@ pub struct EbpfProbe {
     interface: String,
     syn_map_max_entries: u32,
     log_level: EbpfLogLevel,
+    /// Tick reads shared between lookups (see [`LookupMode`]).
+    tick: counters::TickCache,
 }
 
 /// Ring-buffer drain handle for `aya-log`. Caller must poll the fd and call [`flush`](Self::flush).
@@ -117,6 +132,10 @@ impl EbpfProbe {
     ///   When non-off, drain the records via [`take_debug_log_poller`](Self::take_debug_log_poller).
     /// - `pin_base`: bpffs directory where maps are pinned (e.g. `/sys/fs/bpf/huginn`). Reuses
     ///   existing pins on restart; drops them first when `syn_map_max_entries` changed.
+    /// - `syn_rate_limit`: per-source SYN token bucket enforced by the attached program; SYNs over
+    ///   the rate are dropped. `None` disables it. The source denylist needs no setting here: it is
+    ///   enforced whenever the proxy filled the pinned `syn_deny_v4`/`syn_deny_v6` tries (see
+    ///   [`SynDenylist`]).
     #[allow(clippy::too_many_arguments)]
     pub fn new(
         interface: &str,
@@ -127,6 +146,7 @@ impl EbpfProbe {
         capture: CaptureBackend,
         log_level: EbpfLogLevel,
         pin_base: &str,
+        syn_rate_limit: Option<SynRateLimit>,
     ) -> Result<Self, EbpfError> {
         // The BPF program compares ip->daddr and tcp->dest (both network-byte-order fields)
         // against these globals. On a little-endian CPU, network-order bytes [a,b,c,d] in the
@@ -149,6 +169,10 @@ impl EbpfProbe {
         // 0 = logging off (default); higher = more verbose (log::LevelFilter encoding).
         let bpf_log_level: u8 = log_level.as_u8();
 
+        // (0, 0) = rate limiting off; the program never touches its bucket maps.
+        let (bpf_rate_cost_ns, bpf_rate_burst_ns) =
+            syn_rate_limit.map_or((0, 0), |limit| rate_limit_ns(limit.per_second, limit.burst));
+
         // Create the pin directory and drop any pins left over from an
         // incompatible capacity before the loader touches them.
         maps::prepare_pins(pin_base, syn_map_max_entries)?;
@@ -166,6 +190,8 @@ impl EbpfProbe {
             .override_global("dst_ip_v6", &bpf_dst_ip_v6, false)
             .override_global("dst_port", &bpf_dst_port, false)
             .override_global("log_level", &bpf_log_level, false)
+            .override_global("syn_rate_cost_ns", &bpf_rate_cost_ns, false)
+            .override_global("syn_rate_burst_ns", &bpf_rate_burst_ns, false)
             .map_max_entries(pin::SYN_MAP_V4_NAME, syn_map_max_entries)
             .map_max_entries(pin::SYN_MAP_V6_NAME, syn_map_max_entries);
         for (name, path) in &pin_paths {
@@ -201,6 +227,8 @@ impl EbpfProbe {
             filter_ip_v6,
             dst_port,
             mode = mode_str,
+            syn_rate_limit = syn_rate_limit.map_or(0, |limit| limit.per_second),
+            syn_rate_burst = syn_rate_limit.map_or(0, |limit| limit.burst),
             "eBPF TCP SYN fingerprinting attached"
         );
 
@@ -209,6 +237,7 @@ impl EbpfProbe {
             interface: interface.to_string(),
             syn_map_max_entries,
             log_level,
+            tick: counters::TickCache::new(LookupMode::Direct),
         })
     }
 
@@ -236,7 +265,10 @@ impl EbpfProbe {
             0 => return Err(EbpfError::MapNotReady { name: pin::SYN_META_NAME.to_string() }),
             capacity => capacity,
         };
+        let syn_v4 = maps::typed_map(Map::LruHashMap(syn_data_v4), pin::SYN_MAP_V4_NAME)?;
+        let syn_v6 = maps::typed_map(Map::LruHashMap(syn_data_v6), pin::SYN_MAP_V6_NAME)?;
         let counter_data = maps::open_pinned_map(pin::counter_path(base_path))?;
+        let counter = maps::typed_map(Map::Array(counter_data), pin::COUNTER_NAME)?;
         let insert_failures_v4 = maps::open_pinned_map(pin::insert_failures_v4_path(base_path))?;
         let insert_failures_v6 = maps::open_pinned_map(pin::insert_failures_v6_path(base_path))?;
         let captured_v4 = maps::open_pinned_map(pin::syn_captured_v4_path(base_path))?;
@@ -249,27 +281,34 @@ impl EbpfProbe {
         Ok(Self {
             inner: ProbeInner::Pinned(Box::new(PinnedMaps {
                 ipv4: PinnedFamilyMaps {
-                    syn: Map::LruHashMap(syn_data_v4),
+                    syn: syn_v4,
                     id: syn_id_v4,
                     insert_failures: Map::PerCpuArray(insert_failures_v4),
                     captured: Map::PerCpuArray(captured_v4),
                     malformed: Map::PerCpuArray(malformed_v4),
                 },
                 ipv6: PinnedFamilyMaps {
-                    syn: Map::LruHashMap(syn_data_v6),
+                    syn: syn_v6,
                     id: syn_id_v6,
                     insert_failures: Map::PerCpuArray(insert_failures_v6),
                     captured: Map::PerCpuArray(captured_v6),
                     malformed: Map::PerCpuArray(malformed_v6),
                 },
-                counter: Map::Array(counter_data),
+                counter,
             })),
             interface: String::new(),
             syn_map_max_entries,
             log_level: EbpfLogLevel::Off,
+            tick: counters::TickCache::new(LookupMode::Direct),
         })
     }
 
+    /// Set how lookups read the SYN tick for staleness checks (default [`LookupMode::Direct`]).
+    pub fn with_lookup_mode(mut self, mode: LookupMode) -> Self {
+        self.tick = counters::TickCache::new(mode);
+        self
+    }
+
     /// Read the kernel identities currently published at the IPv4 and IPv6 pin paths.
     pub fn pinned_map_ids_from_path(base_path: &str) -> Result<PinnedMapIds, EbpfError> {
         Ok(PinnedMapIds {
@@ -307,29 +346,39 @@ impl EbpfProbe {
         }
     }
 
-    fn syn_map_v4(&self) -> Option<&Map> {
-        match &self.inner {
-            ProbeInner::Embedded { ebpf } => ebpf.map(pin::SYN_MAP_V4_NAME),
-            ProbeInner::Pinned(p) => Some(&p.ipv4.syn),
-        }
-    }
-
-    fn syn_map_v6(&self) -> Option<&Map> {
+    /// Exact-match lookup in the IPv4 SYN map. `None` on a miss or an unavailable map.
+    fn get_syn_v4(&self, key: &u64) -> Option<SynRawDataV4> {
         match &self.inner {
-            ProbeInner::Embedded { ebpf } => ebpf.map(pin::SYN_MAP_V6_NAME),
-            ProbeInner::Pinned(p) => Some(&p.ipv6.syn),
+            ProbeInner::Embedded { ebpf } => {
+                let map =
+                    HashMap::<_, u64, SynRawDataV4>::try_from(ebpf.map(pin::SYN_MAP_V4_NAME)?)
+                        .ok()?;
+                map.get(key, 0).ok()
+            }
+            ProbeInner::Pinned(p) => p.ipv4.syn.get(key, 0).ok(),
         }
     }
 
-    fn counter_map(&self) -> Option<&Map> {
+    /// Exact-match lookup in the IPv6 SYN map. `None` on a miss or an unavailable map.
+    fn get_syn_v6(&self, key: &[u8; 18]) -> Option<SynRawDataV6> {
         match &self.inner {
-            ProbeInner::Embedded { ebpf } => ebpf.map(pin::COUNTER_NAME),
-            ProbeInner::Pinned(p) => Some(&p.counter),
+            ProbeInner::Embedded { ebpf } => {
+                let map =
+                    HashMap::<_, [u8; 18], SynRawDataV6>::try_from(ebpf.map(pin::SYN_MAP_V6_NAME)?)
+                        .ok()?;
+                map.get(key, 0).ok()
+            }
+            ProbeInner::Pinned(p) => p.ipv6.syn.get(key, 0).ok(),
         }
     }
 
     fn read_current_tick(&self) -> Option<u64> {
-        counters::read_array_counter(self.counter_map()?)
+        self.tick.get(|| match &self.inner {
+            ProbeInner::Embedded { ebpf } => {
+                counters::read_array_counter(ebpf.map(pin::COUNTER_NAME)?)
+            }
+            ProbeInner::Pinned(p) => counters::read_array_slot(&p.counter),
+        })
     }
 
     fn counter_from(&self, name: &str, pick: impl Fn(&PinnedMaps) -> &Map) -> Option<u64> {
@@ -371,6 +420,11 @@ impl EbpfProbe {
         self.counter_from(pin::SYN_MALFORMED_V6_NAME, |p| &p.ipv6.malformed)
     }
 
+    /// LRU capacity the staleness threshold is derived from (see [`is_stale`]).
+    pub fn syn_map_max_entries(&self) -> u32 {
+        self.syn_map_max_entries
+    }
+
     pub fn interface(&self) -> &str {
         &self.interface
     }
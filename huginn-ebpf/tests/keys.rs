@@ -4,7 +4,7 @@
 
 use std::net::{Ipv4Addr, Ipv6Addr};
 
-use huginn_ebpf::probe::{make_bpf_key_v4, make_bpf_key_v6};
+use huginn_ebpf::probe::{deny_key_v4, deny_key_v6, make_bpf_key_v4, make_bpf_key_v6};
 use huginn_ebpf_common::{make_key_v4, make_key_v6};
 
 /// make_bpf_key must produce the same u64 as common::make_key for the same (ip, port)
@@ -137,3 +137,25 @@ fn test_make_bpf_key_v6_port_in_network_order() {
     assert_eq!(key[16], 0x12);
     assert_eq!(key[17], 0x34);
 }
+
+/// Denylist keys carry the prefix length and the network address in wire order, with host bits
+/// cleared, so the trie holds one entry per distinct prefix.
+#[test]
+fn test_deny_keys_mask_host_bits() {
+    assert_eq!(deny_key_v4(Ipv4Addr::new(10, 1, 2, 3), 8), (8, [10, 0, 0, 0]));
+    assert_eq!(deny_key_v4(Ipv4Addr::new(192, 0, 2, 7), 32), (32, [192, 0, 2, 7]));
+    assert_eq!(deny_key_v4(Ipv4Addr::new(192, 0, 2, 7), 0), (0, [0; 4]));
+    assert_eq!(deny_key_v4(Ipv4Addr::new(192, 0, 2, 7), 40), (32, [192, 0, 2, 7]));
+
+    let (len, data) = deny_key_v6(Ipv6Addr::new(0x2001, 0x0db8, 0xffff, 0, 0, 0, 0, 1), 32);
+    assert_eq!(len, 32);
+    assert_eq!(Ipv6Addr::from(data), Ipv6Addr::new(0x2001, 0x0db8, 0, 0, 0, 0, 0, 0));
+}
+
+/// The kernel looks up `ip->saddr.to_ne_bytes()`: a denylisted /32 must produce those bytes.
+#[test]
+fn test_deny_key_v4_matches_kernel_saddr_bytes() {
+    let ip = Ipv4Addr::new(203, 0, 113, 9);
+    let saddr = u32::from_ne_bytes(ip.octets());
+    assert_eq!(deny_key_v4(ip, 32).1, saddr.to_ne_bytes());
+}
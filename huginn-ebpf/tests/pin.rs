@@ -49,6 +49,17 @@ fn test_syn_malformed_path_ends_with_map_name() {
     );
 }
 
+#[test]
+fn test_syn_events_path_ends_with_map_name() {
+    let path = pin::syn_events_path("/sys/fs/bpf/huginn");
+    assert_eq!(path.file_name().and_then(|p| p.to_str()), Some(pin::SYN_EVENTS_NAME));
+}
+
+#[test]
+fn test_syn_events_is_pinned_by_the_agent() {
+    assert!(pin::ALL_NAMES.contains(&pin::SYN_EVENTS_NAME));
+}
+
 #[test]
 fn test_constant_names_match_expected() {
     assert_eq!(pin::SYN_MAP_V4_NAME, "tcp_syn_map_v4");
@@ -56,6 +67,7 @@ fn test_constant_names_match_expected() {
     assert_eq!(pin::SYN_INSERT_FAILURES_V4_NAME, "syn_insert_failures_v4");
     assert_eq!(pin::SYN_CAPTURED_V4_NAME, "syn_captured_v4");
     assert_eq!(pin::SYN_MALFORMED_V4_NAME, "syn_malformed_v4");
+    assert_eq!(pin::SYN_EVENTS_NAME, "syn_events");
 }
 
 #[test]
@@ -124,3 +136,24 @@ fn test_all_v6_paths_start_with_base() {
     assert!(pin::syn_captured_v6_path(base).starts_with(Path::new(base)));
     assert!(pin::syn_malformed_v6_path(base).starts_with(Path::new(base)));
 }
+
+// ── SYN enforcement ───────────────────────────────────────────────────────────
+
+#[test]
+fn test_syn_enforcement_maps_are_pinned() {
+    for name in [
+        pin::SYN_DENY_V4_NAME,
+        pin::SYN_DENY_V6_NAME,
+        pin::SYN_DENIED_V4_NAME,
+        pin::SYN_DENIED_V6_NAME,
+        pin::SYN_RATE_LIMITED_V4_NAME,
+        pin::SYN_RATE_LIMITED_V6_NAME,
+    ] {
+        assert!(pin::ALL_NAMES.contains(&name), "{name} must be pinned by the agent");
+    }
+    let base = "/sys/fs/bpf/huginn";
+    assert!(pin::syn_deny_v4_path(base).ends_with(pin::SYN_DENY_V4_NAME));
+    assert!(pin::syn_deny_v6_path(base).ends_with(pin::SYN_DENY_V6_NAME));
+    assert!(pin::syn_denied_v4_path(base).ends_with(pin::SYN_DENIED_V4_NAME));
+    assert!(pin::syn_rate_limited_v6_path(base).ends_with(pin::SYN_RATE_LIMITED_V6_NAME));
+}
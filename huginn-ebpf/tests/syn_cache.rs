@@ -0,0 +1,103 @@
+use std::net::{Ipv4Addr, Ipv6Addr};
+
+use huginn_ebpf::{SynCache, SynRawDataV4, SynRawDataV6};
+
+type TestResult = Result<(), Box<dyn std::error::Error + Send + Sync>>;
+
+/// A record as the BPF program would capture it from `ip:port` at `tick`.
+fn syn_v4(ip: Ipv4Addr, port: u16, tick: u64) -> SynRawDataV4 {
+    SynRawDataV4 {
+        src_addr: u32::from_ne_bytes(ip.octets()),
+        src_port: port.to_be(),
+        ip_ttl: 64,
+        tick,
+        ..SynRawDataV4::default()
+    }
+}
+
+fn syn_v6(ip: Ipv6Addr, port: u16, tick: u64) -> SynRawDataV6 {
+    SynRawDataV6 { src_addr: ip.octets(), src_port: port.to_be(), tick, ..SynRawDataV6::default() }
+}
+
+#[test]
+fn hit_is_returned_once() -> TestResult {
+    let cache = SynCache::new(64);
+    let ip = Ipv4Addr::new(192, 0, 2, 10);
+    cache.insert_v4(syn_v4(ip, 40000, 1));
+
+    let raw = cache.take_v4(ip, 40000).ok_or("expected a hit")?;
+    assert_eq!(raw.ip_ttl, 64);
+    assert!(cache.take_v4(ip, 40000).is_none());
+    assert!(cache.is_empty());
+    Ok(())
+}
+
+#[test]
+fn lookup_is_keyed_by_address_and_port() {
+    let cache = SynCache::new(64);
+    let ip = Ipv4Addr::new(192, 0, 2, 10);
+    cache.insert_v4(syn_v4(ip, 40000, 1));
+
+    assert!(cache.take_v4(ip, 40001).is_none());
+    assert!(cache.take_v4(Ipv4Addr::new(192, 0, 2, 11), 40000).is_none());
+    assert!(cache.take_v6(Ipv6Addr::LOCALHOST, 40000).is_none());
+    assert_eq!(cache.len(), 1);
+}
+
+#[test]
+fn ipv6_hit() -> TestResult {
+    let cache = SynCache::new(64);
+    let ip: Ipv6Addr = "2001:db8::1".parse()?;
+    cache.insert_v6(syn_v6(ip, 8443, 3));
+
+    let raw = cache.take_v6(ip, 8443).ok_or("expected a hit")?;
+    assert_eq!(raw.tick, 3);
+    Ok(())
+}
+
+#[test]
+fn newer_capture_replaces_older_one() -> TestResult {
+    let cache = SynCache::new(64);
+    let ip = Ipv4Addr::new(198, 51, 100, 7);
+    cache.insert_v4(syn_v4(ip, 50000, 1));
+    cache.insert_v4(syn_v4(ip, 50000, 2));
+
+    assert_eq!(cache.take_v4(ip, 50000).ok_or("expected a hit")?.tick, 2);
+    assert!(cache.is_empty());
+    Ok(())
+}
+
+#[test]
+fn entry_older_than_threshold_is_stale() {
+    // syn_map_max_entries = 4 -> stale once more than 8 SYNs arrived since capture.
+    let cache = SynCache::new(4);
+    let old = Ipv4Addr::new(203, 0, 113, 1);
+    cache.insert_v4(syn_v4(old, 1000, 0));
+    cache.insert_v6(syn_v6(Ipv6Addr::LOCALHOST, 1000, 9));
+
+    assert!(cache.take_v4(old, 1000).is_none());
+}
+
+#[test]
+fn capacity_is_bounded() {
+    let cache = SynCache::new(16);
+    for port in 0..10_000u16 {
+        cache.insert_v4(syn_v4(Ipv4Addr::new(10, 0, 0, 1), port, u64::from(port)));
+    }
+    // 2 x syn_map_max_entries, rounded up per shard.
+    assert!(cache.len() <= 32);
+    assert!(cache.take_v4(Ipv4Addr::new(10, 0, 0, 1), 9_999).is_some());
+}
+
+#[test]
+fn samples_are_dispatched_by_length() {
+    let cache = SynCache::new(64);
+    let v4 = vec![0u8; std::mem::size_of::<SynRawDataV4>()];
+    let v6 = vec![0u8; std::mem::size_of::<SynRawDataV6>()];
+
+    assert!(cache.insert_sample(&v4));
+    assert!(cache.insert_sample(&v6));
+    assert!(!cache.insert_sample(&v4[1..]));
+    assert!(cache.take_v4(Ipv4Addr::UNSPECIFIED, 0).is_some());
+    assert!(cache.take_v6(Ipv6Addr::UNSPECIFIED, 0).is_some());
+}
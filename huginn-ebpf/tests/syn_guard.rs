@@ -0,0 +1,55 @@
+//! Per-source SYN token bucket shared with the BPF programs, and the loader parameters derived
+//! from the agent's rate limit.
+
+use huginn_ebpf_common::syn_guard::{rate_limit_ns, SynBucket};
+
+const SEC: u64 = 1_000_000_000;
+
+#[test]
+fn test_rate_limit_ns_derives_cost_and_burst() {
+    assert_eq!(rate_limit_ns(10, 5), (100_000_000, 500_000_000));
+    assert_eq!(rate_limit_ns(10, 0), (100_000_000, 100_000_000), "a zero burst is one SYN");
+    assert_eq!(rate_limit_ns(0, 5), (0, 0), "a zero rate turns the limit off");
+    assert_eq!(rate_limit_ns(u32::MAX, 1), (1, 1), "the cost never rounds down to off");
+}
+
+#[test]
+fn test_bucket_allows_burst_then_refills_at_rate() {
+    let (cost, burst) = rate_limit_ns(10, 3);
+    let start = SEC.saturating_mul(5);
+    let mut bucket = SynBucket::first(start, cost, burst);
+    assert!(bucket.take(start, cost, burst));
+    assert!(bucket.take(start, cost, burst));
+    assert!(!bucket.take(start, cost, burst), "the fourth SYN of a burst of 3 is dropped");
+
+    // One cost later a single SYN is admitted again, not two.
+    let later = start.saturating_add(cost);
+    assert!(bucket.take(later, cost, burst));
+    assert!(!bucket.take(later, cost, burst));
+}
+
+#[test]
+fn test_bucket_credit_is_capped_at_burst() {
+    let (cost, burst) = rate_limit_ns(100, 2);
+    let mut bucket = SynBucket::first(0, cost, burst);
+    let idle = SEC.saturating_mul(3600);
+    assert!(bucket.take(idle, cost, burst));
+    assert!(bucket.take(idle, cost, burst));
+    assert!(!bucket.take(idle, cost, burst), "an hour idle still only buys the burst");
+}
+
+#[test]
+fn test_zeroed_bucket_starts_full() {
+    // Other CPUs' slots of a per-CPU entry start zeroed: they must admit, not drop.
+    let (cost, burst) = rate_limit_ns(1, 1);
+    let mut bucket = SynBucket::default();
+    assert!(bucket.take(SEC, cost, burst));
+    assert!(!bucket.take(SEC, cost, burst));
+}
+
+#[test]
+fn test_clock_going_backwards_adds_no_credit() {
+    let (cost, burst) = rate_limit_ns(1, 1);
+    let mut bucket = SynBucket::first(SEC.saturating_mul(10), cost, burst);
+    assert!(!bucket.take(SEC, cost, burst));
+}
@@ -23,7 +23,12 @@ impl HealthCheckHttpClient {
         connector
             .set_connect_timeout(Some(Duration::from_secs(connect_timeout_secs.clamp(1, 300))));
 
-        let pool = BackendPoolConfig { enabled: true, idle_timeout: 60, pool_max_idle_per_host: 1 };
+        let pool = BackendPoolConfig {
+            enabled: true,
+            idle_timeout: 60,
+            pool_max_idle_per_host: 1,
+            prewarm: None,
+        };
         let mut builder = Client::builder(TokioExecutor::new());
         builder.pool_idle_timeout(Duration::from_secs(pool.idle_timeout));
         builder.pool_max_idle_per_host(pool.pool_max_idle_per_host);
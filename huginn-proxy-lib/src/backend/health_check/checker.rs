@@ -8,7 +8,8 @@ use super::check_tcp::check_tcp;
 use super::counter::ConsecutiveCounter;
 use super::health::UpstreamHealth;
 use super::HealthRegistry;
-use crate::config::{Backend, HealthCheckConfig, HealthCheckType};
+use crate::backend::BackendSelector;
+use crate::config::{Backend, DynamicConfig, HealthCheckConfig, HealthCheckType};
 use crate::telemetry::Metrics;
 use tokio::runtime::Handle;
 use tokio::task::JoinHandle;
@@ -24,12 +25,24 @@ struct ActiveChecker {
 
 pub struct HealthCheckSupervisor {
     registry: Arc<HealthRegistry>,
+    /// Republished after every config reconcile so its pinned health handles track `registry`.
+    selector: Arc<BackendSelector>,
     active: Mutex<HashMap<String, ActiveChecker>>,
 }
 
 impl HealthCheckSupervisor {
     pub fn new(registry: Arc<HealthRegistry>) -> Self {
-        Self { registry, active: Mutex::new(HashMap::new()) }
+        Self::with_selector(registry, Arc::new(BackendSelector::new()))
+    }
+
+    /// Supervisor that republishes `selector` in [`Self::reconcile_config`].
+    pub fn with_selector(registry: Arc<HealthRegistry>, selector: Arc<BackendSelector>) -> Self {
+        Self { registry, selector, active: Mutex::new(HashMap::new()) }
+    }
+
+    /// The selector republished by [`Self::reconcile_config`].
+    pub fn selector(&self) -> &Arc<BackendSelector> {
+        &self.selector
     }
 
     /// Stops all checker tasks (used on graceful process shutdown).
@@ -41,6 +54,18 @@ impl HealthCheckSupervisor {
         }
     }
 
+    /// [`Self::reconcile`] the snapshot's backends, then publish its selection snapshot (startup
+    /// and every successful reload).
+    pub fn reconcile_config(
+        &self,
+        dynamic: &DynamicConfig,
+        metrics: &Arc<Metrics>,
+        handle: &Handle,
+    ) {
+        self.reconcile(&dynamic.backends, metrics, handle);
+        self.selector.publish(&dynamic.routing, &self.registry);
+    }
+
     /// Diff `backends` against the running set: cancels removed/changed, spawns new tasks.
     pub fn reconcile(&self, backends: &[Backend], metrics: &Arc<Metrics>, handle: &Handle) {
         let wanted = collect_wanted_checks(backends);
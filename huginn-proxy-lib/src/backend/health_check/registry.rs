@@ -5,11 +5,13 @@
 //! backend's status on every request without any coordination with the
 //! checker tasks.
 //!
-//! The map is wrapped in `Arc<RwLock<HashMap<...>>>` for consistency with the
-//! existing `SharedRateLimiter` pattern in
-//! [`crate::proxy::reload`]. Reads dominate writes by orders of magnitude
-//! (every request reads, mutations only happen on hot reload), so the
-//! `RwLock` contention is negligible in practice.
+//! The map is an immutable snapshot published through `ArcSwap`, the same
+//! pattern as `SharedRateLimiter` in [`crate::proxy::reload`]. Reads dominate
+//! writes by orders of magnitude (every request reads, mutations only happen on
+//! hot reload), so readers never take a lock: a write clones the map, edits the
+//! copy and swaps it in, serialised by a writer-only mutex. The request path
+//! goes one step further and reads each backend's [`UpstreamHealth`] straight
+//! from the selector snapshot (see [`crate::backend::BackendSelector`]).
 //!
 //! ## Opt-in behaviour
 //!
@@ -19,14 +21,24 @@
 //! not gated until a backend registers a probe.
 
 use super::health::UpstreamHealth;
+use arc_swap::ArcSwap;
 use std::collections::HashMap;
-use std::sync::{Arc, RwLock};
+use std::sync::{Arc, Mutex};
 
-/// Address → health state map shared between the future `HealthCheckSupervisor`
+type HealthMap = HashMap<String, Arc<UpstreamHealth>>;
+
+/// Address → health state map shared between the `HealthCheckSupervisor`
 /// (writer, on hot reload) and the forwarding gate (reader, per request).
 #[derive(Debug, Default, Clone)]
 pub struct HealthRegistry {
-    inner: Arc<RwLock<HashMap<String, Arc<UpstreamHealth>>>>,
+    inner: Arc<RegistryInner>,
+}
+
+#[derive(Debug, Default)]
+struct RegistryInner {
+    map: ArcSwap<HealthMap>,
+    /// Serialises writers so concurrent copy-on-write updates never lose an entry.
+    write: Mutex<()>,
 }
 
 impl HealthRegistry {
@@ -40,50 +52,62 @@ impl HealthRegistry {
     /// Opt-in: only backends with an active health-check configuration are
     /// registered; unknown addresses are treated as healthy (no gate).
     pub fn is_healthy(&self, address: &str) -> bool {
-        match self.inner.read() {
-            Ok(map) => map.get(address).is_none_or(|h| h.is_healthy()),
-            // Lock poisoning means a checker task panicked. Fail-open so the
-            // proxy keeps serving traffic while the operator investigates.
-            Err(poisoned) => poisoned
-                .into_inner()
-                .get(address)
-                .is_none_or(|h| h.is_healthy()),
-        }
+        self.inner
+            .map
+            .load()
+            .get(address)
+            .is_none_or(|h| h.is_healthy())
+    }
+
+    /// The [`UpstreamHealth`] handle for `address`, if registered. Used to pin
+    /// health handles into the selector snapshot.
+    pub fn get(&self, address: &str) -> Option<Arc<UpstreamHealth>> {
+        self.inner.map.load().get(address).cloned()
     }
 
     /// Returns the [`UpstreamHealth`] handle for `address`, creating it (and
     /// inserting it into the map) if absent. Used by the supervisor when starting a probe task.
     pub fn get_or_create(&self, address: &str) -> Arc<UpstreamHealth> {
-        let mut map = self.inner.write().unwrap_or_else(|e| e.into_inner());
-        map.entry(address.to_string())
-            .or_insert_with(|| Arc::new(UpstreamHealth::new()))
-            .clone()
+        let _write = self.lock_writer();
+        if let Some(health) = self.inner.map.load().get(address) {
+            return Arc::clone(health);
+        }
+        let health = Arc::new(UpstreamHealth::new());
+        let mut map = HealthMap::clone(&self.inner.map.load());
+        map.insert(address.to_string(), Arc::clone(&health));
+        self.inner.map.store(Arc::new(map));
+        health
     }
 
     /// Drop the entry for `address`. Used by the supervisor when a probe is
     /// canceled (backend removed or health check disabled via hot reload).
     pub fn remove(&self, address: &str) {
-        let mut map = self.inner.write().unwrap_or_else(|e| e.into_inner());
+        let _write = self.lock_writer();
+        if !self.inner.map.load().contains_key(address) {
+            return;
+        }
+        let mut map = HealthMap::clone(&self.inner.map.load());
         map.remove(address);
+        self.inner.map.store(Arc::new(map));
     }
 
     /// Returns the set of currently registered addresses. Useful for hot
     /// reload diffing and for tests.
     pub fn addresses(&self) -> Vec<String> {
-        let map = self.inner.read().unwrap_or_else(|e| e.into_inner());
-        map.keys().cloned().collect()
+        self.inner.map.load().keys().cloned().collect()
     }
 
     /// Number of backends currently registered. Mostly useful for tests.
     pub fn len(&self) -> usize {
-        self.inner.read().unwrap_or_else(|e| e.into_inner()).len()
+        self.inner.map.load().len()
     }
 
     /// Returns `true` if no backends are registered.
     pub fn is_empty(&self) -> bool {
-        self.inner
-            .read()
-            .unwrap_or_else(|e| e.into_inner())
-            .is_empty()
+        self.inner.map.load().is_empty()
+    }
+
+    fn lock_writer(&self) -> std::sync::MutexGuard<'_, ()> {
+        self.inner.write.lock().unwrap_or_else(|e| e.into_inner())
     }
 }
@@ -0,0 +1,78 @@
+use std::fmt::{self, Write as _};
+use std::net::IpAddr;
+
+use crate::config::HashKey;
+
+/// Request properties a consistent-hash route can key on.
+#[derive(Clone, Copy)]
+pub struct ClientKey<'a> {
+    /// Effective client IP.
+    pub ip: IpAddr,
+    /// Client JA4 (`ja4` header value) when the connection was fingerprinted.
+    pub ja4: Option<&'a dyn fmt::Display>,
+}
+
+impl<'a> ClientKey<'a> {
+    pub fn new(ip: IpAddr, ja4: Option<&'a dyn fmt::Display>) -> Self {
+        Self { ip, ja4 }
+    }
+
+    /// Stable 64-bit hash of the property selected by `key`. JA4 falls back to the IP when the
+    /// connection carries no fingerprint. The JA4 is hashed straight from its `Display`
+    /// output, without building the string.
+    pub fn hash(&self, key: HashKey) -> u64 {
+        let mut hasher = Fnv1a::default();
+        match (key, self.ja4) {
+            (HashKey::Ja4, Some(ja4)) => {
+                // `Fnv1a::write_str` never fails.
+                let _ = write!(hasher, "{ja4}");
+            }
+            _ => match self.ip {
+                IpAddr::V4(ip) => hasher.write(&ip.octets()),
+                IpAddr::V6(ip) => hasher.write(&ip.octets()),
+            },
+        }
+        hasher.0
+    }
+}
+
+/// Stable hash of a backend address, precomputed per slot for rendezvous hashing.
+pub(crate) fn address_hash(address: &str) -> u64 {
+    let mut hasher = Fnv1a::default();
+    hasher.write(address.as_bytes());
+    hasher.0
+}
+
+/// Rendezvous weight of `(client, backend)`; the highest weight owns the client. The
+/// finalizer spreads the combined bits so close FNV hashes do not favor one backend.
+pub(crate) fn rendezvous_weight(client_hash: u64, address_hash: u64) -> u64 {
+    let mut z = client_hash ^ address_hash;
+    z = (z ^ (z >> 30)).wrapping_mul(0xbf58_476d_1ce4_e5b9);
+    z = (z ^ (z >> 27)).wrapping_mul(0x94d0_49bb_1331_11eb);
+    z ^ (z >> 31)
+}
+
+/// 64-bit FNV-1a. Unlike the std/ahash hashers it is unseeded, so the mapping of clients to
+/// backends survives restarts and is identical on every proxy instance.
+struct Fnv1a(u64);
+
+impl Default for Fnv1a {
+    fn default() -> Self {
+        Self(0xcbf2_9ce4_8422_2325)
+    }
+}
+
+impl Fnv1a {
+    fn write(&mut self, bytes: &[u8]) {
+        for &byte in bytes {
+            self.0 = (self.0 ^ u64::from(byte)).wrapping_mul(0x0100_0000_01b3);
+        }
+    }
+}
+
+impl fmt::Write for Fnv1a {
+    fn write_str(&mut self, s: &str) -> fmt::Result {
+        self.write(s.as_bytes());
+        Ok(())
+    }
+}
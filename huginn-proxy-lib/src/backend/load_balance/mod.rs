@@ -1,4 +1,8 @@
+pub mod affinity;
 pub mod round_robin;
 pub mod selector;
+pub mod stats;
+pub use affinity::ClientKey;
 pub use round_robin::RoundRobin;
-pub use selector::BackendSelector;
+pub use selector::{BackendSelector, SelectedBackend};
+pub use stats::BackendStats;
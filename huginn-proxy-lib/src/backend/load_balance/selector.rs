@@ -1,17 +1,169 @@
-use std::collections::HashMap;
-use std::sync::RwLock;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::Arc;
 
-use crate::backend::health_check::HealthRegistry;
+use ahash::AHashMap;
+use arc_swap::ArcSwap;
 
+use crate::backend::health_check::{HealthRegistry, UpstreamHealth};
+use crate::config::LoadBalance;
+use crate::proxy::router::{RouteMatch, RoutingTable, UpstreamTarget};
+
+use super::affinity::{address_hash, rendezvous_weight, ClientKey};
 use super::round_robin::RoundRobin;
+use super::stats::BackendStats;
 
 /// Selects one healthy backend among route candidates using the currently configured strategy.
 ///
-/// The selector is intentionally lightweight, and lock contention is negligible in
-/// practice: one read lock per request and a write lock only on the first use of a prefix.
+/// The request path ([`Self::select_route`]) reads an immutable [`SelectorSnapshot`] published
+/// through `ArcSwap` by [`Self::publish`] (startup and every reload, after health checks are
+/// reconciled): per route group it holds the group's [`LoadBalance`] strategy, the candidate
+/// addresses as `Arc<str>`, each backend's [`UpstreamHealth`] atomic and [`BackendStats`], and a
+/// cache-line padded cursor, so selection takes no lock and allocates nothing. Requests still on
+/// a config generation other than the published one (a keep-alive or HTTP/2 connection opened
+/// before a reload) use the published plan of the same domain host and route prefix, so they
+/// share its cursors, stats and hash affinity; a group the reload removed is served from its own
+/// candidates with the same strategy. [`Self::select`] is the plain by-address round-robin path.
 #[derive(Default)]
 pub struct BackendSelector {
-    rr_by_prefix: RwLock<HashMap<String, RoundRobin>>,
+    snapshot: ArcSwap<SelectorSnapshot>,
+    rr_by_prefix: ArcSwap<AHashMap<String, RoundRobin>>,
+    /// Per-address load stats, carried over across publishes.
+    stats: ArcSwap<AHashMap<Arc<str>, Arc<BackendStats>>>,
+}
+
+/// Backend chosen for one request.
+#[derive(Debug, Clone)]
+pub struct SelectedBackend {
+    pub address: Arc<str>,
+    /// Load stats of `address`; `None` only for an address never published (stale snapshot).
+    pub stats: Option<Arc<BackendStats>>,
+    /// Pre-resolved upstream of `address` from the routing table; `None` on the stale-snapshot
+    /// fallback, where `forward` resolves the address itself.
+    pub upstream: Option<Arc<UpstreamTarget>>,
+}
+
+/// Selection state compiled for one [`RoutingTable`].
+#[derive(Default)]
+struct SelectorSnapshot {
+    /// Routing table this snapshot was compiled from (identity-compared, never dereferenced on
+    /// the request path).
+    routing: Option<Arc<RoutingTable>>,
+    /// Per domain, per route index; `Some` only at the first route of each same-prefix group.
+    plans: Vec<Vec<Option<RoutePlan>>>,
+    /// Domain host → route prefix → `(domain index, route index)` of the group's plan, for
+    /// requests matched by another routing table. First domain per host, as routing picks.
+    groups: AHashMap<Option<String>, AHashMap<String, (usize, usize)>>,
+}
+
+struct RoutePlan {
+    strategy: LoadBalance,
+    slots: Box<[BackendSlot]>,
+    cursor: PaddedCursor,
+}
+
+struct BackendSlot {
+    address: Arc<str>,
+    /// `None` when the backend has no health check (always healthy).
+    health: Option<Arc<UpstreamHealth>>,
+    stats: Arc<BackendStats>,
+    /// Rendezvous-hashing seed of `address`.
+    address_hash: u64,
+    upstream: Option<Arc<UpstreamTarget>>,
+}
+
+impl BackendSlot {
+    fn is_healthy(&self) -> bool {
+        self.health.as_ref().is_none_or(|h| h.is_healthy())
+    }
+
+    fn selected(&self) -> SelectedBackend {
+        SelectedBackend {
+            address: Arc::clone(&self.address),
+            stats: Some(Arc::clone(&self.stats)),
+            upstream: self.upstream.clone(),
+        }
+    }
+}
+
+impl SelectorSnapshot {
+    fn plan(&self, domain_index: usize, route_index: usize) -> Option<&RoutePlan> {
+        self.plans.get(domain_index)?.get(route_index)?.as_ref()
+    }
+}
+
+impl RoutePlan {
+    fn pick(&self, client: &ClientKey<'_>) -> Option<&BackendSlot> {
+        let healthy = || self.slots.iter().filter(|slot| slot.is_healthy());
+        let len = healthy().count();
+        if len <= 1 {
+            return healthy().next();
+        }
+        match self.strategy {
+            LoadBalance::RoundRobin => healthy().nth(self.cursor.next(len)),
+            LoadBalance::LeastOutstanding => {
+                // Rotate the scan start so ties do not always go to the first candidate.
+                let offset = self.cursor.next(len);
+                healthy()
+                    .cycle()
+                    .skip(offset)
+                    .take(len)
+                    .min_by_key(|slot| slot.stats.in_flight())
+            }
+            LoadBalance::P2cEwma => {
+                let (a, b) = self.cursor.two_distinct(len);
+                let (a, b) = (healthy().nth(a)?, healthy().nth(b)?);
+                let (cost_a, cost_b) = (a.stats.cost(), b.stats.cost());
+                if cost_b < cost_a
+                    || (cost_b == cost_a && b.stats.in_flight() < a.stats.in_flight())
+                {
+                    Some(b)
+                } else {
+                    Some(a)
+                }
+            }
+            LoadBalance::ConsistentHash { key } => {
+                let client = client.hash(key);
+                healthy().max_by_key(|slot| rendezvous_weight(client, slot.address_hash))
+            }
+        }
+    }
+}
+
+/// Round-robin cursor on its own cache line, so cursors of routes served from different cores
+/// never share one. 128 bytes also covers the adjacent-line prefetcher on x86_64 and the
+/// 128-byte lines of Apple aarch64.
+#[repr(align(128))]
+#[derive(Default)]
+struct PaddedCursor(AtomicUsize);
+
+impl PaddedCursor {
+    /// Next round-robin index in `0..len` (`len > 0`).
+    fn next(&self, len: usize) -> usize {
+        self.0
+            .fetch_add(1, Ordering::Relaxed)
+            .checked_rem(len)
+            .unwrap_or(0)
+    }
+
+    /// Two distinct pseudo-random indices in `0..len` (`len >= 2`) for P2C: the cursor ticket
+    /// is scrambled (splitmix64) rather than drawn from a thread RNG, keeping selection
+    /// dependency- and lock-free.
+    fn two_distinct(&self, len: usize) -> (usize, usize) {
+        let ticket = self.0.fetch_add(1, Ordering::Relaxed) as u64;
+        let mut z = ticket.wrapping_mul(0x9e37_79b9_7f4a_7c15);
+        z = (z ^ (z >> 30)).wrapping_mul(0xbf58_476d_1ce4_e5b9);
+        z = (z ^ (z >> 27)).wrapping_mul(0x94d0_49bb_1331_11eb);
+        z ^= z >> 31;
+        let len64 = len as u64;
+        let first = z.checked_rem(len64).unwrap_or(0);
+        // Second index drawn from the other `len - 1` slots, from the high bits.
+        let step = (z >> 32)
+            .checked_rem(len64.saturating_sub(1))
+            .unwrap_or(0)
+            .saturating_add(1);
+        let second = first.saturating_add(step).checked_rem(len64).unwrap_or(0);
+        (first as usize, second as usize)
+    }
 }
 
 impl BackendSelector {
@@ -19,48 +171,247 @@ impl BackendSelector {
         Self::default()
     }
 
+    /// Compile and publish the selection snapshot for `routing`.
+    ///
+    /// Health handles are pinned from `health_registry` as registered right now, so call this
+    /// after every health-check reconcile (see `HealthCheckSupervisor::reconcile_config`).
+    /// Round-robin cursors start over with each snapshot; per-address [`BackendStats`] (in-flight
+    /// counts, latency EWMA) carry over for addresses still routed to.
+    pub fn publish(&self, routing: &Arc<RoutingTable>, health_registry: &HealthRegistry) {
+        let previous_stats = self.stats.load();
+        let mut stats: AHashMap<Arc<str>, Arc<BackendStats>> = AHashMap::new();
+        let mut groups: AHashMap<Option<String>, AHashMap<String, (usize, usize)>> =
+            AHashMap::new();
+        for (domain_index, domain) in routing.domains().iter().enumerate() {
+            if groups.contains_key(&domain.host) {
+                continue;
+            }
+            let mut by_prefix = AHashMap::new();
+            for (index, r) in domain.routes.iter().enumerate() {
+                by_prefix
+                    .entry(r.prefix.clone())
+                    .or_insert((domain_index, index));
+            }
+            groups.insert(domain.host.clone(), by_prefix);
+        }
+        let plans = routing
+            .domains()
+            .iter()
+            .enumerate()
+            .map(|(domain_index, domain)| {
+                let routes = &domain.routes;
+                let mut prev_prefix: Option<&str> = None;
+                routes
+                    .iter()
+                    .enumerate()
+                    .map(|(index, first)| {
+                        let first_of_group = prev_prefix != Some(first.prefix.as_str());
+                        prev_prefix = Some(first.prefix.as_str());
+                        if !first_of_group {
+                            return None;
+                        }
+                        let slots = routes[index..]
+                            .iter()
+                            .take_while(|r| r.prefix == first.prefix)
+                            .enumerate()
+                            .map(|(offset, r)| {
+                                let (address, stats) =
+                                    intern(&mut stats, &previous_stats, r.backend.as_str());
+                                BackendSlot {
+                                    address_hash: address_hash(&address),
+                                    address,
+                                    health: health_registry.get(&r.backend),
+                                    stats,
+                                    upstream: routing
+                                        .upstream(domain_index, index.saturating_add(offset))
+                                        .cloned(),
+                                }
+                            })
+                            .collect();
+                        Some(RoutePlan {
+                            strategy: first.load_balance,
+                            slots,
+                            cursor: PaddedCursor::default(),
+                        })
+                    })
+                    .collect()
+            })
+            .collect();
+        self.stats.store(Arc::new(stats));
+        self.snapshot.store(Arc::new(SelectorSnapshot {
+            routing: Some(Arc::clone(routing)),
+            plans,
+            groups,
+        }));
+    }
+
+    /// Choose one backend for `route`, matched by `routing` in the domain at `domain_index`.
+    ///
+    /// Unhealthy candidates are skipped and `None` is returned when none is left, as in
+    /// [`Self::select`]; among several healthy candidates the group's [`LoadBalance`] strategy
+    /// decides (`client` feeds consistent hashing). Lock- and allocation-free when `routing` is
+    /// the table of the published snapshot. Otherwise (a connection still on a previous config
+    /// generation) the published plan of the same domain host and prefix decides, so a client
+    /// keeps its consistent-hash backend across the reload; a group the published config no
+    /// longer has is picked from `route`'s candidates with its own strategy.
+    pub fn select_route(
+        &self,
+        routing: &Arc<RoutingTable>,
+        domain_index: usize,
+        route: &RouteMatch<'_>,
+        client: &ClientKey<'_>,
+        health_registry: &HealthRegistry,
+    ) -> Option<SelectedBackend> {
+        let snapshot = self.snapshot.load();
+        let published = snapshot
+            .routing
+            .as_ref()
+            .is_some_and(|published| Arc::ptr_eq(published, routing));
+        let plan = if published {
+            snapshot.plan(domain_index, route.route_index)
+        } else {
+            routing
+                .domain(domain_index)
+                .and_then(|domain| snapshot.groups.get(&domain.host))
+                .and_then(|by_prefix| by_prefix.get(route.matched_prefix))
+                .and_then(|&(domain_index, route_index)| snapshot.plan(domain_index, route_index))
+        };
+        match plan {
+            // The published upstream indexes the published backend list, not `routing`'s.
+            Some(plan) => plan.pick(client).map(|slot| {
+                let mut selected = slot.selected();
+                if !published {
+                    selected.upstream = None;
+                }
+                selected
+            }),
+            None => {
+                let strategy = routing
+                    .domain(domain_index)
+                    .and_then(|domain| domain.routes.get(route.route_index))
+                    .map(|r| r.load_balance)
+                    .unwrap_or_default();
+                self.select_unpublished(strategy, route, client, health_registry)
+            }
+        }
+    }
+
+    /// [`RoutePlan::pick`] over the candidates of a group missing from the published snapshot,
+    /// resolving health and stats by address.
+    fn select_unpublished(
+        &self,
+        strategy: LoadBalance,
+        route: &RouteMatch<'_>,
+        client: &ClientKey<'_>,
+        health_registry: &HealthRegistry,
+    ) -> Option<SelectedBackend> {
+        let stats = self.stats.load();
+        let candidates = route.backend_candidates;
+        let healthy = || {
+            candidates
+                .iter()
+                .filter(|address| health_registry.is_healthy(address))
+        };
+        let in_flight = |address: &str| stats.get(address).map_or(0, |s| s.in_flight());
+        let cost = |address: &str| stats.get(address).map_or(0.0, |s| s.cost());
+        let address = match healthy().count() {
+            0 => return None,
+            1 => healthy().next()?,
+            len => match strategy {
+                LoadBalance::RoundRobin => healthy().nth(self.rr(route.matched_prefix, len))?,
+                LoadBalance::LeastOutstanding => healthy().min_by_key(|a| in_flight(a))?,
+                LoadBalance::P2cEwma => {
+                    let first = self.rr(route.matched_prefix, len);
+                    let a = healthy().nth(first)?;
+                    let b = healthy().cycle().nth(first.saturating_add(1))?;
+                    if cost(b) < cost(a) || (cost(b) == cost(a) && in_flight(b) < in_flight(a)) {
+                        b
+                    } else {
+                        a
+                    }
+                }
+                LoadBalance::ConsistentHash { key } => {
+                    let client = client.hash(key);
+                    healthy().max_by_key(|a| rendezvous_weight(client, address_hash(a)))?
+                }
+            },
+        };
+        let (address, stats) = match stats.get_key_value(address) {
+            Some((address, entry)) => (Arc::clone(address), Some(Arc::clone(entry))),
+            None => (Arc::from(address), None),
+        };
+        Some(SelectedBackend { address, stats, upstream: None })
+    }
+
     /// Choose one backend address among route candidates.
     ///
     /// - Candidates are filtered by `health_registry` (active health checks).
     /// - If exactly one healthy candidate remains, return it directly.
     /// - If multiple healthy candidates remain, pick one with per-prefix round-robin.
     /// - If no candidate is healthy (or the list is empty), return `None`.
-    pub fn select(
+    pub fn select<I, S>(
         &self,
         route_prefix: &str,
-        candidates: &[&str],
+        candidates: I,
         health_registry: &HealthRegistry,
-    ) -> Option<String> {
-        let healthy: Vec<&str> = candidates
-            .iter()
-            .copied()
-            .filter(|addr| health_registry.is_healthy(addr))
-            .collect();
+    ) -> Option<String>
+    where
+        I: IntoIterator<Item = S>,
+        I::IntoIter: Clone,
+        S: AsRef<str>,
+    {
+        let candidates = candidates.into_iter();
+        let healthy = || {
+            candidates
+                .clone()
+                .filter(|addr| health_registry.is_healthy(addr.as_ref()))
+        };
+        let index = match healthy().count() {
+            0 => return None,
+            1 => 0,
+            len => self.rr(route_prefix, len),
+        };
+        healthy().nth(index).map(|addr| addr.as_ref().to_string())
+    }
 
-        match healthy.len() {
-            0 => None,
-            1 => Some(healthy[0].to_string()),
-            len => {
-                let idx = self.get_or_create_rr(route_prefix).next(len);
-                Some(healthy[idx].to_string())
-            }
-        }
+    /// Next per-prefix round-robin index in `0..len`.
+    fn rr(&self, route_prefix: &str, len: usize) -> usize {
+        self.get_or_create_rr(route_prefix).next(len)
     }
 
     fn get_or_create_rr(&self, route_prefix: &str) -> RoundRobin {
-        if let Some(rr) = self
-            .rr_by_prefix
-            .read()
-            .unwrap_or_else(|e| e.into_inner())
-            .get(route_prefix)
-        {
+        if let Some(rr) = self.rr_by_prefix.load().get(route_prefix) {
             return rr.clone();
         }
+        // First use of this prefix: copy-on-write insert. `rcu` retries on a concurrent insert,
+        // and `or_default` keeps whichever cursor won.
+        self.rr_by_prefix.rcu(|map| {
+            let mut map = AHashMap::clone(map);
+            map.entry(route_prefix.to_string()).or_default();
+            map
+        });
         self.rr_by_prefix
-            .write()
-            .unwrap_or_else(|e| e.into_inner())
-            .entry(route_prefix.to_string())
-            .or_default()
-            .clone()
+            .load()
+            .get(route_prefix)
+            .cloned()
+            .unwrap_or_default()
+    }
+}
+
+/// Address and stats for `backend` in the snapshot being built: shared within it, and carried
+/// over from `previous` when the address was already published.
+fn intern(
+    stats: &mut AHashMap<Arc<str>, Arc<BackendStats>>,
+    previous: &AHashMap<Arc<str>, Arc<BackendStats>>,
+    backend: &str,
+) -> (Arc<str>, Arc<BackendStats>) {
+    if let Some((address, entry)) = stats.get_key_value(backend) {
+        return (Arc::clone(address), Arc::clone(entry));
     }
+    let (address, entry) = match previous.get_key_value(backend) {
+        Some((address, entry)) => (Arc::clone(address), Arc::clone(entry)),
+        None => (Arc::from(backend), Arc::new(BackendStats::new())),
+    };
+    stats.insert(Arc::clone(&address), Arc::clone(&entry));
+    (address, entry)
 }
@@ -0,0 +1,70 @@
+use std::sync::atomic::{AtomicU64, AtomicUsize, Ordering};
+
+/// Weight of the newest sample in the latency EWMA.
+const EWMA_ALPHA: f64 = 0.3;
+
+/// Live load signals of one backend address, read by the least-outstanding and P2C strategies.
+///
+/// One instance per address is shared by every route plan targeting it, and carried over by
+/// `BackendSelector::publish` across reloads, so requests started under a previous snapshot
+/// still decrement the counter the current snapshot reads.
+#[derive(Debug, Default)]
+pub struct BackendStats {
+    in_flight: AtomicUsize,
+    /// Latency EWMA in seconds, stored as `f64` bits; `0.0` until the first sample.
+    ewma_bits: AtomicU64,
+}
+
+impl BackendStats {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// Requests currently forwarded to this backend and not yet answered.
+    pub fn in_flight(&self) -> usize {
+        self.in_flight.load(Ordering::Relaxed)
+    }
+
+    /// Backend latency EWMA in seconds (`0.0` before the first response).
+    pub fn latency_ewma(&self) -> f64 {
+        f64::from_bits(self.ewma_bits.load(Ordering::Relaxed))
+    }
+
+    /// Count one request as in flight; pair every call with [`Self::finish`].
+    pub fn start(&self) {
+        self.in_flight.fetch_add(1, Ordering::Relaxed);
+    }
+
+    /// Release one request counted by [`Self::start`].
+    pub fn finish(&self) {
+        // Saturating so an unpaired call cannot wrap the counter and starve this backend.
+        let _ = self
+            .in_flight
+            .fetch_update(Ordering::Relaxed, Ordering::Relaxed, |n| n.checked_sub(1));
+    }
+
+    /// Fold one backend response time into the EWMA and return the new value. The first sample
+    /// seeds the average directly.
+    pub fn observe_latency(&self, seconds: f64) -> f64 {
+        let update = |bits: u64| {
+            let prev = f64::from_bits(bits);
+            let next = if prev > 0.0 {
+                prev + EWMA_ALPHA * (seconds - prev)
+            } else {
+                seconds
+            };
+            Some(next.to_bits())
+        };
+        let prev = self
+            .ewma_bits
+            .fetch_update(Ordering::Relaxed, Ordering::Relaxed, update)
+            .unwrap_or_else(|bits| bits);
+        update(prev).map_or(seconds, f64::from_bits)
+    }
+
+    /// P2C cost: expected wait for one more request, `latency EWMA × (in-flight + 1)`.
+    /// Unsampled backends cost `0.0`, so they receive traffic until they report a latency.
+    pub(crate) fn cost(&self) -> f64 {
+        self.latency_ewma() * (self.in_flight() as f64 + 1.0)
+    }
+}
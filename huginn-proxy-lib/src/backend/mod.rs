@@ -5,5 +5,5 @@ mod upstream_gateway;
 pub use health_check::{
     check_http, HealthCheckHttpClient, HealthCheckSupervisor, HealthRegistry, UpstreamHealth,
 };
-pub use load_balance::{BackendSelector, RoundRobin};
+pub use load_balance::{BackendSelector, BackendStats, ClientKey, RoundRobin, SelectedBackend};
 pub use upstream_gateway::UpstreamGateway;
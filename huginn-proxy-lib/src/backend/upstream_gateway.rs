@@ -1,19 +1,34 @@
 use std::sync::Arc;
 
 use super::{BackendSelector, HealthRegistry};
+use crate::proxy::admission::ConcurrencyLimiter;
+use crate::proxy::cache::ResponseCache;
+use crate::proxy::coalesce::Coalescer;
 
 /// Combines selection and health-gate into a single forwarding context.
 ///
-/// [`BackendSelector`] (round-robin algorithm) and the [`HealthRegistry`]
-/// (per-backend health state). Cheap to clone both fields are `Arc`.
+/// [`BackendSelector`] (round-robin algorithm), the [`HealthRegistry`]
+/// (per-backend health state), the adaptive [`ConcurrencyLimiter`] and the
+/// [`ResponseCache`] in front of the backends, if enabled, and the [`Coalescer`] of
+/// in-flight requests.
+/// Cheap to clone, every field is an `Arc`.
 #[derive(Clone)]
 pub struct UpstreamGateway {
     pub health: Arc<HealthRegistry>,
     pub selector: Arc<BackendSelector>,
+    pub concurrency: Option<Arc<ConcurrencyLimiter>>,
+    pub cache: Option<Arc<ResponseCache>>,
+    pub coalescer: Arc<Coalescer>,
 }
 
 impl UpstreamGateway {
-    pub fn new(health: Arc<HealthRegistry>, selector: Arc<BackendSelector>) -> Self {
-        Self { health, selector }
+    pub fn new(
+        health: Arc<HealthRegistry>,
+        selector: Arc<BackendSelector>,
+        concurrency: Option<Arc<ConcurrencyLimiter>>,
+        cache: Option<Arc<ResponseCache>>,
+        coalescer: Arc<Coalescer>,
+    ) -> Self {
+        Self { health, selector, concurrency, cache, coalescer }
     }
 }
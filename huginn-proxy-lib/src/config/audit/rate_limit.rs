@@ -6,8 +6,8 @@ use crate::config::{Config, LimitBy, RateLimitConfig};
 /// Findings for one enabled rate-limit block. Disabled blocks build no limiter, so they are skipped.
 ///
 /// Catches two silent footguns:
-/// - `window_seconds == 0`: the limiter is built with `Duration::from_secs(0)` and cannot express a
-///   rate.
+/// - `requests_per_second == 0`: the token bucket cannot refill at a zero rate, so the limiter
+///   enforces the minimum of 1 request per second instead of what the config reads as.
 /// - `limit_by = "header"` without a `limit_by_header`: at runtime the key extraction falls back to
 ///   the peer IP, silently limiting by IP instead of the intended header.
 fn check_block(out: &mut Vec<ConfigWarning>, scope: &str, rl: &RateLimitConfig) {
@@ -17,10 +17,11 @@ fn check_block(out: &mut Vec<ConfigWarning>, scope: &str, rl: &RateLimitConfig)
     let mut push = |message: &str| {
         out.push(ConfigWarning { scope: scope.to_string(), message: message.to_string() });
     };
-    if rl.window_seconds == 0 {
+    if rl.requests_per_second == 0 {
         push(
-            "rate_limit is enabled but window_seconds is 0; the limiter cannot compute a rate \
-             (window_seconds must be > 0)",
+            "rate_limit is enabled but requests_per_second is 0; the token bucket cannot refill \
+             at a zero rate and is enforced at 1 request per second (set burst = 0 to reject \
+             every request)",
         );
     }
     let header_missing = rl
@@ -1,5 +1,7 @@
 use std::convert::TryFrom;
 
+use super::cache::{RouteCacheConfig, RouteCacheView};
+use super::coalesce::{RouteCoalesceConfig, RouteCoalesceView};
 use super::headers::{HeaderManipulation, HeaderManipulationView};
 use super::security::{DomainSecurityConfig, RouteSecurityConfig, ScopedSecurityView};
 use crate::error::{ProxyError, Result};
@@ -182,6 +184,101 @@ pub struct Backend {
     pub health_check: Option<HealthCheckConfig>,
 }
 
+/// Request property hashed by [`LoadBalance::ConsistentHash`].
+#[derive(Debug, Default, Deserialize, Clone, Copy, PartialEq, Eq, Hash)]
+#[serde(rename_all = "lowercase")]
+pub enum HashKey {
+    /// Effective client IP (after PROXY protocol / trusted-proxy resolution).
+    #[default]
+    Ip,
+    /// Client JA4 fingerprint; falls back to the client IP on connections without one
+    /// (plain HTTP, or fingerprint capture disabled).
+    Ja4,
+}
+
+impl HashKey {
+    pub const fn as_str(self) -> &'static str {
+        match self {
+            HashKey::Ip => "ip",
+            HashKey::Ja4 => "ja4",
+        }
+    }
+}
+
+/// Backend choice among the routes sharing one prefix (a load-balance group).
+///
+/// Configured per route; every route of a group must carry the same value (checked by
+/// `Config::validate_cross_refs`). Health gating applies first with every strategy.
+#[derive(Debug, Default, Clone, Copy, PartialEq, Eq, Hash)]
+pub enum LoadBalance {
+    /// Rotate through healthy candidates.
+    #[default]
+    RoundRobin,
+    /// Candidate with the fewest requests currently in flight through this proxy.
+    LeastOutstanding,
+    /// Power of two choices: sample two candidates, keep the one with the lower
+    /// latency EWMA × (in-flight + 1).
+    P2cEwma,
+    /// Rendezvous hashing on `key`: a given client keeps landing on the same backend while it
+    /// stays healthy, and only the clients of a removed backend move.
+    ConsistentHash { key: HashKey },
+}
+
+impl LoadBalance {
+    pub const fn as_str(self) -> &'static str {
+        match self {
+            LoadBalance::RoundRobin => "round_robin",
+            LoadBalance::LeastOutstanding => "least_outstanding",
+            LoadBalance::P2cEwma => "p2c_ewma",
+            LoadBalance::ConsistentHash { .. } => "consistent_hash",
+        }
+    }
+}
+
+/// Wire shape for a `load_balance` table: `strategy` (default `round_robin`) and, for
+/// `consistent_hash` only, `hash_key` (default `ip`).
+#[derive(Deserialize, Default)]
+#[serde(deny_unknown_fields)]
+struct LoadBalanceDe {
+    strategy: Option<String>,
+    hash_key: Option<HashKey>,
+}
+
+impl TryFrom<LoadBalanceDe> for LoadBalance {
+    type Error = String;
+
+    fn try_from(d: LoadBalanceDe) -> std::result::Result<Self, Self::Error> {
+        let strategy = d.strategy.map(|s| s.to_lowercase());
+        let lb = match strategy.as_deref() {
+            None | Some("round_robin") => LoadBalance::RoundRobin,
+            Some("least_outstanding") => LoadBalance::LeastOutstanding,
+            Some("p2c_ewma") => LoadBalance::P2cEwma,
+            Some("consistent_hash") => {
+                return Ok(LoadBalance::ConsistentHash { key: d.hash_key.unwrap_or_default() });
+            }
+            Some(x) => {
+                return Err(format!(
+                    "invalid load_balance.strategy: \"{x}\" (expected `round_robin`, \
+                     `least_outstanding`, `p2c_ewma` or `consistent_hash`)"
+                ));
+            }
+        };
+        if d.hash_key.is_some() {
+            return Err(
+                "`hash_key` is only valid for load_balance.strategy = \"consistent_hash\"".into()
+            );
+        }
+        Ok(lb)
+    }
+}
+
+impl<'de> Deserialize<'de> for LoadBalance {
+    fn deserialize<D: Deserializer<'de>>(deserializer: D) -> std::result::Result<Self, D::Error> {
+        let raw = LoadBalanceDe::deserialize(deserializer)?;
+        LoadBalance::try_from(raw).map_err(serde::de::Error::custom)
+    }
+}
+
 /// Route configuration for path-based routing
 #[derive(Debug, Deserialize, Clone, PartialEq)]
 #[serde(deny_unknown_fields)]
@@ -205,6 +302,11 @@ pub struct Route {
     /// Default: false (use connection pooling for better performance)
     #[serde(default)]
     pub force_new_connection: bool,
+    /// Backend choice within this route's load-balance group (routes sharing `prefix`).
+    /// Example: `load_balance = { strategy = "consistent_hash", hash_key = "ja4" }`
+    /// Default: round-robin
+    #[serde(default)]
+    pub load_balance: LoadBalance,
     /// Path that will be used to replace the "prefix" part of incoming url
     /// If specified, the matched prefix will be replaced with this path before forwarding to backend
     /// Example: prefix = "/api", replace_path = "/v1"
@@ -220,15 +322,29 @@ pub struct Route {
     /// Allows adding or removing headers for specific routes
     #[serde(default)]
     pub headers: Option<HeaderManipulation>,
+    /// Serve cacheable `GET` responses from the shared `[cache]` store (optional)
+    /// Omit the table to always forward.
+    #[serde(default)]
+    pub cache: Option<RouteCacheConfig>,
+    /// Share one upstream request among concurrent identical `GET`s (optional)
+    /// Omit the table to forward every request on its own.
+    #[serde(default)]
+    pub coalesce: Option<RouteCoalesceConfig>,
 }
 
 /// Sort routes longest-prefix first so `pick_route` can use an early-terminating `find`.
 ///
-/// Stable sort preserves declaration order within same-length prefixes, which matters
-/// for load-balance groups that share the same prefix (round-robin candidates).
+/// Equal-length prefixes are ordered lexically so routes sharing a prefix sit next to each
+/// other; the routing table borrows each such load-balance group (round-robin candidates) as a
+/// contiguous slice. The sort is stable, so declaration order within a group is preserved.
 /// Call this once at config load time via `Config::into_parts`; do not call per-request.
 pub fn sort_routes(routes: &mut [Route]) {
-    routes.sort_by_key(|r| std::cmp::Reverse(r.prefix.len()));
+    routes.sort_by(|a, b| {
+        b.prefix
+            .len()
+            .cmp(&a.prefix.len())
+            .then_with(|| a.prefix.cmp(&b.prefix))
+    });
 }
 
 /// Identifier used for the catch-all (host-less) domain, the entry with `host: None`
@@ -317,6 +433,11 @@ pub struct BackendPoolConfig {
     /// Default: 0 (unlimited)
     #[serde(default)]
     pub pool_max_idle_per_host: usize,
+
+    /// Keep connections to every backend open ahead of demand (opt-in)
+    /// Omit the table to connect on demand only. Ignored when `enabled = false`.
+    #[serde(default)]
+    pub prewarm: Option<PrewarmConfig>,
 }
 
 impl Default for BackendPoolConfig {
@@ -325,6 +446,51 @@ impl Default for BackendPoolConfig {
             enabled: true,
             idle_timeout: default_backend_pool_idle_timeout(),
             pool_max_idle_per_host: 0,
+            prewarm: None,
+        }
+    }
+}
+
+/// `[backend_pool.prewarm]`: spare upstream connections opened ahead of demand, so a freshly
+/// (re)built pool does not pay TCP connect latency on its first requests.
+///
+/// Spares are established TCP connections handed to the pooled clients when they would
+/// otherwise dial; they add to the clients' own idle connections. A fresh pool is filled before
+/// it is swapped in on reload (bounded by `timeout_ms`), and spares are replaced in the
+/// background as they are used or closed by the backend.
+#[derive(Clone, Debug, Deserialize, PartialEq, Eq, Hash)]
+#[serde(deny_unknown_fields)]
+pub struct PrewarmConfig {
+    /// Spare HTTP/1.1 connections kept per backend
+    /// Default: 2
+    #[serde(default = "default_prewarm_min_idle")]
+    pub min_idle_per_backend: usize,
+
+    /// Also keep one spare HTTP/2 connection per backend whose `http_version` is `http2` or
+    /// `preserve`
+    /// Default: true
+    #[serde(default = "default_true")]
+    pub http2: bool,
+
+    /// Upper bound on how long a reload (or startup) waits for the initial fill, in milliseconds
+    /// Backends still connecting afterwards are filled in the background.
+    /// Default: 1000
+    #[serde(default = "default_prewarm_timeout_ms")]
+    pub timeout_ms: u64,
+
+    /// Interval of the background refill, in milliseconds (a used spare is replaced immediately)
+    /// Default: 1000
+    #[serde(default = "default_prewarm_refill_interval_ms")]
+    pub refill_interval_ms: u64,
+}
+
+impl Default for PrewarmConfig {
+    fn default() -> Self {
+        Self {
+            min_idle_per_backend: default_prewarm_min_idle(),
+            http2: true,
+            timeout_ms: default_prewarm_timeout_ms(),
+            refill_interval_ms: default_prewarm_refill_interval_ms(),
         }
     }
 }
@@ -340,6 +506,18 @@ fn default_backend_pool_idle_timeout() -> u64 {
     90
 }
 
+fn default_prewarm_min_idle() -> usize {
+    2
+}
+
+fn default_prewarm_timeout_ms() -> u64 {
+    1000
+}
+
+fn default_prewarm_refill_interval_ms() -> u64 {
+    1000
+}
+
 /// Allowlisted effective-config view of [`Backend`]. Field names are the JSON keys.
 #[derive(Serialize)]
 pub(crate) struct BackendView<'a> {
@@ -383,9 +561,18 @@ struct RouteView<'a> {
     backend: &'a str,
     fingerprinting: Option<bool>,
     force_new_connection: bool,
+    load_balance: LoadBalanceView,
     replace_path: Option<&'a str>,
     security: Option<ScopedSecurityView<'a>>,
     headers: Option<HeaderManipulationView<'a>>,
+    cache: Option<RouteCacheView>,
+    coalesce: Option<RouteCoalesceView>,
+}
+
+#[derive(Serialize)]
+struct LoadBalanceView {
+    strategy: &'static str,
+    hash_key: Option<&'static str>,
 }
 
 /// Allowlisted effective-config view of [`BackendPoolConfig`]. Field names are the JSON keys.
@@ -394,6 +581,15 @@ pub(crate) struct BackendPoolView {
     enabled: bool,
     idle_timeout: u64,
     pool_max_idle_per_host: usize,
+    prewarm: Option<PrewarmView>,
+}
+
+#[derive(Serialize)]
+struct PrewarmView {
+    min_idle_per_backend: usize,
+    http2: bool,
+    timeout_ms: u64,
+    refill_interval_ms: u64,
 }
 
 impl Backend {
@@ -427,6 +623,16 @@ impl HealthCheckConfig {
     }
 }
 
+impl LoadBalance {
+    fn effective_view(self) -> LoadBalanceView {
+        let hash_key = match self {
+            LoadBalance::ConsistentHash { key } => Some(key.as_str()),
+            _ => None,
+        };
+        LoadBalanceView { strategy: self.as_str(), hash_key }
+    }
+}
+
 impl Domain {
     pub(crate) fn effective_view(&self) -> DomainView<'_> {
         DomainView {
@@ -454,6 +660,7 @@ impl Route {
             backend: self.backend.as_str(),
             fingerprinting: self.fingerprinting,
             force_new_connection: self.force_new_connection,
+            load_balance: self.load_balance.effective_view(),
             replace_path: self.replace_path.as_deref(),
             security: self
                 .security
@@ -463,6 +670,11 @@ impl Route {
                 .headers
                 .as_ref()
                 .map(HeaderManipulation::effective_view),
+            cache: self.cache.as_ref().map(RouteCacheConfig::effective_view),
+            coalesce: self
+                .coalesce
+                .as_ref()
+                .map(RouteCoalesceConfig::effective_view),
         }
     }
 }
@@ -473,6 +685,12 @@ impl BackendPoolConfig {
             enabled: self.enabled,
             idle_timeout: self.idle_timeout,
             pool_max_idle_per_host: self.pool_max_idle_per_host,
+            prewarm: self.prewarm.as_ref().map(|p| PrewarmView {
+                min_idle_per_backend: p.min_idle_per_backend,
+                http2: p.http2,
+                timeout_ms: p.timeout_ms,
+                refill_interval_ms: p.refill_interval_ms,
+            }),
         }
     }
 }
@@ -0,0 +1,40 @@
+use serde::{Deserialize, Serialize};
+
+/// Response caching for one route (`[domains.routes.cache]`; opt-in, omit the table to disable).
+///
+/// `GET` responses the backend marks cacheable are stored in the shared `[cache]` store and
+/// served to later `GET`/`HEAD` requests for the same host, path and query until they expire.
+/// Freshness comes from `Cache-Control` (`s-maxage`, then `max-age`); `private`, `no-store`,
+/// `no-cache`, `Set-Cookie` and `Vary: *` keep a response out of the cache. Requests that carry
+/// `Authorization`, `Range` or `Cache-Control: no-store` bypass it.
+#[derive(Debug, Deserialize, Clone, PartialEq, Eq, Default)]
+#[serde(deny_unknown_fields)]
+pub struct RouteCacheConfig {
+    /// Freshness lifetime, in seconds, of a cacheable response that sets neither `max-age` nor
+    /// `s-maxage`. `0` = only cache responses with an explicit lifetime.
+    /// Default: 0
+    #[serde(default)]
+    pub default_ttl_secs: u64,
+    /// Key entries by the connection's JA4 fingerprint as well, so each TLS client profile gets
+    /// its own copy. Fingerprint headers the backend lists in `Vary` are otherwise ignored: the
+    /// proxy sets them itself, so the client's request never carries the values the backend saw.
+    /// Default: false
+    #[serde(default)]
+    pub key_fingerprints: bool,
+}
+
+/// Allowlisted effective-config view of [`RouteCacheConfig`]. Field names are the JSON keys.
+#[derive(Serialize)]
+pub(crate) struct RouteCacheView {
+    default_ttl_secs: u64,
+    key_fingerprints: bool,
+}
+
+impl RouteCacheConfig {
+    pub(crate) fn effective_view(&self) -> RouteCacheView {
+        RouteCacheView {
+            default_ttl_secs: self.default_ttl_secs,
+            key_fingerprints: self.key_fingerprints,
+        }
+    }
+}
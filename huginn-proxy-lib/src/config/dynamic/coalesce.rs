@@ -0,0 +1,85 @@
+use http::HeaderName;
+use serde::{Deserialize, Serialize};
+
+/// Request coalescing for one route (`[domains.routes.coalesce]`; opt-in, omit the table to
+/// disable).
+///
+/// Concurrent `GET`s for the same backend, host, route, path and query, and values of the
+/// `vary` headers share one upstream request. The others wait for its response and read the same
+/// body as it streams in. Requests carrying `Authorization` or `Cookie` are only coalesced when
+/// that header is listed in `vary`.
+#[derive(Debug, Deserialize, Clone, PartialEq, Eq)]
+#[serde(deny_unknown_fields)]
+pub struct RouteCoalesceConfig {
+    /// Request headers whose values split requests into separate flights (e.g.
+    /// `accept-encoding`). Case-insensitive.
+    /// Default: []
+    #[serde(default, deserialize_with = "deserialize_header_names")]
+    pub vary: Vec<HeaderName>,
+    /// How long a waiting request waits for the shared response head, in milliseconds, before it
+    /// is forwarded on its own.
+    /// Default: 2000
+    #[serde(default = "default_max_wait_ms")]
+    pub max_wait_ms: u64,
+    /// Largest response body shared with waiting requests, in bytes. A response without a known
+    /// length, or a longer one, only goes to the request that fetched it; the others are
+    /// forwarded on their own.
+    /// Default: 1048576 (1 MiB)
+    #[serde(default = "default_max_body_bytes")]
+    pub max_body_bytes: u64,
+}
+
+impl Default for RouteCoalesceConfig {
+    fn default() -> Self {
+        Self {
+            vary: Vec::new(),
+            max_wait_ms: default_max_wait_ms(),
+            max_body_bytes: default_max_body_bytes(),
+        }
+    }
+}
+
+fn default_max_wait_ms() -> u64 {
+    2000
+}
+
+fn default_max_body_bytes() -> u64 {
+    1024 * 1024
+}
+
+fn deserialize_header_names<'de, D>(deserializer: D) -> Result<Vec<HeaderName>, D::Error>
+where
+    D: serde::Deserializer<'de>,
+{
+    let strings: Vec<String> = Vec::deserialize(deserializer)?;
+    strings
+        .into_iter()
+        .map(|s| {
+            HeaderName::from_bytes(s.as_bytes()).map_err(|e| {
+                serde::de::Error::custom(format!("Invalid header name '{}': {}", s, e))
+            })
+        })
+        .collect()
+}
+
+/// Allowlisted effective-config view of [`RouteCoalesceConfig`]. Field names are the JSON keys.
+#[derive(Serialize)]
+pub(crate) struct RouteCoalesceView {
+    vary: Vec<String>,
+    max_wait_ms: u64,
+    max_body_bytes: u64,
+}
+
+impl RouteCoalesceConfig {
+    pub(crate) fn effective_view(&self) -> RouteCoalesceView {
+        RouteCoalesceView {
+            vary: self
+                .vary
+                .iter()
+                .map(|name| name.as_str().to_string())
+                .collect(),
+            max_wait_ms: self.max_wait_ms,
+            max_body_bytes: self.max_body_bytes,
+        }
+    }
+}
@@ -1,16 +1,23 @@
 pub mod backend;
+pub mod cache;
+pub mod coalesce;
 pub mod headers;
 pub mod security;
 pub use backend::{
     sort_domain_routes, sort_routes, Backend, BackendHttpVersion, BackendPoolConfig, Domain,
-    HealthCheckConfig, HealthCheckType, Route, DEFAULT_DOMAIN_LABEL, DEFAULT_FINGERPRINTING,
+    HashKey, HealthCheckConfig, HealthCheckType, LoadBalance, PrewarmConfig, Route,
+    DEFAULT_DOMAIN_LABEL, DEFAULT_FINGERPRINTING,
 };
+pub use cache::RouteCacheConfig;
+pub use coalesce::RouteCoalesceConfig;
 pub use headers::{CustomHeader, HeaderManipulation, HeaderManipulationGroup};
 pub use security::{
     CspConfig, DomainSecurityConfig, HstsConfig, IpFilterConfig, IpFilterMode, LimitBy,
     RateLimitConfig, RouteSecurityConfig, SecurityConfig, SecurityDynamicConfig, SecurityHeaders,
 };
 
+use crate::proxy::router::RoutingTable;
+use crate::security::IpFilterIndex;
 use backend::{BackendPoolView, BackendView, DomainView};
 use headers::HeaderManipulationView;
 use security::SecurityView;
@@ -29,12 +36,17 @@ pub struct DynamicConfig {
     pub backends: Arc<Vec<Backend>>,
     /// Domain entries, each groups a TLS cert with its path-based routes
     pub domains: Arc<Vec<Domain>>,
+    /// Host/route lookup index compiled from `domains`, shared by every connection on this snapshot
+    pub routing: Arc<RoutingTable>,
     /// Preserve the original Host header from clients when forwarding
     pub preserve_host: bool,
     /// Global header manipulation applied to all requests/responses
     pub headers: Option<HeaderManipulation>,
     /// Dynamic security policy (headers, IP filter, rate limits)
     pub security: SecurityDynamicConfig,
+    /// Global, domain and route IP filters compiled for lookup, shared by every connection on
+    /// this snapshot
+    pub ip_filters: Arc<IpFilterIndex>,
     /// Backend connection pool settings (idle timeout, max idle connections per host)
     pub backend_pool: BackendPoolConfig,
 }
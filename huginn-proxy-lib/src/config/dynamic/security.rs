@@ -1,9 +1,11 @@
 use std::net::IpAddr;
+use std::sync::Arc;
 
 use ipnet::IpNet;
 use serde::{Deserialize, Serialize};
 
 use super::headers::CustomHeader;
+use crate::config::startup::rate_limit_cluster::RateLimitClusterConfig;
 use crate::config::Secret;
 
 /// Security configuration (used for TOML deserialization via Config)
@@ -28,6 +30,9 @@ pub struct SecurityConfig {
     /// route, so it is configured once globally and is **not** overridable per domain/route.
     #[serde(default)]
     pub trusted_proxies: TrustedProxiesConfig,
+    /// Cluster-wide rate limiting (static requires restart to change)
+    #[serde(default)]
+    pub rate_limit_cluster: RateLimitClusterConfig,
 }
 
 impl Default for SecurityConfig {
@@ -38,6 +43,7 @@ impl Default for SecurityConfig {
             ip_filter: IpFilterConfig::default(),
             rate_limit: RateLimitConfig::default(),
             trusted_proxies: TrustedProxiesConfig::default(),
+            rate_limit_cluster: RateLimitClusterConfig::default(),
         }
     }
 }
@@ -115,8 +121,8 @@ pub struct DomainSecurityConfig {
 pub struct SecurityDynamicConfig {
     /// Security headers injected into responses
     pub headers: SecurityHeaders,
-    /// IP allow/deny list
-    pub ip_filter: IpFilterConfig,
+    /// IP allow/deny list, shared so per-connection security contexts don't copy large lists
+    pub ip_filter: Arc<IpFilterConfig>,
     /// Rate limiting policy
     pub rate_limit: RateLimitConfig,
     /// Trusted reverse-proxy configuration (global, not overridable per scope).
@@ -246,7 +252,7 @@ impl Default for IpFilterConfig {
 }
 
 /// Custom deserializer for IP networks that handles parsing errors gracefully
-fn deserialize_ip_networks<'de, D>(deserializer: D) -> Result<Vec<IpNet>, D::Error>
+pub(crate) fn deserialize_ip_networks<'de, D>(deserializer: D) -> Result<Vec<IpNet>, D::Error>
 where
     D: serde::Deserializer<'de>,
 {
@@ -273,15 +279,16 @@ pub struct RateLimitConfig {
     /// Default: false
     #[serde(default)]
     pub enabled: bool,
-    /// Maximum requests per second
+    /// Sustained requests per second (the token bucket refill rate)
     /// Default: 1000
     #[serde(default = "default_requests_per_second")]
     pub requests_per_second: u32,
-    /// Burst size (maximum requests in a single window)
+    /// Token bucket depth (requests a client may send at once before the sustained rate applies)
     /// Default: 2000 (2x requests_per_second)
     #[serde(default = "default_burst")]
     pub burst: u32,
-    /// Time window in seconds
+    /// Time window in seconds. Not used for enforcement since the token bucket needs none;
+    /// accepted for compatibility
     /// Default: 1
     #[serde(default = "default_window_seconds")]
     pub window_seconds: u64,
@@ -343,6 +350,14 @@ pub enum LimitBy {
     /// Rate limit by combination of IP and route
     /// Provides per-IP limits that are also route-specific
     Combined,
+    /// Rate limit by the connection's JA4 TLS fingerprint
+    /// Every client presenting the same ClientHello shares one limit (throttles bot farms
+    /// rotating IPs); connections without a fingerprint are limited by IP
+    Ja4,
+    /// Rate limit by combination of JA4 and client IP
+    /// Connections without a fingerprint are limited by IP
+    #[serde(rename = "ja4_ip")]
+    Ja4Ip,
 }
 
 fn default_requests_per_second() -> u32 {
@@ -517,12 +532,15 @@ impl IpFilterMode {
 }
 
 impl LimitBy {
-    fn as_str(self) -> &'static str {
+    /// Config spelling, also the `strategy` metric label.
+    pub fn as_str(self) -> &'static str {
         match self {
             LimitBy::Ip => "ip",
             LimitBy::Header => "header",
             LimitBy::Route => "route",
             LimitBy::Combined => "combined",
+            LimitBy::Ja4 => "ja4",
+            LimitBy::Ja4Ip => "ja4_ip",
         }
     }
 }
@@ -4,8 +4,13 @@ use std::path::Path;
 
 use crate::config::audit;
 use crate::config::parser::ConfigFormat;
-use crate::config::Config;
+use crate::config::{
+    AcceptConfig, AcceptMode, AdaptiveConcurrencyConfig, CacheConfig, Config, DebugConfig,
+    FingerprintExportConfig, RateLimitClusterConfig, TimingConfig, TlsConfig,
+};
 use crate::error::{ProxyError, Result};
+use crate::proxy::cache::SHARDS;
+use crate::security::rate_limit::MIN_SECRET_LEN;
 
 pub fn load_from_path<P: AsRef<Path>>(p: P) -> Result<Config> {
     let path = p.as_ref();
@@ -89,7 +94,156 @@ fn validate_config(cfg: &Config) -> Result<()> {
         }
     }
 
+    validate_accept(&cfg.listen.accept)?;
+    validate_session_resumption(cfg.tls.as_ref())?;
+    validate_rate_limit_cluster(&cfg.security.rate_limit_cluster)?;
+    validate_adaptive_concurrency(&cfg.admission.adaptive_concurrency)?;
+    validate_cache(&cfg.cache)?;
+    validate_timing(&cfg.telemetry.timing)?;
+    validate_debug(&cfg.telemetry.debug)?;
+    validate_fingerprint_export(&cfg.telemetry.fingerprint_export)?;
     cfg.validate_cross_refs()?;
 
     Ok(())
 }
+
+fn validate_accept(accept: &AcceptConfig) -> Result<()> {
+    if accept.cpu_steering && accept.mode == AcceptMode::Single {
+        return Err(ProxyError::Config(
+            "listen.accept.cpu_steering requires mode = \"reuse_port\" or \"thread_per_core\""
+                .to_string(),
+        ));
+    }
+    if accept.mode != AcceptMode::Single && !cfg!(target_os = "linux") {
+        return Err(ProxyError::Config(format!(
+            "listen.accept.mode = \"{}\" is only supported on Linux",
+            accept.mode.as_str()
+        )));
+    }
+    Ok(())
+}
+
+fn validate_session_resumption(tls: Option<&TlsConfig>) -> Result<()> {
+    let Some(resumption) = tls.map(|tls| &tls.session_resumption) else {
+        return Ok(());
+    };
+    // Sessions are sealed with the shared ticket keys before they are written to memcached.
+    if resumption.enabled
+        && resumption.shared_cache.is_some()
+        && resumption.ticket_keys_path.is_none()
+    {
+        return Err(ProxyError::Config(
+            "tls.session_resumption.shared_cache requires ticket_keys_path".to_string(),
+        ));
+    }
+    Ok(())
+}
+
+fn validate_adaptive_concurrency(adaptive: &AdaptiveConcurrencyConfig) -> Result<()> {
+    if !adaptive.enabled {
+        return Ok(());
+    }
+    if adaptive.min_limit == 0
+        || adaptive.min_limit > adaptive.initial_limit
+        || adaptive.initial_limit > adaptive.max_limit
+    {
+        return Err(ProxyError::Config(format!(
+            "admission.adaptive_concurrency limits must satisfy 0 < min_limit <= initial_limit \
+             <= max_limit (got {} / {} / {})",
+            adaptive.min_limit, adaptive.initial_limit, adaptive.max_limit
+        )));
+    }
+    if adaptive.latency_tolerance.is_nan() || adaptive.latency_tolerance <= 1.0 {
+        return Err(ProxyError::Config(
+            "admission.adaptive_concurrency.latency_tolerance must be greater than 1.0".to_string(),
+        ));
+    }
+    if !(adaptive.backoff_ratio > 0.0 && adaptive.backoff_ratio < 1.0) {
+        return Err(ProxyError::Config(
+            "admission.adaptive_concurrency.backoff_ratio must be between 0.0 and 1.0 (exclusive)"
+                .to_string(),
+        ));
+    }
+    Ok(())
+}
+
+fn validate_cache(cache: &CacheConfig) -> Result<()> {
+    if cache.max_size_bytes == 0 {
+        return Ok(());
+    }
+    // An object must fit in the one shard its key maps to.
+    let shard_bytes = cache.max_size_bytes / SHARDS as u64;
+    if cache.max_object_bytes == 0 || cache.max_object_bytes > shard_bytes {
+        return Err(ProxyError::Config(format!(
+            "cache.max_object_bytes must be between 1 and max_size_bytes / {SHARDS} ({shard_bytes})"
+        )));
+    }
+    Ok(())
+}
+
+fn validate_timing(timing: &TimingConfig) -> Result<()> {
+    if timing.slow_request_sample == 0 {
+        return Err(ProxyError::Config(
+            "telemetry.timing.slow_request_sample must be at least 1".to_string(),
+        ));
+    }
+    Ok(())
+}
+
+fn validate_debug(debug: &DebugConfig) -> Result<()> {
+    if !debug.enabled {
+        return Ok(());
+    }
+    if debug.token.expose().len() < MIN_SECRET_LEN {
+        return Err(ProxyError::Config(format!(
+            "telemetry.debug.token must be at least {MIN_SECRET_LEN} bytes"
+        )));
+    }
+    if debug.max_window_seconds == 0 {
+        return Err(ProxyError::Config(
+            "telemetry.debug.max_window_seconds must be at least 1".to_string(),
+        ));
+    }
+    Ok(())
+}
+
+fn validate_fingerprint_export(export: &FingerprintExportConfig) -> Result<()> {
+    if !export.enabled {
+        return Ok(());
+    }
+    if export.path.is_some() == export.endpoint.is_some() {
+        return Err(ProxyError::Config(
+            "telemetry.fingerprint_export needs exactly one of path or endpoint".to_string(),
+        ));
+    }
+    if export.queue_capacity == 0 || export.batch_size == 0 || export.flush_interval_ms == 0 {
+        return Err(ProxyError::Config(
+            "telemetry.fingerprint_export queue_capacity, batch_size and flush_interval_ms must \
+             be at least 1"
+                .to_string(),
+        ));
+    }
+    Ok(())
+}
+
+fn validate_rate_limit_cluster(cluster: &RateLimitClusterConfig) -> Result<()> {
+    if !cluster.enabled {
+        return Ok(());
+    }
+    if cluster.secret.expose().len() < MIN_SECRET_LEN {
+        return Err(ProxyError::Config(format!(
+            "security.rate_limit_cluster.secret must be at least {MIN_SECRET_LEN} bytes"
+        )));
+    }
+    if cluster.peers.is_empty() {
+        return Err(ProxyError::Config(
+            "security.rate_limit_cluster.enabled requires at least one peer".to_string(),
+        ));
+    }
+    if cluster.sync_interval_ms == 0 {
+        return Err(ProxyError::Config(
+            "security.rate_limit_cluster.sync_interval_ms must be greater than 0".to_string(),
+        ));
+    }
+    Ok(())
+}
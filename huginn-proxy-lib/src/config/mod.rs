@@ -20,8 +20,9 @@ pub use dynamic::security::{
 };
 pub use dynamic::{
     sort_domain_routes, sort_routes, Backend, BackendHttpVersion, BackendPoolConfig, CustomHeader,
-    Domain, DynamicConfig, HeaderManipulation, HeaderManipulationGroup, HealthCheckConfig,
-    HealthCheckType, Route, DEFAULT_DOMAIN_LABEL, DEFAULT_FINGERPRINTING,
+    Domain, DynamicConfig, HashKey, HeaderManipulation, HeaderManipulationGroup, HealthCheckConfig,
+    HealthCheckType, LoadBalance, PrewarmConfig, Route, RouteCacheConfig, RouteCoalesceConfig,
+    DEFAULT_DOMAIN_LABEL, DEFAULT_FINGERPRINTING,
 };
 pub use effective::{EffectiveConfigSummary, EffectiveConfigView};
 pub use loader::load_from_path;
@@ -29,7 +30,9 @@ pub use parser::{ConfigFormat, ConfigParser, TomlParser, YamlParser};
 pub use root::{Config, ConfigParts};
 pub use secret::Secret;
 pub use startup::{
-    ClientAuth, FingerprintConfig, KeepAliveConfig, ListenConfig, LoggingConfig,
-    ProxyProtocolConfig, ProxyProtocolMode, ReloadConfig, SessionResumptionConfig, StaticConfig,
-    TelemetryConfig, TimeoutConfig, TlsConfig, TlsOptions, TlsVersion,
+    AcceptConfig, AcceptMode, AdaptiveConcurrencyConfig, AdmissionConfig, CacheConfig, ClientAuth,
+    DebugConfig, FingerprintConfig, FingerprintExportConfig, KeepAliveConfig, ListenConfig,
+    LoggingConfig, ProxyProtocolConfig, ProxyProtocolMode, RateLimitClusterConfig, ReloadConfig,
+    SessionResumptionConfig, SharedSessionCacheConfig, StaticConfig, TelemetryConfig,
+    TimeoutConfig, TimingConfig, TlsConfig, TlsOptions, TlsVersion,
 };
@@ -1,12 +1,14 @@
-use std::collections::HashSet;
+use std::collections::{HashMap, HashSet};
 use std::sync::Arc;
 
 use serde::Deserialize;
 
-use super::dynamic::backend::{Backend, BackendPoolConfig, Domain};
+use super::dynamic::backend::{Backend, BackendPoolConfig, Domain, LoadBalance};
 use super::dynamic::headers::HeaderManipulation;
 use super::dynamic::security::{SecurityConfig, SecurityDynamicConfig};
 use super::dynamic::DynamicConfig;
+use super::startup::admission::AdmissionConfig;
+use super::startup::cache::CacheConfig;
 use super::startup::fingerprinting::FingerprintConfig;
 use super::startup::listen::ListenConfig;
 use super::startup::reload::ReloadConfig;
@@ -14,6 +16,8 @@ use super::startup::telemetry::{LoggingConfig, TelemetryConfig};
 use super::startup::timeout::TimeoutConfig;
 use super::startup::tls::TlsConfig;
 use super::startup::StaticConfig;
+use crate::proxy::router::RoutingTable;
+use crate::security::IpFilterIndex;
 
 /// Main configuration structure, the TOML deserialization target.
 #[derive(Debug, Deserialize, Clone)]
@@ -66,6 +70,13 @@ pub struct Config {
     /// Controls idle timeout and max idle connections per host
     #[serde(default)]
     pub backend_pool: BackendPoolConfig,
+    /// Load shedding: per-IP connection caps, scheduler-lag admission and adaptive concurrency
+    /// limits
+    #[serde(default)]
+    pub admission: AdmissionConfig,
+    /// Response cache store shared by the routes that enable `cache`
+    #[serde(default)]
+    pub cache: CacheConfig,
 }
 
 /// Config split into its static and dynamic halves.
@@ -84,7 +95,21 @@ impl Config {
             self.backends.iter().map(|b| b.address.as_str()).collect();
 
         for domain in &self.domains {
+            let mut group_strategy: HashMap<&str, LoadBalance> = HashMap::new();
             for route in &domain.routes {
+                let strategy = *group_strategy
+                    .entry(route.prefix.as_str())
+                    .or_insert(route.load_balance);
+                if strategy != route.load_balance {
+                    return Err(crate::error::ProxyError::Config(format!(
+                        "Domain '{}' routes with prefix '{}' disagree on load_balance \
+                         ('{}' vs '{}'); set the same value on every route of the group",
+                        domain.label(),
+                        route.prefix,
+                        strategy.as_str(),
+                        route.load_balance.as_str()
+                    )));
+                }
                 if !backend_addrs.contains(route.backend.as_str()) {
                     return Err(crate::error::ProxyError::Config(format!(
                         "Domain '{}' route '{}' references unknown backend '{}' (known: [{}])",
@@ -110,8 +135,13 @@ impl Config {
     ///   logging, timeouts, `max_connections`). Changing these requires a restart.
     /// - `DynamicConfig` holds hot-reloadable settings (domains, backends, headers,
     ///   security policy). Wrap the returned value in `ArcSwap` to support
-    ///   atomic hot-swaps at runtime.
+    ///   atomic hot-swaps at runtime. Its routing table and IP filter index are compiled here,
+    ///   once per snapshot.
     pub fn into_parts(self) -> ConfigParts {
+        let mut domains = self.domains;
+        super::sort_domain_routes(&mut domains);
+        let domains = Arc::new(domains);
+        let ip_filters = Arc::new(IpFilterIndex::new(&self.security.ip_filter, &domains));
         ConfigParts {
             static_cfg: StaticConfig {
                 listen: self.listen,
@@ -122,22 +152,26 @@ impl Config {
                 telemetry: self.telemetry,
                 reload: self.reload,
                 max_connections: self.security.max_connections,
+                rate_limit_cluster: self.security.rate_limit_cluster,
+                admission: self.admission,
+                cache: self.cache,
             },
             dynamic_cfg: DynamicConfig {
+                routing: Arc::new(RoutingTable::with_backends(
+                    Arc::clone(&domains),
+                    &self.backends,
+                )),
                 backends: Arc::new(self.backends),
-                domains: {
-                    let mut domains = self.domains;
-                    super::sort_domain_routes(&mut domains);
-                    Arc::new(domains)
-                },
+                domains,
                 preserve_host: self.preserve_host,
                 headers: self.headers,
                 security: SecurityDynamicConfig {
                     headers: self.security.headers,
-                    ip_filter: self.security.ip_filter,
+                    ip_filter: Arc::new(self.security.ip_filter),
                     rate_limit: self.security.rate_limit,
                     trusted_proxies: self.security.trusted_proxies,
                 },
+                ip_filters,
                 backend_pool: self.backend_pool,
             },
         }
@@ -0,0 +1,142 @@
+use serde::{Deserialize, Serialize};
+
+/// Load shedding (`[admission]`).
+///
+/// Static: the per-IP table and scheduler-lag probes are set up once at startup, and the adaptive
+/// limits keep their learned state across config reloads. Everything is off by default.
+#[derive(Debug, Deserialize, Clone, PartialEq)]
+#[serde(deny_unknown_fields)]
+pub struct AdmissionConfig {
+    /// Concurrent connections a single client IP may hold, counted against the address resolved
+    /// from the PROXY protocol header when one is accepted. `0` = unlimited. Default `0`.
+    #[serde(default)]
+    pub max_connections_per_ip: u32,
+    /// Refuse new connections while the async runtime polls timers this many milliseconds late,
+    /// i.e. before it is too saturated to serve the connections it already holds. `0` = off.
+    /// Default `0`.
+    #[serde(default)]
+    pub max_scheduler_lag_ms: u64,
+    /// `Retry-After` (seconds) of the 503 sent for requests shed by an adaptive limit. Default `1`.
+    #[serde(default = "default_retry_after_secs")]
+    pub retry_after_secs: u64,
+    /// Per-route and per-backend concurrency limits adapted to observed backend latency.
+    #[serde(default)]
+    pub adaptive_concurrency: AdaptiveConcurrencyConfig,
+}
+
+impl Default for AdmissionConfig {
+    fn default() -> Self {
+        Self {
+            max_connections_per_ip: 0,
+            max_scheduler_lag_ms: 0,
+            retry_after_secs: default_retry_after_secs(),
+            adaptive_concurrency: AdaptiveConcurrencyConfig::default(),
+        }
+    }
+}
+
+/// AIMD concurrency limits (`[admission.adaptive_concurrency]`).
+///
+/// Every route and every backend address gets its own limit on requests awaiting backend
+/// response headers. A request over either limit is answered 503 without reaching the backend.
+/// Each response within `latency_tolerance` × the lowest recent latency grows the limit by
+/// `1 / limit`; a slower response, a backend error or a 502/503/504 multiplies it by
+/// `backoff_ratio`, at most once per round trip.
+#[derive(Debug, Deserialize, Clone, PartialEq)]
+#[serde(deny_unknown_fields)]
+pub struct AdaptiveConcurrencyConfig {
+    /// Enable adaptive limits. Default `false`.
+    #[serde(default)]
+    pub enabled: bool,
+    /// Limit a route or backend starts with. Default `20`.
+    #[serde(default = "default_initial_limit")]
+    pub initial_limit: u32,
+    /// Floor the limit never backs off below. Default `4`.
+    #[serde(default = "default_min_limit")]
+    pub min_limit: u32,
+    /// Ceiling the limit never grows past. Default `1000`.
+    #[serde(default = "default_max_limit")]
+    pub max_limit: u32,
+    /// Latency, as a multiple of the lowest recent latency, above which a response counts as
+    /// congestion. Greater than `1.0`. Default `2.0`.
+    #[serde(default = "default_latency_tolerance")]
+    pub latency_tolerance: f64,
+    /// Factor applied to the limit on congestion, in `(0.0, 1.0)`. Default `0.9`.
+    #[serde(default = "default_backoff_ratio")]
+    pub backoff_ratio: f64,
+}
+
+impl Default for AdaptiveConcurrencyConfig {
+    fn default() -> Self {
+        Self {
+            enabled: false,
+            initial_limit: default_initial_limit(),
+            min_limit: default_min_limit(),
+            max_limit: default_max_limit(),
+            latency_tolerance: default_latency_tolerance(),
+            backoff_ratio: default_backoff_ratio(),
+        }
+    }
+}
+
+fn default_retry_after_secs() -> u64 {
+    1
+}
+
+fn default_initial_limit() -> u32 {
+    20
+}
+
+fn default_min_limit() -> u32 {
+    4
+}
+
+fn default_max_limit() -> u32 {
+    1000
+}
+
+fn default_latency_tolerance() -> f64 {
+    2.0
+}
+
+fn default_backoff_ratio() -> f64 {
+    0.9
+}
+
+/// Allowlisted effective-config view of [`AdmissionConfig`]. Field names are the JSON keys.
+#[derive(Serialize)]
+pub(crate) struct AdmissionView {
+    max_connections_per_ip: u32,
+    max_scheduler_lag_ms: u64,
+    retry_after_secs: u64,
+    adaptive_concurrency: AdaptiveConcurrencyView,
+}
+
+#[derive(Serialize)]
+pub(crate) struct AdaptiveConcurrencyView {
+    enabled: bool,
+    initial_limit: u32,
+    min_limit: u32,
+    max_limit: u32,
+    latency_tolerance: f64,
+    backoff_ratio: f64,
+}
+
+impl AdmissionConfig {
+    pub(crate) fn effective_view(&self) -> AdmissionView {
+        let adaptive = &self.adaptive_concurrency;
+        AdmissionView {
+            max_connections_per_ip: self.max_connections_per_ip,
+            max_scheduler_lag_ms: self.max_scheduler_lag_ms,
+            retry_after_secs: self.retry_after_secs,
+            adaptive_concurrency: AdaptiveConcurrencyView {
+                enabled: adaptive.enabled,
+                initial_limit: adaptive.initial_limit,
+                min_limit: adaptive.min_limit,
+                max_limit: adaptive.max_limit,
+                latency_tolerance: adaptive.latency_tolerance,
+                backoff_ratio: adaptive.backoff_ratio,
+            },
+        }
+    }
+}
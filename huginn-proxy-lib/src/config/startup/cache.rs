@@ -0,0 +1,49 @@
+use serde::{Deserialize, Serialize};
+
+/// Response cache store (`[cache]`).
+///
+/// Static: the store is sized once at startup and its entries survive config reloads. Caching
+/// itself is opt-in per route (`[domains.routes.cache]`); without such a route the store stays
+/// empty.
+#[derive(Debug, Deserialize, Clone, PartialEq, Eq)]
+#[serde(deny_unknown_fields)]
+pub struct CacheConfig {
+    /// Memory bound of all cached responses (bodies, headers and keys), in bytes. `0` disables
+    /// caching for every route. Default `67108864` (64 MiB).
+    #[serde(default = "default_max_size_bytes")]
+    pub max_size_bytes: u64,
+    /// Largest response body stored, in bytes. At most `max_size_bytes / 16` (the store is split
+    /// into 16 shards). Default `1048576` (1 MiB).
+    #[serde(default = "default_max_object_bytes")]
+    pub max_object_bytes: u64,
+}
+
+impl Default for CacheConfig {
+    fn default() -> Self {
+        Self {
+            max_size_bytes: default_max_size_bytes(),
+            max_object_bytes: default_max_object_bytes(),
+        }
+    }
+}
+
+fn default_max_size_bytes() -> u64 {
+    64 * 1024 * 1024
+}
+
+fn default_max_object_bytes() -> u64 {
+    1024 * 1024
+}
+
+/// Allowlisted effective-config view of [`CacheConfig`]. Field names are the JSON keys.
+#[derive(Serialize)]
+pub(crate) struct CacheView {
+    max_size_bytes: u64,
+    max_object_bytes: u64,
+}
+
+impl CacheConfig {
+    pub(crate) fn effective_view(&self) -> CacheView {
+        CacheView { max_size_bytes: self.max_size_bytes, max_object_bytes: self.max_object_bytes }
+    }
+}
@@ -51,6 +51,42 @@ impl Default for ProxyProtocolConfig {
     }
 }
 
+/// How accepted connections are spread over threads.
+#[derive(Debug, Deserialize, Clone, Copy, PartialEq, Eq, Default)]
+#[serde(rename_all = "snake_case")]
+pub enum AcceptMode {
+    /// One socket per address and one accept task; connections are spawned on whichever worker
+    /// runs it (today's behavior).
+    #[default]
+    Single,
+    /// `shards` `SO_REUSEPORT` sockets per address, each with its own accept task on the shared
+    /// runtime. The kernel spreads connections over the sockets, and each connection task starts
+    /// on the worker that accepted it (tokio may still move it when another worker is idle).
+    ReusePort,
+    /// Like `reuse_port`, but each shard runs on its own thread pinned to one CPU, with a
+    /// single-threaded runtime: a connection never leaves the thread that accepted it. Linux only.
+    ThreadPerCore,
+}
+
+/// Accept sharding for the listen addresses. Static (restart to apply).
+#[derive(Debug, Deserialize, Clone, Copy, PartialEq, Eq, Default)]
+#[serde(deny_unknown_fields)]
+pub struct AcceptConfig {
+    /// Default: single.
+    #[serde(default)]
+    pub mode: AcceptMode,
+    /// Sockets per listen address in the sharded modes. `0` uses one per runtime worker
+    /// (`reuse_port`) or per available CPU (`thread_per_core`). Default: 0.
+    #[serde(default)]
+    pub shards: usize,
+    /// Attach a classic BPF program (`SO_ATTACH_REUSEPORT_CBPF`) that picks the socket by the CPU
+    /// that received the SYN (`cpu % shards`), instead of the kernel's 4-tuple hash. With
+    /// `thread_per_core` and one shard per CPU, a connection is served on the CPU where its packets
+    /// are already processed. Requires a sharded mode; Linux only. Default: false.
+    #[serde(default)]
+    pub cpu_steering: bool,
+}
+
 /// Listener configuration, addresses and kernel socket options.
 #[derive(Debug, Deserialize, Clone, PartialEq)]
 #[serde(deny_unknown_fields)]
@@ -79,6 +115,9 @@ pub struct ListenConfig {
     /// [`ProxyProtocolConfig`].
     #[serde(default)]
     pub proxy_protocol: ProxyProtocolConfig,
+    /// Accept sharding (`SO_REUSEPORT`). See [`AcceptConfig`].
+    #[serde(default)]
+    pub accept: AcceptConfig,
 }
 
 impl Default for ListenConfig {
@@ -87,6 +126,7 @@ impl Default for ListenConfig {
             addrs: vec![],
             tcp_backlog: default_tcp_backlog(),
             proxy_protocol: ProxyProtocolConfig::default(),
+            accept: AcceptConfig::default(),
         }
     }
 }
@@ -132,6 +172,14 @@ pub(crate) struct ListenView {
     addrs: Vec<String>,
     tcp_backlog: i32,
     proxy_protocol: ProxyProtocolView,
+    accept: AcceptView,
+}
+
+#[derive(Serialize)]
+struct AcceptView {
+    mode: &'static str,
+    shards: usize,
+    cpu_steering: bool,
 }
 
 #[derive(Serialize)]
@@ -149,6 +197,11 @@ impl ListenConfig {
                 mode: self.proxy_protocol.mode.as_str(),
                 header_timeout_ms: self.proxy_protocol.header_timeout_ms,
             },
+            accept: AcceptView {
+                mode: self.accept.mode.as_str(),
+                shards: self.accept.shards,
+                cpu_steering: self.accept.cpu_steering,
+            },
         }
     }
 }
@@ -162,3 +215,13 @@ impl ProxyProtocolMode {
         }
     }
 }
+
+impl AcceptMode {
+    pub(crate) fn as_str(self) -> &'static str {
+        match self {
+            AcceptMode::Single => "single",
+            AcceptMode::ReusePort => "reuse_port",
+            AcceptMode::ThreadPerCore => "thread_per_core",
+        }
+    }
+}
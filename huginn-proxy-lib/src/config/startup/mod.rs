@@ -1,5 +1,8 @@
+pub mod admission;
+pub mod cache;
 pub mod fingerprinting;
 pub mod listen;
+pub mod rate_limit_cluster;
 pub mod reload;
 pub mod telemetry;
 pub mod timeout;
@@ -7,15 +10,26 @@ pub mod tls;
 
 use serde::Serialize;
 
+pub use admission::{AdaptiveConcurrencyConfig, AdmissionConfig};
+pub use cache::CacheConfig;
 pub use fingerprinting::FingerprintConfig;
-pub use listen::{ListenConfig, ProxyProtocolConfig, ProxyProtocolMode};
+pub use listen::{AcceptConfig, AcceptMode, ListenConfig, ProxyProtocolConfig, ProxyProtocolMode};
+pub use rate_limit_cluster::RateLimitClusterConfig;
 pub use reload::ReloadConfig;
-pub use telemetry::{LoggingConfig, TelemetryConfig};
+pub use telemetry::{
+    DebugConfig, FingerprintExportConfig, LoggingConfig, TelemetryConfig, TimingConfig,
+};
 pub use timeout::{KeepAliveConfig, TimeoutConfig};
-pub use tls::{ClientAuth, SessionResumptionConfig, TlsConfig, TlsOptions, TlsVersion};
+pub use tls::{
+    ClientAuth, SessionResumptionConfig, SharedSessionCacheConfig, TlsConfig, TlsOptions,
+    TlsVersion,
+};
 
+use admission::AdmissionView;
+use cache::CacheView;
 use fingerprinting::FingerprintView;
 use listen::ListenView;
+use rate_limit_cluster::RateLimitClusterView;
 use reload::ReloadView;
 use telemetry::{LoggingView, TelemetryView};
 use timeout::TimeoutView;
@@ -44,6 +58,12 @@ pub struct StaticConfig {
     pub reload: ReloadConfig,
     /// Maximum concurrent connections (from \[security\] in TOML)
     pub max_connections: usize,
+    /// Cluster-wide rate limiting (`[security.rate_limit_cluster]` in TOML)
+    pub rate_limit_cluster: RateLimitClusterConfig,
+    /// Load shedding and adaptive concurrency (`[admission]` in TOML)
+    pub admission: AdmissionConfig,
+    /// Response cache store (`[cache]` in TOML)
+    pub cache: CacheConfig,
 }
 
 /// Allowlisted effective-config view of [`StaticConfig`]. Each section mirrors one config type;
@@ -58,6 +78,9 @@ pub(crate) struct StaticView<'a> {
     telemetry: TelemetryView<'a>,
     reload: ReloadView,
     max_connections: usize,
+    rate_limit_cluster: RateLimitClusterView<'a>,
+    admission: AdmissionView,
+    cache: CacheView,
 }
 
 impl StaticConfig {
@@ -71,6 +94,9 @@ impl StaticConfig {
             telemetry: self.telemetry.effective_view(),
             reload: self.reload.effective_view(),
             max_connections: self.max_connections,
+            rate_limit_cluster: self.rate_limit_cluster.effective_view(),
+            admission: self.admission.effective_view(),
+            cache: self.cache.effective_view(),
         }
     }
 }
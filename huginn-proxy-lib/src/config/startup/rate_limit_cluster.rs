@@ -0,0 +1,75 @@
+use std::net::{Ipv4Addr, SocketAddr};
+
+use serde::{Deserialize, Serialize};
+
+use crate::config::Secret;
+
+/// Cluster-wide rate limiting (`[security.rate_limit_cluster]`).
+///
+/// Static: the sync socket is bound and the peers resolved once at startup (changing it requires a
+/// restart). Every node enforces rate limits from its own buckets and every few milliseconds pushes
+/// the requests it admitted per key to its peers, which debit them from their buckets. The
+/// configured `rate_limit` blocks then describe the budget of the whole cluster.
+#[derive(Debug, Deserialize, Clone, PartialEq)]
+#[serde(deny_unknown_fields)]
+pub struct RateLimitClusterConfig {
+    /// Share rate-limit consumption with `peers`. Default `false`.
+    #[serde(default)]
+    pub enabled: bool,
+    /// UDP address the node receives peer updates on. Default `0.0.0.0:7420`.
+    #[serde(default = "default_bind")]
+    pub bind: SocketAddr,
+    /// Sync addresses (`host:port`) of the other nodes. Listing the node itself is harmless: its
+    /// own updates are recognised and ignored.
+    #[serde(default)]
+    pub peers: Vec<String>,
+    /// How often admitted requests are pushed to peers, in milliseconds. Default `10`.
+    #[serde(default = "default_sync_interval_ms")]
+    pub sync_interval_ms: u64,
+    /// Secret shared by every node: authenticates updates and seeds key hashing, so all nodes
+    /// agree on which bucket a client maps to. At least 16 bytes.
+    #[serde(default)]
+    pub secret: Secret<String>,
+}
+
+fn default_bind() -> SocketAddr {
+    SocketAddr::from((Ipv4Addr::UNSPECIFIED, 7420))
+}
+
+fn default_sync_interval_ms() -> u64 {
+    10
+}
+
+impl Default for RateLimitClusterConfig {
+    fn default() -> Self {
+        Self {
+            enabled: false,
+            bind: default_bind(),
+            peers: Vec::new(),
+            sync_interval_ms: default_sync_interval_ms(),
+            secret: Secret::default(),
+        }
+    }
+}
+
+/// Allowlisted effective-config view of [`RateLimitClusterConfig`]. The secret is redacted.
+#[derive(Serialize)]
+pub(crate) struct RateLimitClusterView<'a> {
+    enabled: bool,
+    bind: String,
+    peers: &'a [String],
+    sync_interval_ms: u64,
+    secret: &'a Secret<String>,
+}
+
+impl RateLimitClusterConfig {
+    pub(crate) fn effective_view(&self) -> RateLimitClusterView<'_> {
+        RateLimitClusterView {
+            enabled: self.enabled,
+            bind: self.bind.to_string(),
+            peers: &self.peers,
+            sync_interval_ms: self.sync_interval_ms,
+            secret: &self.secret,
+        }
+    }
+}
@@ -1,5 +1,11 @@
+use std::path::PathBuf;
+
+use ipnet::IpNet;
 use serde::{Deserialize, Serialize};
 
+use crate::config::dynamic::security::deserialize_ip_networks;
+use crate::config::Secret;
+
 /// Telemetry configuration
 /// Controls observability features: metrics, tracing, and OpenTelemetry integration
 #[derive(Debug, Deserialize, Clone, Default, PartialEq)]
@@ -18,6 +24,138 @@ pub struct TelemetryConfig {
     /// Default: "warn" (suppress informational logs from OpenTelemetry SDK)
     #[serde(default = "default_otel_log_level")]
     pub otel_log_level: String,
+    /// Per-phase request latency breakdown (`[telemetry.timing]`)
+    #[serde(default)]
+    pub timing: TimingConfig,
+    /// Profiling and runtime introspection endpoints (`[telemetry.debug]`)
+    #[serde(default)]
+    pub debug: DebugConfig,
+    /// Batched export of connection fingerprints (`[telemetry.fingerprint_export]`)
+    #[serde(default)]
+    pub fingerprint_export: FingerprintExportConfig,
+}
+
+/// Per-phase latency breakdown (`[telemetry.timing]`).
+///
+/// Phase durations are always recorded in `huginn_phase_duration_seconds`; these settings only
+/// control where a single request's breakdown is exposed.
+#[derive(Debug, Deserialize, Clone, PartialEq, Eq)]
+#[serde(deny_unknown_fields)]
+pub struct TimingConfig {
+    /// Client CIDRs whose responses carry a `Server-Timing` header with the request's phases.
+    /// Matched against the resolved client IP. Empty (default) means never.
+    #[serde(default, deserialize_with = "deserialize_ip_networks")]
+    pub server_timing_cidrs: Vec<IpNet>,
+    /// Log the phase breakdown of requests slower than this, in milliseconds. `0` (default)
+    /// disables slow-request logging.
+    #[serde(default)]
+    pub slow_request_ms: u64,
+    /// Log one in every `slow_request_sample` slow requests. Must be at least 1. Default `1`.
+    #[serde(default = "default_slow_request_sample")]
+    pub slow_request_sample: u64,
+}
+
+impl Default for TimingConfig {
+    fn default() -> Self {
+        Self {
+            server_timing_cidrs: Vec::new(),
+            slow_request_ms: 0,
+            slow_request_sample: default_slow_request_sample(),
+        }
+    }
+}
+
+fn default_slow_request_sample() -> u64 {
+    1
+}
+
+/// Runtime introspection endpoints on the metrics server (`[telemetry.debug]`).
+///
+/// Served under `/debug/` on `metrics_port`, to requests with `Authorization: Bearer <token>`.
+#[derive(Debug, Deserialize, Clone, PartialEq)]
+#[serde(deny_unknown_fields)]
+pub struct DebugConfig {
+    /// Serve the `/debug/` endpoints. Default `false`.
+    #[serde(default)]
+    pub enabled: bool,
+    /// Bearer token required by every `/debug/` request. At least 16 bytes when enabled.
+    #[serde(default)]
+    pub token: Secret<String>,
+    /// Longest runtime sampling window a request may ask for, in seconds.
+    /// Must be at least 1. Default `60`.
+    #[serde(default = "default_max_window_seconds")]
+    pub max_window_seconds: u64,
+}
+
+impl Default for DebugConfig {
+    fn default() -> Self {
+        Self {
+            enabled: false,
+            token: Secret::default(),
+            max_window_seconds: default_max_window_seconds(),
+        }
+    }
+}
+
+fn default_max_window_seconds() -> u64 {
+    60
+}
+
+/// Asynchronous export of connection fingerprints (`[telemetry.fingerprint_export]`).
+///
+/// Request handlers queue one record per connection (plus one per request that tried to spoof a
+/// fingerprint header) without blocking; a background task folds identical records seen within
+/// one flush interval into a single line and writes newline-delimited JSON to `path` or to a TCP
+/// collector at `endpoint`. Exactly one of the two must be set when enabled.
+#[derive(Debug, Deserialize, Clone, PartialEq, Eq)]
+#[serde(deny_unknown_fields)]
+pub struct FingerprintExportConfig {
+    /// Export fingerprint records. Default `false`.
+    #[serde(default)]
+    pub enabled: bool,
+    /// File the records are appended to, created if missing.
+    #[serde(default)]
+    pub path: Option<PathBuf>,
+    /// `host:port` of a collector reading newline-delimited JSON over TCP (e.g. a Vector or
+    /// Fluent Bit `socket` source forwarding to Kafka or OTLP). Reconnected on failure.
+    #[serde(default)]
+    pub endpoint: Option<String>,
+    /// Records the queue holds before new ones are dropped. Must be at least 1. Default `65536`.
+    #[serde(default = "default_export_queue_capacity")]
+    pub queue_capacity: usize,
+    /// Distinct records that trigger a write before the flush interval ends. Must be at least
+    /// 1. Default `1024`.
+    #[serde(default = "default_export_batch_size")]
+    pub batch_size: usize,
+    /// Longest time a record waits before it is written, in milliseconds; identical records
+    /// within one interval are written once with a count. Must be at least 1. Default `1000`.
+    #[serde(default = "default_export_flush_interval_ms")]
+    pub flush_interval_ms: u64,
+}
+
+impl Default for FingerprintExportConfig {
+    fn default() -> Self {
+        Self {
+            enabled: false,
+            path: None,
+            endpoint: None,
+            queue_capacity: default_export_queue_capacity(),
+            batch_size: default_export_batch_size(),
+            flush_interval_ms: default_export_flush_interval_ms(),
+        }
+    }
+}
+
+fn default_export_queue_capacity() -> usize {
+    65_536
+}
+
+fn default_export_batch_size() -> usize {
+    1_024
+}
+
+fn default_export_flush_interval_ms() -> u64 {
+    1_000
 }
 
 fn default_otel_log_level() -> String {
@@ -53,6 +191,36 @@ fn default_false() -> bool {
 pub(crate) struct TelemetryView<'a> {
     metrics_port: Option<u16>,
     otel_log_level: &'a str,
+    timing: TimingView,
+    debug: DebugView<'a>,
+    fingerprint_export: FingerprintExportView<'a>,
+}
+
+/// Allowlisted effective-config view of [`TimingConfig`]. Field names are the JSON keys.
+#[derive(Serialize)]
+pub(crate) struct TimingView {
+    server_timing_cidrs: Vec<String>,
+    slow_request_ms: u64,
+    slow_request_sample: u64,
+}
+
+/// Allowlisted effective-config view of [`DebugConfig`]. The token is redacted.
+#[derive(Serialize)]
+pub(crate) struct DebugView<'a> {
+    enabled: bool,
+    token: &'a Secret<String>,
+    max_window_seconds: u64,
+}
+
+/// Allowlisted effective-config view of [`FingerprintExportConfig`]. Field names are the JSON keys.
+#[derive(Serialize)]
+pub(crate) struct FingerprintExportView<'a> {
+    enabled: bool,
+    path: Option<&'a std::path::Path>,
+    endpoint: Option<&'a str>,
+    queue_capacity: usize,
+    batch_size: usize,
+    flush_interval_ms: u64,
 }
 
 /// Allowlisted effective-config view of [`LoggingConfig`]. Field names are the JSON keys.
@@ -67,6 +235,46 @@ impl TelemetryConfig {
         TelemetryView {
             metrics_port: self.metrics_port,
             otel_log_level: self.otel_log_level.as_str(),
+            timing: self.timing.effective_view(),
+            debug: self.debug.effective_view(),
+            fingerprint_export: self.fingerprint_export.effective_view(),
+        }
+    }
+}
+
+impl TimingConfig {
+    pub(crate) fn effective_view(&self) -> TimingView {
+        TimingView {
+            server_timing_cidrs: self
+                .server_timing_cidrs
+                .iter()
+                .map(ToString::to_string)
+                .collect(),
+            slow_request_ms: self.slow_request_ms,
+            slow_request_sample: self.slow_request_sample,
+        }
+    }
+}
+
+impl DebugConfig {
+    pub(crate) fn effective_view(&self) -> DebugView<'_> {
+        DebugView {
+            enabled: self.enabled,
+            token: &self.token,
+            max_window_seconds: self.max_window_seconds,
+        }
+    }
+}
+
+impl FingerprintExportConfig {
+    pub(crate) fn effective_view(&self) -> FingerprintExportView<'_> {
+        FingerprintExportView {
+            enabled: self.enabled,
+            path: self.path.as_deref(),
+            endpoint: self.endpoint.as_deref(),
+            queue_capacity: self.queue_capacity,
+            batch_size: self.batch_size,
+            flush_interval_ms: self.flush_interval_ms,
         }
     }
 }
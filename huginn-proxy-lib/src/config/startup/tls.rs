@@ -56,6 +56,15 @@ pub struct TlsOptions {
     /// Default: false (lenient, serve the default cert for unmatched SNI).
     #[serde(default)]
     pub sni_strict: bool,
+    /// Kernel TLS offload (Linux).
+    ///
+    /// When `true`, the session keys are handed to the kernel after the handshake, which then
+    /// encrypts and decrypts records (`setsockopt(TLS_TX/TLS_RX)`). Connections whose cipher
+    /// the kernel lacks, or any connection when the `tls` module is unavailable, stay on rustls.
+    ///
+    /// Default: false (records processed by rustls).
+    #[serde(default)]
+    pub ktls: bool,
 }
 
 impl Default for TlsOptions {
@@ -67,6 +76,7 @@ impl Default for TlsOptions {
             cipher_suites: default_cipher_suites(),
             curve_preferences: default_curve_preferences(),
             sni_strict: false,
+            ktls: false,
         }
     }
 }
@@ -128,14 +138,52 @@ pub struct SessionResumptionConfig {
     /// TLS 1.3 uses stateless session tickets and doesn't use this cache
     #[serde(default = "default_session_cache_size")]
     pub max_sessions: usize,
+    /// File with the session ticket keys shared by every replica (default: none)
+    /// One hex-encoded 32-byte key per line; `#` starts a comment. The first key encrypts new
+    /// tickets, every key decrypts (see SETTINGS.md for rotation). Re-read on hot reload.
+    /// When unset, rustls' per-process ticketer is used and tickets only resume on this replica
+    #[serde(default)]
+    pub ticket_keys_path: Option<String>,
+    /// Lifetime hint sent with tickets from `ticket_keys_path`, in seconds (default: 21600)
+    #[serde(default = "default_ticket_lifetime_secs")]
+    pub ticket_lifetime_secs: u32,
+    /// Session cache shared across replicas for TLS 1.2 session ID resumption (default: none)
+    /// Sessions are kept in the local `max_sessions` cache and mirrored to the shared backend
+    #[serde(default)]
+    pub shared_cache: Option<SharedSessionCacheConfig>,
 }
 
 impl Default for SessionResumptionConfig {
     fn default() -> Self {
-        Self { enabled: default_true(), max_sessions: default_session_cache_size() }
+        Self {
+            enabled: default_true(),
+            max_sessions: default_session_cache_size(),
+            ticket_keys_path: None,
+            ticket_lifetime_secs: default_ticket_lifetime_secs(),
+            shared_cache: None,
+        }
     }
 }
 
+/// Memcached backend of the shared TLS session cache
+#[derive(Debug, Deserialize, Clone, PartialEq)]
+#[cfg_attr(test, derive(serde::Serialize))]
+#[serde(deny_unknown_fields)]
+pub struct SharedSessionCacheConfig {
+    /// Memcached server address (`host:port`), resolved at startup
+    pub memcached: String,
+    /// Timeout of a lookup before the handshake (connect and reply), in milliseconds (default: 10)
+    /// A slow or unreachable server counts as a cache miss
+    #[serde(default = "default_shared_cache_timeout_ms")]
+    pub timeout_ms: u64,
+    /// Expiry of stored sessions, in seconds (default: 3600)
+    #[serde(default = "default_shared_cache_ttl_secs")]
+    pub ttl_secs: u32,
+    /// Prefix of every key written to memcached (default: "huginn:tls:")
+    #[serde(default = "default_shared_cache_key_prefix")]
+    pub key_prefix: String,
+}
+
 fn default_true() -> bool {
     true
 }
@@ -144,6 +192,22 @@ fn default_session_cache_size() -> usize {
     256
 }
 
+fn default_ticket_lifetime_secs() -> u32 {
+    21_600
+}
+
+fn default_shared_cache_timeout_ms() -> u64 {
+    10
+}
+
+fn default_shared_cache_ttl_secs() -> u32 {
+    3600
+}
+
+fn default_shared_cache_key_prefix() -> String {
+    "huginn:tls:".to_string()
+}
+
 #[derive(Debug, Deserialize, Clone, PartialEq)]
 #[serde(deny_unknown_fields)]
 pub struct TlsConfig {
@@ -179,7 +243,7 @@ pub(crate) struct TlsEnabledView<'a> {
     alpn: &'a [String],
     options: TlsOptionsView<'a>,
     client_auth: ClientAuthView,
-    session_resumption: SessionResumptionView,
+    session_resumption: SessionResumptionView<'a>,
 }
 
 #[derive(Serialize)]
@@ -190,6 +254,7 @@ struct TlsOptionsView<'a> {
     cipher_suites: &'a [String],
     curve_preferences: &'a [String],
     sni_strict: bool,
+    ktls: bool,
 }
 
 #[derive(Serialize)]
@@ -200,9 +265,21 @@ struct ClientAuthView {
 }
 
 #[derive(Serialize)]
-struct SessionResumptionView {
+struct SessionResumptionView<'a> {
     enabled: bool,
     max_sessions: usize,
+    ticket_keys: &'static str,
+    ticket_lifetime_secs: u32,
+    shared_cache: Option<SharedSessionCacheView<'a>>,
+}
+
+#[derive(Serialize)]
+struct SharedSessionCacheView<'a> {
+    backend: &'static str,
+    address: &'a str,
+    timeout_ms: u64,
+    ttl_secs: u32,
+    key_prefix: &'a str,
 }
 
 /// Build the effective-config view for the optional TLS section.
@@ -235,11 +312,29 @@ pub(crate) fn effective_tls_view(config: Option<&TlsConfig>) -> TlsView<'_> {
             cipher_suites: config.options.cipher_suites.as_slice(),
             curve_preferences: config.options.curve_preferences.as_slice(),
             sni_strict: config.options.sni_strict,
+            ktls: config.options.ktls,
         },
         client_auth,
         session_resumption: SessionResumptionView {
             enabled: config.session_resumption.enabled,
             max_sessions: config.session_resumption.max_sessions,
+            ticket_keys: if config.session_resumption.ticket_keys_path.is_some() {
+                "shared_file"
+            } else {
+                "per_process"
+            },
+            ticket_lifetime_secs: config.session_resumption.ticket_lifetime_secs,
+            shared_cache: config
+                .session_resumption
+                .shared_cache
+                .as_ref()
+                .map(|cache| SharedSessionCacheView {
+                    backend: "memcached",
+                    address: &cache.memcached,
+                    timeout_ms: cache.timeout_ms,
+                    ttl_secs: cache.ttl_secs,
+                    key_prefix: &cache.key_prefix,
+                }),
         },
     })
 }
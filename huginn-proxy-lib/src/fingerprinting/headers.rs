@@ -1,3 +1,14 @@
+use std::fmt;
+
+use bytes::Bytes;
+use http::HeaderValue;
+
+/// Encode a fingerprint as a header value backed by its own `Bytes`, so that the clones
+/// injected into each request share one buffer. `None` if it is not a valid header value.
+pub fn encode_header_value(value: &impl fmt::Display) -> Option<HeaderValue> {
+    HeaderValue::from_maybe_shared(Bytes::from(value.to_string())).ok()
+}
+
 /// HTTP header names for fingerprint injection
 ///
 /// These constants define the header names used to inject fingerprints
@@ -1,170 +1,272 @@
 use std::pin::Pin;
-use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
 use std::sync::Arc;
 use std::task::{Context, Poll};
 
+use http::HeaderValue;
 use huginn_net_http::akamai_extractor::extract_akamai_fingerprint;
 use huginn_net_http::http2_parser::Http2Parser;
-use huginn_net_http::{AkamaiFingerprint, Http2FrameType, HuginnNetHttpError};
+use huginn_net_http::{AkamaiFingerprint, HuginnNetHttpError};
 use tokio::io::{AsyncRead, AsyncWrite, ReadBuf};
 use tokio::sync::watch;
 use tokio::time::Instant;
 use tracing::{debug, warn};
 
-/// CapturingStream captures all data read from the inner stream
-/// while passing it through. Processes fingerprint inline for optimal performance
+use super::headers::encode_header_value;
+
+const PREFACE: &[u8] = b"PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+/// HTTP/2 frame header: 3 length + 1 type + 1 flags + 4 stream id
+const FRAME_HEADER_LEN: usize = 9;
+
+const FRAME_HEADERS: u8 = 0x1;
+const FRAME_PRIORITY: u8 = 0x2;
+const FRAME_SETTINGS: u8 = 0x4;
+const FRAME_WINDOW_UPDATE: u8 = 0x8;
+const FRAME_CONTINUATION: u8 = 0x9;
+const FLAG_ACK: u8 = 0x1;
+const FLAG_END_HEADERS: u8 = 0x4;
+
+/// Akamai fingerprint published by [`CapturingStream`], with its `x-http2-akamai` value
+/// encoded once for every request on the connection.
+#[derive(Debug, Clone)]
+pub struct Http2Fingerprint {
+    pub akamai: AkamaiFingerprint,
+    pub header_value: Option<HeaderValue>,
+}
+
+impl Http2Fingerprint {
+    pub fn new(akamai: AkamaiFingerprint) -> Self {
+        let header_value = encode_header_value(&akamai.fingerprint);
+        Self { akamai, header_value }
+    }
+}
+
+/// CapturingStream watches the client's first HTTP/2 frames while passing all data through,
+/// and publishes the Akamai fingerprint as soon as the first header block is complete.
+///
+/// Only the frames the fingerprint is computed from (SETTINGS, WINDOW_UPDATE, PRIORITY and
+/// the first HEADERS block) are kept; everything else is skipped by its length. Once the
+/// fingerprint is extracted, or the connection turns out not to carry one within
+/// `max_capture` bytes, the capture state is freed and reads go straight to the inner stream.
 pub struct CapturingStream<S> {
     inner: S,
-    fingerprint_tx: watch::Sender<Option<AkamaiFingerprint>>,
-    fingerprint_extracted: Arc<AtomicBool>,
-    max_capture: usize,
-    captured_len: Arc<AtomicUsize>,
-    buffer: Vec<u8>, // Inline buffer for fast processing
-    parser: Http2Parser<'static>,
-    parsed_offset: usize,
-    // Track whether each required frame type has been seen across multiple reads.
-    // SETTINGS and HEADERS may arrive in different TCP segments, so we accumulate
-    // across reads and only extract when both are present in the full buffer.
-    seen_settings_frame: bool,
-    seen_headers_frame: bool,
-    extraction_start: Option<Instant>,
+    capture: Capture,
+}
+
+enum Capture {
+    Collecting(Box<Collector>),
+    Passthrough,
+}
+
+/// Outcome of feeding client bytes to a [`Collector`].
+enum Step {
+    NeedMore,
+    HeaderBlockComplete,
+    NotHttp2,
+    LimitReached,
+}
+
+struct Collector {
+    fingerprint_tx: watch::Sender<Option<Http2Fingerprint>>,
     metrics: Arc<crate::telemetry::Metrics>,
+    parser: Http2Parser<'static>,
+    started: Instant,
+    max_capture: usize,
+    /// Client bytes inspected so far, bounded by `max_capture`.
+    inspected: usize,
+    preface_matched: usize,
+    /// Header of the current frame; bytes past `header_len` are still to come.
+    header: [u8; FRAME_HEADER_LEN],
+    header_len: usize,
+    /// Payload bytes of the current frame still to come.
+    payload_left: usize,
+    /// Whether the current frame is appended to `frames`.
+    keep_frame: bool,
+    /// A HEADERS frame without END_HEADERS was kept; CONTINUATION frames complete it.
+    in_header_block: bool,
+    /// Raw frames (header and payload) the fingerprint is computed from.
+    frames: Vec<u8>,
 }
 
 impl<S> CapturingStream<S> {
     pub fn new(
         inner: S,
         max_capture: usize,
-        fingerprint_tx: watch::Sender<Option<AkamaiFingerprint>>,
+        fingerprint_tx: watch::Sender<Option<Http2Fingerprint>>,
         metrics: Arc<crate::telemetry::Metrics>,
-    ) -> (Self, Arc<AtomicBool>) {
-        let fingerprint_extracted = Arc::new(AtomicBool::new(false));
-        (
-            Self {
-                inner,
-                fingerprint_tx,
-                fingerprint_extracted: fingerprint_extracted.clone(),
-                max_capture,
-                captured_len: Arc::new(AtomicUsize::new(0)),
-                buffer: Vec::with_capacity(max_capture),
-                parser: Http2Parser::new(),
-                parsed_offset: 0,
-                seen_settings_frame: false,
-                seen_headers_frame: false,
-                extraction_start: Some(Instant::now()),
-                metrics,
-            },
-            fingerprint_extracted,
-        )
+    ) -> Self {
+        let collector = Collector {
+            fingerprint_tx,
+            metrics,
+            parser: Http2Parser::new(),
+            started: Instant::now(),
+            max_capture,
+            inspected: 0,
+            preface_matched: 0,
+            header: [0; FRAME_HEADER_LEN],
+            header_len: 0,
+            payload_left: 0,
+            keep_frame: false,
+            in_header_block: false,
+            frames: Vec::new(),
+        };
+        Self { inner, capture: Capture::Collecting(Box::new(collector)) }
+    }
+
+    /// `false` once the stream has switched to passthrough (fingerprint published, or none
+    /// to be found).
+    pub fn is_capturing(&self) -> bool {
+        matches!(self.capture, Capture::Collecting(_))
+    }
+}
+
+impl Collector {
+    fn feed(&mut self, data: &[u8]) -> Step {
+        let budget = self.max_capture.saturating_sub(self.inspected);
+        let mut data = data.get(..budget).unwrap_or(data);
+        self.inspected = self.inspected.saturating_add(data.len());
+
+        while !data.is_empty() {
+            if self.preface_matched < PREFACE.len() {
+                let expected = &PREFACE[self.preface_matched..];
+                let n = expected.len().min(data.len());
+                if data[..n] != expected[..n] {
+                    return Step::NotHttp2;
+                }
+                self.preface_matched = self.preface_matched.saturating_add(n);
+                data = &data[n..];
+            } else if self.payload_left > 0 {
+                let n = self.payload_left.min(data.len());
+                if self.keep_frame {
+                    self.frames.extend_from_slice(&data[..n]);
+                }
+                self.payload_left = self.payload_left.saturating_sub(n);
+                data = &data[n..];
+                if self.payload_left == 0 && self.header_block_complete() {
+                    return Step::HeaderBlockComplete;
+                }
+            } else {
+                let n = FRAME_HEADER_LEN
+                    .saturating_sub(self.header_len)
+                    .min(data.len());
+                self.header[self.header_len..][..n].copy_from_slice(&data[..n]);
+                self.header_len = self.header_len.saturating_add(n);
+                data = &data[n..];
+                if self.header_len == FRAME_HEADER_LEN {
+                    self.header_len = 0;
+                    if self.start_frame() {
+                        return Step::HeaderBlockComplete;
+                    }
+                }
+            }
+        }
+
+        if self.inspected >= self.max_capture {
+            Step::LimitReached
+        } else {
+            Step::NeedMore
+        }
+    }
+
+    /// Decide whether the frame whose header was just read is kept. Returns `true` when it
+    /// has no payload and completes the first header block.
+    fn start_frame(&mut self) -> bool {
+        let [l0, l1, l2, frame_type, flags, s0, s1, s2, s3] = self.header;
+        let length = u32::from_be_bytes([0, l0, l1, l2]) as usize;
+        let stream_id = u32::from_be_bytes([s0 & 0x7f, s1, s2, s3]);
+
+        self.keep_frame = if self.in_header_block {
+            frame_type == FRAME_CONTINUATION
+        } else {
+            match frame_type {
+                FRAME_SETTINGS => stream_id == 0 && flags & FLAG_ACK == 0,
+                FRAME_WINDOW_UPDATE | FRAME_PRIORITY => true,
+                FRAME_HEADERS => stream_id != 0,
+                _ => false,
+            }
+        };
+        if self.keep_frame {
+            self.frames.extend_from_slice(&self.header);
+            self.in_header_block |= frame_type == FRAME_HEADERS;
+        }
+        self.payload_left = length;
+        length == 0 && self.header_block_complete()
+    }
+
+    /// Whether the frame just completed ends the first header block.
+    fn header_block_complete(&self) -> bool {
+        let [_, _, _, frame_type, flags, ..] = self.header;
+        self.keep_frame
+            && matches!(frame_type, FRAME_HEADERS | FRAME_CONTINUATION)
+            && flags & FLAG_END_HEADERS != 0
+    }
+
+    fn publish(&mut self) {
+        let fingerprint = match self.parser.parse_frames_skip_preface(&self.frames) {
+            Ok((frames, _)) => extract_akamai_fingerprint(&frames),
+            Err(_) => {
+                debug!("CapturingStream: captured HTTP/2 frames could not be parsed");
+                return;
+            }
+        };
+        match fingerprint {
+            Ok(fingerprint) => {
+                debug!(
+                    "CapturingStream: extracted fingerprint inline: {}",
+                    fingerprint.fingerprint
+                );
+                let _ = self
+                    .fingerprint_tx
+                    .send(Some(Http2Fingerprint::new(fingerprint)));
+                self.metrics.http2_fingerprints_extracted_total.add(1, &[]);
+                self.metrics
+                    .http2_fingerprint_extraction_duration_seconds
+                    .record(self.started.elapsed().as_secs_f64(), &[]);
+            }
+            Err(HuginnNetHttpError::MalformedPseudoHeaders(reason)) => {
+                warn!(
+                    "CapturingStream: malformed HEADERS frame, possible spoofed traffic: {}",
+                    reason
+                );
+                self.metrics.record_http2_fingerprint_failure();
+            }
+            Err(HuginnNetHttpError::NoSettingsFrame) => {
+                debug!("CapturingStream: no SETTINGS frame before the first HEADERS frame");
+            }
+            Err(e) => {
+                debug!("CapturingStream: fingerprint extraction error: {e}");
+            }
+        }
     }
 }
 
 impl<S: AsyncRead + Unpin> AsyncRead for CapturingStream<S> {
     fn poll_read(
-        mut self: Pin<&mut Self>,
+        self: Pin<&mut Self>,
         cx: &mut Context<'_>,
         buf: &mut ReadBuf<'_>,
     ) -> Poll<std::io::Result<()>> {
+        let this = self.get_mut();
+        let Capture::Collecting(collector) = &mut this.capture else {
+            return Pin::new(&mut this.inner).poll_read(cx, buf);
+        };
+
         let before = buf.filled().len();
-        let result = Pin::new(&mut self.inner).poll_read(cx, buf);
-        let after = buf.filled().len();
-
-        if after > before && !self.fingerprint_extracted.load(Ordering::Relaxed) {
-            let read_data = &buf.filled()[before..after];
-            let current_len = self.captured_len.load(Ordering::Relaxed);
-
-            if current_len < self.max_capture {
-                let remaining = self.max_capture.saturating_sub(current_len);
-                let to_capture = read_data.len().min(remaining);
-                let data_to_process = &read_data[..to_capture];
-
-                self.captured_len
-                    .store(current_len.saturating_add(to_capture), Ordering::Relaxed);
-
-                self.buffer.extend_from_slice(data_to_process);
-
-                // Use parse_frames_skip_preface to handle preface automatically
-                let frame_data = &self.buffer[self.parsed_offset..];
-                const MIN_FRAME_LEN: usize = 9; // HTTP/2 frame header: 3 length + 1 type + 1 flags + 4 stream id
-
-                if frame_data.len() >= MIN_FRAME_LEN {
-                    // Use parse_frames_skip_preface to get both frames and bytes consumed (handles preface automatically)
-                    match self.parser.parse_frames_skip_preface(frame_data) {
-                        Ok((frames, bytes_consumed)) => {
-                            if !frames.is_empty() {
-                                // Update parsed_offset based on actual bytes consumed (includes preface if present)
-                                self.parsed_offset =
-                                    self.parsed_offset.saturating_add(bytes_consumed);
-
-                                // Track frame types across reads: SETTINGS and HEADERS
-                                // may arrive in different TCP segments. Update flags from
-                                // the frames seen in this read, then when both are present
-                                // re-parse the full buffer to get all frames together.
-                                self.seen_settings_frame |= frames.iter().any(|f| {
-                                    f.frame_type == Http2FrameType::Settings && f.stream_id == 0
-                                });
-                                self.seen_headers_frame |= frames.iter().any(|f| {
-                                    f.frame_type == Http2FrameType::Headers && f.stream_id > 0
-                                });
-
-                                let all_frames_opt = (self.seen_settings_frame
-                                    && self.seen_headers_frame)
-                                    .then(|| {
-                                        self.parser
-                                            .parse_frames_skip_preface(&self.buffer)
-                                            .ok()
-                                            .map(|(f, _)| f)
-                                    })
-                                    .flatten();
-
-                                if let Some(frames) = all_frames_opt.as_deref() {
-                                    match extract_akamai_fingerprint(frames) {
-                                        Ok(fingerprint) => {
-                                            debug!(
-                                                "CapturingStream: extracted fingerprint inline: {}",
-                                                fingerprint.fingerprint
-                                            );
-                                            let _ = self.fingerprint_tx.send(Some(fingerprint));
-                                            self.fingerprint_extracted
-                                                .store(true, Ordering::Relaxed);
-
-                                            if let Some(start) = self.extraction_start.take() {
-                                                let duration = start.elapsed().as_secs_f64();
-                                                self.metrics
-                                                    .http2_fingerprints_extracted_total
-                                                    .add(1, &[]);
-                                                self.metrics
-                                                    .http2_fingerprint_extraction_duration_seconds
-                                                    .record(duration, &[]);
-                                            }
-                                        }
-                                        Err(HuginnNetHttpError::MalformedPseudoHeaders(reason)) => {
-                                            warn!(
-                                                "CapturingStream: malformed HEADERS frame, possible spoofed traffic: {}",
-                                                reason
-                                            );
-                                            self.metrics.record_http2_fingerprint_failure();
-                                        }
-                                        Err(HuginnNetHttpError::NoSettingsFrame) => {
-                                            debug!("CapturingStream: SETTINGS frame not yet received, will retry on next read");
-                                        }
-                                        Err(e) => {
-                                            debug!("CapturingStream: fingerprint extraction error: {e}");
-                                        }
-                                    }
-                                }
-                            }
-                        }
-                        Err(_) => {
-                            // Parsing error, continue (might need more data)
-                            // Note: HTTP/1.1 detection happens in handle_proxy_request
-                            // when req.version() != HTTP_2
-                        }
-                    }
-                }
-            }
+        let result = Pin::new(&mut this.inner).poll_read(cx, buf);
+        let read_data = &buf.filled()[before..];
+        if read_data.is_empty() {
+            return result;
         }
 
+        match collector.feed(read_data) {
+            Step::NeedMore => return result,
+            Step::HeaderBlockComplete => collector.publish(),
+            // HTTP/1.1 detection happens in handle_proxy_request when req.version() != HTTP_2
+            Step::NotHttp2 => debug!("CapturingStream: no HTTP/2 preface, passthrough"),
+            Step::LimitReached => {
+                debug!("CapturingStream: no HTTP/2 header block within max_capture, passthrough")
+            }
+        }
+        this.capture = Capture::Passthrough;
         result
     }
 }
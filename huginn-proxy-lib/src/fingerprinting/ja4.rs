@@ -1,16 +1,52 @@
+use std::fmt;
+use std::sync::{Arc, LazyLock};
+
+use http::HeaderValue;
 use huginn_net_tls::Ja4Payload;
 
+use super::headers::{encode_header_value, names};
+
+type Compute = Box<dyn FnOnce() -> Ja4Variant + Send>;
+
+/// One JA4 variant of a connection with both header encodings, built on first use.
+#[derive(Debug)]
+pub struct Ja4Variant {
+    pub payload: Ja4Payload,
+    /// Hashed form (`x-tls-ja4`, `x-tls-ja4-o`, `x-tls-ja4-s1`)
+    pub full: Option<HeaderValue>,
+    /// Raw form (`x-tls-ja4-r`, `x-tls-ja4-or`, `x-tls-ja4-s1r`)
+    pub raw: Option<HeaderValue>,
+}
+
+impl Ja4Variant {
+    pub fn new(payload: Ja4Payload) -> Self {
+        Self {
+            full: encode_header_value(&payload.full),
+            raw: encode_header_value(&payload.raw),
+            payload,
+        }
+    }
+}
+
 /// JA4 fingerprint data extracted from TLS ClientHello
-#[derive(Debug, Clone)]
+///
+/// Each variant (and its SHA-256 work) is computed the first time it is read, and its header
+/// values are encoded once; later reads, from any request on the connection, share them.
+/// Cloning is a reference-count bump, so every HTTP/2 stream can hold its own handle.
+#[derive(Clone)]
 pub struct Ja4Fingerprints {
-    /// Normalized JA4 payload
-    pub ja4: Ja4Payload,
-    /// Not normalized JA4 payload
-    pub ja4_original: Ja4Payload,
-    /// Normalized and stable JA4 payload
-    pub ja4_stable_v1: Ja4Payload,
+    inner: Arc<Inner>,
+}
+
+struct Inner {
+    /// Normalized JA4
+    ja4: LazyLock<Ja4Variant, Compute>,
+    /// Not normalized JA4
+    ja4_original: LazyLock<Ja4Variant, Compute>,
+    /// Normalized and stable JA4
+    ja4_stable_v1: LazyLock<Ja4Variant, Compute>,
     /// Server Name Indication from ClientHello (SNI extension)
-    pub sni: Option<String>,
+    sni: Option<String>,
 }
 
 impl Ja4Fingerprints {
@@ -20,6 +56,83 @@ impl Ja4Fingerprints {
         ja4_stable_v1: Ja4Payload,
         sni: Option<String>,
     ) -> Self {
-        Self { ja4, ja4_original, ja4_stable_v1, sni }
+        Self::lazy(
+            move || Ja4Variant::new(ja4),
+            move || Ja4Variant::new(ja4_original),
+            move || Ja4Variant::new(ja4_stable_v1),
+            sni,
+        )
+    }
+
+    /// Fingerprints whose variants are produced by the given closures on first use.
+    pub fn lazy(
+        ja4: impl FnOnce() -> Ja4Variant + Send + 'static,
+        ja4_original: impl FnOnce() -> Ja4Variant + Send + 'static,
+        ja4_stable_v1: impl FnOnce() -> Ja4Variant + Send + 'static,
+        sni: Option<String>,
+    ) -> Self {
+        Self {
+            inner: Arc::new(Inner {
+                ja4: LazyLock::new(Box::new(ja4) as Compute),
+                ja4_original: LazyLock::new(Box::new(ja4_original) as Compute),
+                ja4_stable_v1: LazyLock::new(Box::new(ja4_stable_v1) as Compute),
+                sni,
+            }),
+        }
+    }
+
+    /// Normalized JA4, generated on first call
+    pub fn ja4(&self) -> &Ja4Variant {
+        &self.inner.ja4
+    }
+
+    /// Not normalized JA4, generated on first call
+    pub fn ja4_original(&self) -> &Ja4Variant {
+        &self.inner.ja4_original
+    }
+
+    /// Normalized and stable JA4, generated on first call
+    pub fn ja4_stable_v1(&self) -> &Ja4Variant {
+        &self.inner.ja4_stable_v1
+    }
+
+    /// Server Name Indication from ClientHello (SNI extension)
+    pub fn sni(&self) -> Option<&str> {
+        self.inner.sni.as_deref()
+    }
+
+    /// Every JA4 header with its value, in injection order. Computes all variants.
+    pub fn header_values(&self) -> [(&'static str, Option<&HeaderValue>); 6] {
+        let (ja4, original, stable) = (self.ja4(), self.ja4_original(), self.ja4_stable_v1());
+        [
+            (names::TLS_JA4, ja4.full.as_ref()),
+            (names::TLS_JA4_R, ja4.raw.as_ref()),
+            (names::TLS_JA4_O, original.full.as_ref()),
+            (names::TLS_JA4_OR, original.raw.as_ref()),
+            (names::TLS_JA4_S1, stable.full.as_ref()),
+            (names::TLS_JA4_S1R, stable.raw.as_ref()),
+        ]
+    }
+}
+
+/// Writes the normalized JA4 (the `x-tls-ja4` value), as used for consistent hashing.
+impl fmt::Display for Ja4Fingerprints {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        let ja4 = self.ja4();
+        match ja4.full.as_ref().and_then(|v| v.to_str().ok()) {
+            Some(encoded) => f.write_str(encoded),
+            None => fmt::Display::fmt(&ja4.payload.full, f),
+        }
+    }
+}
+
+impl fmt::Debug for Ja4Fingerprints {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.debug_struct("Ja4Fingerprints")
+            .field("ja4", &self.inner.ja4)
+            .field("ja4_original", &self.inner.ja4_original)
+            .field("ja4_stable_v1", &self.inner.ja4_stable_v1)
+            .field("sni", &self.inner.sni)
+            .finish()
     }
 }
@@ -4,9 +4,9 @@ pub mod ja4;
 pub mod tls_extractor;
 pub mod types;
 
-pub use headers::{forwarded, names};
-pub use http2_extractor::CapturingStream;
+pub use headers::{encode_header_value, forwarded, names};
+pub use http2_extractor::{CapturingStream, Http2Fingerprint};
 pub use huginn_net_tcp::TcpObservation;
-pub use ja4::Ja4Fingerprints;
-pub use tls_extractor::read_client_hello;
+pub use ja4::{Ja4Fingerprints, Ja4Variant};
+pub use tls_extractor::{read_client_hello, read_client_hello_buffered, ClientHello};
 pub use types::SynResult;
@@ -1,49 +1,158 @@
+use std::cell::RefCell;
 use std::sync::Arc;
+use tokio::io::AsyncRead;
 use tokio::time::Instant;
 
-use super::ja4::Ja4Fingerprints;
+use super::ja4::{Ja4Fingerprints, Ja4Variant};
 use crate::telemetry::Metrics;
 
-/// Reads TLS ClientHello from the stream and extracts JA4 fingerprint
-pub async fn read_client_hello(
-    stream: &mut tokio::net::TcpStream,
+/// Initial capacity of a ClientHello buffer; fits any ClientHello without post-quantum key shares.
+const CLIENT_HELLO_BUFFER_CAPACITY: usize = 8 * 1024;
+/// Reads stop once this much has been buffered without completing the first record.
+const CLIENT_HELLO_MAX_BYTES: usize = 64 * 1024;
+/// Buffers kept per worker thread; enough for a burst of concurrent handshakes.
+const POOLED_BUFFERS_PER_THREAD: usize = 32;
+
+thread_local! {
+    /// Recycled ClientHello buffers of the current runtime worker.
+    static BUFFER_POOL: RefCell<Vec<Vec<u8>>> = const { RefCell::new(Vec::new()) };
+}
+
+fn take_buffer() -> Vec<u8> {
+    BUFFER_POOL
+        .try_with(|pool| pool.borrow_mut().pop())
+        .ok()
+        .flatten()
+        .unwrap_or_else(|| Vec::with_capacity(CLIENT_HELLO_BUFFER_CAPACITY))
+}
+
+fn recycle_buffer(mut buf: Vec<u8>) {
+    // Buffers grown by an oversized ClientHello are released rather than pinned in the pool.
+    if buf.capacity() > CLIENT_HELLO_MAX_BYTES {
+        return;
+    }
+    buf.clear();
+    let _ = BUFFER_POOL.try_with(|pool| {
+        let mut pool = pool.borrow_mut();
+        if pool.len() < POOLED_BUFFERS_PER_THREAD {
+            pool.push(buf);
+        }
+    });
+}
+
+/// Bytes read from the client before the TLS handshake: the ClientHello record, possibly
+/// followed by whatever else arrived in the same reads.
+///
+/// The buffer comes from a per-thread pool and goes back to it on drop, so a connection
+/// costs no allocation here once the worker is warm. Drop it as soon as the bytes have been
+/// handed to rustls.
+///
+/// Behind a PROXY-protocol load balancer the same buffer first receives the PROXY header
+/// (see [`crate::proxy::peer_resolution::resolve_peer_buffered`]); [`Self::bytes`] starts after it.
+pub struct ClientHello {
+    buf: Vec<u8>,
+    /// Length of the PROXY header at the start of `buf`.
+    start: usize,
+}
+
+impl ClientHello {
+    /// An empty buffer taken from the pool.
+    pub fn new() -> Self {
+        Self { buf: take_buffer(), start: 0 }
+    }
+
+    /// The bytes read after the PROXY header, if any.
+    pub fn bytes(&self) -> &[u8] {
+        self.buf.get(self.start..).unwrap_or_default()
+    }
+
+    /// The whole buffer, for the PROXY header stage to read into.
+    pub(crate) fn buffer_mut(&mut self) -> &mut Vec<u8> {
+        &mut self.buf
+    }
+
+    /// Skip the `len`-byte PROXY header at the start of the buffer.
+    pub(crate) fn skip_header(&mut self, len: usize) {
+        self.start = len.min(self.buf.len());
+    }
+}
+
+impl Default for ClientHello {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl Drop for ClientHello {
+    fn drop(&mut self) {
+        recycle_buffer(std::mem::take(&mut self.buf));
+    }
+}
+
+/// Reads TLS ClientHello from the stream and extracts JA4 fingerprint.
+///
+/// The returned bytes are the only copy of the record: the caller feeds them to rustls
+/// instead of replaying them through the stream.
+pub async fn read_client_hello<S>(
+    stream: &mut S,
+    metrics: Arc<Metrics>,
+) -> std::io::Result<(ClientHello, Option<Ja4Fingerprints>)>
+where
+    S: AsyncRead + Unpin,
+{
+    read_client_hello_buffered(stream, ClientHello::new(), metrics).await
+}
+
+/// [`read_client_hello`] continuing from the bytes already in `hello`: reads only what the
+/// first record still lacks, so nothing is read when the PROXY header stage buffered it whole.
+pub async fn read_client_hello_buffered<S>(
+    stream: &mut S,
+    mut hello: ClientHello,
     metrics: Arc<Metrics>,
-) -> std::io::Result<(Vec<u8>, Option<Ja4Fingerprints>)> {
+) -> std::io::Result<(ClientHello, Option<Ja4Fingerprints>)>
+where
+    S: AsyncRead + Unpin,
+{
     use huginn_net_tls::tls_process::parse_tls_client_hello;
     use tokio::io::AsyncReadExt;
 
     let start = Instant::now();
-    let mut buf = Vec::with_capacity(8192);
     loop {
-        if buf.len() >= 5 {
-            let len = u16::from_be_bytes([buf[3], buf[4]]) as usize;
+        let record = hello.bytes();
+        if record.len() >= 5 {
+            let len = u16::from_be_bytes([record[3], record[4]]) as usize;
             let needed = len.saturating_add(5);
-            if buf.len() >= needed {
+            if record.len() >= needed {
                 break;
             }
         }
-        let read = stream.read_buf(&mut buf).await?;
+        let read = stream.read_buf(&mut hello.buf).await?;
         if read == 0 {
             break;
         }
-        if buf.len() > 64 * 1024 {
+        if hello.buf.len() > CLIENT_HELLO_MAX_BYTES {
             break;
         }
     }
 
     let duration = start.elapsed().as_secs_f64();
 
-    let fingerprints = match parse_tls_client_hello(&buf) {
+    let fingerprints = match parse_tls_client_hello(hello.bytes()) {
         Ok(signature) => {
             metrics.tls_fingerprints_extracted_total.add(1, &[]);
             metrics
                 .tls_fingerprint_extraction_duration_seconds
                 .record(duration, &[]);
-            let ja4 = signature.generate_ja4();
-            let ja4_original = signature.generate_ja4_original();
-            let ja4_stable_v1 = signature.generate_ja4_stable_v1();
-            let sni = signature.sni;
-            Some(Ja4Fingerprints::new(ja4, ja4_original, ja4_stable_v1, sni))
+            // The variants (and their SHA-256 work) are generated when a request first needs them.
+            let sni = signature.sni.clone();
+            let signature = Arc::new(signature);
+            let (original, stable) = (Arc::clone(&signature), Arc::clone(&signature));
+            Some(Ja4Fingerprints::lazy(
+                move || Ja4Variant::new(signature.generate_ja4()),
+                move || Ja4Variant::new(original.generate_ja4_original()),
+                move || Ja4Variant::new(stable.generate_ja4_stable_v1()),
+                sni,
+            ))
         }
         Err(_) => {
             metrics.tls_fingerprint_failures_total.add(1, &[]);
@@ -51,5 +160,5 @@ pub async fn read_client_hello(
         }
     };
 
-    Ok((buf, fingerprints))
+    Ok((hello, fingerprints))
 }
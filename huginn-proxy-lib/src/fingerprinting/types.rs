@@ -2,7 +2,7 @@ use huginn_net_tcp::TcpObservation;
 
 /// Outcome of a TCP SYN fingerprint probe.
 ///
-/// Returned by the [`SynProbe`](crate::proxy::server::SynProbe) closure; lets
+/// Returned by [`SynProbe::lookup`](crate::proxy::server::SynProbe::lookup); lets
 /// `server.rs` record a precise metric label for each connection.
 #[derive(Debug, Clone)]
 pub enum SynResult {
@@ -19,7 +19,10 @@ pub use config::{
 };
 pub use error::{ProxyError, Result};
 pub use fingerprinting::SynResult;
-pub use fingerprinting::{forwarded, names, read_client_hello, CapturingStream, Ja4Fingerprints};
+pub use fingerprinting::{
+    forwarded, names, read_client_hello, read_client_hello_buffered, CapturingStream, ClientHello,
+    Ja4Fingerprints,
+};
 pub use proxy::reload::{
     initial_client_pool, initial_rate_limiter, try_reload, SharedClientPool, SharedRateLimiter,
 };
@@ -1,17 +1,21 @@
 use crate::backend::health_check::HealthRegistry;
 use crate::backend::{BackendSelector, UpstreamGateway};
-use crate::config::{FingerprintConfig, KeepAliveConfig};
-use crate::fingerprinting::{SynResult, TcpObservation};
+use crate::config::{FingerprintConfig, KeepAliveConfig, ProxyProtocolMode};
+use crate::fingerprinting::{ClientHello, SynResult, TcpObservation};
+use crate::proxy::admission::{ConcurrencyLimiter, SchedulerLag};
+use crate::proxy::cache::ResponseCache;
+use crate::proxy::coalesce::Coalescer;
 use crate::proxy::connection::{ConnectionError, ConnectionManager};
-use crate::proxy::peer_resolution::{resolve_peer, ResolvedProxyProtocol};
+use crate::proxy::peer_resolution::{resolve_peer, resolve_peer_buffered, ResolvedProxyProtocol};
 use crate::proxy::reload::{SharedClientPool, SharedDynamicConfig, SharedRateLimiter};
 use crate::proxy::security_context::SecurityContext;
 use crate::proxy::shutdown::ShutdownWatch;
 use crate::proxy::transport::{
     handle_plain_connection, handle_tls_connection, PlainConnectionConfig, TlsConnectionConfig,
 };
-use crate::telemetry::Metrics;
+use crate::telemetry::{ConnectionTiming, FingerprintExporter, Metrics, Phase, TimingPolicy};
 use crate::tls::setup::SharedTlsAcceptor;
+use crate::tls::SharedSessionCache;
 use hyper_util::rt::TokioExecutor;
 use hyper_util::server::conn::auto::Builder as ConnBuilder;
 use std::net::SocketAddr;
@@ -21,17 +25,42 @@ use tokio::net::TcpListener;
 use tokio::time::{Duration, Instant};
 use tracing::warn;
 
-/// Callback type for TCP SYN fingerprint lookup.
+/// TCP SYN fingerprint lookup callback.
 ///
-/// Returns a [`SynResult`] so the server can record a precise metric label.
+/// Returns a [`SynResult`] so the server can record a precise metric label; `mode` labels the
+/// lookup latency histogram (how the probe reads the BPF maps, e.g. `direct` or `coalesced`).
 /// Implemented by `huginn-proxy` when the `ebpf-tcp` feature is enabled.
-pub type SynProbe = Arc<dyn Fn(SocketAddr) -> SynResult + Send + Sync>;
+#[derive(Clone)]
+pub struct SynProbe {
+    lookup: Arc<dyn Fn(SocketAddr) -> SynResult + Send + Sync>,
+    mode: &'static str,
+}
+
+impl SynProbe {
+    pub fn new(
+        mode: &'static str,
+        lookup: impl Fn(SocketAddr) -> SynResult + Send + Sync + 'static,
+    ) -> Self {
+        Self { lookup: Arc::new(lookup), mode }
+    }
+
+    pub fn lookup(&self, peer: SocketAddr) -> SynResult {
+        (self.lookup)(peer)
+    }
+
+    pub fn mode(&self) -> &'static str {
+        self.mode
+    }
+}
 
 /// Shared state for accept loops, built once in `run()` and cloned per listener.
 pub struct AcceptContext {
     pub dynamic_cfg: SharedDynamicConfig,
     pub rate_limiter: SharedRateLimiter,
     pub tls_acceptor: Option<SharedTlsAcceptor>,
+    /// Shared TLS 1.2 session store, prefetched into before each handshake; `None` without
+    /// `session_resumption.shared_cache`.
+    pub session_cache: Option<Arc<SharedSessionCache>>,
     pub fingerprint_config: FingerprintConfig,
     pub keep_alive_config: KeepAliveConfig,
     pub metrics: Arc<Metrics>,
@@ -43,6 +72,18 @@ pub struct AcceptContext {
     pub tls_handshake_timeout: Duration,
     pub connection_handling_timeout: Duration,
     pub proxy_protocol: ResolvedProxyProtocol,
+    /// Adaptive route/backend concurrency limits; `None` when disabled.
+    pub concurrency: Option<Arc<ConcurrencyLimiter>>,
+    /// `[admission].max_scheduler_lag_ms`; `None` when off. Each runtime probes its own lag.
+    pub max_scheduler_lag: Option<Duration>,
+    /// `[cache]` store; `None` when `max_size_bytes = 0`.
+    pub response_cache: Option<Arc<ResponseCache>>,
+    /// In-flight requests of routes with `coalesce`.
+    pub coalescer: Arc<Coalescer>,
+    /// `[telemetry.timing]`: where request phase breakdowns are exposed.
+    pub timing: Arc<TimingPolicy>,
+    /// `[telemetry.fingerprint_export]` queue; `None` when disabled.
+    pub fingerprint_export: Option<Arc<FingerprintExporter>>,
 }
 
 pub async fn accept_loop(
@@ -51,6 +92,7 @@ pub async fn accept_loop(
     shutdown_signal: Arc<AtomicUsize>,
     mut shutdown_rx: ShutdownWatch,
     connection_manager: Arc<ConnectionManager>,
+    scheduler_lag: Option<Arc<SchedulerLag>>,
     ctx: Arc<AcceptContext>,
 ) {
     loop {
@@ -71,19 +113,24 @@ pub async fn accept_loop(
         };
 
         // Count against the socket peer, before spawning, so a full table never spawns doomed tasks.
-        let guard = match connection_manager.try_accept(socket_peer, &ctx.metrics) {
+        let guard = match connection_manager.try_accept(
+            socket_peer,
+            scheduler_lag.as_deref(),
+            &ctx.metrics,
+        ) {
             Ok(g) => g,
             Err(ConnectionError::Shutdown) => {
                 drop(stream);
                 break;
             }
-            Err(ConnectionError::LimitExceeded { .. }) => {
+            Err(_) => {
                 drop(stream);
                 continue;
             }
         };
 
         let ctx_task = Arc::clone(&ctx);
+        let connection_manager = Arc::clone(&connection_manager);
         tokio::spawn(async move {
             let _guard = guard;
             let mut stream = stream;
@@ -100,55 +147,106 @@ pub async fn accept_loop(
             // Behind an L4 passthrough proxy this recovers the original client `(src_ip, src_port)`
             // from the PROXY protocol header (v1 or v2) so the eBPF SYN lookup, `X-Forwarded-*`,
             // rate-limiting, IP filtering and logs all see the real client.
-            let peer = match resolve_peer(
-                ctx_task.proxy_protocol.mode,
-                ctx_task.proxy_protocol.header_timeout,
-                &ctx_task.metrics,
-                &dynamic.security.trusted_proxies,
-                &mut stream,
-                socket_peer,
-            )
-            .await
-            {
+            //
+            // TLS listeners read the header into the pooled ClientHello buffer: the bytes that
+            // follow it are the start of the handshake, so they are kept rather than re-read.
+            let resolve_start = Instant::now();
+            let mut client_hello = ctx_task.tls_acceptor.as_ref().map(|_| ClientHello::new());
+            let proxy_protocol = ctx_task.proxy_protocol;
+            let trusted_proxies = &dynamic.security.trusted_proxies;
+            let resolved = match client_hello.as_mut() {
+                Some(hello) => {
+                    resolve_peer_buffered(
+                        proxy_protocol.mode,
+                        proxy_protocol.header_timeout,
+                        &ctx_task.metrics,
+                        trusted_proxies,
+                        &mut stream,
+                        socket_peer,
+                        hello,
+                    )
+                    .await
+                }
+                None => {
+                    resolve_peer(
+                        proxy_protocol.mode,
+                        proxy_protocol.header_timeout,
+                        &ctx_task.metrics,
+                        trusted_proxies,
+                        &mut stream,
+                        socket_peer,
+                    )
+                    .await
+                }
+            };
+            let peer = match resolved {
                 Some(p) => p,
                 None => return, // dropped (require + untrusted, bad header, or timeout)
             };
+            let mut timing = ConnectionTiming::new(Arc::clone(&ctx_task.timing), peer.ip());
+            if proxy_protocol.mode != ProxyProtocolMode::Off {
+                timing.record(Phase::ProxyProtocol, resolve_start.elapsed(), &ctx_task.metrics);
+            }
+
+            // Per-IP caps count the resolved client: behind a PROXY-protocol load balancer every
+            // socket peer is the balancer itself.
+            let _client_guard =
+                match connection_manager.try_accept_client(peer.ip(), &ctx_task.metrics) {
+                    Ok(guard) => guard,
+                    Err(_) => return,
+                };
 
             let syn_start = Instant::now();
-            let syn_result = ctx_task.syn_probe.as_ref().map(|probe| probe(peer));
-            let syn_duration = syn_start.elapsed().as_secs_f64();
-            let syn_fingerprint: Option<TcpObservation> = syn_result.as_ref().and_then(|r| {
-                ctx_task
-                    .metrics
-                    .record_tcp_syn_fingerprint(r.label(), syn_duration);
-                r.observation().cloned()
-            });
+            let syn_result = ctx_task
+                .syn_probe
+                .as_ref()
+                .map(|probe| (probe.lookup(peer), probe.mode()));
+            let syn_elapsed = syn_start.elapsed();
+            let syn_fingerprint: Option<TcpObservation> =
+                syn_result.as_ref().and_then(|(r, mode)| {
+                    ctx_task.metrics.record_tcp_syn_fingerprint(
+                        r.label(),
+                        *mode,
+                        syn_elapsed.as_secs_f64(),
+                    );
+                    r.observation().cloned()
+                });
+            if syn_result.is_some() {
+                timing.record(Phase::SynProbe, syn_elapsed, &ctx_task.metrics);
+            }
 
             let rate_mgr = (**ctx_task.rate_limiter.load()).clone();
             let security = SecurityContext::new(
                 dynamic.security.headers.clone(),
-                dynamic.security.ip_filter.clone(),
+                Arc::clone(&dynamic.security.ip_filter),
                 dynamic.security.rate_limit.clone(),
                 rate_mgr,
                 dynamic.headers.clone(),
                 dynamic.security.trusted_proxies.clone(),
             );
             let backends = Arc::clone(&dynamic.backends);
-            let domains = Arc::clone(&dynamic.domains);
+            let routing = Arc::clone(&dynamic.routing);
+            let ip_filters = Arc::clone(&dynamic.ip_filters);
             let preserve_host = dynamic.preserve_host;
             let upstream = UpstreamGateway::new(
                 ctx_task.health_registry.clone(),
                 ctx_task.backend_selector.clone(),
+                ctx_task.concurrency.clone(),
+                ctx_task.response_cache.clone(),
+                ctx_task.coalescer.clone(),
             );
 
             if let Some(ref tls_acceptor) = ctx_task.tls_acceptor {
                 handle_tls_connection(
                     stream,
                     peer,
+                    client_hello.unwrap_or_default(),
                     TlsConnectionConfig {
                         tls_acceptor: tls_acceptor.clone(),
+                        session_cache: ctx_task.session_cache.clone(),
                         fingerprint_config: ctx_task.fingerprint_config.clone(),
-                        domains: domains.clone(),
+                        routing: routing.clone(),
+                        ip_filters: ip_filters.clone(),
                         backends,
                         keep_alive: ctx_task.keep_alive_config.clone(),
                         security: security.clone(),
@@ -160,6 +258,8 @@ pub async fn accept_loop(
                         client_pool: ctx_task.client_pool.load_full(),
                         syn_fingerprint: syn_fingerprint.clone(),
                         upstream: upstream.clone(),
+                        timing,
+                        fingerprint_export: ctx_task.fingerprint_export.clone(),
                     },
                 )
                 .await;
@@ -168,7 +268,8 @@ pub async fn accept_loop(
                     stream,
                     peer,
                     PlainConnectionConfig {
-                        domains,
+                        routing,
+                        ip_filters,
                         backends,
                         keep_alive: ctx_task.keep_alive_config.clone(),
                         security,
@@ -179,6 +280,8 @@ pub async fn accept_loop(
                         client_pool: ctx_task.client_pool.load_full(),
                         syn_fingerprint,
                         upstream,
+                        timing,
+                        fingerprint_export: ctx_task.fingerprint_export.clone(),
                     },
                 )
                 .await;
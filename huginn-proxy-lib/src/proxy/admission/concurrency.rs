@@ -0,0 +1,315 @@
+use std::sync::atomic::{AtomicU32, AtomicU64, Ordering};
+use std::sync::Arc;
+
+use ahash::{AHashMap, RandomState};
+use arc_swap::ArcSwap;
+use opentelemetry::KeyValue;
+use tokio::time::{Duration, Instant};
+
+use crate::config::{AdaptiveConcurrencyConfig, AdmissionConfig};
+use crate::telemetry::attributes::backend_address;
+use crate::telemetry::metrics::{labels, values};
+use crate::telemetry::{Metrics, RouteAttributes};
+
+/// How far a response within tolerance pulls the latency baseline toward itself. Small, so the
+/// baseline follows a backend that becomes slower for good over a few thousand responses. It
+/// never absorbs queueing, because congested responses are not folded in.
+const BASELINE_DRIFT: f64 = 0.001;
+
+/// AIMD limit on the concurrent requests of one route or backend.
+///
+/// The limit is an `f64` (stored as bits) so that the additive step `1 / limit` accumulates
+/// across responses; admission compares the in-flight count against its integer part.
+#[derive(Debug)]
+pub struct AdaptiveLimit {
+    in_flight: AtomicU32,
+    limit_bits: AtomicU64,
+    /// Lowest recent latency in seconds, stored as `f64` bits; `0.0` until the first sample.
+    baseline_bits: AtomicU64,
+    /// Nanoseconds after `epoch` of the last decrease; `0` before the first.
+    last_decrease: AtomicU64,
+    epoch: Instant,
+    /// Labels of this limit's `concurrency_limit` gauge.
+    attributes: Box<[KeyValue]>,
+}
+
+impl AdaptiveLimit {
+    pub fn new(initial_limit: u32, attributes: Box<[KeyValue]>) -> Self {
+        Self {
+            in_flight: AtomicU32::new(0),
+            limit_bits: AtomicU64::new(f64::from(initial_limit).to_bits()),
+            baseline_bits: AtomicU64::new(0f64.to_bits()),
+            last_decrease: AtomicU64::new(0),
+            epoch: Instant::now(),
+            attributes,
+        }
+    }
+
+    /// Requests admitted at once: the integer part of the limit.
+    pub fn limit(&self) -> u32 {
+        f64::from_bits(self.limit_bits.load(Ordering::Relaxed)) as u32
+    }
+
+    pub fn in_flight(&self) -> u32 {
+        self.in_flight.load(Ordering::Relaxed)
+    }
+
+    /// Lowest recent latency in seconds (`0.0` before the first response).
+    pub fn baseline(&self) -> f64 {
+        f64::from_bits(self.baseline_bits.load(Ordering::Relaxed))
+    }
+
+    /// Admit one request if the in-flight count is below the limit; pair with [`Self::release`].
+    pub fn try_acquire(&self) -> bool {
+        let limit = self.limit();
+        self.in_flight
+            .fetch_update(Ordering::AcqRel, Ordering::Relaxed, |n| {
+                (n < limit).then(|| n.saturating_add(1))
+            })
+            .is_ok()
+    }
+
+    pub fn release(&self) {
+        let _ = self
+            .in_flight
+            .fetch_update(Ordering::Relaxed, Ordering::Relaxed, |n| n.checked_sub(1));
+    }
+
+    /// Fold one backend response into the limit, before its request is released. `overloaded`
+    /// marks a response that signals congestion whatever its latency (backend error, 502/503/504).
+    /// Returns the new limit when its integer part changed.
+    pub fn observe(
+        &self,
+        latency: Duration,
+        overloaded: bool,
+        config: &AdaptiveConcurrencyConfig,
+    ) -> Option<u32> {
+        let rtt = latency.as_secs_f64();
+        let baseline = self.baseline();
+        let slow = baseline > 0.0 && rtt > baseline * config.latency_tolerance;
+        if overloaded || slow {
+            return self.decrease(baseline.max(rtt), config);
+        }
+
+        let _ = self
+            .baseline_bits
+            .fetch_update(Ordering::Relaxed, Ordering::Relaxed, |bits| {
+                let prev = f64::from_bits(bits);
+                let next = if prev == 0.0 || rtt < prev {
+                    rtt
+                } else {
+                    prev + BASELINE_DRIFT * (rtt - prev)
+                };
+                Some(next.to_bits())
+            });
+
+        // Grow only while the limit is what bounds concurrency. A route that never has more
+        // than 3 requests in flight would otherwise climb to `max_limit` and lose its protection
+        // by the time load arrives.
+        if self.in_flight().saturating_mul(2) < self.limit() {
+            return None;
+        }
+        let max = f64::from(config.max_limit);
+        self.update_limit(|limit| (limit + 1.0 / limit).min(max))
+    }
+
+    /// Multiplicative decrease, at most once per `window` seconds. The requests in flight when the
+    /// limit dropped answer within about one round trip and carry the same congestion, so they
+    /// must not shrink it again.
+    fn decrease(&self, window: f64, config: &AdaptiveConcurrencyConfig) -> Option<u32> {
+        let now = u64::try_from(self.epoch.elapsed().as_nanos())
+            .unwrap_or(u64::MAX)
+            .max(1);
+        let last = self.last_decrease.load(Ordering::Relaxed);
+        let window = Duration::from_secs_f64(window).as_nanos();
+        if last != 0 && u128::from(now.saturating_sub(last)) < window {
+            return None;
+        }
+        // Responses racing in the same instant decrease once.
+        self.last_decrease
+            .compare_exchange(last, now, Ordering::Relaxed, Ordering::Relaxed)
+            .ok()?;
+        let min = f64::from(config.min_limit);
+        self.update_limit(|limit| (limit * config.backoff_ratio).max(min))
+    }
+
+    fn update_limit(&self, next: impl Fn(f64) -> f64) -> Option<u32> {
+        let prev = self
+            .limit_bits
+            .fetch_update(Ordering::Relaxed, Ordering::Relaxed, |bits| {
+                Some(next(f64::from_bits(bits)).to_bits())
+            })
+            .unwrap_or_else(|bits| bits);
+        let before = f64::from_bits(prev) as u32;
+        let after = self.limit();
+        (before != after).then_some(after)
+    }
+}
+
+/// Which adaptive limit shed a request.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum Shed {
+    Route,
+    Backend,
+}
+
+impl Shed {
+    /// `scope` label of `requests_shed_total`.
+    pub fn scope(self) -> &'static str {
+        match self {
+            Self::Route => values::SCOPE_ROUTE,
+            Self::Backend => values::SCOPE_BACKEND,
+        }
+    }
+}
+
+/// Admission to the limits of one route and one backend. Dropping it releases both.
+#[derive(Debug)]
+pub struct ConcurrencyPermit {
+    route: Arc<AdaptiveLimit>,
+    backend: Arc<AdaptiveLimit>,
+}
+
+impl Drop for ConcurrencyPermit {
+    fn drop(&mut self) {
+        self.route.release();
+        self.backend.release();
+    }
+}
+
+/// Adaptive concurrency limits per route and per backend address
+/// (`[admission.adaptive_concurrency]`).
+///
+/// A route limit protects its backends from that route's traffic, and a backend limit protects a
+/// backend shared by several routes. A request needs room in both to be forwarded, and otherwise
+/// gets a 503 with `Retry-After` instead of queueing behind a slow upstream. Limits are created
+/// on first use and kept for the life of the process. The limiter lives outside the dynamic
+/// config, so a reload keeps the limits already learned.
+pub struct ConcurrencyLimiter {
+    config: AdaptiveConcurrencyConfig,
+    retry_after_secs: u64,
+    /// Keys route limits by `(domain label, route prefix)` without allocating.
+    hasher: RandomState,
+    routes: ArcSwap<AHashMap<u64, Arc<AdaptiveLimit>>>,
+    backends: ArcSwap<AHashMap<Arc<str>, Arc<AdaptiveLimit>>>,
+}
+
+impl ConcurrencyLimiter {
+    /// `None` when adaptive concurrency is disabled.
+    pub fn from_config(admission: &AdmissionConfig) -> Option<Self> {
+        admission.adaptive_concurrency.enabled.then(|| Self {
+            config: admission.adaptive_concurrency.clone(),
+            retry_after_secs: admission.retry_after_secs,
+            hasher: RandomState::new(),
+            routes: ArcSwap::default(),
+            backends: ArcSwap::default(),
+        })
+    }
+
+    /// `Retry-After` of shed responses, in seconds.
+    pub fn retry_after_secs(&self) -> u64 {
+        self.retry_after_secs
+    }
+
+    /// Admit one request to `prefix` of `domain` (labelled `route`) forwarded to `backend`.
+    pub fn try_acquire(
+        &self,
+        domain: &str,
+        prefix: &str,
+        route: &RouteAttributes,
+        backend: &Arc<str>,
+        metrics: &Metrics,
+    ) -> Result<ConcurrencyPermit, Shed> {
+        let route_limit = self.route_limit(domain, prefix, route, metrics);
+        if !route_limit.try_acquire() {
+            return Err(Shed::Route);
+        }
+        let backend_limit = self.backend_limit(backend, metrics);
+        if !backend_limit.try_acquire() {
+            route_limit.release();
+            return Err(Shed::Backend);
+        }
+        Ok(ConcurrencyPermit { route: route_limit, backend: backend_limit })
+    }
+
+    /// Feed the backend's answer to a permitted request into both of its limits.
+    pub fn complete(
+        &self,
+        permit: &ConcurrencyPermit,
+        latency: Duration,
+        overloaded: bool,
+        metrics: &Metrics,
+    ) {
+        for limit in [&permit.route, &permit.backend] {
+            if let Some(value) = limit.observe(latency, overloaded, &self.config) {
+                metrics.record_concurrency_limit(value, &limit.attributes);
+            }
+        }
+    }
+
+    /// Limit of `prefix` under `domain`, if a request has used it.
+    pub fn route(&self, domain: &str, prefix: &str) -> Option<Arc<AdaptiveLimit>> {
+        let key = self.hasher.hash_one((domain, prefix));
+        self.routes.load().get(&key).cloned()
+    }
+
+    /// Limit of `backend`, if a request has used it.
+    pub fn backend(&self, backend: &str) -> Option<Arc<AdaptiveLimit>> {
+        self.backends.load().get(backend).cloned()
+    }
+
+    fn route_limit(
+        &self,
+        domain: &str,
+        prefix: &str,
+        route: &RouteAttributes,
+        metrics: &Metrics,
+    ) -> Arc<AdaptiveLimit> {
+        let key = self.hasher.hash_one((domain, prefix));
+        if let Some(limit) = self.routes.load().get(&key) {
+            return Arc::clone(limit);
+        }
+        let attributes: Box<[KeyValue]> = Box::new([
+            KeyValue::new(labels::SCOPE, values::SCOPE_ROUTE),
+            route.route.clone(),
+            route.domain.clone(),
+        ]);
+        let limit = self.insert(&self.routes, key, attributes);
+        metrics.record_concurrency_limit(limit.limit(), &limit.attributes);
+        limit
+    }
+
+    fn backend_limit(&self, backend: &Arc<str>, metrics: &Metrics) -> Arc<AdaptiveLimit> {
+        if let Some(limit) = self.backends.load().get(&**backend) {
+            return Arc::clone(limit);
+        }
+        let attributes: Box<[KeyValue]> = Box::new([
+            KeyValue::new(labels::SCOPE, values::SCOPE_BACKEND),
+            backend_address(backend),
+        ]);
+        let limit = self.insert(&self.backends, Arc::clone(backend), attributes);
+        metrics.record_concurrency_limit(limit.limit(), &limit.attributes);
+        limit
+    }
+
+    /// First use of a route or backend: copy-on-write insert. `rcu` retries on a concurrent
+    /// insert, and `or_insert_with` keeps whichever limit won.
+    fn insert<K>(
+        &self,
+        map: &ArcSwap<AHashMap<K, Arc<AdaptiveLimit>>>,
+        key: K,
+        attributes: Box<[KeyValue]>,
+    ) -> Arc<AdaptiveLimit>
+    where
+        K: std::hash::Hash + Eq + Clone,
+    {
+        let fresh = Arc::new(AdaptiveLimit::new(self.config.initial_limit, attributes));
+        map.rcu(|current| {
+            let mut next = AHashMap::clone(current);
+            next.entry(key.clone())
+                .or_insert_with(|| Arc::clone(&fresh));
+            next
+        });
+        map.load().get(&key).cloned().unwrap_or(fresh)
+    }
+}
@@ -0,0 +1,93 @@
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::Arc;
+
+use opentelemetry::KeyValue;
+use tokio::time::{Duration, Instant};
+use tracing::info;
+
+use crate::proxy::shutdown::{ServiceHandle, ServiceName, ShutdownWatch};
+use crate::telemetry::metrics::labels;
+use crate::telemetry::Metrics;
+
+/// How long the probe asks the runtime to sleep between measurements.
+const PROBE_INTERVAL: Duration = Duration::from_millis(10);
+
+/// Weight of the newest sample in the smoothed lag, so one slow poll does not refuse connections.
+const LAG_ALPHA: f64 = 0.25;
+
+/// Smoothed scheduler lag of one Tokio runtime, and the threshold past which
+/// [`ConnectionManager::try_accept`](crate::proxy::connection::ConnectionManager::try_accept)
+/// refuses new connections.
+///
+/// A probe task on the runtime sleeps [`PROBE_INTERVAL`] and measures how late it is woken. The
+/// delay grows when tasks are queued faster than the runtime can poll them. Refusing connections
+/// at that point costs the kernel one RST each. Accepting them would slow down every connection
+/// already held. Each runtime has its own probe: the main runtime, and one per `thread_per_core`
+/// shard.
+#[derive(Debug)]
+pub struct SchedulerLag {
+    /// Smoothed lag in seconds, stored as `f64` bits.
+    lag_bits: AtomicU64,
+    threshold: Duration,
+}
+
+impl SchedulerLag {
+    pub fn new(threshold: Duration) -> Self {
+        Self { lag_bits: AtomicU64::new(0f64.to_bits()), threshold }
+    }
+
+    /// Current smoothed lag.
+    pub fn lag(&self) -> Duration {
+        Duration::from_secs_f64(f64::from_bits(self.lag_bits.load(Ordering::Relaxed)))
+    }
+
+    /// Whether the smoothed lag exceeds the configured threshold.
+    pub fn saturated(&self) -> bool {
+        self.lag() > self.threshold
+    }
+
+    /// Fold one measured lag into the smoothed value and return the new value in seconds.
+    pub fn observe(&self, sample: Duration) -> f64 {
+        let sample = sample.as_secs_f64();
+        let prev = f64::from_bits(self.lag_bits.load(Ordering::Relaxed));
+        let next = prev + LAG_ALPHA * (sample - prev);
+        // Only the probe task writes, so a plain store cannot lose an update.
+        self.lag_bits.store(next.to_bits(), Ordering::Relaxed);
+        next
+    }
+
+    /// Probe the current runtime until shutdown. `runtime` labels the lag gauge (`main`,
+    /// `shard-N`).
+    pub async fn probe(
+        self: Arc<Self>,
+        runtime: String,
+        metrics: Arc<Metrics>,
+        mut shutdown_rx: ShutdownWatch,
+    ) {
+        let runtime = KeyValue::new(labels::RUNTIME, runtime);
+        loop {
+            let scheduled = Instant::now();
+            tokio::select! {
+                biased;
+                _ = shutdown_rx.wait_for(|v| *v) => break,
+                _ = tokio::time::sleep(PROBE_INTERVAL) => {}
+            }
+            let lag = scheduled.elapsed().saturating_sub(PROBE_INTERVAL);
+            metrics.record_scheduler_lag(self.observe(lag), &runtime);
+        }
+    }
+
+    /// Spawn the probe of the main runtime as a background service.
+    pub fn spawn(
+        self: &Arc<Self>,
+        metrics: Arc<Metrics>,
+        shutdown_rx: ShutdownWatch,
+    ) -> ServiceHandle {
+        info!(
+            max_scheduler_lag_ms = self.threshold.as_millis(),
+            "Scheduler-lag admission enabled"
+        );
+        let handle = tokio::spawn(Arc::clone(self).probe("main".to_string(), metrics, shutdown_rx));
+        ServiceHandle { handle, name: ServiceName::SchedulerLag }
+    }
+}
@@ -0,0 +1,19 @@
+//! Load shedding (`[admission]`).
+//!
+//! Three independent gates, each off by default:
+//!
+//! - [`SchedulerLag`]: refuse new connections while the runtime is behind on polling, before it
+//!   saturates (checked at accept).
+//! - [`PerIpLimit`]: cap the concurrent connections of one client IP (checked once the PROXY
+//!   protocol header, if any, has named the real client).
+//! - [`ConcurrencyLimiter`]: AIMD limits on the requests in flight per route and per backend.
+//!   A request over either limit gets a 503 with `Retry-After` instead of queueing behind a slow
+//!   upstream (checked after backend selection).
+
+mod concurrency;
+mod lag;
+mod per_ip;
+
+pub use concurrency::{AdaptiveLimit, ConcurrencyLimiter, ConcurrencyPermit, Shed};
+pub use lag::SchedulerLag;
+pub use per_ip::{PerIpGuard, PerIpLimit};
@@ -0,0 +1,103 @@
+use std::collections::hash_map::Entry;
+use std::net::IpAddr;
+use std::sync::{Arc, Mutex, MutexGuard};
+
+use ahash::{AHashMap, RandomState};
+
+/// Shards of the table; a power of two, indexed by the top bits of the IP's hash.
+const SHARD_BITS: u32 = 6;
+
+/// Concurrent connections per client IP (`[admission].max_connections_per_ip`).
+///
+/// An exact count per IP, in maps sharded by a keyed hash so connections from different clients
+/// rarely take the same lock. A client's entry is removed when its last connection closes, so
+/// the table only holds clients that are connected. The hash key is random per process, so a
+/// client cannot choose addresses that land on a victim's shard.
+pub struct PerIpLimit {
+    limit: u32,
+    hasher: RandomState,
+    shards: Box<[Shard]>,
+}
+
+/// Aligned to its own cache lines so neighbouring shard locks do not false-share.
+#[repr(align(128))]
+#[derive(Default)]
+struct Shard {
+    counts: Mutex<AHashMap<IpAddr, u32>>,
+}
+
+impl PerIpLimit {
+    /// Number of shards; more clients than this means some share a shard's map.
+    pub const SHARDS: usize = 1 << SHARD_BITS;
+
+    pub fn new(limit: u32) -> Self {
+        Self {
+            limit,
+            hasher: RandomState::new(),
+            shards: (0..Self::SHARDS).map(|_| Shard::default()).collect(),
+        }
+    }
+
+    pub fn limit(&self) -> u32 {
+        self.limit
+    }
+
+    /// Connections currently held by `ip`.
+    pub fn count(&self, ip: IpAddr) -> u32 {
+        self.counts(ip).get(&ip).copied().unwrap_or(0)
+    }
+
+    /// Client IPs currently holding at least one connection (takes every shard lock; not for
+    /// the accept path).
+    pub fn clients(&self) -> usize {
+        self.shards
+            .iter()
+            .map(|shard| shard.counts.lock().unwrap_or_else(|e| e.into_inner()).len())
+            .sum()
+    }
+
+    /// Count one connection from `ip`, or `None` when it already holds `limit`; a refused
+    /// attempt changes no count. The connection is released when the guard drops.
+    pub fn try_acquire(self: &Arc<Self>, ip: IpAddr) -> Option<PerIpGuard> {
+        let mut counts = self.counts(ip);
+        let held = counts.get(&ip).copied().unwrap_or(0);
+        if held >= self.limit {
+            return None;
+        }
+        counts.insert(ip, held.saturating_add(1));
+        Some(PerIpGuard { table: Arc::clone(self), ip })
+    }
+
+    fn release(&self, ip: IpAddr) {
+        if let Entry::Occupied(mut entry) = self.counts(ip).entry(ip) {
+            if *entry.get() <= 1 {
+                entry.remove();
+            } else {
+                *entry.get_mut() = entry.get().saturating_sub(1);
+            }
+        }
+    }
+
+    /// Locked map of `ip`'s shard. Top bits of the hash, so shards stay independent of the bits
+    /// each map hashes on.
+    fn counts(&self, ip: IpAddr) -> MutexGuard<'_, AHashMap<IpAddr, u32>> {
+        let shard =
+            usize::try_from(self.hasher.hash_one(ip) >> (u64::BITS - SHARD_BITS)).unwrap_or(0);
+        self.shards[shard]
+            .counts
+            .lock()
+            .unwrap_or_else(|e| e.into_inner())
+    }
+}
+
+/// One connection counted by [`PerIpLimit::try_acquire`].
+pub struct PerIpGuard {
+    table: Arc<PerIpLimit>,
+    ip: IpAddr,
+}
+
+impl Drop for PerIpGuard {
+    fn drop(&mut self) {
+        self.table.release(self.ip);
+    }
+}
@@ -0,0 +1,347 @@
+//! Response cache (`[cache]` store, enabled per route with `[domains.routes.cache]`).
+//!
+//! The handler looks a request up once it has passed every check that can refuse it (IP filter,
+//! rate limit) and before a backend is picked, so a hit costs no backend work at all. A miss is
+//! forwarded as usual and its response handed back to [`ResponseCache::store`], which keeps the
+//! body as one shared [`Bytes`]: hits clone a reference, not the body.
+
+pub mod policy;
+mod store;
+
+pub use store::SHARDS;
+
+use std::sync::atomic::{AtomicU8, Ordering};
+use std::sync::Arc;
+
+use ahash::RandomState;
+use bytes::Bytes;
+use http::header::{CONNECTION, CONTENT_LENGTH, TRANSFER_ENCODING};
+use http::{HeaderMap, HeaderName, HeaderValue, Method, Request, Response, StatusCode};
+use http_body_util::BodyExt;
+use hyper::body::Body;
+use tokio::time::{Duration, Instant};
+
+use crate::config::{CacheConfig, RouteCacheConfig};
+use crate::proxy::http_result::{HttpError, HttpResult};
+use crate::telemetry::metrics::values;
+use crate::telemetry::{Metrics, RouteAttributes};
+use crate::utils::http::{empty_body, full_body, RespBody};
+use policy::RequestPolicy;
+use store::Store;
+
+/// Most reads an entry accumulates toward staying in the main FIFO.
+const MAX_FREQUENCY: u8 = 3;
+
+/// Bytes charged per entry on top of its body, headers and key, for the map slot, queue record
+/// and allocations.
+const ENTRY_OVERHEAD: usize = 256;
+
+/// What identifies a cached response, borrowed from the request.
+///
+/// The route's backend is part of the key, so a reload that points the route elsewhere stops
+/// serving what the previous backend answered.
+#[derive(Debug, Clone, Copy, Hash, PartialEq, Eq)]
+pub struct CacheKey<'a> {
+    pub https: bool,
+    pub host: &'a str,
+    pub backend: &'a str,
+    pub path_and_query: &'a str,
+    /// Normalized JA4 of the connection, on routes with `key_fingerprints`.
+    pub fingerprint: Option<&'a [u8]>,
+}
+
+/// Owned copy of a [`CacheKey`], kept with the entry so a hash collision is never served.
+#[derive(Debug)]
+struct StoredKey {
+    https: bool,
+    host: Box<str>,
+    backend: Box<str>,
+    path_and_query: Box<str>,
+    fingerprint: Option<Box<[u8]>>,
+}
+
+impl StoredKey {
+    fn new(key: &CacheKey<'_>) -> Self {
+        Self {
+            https: key.https,
+            host: key.host.into(),
+            backend: key.backend.into(),
+            path_and_query: key.path_and_query.into(),
+            fingerprint: key.fingerprint.map(Into::into),
+        }
+    }
+
+    fn matches(&self, key: &CacheKey<'_>) -> bool {
+        self.https == key.https
+            && *self.host == *key.host
+            && *self.backend == *key.backend
+            && *self.path_and_query == *key.path_and_query
+            && self.fingerprint.as_deref() == key.fingerprint
+    }
+
+    fn len(&self) -> usize {
+        [
+            self.host.len(),
+            self.backend.len(),
+            self.path_and_query.len(),
+            self.fingerprint.as_ref().map_or(0, |f| f.len()),
+        ]
+        .into_iter()
+        .fold(0, usize::saturating_add)
+    }
+}
+
+/// One stored response.
+#[derive(Debug)]
+pub struct CachedResponse {
+    key: StoredKey,
+    status: StatusCode,
+    headers: HeaderMap,
+    body: Bytes,
+    /// Request header values the response varies on, as sent by the request that stored it.
+    vary: Box<[(HeaderName, Option<HeaderValue>)]>,
+    stored_at: Instant,
+    expires_at: Instant,
+    /// `Age` the response already had when it arrived.
+    initial_age: u64,
+    /// Labels of the route that stored it, for its eviction count.
+    route: RouteAttributes,
+    /// Reads since it was stored or last passed a queue tail, up to [`MAX_FREQUENCY`].
+    frequency: AtomicU8,
+    /// Bytes charged against the store.
+    size: usize,
+}
+
+impl CachedResponse {
+    fn is_expired(&self, now: Instant) -> bool {
+        now >= self.expires_at
+    }
+
+    fn varies_from<B>(&self, req: &Request<B>) -> bool {
+        self.vary
+            .iter()
+            .any(|(name, value)| req.headers().get(name) != value.as_ref())
+    }
+
+    fn touch(&self) {
+        let _ = self
+            .frequency
+            .fetch_update(Ordering::Relaxed, Ordering::Relaxed, |f| {
+                (f < MAX_FREQUENCY).then(|| f.saturating_add(1))
+            });
+    }
+
+    fn frequency(&self) -> u8 {
+        self.frequency.load(Ordering::Relaxed)
+    }
+
+    fn reset_frequency(&self) {
+        self.frequency.store(0, Ordering::Relaxed);
+    }
+
+    /// Spend one read; `false` when none is left.
+    fn take_frequency(&self) -> bool {
+        self.frequency
+            .fetch_update(Ordering::Relaxed, Ordering::Relaxed, |f| f.checked_sub(1))
+            .is_ok()
+    }
+
+    /// The response to serve now; `head` leaves the body out.
+    fn response(&self, head: bool, now: Instant) -> Response<RespBody> {
+        let body = if head {
+            empty_body()
+        } else {
+            full_body(self.body.clone())
+        };
+        let mut response = Response::new(body);
+        *response.status_mut() = self.status;
+        *response.headers_mut() = self.headers.clone();
+        let age = self
+            .initial_age
+            .saturating_add(now.saturating_duration_since(self.stored_at).as_secs());
+        response
+            .headers_mut()
+            .insert(http::header::AGE, HeaderValue::from(age));
+        response
+    }
+}
+
+/// Outcome of [`ResponseCache::lookup`].
+pub enum Lookup {
+    /// A fresh stored response, ready to send.
+    Hit(Response<RespBody>),
+    /// Forward the request. With a [`PendingStore`], pass the response to
+    /// [`ResponseCache::store`] afterwards.
+    Forward(Option<PendingStore>),
+}
+
+/// What [`ResponseCache::store`] needs from a request that missed.
+pub struct PendingStore {
+    hash: u64,
+    key: StoredKey,
+    /// The client's headers before forwarding added or removed any, for `Vary`.
+    request_headers: HeaderMap,
+    default_ttl: Duration,
+    route: RouteAttributes,
+}
+
+/// Shared, memory-bounded store of backend responses; see the module docs.
+///
+/// Static: entries survive config reloads, and routes opt in per snapshot.
+pub struct ResponseCache {
+    store: Store,
+    hasher: RandomState,
+    max_object_bytes: u64,
+}
+
+impl ResponseCache {
+    pub fn new(config: &CacheConfig) -> Self {
+        Self {
+            store: Store::new(config.max_size_bytes),
+            hasher: RandomState::new(),
+            max_object_bytes: config.max_object_bytes,
+        }
+    }
+
+    /// `None` when `max_size_bytes` is `0`.
+    pub fn from_config(config: &CacheConfig) -> Option<Self> {
+        (config.max_size_bytes > 0).then(|| Self::new(config))
+    }
+
+    /// Bytes currently charged against `max_size_bytes`.
+    pub fn size_bytes(&self) -> u64 {
+        self.store.size_bytes()
+    }
+
+    /// Entries currently stored, fresh or not (takes every shard lock; not for the request path).
+    pub fn len(&self) -> usize {
+        self.store.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Serve `req` from the cache, or say how to forward it. Records the lookup result.
+    pub fn lookup<B>(
+        &self,
+        req: &Request<B>,
+        key: &CacheKey<'_>,
+        config: &RouteCacheConfig,
+        route: &RouteAttributes,
+        metrics: &Metrics,
+    ) -> Lookup {
+        let policy = policy::request_policy(req.method(), req.headers());
+        if policy == RequestPolicy::Bypass {
+            metrics.record_cache_lookup(values::CACHE_BYPASS, route);
+            return Lookup::Forward(None);
+        }
+        let hash = self.hasher.hash_one(key);
+        let now = Instant::now();
+        if policy == RequestPolicy::Cacheable {
+            if let Some(entry) = self.store.get(hash) {
+                if entry.key.matches(key) && !entry.is_expired(now) && !entry.varies_from(req) {
+                    entry.touch();
+                    metrics.record_cache_lookup(values::CACHE_HIT, route);
+                    return Lookup::Hit(entry.response(req.method() == Method::HEAD, now));
+                }
+            }
+        }
+        metrics.record_cache_lookup(values::CACHE_MISS, route);
+        // A `HEAD` response has no body to store.
+        let pending = (req.method() == Method::GET).then(|| PendingStore {
+            hash,
+            key: StoredKey::new(key),
+            request_headers: req.headers().clone(),
+            default_ttl: Duration::from_secs(config.default_ttl_secs),
+            route: route.clone(),
+        });
+        Lookup::Forward(pending)
+    }
+
+    /// Store `response` if the backend allows it, and return it to send to the client.
+    ///
+    /// A storable response is buffered (it is at most `max_object_bytes`); any other is returned
+    /// untouched and keeps streaming. A backend that fails mid-body while being buffered yields
+    /// [`HttpError::FailedToGetResponseFromBackend`], as a failed forward would.
+    pub async fn store(
+        &self,
+        pending: PendingStore,
+        response: Response<RespBody>,
+        metrics: &Metrics,
+    ) -> HttpResult<Response<RespBody>> {
+        let Some(ttl) =
+            policy::freshness(response.status(), response.headers(), pending.default_ttl)
+        else {
+            return Ok(response);
+        };
+        let Some(varied) = policy::vary(response.headers()) else {
+            return Ok(response);
+        };
+        let declared = response
+            .headers()
+            .get(CONTENT_LENGTH)
+            .and_then(|v| v.to_str().ok())
+            .and_then(|v| v.parse::<u64>().ok())
+            .or_else(|| response.body().size_hint().exact());
+        if declared.is_none_or(|len| len > self.max_object_bytes) {
+            return Ok(response);
+        }
+
+        let (mut parts, body) = response.into_parts();
+        let body = body
+            .collect()
+            .await
+            .map_err(|e| HttpError::FailedToGetResponseFromBackend(e.to_string()))?
+            .to_bytes();
+
+        // The body is re-sent whole, so framing headers from the backend do not apply.
+        parts.headers.remove(CONNECTION);
+        parts.headers.remove(TRANSFER_ENCODING);
+        parts
+            .headers
+            .insert(CONTENT_LENGTH, HeaderValue::from(body.len()));
+        let initial_age = policy::age(&parts.headers);
+        parts.headers.remove(http::header::AGE);
+
+        let vary: Box<[_]> = varied
+            .into_iter()
+            .map(|name| {
+                let value = pending.request_headers.get(&name).cloned();
+                (name, value)
+            })
+            .collect();
+        let header_bytes = parts
+            .headers
+            .iter()
+            .map(|(name, value)| name.as_str().len().saturating_add(value.len()))
+            .fold(0, usize::saturating_add);
+        let size = [body.len(), header_bytes, pending.key.len(), ENTRY_OVERHEAD]
+            .into_iter()
+            .fold(0, usize::saturating_add);
+
+        let now = Instant::now();
+        let Some(expires_at) = now.checked_add(ttl) else {
+            return Ok(Response::from_parts(parts, full_body(body)));
+        };
+        let entry = Arc::new(CachedResponse {
+            key: pending.key,
+            status: parts.status,
+            headers: parts.headers.clone(),
+            body: body.clone(),
+            vary,
+            stored_at: now,
+            expires_at,
+            initial_age,
+            route: pending.route,
+            frequency: AtomicU8::new(0),
+            size,
+        });
+        for evicted in self.store.insert(pending.hash, entry) {
+            metrics.record_cache_eviction(&evicted.route);
+        }
+        metrics.record_cache_size(self.size_bytes());
+
+        Ok(Response::from_parts(parts, full_body(body)))
+    }
+}
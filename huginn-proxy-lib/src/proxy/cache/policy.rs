@@ -0,0 +1,170 @@
+//! `Cache-Control` handling for a shared cache: the subset of RFC 9111 the response cache needs.
+
+use http::header::{AGE, AUTHORIZATION, CACHE_CONTROL, EXPIRES, PRAGMA, RANGE, SET_COOKIE, VARY};
+use http::{HeaderMap, HeaderName, Method, StatusCode};
+use tokio::time::Duration;
+
+use crate::fingerprinting::names;
+
+/// Statuses cacheable by default (RFC 9110 §15.1) that a reverse proxy sees in practice.
+const CACHEABLE_STATUS: [StatusCode; 7] = [
+    StatusCode::OK,
+    StatusCode::NON_AUTHORITATIVE_INFORMATION,
+    StatusCode::NO_CONTENT,
+    StatusCode::MOVED_PERMANENTLY,
+    StatusCode::PERMANENT_REDIRECT,
+    StatusCode::NOT_FOUND,
+    StatusCode::GONE,
+];
+
+/// What a request's own method and headers allow the cache to do.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum RequestPolicy {
+    /// Serve a fresh entry, or store the response on a miss.
+    Cacheable,
+    /// Skip the lookup (`no-cache`, `max-age=0`, `Pragma: no-cache`) but store the response.
+    Revalidate,
+    /// Neither look up nor store: a method other than `GET`/`HEAD`, `Authorization`, `Range`, or
+    /// `no-store`.
+    Bypass,
+}
+
+pub fn request_policy(method: &Method, headers: &HeaderMap) -> RequestPolicy {
+    if (method != Method::GET && method != Method::HEAD)
+        || headers.contains_key(AUTHORIZATION)
+        || headers.contains_key(RANGE)
+    {
+        return RequestPolicy::Bypass;
+    }
+    let mut policy = RequestPolicy::Cacheable;
+    for (name, value) in directives(headers) {
+        if name.eq_ignore_ascii_case("no-store") {
+            return RequestPolicy::Bypass;
+        }
+        if name.eq_ignore_ascii_case("no-cache")
+            || (name.eq_ignore_ascii_case("max-age") && seconds(value) == 0)
+        {
+            policy = RequestPolicy::Revalidate;
+        }
+    }
+    let pragma_no_cache = headers
+        .get_all(PRAGMA)
+        .iter()
+        .filter_map(|v| v.to_str().ok())
+        .any(|v| v.trim().eq_ignore_ascii_case("no-cache"));
+    if pragma_no_cache && !headers.contains_key(CACHE_CONTROL) {
+        policy = RequestPolicy::Revalidate;
+    }
+    policy
+}
+
+/// How long a response may be served from the cache, or `None` when it must not be stored.
+///
+/// `s-maxage` wins over `max-age`; without either, `default_ttl` applies (`0` = not cached). An
+/// `Expires` header without `max-age` keeps the response out: dates are not parsed, and
+/// `Expires` is mostly used to mark responses already stale. `Age` from an upstream cache is
+/// subtracted.
+pub fn freshness(
+    status: StatusCode,
+    headers: &HeaderMap,
+    default_ttl: Duration,
+) -> Option<Duration> {
+    if !CACHEABLE_STATUS.contains(&status) || headers.contains_key(SET_COOKIE) {
+        return None;
+    }
+    let mut max_age = None;
+    let mut s_maxage = None;
+    for (name, value) in directives(headers) {
+        if ["no-store", "no-cache", "private"]
+            .iter()
+            .any(|d| name.eq_ignore_ascii_case(d))
+        {
+            return None;
+        }
+        if name.eq_ignore_ascii_case("s-maxage") {
+            s_maxage = Some(seconds(value));
+        } else if name.eq_ignore_ascii_case("max-age") {
+            max_age = Some(seconds(value));
+        }
+    }
+    let lifetime = match s_maxage.or(max_age) {
+        Some(secs) => Duration::from_secs(secs),
+        None if headers.contains_key(EXPIRES) => return None,
+        None => default_ttl,
+    };
+    let remaining = lifetime.saturating_sub(Duration::from_secs(age(headers)));
+    (!remaining.is_zero()).then_some(remaining)
+}
+
+/// `Age` of a response, in seconds (`0` when absent or malformed).
+pub fn age(headers: &HeaderMap) -> u64 {
+    headers
+        .get(AGE)
+        .and_then(|v| v.to_str().ok())
+        .and_then(|v| v.trim().parse().ok())
+        .unwrap_or(0)
+}
+
+/// Request headers a response varies on, or `None` for `Vary: *`.
+///
+/// Proxy-authoritative fingerprint headers are left out: the client never sends them (they are
+/// stripped on entry), so the request would always look the same to the cache. Routes that need
+/// per-fingerprint entries set `key_fingerprints` instead.
+pub fn vary(headers: &HeaderMap) -> Option<Vec<HeaderName>> {
+    let mut varied = Vec::new();
+    for field in vary_fields(headers) {
+        if field == "*" {
+            return None;
+        }
+        let Ok(name) = HeaderName::from_bytes(field.as_bytes()) else {
+            return None;
+        };
+        if !names::FINGERPRINTS.contains(&name.as_str()) && !varied.contains(&name) {
+            varied.push(name);
+        }
+    }
+    Some(varied)
+}
+
+/// Field names listed in `Vary`, as sent (`*` included).
+pub fn vary_fields(headers: &HeaderMap) -> impl Iterator<Item = &str> {
+    headers
+        .get_all(VARY)
+        .iter()
+        .filter_map(|v| v.to_str().ok())
+        .flat_map(|v| v.split(','))
+        .map(str::trim)
+        .filter(|f| !f.is_empty())
+}
+
+/// Whether a response may be sent to clients other than the one it was fetched for: no
+/// `Set-Cookie`, and no `private` or `no-store`.
+pub fn shareable(headers: &HeaderMap) -> bool {
+    !headers.contains_key(SET_COOKIE)
+        && !directives(headers).any(|(name, _)| {
+            ["private", "no-store"]
+                .iter()
+                .any(|d| name.eq_ignore_ascii_case(d))
+        })
+}
+
+/// `Cache-Control` directives as `(name, argument)`, with quotes around arguments removed.
+fn directives(headers: &HeaderMap) -> impl Iterator<Item = (&str, Option<&str>)> {
+    headers
+        .get_all(CACHE_CONTROL)
+        .iter()
+        .filter_map(|v| v.to_str().ok())
+        .flat_map(|v| v.split(','))
+        .map(str::trim)
+        .filter(|d| !d.is_empty())
+        .map(|d| match d.split_once('=') {
+            Some((name, arg)) => (name.trim_end(), Some(arg.trim_start().trim_matches('"'))),
+            None => (d, None),
+        })
+}
+
+/// Delta-seconds argument of a directive; a missing or malformed one counts as `0` (stale), as
+/// RFC 9111 §1.2.2 asks.
+fn seconds(arg: Option<&str>) -> u64 {
+    arg.and_then(|a| a.parse().ok()).unwrap_or(0)
+}
@@ -0,0 +1,255 @@
+use std::collections::VecDeque;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, RwLock, RwLockReadGuard, RwLockWriteGuard};
+
+use ahash::{AHashMap, AHashSet};
+use tokio::time::Instant;
+
+use super::CachedResponse;
+
+/// Shards of the store; the top bits of an entry's hash pick its shard.
+pub const SHARDS: usize = 16;
+const SHARD_SHIFT: u32 = u64::BITS - SHARDS.trailing_zeros();
+
+/// Share of a shard's capacity held by the probationary (small) queue.
+const SMALL_PERCENT: usize = 10;
+
+/// Ghost hashes kept per shard even while it holds few entries.
+const GHOST_MIN: usize = 64;
+
+/// Sharded S3-FIFO store of cached responses, bounded in bytes.
+///
+/// A new entry enters a small probationary FIFO. When it reaches the tail, it moves to the main
+/// FIFO if it was read since it was stored, and is evicted otherwise. Its hash is then kept in a
+/// ghost queue, so if the same response is stored again soon it goes straight to the main FIFO.
+/// The main FIFO gives every entry read since its last pass a second chance (up to three reads
+/// count), so popular responses stay and one-hit wonders leave after a short probation. Expired
+/// entries are dropped whenever they reach a tail.
+///
+/// Reads take a shard read lock and bump the entry's counter atomically. Only stores take the
+/// write lock.
+pub(super) struct Store {
+    shards: Box<[Shard]>,
+    shard_capacity: usize,
+    small_capacity: usize,
+}
+
+/// Aligned to its own cache lines so neighbouring shard locks do not false-share.
+#[repr(align(128))]
+#[derive(Default)]
+struct Shard {
+    state: RwLock<ShardState>,
+    /// Bytes held, mirrored from `state` for lock-free size reporting.
+    bytes: AtomicU64,
+}
+
+#[derive(Default)]
+struct ShardState {
+    slots: AHashMap<u64, Slot>,
+    small: VecDeque<Queued>,
+    main: VecDeque<Queued>,
+    small_bytes: usize,
+    main_bytes: usize,
+    ghost: VecDeque<u64>,
+    ghost_set: AHashSet<u64>,
+    next_id: u64,
+}
+
+struct Slot {
+    entry: Arc<CachedResponse>,
+    /// Matches the slot's queue record; records of replaced entries no longer match.
+    id: u64,
+    main: bool,
+}
+
+#[derive(Clone, Copy)]
+struct Queued {
+    hash: u64,
+    id: u64,
+}
+
+impl Store {
+    pub(super) fn new(capacity: u64) -> Self {
+        let total = usize::try_from(capacity).unwrap_or(usize::MAX);
+        let shard_capacity = total / SHARDS;
+        Self {
+            shards: (0..SHARDS).map(|_| Shard::default()).collect(),
+            shard_capacity,
+            small_capacity: (shard_capacity / 100).saturating_mul(SMALL_PERCENT),
+        }
+    }
+
+    pub(super) fn get(&self, hash: u64) -> Option<Arc<CachedResponse>> {
+        let state = self.shard(hash).read();
+        state.slots.get(&hash).map(|slot| Arc::clone(&slot.entry))
+    }
+
+    /// Store `entry` under `hash`, replacing any previous entry. Returns the entries evicted to
+    /// make room.
+    pub(super) fn insert(&self, hash: u64, entry: Arc<CachedResponse>) -> Vec<Arc<CachedResponse>> {
+        let mut evicted = Vec::new();
+        if entry.size > self.shard_capacity {
+            return evicted;
+        }
+        let shard = self.shard(hash);
+        let mut state = shard.write();
+        state.insert(hash, entry);
+        let now = Instant::now();
+        while state.small_bytes.saturating_add(state.main_bytes) > self.shard_capacity {
+            let progressed = if state.small_bytes > self.small_capacity || state.main.is_empty() {
+                state.evict_small(now, &mut evicted)
+            } else {
+                state.evict_main(now, &mut evicted)
+            };
+            if !progressed {
+                break;
+            }
+        }
+        state.compact();
+        let bytes = state.small_bytes.saturating_add(state.main_bytes);
+        shard
+            .bytes
+            .store(u64::try_from(bytes).unwrap_or(u64::MAX), Ordering::Relaxed);
+        evicted
+    }
+
+    pub(super) fn size_bytes(&self) -> u64 {
+        self.shards
+            .iter()
+            .map(|shard| shard.bytes.load(Ordering::Relaxed))
+            .fold(0, u64::saturating_add)
+    }
+
+    pub(super) fn len(&self) -> usize {
+        self.shards
+            .iter()
+            .map(|shard| shard.read().slots.len())
+            .fold(0, usize::saturating_add)
+    }
+
+    fn shard(&self, hash: u64) -> &Shard {
+        &self.shards[(hash >> SHARD_SHIFT) as usize]
+    }
+}
+
+impl Shard {
+    // A panic cannot leave the state half-updated in a way later operations trip on (a stale
+    // queue record is skipped), so recover from poisoning instead of failing every request.
+    fn read(&self) -> RwLockReadGuard<'_, ShardState> {
+        self.state.read().unwrap_or_else(|e| e.into_inner())
+    }
+
+    fn write(&self) -> RwLockWriteGuard<'_, ShardState> {
+        self.state.write().unwrap_or_else(|e| e.into_inner())
+    }
+}
+
+impl ShardState {
+    fn insert(&mut self, hash: u64, entry: Arc<CachedResponse>) {
+        let size = entry.size;
+        // A replaced entry keeps its place in the main FIFO; an entry evicted recently (ghost)
+        // is let straight back in.
+        let replaced_main = self.remove(hash).is_some_and(|slot| slot.main);
+        let main = replaced_main || self.ghost_set.remove(&hash);
+        let id = self.next_id;
+        self.next_id = self.next_id.wrapping_add(1);
+        let queued = Queued { hash, id };
+        if main {
+            self.main.push_front(queued);
+            self.main_bytes = self.main_bytes.saturating_add(size);
+        } else {
+            self.small.push_front(queued);
+            self.small_bytes = self.small_bytes.saturating_add(size);
+        }
+        self.slots.insert(hash, Slot { entry, id, main });
+    }
+
+    fn remove(&mut self, hash: u64) -> Option<Slot> {
+        let slot = self.slots.remove(&hash)?;
+        let bytes = if slot.main {
+            &mut self.main_bytes
+        } else {
+            &mut self.small_bytes
+        };
+        *bytes = bytes.saturating_sub(slot.entry.size);
+        Some(slot)
+    }
+
+    /// Take the small FIFO's tail: promote it if it was read, evict it to the ghost queue if not.
+    /// `false` when there is nothing left to take.
+    fn evict_small(&mut self, now: Instant, evicted: &mut Vec<Arc<CachedResponse>>) -> bool {
+        let Some(queued) = self.small.pop_back() else {
+            return self.evict_main(now, evicted);
+        };
+        let Some(entry) = self.live(queued) else {
+            return true;
+        };
+        if entry.frequency() > 0 && !entry.is_expired(now) {
+            entry.reset_frequency();
+            if let Some(slot) = self.slots.get_mut(&queued.hash) {
+                slot.main = true;
+            }
+            self.small_bytes = self.small_bytes.saturating_sub(entry.size);
+            self.main_bytes = self.main_bytes.saturating_add(entry.size);
+            self.main.push_front(queued);
+            return true;
+        }
+        self.remove(queued.hash);
+        if !entry.is_expired(now) {
+            self.remember(queued.hash);
+        }
+        evicted.push(entry);
+        true
+    }
+
+    /// Take the main FIFO's tail: give it another pass if it was read since its last one, evict
+    /// it if not. `false` when there is nothing left to take.
+    fn evict_main(&mut self, now: Instant, evicted: &mut Vec<Arc<CachedResponse>>) -> bool {
+        let Some(queued) = self.main.pop_back() else {
+            return false;
+        };
+        let Some(entry) = self.live(queued) else {
+            return true;
+        };
+        if entry.take_frequency() && !entry.is_expired(now) {
+            self.main.push_front(queued);
+            return true;
+        }
+        self.remove(queued.hash);
+        evicted.push(entry);
+        true
+    }
+
+    /// The entry `queued` refers to, unless it was replaced or removed since.
+    fn live(&self, queued: Queued) -> Option<Arc<CachedResponse>> {
+        self.slots
+            .get(&queued.hash)
+            .filter(|slot| slot.id == queued.id)
+            .map(|slot| Arc::clone(&slot.entry))
+    }
+
+    fn remember(&mut self, hash: u64) {
+        if self.ghost_set.insert(hash) {
+            self.ghost.push_front(hash);
+        }
+        let bound = self.slots.len().max(GHOST_MIN);
+        while self.ghost.len() > bound {
+            if let Some(old) = self.ghost.pop_back() {
+                self.ghost_set.remove(&old);
+            }
+        }
+    }
+
+    /// Drop queue records of replaced entries once they outnumber live ones, so a key stored
+    /// over and over in a cache that never fills does not grow the queues.
+    fn compact(&mut self) {
+        let bound = self.slots.len().saturating_mul(2).saturating_add(GHOST_MIN);
+        if self.small.len().saturating_add(self.main.len()) <= bound {
+            return;
+        }
+        let slots = &self.slots;
+        let live = |queued: &Queued| slots.get(&queued.hash).is_some_and(|s| s.id == queued.id);
+        self.small.retain(live);
+        self.main.retain(live);
+    }
+}
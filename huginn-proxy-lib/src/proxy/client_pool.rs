@@ -1,13 +1,26 @@
-use crate::config::{BackendPoolConfig, KeepAliveConfig};
+use crate::config::{
+    Backend, BackendHttpVersion, BackendPoolConfig, KeepAliveConfig, PrewarmConfig,
+};
+use crate::proxy::direct_client::DirectClient;
+use crate::proxy::warm_pool::{WarmConnector, WarmStash};
+use crate::telemetry::Metrics;
+use ahash::AHashMap;
 use http::Version;
 use hyper::body::Incoming;
 use hyper_util::client::legacy::connect::HttpConnector;
 use hyper_util::client::legacy::Client;
 use hyper_util::rt::TokioExecutor;
+use std::collections::HashMap;
 use std::sync::Arc;
 use std::time::Duration;
+use tracing::info;
 
-pub type HttpClient = Client<HttpConnector, Incoming>;
+pub type HttpClient = Client<WarmConnector, Incoming>;
+
+/// `protocol` label values of the prewarm metrics (`Debug` of the matching `http::Version`,
+/// like the backend request metrics).
+const PROTOCOL_HTTP11: &str = "HTTP/1.1";
+const PROTOCOL_HTTP2: &str = "HTTP/2.0";
 
 /// Shared HTTP client pool for backend connections
 ///
@@ -16,47 +29,141 @@ pub type HttpClient = Client<HttpConnector, Incoming>;
 ///
 /// # Force New Connection
 ///
-/// Routes can bypass pooling by setting `force_new_connection = true`.
+/// Routes can bypass pooling by setting `force_new_connection = true`; their requests go
+/// through the pool's [`DirectClient`], which dials a new connection per request.
 /// Use cases:
 /// - TCP fingerprinting (future feature)
 /// - Per-request TLS fingerprinting
+///
+/// # Per-backend clients
+///
+/// Every configured backend has its own pair of clients (see [`Self::with_backends`]), so a
+/// reload can drop the idle connections of a removed backend while the other backends keep
+/// theirs. Addresses that are not configured backends share one pair.
+///
+/// # Prewarming
+///
+/// With `backend_pool.prewarm` set, all clients draw new connections from a stash of spare
+/// TCP connections kept per backend (see [`Self::prewarm`]).
 #[derive(Clone)]
 pub struct ClientPool {
+    /// Clients of the configured backends, by address
+    backends: Arc<AHashMap<String, Arc<Clients>>>,
+
+    /// Clients for any other address
+    shared: Arc<Clients>,
+
+    /// Non-pooling sender for `force_new_connection` routes
+    direct: Arc<DirectClient>,
+
+    /// Spare-connection stashes of the clients; `None` unless prewarming is configured.
+    prewarm: Option<Arc<Prewarm>>,
+
+    /// What clients are built from, for backends added by a reload
+    settings: Arc<Settings>,
+}
+
+/// The HTTP/1.1 and HTTP/2 clients of one backend.
+struct Clients {
     /// Client for HTTP/1.1 requests (supports keep-alive and pooling)
     http11: Arc<HttpClient>,
 
     /// Client for HTTP/2 requests (http2_only with pooling)
     http2: Arc<HttpClient>,
+}
 
-    /// Configuration (stored for creating one-off clients)
+struct Settings {
     keep_alive: KeepAliveConfig,
-
-    /// TCP connect timeout (None = no timeout).
+    config: BackendPoolConfig,
     upstream_connect_ms: Option<u64>,
 }
 
+/// How a [`ClientPool::with_backends`] pool relates to the pool it was derived from.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct BackendReuse {
+    /// Backends that kept their clients and idle connections
+    pub reused: usize,
+    /// Backends that got new clients
+    pub added: usize,
+    /// Backends whose clients were dropped
+    pub removed: usize,
+}
+
+struct Prewarm {
+    config: PrewarmConfig,
+    http11: Arc<WarmStash>,
+    http2: Arc<WarmStash>,
+}
+
 impl ClientPool {
     pub fn new(
         keep_alive: &KeepAliveConfig,
         config: BackendPoolConfig,
         upstream_connect_ms: Option<u64>,
     ) -> Self {
-        let http11_client = Self::create_http11_client(keep_alive, &config, upstream_connect_ms);
-        let http2_client = Self::create_http2_client(keep_alive, &config, upstream_connect_ms);
+        let prewarm = config
+            .prewarm
+            .clone()
+            .filter(|_| config.enabled)
+            .map(|prewarm| {
+                let dial = Self::create_connector(keep_alive, upstream_connect_ms);
+                Arc::new(Prewarm {
+                    config: prewarm,
+                    http11: Arc::new(WarmStash::new(PROTOCOL_HTTP11, dial.clone())),
+                    http2: Arc::new(WarmStash::new(PROTOCOL_HTTP2, dial)),
+                })
+            });
+        let settings = Settings { keep_alive: keep_alive.clone(), config, upstream_connect_ms };
 
         Self {
-            http11: Arc::new(http11_client),
-            http2: Arc::new(http2_client),
-            keep_alive: keep_alive.clone(),
-            upstream_connect_ms,
+            backends: Arc::new(AHashMap::new()),
+            shared: Arc::new(Clients::new(&settings, prewarm.as_deref())),
+            direct: Arc::new(DirectClient::new(keep_alive, upstream_connect_ms)),
+            prewarm,
+            settings: Arc::new(settings),
         }
     }
 
-    fn create_http11_client(
+    /// This pool with clients for exactly `backends`: a backend that already has clients keeps
+    /// them (and their idle connections), a new one gets its own, and the clients of backends not
+    /// in the list are dropped once in-flight requests holding the old pool finish.
+    ///
+    /// The shared clients, the direct client, and the prewarm stashes carry over unchanged.
+    pub fn with_backends(&self, backends: &[Backend]) -> (Self, BackendReuse) {
+        let mut reuse = BackendReuse::default();
+        let mut clients = AHashMap::with_capacity(backends.len());
+        for backend in backends {
+            if clients.contains_key(&backend.address) {
+                continue;
+            }
+            let backend_clients = match self.backends.get(&backend.address) {
+                Some(existing) => {
+                    reuse.reused = reuse.reused.saturating_add(1);
+                    Arc::clone(existing)
+                }
+                None => {
+                    reuse.added = reuse.added.saturating_add(1);
+                    Arc::new(Clients::new(&self.settings, self.prewarm.as_deref()))
+                }
+            };
+            clients.insert(backend.address.clone(), backend_clients);
+        }
+        reuse.removed = self.backends.len().saturating_sub(reuse.reused);
+
+        let pool = Self {
+            backends: Arc::new(clients),
+            shared: Arc::clone(&self.shared),
+            direct: Arc::clone(&self.direct),
+            prewarm: self.prewarm.clone(),
+            settings: Arc::clone(&self.settings),
+        };
+        (pool, reuse)
+    }
+
+    fn create_connector(
         keep_alive: &KeepAliveConfig,
-        config: &BackendPoolConfig,
         upstream_connect_ms: Option<u64>,
-    ) -> HttpClient {
+    ) -> HttpConnector {
         let mut connector = HttpConnector::new();
         // TCP keep-alive: sends periodic packets to keep TCP connection alive
         if keep_alive.enabled {
@@ -65,6 +172,16 @@ impl ClientPool {
             connector.set_keepalive(None);
         }
         connector.set_connect_timeout(upstream_connect_ms.map(Duration::from_millis));
+        connector
+    }
+
+    fn create_http11_client(
+        keep_alive: &KeepAliveConfig,
+        config: &BackendPoolConfig,
+        upstream_connect_ms: Option<u64>,
+        stash: Option<Arc<WarmStash>>,
+    ) -> HttpClient {
+        let connector = Self::create_connector(keep_alive, upstream_connect_ms);
 
         let mut builder = Client::builder(TokioExecutor::new());
         builder.pool_idle_timeout(Duration::from_secs(config.idle_timeout));
@@ -74,23 +191,17 @@ impl ClientPool {
             builder.pool_max_idle_per_host(config.pool_max_idle_per_host);
         }
 
-        builder.build(connector)
+        builder.build(WarmConnector::new(connector, stash))
     }
 
     fn create_http2_client(
         keep_alive: &KeepAliveConfig,
         config: &BackendPoolConfig,
         upstream_connect_ms: Option<u64>,
+        stash: Option<Arc<WarmStash>>,
     ) -> HttpClient {
-        let mut connector = HttpConnector::new();
-        // TCP keep-alive: sends periodic packets to keep TCP connection alive
         // HTTP/2 uses persistent connections by default with native multiplexing
-        if keep_alive.enabled {
-            connector.set_keepalive(Some(Duration::from_secs(keep_alive.upstream_idle_timeout)));
-        } else {
-            connector.set_keepalive(None);
-        }
-        connector.set_connect_timeout(upstream_connect_ms.map(Duration::from_millis));
+        let connector = Self::create_connector(keep_alive, upstream_connect_ms);
 
         let mut builder = Client::builder(TokioExecutor::new());
         builder.http2_only(true);
@@ -101,38 +212,90 @@ impl ClientPool {
             builder.pool_max_idle_per_host(config.pool_max_idle_per_host);
         }
 
-        builder.build(connector)
+        builder.build(WarmConnector::new(connector, stash))
     }
 
-    /// Get the appropriate client for the given HTTP version
+    /// Point prewarming at `backends` and fill the spare connections, waiting at most
+    /// `prewarm.timeout_ms`; no-op unless `backend_pool.prewarm` is configured.
+    ///
+    /// Every backend gets `min_idle_per_backend` HTTP/1.1 spares, plus one HTTP/2 spare when
+    /// `prewarm.http2` is set and its `http_version` is `http2` or `preserve`. Call it on a new
+    /// pool before it is swapped in, and again on the live pool when backends are added. The first
+    /// call starts the background refill that replaces used and closed spares.
+    pub async fn prewarm(&self, backends: &[Backend], metrics: &Arc<Metrics>) {
+        let Some(prewarm) = &self.prewarm else {
+            return;
+        };
+        let config = &prewarm.config;
+        let http11_targets = backends
+            .iter()
+            .map(|b| (b.address.clone(), config.min_idle_per_backend))
+            .collect();
+        let http2_targets: HashMap<String, usize> = backends
+            .iter()
+            .filter(|b| {
+                config.http2
+                    && matches!(
+                        b.http_version,
+                        Some(BackendHttpVersion::Http2 | BackendHttpVersion::Preserve)
+                    )
+            })
+            .map(|b| (b.address.clone(), 1))
+            .collect();
+        prewarm.http11.set_targets(http11_targets);
+        prewarm.http2.set_targets(http2_targets);
+
+        let interval = Duration::from_millis(config.refill_interval_ms.max(1));
+        prewarm.http11.spawn_refill(interval, metrics);
+        prewarm.http2.spawn_refill(interval, metrics);
+
+        let fill = async { tokio::join!(prewarm.http11.fill(), prewarm.http2.fill()) };
+        if tokio::time::timeout(Duration::from_millis(config.timeout_ms), fill)
+            .await
+            .is_err()
+        {
+            info!(
+                timeout_ms = config.timeout_ms,
+                "Backend pool prewarm timed out; remaining connections are opened in the background"
+            );
+        }
+    }
+
+    /// Get the appropriate client for the given backend and HTTP version
     ///
     /// Returns `None` if `force_new` is true, signaling that the caller should
-    /// create a one-off client instead of using the pool.
+    /// send through [`Self::direct_client`] instead of using the pool.
     ///
     /// # Arguments
     ///
+    /// * `backend` - Backend address; one that is not a configured backend gets the shared clients
     /// * `version` - Target HTTP version
     /// * `force_new` - If true, bypass pooling and return None
     ///
     /// # Returns
     ///
     /// - `Some(&Arc<HttpClient>)` - Pooled client to use
-    /// - `None` - Create one-off client via `create_oneoff_client()`
-    pub fn get_client(&self, version: Version, force_new: bool) -> Option<&Arc<HttpClient>> {
+    /// - `None` - Send through [`Self::direct_client`]
+    pub fn get_client(
+        &self,
+        backend: &str,
+        version: Version,
+        force_new: bool,
+    ) -> Option<&Arc<HttpClient>> {
         if force_new {
-            None
-        } else {
-            Some(match version {
-                Version::HTTP_2 => &self.http2,
-                _ => &self.http11,
-            })
+            return None;
         }
+        let clients = self.backends.get(backend).unwrap_or(&self.shared);
+        Some(match version {
+            Version::HTTP_2 => &clients.http2,
+            _ => &clients.http11,
+        })
     }
 
-    /// Create a one-off client for `force_new_connection` scenarios
+    /// Non-pooling sender for `force_new_connection` scenarios
     ///
-    /// This client will NOT pool connections. Each request will establish
-    /// a new TCP connection and TLS handshake.
+    /// Built once with the pool; every request it sends establishes a new TCP connection
+    /// and HTTP handshake, and the connection is closed with the response.
     ///
     /// # Use Cases
     ///
@@ -142,24 +305,29 @@ impl ClientPool {
     ///
     /// # Performance Warning
     ///
-    /// Creating a new client per request adds latency
-    /// (TCP handshake + TLS handshake). Only use when necessary.
-    pub fn create_oneoff_client(&self, version: Version) -> HttpClient {
-        // For one-off clients, disable pooling by setting max idle to 0
-        let oneoff_config =
-            BackendPoolConfig { enabled: false, idle_timeout: 0, pool_max_idle_per_host: 0 };
-
-        match version {
-            Version::HTTP_2 => Self::create_http2_client(
-                &self.keep_alive,
-                &oneoff_config,
-                self.upstream_connect_ms,
-            ),
-            _ => Self::create_http11_client(
-                &self.keep_alive,
-                &oneoff_config,
-                self.upstream_connect_ms,
-            ),
+    /// A new connection per request adds latency (TCP handshake + TLS handshake).
+    /// Only use when necessary.
+    pub fn direct_client(&self) -> &DirectClient {
+        &self.direct
+    }
+}
+
+impl Clients {
+    fn new(settings: &Settings, prewarm: Option<&Prewarm>) -> Self {
+        let Settings { keep_alive, config, upstream_connect_ms } = settings;
+        Self {
+            http11: Arc::new(ClientPool::create_http11_client(
+                keep_alive,
+                config,
+                *upstream_connect_ms,
+                prewarm.map(|p| Arc::clone(&p.http11)),
+            )),
+            http2: Arc::new(ClientPool::create_http2_client(
+                keep_alive,
+                config,
+                *upstream_connect_ms,
+                prewarm.map(|p| Arc::clone(&p.http2)),
+            )),
         }
     }
 }
@@ -0,0 +1,172 @@
+use std::pin::Pin;
+use std::sync::{Arc, Mutex, MutexGuard};
+use std::task::{Context, Poll, Waker};
+
+use bytes::Bytes;
+use http::{HeaderMap, Response, StatusCode, Version};
+use http_body_util::BodyExt;
+use hyper::body::{Body, Frame, SizeHint};
+use tracing::debug;
+
+use crate::utils::http::RespBody;
+
+/// A response fanned out to the requests of one flight: its head, and the body frames the pump
+/// task has read from the backend so far.
+pub(super) struct SharedResponse {
+    status: StatusCode,
+    version: Version,
+    headers: HeaderMap,
+    len: u64,
+    log: Arc<Log>,
+}
+
+impl SharedResponse {
+    /// Start reading `response`'s body (of declared length `len`) in the background.
+    pub(super) fn spawn(response: Response<RespBody>, len: u64) -> Arc<Self> {
+        let (parts, body) = response.into_parts();
+        let log = Arc::new(Log::default());
+        tokio::spawn(pump(body, Arc::clone(&log), len));
+        Arc::new(Self {
+            status: parts.status,
+            version: parts.version,
+            headers: parts.headers,
+            len,
+            log,
+        })
+    }
+
+    /// A copy of the response whose body replays the shared frames from the start.
+    pub(super) fn response(&self) -> Response<RespBody> {
+        let body = SharedBody { log: Arc::clone(&self.log), next: 0, remaining: self.len };
+        let mut response = Response::new(body.boxed());
+        *response.status_mut() = self.status;
+        *response.version_mut() = self.version;
+        *response.headers_mut() = self.headers.clone();
+        response
+    }
+}
+
+enum SharedFrame {
+    Data(Bytes),
+    Trailers(HeaderMap),
+}
+
+/// Frames read so far. Kept until the last reader is dropped, which the declared length bounds.
+#[derive(Default)]
+struct Log {
+    state: Mutex<LogState>,
+}
+
+#[derive(Default)]
+struct LogState {
+    frames: Vec<SharedFrame>,
+    /// Set once the backend body ended, cleanly or not; no frame is added after it.
+    done: bool,
+    /// Readers waiting for the next frame.
+    wakers: Vec<Waker>,
+}
+
+impl Log {
+    // Frames are only appended, so a panic cannot leave the log inconsistent.
+    fn lock(&self) -> MutexGuard<'_, LogState> {
+        self.state.lock().unwrap_or_else(|e| e.into_inner())
+    }
+
+    fn push(&self, frame: SharedFrame) {
+        let wakers = {
+            let mut state = self.lock();
+            state.frames.push(frame);
+            std::mem::take(&mut state.wakers)
+        };
+        wakers.into_iter().for_each(Waker::wake);
+    }
+
+    fn finish(&self) {
+        let wakers = {
+            let mut state = self.lock();
+            state.done = true;
+            std::mem::take(&mut state.wakers)
+        };
+        wakers.into_iter().for_each(Waker::wake);
+    }
+}
+
+/// Read the backend body into `log` for every reader, independent of any one client: the
+/// leader's client going away does not cut the body short for the others.
+///
+/// A backend error, or a body longer than declared, ends the log early. Readers then end short
+/// of `Content-Length`, which the server turns into an aborted response, as it would for the
+/// leader alone.
+async fn pump(mut body: RespBody, log: Arc<Log>, len: u64) {
+    let mut received: u64 = 0;
+    // Stop pulling from the backend once every reader is gone.
+    while Arc::strong_count(&log) > 1 {
+        let frame = match body.frame().await {
+            Some(Ok(frame)) => frame,
+            Some(Err(e)) => {
+                debug!(error = %e, "Coalesced response body failed");
+                break;
+            }
+            None => break,
+        };
+        let frame = match frame.into_data() {
+            Ok(data) => {
+                received = received.saturating_add(u64::try_from(data.len()).unwrap_or(u64::MAX));
+                if received > len {
+                    debug!(len, "Coalesced response body longer than its Content-Length");
+                    break;
+                }
+                SharedFrame::Data(data)
+            }
+            Err(frame) => match frame.into_trailers() {
+                Ok(trailers) => SharedFrame::Trailers(trailers),
+                Err(_) => continue,
+            },
+        };
+        log.push(frame);
+    }
+    log.finish();
+}
+
+/// One reader of a [`Log`].
+struct SharedBody {
+    log: Arc<Log>,
+    next: usize,
+    remaining: u64,
+}
+
+impl Body for SharedBody {
+    type Data = Bytes;
+    type Error = hyper::Error;
+
+    fn poll_frame(
+        self: Pin<&mut Self>,
+        cx: &mut Context<'_>,
+    ) -> Poll<Option<Result<Frame<Bytes>, hyper::Error>>> {
+        let this = self.get_mut();
+        let mut state = this.log.lock();
+        let Some(frame) = state.frames.get(this.next) else {
+            if state.done {
+                return Poll::Ready(None);
+            }
+            if !state.wakers.iter().any(|w| w.will_wake(cx.waker())) {
+                state.wakers.push(cx.waker().clone());
+            }
+            return Poll::Pending;
+        };
+        this.next = this.next.saturating_add(1);
+        let frame = match frame {
+            SharedFrame::Data(data) => {
+                let len = u64::try_from(data.len()).unwrap_or(u64::MAX);
+                this.remaining = this.remaining.saturating_sub(len);
+                Frame::data(data.clone())
+            }
+            SharedFrame::Trailers(trailers) => Frame::trailers(trailers.clone()),
+        };
+        Poll::Ready(Some(Ok(frame)))
+    }
+
+    fn size_hint(&self) -> SizeHint {
+        SizeHint::with_exact(self.remaining)
+    }
+}
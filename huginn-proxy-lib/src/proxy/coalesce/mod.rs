@@ -0,0 +1,282 @@
+//! Request coalescing (single-flight), enabled per route with `[domains.routes.coalesce]`.
+//!
+//! The first coalescable request for a key becomes the leader of a flight and is forwarded.
+//! Identical requests arriving while it is in flight join as followers: they take no
+//! concurrency permit and send nothing upstream, and wait up to `max_wait_ms` for the leader's
+//! outcome. A shareable response is then read once from the backend by a background task, and
+//! the leader and every follower stream the same [`Bytes`] frames from it. A follower that
+//! times out, or whose leader got a response that may not be shared (or went away), is
+//! forwarded on its own.
+//!
+//! On a route that also has `cache`, the leader's response is stored before it is shared, so
+//! the followers of a miss are the last requests to need the backend.
+
+mod body;
+
+use std::sync::{Arc, Mutex, MutexGuard};
+
+use ahash::{AHashMap, RandomState};
+use http::header::{AUTHORIZATION, CONTENT_LENGTH, COOKIE, TRANSFER_ENCODING};
+use http::{HeaderMap, HeaderName, Method, Request, Response};
+use hyper::body::Body;
+use tokio::sync::watch;
+use tokio::time::Duration;
+
+use crate::config::RouteCoalesceConfig;
+use crate::proxy::cache::policy;
+use crate::proxy::http_result::{HttpError, HttpResult};
+use crate::telemetry::metrics::values;
+use crate::telemetry::{Metrics, RouteAttributes};
+use crate::utils::http::RespBody;
+use body::SharedResponse;
+
+/// Flight map shards; the low bits of a key's hash pick its shard.
+const SHARDS: usize = 16;
+const SHARD_MASK: u64 = SHARDS as u64 - 1;
+
+/// What identifies a flight, borrowed from the request. The values of the route's `vary`
+/// headers are added when it is encoded.
+#[derive(Debug, Clone, Copy)]
+pub struct CoalesceKey<'a> {
+    pub https: bool,
+    pub host: &'a str,
+    pub backend: &'a str,
+    /// Matched route prefix. With the path it determines the rewritten upstream URI, and it
+    /// keeps routes with different security headers apart.
+    pub route: &'a str,
+    pub path_and_query: &'a str,
+}
+
+impl CoalesceKey<'_> {
+    fn encode(&self, vary: &[HeaderName], headers: &HeaderMap) -> Vec<u8> {
+        // NUL and SOH cannot appear in a host, path or header value, so they delimit fields
+        // and values unambiguously (an absent header differs from an empty one).
+        let mut key = vec![u8::from(self.https)];
+        for part in [self.host, self.backend, self.route, self.path_and_query] {
+            key.extend_from_slice(part.as_bytes());
+            key.push(0);
+        }
+        for name in vary {
+            for value in headers.get_all(name) {
+                key.extend_from_slice(value.as_bytes());
+                key.push(1);
+            }
+            key.push(0);
+        }
+        key
+    }
+}
+
+#[derive(Clone)]
+enum Outcome {
+    Shared(Arc<SharedResponse>),
+    /// The leader's forward failed; followers answer with the same error.
+    Failed(HttpError),
+    /// Forward on your own: the response may not be shared, or the leader went away.
+    Fallback,
+}
+
+type Flights = AHashMap<Arc<[u8]>, watch::Receiver<Option<Outcome>>>;
+
+/// Result of [`Coalescer::join`].
+pub enum Join<'a> {
+    /// Forward the request, then pass the result to [`Leader::complete`].
+    Leader(Leader<'a>),
+    /// An identical request is in flight; [`Follower::wait`] for its outcome.
+    Follower(Follower),
+    /// Not a request that may share a response.
+    Bypass,
+}
+
+/// In-flight requests, shared by every route with `coalesce`; see the module docs.
+///
+/// Static: a config reload leaves flights in progress alone.
+pub struct Coalescer {
+    shards: Box<[Mutex<Flights>]>,
+    hasher: RandomState,
+}
+
+impl Default for Coalescer {
+    fn default() -> Self {
+        Self::new()
+    }
+}
+
+impl Coalescer {
+    pub fn new() -> Self {
+        Self {
+            shards: (0..SHARDS).map(|_| Mutex::default()).collect(),
+            hasher: RandomState::new(),
+        }
+    }
+
+    /// Lead a new flight for `req`, or follow the one in progress. Records leaders.
+    pub fn join<'a, B>(
+        &'a self,
+        req: &Request<B>,
+        key: &CoalesceKey<'_>,
+        config: &'a RouteCoalesceConfig,
+        route: &RouteAttributes,
+        metrics: &Metrics,
+    ) -> Join<'a> {
+        if !coalescable(req, &config.vary) {
+            return Join::Bypass;
+        }
+        let key = key.encode(&config.vary, req.headers());
+        let shard = (self.hasher.hash_one(&key) & SHARD_MASK) as usize;
+        let mut flights = self.lock(shard);
+        if let Some(rx) = flights.get(key.as_slice()) {
+            let rx = rx.clone();
+            drop(flights);
+            return Join::Follower(Follower {
+                rx,
+                max_wait: Duration::from_millis(config.max_wait_ms),
+            });
+        }
+        let key: Arc<[u8]> = key.into();
+        let (tx, rx) = watch::channel(None);
+        flights.insert(Arc::clone(&key), rx);
+        drop(flights);
+        metrics.record_coalesce(values::COALESCE_LEADER, route);
+        Join::Leader(Leader { coalescer: self, shard, key: Some(key), tx, config })
+    }
+
+    /// Flights in progress (takes every shard lock; not for the request path).
+    pub fn len(&self) -> usize {
+        (0..SHARDS)
+            .map(|shard| self.lock(shard).len())
+            .fold(0, usize::saturating_add)
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    // The map is only inserted into and removed from, so recover from poisoning.
+    fn lock(&self, shard: usize) -> MutexGuard<'_, Flights> {
+        self.shards[shard].lock().unwrap_or_else(|e| e.into_inner())
+    }
+}
+
+/// A `GET` without a body, whose credentials (if any) are part of the key.
+fn coalescable<B>(req: &Request<B>, vary: &[HeaderName]) -> bool {
+    let headers = req.headers();
+    let has_body = headers.contains_key(TRANSFER_ENCODING)
+        || headers
+            .get(CONTENT_LENGTH)
+            .is_some_and(|v| v.as_bytes() != b"0");
+    req.method() == Method::GET
+        && !has_body
+        && [AUTHORIZATION, COOKIE]
+            .iter()
+            .all(|name| !headers.contains_key(name) || vary.contains(name))
+}
+
+/// The leader of a flight. Dropping it without [`Leader::complete`] (the request was cancelled)
+/// sends its followers upstream on their own.
+pub struct Leader<'a> {
+    coalescer: &'a Coalescer,
+    shard: usize,
+    key: Option<Arc<[u8]>>,
+    tx: watch::Sender<Option<Outcome>>,
+    config: &'a RouteCoalesceConfig,
+}
+
+impl Leader<'_> {
+    /// Hand the forward result to the followers, and return the leader's own response.
+    pub fn complete(
+        mut self,
+        result: HttpResult<Response<RespBody>>,
+    ) -> HttpResult<Response<RespBody>> {
+        self.leave();
+        // Only the followers' receivers are left once the flight is out of the map.
+        if self.tx.receiver_count() == 0 {
+            return result;
+        }
+        let response = match result {
+            Ok(response) => response,
+            Err(error) => {
+                self.tx.send_replace(Some(Outcome::Failed(error.clone())));
+                return Err(error);
+            }
+        };
+        let Some(len) = shared_length(&response, self.config) else {
+            self.tx.send_replace(Some(Outcome::Fallback));
+            return Ok(response);
+        };
+        let shared = SharedResponse::spawn(response, len);
+        let own = shared.response();
+        self.tx.send_replace(Some(Outcome::Shared(shared)));
+        Ok(own)
+    }
+
+    /// Take the flight out of the map, so later requests start a new one.
+    fn leave(&mut self) {
+        if let Some(key) = self.key.take() {
+            self.coalescer.lock(self.shard).remove(&key);
+        }
+    }
+}
+
+impl Drop for Leader<'_> {
+    fn drop(&mut self) {
+        self.leave();
+    }
+}
+
+/// Body length of a response that may go to every follower, or `None`.
+///
+/// The response must be shareable (see [`policy::shareable`]), vary only on headers in the key,
+/// and have a declared length within `max_body_bytes`, which bounds what a flight buffers.
+fn shared_length(response: &Response<RespBody>, config: &RouteCoalesceConfig) -> Option<u64> {
+    let headers = response.headers();
+    let keyed = policy::vary_fields(headers).all(|field| {
+        config
+            .vary
+            .iter()
+            .any(|name| name.as_str().eq_ignore_ascii_case(field))
+    });
+    if !keyed || !policy::shareable(headers) {
+        return None;
+    }
+    headers
+        .get(CONTENT_LENGTH)
+        .and_then(|v| v.to_str().ok())
+        .and_then(|v| v.parse::<u64>().ok())
+        .or_else(|| response.body().size_hint().exact())
+        .filter(|&len| len <= config.max_body_bytes)
+}
+
+/// A request waiting on another's flight.
+pub struct Follower {
+    rx: watch::Receiver<Option<Outcome>>,
+    max_wait: Duration,
+}
+
+impl Follower {
+    /// The leader's response (or error), or `None` to forward on its own. Records the result.
+    pub async fn wait(
+        mut self,
+        route: &RouteAttributes,
+        metrics: &Metrics,
+    ) -> Option<HttpResult<Response<RespBody>>> {
+        let outcome =
+            match tokio::time::timeout(self.max_wait, self.rx.wait_for(Option::is_some)).await {
+                Ok(Ok(outcome)) => Option::clone(&outcome),
+                // Timed out, or the leader was dropped without completing.
+                Ok(Err(_)) | Err(_) => None,
+            };
+        let result = match outcome {
+            Some(Outcome::Shared(shared)) => Some(Ok(shared.response())),
+            Some(Outcome::Failed(error)) => Some(Err(error)),
+            Some(Outcome::Fallback) | None => None,
+        };
+        let label = if result.is_some() {
+            values::COALESCE_FOLLOWER
+        } else {
+            values::COALESCE_FALLBACK
+        };
+        metrics.record_coalesce(label, route);
+        result
+    }
+}
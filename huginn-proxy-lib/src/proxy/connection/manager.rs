@@ -1,9 +1,11 @@
+use std::net::IpAddr;
 use std::sync::atomic::{AtomicUsize, Ordering};
 use std::sync::Arc;
 use thiserror::Error;
 use tokio::sync::watch;
-use tracing::warn;
+use tracing::{debug, warn};
 
+use crate::proxy::admission::{PerIpGuard, PerIpLimit, SchedulerLag};
 use crate::telemetry::metrics::values;
 use crate::telemetry::Metrics;
 
@@ -16,6 +18,10 @@ pub enum ConnectionError {
     Shutdown,
     #[error("Connection limit exceeded (current: {current}, limit: {limit})")]
     LimitExceeded { current: usize, limit: usize },
+    #[error("Scheduler lag {lag_ms}ms exceeds max_scheduler_lag_ms")]
+    SchedulerLag { lag_ms: u128 },
+    #[error("Client {ip} already holds max_connections_per_ip ({limit})")]
+    PerIpLimitExceeded { ip: IpAddr, limit: u32 },
 }
 
 /// Manages connection limits and lifecycle
@@ -24,6 +30,8 @@ pub struct ConnectionManager {
     max_connections: usize,
     shutdown_signal: Arc<AtomicUsize>,
     connections_closed_tx: watch::Sender<()>,
+    /// `None` when `[admission].max_connections_per_ip` is `0`.
+    per_ip: Option<Arc<PerIpLimit>>,
 }
 
 impl ConnectionManager {
@@ -37,9 +45,16 @@ impl ConnectionManager {
             max_connections,
             shutdown_signal,
             connections_closed_tx,
+            per_ip: None,
         }
     }
 
+    /// Cap the concurrent connections of each client IP at `limit` (`0` = unlimited).
+    pub fn with_per_ip_limit(mut self, limit: u32) -> Self {
+        self.per_ip = (limit > 0).then(|| Arc::new(PerIpLimit::new(limit)));
+        self
+    }
+
     /// Get the active connections counter (for metrics)
     pub fn active_connections(&self) -> Arc<AtomicUsize> {
         self.active_connections.clone()
@@ -52,9 +67,13 @@ impl ConnectionManager {
 
     /// Try to accept a new connection
     /// Returns Ok(guard) if connection is accepted, Err(ConnectionError) if rejected
+    ///
+    /// `scheduler_lag` is the probe of the runtime the accept loop runs on, when
+    /// `[admission].max_scheduler_lag_ms` is set.
     pub fn try_accept(
         &self,
         peer: std::net::SocketAddr,
+        scheduler_lag: Option<&SchedulerLag>,
         metrics: &Arc<Metrics>,
     ) -> Result<ConnectionGuard, ConnectionError> {
         // Check if shutdown was requested
@@ -62,26 +81,36 @@ impl ConnectionManager {
             return Err(ConnectionError::Shutdown);
         }
 
-        // TODO: race condition, two threads can both read the same count, pass the limit check,
-        // and both increment, exceeding max_connections. Fix: fetch_add first, then revert if over limit.
-        // Check connection limit (DoS protection)
-        let current_connections = self.active_connections.load(Ordering::Relaxed);
-        if current_connections >= self.max_connections {
+        if let Some(lag) = scheduler_lag.filter(|lag| lag.saturated()) {
+            metrics.record_connection_rejected(values::REASON_SCHEDULER_LAG);
+            // Debug only: the metric carries the signal, and a warning per refused connection
+            // would add work to a runtime that is already behind.
+            debug!(lag = ?lag.lag(), peer = %peer, "Scheduler lagging, rejecting connection");
+            return Err(ConnectionError::SchedulerLag { lag_ms: lag.lag().as_millis() });
+        }
+
+        // Check connection limit (DoS protection). The check and the increment are one atomic
+        // step, so concurrent accepts cannot both pass at `max_connections - 1`.
+        let max_connections = self.max_connections;
+        if let Err(current_connections) =
+            self.active_connections
+                .fetch_update(Ordering::AcqRel, Ordering::Relaxed, |n| {
+                    (n < max_connections).then(|| n.saturating_add(1))
+                })
+        {
             metrics.record_connection_rejected(values::REASON_LIMIT_EXCEEDED);
             warn!(
                 current = current_connections,
-                limit = self.max_connections,
+                limit = max_connections,
                 peer = %peer,
                 "Connection limit exceeded, rejecting connection"
             );
             return Err(ConnectionError::LimitExceeded {
                 current: current_connections,
-                limit: self.max_connections,
+                limit: max_connections,
             });
         }
 
-        self.active_connections.fetch_add(1, Ordering::Relaxed);
-
         metrics.connections_total.add(1, &[]);
         metrics.connections_active.add(1, &[]);
 
@@ -91,4 +120,25 @@ impl ConnectionManager {
             metrics.connections_active.clone(),
         ))
     }
+
+    /// Count the connection against its client IP, once the PROXY protocol header (if any) has
+    /// been resolved. Hold the returned guard for the life of the connection; it is `None` when
+    /// no per-IP cap is configured.
+    pub fn try_accept_client(
+        &self,
+        ip: IpAddr,
+        metrics: &Arc<Metrics>,
+    ) -> Result<Option<PerIpGuard>, ConnectionError> {
+        let Some(per_ip) = &self.per_ip else {
+            return Ok(None);
+        };
+        match per_ip.try_acquire(ip) {
+            Some(guard) => Ok(Some(guard)),
+            None => {
+                metrics.record_connection_rejected(values::REASON_PER_IP_LIMIT);
+                debug!(%ip, limit = per_ip.limit(), "Per-IP connection limit exceeded");
+                Err(ConnectionError::PerIpLimitExceeded { ip, limit: per_ip.limit() })
+            }
+        }
+    }
 }
@@ -0,0 +1,113 @@
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::{Mutex, MutexGuard};
+
+/// Upper bound on distinct hosts (and, separately, routes) remembered per connection. Real
+/// clients coalesce a handful of hosts onto one connection; past the bound decisions are still
+/// computed, just not stored, so a client cycling `:authority` values cannot grow the memo.
+const MAX_ENTRIES: usize = 16;
+
+/// Request-invariant decisions for one request host on a connection.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct HostDecision {
+    /// Index of the matched domain in the connection's [`RoutingTable`](crate::proxy::router::RoutingTable);
+    /// `None` means no domain (HTTP 421).
+    pub domain_index: Option<usize>,
+    /// Whether the host is served by the certificate the connection's SNI selected (always
+    /// `true` on connections without SNI).
+    pub authoritative: bool,
+    /// Some route of the domain overrides `ip_filter`, so the IP check runs after routing.
+    pub defer_ip_check: bool,
+    /// Pre-routing IP-ACL verdict against the domain (or global) filter; meaningless when
+    /// `defer_ip_check` is set.
+    pub ip_allowed: bool,
+}
+
+/// Per-connection cache of routing and security decisions that only depend on the connection's
+/// fixed inputs (peer, SNI and the config snapshot taken at accept time) plus the request host
+/// or matched route.
+///
+/// Owned by the connection's service closure, so every HTTP/2 stream and HTTP/1.1 keep-alive
+/// request on the connection reuses it; it never outlives the snapshot its indices point into.
+/// Metrics are still recorded per request by the caller, only the computation is skipped.
+#[derive(Debug, Default)]
+pub struct ConnectionMemo {
+    state: Mutex<MemoState>,
+    /// The connection's fingerprints were queued for export (`[telemetry.fingerprint_export]`).
+    fingerprints_exported: AtomicBool,
+}
+
+#[derive(Debug, Default)]
+struct MemoState {
+    hosts: Vec<(Box<str>, HostDecision)>,
+    /// `(domain index, matched prefix)` → route-level IP-ACL verdict.
+    route_ip: Vec<(usize, Box<str>, bool)>,
+}
+
+impl ConnectionMemo {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    /// The decision for `host`, running `compute` only on the first request for it.
+    pub fn host_decision(
+        &self,
+        host: &str,
+        compute: impl FnOnce() -> HostDecision,
+    ) -> HostDecision {
+        let cached = self
+            .lock()
+            .hosts
+            .iter()
+            .find(|(h, _)| &**h == host)
+            .map(|(_, d)| *d);
+        if let Some(decision) = cached {
+            return decision;
+        }
+        // Computed outside the lock: concurrent streams may race to fill the same entry, which
+        // is harmless since the result is deterministic.
+        let decision = compute();
+        let mut state = self.lock();
+        if state.hosts.len() < MAX_ENTRIES && !state.hosts.iter().any(|(h, _)| &**h == host) {
+            state.hosts.push((host.into(), decision));
+        }
+        decision
+    }
+
+    /// The route-level (deferred) IP-ACL verdict for `prefix` in domain `domain_index`, running
+    /// `compute` only on the first request for that route.
+    pub fn route_ip_allowed(
+        &self,
+        domain_index: usize,
+        prefix: &str,
+        compute: impl FnOnce() -> bool,
+    ) -> bool {
+        let matches = |(d, p, _): &&(usize, Box<str>, bool)| *d == domain_index && &**p == prefix;
+        let cached = self
+            .lock()
+            .route_ip
+            .iter()
+            .find(matches)
+            .map(|&(_, _, allowed)| allowed);
+        if let Some(allowed) = cached {
+            return allowed;
+        }
+        let allowed = compute();
+        let mut state = self.lock();
+        if state.route_ip.len() < MAX_ENTRIES && !state.route_ip.iter().any(|e| matches(&e)) {
+            state.route_ip.push((domain_index, prefix.into(), allowed));
+        }
+        allowed
+    }
+
+    /// `true` for the first caller on the connection only: its fingerprints are exported once,
+    /// not once per keep-alive request or HTTP/2 stream.
+    pub fn claim_fingerprint_export(&self) -> bool {
+        !self.fingerprints_exported.swap(true, Ordering::Relaxed)
+    }
+
+    fn lock(&self) -> MutexGuard<'_, MemoState> {
+        // A panicking request cannot leave the memo half-written (entries are pushed whole),
+        // so recover from poisoning instead of failing every later request on the connection.
+        self.state.lock().unwrap_or_else(|e| e.into_inner())
+    }
+}
@@ -1,7 +1,7 @@
 pub mod guards;
 pub mod manager;
-pub mod stream;
+pub mod memo;
 
 pub use guards::{ConnectionGuard, TlsConnectionGuard};
 pub use manager::{ConnectionError, ConnectionManager};
-pub use stream::PrefixedStream;
+pub use memo::{ConnectionMemo, HostDecision};
@@ -0,0 +1,154 @@
+//! Non-pooling send path for `force_new_connection` routes.
+//!
+//! Every request gets a freshly dialed TCP connection and its own HTTP/1.1 or HTTP/2
+//! handshake, driven directly through `hyper::client::conn`; no per-request `Client`,
+//! connector or pool is built. Backend addresses are resolved once and cached, so the
+//! per-request cost is the socket and the handshake.
+
+use std::net::SocketAddr;
+use std::sync::Arc;
+use std::time::Duration;
+
+use ahash::AHashMap;
+use arc_swap::ArcSwap;
+use http::uri::PathAndQuery;
+use http::{Request, Response, Uri, Version};
+use hyper::body::{Body, Incoming};
+use hyper_util::rt::{TokioExecutor, TokioIo};
+use socket2::{SockRef, TcpKeepalive};
+use tokio::net::TcpStream;
+use tracing::debug;
+
+use crate::config::KeepAliveConfig;
+
+pub type DirectError = Box<dyn std::error::Error + Send + Sync>;
+
+/// Dials one connection per request; built once per [`ClientPool`](super::ClientPool).
+pub struct DirectClient {
+    /// TCP keep-alive idle time (None = disabled), matching the pooled connectors.
+    tcp_keepalive: Option<Duration>,
+    connect_timeout: Option<Duration>,
+    /// Resolved addresses per backend authority (`host:port`). An entry is dropped when no
+    /// address accepts, so DNS changes are picked up on the next request.
+    resolved: ArcSwap<AHashMap<String, Arc<[SocketAddr]>>>,
+}
+
+impl DirectClient {
+    pub fn new(keep_alive: &KeepAliveConfig, upstream_connect_ms: Option<u64>) -> Self {
+        Self {
+            tcp_keepalive: keep_alive
+                .enabled
+                .then(|| Duration::from_secs(keep_alive.upstream_idle_timeout)),
+            connect_timeout: upstream_connect_ms.map(Duration::from_millis),
+            resolved: ArcSwap::default(),
+        }
+    }
+
+    /// Send `req` (absolute `http://` URI, as built by `forward`) over a new connection
+    /// speaking `version` (`HTTP_2` for prior-knowledge HTTP/2, otherwise HTTP/1.1).
+    ///
+    /// HTTP/1.1 requests are sent in origin form with a `Host` header for the backend
+    /// added when absent, as the pooled client does.
+    pub async fn send<B>(
+        &self,
+        mut req: Request<B>,
+        version: Version,
+    ) -> Result<Response<Incoming>, DirectError>
+    where
+        B: Body + Send + Unpin + 'static,
+        B::Data: Send,
+        B::Error: Into<DirectError>,
+    {
+        let authority = req
+            .uri()
+            .authority()
+            .ok_or("request URI has no backend authority")?
+            .clone();
+        let stream = self.connect(authority.as_str()).await?;
+        let io = TokioIo::new(stream);
+
+        if version == Version::HTTP_2 {
+            let (mut sender, conn) =
+                hyper::client::conn::http2::handshake(TokioExecutor::new(), io).await?;
+            tokio::spawn(async move {
+                if let Err(e) = conn.await {
+                    debug!(error = %e, "Direct HTTP/2 backend connection closed with error");
+                }
+            });
+            return Ok(sender.send_request(req).await?);
+        }
+
+        if !req.headers().contains_key(http::header::HOST) {
+            let host = http::HeaderValue::from_str(authority.as_str())?;
+            req.headers_mut().insert(http::header::HOST, host);
+        }
+        let origin_form = req
+            .uri()
+            .path_and_query()
+            .cloned()
+            .unwrap_or_else(|| PathAndQuery::from_static("/"));
+        *req.uri_mut() = Uri::from(origin_form);
+
+        let (mut sender, conn) = hyper::client::conn::http1::handshake(io).await?;
+        tokio::spawn(async move {
+            if let Err(e) = conn.await {
+                debug!(error = %e, "Direct HTTP/1.1 backend connection closed with error");
+            }
+        });
+        Ok(sender.send_request(req).await?)
+    }
+
+    async fn connect(&self, authority: &str) -> Result<TcpStream, DirectError> {
+        let addrs = self.resolve(authority).await?;
+        let mut last_error: Option<std::io::Error> = None;
+        for addr in addrs.iter() {
+            match self.connect_addr(*addr).await {
+                Ok(stream) => return Ok(stream),
+                Err(e) => last_error = Some(e),
+            }
+        }
+        self.resolved.rcu(|map| {
+            let mut map = AHashMap::clone(map);
+            map.remove(authority);
+            map
+        });
+        Err(last_error
+            .map(DirectError::from)
+            .unwrap_or_else(|| format!("no address for backend {authority}").into()))
+    }
+
+    async fn connect_addr(&self, addr: SocketAddr) -> std::io::Result<TcpStream> {
+        let connecting = TcpStream::connect(addr);
+        let stream = match self.connect_timeout {
+            Some(timeout) => tokio::time::timeout(timeout, connecting)
+                .await
+                .map_err(|_| {
+                    std::io::Error::new(std::io::ErrorKind::TimedOut, "connect timeout")
+                })??,
+            None => connecting.await?,
+        };
+        if let Some(idle) = self.tcp_keepalive {
+            SockRef::from(&stream).set_tcp_keepalive(&TcpKeepalive::new().with_time(idle))?;
+        }
+        Ok(stream)
+    }
+
+    async fn resolve(&self, authority: &str) -> Result<Arc<[SocketAddr]>, DirectError> {
+        if let Some(addrs) = self.resolved.load().get(authority) {
+            return Ok(Arc::clone(addrs));
+        }
+        let addrs: Arc<[SocketAddr]> = match authority.parse::<SocketAddr>() {
+            Ok(addr) => Arc::from([addr]),
+            Err(_) => tokio::net::lookup_host(authority).await?.collect(),
+        };
+        if addrs.is_empty() {
+            return Err(format!("backend {authority} resolved to no address").into());
+        }
+        self.resolved.rcu(|map| {
+            let mut map = AHashMap::clone(map);
+            map.insert(authority.to_string(), Arc::clone(&addrs));
+            map
+        });
+        Ok(addrs)
+    }
+}
@@ -1,11 +1,17 @@
+use crate::backend::{BackendStats, SelectedBackend};
 use crate::config::{BackendHttpVersion, KeepAliveConfig};
+use crate::proxy::direct_client::DirectError;
 use crate::proxy::http_result::{HttpError, HttpResult};
 use crate::proxy::ClientPool;
-use crate::telemetry::Metrics;
+use crate::telemetry::attributes::backend_address;
+use crate::telemetry::{Metrics, RequestAttributes, RouteAttributes};
 use crate::utils::http::RespBody;
-use http::{Request, Response, Version};
+use bytes::Bytes;
+use http::uri::{self, Authority, PathAndQuery, Scheme};
+use http::{Request, Response, Uri, Version};
 use http_body_util::BodyExt;
 use hyper::body::Incoming;
+use opentelemetry::KeyValue;
 use std::sync::Arc;
 use tokio::time::Instant;
 
@@ -18,8 +24,9 @@ pub struct ForwardConfig<'a> {
     pub security_headers: Option<&'a crate::config::SecurityHeaders>,
     pub is_https: bool,
     pub preserve_host: bool,
-    pub route: &'a str,
-    pub domain: &'a str,
+    /// Method and protocol labels of the client request.
+    pub request: &'a RequestAttributes,
+    pub route: &'a RouteAttributes,
     pub client_pool: &'a Arc<ClientPool>,
     pub force_new_connection: bool,
 }
@@ -58,47 +65,96 @@ pub fn determine_http_version(
     }
 }
 
-pub async fn forward(
-    mut req: Request<Incoming>,
-    backend: String,
-    config: ForwardConfig<'_>,
-) -> HttpResult<Response<RespBody>> {
-    let start = Instant::now();
-    let protocol = format!("{:?}", req.version());
-
-    let org_pq = req
-        .uri()
-        .path_and_query()
-        .map(|pq| pq.as_str())
-        .unwrap_or("/")
-        .as_bytes();
-
-    // Replace some parts of path if replace_path is enabled for chosen upstream
-    let new_pq = match config.replace_path {
-        Some(new_path) => {
-            let matched_path: &[u8] = config.matched_prefix.as_bytes();
+/// Upstream request URI: `http://{authority}` followed by the request's path and query, with
+/// `matched_prefix` replaced by `replace_path` when set.
+///
+/// Without `replace_path` the original path-and-query is reused as is (a reference-counted
+/// clone); with it, the rewritten path is built in a single allocation.
+pub fn upstream_uri(
+    authority: Authority,
+    original: &Uri,
+    matched_prefix: &str,
+    replace_path: Option<&str>,
+) -> HttpResult<Uri> {
+    let path_and_query = match (replace_path, original.path_and_query()) {
+        (None, Some(pq)) => pq.clone(),
+        (None, None) => PathAndQuery::from_static("/"),
+        (Some(new_path), pq) => {
+            let org_pq = pq.map_or("/", PathAndQuery::as_str).as_bytes();
+            let matched_path = matched_prefix.as_bytes();
             if matched_path.is_empty() || org_pq.len() < matched_path.len() {
                 return Err(HttpError::InvalidUri("Path and query is broken".to_string()));
             }
-            let remaining_len = org_pq.len().saturating_sub(matched_path.len());
-            let capacity = remaining_len.saturating_add(new_path.len());
+            let rest = &org_pq[matched_path.len()..];
+            let capacity = new_path.len().saturating_add(rest.len()).saturating_add(1);
             let mut new_pq = Vec::<u8>::with_capacity(capacity);
             new_pq.extend_from_slice(new_path.as_bytes());
-            new_pq.extend_from_slice(&org_pq[matched_path.len()..]);
-            new_pq
+            new_pq.extend_from_slice(rest);
+            // An empty or query-only result addresses the root path.
+            if new_pq.first().is_none_or(|&b| b == b'?') {
+                new_pq.insert(0, b'/');
+            }
+            PathAndQuery::from_maybe_shared(Bytes::from(new_pq))
+                .map_err(|e| HttpError::InvalidUri(e.to_string()))?
         }
-        None => org_pq.to_vec(),
     };
+    let mut parts = uri::Parts::default();
+    parts.scheme = Some(Scheme::HTTP);
+    parts.authority = Some(authority);
+    parts.path_and_query = Some(path_and_query);
+    Uri::from_parts(parts).map_err(|e| HttpError::InvalidUri(e.to_string()))
+}
+
+/// Counts one request as in flight to a backend (load-balancer stats and the
+/// `huginn_backend_in_flight_requests` gauge) until dropped, including when the forward future
+/// is cancelled because the client went away.
+struct InFlight<'a> {
+    stats: Option<&'a BackendStats>,
+    metrics: &'a Metrics,
+    backend: &'a KeyValue,
+}
+
+impl<'a> InFlight<'a> {
+    fn start(stats: Option<&'a BackendStats>, metrics: &'a Metrics, backend: &'a KeyValue) -> Self {
+        if let Some(stats) = stats {
+            stats.start();
+        }
+        metrics.record_backend_in_flight(backend, 1);
+        Self { stats, metrics, backend }
+    }
+}
+
+impl Drop for InFlight<'_> {
+    fn drop(&mut self) {
+        if let Some(stats) = self.stats {
+            stats.finish();
+        }
+        self.metrics.record_backend_in_flight(self.backend, -1);
+    }
+}
 
-    let new_path_str = String::from_utf8(new_pq)
-        .map_err(|e| HttpError::InvalidUri(format!("Invalid UTF-8 in path: {}", e)))?;
+pub async fn forward(
+    mut req: Request<Incoming>,
+    selected: SelectedBackend,
+    config: ForwardConfig<'_>,
+) -> HttpResult<Response<RespBody>> {
+    let SelectedBackend { address: backend, stats, upstream } = selected;
+    let start = Instant::now();
+    let backend_attribute = backend_address(&backend);
 
-    let uri = format!("http://{}{}", backend, new_path_str)
-        .parse::<http::Uri>()
-        .map_err(|e| HttpError::InvalidUri(e.to_string()))?;
+    let authority = match upstream.as_ref().and_then(|u| u.authority.clone()) {
+        Some(authority) => authority,
+        None => Authority::try_from(&*backend).map_err(|e| HttpError::InvalidUri(e.to_string()))?,
+    };
+    let uri = upstream_uri(authority, req.uri(), config.matched_prefix, config.replace_path)?;
 
     let client_version = req.version();
-    let backend_config = find_backend_config(&backend, config.backends);
+    let backend_config = match &upstream {
+        Some(upstream) => upstream
+            .backend_index
+            .and_then(|index| config.backends.get(index)),
+        None => find_backend_config(&backend, config.backends),
+    };
     let target_version = determine_http_version(backend_config, client_version, false);
 
     if req.version() != target_version {
@@ -110,12 +166,9 @@ pub async fn forward(
     if let Some(content_length) = parts.headers.get(hyper::header::CONTENT_LENGTH) {
         if let Ok(length_str) = content_length.to_str() {
             if let Ok(length) = length_str.parse::<u64>() {
-                config.metrics.record_backend_bytes_sent(
-                    length,
-                    &backend,
-                    config.route,
-                    config.domain,
-                );
+                config
+                    .metrics
+                    .record_backend_bytes_sent(length, &backend_attribute, config.route);
             }
         }
     }
@@ -131,16 +184,25 @@ pub async fn forward(
 
     let out_req = Request::from_parts(parts, body);
 
-    let result = if let Some(pooled_client) = config
-        .client_pool
-        .get_client(target_version, config.force_new_connection)
+    let in_flight = InFlight::start(stats.as_deref(), &config.metrics, &backend_attribute);
+    let result = if let Some(pooled_client) =
+        config
+            .client_pool
+            .get_client(&backend, target_version, config.force_new_connection)
     {
-        pooled_client.request(out_req).await
+        pooled_client
+            .request(out_req)
+            .await
+            .map_err(DirectError::from)
     } else {
-        let oneoff_client = config.client_pool.create_oneoff_client(target_version);
-        oneoff_client.request(out_req).await
+        config
+            .client_pool
+            .direct_client()
+            .send(out_req, target_version)
+            .await
     };
 
+    drop(in_flight);
     let duration = start.elapsed().as_secs_f64();
 
     match result {
@@ -152,9 +214,8 @@ pub async fn forward(
                     if let Ok(length) = length_str.parse::<u64>() {
                         config.metrics.record_backend_bytes_received(
                             length,
-                            &backend,
+                            &backend_attribute,
                             config.route,
-                            config.domain,
                         );
                     }
                 }
@@ -166,30 +227,27 @@ pub async fn forward(
                 config.is_https,
             );
 
-            config.metrics.record_backend_request(
-                &backend,
-                status_code,
-                &protocol,
-                config.route,
-                config.domain,
-            );
-            config.metrics.record_backend_duration(
+            config.metrics.record_backend_response(
                 duration,
-                &backend,
+                &backend_attribute,
                 status_code,
-                &protocol,
+                config.request,
                 config.route,
-                config.domain,
             );
+            if let Some(stats) = &stats {
+                let ewma = stats.observe_latency(duration);
+                config
+                    .metrics
+                    .record_backend_latency_ewma(ewma, &backend_attribute);
+            }
             Ok(resp.map(|b| b.boxed()))
         }
         Err(e) => {
             let error = HttpError::FailedToGetResponseFromBackend(e.to_string());
             config.metrics.record_backend_error(
-                &backend,
+                &backend_attribute,
                 error.error_type(),
                 config.route,
-                config.domain,
             );
             Err(error)
         }
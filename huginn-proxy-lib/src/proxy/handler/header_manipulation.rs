@@ -27,7 +27,7 @@ use std::sync::Arc;
 pub fn apply_header_manipulation_group(
     headers: &mut HeaderMap,
     manipulation: &HeaderManipulationGroup,
-    context: &str,
+    context: &'static str,
     metrics: &Arc<Metrics>,
 ) {
     // Remove headers first
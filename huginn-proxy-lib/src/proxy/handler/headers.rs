@@ -1,21 +1,25 @@
+use bytes::Bytes;
 use huginn_net_http::AkamaiFingerprint;
-use hyper::body::Incoming;
 use hyper::header::HeaderValue;
 use hyper::Request;
-use std::net::SocketAddr;
+use std::io::{Cursor, Write};
+use std::net::{IpAddr, SocketAddr};
 
-use crate::fingerprinting::headers::forwarded;
+use crate::fingerprinting::headers::{encode_header_value, forwarded};
 
 /// Convert Akamai fingerprint to HTTP header value
 pub fn akamai_header_value(value: Option<&AkamaiFingerprint>) -> Option<HeaderValue> {
-    value.and_then(|f| HeaderValue::from_str(&f.fingerprint).ok())
+    value.and_then(|f| encode_header_value(&f.fingerprint))
 }
 
 /// Convert TLS (JA4) fingerprint to HTTP header value
 pub fn tls_header_value(value: Option<&huginn_net_tls::Ja4Payload>) -> Option<HeaderValue> {
-    value.and_then(|f| HeaderValue::from_str(&f.full.to_string()).ok())
+    value.and_then(|f| encode_header_value(&f.full))
 }
 
+/// Longest textual IP address (`ffff:ffff:ffff:ffff:ffff:ffff:255.255.255.255`).
+const MAX_IP_TEXT_LEN: usize = 45;
+
 /// Add X-Forwarded-* headers to the request
 ///
 /// This function:
@@ -23,27 +27,37 @@ pub fn tls_header_value(value: Option<&huginn_net_tls::Ja4Payload>) -> Option<He
 /// 2. Sets X-Forwarded-Host from the resolved routing host
 /// 3. Sets X-Forwarded-Port from the peer's port
 /// 4. Sets X-Forwarded-Proto based on is_https flag
-pub fn add_forwarded_headers(
-    req: &mut Request<Incoming>,
+///
+/// The client IP is formatted on the stack, so each header value costs one allocation (none
+/// for X-Forwarded-Proto).
+pub fn add_forwarded_headers<B>(
+    req: &mut Request<B>,
     peer: SocketAddr,
     is_https: bool,
     forwarded_host: &str,
 ) {
     // X-Forwarded-For: Append client IP to existing header, or create new one
-    let client_ip = peer.ip().to_string();
-    if let Some(existing_for) = req.headers().get(forwarded::FOR) {
-        // Append to existing header (comma-separated)
-        if let Ok(existing_str) = existing_for.to_str() {
-            let new_value = format!("{existing_str}, {client_ip}");
-            if let Ok(header_value) = HeaderValue::from_str(&new_value) {
-                req.headers_mut().insert(forwarded::FOR, header_value);
-            }
-        }
-    } else {
+    let mut ip_buf = [0u8; MAX_IP_TEXT_LEN];
+    let client_ip = format_ip(peer.ip(), &mut ip_buf);
+    let forwarded_for = match req.headers().get(forwarded::FOR) {
+        // Append to existing header (comma-separated); an unreadable value is left untouched
+        Some(existing_for) => existing_for.to_str().ok().map(|existing| {
+            let existing = existing.as_bytes();
+            let len = existing
+                .len()
+                .saturating_add(2)
+                .saturating_add(client_ip.len());
+            let mut value = Vec::with_capacity(len);
+            value.extend_from_slice(existing);
+            value.extend_from_slice(b", ");
+            value.extend_from_slice(client_ip);
+            HeaderValue::from_maybe_shared(Bytes::from(value))
+        }),
         // Create new header
-        if let Ok(header_value) = HeaderValue::from_str(&client_ip) {
-            req.headers_mut().insert(forwarded::FOR, header_value);
-        }
+        None => Some(HeaderValue::from_bytes(client_ip)),
+    };
+    if let Some(Ok(header_value)) = forwarded_for {
+        req.headers_mut().insert(forwarded::FOR, header_value);
     }
 
     // X-Forwarded-Host: strip any client-supplied value first, then set it to the host the
@@ -60,14 +74,20 @@ pub fn add_forwarded_headers(
     }
 
     // X-Forwarded-Port: Use the port from peer SocketAddr
-    let port = peer.port().to_string();
-    if let Ok(header_value) = HeaderValue::from_str(&port) {
-        req.headers_mut().insert(forwarded::PORT, header_value);
-    }
+    req.headers_mut()
+        .insert(forwarded::PORT, HeaderValue::from(peer.port()));
 
     // X-Forwarded-Proto: "https" or "http"
     let proto = if is_https { "https" } else { "http" };
-    if let Ok(header_value) = HeaderValue::from_str(proto) {
-        req.headers_mut().insert(forwarded::PROTO, header_value);
-    }
+    req.headers_mut()
+        .insert(forwarded::PROTO, HeaderValue::from_static(proto));
+}
+
+/// Write `ip` in its `Display` form into `buf` and return the written bytes.
+fn format_ip(ip: IpAddr, buf: &mut [u8; MAX_IP_TEXT_LEN]) -> &[u8] {
+    let mut cursor = Cursor::new(&mut buf[..]);
+    // Cannot fail: every address fits in `MAX_IP_TEXT_LEN`.
+    let _ = write!(cursor, "{ip}");
+    let len = usize::try_from(cursor.position()).unwrap_or(0);
+    buf.get(..len).unwrap_or_default()
 }
@@ -1,12 +1,13 @@
 use http::StatusCode;
 use hyper::Response;
+use std::fmt;
 use std::sync::Arc;
 use tracing::debug;
 
 use crate::config::{RateLimitConfig, TrustedProxiesConfig};
 use crate::proxy::router::RouteMatch;
-use crate::security::{extract_rate_limit_key, RateLimitManager, RateLimitResult};
-use crate::telemetry::Metrics;
+use crate::security::{rate_limit_key, RateLimitManager, RateLimitResult};
+use crate::telemetry::{Metrics, RouteAttributes};
 use crate::utils::http::{json_error, RespBody};
 
 /// Check rate limiting for incoming request.
@@ -24,6 +25,8 @@ pub fn check_rate_limit(
     metrics: &Arc<Metrics>,
     domain: &str,
     trusted_proxies: &TrustedProxiesConfig,
+    ja4: Option<&dyn fmt::Display>,
+    attributes: &RouteAttributes,
 ) -> Option<Response<RespBody>> {
     let manager = rate_limit_manager?;
 
@@ -34,29 +37,31 @@ pub fn check_rate_limit(
     let limit_by = effective.limit_by;
     let limit_by_header = effective.limit_by_header.as_deref();
 
-    let rate_limit_key = extract_rate_limit_key(
+    // Hashed in place and checked with a static strategy label: nothing is allocated for the
+    // key on the request path.
+    let key = rate_limit_key(
         limit_by,
         peer,
         route_match.matched_prefix,
         limit_by_header,
         headers,
         trusted_proxies,
+        ja4,
     );
 
-    let strategy = format!("{:?}", limit_by).to_lowercase();
-    metrics.record_rate_limit_request(&strategy, route_match.matched_prefix, domain);
+    let strategy = limit_by.as_str();
+    metrics.record_rate_limit_request(strategy, attributes);
 
-    let rate_limit_result =
-        manager.check(&rate_limit_key, domain, Some(route_match.matched_prefix));
+    let rate_limit_result = manager.check_key(key, domain, Some(route_match.matched_prefix));
 
     match rate_limit_result {
         RateLimitResult::Limited { limit, reset_after, .. } => {
-            metrics.record_rate_limit_rejection(&strategy, route_match.matched_prefix, domain);
+            metrics.record_rate_limit_rejection(strategy, attributes);
             Some(create_429_response(limit, reset_after.as_secs()))
         }
         RateLimitResult::Allowed { limit, remaining } => {
             debug!(limit = limit, remaining = remaining, "Rate limit check passed");
-            metrics.record_rate_limit_allowed(&strategy, route_match.matched_prefix, domain);
+            metrics.record_rate_limit_allowed(strategy, attributes);
             None
         }
     }
@@ -1,19 +1,28 @@
 use super::host::extract_request_host;
-use crate::backend::UpstreamGateway;
+use crate::backend::{ClientKey, UpstreamGateway};
 use crate::config::{Backend, Domain, KeepAliveConfig, DEFAULT_DOMAIN_LABEL};
 use crate::fingerprinting::names;
+use crate::fingerprinting::Http2Fingerprint;
 use crate::fingerprinting::TcpObservation;
+use crate::proxy::cache::{CacheKey, Lookup};
+use crate::proxy::coalesce::{CoalesceKey, Join};
+use crate::proxy::connection::{ConnectionMemo, HostDecision};
 use crate::proxy::forwarding::forward;
 use crate::proxy::handler::header_manipulation::{
     apply_request_header_manipulation, apply_response_header_manipulation,
 };
-use crate::proxy::handler::headers::{add_forwarded_headers, akamai_header_value};
+use crate::proxy::handler::headers::add_forwarded_headers;
 use crate::proxy::handler::rate_limit_validation::check_rate_limit;
 use crate::proxy::handler::resolve::{domain_defers_ip_filter, resolve_security};
 use crate::proxy::http_result::{HttpError, HttpResult};
+use crate::proxy::router::RoutingTable;
 use crate::proxy::ClientPool;
+use crate::security::IpFilterIndex;
 use crate::telemetry::metrics::values;
-use crate::telemetry::Metrics;
+use crate::telemetry::{
+    ConnectionTiming, FingerprintExporter, FingerprintRecord, Metrics, Phase, RequestAttributes,
+    RouteAttributes,
+};
 use http::HeaderMap;
 use http::StatusCode;
 use http::Version;
@@ -21,11 +30,12 @@ use hyper::body::Incoming;
 use hyper::header::HeaderName;
 use hyper::Request;
 use std::sync::Arc;
+use std::time::SystemTime;
 use tokio::sync::watch;
 use tokio::time::Instant;
 use tracing::debug;
 
-use crate::utils::http::RespBody;
+use crate::utils::http::{json_error, version_label, RespBody};
 
 /// Strip all proxy-authoritative fingerprint headers from an incoming request.
 ///
@@ -45,14 +55,13 @@ pub fn strip_client_fingerprints(headers: &mut HeaderMap) -> Vec<&'static str> {
     spoofed
 }
 
+/// Record an IP-ACL verdict (computed, or memoized per connection) and map a denial to 403.
 fn check_ip_access(
     peer: std::net::SocketAddr,
-    ip_filter: &crate::config::IpFilterConfig,
+    allowed: bool,
     metrics: &Arc<Metrics>,
 ) -> HttpResult<()> {
-    let client_ip = peer.ip();
-
-    if !crate::security::is_ip_allowed(client_ip, ip_filter) {
+    if !allowed {
         debug!(?peer, "IP blocked by filter");
         metrics.record_ip_filter_denied();
         metrics.record_error(values::ERROR_IP_BLOCKED);
@@ -67,19 +76,48 @@ fn check_ip_access(
 /// pre-routing (domain-effective) and post-routing (route-effective) check sites.
 fn enforce_ip_access(
     peer: std::net::SocketAddr,
-    ip_filter: &crate::config::IpFilterConfig,
+    allowed: bool,
     metrics: &Arc<Metrics>,
-    method: &str,
-    protocol: &str,
+    request: &RequestAttributes,
 ) -> HttpResult<()> {
-    if let Err(e) = check_ip_access(peer, ip_filter, metrics) {
+    if let Err(e) = check_ip_access(peer, allowed, metrics) {
         let status_code = StatusCode::from(e.clone()).as_u16();
-        metrics.record_entrypoint_request(method, status_code, protocol);
+        metrics.record_entrypoint_request(request, status_code);
         return Err(e);
     }
     Ok(())
 }
 
+/// `Content-Length` of a request or response, when present and valid.
+fn content_length(headers: &HeaderMap) -> Option<u64> {
+    headers
+        .get(hyper::header::CONTENT_LENGTH)
+        .and_then(|v| v.to_str().ok())
+        .and_then(|v| v.parse().ok())
+}
+
+/// 503 for a request shed by an adaptive concurrency limit.
+fn shed_response(retry_after_secs: u64) -> hyper::Response<RespBody> {
+    let mut resp = json_error(StatusCode::SERVICE_UNAVAILABLE, "overloaded");
+    resp.headers_mut()
+        .insert(hyper::header::RETRY_AFTER, hyper::header::HeaderValue::from(retry_after_secs));
+    resp
+}
+
+/// Whether the outcome of `forward` tells the adaptive limits about the backend: `Some(true)`
+/// for congestion whatever the latency (backend unreachable, 502/503/504), `Some(false)` for a
+/// plain response, `None` for failures that never reached the backend.
+fn backend_overloaded(result: &HttpResult<hyper::Response<RespBody>>) -> Option<bool> {
+    match result {
+        Ok(response) => Some(matches!(
+            response.status(),
+            StatusCode::BAD_GATEWAY | StatusCode::SERVICE_UNAVAILABLE | StatusCode::GATEWAY_TIMEOUT
+        )),
+        Err(HttpError::FailedToGetResponseFromBackend(_)) => Some(true),
+        Err(_) => None,
+    }
+}
+
 /// Handle request routing and forwarding.
 ///
 /// `peer` is the effective client address as resolved by `resolve_peer`, and is expected to be
@@ -87,13 +125,23 @@ fn enforce_ip_access(
 /// protocol header) are normalized to plain IPv4 at that single point. This handler therefore does
 /// **not** re-normalize; it relies on that contract so `ip_filter`, the rate-limit key and
 /// `X-Forwarded-For` all observe one consistent form.
+///
+/// `memo` is the connection's [`ConnectionMemo`]: host-level decisions (domain, SNI coverage,
+/// IP-ACL verdicts) are computed once per host/route and reused by later requests on the same
+/// connection, which shares one `peer`, SNI and config snapshot.
+///
+/// `connection_timing` holds the connection's phases; the request's own phases are marked on it
+/// as the handler passes them (see [`crate::telemetry::timing`]).
+///
+/// `fingerprint_export` is the `[telemetry.fingerprint_export]` queue, when enabled.
 #[allow(clippy::too_many_arguments)]
 pub async fn handle_proxy_request(
     mut req: Request<Incoming>,
-    domains: Arc<Vec<Domain>>,
+    routing: Arc<RoutingTable>,
+    ip_filters: Arc<IpFilterIndex>,
     backends: Arc<Vec<Backend>>,
     ja4_fingerprints: Option<crate::fingerprinting::Ja4Fingerprints>,
-    fingerprint_rx: Option<watch::Receiver<Option<huginn_net_http::AkamaiFingerprint>>>,
+    fingerprint_rx: Option<watch::Receiver<Option<Http2Fingerprint>>>,
     syn_fingerprint: Option<TcpObservation>,
     keep_alive: &KeepAliveConfig,
     security: &crate::proxy::SecurityContext,
@@ -104,23 +152,64 @@ pub async fn handle_proxy_request(
     client_pool: &Arc<ClientPool>,
     upstream: &UpstreamGateway,
     connection_sni: Option<&str>,
+    memo: &ConnectionMemo,
+    connection_timing: &ConnectionTiming,
+    fingerprint_export: Option<&FingerprintExporter>,
 ) -> HttpResult<hyper::Response<RespBody>> {
     let start = Instant::now();
-    let method = req.method().to_string();
-    let protocol = format!("{:?}", req.version());
+    let mut timing = connection_timing.request(start);
+    let protocol = version_label(req.version());
+    let request_attributes = RequestAttributes::new(req.method(), req.version());
 
-    if let Some(content_length) = req.headers().get(hyper::header::CONTENT_LENGTH) {
-        if let Ok(length_str) = content_length.to_str() {
-            if let Ok(length) = length_str.parse::<u64>() {
-                metrics.record_bytes_received(length, &protocol);
-            }
-        }
+    if let Some(length) = content_length(req.headers()) {
+        metrics.record_bytes_received(length, protocol);
     }
 
     let path = req.uri().path();
     let host = extract_request_host(&req);
 
-    let domain = crate::proxy::router::pick_domain(&domains, &host);
+    // Export the connection's fingerprints on its first request, and again on any request that
+    // carries client-supplied fingerprint headers. Queued before routing so rejected clients
+    // are exported too.
+    if let Some(exporter) = fingerprint_export {
+        let supplied: Vec<&'static str> = names::FINGERPRINTS
+            .iter()
+            .copied()
+            .filter(|&name| req.headers().contains_key(name))
+            .collect();
+        if memo.claim_fingerprint_export() || !supplied.is_empty() {
+            exporter.push(FingerprintRecord {
+                time: SystemTime::now(),
+                client_ip: peer.ip(),
+                host: host.as_str().into(),
+                ja4: ja4_fingerprints.clone(),
+                akamai: fingerprint_rx
+                    .as_ref()
+                    .and_then(|rx| rx.borrow().as_ref().and_then(|fp| fp.header_value.clone())),
+                tcp_syn: syn_fingerprint.clone(),
+                spoofed: supplied,
+            });
+        }
+    }
+
+    // Domain, SNI coverage and the pre-routing IP verdict only depend on `host` for the life of
+    // the connection; compute them once per host.
+    let decision = memo.host_decision(&host, || {
+        let picked = routing.pick_domain(&host);
+        let defer_ip_check = picked.is_some_and(|(_, d)| domain_defers_ip_filter(d));
+        let domain_index = picked.map(|(index, _)| index);
+        let ip_allowed = defer_ip_check || ip_filters.domain(domain_index).allows(peer.ip());
+        HostDecision {
+            domain_index,
+            authoritative: connection_sni
+                .is_none_or(|sni| routing.authority_matches_sni(sni, &host)),
+            defer_ip_check,
+            ip_allowed,
+        }
+    });
+    let domain = decision
+        .domain_index
+        .and_then(|index| routing.domain(index));
     let domain_headers = domain.and_then(|d| d.headers.as_ref());
     let domain_label: &str = domain.map_or(DEFAULT_DOMAIN_LABEL, Domain::label);
 
@@ -133,12 +222,8 @@ pub async fn handle_proxy_request(
     // If no route overrides the IP filter, the domain/global filter applies to every route, so
     // enforce it pre-routing (a blocked client never learns whether a host/route exists). If a
     // route does override it, defer to post-routing (route-level ACL; see `resolve_security`).
-    let defer_ip_check = domain.is_some_and(domain_defers_ip_filter);
-    if !defer_ip_check {
-        let domain_ip_filter = domain_security
-            .and_then(|s| s.ip_filter.as_ref())
-            .unwrap_or(&security.ip_filter);
-        enforce_ip_access(peer, domain_ip_filter, &metrics, &method, &protocol)?;
+    if !decision.defer_ip_check {
+        enforce_ip_access(peer, decision.ip_allowed, &metrics, &request_attributes)?;
     }
 
     // Misdirected-request enforcement (RFC 9110 §15.5.20 / RFC 7540 §9.1.2), always on,
@@ -149,7 +234,7 @@ pub async fn handle_proxy_request(
     // fires on TLS connections that presented an SNI; runs after the IP filter so a blocked
     // client never learns whether a host exists.
     if let Some(sni) = connection_sni {
-        if !crate::proxy::router::authority_matches_sni(&domains, sni, &host) {
+        if !decision.authoritative {
             debug!(
                 ?peer,
                 sni,
@@ -159,71 +244,60 @@ pub async fn handle_proxy_request(
             let error = HttpError::MisdirectedRequest;
             metrics.record_error(error.error_type());
             let status_code = StatusCode::from(error.clone()).as_u16();
-            metrics.record_entrypoint_request(&method, status_code, &protocol);
+            metrics.record_entrypoint_request(&request_attributes, status_code);
             return Err(error);
         }
     }
 
-    let route_match = match domain {
+    let (domain_index, route_match) = match decision.domain_index {
         None => {
             let error = HttpError::MisdirectedRequest;
             metrics.record_error(error.error_type());
             let status_code = StatusCode::from(error.clone()).as_u16();
-            metrics.record_entrypoint_request(&method, status_code, &protocol);
+            metrics.record_entrypoint_request(&request_attributes, status_code);
             return Err(error);
         }
-        Some(d) => match crate::proxy::router::pick_route_with_fingerprinting(path, &d.routes) {
-            Some(r) => r,
+        Some(domain_index) => match routing.pick_route(domain_index, path) {
+            Some(r) => (domain_index, r),
             None => {
                 let error = HttpError::NoMatchingRoute;
                 metrics.record_error(error.error_type());
                 let status_code = StatusCode::from(error.clone()).as_u16();
-                metrics.record_entrypoint_request(&method, status_code, &protocol);
+                metrics.record_entrypoint_request(&request_attributes, status_code);
                 return Err(error);
             }
         },
     };
 
+    // Interned when the routing table was compiled; built here only if the table lacks the
+    // route, which `pick_route` never returns.
+    let fallback_attributes;
+    let route_attributes = match routing.route_attributes(domain_index, route_match.route_index) {
+        Some(attributes) => attributes,
+        None => {
+            fallback_attributes = RouteAttributes::new(route_match.matched_prefix, domain_label);
+            &fallback_attributes
+        }
+    };
+
     // Route is known: resolve the whole-block effective policy (route.or(domain).or(global)).
     let effective = resolve_security(security, domain, &route_match);
 
     // Deferred route-level IP check, before backend selection (blocked client never hits upstream).
-    if defer_ip_check {
-        enforce_ip_access(peer, effective.ip_filter, &metrics, &method, &protocol)?;
+    if decision.defer_ip_check {
+        let allowed = memo.route_ip_allowed(domain_index, route_match.matched_prefix, || {
+            ip_filters
+                .route(Some(domain_index), route_match.route_index)
+                .allows(peer.ip())
+        });
+        enforce_ip_access(peer, allowed, &metrics, &request_attributes)?;
     }
+    timing.mark(Phase::Routing, &metrics);
 
-    let selected_upstream = match upstream.selector.select(
-        route_match.matched_prefix,
-        &route_match.backend_candidates,
-        &upstream.health,
-    ) {
-        Some(addr) => addr,
-        None => {
-            metrics.record_health_check_gate_reject(route_match.backend);
-            let error = HttpError::UpstreamUnhealthy;
-            let status_code = StatusCode::from(error.clone()).as_u16();
-            metrics.record_entrypoint_request(&method, status_code, &protocol);
-            metrics.record_request(
-                &method,
-                status_code,
-                &protocol,
-                route_match.matched_prefix,
-                domain_label,
-            );
-            metrics.record_request_duration(
-                start.elapsed().as_secs_f64(),
-                &method,
-                status_code,
-                &protocol,
-                route_match.matched_prefix,
-                domain_label,
-            );
-            return Err(error);
-        }
-    };
-    metrics.record_backend_selection(&selected_upstream);
-
-    if let Some(rate_limited_response) = check_rate_limit(
+    let ja4 = ja4_fingerprints
+        .as_ref()
+        .map(|fp| fp as &dyn std::fmt::Display);
+    let rate_limited = check_rate_limit(
         security.rate_limit_manager.as_ref(),
         effective_rate_limit,
         &route_match,
@@ -232,27 +306,106 @@ pub async fn handle_proxy_request(
         &metrics,
         domain_label,
         &security.trusted_proxies,
-    ) {
+        ja4,
+        route_attributes,
+    );
+    if security.rate_limit_manager.is_some() {
+        timing.mark(Phase::RateLimit, &metrics);
+    }
+    if let Some(mut rate_limited_response) = rate_limited {
         let status_code = rate_limited_response.status().as_u16();
-        metrics.record_entrypoint_request(&method, status_code, &protocol);
+        metrics.record_entrypoint_request(&request_attributes, status_code);
         metrics.record_request(
-            &method,
+            start.elapsed().as_secs_f64(),
             status_code,
-            &protocol,
-            route_match.matched_prefix,
-            domain_label,
+            &request_attributes,
+            route_attributes,
         );
-        metrics.record_request_duration(
-            start.elapsed().as_secs_f64(),
-            &method,
+        timing.finish(
+            Some(rate_limited_response.headers_mut()),
             status_code,
-            &protocol,
             route_match.matched_prefix,
             domain_label,
         );
         return Ok(rate_limited_response);
     }
 
+    // Response cache: after every check that can refuse the request, before a backend is picked,
+    // so a hit costs no backend work.
+    let mut pending_store = None;
+    if let (Some(cache), Some(config)) = (upstream.cache.as_deref(), route_match.cache) {
+        let fingerprint = ja4_fingerprints
+            .as_ref()
+            .filter(|_| config.key_fingerprints)
+            .and_then(|fp| fp.ja4().full.as_ref())
+            .map(hyper::header::HeaderValue::as_bytes);
+        let key = CacheKey {
+            https: is_https,
+            host: &host,
+            backend: route_match.backend,
+            path_and_query: req.uri().path_and_query().map_or("/", |pq| pq.as_str()),
+            fingerprint,
+        };
+        let lookup = cache.lookup(&req, &key, config, route_attributes, &metrics);
+        timing.mark(Phase::Cache, &metrics);
+        match lookup {
+            Lookup::Hit(mut response) => {
+                if let Some(length) = content_length(response.headers()) {
+                    metrics.record_bytes_sent(length, protocol);
+                }
+                apply_response_header_manipulation(
+                    response.headers_mut(),
+                    security.global_header_manipulation.as_ref(),
+                    domain_headers,
+                    route_match.headers,
+                    &metrics,
+                );
+                let status_code = response.status().as_u16();
+                metrics.record_entrypoint_request(&request_attributes, status_code);
+                metrics.record_request(
+                    start.elapsed().as_secs_f64(),
+                    status_code,
+                    &request_attributes,
+                    route_attributes,
+                );
+                timing.finish(
+                    Some(response.headers_mut()),
+                    status_code,
+                    route_match.matched_prefix,
+                    domain_label,
+                );
+                return Ok(response);
+            }
+            Lookup::Forward(pending) => pending_store = pending,
+        }
+    }
+
+    let client = ClientKey::new(peer.ip(), ja4);
+    let selected = upstream.selector.select_route(
+        &routing,
+        domain_index,
+        &route_match,
+        &client,
+        &upstream.health,
+    );
+    let selected_upstream = match selected {
+        Some(selected) => selected,
+        None => {
+            metrics.record_health_check_gate_reject(route_match.backend);
+            let error = HttpError::UpstreamUnhealthy;
+            let status_code = StatusCode::from(error.clone()).as_u16();
+            metrics.record_entrypoint_request(&request_attributes, status_code);
+            metrics.record_request(
+                start.elapsed().as_secs_f64(),
+                status_code,
+                &request_attributes,
+                route_attributes,
+            );
+            return Err(error);
+        }
+    };
+    metrics.record_backend_selection(&selected_upstream.address);
+
     // Strip proxy-authoritative fingerprint headers unconditionally, must run outside the
     // fingerprinting gate, so routes with fingerprinting=false also strip spoofed values.
     let spoofed = strip_client_fingerprints(req.headers_mut());
@@ -264,46 +417,19 @@ pub async fn handle_proxy_request(
     // not from HTTP headers, so adding X-Forwarded-* headers won't affect fingerprint generation)
     if effective.fingerprinting {
         if let Some(ref fingerprints) = ja4_fingerprints {
-            if let Ok(hv) = hyper::header::HeaderValue::from_str(&fingerprints.ja4.full.to_string())
-            {
-                req.headers_mut()
-                    .insert(HeaderName::from_static(names::TLS_JA4), hv);
-            }
-            if let Ok(hv) = hyper::header::HeaderValue::from_str(&fingerprints.ja4.raw.to_string())
-            {
-                req.headers_mut()
-                    .insert(HeaderName::from_static(names::TLS_JA4_R), hv);
-            }
-            if let Ok(hv) =
-                hyper::header::HeaderValue::from_str(&fingerprints.ja4_original.full.to_string())
-            {
-                req.headers_mut()
-                    .insert(HeaderName::from_static(names::TLS_JA4_O), hv);
-            }
-            if let Ok(hv) =
-                hyper::header::HeaderValue::from_str(&fingerprints.ja4_original.raw.to_string())
-            {
-                req.headers_mut()
-                    .insert(HeaderName::from_static(names::TLS_JA4_OR), hv);
-            }
-            if let Ok(hv) =
-                hyper::header::HeaderValue::from_str(&fingerprints.ja4_stable_v1.full.to_string())
-            {
-                req.headers_mut()
-                    .insert(HeaderName::from_static(names::TLS_JA4_S1), hv);
-            }
-            if let Ok(hv) =
-                hyper::header::HeaderValue::from_str(&fingerprints.ja4_stable_v1.raw.to_string())
-            {
-                req.headers_mut()
-                    .insert(HeaderName::from_static(names::TLS_JA4_S1R), hv);
+            // Encoded once per connection; each insert clones a shared `Bytes` value.
+            for (name, value) in fingerprints.header_values() {
+                if let Some(hv) = value {
+                    req.headers_mut()
+                        .insert(HeaderName::from_static(name), hv.clone());
+                }
             }
         }
         if let Some(ref rx) = fingerprint_rx {
             if req.version() == Version::HTTP_2 {
-                let akamai = rx.borrow().clone();
+                let akamai = rx.borrow().as_ref().and_then(|fp| fp.header_value.clone());
                 debug!("Handler: akamai fingerprint: {:?}", akamai);
-                if let Some(hv) = akamai_header_value(akamai.as_ref()) {
+                if let Some(hv) = akamai {
                     debug!("Handler: injecting {} header: {:?}", names::HTTP2_AKAMAI, hv);
                     req.headers_mut()
                         .insert(HeaderName::from_static(names::HTTP2_AKAMAI), hv);
@@ -354,35 +480,119 @@ pub async fn handle_proxy_request(
         route_match.headers,
         &metrics,
     );
+    timing.mark(Phase::Prepare, &metrics);
 
-    let result = forward(
-        req,
-        selected_upstream,
-        crate::proxy::forwarding::ForwardConfig {
-            backends: &backends,
-            keep_alive,
-            metrics: Arc::clone(&metrics),
-            matched_prefix: route_match.matched_prefix,
-            replace_path: route_match.replace_path,
-            security_headers: Some(effective.security_headers),
-            is_https,
-            preserve_host,
+    // Request coalescing: an identical request already in flight answers this one, which then
+    // takes no concurrency permit and sends nothing upstream.
+    let mut leader = None;
+    let mut shared = None;
+    if let Some(config) = route_match.coalesce {
+        let key = CoalesceKey {
+            https: is_https,
+            host: &host,
+            backend: &selected_upstream.address,
             route: route_match.matched_prefix,
-            domain: domain_label,
-            client_pool,
-            force_new_connection: route_match.force_new_connection,
-        },
-    )
-    .await;
+            path_and_query: req.uri().path_and_query().map_or("/", |pq| pq.as_str()),
+        };
+        match upstream
+            .coalescer
+            .join(&req, &key, config, route_attributes, &metrics)
+        {
+            Join::Leader(flight) => leader = Some(flight),
+            Join::Follower(flight) => {
+                shared = flight.wait(route_attributes, &metrics).await;
+                timing.mark(Phase::Coalesce, &metrics);
+            }
+            Join::Bypass => {}
+        }
+    }
 
-    let mut result = result;
-    if let Ok(ref mut response) = result {
-        if let Some(content_length) = response.headers().get(hyper::header::CONTENT_LENGTH) {
-            if let Ok(length_str) = content_length.to_str() {
-                if let Ok(length) = length_str.parse::<u64>() {
-                    metrics.record_bytes_sent(length, &protocol);
+    let mut result = if let Some(result) = shared {
+        result
+    } else {
+        // Adaptive concurrency: shed before a request the route or backend has no room for is
+        // forwarded. The permit is held until the backend's response headers arrive.
+        let permit = match upstream.concurrency.as_deref() {
+            None => None,
+            Some(limiter) => match limiter.try_acquire(
+                domain_label,
+                route_match.matched_prefix,
+                route_attributes,
+                &selected_upstream.address,
+                &metrics,
+            ) {
+                Ok(permit) => Some(permit),
+                Err(shed) => {
+                    debug!(
+                        ?peer,
+                        scope = shed.scope(),
+                        "Request shed by adaptive concurrency limit"
+                    );
+                    metrics.record_request_shed(shed.scope(), route_attributes);
+                    let mut response = shed_response(limiter.retry_after_secs());
+                    let status_code = response.status().as_u16();
+                    metrics.record_entrypoint_request(&request_attributes, status_code);
+                    metrics.record_request(
+                        start.elapsed().as_secs_f64(),
+                        status_code,
+                        &request_attributes,
+                        route_attributes,
+                    );
+                    timing.mark(Phase::Upstream, &metrics);
+                    timing.finish(
+                        Some(response.headers_mut()),
+                        status_code,
+                        route_match.matched_prefix,
+                        domain_label,
+                    );
+                    return Ok(response);
                 }
+            },
+        };
+
+        let forward_start = Instant::now();
+        let result = forward(
+            req,
+            selected_upstream,
+            crate::proxy::forwarding::ForwardConfig {
+                backends: &backends,
+                keep_alive,
+                metrics: Arc::clone(&metrics),
+                matched_prefix: route_match.matched_prefix,
+                replace_path: route_match.replace_path,
+                security_headers: Some(effective.security_headers),
+                is_https,
+                preserve_host,
+                request: &request_attributes,
+                route: route_attributes,
+                client_pool,
+                force_new_connection: route_match.force_new_connection,
+            },
+        )
+        .await;
+
+        if let (Some(limiter), Some(permit)) = (upstream.concurrency.as_deref(), permit.as_ref()) {
+            if let Some(overloaded) = backend_overloaded(&result) {
+                limiter.complete(permit, forward_start.elapsed(), overloaded, &metrics);
+            }
+        }
+        drop(permit);
+
+        let result = match (upstream.cache.as_deref(), pending_store, result) {
+            (Some(cache), Some(pending), Ok(response)) => {
+                cache.store(pending, response, &metrics).await
             }
+            (_, _, result) => result,
+        };
+        timing.mark(Phase::Upstream, &metrics);
+        match leader {
+            Some(flight) => flight.complete(result),
+            None => result,
+        }
+    };
+    if let Ok(ref mut response) = result {
+        if let Some(length) = content_length(response.headers()) {
+            metrics.record_bytes_sent(length, protocol);
         }
 
         apply_response_header_manipulation(
@@ -403,19 +613,11 @@ pub async fn handle_proxy_request(
         }
     };
 
-    metrics.record_entrypoint_request(&method, status_code, &protocol);
-    metrics.record_request(
-        &method,
-        status_code,
-        &protocol,
-        route_match.matched_prefix,
-        domain_label,
-    );
-    metrics.record_request_duration(
-        duration,
-        &method,
+    metrics.record_entrypoint_request(&request_attributes, status_code);
+    metrics.record_request(duration, status_code, &request_attributes, route_attributes);
+    timing.finish(
+        result.as_mut().ok().map(hyper::Response::headers_mut),
         status_code,
-        &protocol,
         route_match.matched_prefix,
         domain_label,
     );
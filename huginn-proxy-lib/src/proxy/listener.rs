@@ -12,6 +12,92 @@ use crate::error::Result;
 /// arrives as `::ffff:x.y.z.w` (`SocketAddr::V6`), which would cause the SYN
 /// fingerprint lookup to hit the wrong eBPF map.
 pub fn bind_listener(addr: SocketAddr, backlog: i32) -> std::io::Result<TcpListener> {
+    let socket = new_socket(addr)?;
+    socket.bind(&addr.into())?;
+    socket.listen(backlog)?;
+    TcpListener::from_std(socket.into())
+}
+
+/// Bind `shards` sockets to `addr` in one `SO_REUSEPORT` group; the kernel spreads incoming
+/// connections over them. With `cpu_steering`, the socket is picked by the CPU that received the
+/// SYN (`cpu % shards`) instead of the 4-tuple hash.
+///
+/// Sockets are returned unregistered so each shard can adopt its own on the runtime that serves
+/// it (`TcpListener::from_std`). Socket options are as in [`bind_listener`]. Linux only.
+pub fn bind_reuseport_listeners(
+    addr: SocketAddr,
+    backlog: i32,
+    shards: usize,
+    cpu_steering: bool,
+) -> std::io::Result<Vec<std::net::TcpListener>> {
+    #[cfg(target_os = "linux")]
+    {
+        bind_reuseport_group(addr, backlog, shards, cpu_steering)
+    }
+    #[cfg(not(target_os = "linux"))]
+    {
+        let _ = (addr, backlog, shards, cpu_steering);
+        Err(std::io::Error::new(
+            std::io::ErrorKind::Unsupported,
+            "SO_REUSEPORT listener sharding is only supported on Linux",
+        ))
+    }
+}
+
+#[cfg(target_os = "linux")]
+fn bind_reuseport_group(
+    addr: SocketAddr,
+    backlog: i32,
+    shards: usize,
+    cpu_steering: bool,
+) -> std::io::Result<Vec<std::net::TcpListener>> {
+    use nix::sys::socket::{setsockopt, sockopt};
+
+    let mut listeners = Vec::with_capacity(shards);
+    for _ in 0..shards.max(1) {
+        let socket = new_socket(addr)?;
+        setsockopt(&socket, sockopt::ReusePort, &true)?;
+        socket.bind(&addr.into())?;
+        // The kernel numbers group members in listen order, which is the shard index.
+        socket.listen(backlog)?;
+        listeners.push(std::net::TcpListener::from(socket));
+    }
+    if cpu_steering {
+        if let Some(first) = listeners.first() {
+            attach_cpu_steering(first, listeners.len())?;
+        }
+    }
+    Ok(listeners)
+}
+
+/// Classic BPF for the `SO_REUSEPORT` group: `return cpu % shards`. Attached to one member, it
+/// applies to the whole group.
+#[cfg(target_os = "linux")]
+fn attach_cpu_steering(socket: &std::net::TcpListener, shards: usize) -> std::io::Result<()> {
+    use nix::sys::socket::{setsockopt, sockopt};
+
+    const LD_W_ABS: u16 = (libc::BPF_LD | libc::BPF_W | libc::BPF_ABS) as u16;
+    const ALU_MOD_K: u16 = (libc::BPF_ALU | libc::BPF_MOD | libc::BPF_K) as u16;
+    const RET_A: u16 = (libc::BPF_RET | libc::BPF_A) as u16;
+    // Ancillary load of the current CPU (`SKF_AD_OFF + SKF_AD_CPU`, two's complement in `k`).
+    const AD_CPU: u32 = libc::SKF_AD_OFF.wrapping_add(libc::SKF_AD_CPU) as u32;
+
+    let shards = u32::try_from(shards).map_err(|_| {
+        std::io::Error::new(std::io::ErrorKind::InvalidInput, "too many listener shards")
+    })?;
+    let mut program = [
+        libc::sock_filter { code: LD_W_ABS, jt: 0, jf: 0, k: AD_CPU },
+        libc::sock_filter { code: ALU_MOD_K, jt: 0, jf: 0, k: shards.max(1) },
+        libc::sock_filter { code: RET_A, jt: 0, jf: 0, k: 0 },
+    ];
+    // The kernel copies the program during the call; the pointer does not outlive `program`.
+    let fprog = libc::sock_fprog { len: program.len() as u16, filter: program.as_mut_ptr() };
+    setsockopt(socket, sockopt::AttachReusePortCbpf, &fprog)?;
+    Ok(())
+}
+
+/// Non-blocking TCP socket for `addr` with `SO_REUSEADDR` (and `IPV6_V6ONLY` for IPv6).
+fn new_socket(addr: SocketAddr) -> std::io::Result<socket2::Socket> {
     use socket2::{Domain, Protocol, Socket, Type};
 
     let domain = if addr.is_ipv6() {
@@ -24,10 +110,8 @@ pub fn bind_listener(addr: SocketAddr, backlog: i32) -> std::io::Result<TcpListe
     if addr.is_ipv6() {
         socket.set_only_v6(true)?;
     }
-    socket.bind(&addr.into())?;
-    socket.listen(backlog)?;
     socket.set_nonblocking(true)?;
-    TcpListener::from_std(socket.into())
+    Ok(socket)
 }
 
 pub fn register_signal(kind: signal::unix::SignalKind, name: &str) -> Result<signal::unix::Signal> {
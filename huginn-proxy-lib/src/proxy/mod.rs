@@ -1,6 +1,10 @@
 pub mod accept;
+pub mod admission;
+pub mod cache;
 pub mod client_pool;
+pub mod coalesce;
 pub mod connection;
+pub mod direct_client;
 pub mod forwarding;
 pub mod handler;
 pub mod http_result;
@@ -11,11 +15,13 @@ pub mod reload;
 pub mod router;
 pub mod security_context;
 pub mod server;
+pub mod shard;
 pub mod shutdown;
 pub mod synthetic_response;
 pub mod transport;
+pub mod warm_pool;
 pub mod watch;
-pub use client_pool::ClientPool;
+pub use client_pool::{BackendReuse, ClientPool};
 pub use forwarding::{determine_http_version, find_backend_config};
 pub use http_result::HttpError;
 pub use router::pick_route;
@@ -7,9 +7,10 @@ use tokio::time::timeout;
 use tracing::{debug, trace, warn};
 
 use crate::config::{ProxyProtocolConfig, ProxyProtocolMode, TrustedProxiesConfig};
+use crate::fingerprinting::ClientHello;
 use crate::proxy::protocol::{
     detect_proxy_protocol, normalize_mapped_ipv4, read_proxy_header_v1, read_proxy_header_v2,
-    ProxyProtocolDetection, ProxyProtocolError, ProxySource,
+    read_proxy_preamble, ProxyProtocolDetection, ProxyProtocolError, ProxySource,
 };
 use crate::telemetry::values as metric_values;
 use crate::telemetry::Metrics;
@@ -86,8 +87,8 @@ fn require_drops(
     }
 }
 
-/// Maps a `read_proxy_header_v1`/`v2` outcome (already raced against `timeout_dur`) to the
-/// effective peer, recording the metric and log line that matches each case.
+/// Maps a `read_proxy_header_v1`/`v2`/`read_proxy_preamble` outcome (already raced against
+/// `timeout_dur`) to the effective peer, recording the metric and log line that matches each case.
 fn peer_from_read_result(
     read_result: Result<Result<ProxySource, ProxyProtocolError>, Elapsed>,
     metrics: &Metrics,
@@ -133,6 +134,46 @@ fn peer_from_read_result(
     }
 }
 
+/// The outcomes that read no header: `Err(peer)` for `off` and for untrusted peers (never parsed,
+/// see [`resolve_peer`]), `Ok(())` when the trusted peer's header must be read.
+fn expect_header(
+    proxy_mode: ProxyProtocolMode,
+    metrics: &Metrics,
+    trusted_proxies: &TrustedProxiesConfig,
+    socket_peer: SocketAddr,
+) -> Result<(), Option<SocketAddr>> {
+    if proxy_mode == ProxyProtocolMode::Off {
+        return Err(Some(socket_peer));
+    }
+    if !is_trusted(socket_peer.ip(), trusted_proxies) {
+        return Err(require_drops(
+            proxy_mode,
+            metrics,
+            socket_peer,
+            metric_values::PROXY_PROTOCOL_DROP_UNTRUSTED_REQUIRE,
+            "drop: proxy_protocol=require + untrusted peer",
+            PassthroughNote::Silent,
+        ));
+    }
+    Ok(())
+}
+
+/// A trusted peer sent no PROXY header.
+fn no_header(
+    proxy_mode: ProxyProtocolMode,
+    metrics: &Metrics,
+    socket_peer: SocketAddr,
+) -> Option<SocketAddr> {
+    require_drops(
+        proxy_mode,
+        metrics,
+        socket_peer,
+        metric_values::PROXY_PROTOCOL_DROP_BAD_HEADER,
+        "drop: proxy_protocol=require + no PROXY header",
+        PassthroughNote::Logged,
+    )
+}
+
 /// Resolve the effective client peer, honoring `proxy_mode`.
 ///
 /// Returns `Some(peer)` to proceed (`peer` is the PROXY-declared client when a trusted peer sent
@@ -157,21 +198,8 @@ pub async fn resolve_peer(
     socket_peer: SocketAddr,
 ) -> Option<SocketAddr> {
     let socket_peer = canonical_peer(socket_peer);
-
-    let mode = match proxy_mode {
-        ProxyProtocolMode::Off => return Some(socket_peer),
-        mode => mode,
-    };
-
-    if !is_trusted(socket_peer.ip(), trusted_proxies) {
-        return require_drops(
-            mode,
-            metrics,
-            socket_peer,
-            metric_values::PROXY_PROTOCOL_DROP_UNTRUSTED_REQUIRE,
-            "drop: proxy_protocol=require + untrusted peer",
-            PassthroughNote::Silent,
-        );
+    if let Err(outcome) = expect_header(proxy_mode, metrics, trusted_proxies, socket_peer) {
+        return outcome;
     }
 
     let detection = match timeout(timeout_dur, detect_proxy_protocol(stream)).await {
@@ -189,19 +217,46 @@ pub async fn resolve_peer(
     };
 
     let read_result = match detection {
-        ProxyProtocolDetection::None => {
-            return require_drops(
-                mode,
-                metrics,
-                socket_peer,
-                metric_values::PROXY_PROTOCOL_DROP_BAD_HEADER,
-                "drop: proxy_protocol=require + no PROXY header",
-                PassthroughNote::Logged,
-            );
-        }
+        ProxyProtocolDetection::None => return no_header(proxy_mode, metrics, socket_peer),
         ProxyProtocolDetection::V1 => timeout(timeout_dur, read_proxy_header_v1(stream)).await,
         ProxyProtocolDetection::V2 => timeout(timeout_dur, read_proxy_header_v2(stream)).await,
     };
 
     peer_from_read_result(read_result, metrics, socket_peer)
 }
+
+/// [`resolve_peer`] for a TLS listener: the PROXY header is read into `hello` rather than
+/// peeked for and consumed from the stream, and every byte after it stays there as the start
+/// of the ClientHello (see [`read_proxy_preamble`]).
+///
+/// Behind a load balancer this usually takes one read, where [`resolve_peer`] peeks (retrying
+/// while the signature is incomplete) and then reads the header in parts; nothing is allocated
+/// for the header. Same outcomes, metrics and security boundary as [`resolve_peer`]: nothing is
+/// read for `off` or an untrusted peer, and `timeout_dur` bounds the whole header.
+pub async fn resolve_peer_buffered(
+    proxy_mode: ProxyProtocolMode,
+    timeout_dur: Duration,
+    metrics: &Metrics,
+    trusted_proxies: &TrustedProxiesConfig,
+    stream: &mut TcpStream,
+    socket_peer: SocketAddr,
+    hello: &mut ClientHello,
+) -> Option<SocketAddr> {
+    let socket_peer = canonical_peer(socket_peer);
+    if let Err(outcome) = expect_header(proxy_mode, metrics, trusted_proxies, socket_peer) {
+        return outcome;
+    }
+
+    let read_result =
+        match timeout(timeout_dur, read_proxy_preamble(stream, hello.buffer_mut())).await {
+            Ok(Ok(None)) => return no_header(proxy_mode, metrics, socket_peer),
+            Ok(Ok(Some(header))) => {
+                hello.skip_header(header.len);
+                Ok(Ok(header.source))
+            }
+            Ok(Err(e)) => Ok(Err(e)),
+            Err(elapsed) => Err(elapsed),
+        };
+
+    peer_from_read_result(read_result, metrics, socket_peer)
+}
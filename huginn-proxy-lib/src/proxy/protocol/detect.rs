@@ -27,8 +27,6 @@ pub enum ProxyProtocolDetection {
 /// the connection. The two signatures start with distinct bytes (`0x0D` for v2, `0x50 'P'` for v1),
 /// so the classification usually resolves on the first peeked byte.
 pub async fn detect_proxy_protocol(stream: &TcpStream) -> std::io::Result<ProxyProtocolDetection> {
-    let sig = &V2_SIGNATURE[..];
-    let pfx = &V1_PREFIX[..];
     let mut buf = [0u8; 12];
     loop {
         let n = stream.peek(&mut buf).await?;
@@ -36,22 +34,28 @@ pub async fn detect_proxy_protocol(stream: &TcpStream) -> std::io::Result<ProxyP
         if n == 0 {
             return Ok(ProxyProtocolDetection::None);
         }
-        let seen = &buf[..n];
-
-        if seen.starts_with(sig) {
-            return Ok(ProxyProtocolDetection::V2);
-        }
-        if seen.starts_with(pfx) {
-            return Ok(ProxyProtocolDetection::V1);
-        }
-
-        // Inconclusive: could the bytes seen so far still grow into either signature?
-        let could_be_v2 = sig.starts_with(seen);
-        let could_be_v1 = pfx.starts_with(seen);
-        if !could_be_v2 && !could_be_v1 {
-            return Ok(ProxyProtocolDetection::None);
+        if let Some(detection) = classify_proxy_protocol(&buf[..n]) {
+            return Ok(detection);
         }
         // A trusted peer mid-send: small sleep before re-peeking (bounded by caller's timeout).
         tokio::time::sleep(std::time::Duration::from_millis(5)).await;
     }
 }
+
+/// Classify a connection from its first bytes `seen`, or `None` while they are still a prefix
+/// of either signature and more bytes are needed to decide.
+pub fn classify_proxy_protocol(seen: &[u8]) -> Option<ProxyProtocolDetection> {
+    let sig = &V2_SIGNATURE[..];
+    let pfx = &V1_PREFIX[..];
+    if seen.starts_with(sig) {
+        return Some(ProxyProtocolDetection::V2);
+    }
+    if seen.starts_with(pfx) {
+        return Some(ProxyProtocolDetection::V1);
+    }
+    // Inconclusive: could the bytes seen so far still grow into either signature?
+    if sig.starts_with(seen) || pfx.starts_with(seen) {
+        return None;
+    }
+    Some(ProxyProtocolDetection::None)
+}
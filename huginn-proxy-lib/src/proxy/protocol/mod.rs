@@ -15,7 +15,9 @@
 //!
 //! In both cases the stream is left aligned on the byte that follows the header (the TLS
 //! ClientHello in passthrough), so detection via `MSG_PEEK` and consume-exactly-N keep
-//! the handshake intact. The `P` (`0x50`) that starts a v1 line and the `0x0D` that starts a v2
+//! the handshake intact. TLS listeners use [`read_proxy_preamble`] instead: it reads into the
+//! pooled ClientHello buffer and parses the header in place, so the bytes that follow it are
+//! already buffered for the handshake. The `P` (`0x50`) that starts a v1 line and the `0x0D` that starts a v2
 //! header are both distinct from a TLS record type, so a missing header is detected without
 //! consuming.
 //!
@@ -24,10 +26,12 @@
 //! to the [`ppp`] crate (same parser used by the rust-rpxy reference).
 
 mod detect;
+mod preamble;
 mod v1;
 mod v2;
 
-pub use detect::{detect_proxy_protocol, ProxyProtocolDetection};
+pub use detect::{classify_proxy_protocol, detect_proxy_protocol, ProxyProtocolDetection};
+pub use preamble::read_proxy_preamble;
 pub use v1::{read_proxy_header_v1, V1_PREFIX};
 pub use v2::{read_proxy_header_v2, V2_SIGNATURE};
 
@@ -83,6 +87,15 @@ pub enum ProxySource {
     NoClientAddr,
 }
 
+/// A PROXY header parsed in place from buffered bytes (see [`read_proxy_preamble`]).
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct ProxyHeader {
+    /// What the header declared.
+    pub source: ProxySource,
+    /// Header length in bytes (`\r\n` or address block included): where the next protocol starts.
+    pub len: usize,
+}
+
 /// Normalize an IPv4-mapped IPv6 address (`::ffff:a.b.c.d`) to plain IPv4.
 ///
 /// An IPv4 client can surface as an IPv4-mapped IPv6 address, a dual-stack listener bound to
@@ -0,0 +1,55 @@
+//! Buffered PROXY header reader for TLS listeners.
+//!
+//! Instead of peeking for the signature and then consuming exactly the header, the first reads
+//! go straight into the caller's buffer (the pooled ClientHello buffer): the header is framed and
+//! parsed in place, and whatever followed it in the same reads (usually the whole ClientHello)
+//! stays in the buffer for the handshake. One read typically covers both, with no peek retries
+//! and no per-header allocation.
+
+use tokio::io::{AsyncRead, AsyncReadExt};
+
+use super::detect::{classify_proxy_protocol, ProxyProtocolDetection};
+use super::v1::parse_proxy_header_v1;
+use super::v2::parse_proxy_header_v2;
+use super::{ProxyHeader, ProxyProtocolError};
+
+/// Read from `stream` into `buf` until a PROXY header at its start is complete, or its first
+/// bytes prove there is none.
+///
+/// Returns `Ok(None)` when there is no header (the buffered bytes all belong to the
+/// connection), otherwise the parsed header, whose `len` is where the next protocol starts in
+/// `buf`. Bytes past the header are kept, never consumed or copied. The caller wraps this in a
+/// timeout, as for [`super::detect_proxy_protocol`] and the stream readers, and keeps `buf`
+/// whatever the outcome.
+///
+/// Generic over `AsyncRead` for unit testing; the accept loop passes a `&mut TcpStream`.
+pub async fn read_proxy_preamble<R>(
+    stream: &mut R,
+    buf: &mut Vec<u8>,
+) -> Result<Option<ProxyHeader>, ProxyProtocolError>
+where
+    R: AsyncRead + Unpin,
+{
+    loop {
+        let detection = classify_proxy_protocol(buf);
+        let header = match detection {
+            Some(ProxyProtocolDetection::None) => return Ok(None),
+            Some(ProxyProtocolDetection::V1) => parse_proxy_header_v1(buf)?,
+            Some(ProxyProtocolDetection::V2) => parse_proxy_header_v2(buf)?,
+            None => None,
+        };
+        if header.is_some() {
+            return Ok(header);
+        }
+
+        let read = stream.read_buf(buf).await.map_err(ProxyProtocolError::Io)?;
+        if read == 0 {
+            // EOF before a signature was confirmed: not a PROXY header. Once one was, the header
+            // is truncated.
+            return match detection {
+                None => Ok(None),
+                Some(_) => Err(ProxyProtocolError::Io(std::io::ErrorKind::UnexpectedEof.into())),
+            };
+        }
+    }
+}
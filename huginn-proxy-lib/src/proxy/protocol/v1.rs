@@ -2,14 +2,15 @@
 //!
 //! The legacy `PROXY TCP4 …\r\n` line (e.g. HAProxy `send-proxy`) carries no length field, so the
 //! reader consumes **byte-by-byte up to the terminating `\r\n`** (capped at 107 bytes per spec) and
-//! nothing more, leaving the stream aligned on the following ClientHello. Field parsing is
-//! delegated to [`ppp`]; this module owns only the framing and the length cap.
+//! nothing more, leaving the stream aligned on the following ClientHello. Bytes already buffered
+//! (see [`super::read_proxy_preamble`]) are framed in place instead. Field parsing is delegated
+//! to [`ppp`]; this module owns only the framing and the length cap.
 
 use std::net::{IpAddr, SocketAddr};
 
 use tokio::io::{AsyncRead, AsyncReadExt};
 
-use super::{ProxyProtocolError, ProxySource};
+use super::{ProxyHeader, ProxyProtocolError, ProxySource};
 
 /// 6-byte v1 prefix `PROXY ` (note the trailing space).
 pub const V1_PREFIX: [u8; 6] = *b"PROXY ";
@@ -60,7 +61,26 @@ where
             return Err(ProxyProtocolError::V1HeaderTooLong);
         }
     }
-    let header = ppp::v1::Header::try_from(line.as_slice())
-        .map_err(|e| ProxyProtocolError::Parse(format!("{e:?}")))?;
+    parse_line(&line)
+}
+
+/// Parse a v1 header at the start of `buf` without copying it: `Ok(None)` until the terminating
+/// `\r\n` is buffered. The same `V1_MAX_LENGTH` cap applies as for [`read_proxy_header_v1`].
+pub(super) fn parse_proxy_header_v1(buf: &[u8]) -> Result<Option<ProxyHeader>, ProxyProtocolError> {
+    let window = &buf[..buf.len().min(V1_MAX_LENGTH)];
+    match window.windows(2).position(|pair| pair == b"\r\n") {
+        Some(cr) => {
+            let len = cr.saturating_add(2);
+            Ok(Some(ProxyHeader { source: parse_line(&window[..len])?, len }))
+        }
+        None if buf.len() >= V1_MAX_LENGTH => Err(ProxyProtocolError::V1HeaderTooLong),
+        None => Ok(None),
+    }
+}
+
+/// Parse one complete header line, `\r\n` included.
+fn parse_line(line: &[u8]) -> Result<ProxySource, ProxyProtocolError> {
+    let header =
+        ppp::v1::Header::try_from(line).map_err(|e| ProxyProtocolError::Parse(format!("{e:?}")))?;
     Ok(source_from_v1(&header))
 }
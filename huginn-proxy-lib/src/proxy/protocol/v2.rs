@@ -2,14 +2,15 @@
 //!
 //! The signature (`\r\n\r\n\0\r\nQUIT\n`) cannot collide with a TLS ClientHello (`0x16 0x03…`) or
 //! HTTP, and the declared address-block length lets the reader consume **exactly** those bytes so
-//! the stream stays aligned on the following ClientHello. Field parsing is delegated to [`ppp`];
-//! this module owns only the framing and the allocation guard.
+//! the stream stays aligned on the following ClientHello. Bytes already buffered (see
+//! [`super::read_proxy_preamble`]) are framed in place instead. Field parsing is delegated to
+//! [`ppp`]; this module owns only the framing and the allocation guard.
 
 use std::net::{IpAddr, SocketAddr};
 
 use tokio::io::{AsyncRead, AsyncReadExt};
 
-use super::{ProxyProtocolError, ProxySource};
+use super::{ProxyHeader, ProxyProtocolError, ProxySource};
 
 /// 12-byte v2 signature: `\r\n\r\n\0\r\nQUIT\n`.
 pub const V2_SIGNATURE: [u8; 12] =
@@ -62,24 +63,48 @@ where
         .await
         .map_err(ProxyProtocolError::Io)?;
 
+    let len = header_len(&fixed)?;
+
+    // Read exactly the declared address block behind the fixed part, then hand the contiguous
+    // header to `ppp`.
+    let mut header = Vec::with_capacity(len);
+    header.extend_from_slice(&fixed);
+    header.resize(len, 0);
+    stream
+        .read_exact(&mut header[FIXED_LEN..])
+        .await
+        .map_err(ProxyProtocolError::Io)?;
+    parse_header(&header)
+}
+
+/// Parse a v2 header at the start of `buf` without copying it: `Ok(None)` until the whole
+/// declared address block is buffered. The same `V2_MAX_ADDR_LEN` cap applies as for
+/// [`read_proxy_header_v2`], checked as soon as the fixed part is in.
+pub(super) fn parse_proxy_header_v2(buf: &[u8]) -> Result<Option<ProxyHeader>, ProxyProtocolError> {
+    let Some(fixed) = buf.get(..FIXED_LEN) else {
+        return Ok(None);
+    };
+    let len = header_len(fixed)?;
+    match buf.get(..len) {
+        Some(header) => Ok(Some(ProxyHeader { source: parse_header(header)?, len })),
+        None => Ok(None),
+    }
+}
+
+/// Total header length declared by the `fixed` part, address block and TLVs included.
+fn header_len(fixed: &[u8]) -> Result<usize, ProxyProtocolError> {
     // The address-block length lives in bytes 14..16 regardless of the signature; cap it before
-    // allocating so a garbage/hostile length cannot force a large allocation.
+    // buffering so a garbage/hostile length cannot force a large allocation.
     let addr_len = u16::from_be_bytes([fixed[14], fixed[15]]) as usize;
     if addr_len > V2_MAX_ADDR_LEN {
         return Err(ProxyProtocolError::AddrLenTooLarge(addr_len));
     }
+    Ok(FIXED_LEN.saturating_add(addr_len))
+}
 
-    // Read exactly the declared address block, then hand the contiguous header to `ppp`.
-    let mut buf = Vec::with_capacity(FIXED_LEN.saturating_add(addr_len));
-    buf.extend_from_slice(&fixed);
-    let mut addrs = vec![0u8; addr_len];
-    stream
-        .read_exact(&mut addrs)
-        .await
-        .map_err(ProxyProtocolError::Io)?;
-    buf.extend_from_slice(&addrs);
-
-    let header = ppp::v2::Header::try_from(buf.as_slice())
+/// Parse one complete header.
+fn parse_header(header: &[u8]) -> Result<ProxySource, ProxyProtocolError> {
+    let header = ppp::v2::Header::try_from(header)
         .map_err(|e| ProxyProtocolError::Parse(format!("{e:?}")))?;
     Ok(source_from_v2(&header))
 }
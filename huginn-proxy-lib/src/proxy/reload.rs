@@ -3,11 +3,12 @@ use crate::config::{
     load_from_path, Backend, BackendPoolConfig, Domain, DynamicConfig, RateLimitConfig,
     StaticConfig,
 };
-use crate::proxy::client_pool::ClientPool;
+use crate::proxy::client_pool::{BackendReuse, ClientPool};
 use crate::proxy::protocol::warn_proxy_protocol_trust_gap;
+use crate::security::rate_limit::LimiterReuse;
 use crate::security::RateLimitManager;
 use crate::telemetry::Metrics;
-use crate::tls::DynamicCertResolver;
+use crate::tls::{DynamicCertResolver, SharedTicketer};
 use arc_swap::ArcSwap;
 use std::collections::{BTreeMap, HashSet};
 use std::hash::{Hash, Hasher};
@@ -16,10 +17,12 @@ use std::sync::Arc;
 use tokio::runtime::Handle;
 use tracing::{debug, error, info};
 
-/// Hot-swappable rate-limit manager; reused across reloads unless its config changes (see `try_reload`).
+/// Hot-swappable rate-limit manager; reused across reloads unless its config changes, and then
+/// rebuilt around the limiters of unchanged scopes (see `try_reload`).
 pub type SharedRateLimiter = Arc<ArcSwap<Option<Arc<RateLimitManager>>>>;
 
-/// Hot-swappable HTTP client pool; reused unless backends/pool change (see `try_reload`).
+/// Hot-swappable HTTP client pool; reused unless backends/pool change, and then rebuilt around the
+/// clients of unchanged backends (see `try_reload`).
 pub type SharedClientPool = Arc<ArcSwap<ClientPool>>;
 
 /// Hot-swappable dynamic configuration.
@@ -29,11 +32,13 @@ pub type SharedDynamicConfig = Arc<ArcSwap<DynamicConfig>>;
 ///
 /// Does:
 /// - Re-parse + validate; on failure keeps the current config untouched (fail-safe).
-/// - Reload per-domain certs (best-effort) FIRST, then swap rate-limiter, pool, and the
-///   routing config LAST. Cert IO is the slow step; doing it before the synchronous stores
-///   keeps the cert-vs-routes inconsistency window down to microseconds.
-/// - Rebuild only what changed: rate-limiter (counters reset) and client pool (idle conns drained).
-/// - Reconcile health checks for added/removed backends.
+/// - Reload per-domain certs and shared TLS ticket keys (best-effort) FIRST, then swap
+///   rate-limiter, pool, and the routing config LAST. Cert IO is the slow step; doing it before
+///   the synchronous stores keeps the cert-vs-routes inconsistency window down to microseconds.
+/// - Rebuild only what changed, per scope: a rate limiter (counters reset) only for an added or
+///   changed global/domain/route policy, per-backend clients (idle conns drained) only for removed
+///   backends or a changed pool config, and a certificate only when its files' content changed.
+/// - Reconcile health checks for added/removed backends; republish the backend selector.
 ///
 /// Does NOT:
 /// - Touch live connections: each one keeps the config snapshot it took at accept time, so changes
@@ -51,6 +56,7 @@ pub async fn try_reload(
     metrics: &Arc<Metrics>,
     health_supervisor: &HealthCheckSupervisor,
     cert_resolver: Option<&Arc<DynamicCertResolver>>,
+    ticketer: Option<&Arc<SharedTicketer>>,
 ) {
     let _guard = reload_mutex.lock().await;
 
@@ -117,25 +123,46 @@ pub async fn try_reload(
         );
     }
 
-    // Rebuild (resetting counters) only when the rate-limit config or its `rate_limit_signature`
-    // changes; unrelated edits (certs, headers, IP filters, backends) keep the existing buckets.
-    if old_dynamic.security.rate_limit != new_dynamic.security.rate_limit
+    // Ticket keys are re-read from the path the process started with; rotating them needs no
+    // config change, only a reload (SIGHUP or a touch of the config file).
+    if let Some(ticketer) = ticketer {
+        match ticketer.reload() {
+            Ok(keys) => {
+                info!(path = %ticketer.path().display(), keys, "TLS session ticket keys reloaded")
+            }
+            Err(e) => {
+                error!(error = %e, "TLS session ticket keys reload failed, keeping current keys")
+            }
+        }
+    }
+
+    // Rebuild only when the rate-limit config or its `rate_limit_signature` changes; unrelated
+    // edits (certs, headers, IP filters, backends) keep the existing manager. A rebuilt manager
+    // still shares the limiters (and counters) of every scope whose policy is unchanged.
+    let limiters = if old_dynamic.security.rate_limit != new_dynamic.security.rate_limit
         || rate_limit_signature(&old_dynamic.domains) != rate_limit_signature(&new_dynamic.domains)
     {
-        let candidate =
-            RateLimitManager::new(&new_dynamic.security.rate_limit, &new_dynamic.domains);
-        let new_mgr = if candidate.is_enabled() {
-            Some(Arc::new(candidate))
-        } else {
-            None
-        };
+        let previous = rate_limiter.load_full();
+        let (new_mgr, reuse) = rebuild_rate_limiter(
+            &new_dynamic,
+            static_cfg.rate_limit_cluster.enabled,
+            previous.as_deref(),
+        );
         rate_limiter.store(Arc::new(new_mgr));
-        info!("Rate-limit config changed counters reset");
-    }
+        info!(
+            reused = reuse.reused,
+            rebuilt = reuse.rebuilt,
+            "Rate-limit config changed, counters reset for changed scopes only"
+        );
+        Some(reuse)
+    } else {
+        None
+    };
 
-    // Refresh the connection pool when backends are removed or pool config changes; in-flight
-    // requests keep their old pool clone and only its idle connections are dropped afterwards.
-    drain_removed_backends(
+    // Refresh the connection pool when backends change or pool config changes; in-flight
+    // requests keep their old pool clone and only the idle connections of dropped clients go
+    // away afterwards. With prewarming, a new pool is filled before it is swapped in.
+    let backends = reconcile_client_pool(
         &old_dynamic.backends,
         &new_dynamic.backends,
         &old_dynamic.backend_pool,
@@ -143,16 +170,30 @@ pub async fn try_reload(
         client_pool,
         &static_cfg.timeout.keep_alive,
         static_cfg.timeout.upstream_connect_ms,
+        metrics,
+    )
+    .await;
+
+    info!(
+        limiters_reused = limiters.map(|r| r.reused),
+        limiters_rebuilt = limiters.map(|r| r.rebuilt),
+        backends_reused = backends.map(|r| r.reused),
+        backends_added = backends.map(|r| r.added),
+        backends_removed = backends.map(|r| r.removed),
+        certs_reused = cert_report.reused,
+        certs_loaded = cert_report.loaded,
+        "Config reload applied incrementally"
     );
 
     // Routing config swapped LAST so a connection that observes the new routes already
     // sees the matching certs, rate limiter, and pool from the same reload generation.
     let new_dynamic = Arc::new(new_dynamic);
     dynamic_cfg.store(Arc::clone(&new_dynamic));
-    // Reconcile health-check tasks for added/removed backends.
-    health_supervisor.reconcile(&new_dynamic.backends, metrics, &Handle::current());
+    // Reconcile health-check tasks for added/removed backends and republish the backend selector.
+    health_supervisor.reconcile_config(&new_dynamic, metrics, &Handle::current());
 
     metrics.record_reload_success(hash);
+    metrics.record_ip_filter_index(&new_dynamic.ip_filters);
     if hash == old_hash {
         debug!(
             config_hash = hash,
@@ -259,9 +300,12 @@ fn rate_limit_signature(
         .collect()
 }
 
-/// Replace the shared client pool when backends are removed or pool config changes; otherwise
-/// keep it as-is to avoid resetting healthy connections.
-fn drain_removed_backends(
+/// Swap in a client pool for `new_backends` when the backend set or pool config changes;
+/// otherwise keep it as-is (`None`). Backends present before and after keep their clients and
+/// idle connections; only a pool config change rebuilds every client. A replacement pool is
+/// prewarmed before it is stored.
+#[allow(clippy::too_many_arguments)]
+async fn reconcile_client_pool(
     old_backends: &[Backend],
     new_backends: &[Backend],
     old_pool_cfg: &BackendPoolConfig,
@@ -269,29 +313,34 @@ fn drain_removed_backends(
     client_pool: &SharedClientPool,
     keep_alive: &crate::config::startup::timeout::KeepAliveConfig,
     upstream_connect_ms: Option<u64>,
-) {
+    metrics: &Arc<Metrics>,
+) -> Option<BackendReuse> {
     let old_addrs: HashSet<&str> = old_backends.iter().map(|b| b.address.as_str()).collect();
     let new_addrs: HashSet<&str> = new_backends.iter().map(|b| b.address.as_str()).collect();
 
     let removed: Vec<&&str> = old_addrs.difference(&new_addrs).collect();
     let pool_cfg_changed = old_pool_cfg != new_pool_cfg;
 
-    if removed.is_empty() && !pool_cfg_changed {
-        return;
+    if old_addrs == new_addrs && !pool_cfg_changed {
+        return None;
     }
 
     if !removed.is_empty() {
         info!(
             removed = ?removed,
-            "Backends removed, refreshing connection pool to drain idle connections"
+            "Backends removed, dropping their clients to drain idle connections"
         );
     }
-    if pool_cfg_changed {
+    let (new_pool, reuse) = if pool_cfg_changed {
         info!("Backend pool config changed, refreshing connection pool");
-    }
-
-    let new_pool = ClientPool::new(keep_alive, new_pool_cfg.clone(), upstream_connect_ms);
+        ClientPool::new(keep_alive, new_pool_cfg.clone(), upstream_connect_ms)
+            .with_backends(new_backends)
+    } else {
+        client_pool.load().with_backends(new_backends)
+    };
+    new_pool.prewarm(new_backends, metrics).await;
     client_pool.store(Arc::new(new_pool));
+    Some(reuse)
 }
 
 /// Fast hash of a `DynamicConfig` for the `huginn_config_hash` Prometheus gauge: only needs to be
@@ -303,24 +352,46 @@ fn fnv1a_hash(dynamic: &DynamicConfig) -> u64 {
     hasher.finish()
 }
 
-pub fn initial_rate_limiter(dynamic: &DynamicConfig) -> SharedRateLimiter {
-    let candidate = RateLimitManager::new(&dynamic.security.rate_limit, &dynamic.domains);
-    let mgr = if candidate.is_enabled() {
-        Some(Arc::new(candidate))
-    } else {
-        None
+/// `clustered` when `[security.rate_limit_cluster]` is enabled: the limiters then record the
+/// requests they admit for the cluster sync to push.
+pub fn initial_rate_limiter(dynamic: &DynamicConfig, clustered: bool) -> SharedRateLimiter {
+    Arc::new(ArcSwap::new(Arc::new(build_rate_limiter(dynamic, clustered))))
+}
+
+fn build_rate_limiter(dynamic: &DynamicConfig, clustered: bool) -> Option<Arc<RateLimitManager>> {
+    rebuild_rate_limiter(dynamic, clustered, None).0
+}
+
+/// The manager for `dynamic`, sharing `previous`'s limiters of unchanged scopes; `None` when no
+/// limiter is enabled.
+fn rebuild_rate_limiter(
+    dynamic: &DynamicConfig,
+    clustered: bool,
+    previous: Option<&RateLimitManager>,
+) -> (Option<Arc<RateLimitManager>>, LimiterReuse) {
+    let global = &dynamic.security.rate_limit;
+    let (candidate, reuse) = match previous {
+        Some(previous) => previous.rebuild(global, &dynamic.domains),
+        None => {
+            let candidate = if clustered {
+                RateLimitManager::clustered(global, &dynamic.domains)
+            } else {
+                RateLimitManager::new(global, &dynamic.domains)
+            };
+            let rebuilt = candidate.limiter_count();
+            (candidate, LimiterReuse { reused: 0, rebuilt })
+        }
     };
-    Arc::new(ArcSwap::new(Arc::new(mgr)))
+    (candidate.is_enabled().then(|| Arc::new(candidate)), reuse)
 }
 
-pub fn initial_client_pool(
-    static_cfg: &StaticConfig,
-    pool_cfg: &BackendPoolConfig,
-) -> SharedClientPool {
-    let pool = ClientPool::new(
+/// The client pool at startup, with clients for each of `dynamic`'s backends.
+pub fn initial_client_pool(static_cfg: &StaticConfig, dynamic: &DynamicConfig) -> SharedClientPool {
+    let (pool, _) = ClientPool::new(
         &static_cfg.timeout.keep_alive,
-        pool_cfg.clone(),
+        dynamic.backend_pool.clone(),
         static_cfg.timeout.upstream_connect_ms,
-    );
+    )
+    .with_backends(&dynamic.backends);
     Arc::new(ArcSwap::from_pointee(pool))
 }
@@ -1,17 +1,84 @@
-use crate::config::{Domain, Route};
+use std::fmt;
+use std::sync::Arc;
+
+use ahash::AHashMap;
+use http::uri::Authority;
+
+use crate::config::{Backend, Domain, Route};
+use crate::telemetry::RouteAttributes;
+
+/// Backends of the routes that share the matched prefix (the load-balance group), in
+/// declaration order.
+///
+/// Borrowed straight from the domain's route list: `sort_routes` keeps equal prefixes
+/// contiguous, so producing a [`RouteMatch`] never allocates.
+#[derive(Clone, Copy)]
+pub struct BackendCandidates<'a>(&'a [Route]);
+
+impl<'a> BackendCandidates<'a> {
+    pub fn len(&self) -> usize {
+        self.0.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.0.is_empty()
+    }
+
+    /// Backend address of the `index`-th candidate.
+    pub fn get(&self, index: usize) -> Option<&'a str> {
+        self.0.get(index).map(|r| r.backend.as_str())
+    }
+
+    pub fn iter(&self) -> BackendCandidatesIter<'a> {
+        self.0.iter().map(route_backend as fn(&'a Route) -> &'a str)
+    }
+}
+
+/// Iterator over the backend addresses of a [`BackendCandidates`] group.
+pub type BackendCandidatesIter<'a> =
+    std::iter::Map<std::slice::Iter<'a, Route>, fn(&'a Route) -> &'a str>;
+
+fn route_backend(route: &Route) -> &str {
+    route.backend.as_str()
+}
+
+impl<'a> IntoIterator for BackendCandidates<'a> {
+    type Item = &'a str;
+    type IntoIter = BackendCandidatesIter<'a>;
+
+    fn into_iter(self) -> Self::IntoIter {
+        self.iter()
+    }
+}
+
+impl fmt::Debug for BackendCandidates<'_> {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.debug_list().entries(self.iter()).finish()
+    }
+}
+
+impl PartialEq<Vec<&str>> for BackendCandidates<'_> {
+    fn eq(&self, other: &Vec<&str>) -> bool {
+        self.iter().eq(other.iter().copied())
+    }
+}
 
 #[derive(Debug, Clone)]
 pub struct RouteMatch<'a> {
     pub backend: &'a str,
-    pub backend_candidates: Vec<&'a str>,
+    pub backend_candidates: BackendCandidates<'a>,
     pub fingerprinting: Option<bool>,
     pub matched_prefix: &'a str,
+    /// Index of the group's first route in the domain's (sorted) `routes`.
+    pub route_index: usize,
     pub replace_path: Option<&'a str>,
     pub rate_limit: Option<&'a crate::config::RateLimitConfig>,
     pub ip_filter: Option<&'a crate::config::IpFilterConfig>,
     pub security_headers: Option<&'a crate::config::SecurityHeaders>,
     pub headers: Option<&'a crate::config::HeaderManipulation>,
     pub force_new_connection: bool,
+    pub cache: Option<&'a crate::config::RouteCacheConfig>,
+    pub coalesce: Option<&'a crate::config::RouteCoalesceConfig>,
 }
 
 /// Returns true when `prefix` is a valid match for `path`.
@@ -115,6 +182,8 @@ pub fn authority_matches_sni(domains: &[Domain], sni: &str, host: &str) -> bool
     }
 }
 
+/// Linear reference implementation of route matching; the request path uses
+/// [`RoutingTable::pick_route`], which returns the same match from a precompiled trie.
 pub fn pick_route_with_fingerprinting<'a>(
     path: &str,
     routes: &'a [Route],
@@ -122,26 +191,318 @@ pub fn pick_route_with_fingerprinting<'a>(
     let pos = routes
         .iter()
         .position(|r| prefix_matches(path, &r.prefix))?;
-    let first = &routes[pos];
+    Some(route_match(routes, pos, pos.saturating_add(same_prefix_len(&routes[pos..]))))
+}
 
-    let backend_candidates = routes[pos..]
-        .iter()
-        .take_while(|r| r.prefix.len() == first.prefix.len())
-        .filter(|r| r.prefix == first.prefix)
-        .map(|r| r.backend.as_str())
-        .collect::<Vec<_>>();
+/// Length of the run of routes at the start of `routes` sharing the first route's prefix.
+fn same_prefix_len(routes: &[Route]) -> usize {
+    routes.first().map_or(0, |first| {
+        routes
+            .iter()
+            .take_while(|r| r.prefix == first.prefix)
+            .count()
+    })
+}
 
+/// Build the match for the non-empty same-prefix group `routes[start..end]`; its first route
+/// supplies the policy.
+fn route_match(routes: &[Route], start: usize, end: usize) -> RouteMatch<'_> {
+    let group = &routes[start..end];
+    let first = &group[0];
     let security = first.security.as_ref();
-    Some(RouteMatch {
+    RouteMatch {
         backend: first.backend.as_str(),
-        backend_candidates,
+        backend_candidates: BackendCandidates(group),
         fingerprinting: first.fingerprinting,
         matched_prefix: first.prefix.as_str(),
+        route_index: start,
         replace_path: first.replace_path.as_deref(),
         rate_limit: security.and_then(|s| s.rate_limit.as_ref()),
         ip_filter: security.and_then(|s| s.ip_filter.as_ref()),
         security_headers: security.and_then(|s| s.headers.as_ref()),
         headers: first.headers.as_ref(),
         force_new_connection: first.force_new_connection,
-    })
+        cache: first.cache.as_ref(),
+        coalesce: first.coalesce.as_ref(),
+    }
+}
+
+/// Upstream side of one route's backend address, resolved once per snapshot so `forward`
+/// neither reparses the address nor scans the backend list per request.
+#[derive(Debug, PartialEq)]
+pub struct UpstreamTarget {
+    /// The address as a request-URI authority; `None` if it does not parse as one (the
+    /// request then fails with `InvalidUri`, as before).
+    pub authority: Option<Authority>,
+    /// Index into the snapshot's `backends` of the entry declaring this address, if any.
+    pub backend_index: Option<usize>,
+}
+
+/// Routing index compiled once per [`DynamicConfig`](crate::config::DynamicConfig) snapshot.
+///
+/// Replaces the linear scans of [`pick_domain`] and [`pick_route_with_fingerprinting`] on the
+/// request path: exact hosts and wildcard bases are hash lookups, and each domain's route
+/// prefixes form a byte trie whose nodes point at their precomputed same-prefix candidate group.
+/// Lookups are O(host length + path length) and never allocate. Matching semantics are identical
+/// to the linear functions, which remain the reference implementation.
+pub struct RoutingTable {
+    domains: Arc<Vec<Domain>>,
+    /// `host` → index of the first domain declaring it (wildcard patterns included verbatim).
+    exact: AHashMap<String, usize>,
+    /// Wildcard base (`example.com` for `*.example.com`) → index of the first such domain.
+    wildcard: AHashMap<String, usize>,
+    /// Index of the first host-less domain.
+    catch_all: Option<usize>,
+    /// One trie per domain, same order as `domains`.
+    routes: Vec<PrefixTrie>,
+    /// Per domain, per route (same order as the domain's `routes`); targets are shared by every
+    /// route of the same address.
+    upstreams: Vec<Box<[Arc<UpstreamTarget>]>>,
+    /// Per domain, per route: interned `route` / `domain` metric labels.
+    attributes: Vec<Box<[RouteAttributes]>>,
+}
+
+impl RoutingTable {
+    /// Compile `domains` (routes already sorted by `sort_domain_routes`) with no backend list:
+    /// every [`UpstreamTarget::backend_index`] is `None`.
+    pub fn new(domains: Arc<Vec<Domain>>) -> Self {
+        Self::with_backends(domains, &[])
+    }
+
+    /// Compile `domains` (routes already sorted by `sort_domain_routes`), resolving every route
+    /// backend against `backends` (the snapshot's backend list).
+    pub fn with_backends(domains: Arc<Vec<Domain>>, backends: &[Backend]) -> Self {
+        let mut exact = AHashMap::new();
+        let mut wildcard = AHashMap::new();
+        for (index, host) in domains
+            .iter()
+            .enumerate()
+            .filter_map(|(i, d)| d.host.as_deref().map(|h| (i, h)))
+        {
+            exact.entry(host.to_string()).or_insert(index);
+            if let Some(base) = host.strip_prefix("*.") {
+                wildcard.entry(base.to_string()).or_insert(index);
+            }
+        }
+        let catch_all = domains.iter().position(|d| d.host.is_none());
+        let routes = domains
+            .iter()
+            .map(|d| PrefixTrie::build(&d.routes))
+            .collect();
+        let mut targets: AHashMap<&str, Arc<UpstreamTarget>> = AHashMap::new();
+        let upstreams = domains
+            .iter()
+            .map(|d| {
+                d.routes
+                    .iter()
+                    .map(|r| {
+                        let target = targets.entry(r.backend.as_str()).or_insert_with(|| {
+                            Arc::new(UpstreamTarget {
+                                authority: Authority::try_from(r.backend.as_str()).ok(),
+                                backend_index: backends.iter().position(|b| b.address == r.backend),
+                            })
+                        });
+                        Arc::clone(target)
+                    })
+                    .collect()
+            })
+            .collect();
+        let attributes = domains
+            .iter()
+            .map(|d| {
+                let domain = RouteAttributes::domain_value(d.label());
+                d.routes
+                    .iter()
+                    .map(|r| RouteAttributes::with_domain(&r.prefix, domain.clone()))
+                    .collect()
+            })
+            .collect();
+        Self { domains, exact, wildcard, catch_all, routes, upstreams, attributes }
+    }
+
+    /// The domain list this table was compiled from.
+    pub fn domains(&self) -> &Arc<Vec<Domain>> {
+        &self.domains
+    }
+
+    /// Same result as [`pick_domain`], plus the domain's index for [`Self::pick_route`].
+    pub fn pick_domain(&self, host: &str) -> Option<(usize, &Domain)> {
+        let index = self.pick_domain_index(host)?;
+        self.domains.get(index).map(|d| (index, d))
+    }
+
+    fn pick_domain_index(&self, host: &str) -> Option<usize> {
+        if let Some(&index) = self.exact.get(host) {
+            return Some(index);
+        }
+        if let Some(dot) = host.find('.') {
+            if let Some(&index) = self.wildcard.get(&host[dot.saturating_add(1)..]) {
+                return Some(index);
+            }
+        }
+        self.catch_all
+    }
+
+    /// The domain at `index` (as returned by [`Self::pick_domain`]).
+    pub fn domain(&self, index: usize) -> Option<&Domain> {
+        self.domains.get(index)
+    }
+
+    /// Same result as [`pick_route_with_fingerprinting`] over the routes of the domain at
+    /// `domain_index` (as returned by [`Self::pick_domain`]).
+    pub fn pick_route(&self, domain_index: usize, path: &str) -> Option<RouteMatch<'_>> {
+        let routes = &self.domains.get(domain_index)?.routes;
+        let (start, end) = self.routes.get(domain_index)?.longest_match(path)?;
+        Some(route_match(routes, start, end))
+    }
+
+    /// Upstream target of the route at `route_index` in the domain at `domain_index`.
+    pub fn upstream(
+        &self,
+        domain_index: usize,
+        route_index: usize,
+    ) -> Option<&Arc<UpstreamTarget>> {
+        self.upstreams.get(domain_index)?.get(route_index)
+    }
+
+    /// Metric labels of the route at `route_index` in the domain at `domain_index`.
+    pub fn route_attributes(
+        &self,
+        domain_index: usize,
+        route_index: usize,
+    ) -> Option<&RouteAttributes> {
+        self.attributes.get(domain_index)?.get(route_index)
+    }
+
+    /// Same result as [`authority_matches_sni`], except `sni` must already be lowercased
+    /// (the TLS transport lowercases it once per connection).
+    pub fn authority_matches_sni(&self, sni: &str, host: &str) -> bool {
+        match (self.pick_domain_index(sni), self.pick_domain_index(host)) {
+            (Some(sni_index), Some(host_index)) => {
+                if sni_index == host_index {
+                    return true;
+                }
+                let default_cert = self
+                    .catch_all
+                    .and_then(|i| self.domains.get(i))
+                    .and_then(|d| d.cert_path.as_deref());
+                let cert_of = |index: usize| {
+                    self.domains
+                        .get(index)
+                        .and_then(|d| effective_cert_path(d, default_cert))
+                };
+                let sni_cert = cert_of(sni_index);
+                sni_cert.is_some() && sni_cert == cert_of(host_index)
+            }
+            (None, None) => true,
+            _ => false,
+        }
+    }
+}
+
+impl fmt::Debug for RoutingTable {
+    /// Counts only: the hash maps iterate in a per-instance random order, and this output
+    /// feeds the config hash, which must be stable for identical configs.
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.debug_struct("RoutingTable")
+            .field("domains", &self.domains.len())
+            .field("exact_hosts", &self.exact.len())
+            .field("wildcard_hosts", &self.wildcard.len())
+            .field("catch_all", &self.catch_all)
+            .finish()
+    }
+}
+
+impl PartialEq for RoutingTable {
+    /// The table is a pure function of its domains and the backends they resolve to.
+    fn eq(&self, other: &Self) -> bool {
+        self.domains == other.domains && self.upstreams == other.upstreams
+    }
+}
+
+/// Byte trie over one domain's route prefixes.
+///
+/// A node that terminates a prefix stores the `start..end` range of its same-prefix group in the
+/// sorted route list. Walking the path byte by byte and keeping the deepest terminal that sits on
+/// a segment boundary yields the longest [`prefix_matches`] prefix.
+struct PrefixTrie {
+    nodes: Vec<TrieNode>,
+}
+
+#[derive(Default)]
+struct TrieNode {
+    /// `(byte, child node index)`, sorted by byte.
+    children: Vec<(u8, usize)>,
+    /// Route range of the prefix ending at this node.
+    group: Option<(usize, usize)>,
+}
+
+impl TrieNode {
+    fn child(&self, byte: u8) -> Option<usize> {
+        self.children
+            .binary_search_by_key(&byte, |&(b, _)| b)
+            .ok()
+            .map(|i| self.children[i].1)
+    }
+}
+
+impl PrefixTrie {
+    fn build(routes: &[Route]) -> Self {
+        let mut trie = Self { nodes: vec![TrieNode::default()] };
+        let mut start = 0;
+        while start < routes.len() {
+            let end = start.saturating_add(same_prefix_len(&routes[start..]));
+            trie.insert(routes[start].prefix.as_bytes(), (start, end));
+            start = end;
+        }
+        trie
+    }
+
+    fn insert(&mut self, prefix: &[u8], group: (usize, usize)) {
+        let mut node = 0;
+        for &byte in prefix {
+            node = match self.nodes[node].child(byte) {
+                Some(child) => child,
+                None => {
+                    let child = self.nodes.len();
+                    self.nodes.push(TrieNode::default());
+                    let children = &mut self.nodes[node].children;
+                    let at = children.partition_point(|&(b, _)| b < byte);
+                    children.insert(at, (byte, child));
+                    child
+                }
+            };
+        }
+        // First group wins, like the linear `find` over sorted routes.
+        self.nodes[node].group.get_or_insert(group);
+    }
+
+    fn longest_match(&self, path: &str) -> Option<(usize, usize)> {
+        let bytes = path.as_bytes();
+        let mut node = 0;
+        let mut depth = 0;
+        let mut best = None;
+        loop {
+            if let Some(group) = self.nodes[node].group {
+                // `prefix_matches` boundary rule: exact, sub-path, or the root prefix `/`.
+                let on_boundary = depth == bytes.len()
+                    || bytes[depth] == b'/'
+                    || (depth == 1 && bytes[0] == b'/');
+                if on_boundary {
+                    best = Some(group);
+                }
+            }
+            let Some(&byte) = bytes.get(depth) else {
+                break;
+            };
+            match self.nodes[node].child(byte) {
+                Some(child) => {
+                    node = child;
+                    depth = depth.saturating_add(1);
+                }
+                None => break,
+            }
+        }
+        best
+    }
 }
@@ -9,7 +9,8 @@ use crate::security::RateLimitManager;
 #[derive(Clone)]
 pub struct SecurityContext {
     pub headers: SecurityHeaders,
-    pub ip_filter: IpFilterConfig,
+    /// Shared with the config snapshot: cloning the context never copies the lists.
+    pub ip_filter: Arc<IpFilterConfig>,
     pub rate_limit_config: RateLimitConfig,
     pub rate_limit_manager: Option<Arc<RateLimitManager>>,
     pub global_header_manipulation: Option<HeaderManipulation>,
@@ -20,7 +21,7 @@ pub struct SecurityContext {
 impl SecurityContext {
     pub fn new(
         headers: SecurityHeaders,
-        ip_filter: IpFilterConfig,
+        ip_filter: impl Into<Arc<IpFilterConfig>>,
         rate_limit_config: RateLimitConfig,
         rate_limit_manager: Option<Arc<RateLimitManager>>,
         global_header_manipulation: Option<HeaderManipulation>,
@@ -28,7 +29,7 @@ impl SecurityContext {
     ) -> Self {
         Self {
             headers,
-            ip_filter,
+            ip_filter: ip_filter.into(),
             rate_limit_config,
             rate_limit_manager,
             global_header_manipulation,
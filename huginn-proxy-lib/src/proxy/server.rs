@@ -1,21 +1,28 @@
 use crate::backend::health_check::{HealthCheckSupervisor, HealthRegistry};
 use crate::backend::BackendSelector;
 use crate::config::watcher::spawn_config_watcher;
-use crate::config::{EffectiveConfigSummary, EffectiveConfigView, StaticConfig};
+use crate::config::{
+    AcceptConfig, AcceptMode, EffectiveConfigSummary, EffectiveConfigView, StaticConfig,
+};
 use crate::error::Result;
 pub use crate::proxy::accept::SynProbe;
 use crate::proxy::accept::{accept_loop, AcceptContext};
+use crate::proxy::admission::{ConcurrencyLimiter, SchedulerLag};
+use crate::proxy::cache::ResponseCache;
+use crate::proxy::coalesce::Coalescer;
 use crate::proxy::connection::ConnectionManager;
-use crate::proxy::listener::{bind_listener, register_signal};
+use crate::proxy::listener::{bind_listener, bind_reuseport_listeners, register_signal};
 use crate::proxy::peer_resolution::ResolvedProxyProtocol;
 use crate::proxy::protocol::warn_proxy_protocol_trust_gap;
 use crate::proxy::reload::{
     initial_client_pool, initial_rate_limiter, try_reload, SharedDynamicConfig,
 };
+use crate::proxy::shard::{shard_cpus, spawn_pinned_shard, PinnedShard, ShardHandles};
 use crate::proxy::shutdown::{wait_for_drain, ServiceHandle, ShutdownSender};
 pub use crate::proxy::watch::WatchOptions;
-use crate::telemetry::{Metrics, Readiness};
-use crate::tls::{build_tls_acceptor, DynamicCertResolver};
+use crate::security::rate_limit::ClusterSync;
+use crate::telemetry::{FingerprintExporter, Metrics, Readiness, TimingPolicy};
+use crate::tls::{build_tls_acceptor, DynamicCertResolver, SharedSessionCache, SharedTicketer};
 use hyper_util::rt::{TokioExecutor, TokioTimer};
 use hyper_util::server::conn::auto::Builder as ConnBuilder;
 use std::net::SocketAddr;
@@ -40,13 +47,25 @@ pub async fn run(
     // Derive receiver from the sender so all clones share the same channel
     let shutdown_rx = shutdown_tx.subscribe();
 
-    let rate_limiter = Arc::new(initial_rate_limiter(&dynamic_cfg.load()));
-    let client_pool = initial_client_pool(&static_cfg, &dynamic_cfg.load().backend_pool);
+    // Binding the cluster sync seeds rate-limit key hashing, so it precedes the first manager.
+    let cluster_sync = if static_cfg.rate_limit_cluster.enabled {
+        Some(ClusterSync::bind(&static_cfg.rate_limit_cluster).await?)
+    } else {
+        None
+    };
+    let rate_limiter = Arc::new(initial_rate_limiter(&dynamic_cfg.load(), cluster_sync.is_some()));
+    let client_pool = initial_client_pool(&static_cfg, &dynamic_cfg.load());
+    let backends = Arc::clone(&dynamic_cfg.load().backends);
+    client_pool.load_full().prewarm(&backends, &metrics).await;
 
     let health_registry = Arc::new(HealthRegistry::new());
-    let health_supervisor = Arc::new(HealthCheckSupervisor::new(health_registry.clone()));
-    health_supervisor.reconcile(&dynamic_cfg.load().backends, &metrics, &Handle::current());
     let backend_selector = Arc::new(BackendSelector::new());
+    let health_supervisor = Arc::new(HealthCheckSupervisor::with_selector(
+        health_registry.clone(),
+        Arc::clone(&backend_selector),
+    ));
+    health_supervisor.reconcile_config(&dynamic_cfg.load(), &metrics, &Handle::current());
+    metrics.record_ip_filter_index(&dynamic_cfg.load().ip_filters);
 
     let idle_timeout = Duration::from_millis(static_cfg.timeout.proxy_idle_ms);
 
@@ -64,6 +83,13 @@ pub async fn run(
 
     // Collect background service handles for ordered cooperative shutdown.
     let mut services: Vec<ServiceHandle> = Vec::new();
+    if let Some(cluster_sync) = cluster_sync {
+        services.push(cluster_sync.spawn(
+            Arc::clone(&rate_limiter),
+            Arc::clone(&metrics),
+            shutdown_rx.clone(),
+        ));
+    }
 
     // Build the cert resolver and load initial certs from the current dynamic config.
     // `None` when TLS is not configured (plain HTTP mode).
@@ -88,20 +114,66 @@ pub async fn run(
         None
     };
 
+    // Shared session ticket keys; kept here so hot reload can rotate them.
+    let ticketer: Option<Arc<SharedTicketer>> = match &static_cfg.tls {
+        Some(tls) => SharedTicketer::from_config(&tls.session_resumption)?,
+        None => None,
+    };
+    if let Some(ticketer) = &ticketer {
+        info!(
+            path = %ticketer.path().display(),
+            keys = ticketer.key_count(),
+            "TLS session tickets use shared keys"
+        );
+    }
+
+    // One shared session store for every listener, with its writer thread.
+    let session_cache: Option<Arc<SharedSessionCache>> = match &static_cfg.tls {
+        Some(tls) => SharedSessionCache::from_config(&tls.session_resumption, ticketer.clone())?,
+        None => None,
+    };
+
     let tls_acceptor = match (&static_cfg.tls, &cert_resolver) {
-        (Some(tls_config), Some(resolver)) => {
-            Some(build_tls_acceptor(tls_config, Arc::clone(resolver)).await?)
-        }
+        (Some(tls_config), Some(resolver)) => Some(
+            build_tls_acceptor(
+                tls_config,
+                Arc::clone(resolver),
+                ticketer.clone(),
+                session_cache.clone(),
+            )
+            .await?,
+        ),
         _ => None,
     };
 
     let shutdown_signal = Arc::new(AtomicUsize::new(0));
     let (connections_closed_tx, connections_closed_rx) = watch::channel(());
-    let connection_manager = Arc::new(ConnectionManager::new(
-        static_cfg.max_connections,
-        shutdown_signal.clone(),
-        connections_closed_tx.clone(),
-    ));
+    let connection_manager = Arc::new(
+        ConnectionManager::new(
+            static_cfg.max_connections,
+            shutdown_signal.clone(),
+            connections_closed_tx.clone(),
+        )
+        .with_per_ip_limit(static_cfg.admission.max_connections_per_ip),
+    );
+    let max_scheduler_lag = (static_cfg.admission.max_scheduler_lag_ms > 0)
+        .then(|| Duration::from_millis(static_cfg.admission.max_scheduler_lag_ms));
+    let scheduler_lag = max_scheduler_lag.map(|threshold| {
+        let lag = Arc::new(SchedulerLag::new(threshold));
+        services.push(lag.spawn(Arc::clone(&metrics), shutdown_rx.clone()));
+        lag
+    });
+
+    let fingerprint_export = match FingerprintExporter::new(
+        &static_cfg.telemetry.fingerprint_export,
+        Arc::clone(&metrics),
+    ) {
+        Some((exporter, task)) => {
+            services.push(task.spawn(shutdown_rx.clone()).await?);
+            Some(exporter)
+        }
+        None => None,
+    };
 
     let mut sigterm = register_signal(signal::unix::SignalKind::terminate(), "SIGTERM")?;
     let mut sigint = register_signal(signal::unix::SignalKind::interrupt(), "SIGINT")?;
@@ -131,25 +203,55 @@ pub async fn run(
     let reload_mutex = Arc::new(tokio::sync::Mutex::new(()));
 
     let backlog = static_cfg.listen.tcp_backlog;
-    let listeners: Vec<(SocketAddr, TcpListener)> = static_cfg
-        .listen
-        .addrs
-        .iter()
-        .map(|&addr| {
-            bind_listener(addr, backlog)
-                .map(|l| (addr, l))
-                .map_err(crate::error::ProxyError::Io)
-        })
-        .collect::<Result<_>>()?;
+    let accept = static_cfg.listen.accept;
+    let shards = accept_shards(&accept);
+    let mut listeners: Vec<(SocketAddr, TcpListener)> = Vec::new();
+    let mut pinned_shards: Vec<PinnedShard> = Vec::new();
+    match accept.mode {
+        AcceptMode::Single => {
+            for &addr in &static_cfg.listen.addrs {
+                listeners.push((addr, bind_listener(addr, backlog)?));
+            }
+        }
+        AcceptMode::ReusePort => {
+            for &addr in &static_cfg.listen.addrs {
+                for listener in
+                    bind_reuseport_listeners(addr, backlog, shards, accept.cpu_steering)?
+                {
+                    listeners.push((addr, TcpListener::from_std(listener)?));
+                }
+            }
+        }
+        AcceptMode::ThreadPerCore => {
+            pinned_shards = shard_cpus(shards)
+                .into_iter()
+                .enumerate()
+                .map(|(index, cpu)| PinnedShard { index, cpu, listeners: Vec::new() })
+                .collect();
+            for &addr in &static_cfg.listen.addrs {
+                let group = bind_reuseport_listeners(addr, backlog, shards, accept.cpu_steering)?;
+                for (shard, listener) in pinned_shards.iter_mut().zip(group) {
+                    shard.listeners.push((addr, listener));
+                }
+            }
+        }
+    }
 
-    for (addr, _) in &listeners {
-        info!(?addr, "starting proxy");
+    for addr in &static_cfg.listen.addrs {
+        info!(
+            ?addr,
+            accept_mode = accept.mode.as_str(),
+            shards,
+            cpu_steering = accept.cpu_steering,
+            "starting proxy"
+        );
     }
 
     let ctx = Arc::new(AcceptContext {
         dynamic_cfg: Arc::clone(&dynamic_cfg),
         rate_limiter: Arc::clone(&rate_limiter),
         tls_acceptor,
+        session_cache,
         fingerprint_config: static_cfg.fingerprint.clone(),
         keep_alive_config: static_cfg.timeout.keep_alive.clone(),
         metrics: Arc::clone(&metrics),
@@ -163,6 +265,12 @@ pub async fn run(
             static_cfg.timeout.connection_handling_secs,
         ),
         proxy_protocol: ResolvedProxyProtocol::resolve(static_cfg.listen.proxy_protocol),
+        concurrency: ConcurrencyLimiter::from_config(&static_cfg.admission).map(Arc::new),
+        max_scheduler_lag,
+        response_cache: ResponseCache::from_config(&static_cfg.cache).map(Arc::new),
+        coalescer: Arc::new(Coalescer::new()),
+        timing: Arc::new(TimingPolicy::new(&static_cfg.telemetry.timing)),
+        fingerprint_export,
     });
 
     // Spawn one accept task per listener.
@@ -176,9 +284,22 @@ pub async fn run(
             Arc::clone(&shutdown_signal),
             shutdown_rx.clone(),
             Arc::clone(&connection_manager),
+            scheduler_lag.clone(),
             Arc::clone(&ctx),
         ));
     }
+    if !pinned_shards.is_empty() {
+        let handles = ShardHandles {
+            shutdown_signal: Arc::clone(&shutdown_signal),
+            shutdown_rx: shutdown_rx.clone(),
+            connection_manager: Arc::clone(&connection_manager),
+            connections_closed_rx: connections_closed_rx.clone(),
+            ctx: Arc::clone(&ctx),
+        };
+        for shard in pinned_shards {
+            spawn_pinned_shard(shard, handles.clone())?;
+        }
+    }
 
     warn_proxy_protocol_trust_gap(
         static_cfg.listen.proxy_protocol.mode,
@@ -232,6 +353,7 @@ pub async fn run(
                         &metrics,
                         &health_supervisor,
                         cert_resolver.as_ref(),
+                        ticketer.as_ref(),
                     )
                     .await;
                 }
@@ -279,3 +401,16 @@ pub async fn run(
     info!("Proxy server stopped");
     Ok(())
 }
+
+/// Sockets per listen address for the accept mode; `shards = 0` follows the runtime (one per
+/// worker) or the CPUs available to the process.
+fn accept_shards(accept: &AcceptConfig) -> usize {
+    match accept.mode {
+        AcceptMode::Single => 1,
+        _ if accept.shards > 0 => accept.shards,
+        AcceptMode::ReusePort => Handle::current().metrics().num_workers(),
+        AcceptMode::ThreadPerCore => std::thread::available_parallelism()
+            .map(|n| n.get())
+            .unwrap_or(1),
+    }
+}
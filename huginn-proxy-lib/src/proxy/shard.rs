@@ -0,0 +1,167 @@
+use std::net::SocketAddr;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::Arc;
+
+use tokio::net::TcpListener;
+use tokio::sync::watch;
+use tokio::task::JoinSet;
+use tracing::{debug, warn};
+
+use crate::error::{ProxyError, Result};
+use crate::proxy::accept::{accept_loop, AcceptContext};
+use crate::proxy::admission::SchedulerLag;
+use crate::proxy::connection::ConnectionManager;
+use crate::proxy::shutdown::ShutdownWatch;
+
+/// One shard of the `thread_per_core` accept mode: its member of every listen address'
+/// `SO_REUSEPORT` group, and the CPU its thread is pinned to.
+pub struct PinnedShard {
+    pub index: usize,
+    pub cpu: Option<usize>,
+    pub listeners: Vec<(SocketAddr, std::net::TcpListener)>,
+}
+
+/// Shared handles every shard thread needs, cloned per shard.
+#[derive(Clone)]
+pub struct ShardHandles {
+    pub shutdown_signal: Arc<AtomicUsize>,
+    pub shutdown_rx: ShutdownWatch,
+    pub connection_manager: Arc<ConnectionManager>,
+    pub connections_closed_rx: watch::Receiver<()>,
+    pub ctx: Arc<AcceptContext>,
+}
+
+/// CPU for each of `shards` threads, from the CPUs this process may run on.
+///
+/// Shard `i` gets an allowed CPU `c` with `c % shards == i` when there is one, so that with
+/// `cpu_steering` (which routes a SYN received on CPU `c` to shard `c % shards`) the shard serving
+/// a connection runs where its packets arrive. `None` when the affinity mask is unavailable.
+pub fn shard_cpus(shards: usize) -> Vec<Option<usize>> {
+    let allowed = allowed_cpus();
+    (0..shards)
+        .map(|index| {
+            allowed
+                .iter()
+                .copied()
+                .find(|cpu| cpu.checked_rem(shards) == Some(index))
+                .or_else(|| {
+                    index
+                        .checked_rem(allowed.len())
+                        .and_then(|i| allowed.get(i).copied())
+                })
+        })
+        .collect()
+}
+
+/// Run a shard on its own thread with a single-threaded runtime. Connections it accepts, and
+/// everything they spawn (handshakes, proxied requests, backend connections they open), stay on
+/// that thread. After shutdown stops its accept loops, the runtime keeps serving the shard's
+/// connections until the proxy has drained.
+pub fn spawn_pinned_shard(shard: PinnedShard, handles: ShardHandles) -> Result<()> {
+    let runtime = tokio::runtime::Builder::new_current_thread()
+        .enable_all()
+        .build()
+        .map_err(ProxyError::Io)?;
+    let PinnedShard { index, cpu, listeners } = shard;
+
+    std::thread::Builder::new()
+        .name(format!("huginn-shard-{index}"))
+        .spawn(move || {
+            if let Some(cpu) = cpu {
+                match pin_current_thread(cpu) {
+                    Ok(()) => debug!(shard = index, cpu, "accept shard pinned"),
+                    Err(e) => warn!(shard = index, cpu, error = %e, "failed to pin accept shard"),
+                }
+            }
+            runtime.block_on(serve_shard(index, listeners, handles));
+        })
+        .map_err(ProxyError::Io)?;
+    Ok(())
+}
+
+async fn serve_shard(
+    index: usize,
+    listeners: Vec<(SocketAddr, std::net::TcpListener)>,
+    handles: ShardHandles,
+) {
+    let ShardHandles {
+        shutdown_signal,
+        shutdown_rx,
+        connection_manager,
+        mut connections_closed_rx,
+        ctx,
+    } = handles;
+
+    // The shard's own runtime lags independently of the main one, so it gets its own probe.
+    let scheduler_lag = ctx.max_scheduler_lag.map(|threshold| {
+        let lag = Arc::new(SchedulerLag::new(threshold));
+        tokio::spawn(Arc::clone(&lag).probe(
+            format!("shard-{index}"),
+            Arc::clone(&ctx.metrics),
+            shutdown_rx.clone(),
+        ));
+        lag
+    });
+
+    let mut accept_tasks = JoinSet::new();
+    for (addr, listener) in listeners {
+        match TcpListener::from_std(listener) {
+            Ok(listener) => {
+                accept_tasks.spawn(accept_loop(
+                    addr,
+                    listener,
+                    Arc::clone(&shutdown_signal),
+                    shutdown_rx.clone(),
+                    Arc::clone(&connection_manager),
+                    scheduler_lag.clone(),
+                    Arc::clone(&ctx),
+                ));
+            }
+            Err(e) => warn!(?addr, error = %e, "failed to register accept shard listener"),
+        }
+    }
+    while accept_tasks.join_next().await.is_some() {}
+
+    // Dropping the runtime would cancel this shard's connections; the process exits once the
+    // drain completes or times out.
+    if connection_manager
+        .active_connections()
+        .load(Ordering::Relaxed)
+        != 0
+    {
+        let _ = connections_closed_rx.changed().await;
+    }
+}
+
+#[cfg(target_os = "linux")]
+fn allowed_cpus() -> Vec<usize> {
+    use nix::sched::{sched_getaffinity, CpuSet};
+    use nix::unistd::Pid;
+
+    match sched_getaffinity(Pid::from_raw(0)) {
+        Ok(set) => (0..CpuSet::count())
+            .filter(|&cpu| set.is_set(cpu).unwrap_or(false))
+            .collect(),
+        Err(_) => Vec::new(),
+    }
+}
+
+#[cfg(not(target_os = "linux"))]
+fn allowed_cpus() -> Vec<usize> {
+    Vec::new()
+}
+
+#[cfg(target_os = "linux")]
+fn pin_current_thread(cpu: usize) -> nix::Result<()> {
+    use nix::sched::{sched_setaffinity, CpuSet};
+    use nix::unistd::Pid;
+
+    let mut set = CpuSet::new();
+    set.set(cpu)?;
+    sched_setaffinity(Pid::from_raw(0), &set)
+}
+
+#[cfg(not(target_os = "linux"))]
+fn pin_current_thread(_cpu: usize) -> std::io::Result<()> {
+    Ok(())
+}
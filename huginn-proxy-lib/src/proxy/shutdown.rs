@@ -57,7 +57,16 @@ pub enum ServiceName {
     CertReload,
     ConfigWatcher,
     EbpfReconnect,
+    /// Mirror of the global IP denylist into the eBPF agent's SYN denylist maps.
+    EbpfDenylist,
+    /// eBPF reconnect watcher that also drains the SYN event ring.
+    EbpfSynEvents,
+    /// Batched fingerprint export (`[telemetry.fingerprint_export]`).
+    FingerprintExport,
     MetricsServer,
+    RateLimitCluster,
+    /// Scheduler-lag probe of the main runtime (`[admission].max_scheduler_lag_ms`).
+    SchedulerLag,
 }
 
 impl fmt::Display for ServiceName {
@@ -66,7 +75,12 @@ impl fmt::Display for ServiceName {
             Self::CertReload => "cert-reload",
             Self::ConfigWatcher => "config-watcher",
             Self::EbpfReconnect => "ebpf-reconnect",
+            Self::EbpfDenylist => "ebpf-denylist",
+            Self::EbpfSynEvents => "ebpf-syn-events",
+            Self::FingerprintExport => "fingerprint-export",
             Self::MetricsServer => "metrics-server",
+            Self::RateLimitCluster => "rate-limit-cluster",
+            Self::SchedulerLag => "scheduler-lag",
         })
     }
 }
@@ -3,10 +3,11 @@ use std::sync::Arc;
 use super::timeout_helper::serve_with_timeout;
 use crate::backend::UpstreamGateway;
 use crate::fingerprinting::TcpObservation;
+use crate::proxy::connection::ConnectionMemo;
 use crate::proxy::handler::request::handle_proxy_request;
 use crate::proxy::synthetic_response::synthetic_error_response;
 use crate::proxy::ClientPool;
-use crate::telemetry::Metrics;
+use crate::telemetry::{ConnectionTiming, FingerprintExporter, Metrics};
 use http::StatusCode;
 use hyper_util::rt::{TokioExecutor, TokioIo};
 use hyper_util::server::conn::auto::Builder as ConnBuilder;
@@ -14,7 +15,8 @@ use tokio::net::TcpStream;
 
 /// Configuration for handling plain HTTP connections
 pub struct PlainConnectionConfig {
-    pub domains: Arc<Vec<crate::config::Domain>>,
+    pub routing: Arc<crate::proxy::router::RoutingTable>,
+    pub ip_filters: Arc<crate::security::IpFilterIndex>,
     pub backends: Arc<Vec<crate::config::Backend>>,
     pub keep_alive: crate::config::KeepAliveConfig,
     pub security: crate::proxy::SecurityContext,
@@ -25,6 +27,9 @@ pub struct PlainConnectionConfig {
     pub client_pool: Arc<ClientPool>,
     pub syn_fingerprint: Option<TcpObservation>,
     pub upstream: UpstreamGateway,
+    pub timing: ConnectionTiming,
+    /// `[telemetry.fingerprint_export]` queue; `None` when disabled.
+    pub fingerprint_export: Option<Arc<FingerprintExporter>>,
 }
 
 /// Handle a plain HTTP connection
@@ -35,15 +40,23 @@ pub async fn handle_plain_connection(
 ) {
     let backends = config.backends.clone();
     let metrics = config.metrics.clone();
-    let domains = config.domains.clone();
+    let routing = config.routing.clone();
+    let ip_filters = config.ip_filters.clone();
     let keep_alive = config.keep_alive.clone();
     let security = config.security.clone();
     let client_pool = config.client_pool.clone();
     let syn_fingerprint = config.syn_fingerprint.clone();
     let upstream = config.upstream.clone();
+    let timing = Arc::new(config.timing);
+    let fingerprint_export = config.fingerprint_export.clone();
+
+    // Per-connection routing/security memo shared by every request (HTTP/2 stream or
+    // keep-alive request) this service handles.
+    let memo = Arc::new(ConnectionMemo::new());
 
     let svc = hyper::service::service_fn(move |req: hyper::Request<hyper::body::Incoming>| {
-        let domains = domains.clone();
+        let routing = routing.clone();
+        let ip_filters = ip_filters.clone();
         let backends = backends.clone();
         let syn_fingerprint = syn_fingerprint.clone();
         let metrics = metrics.clone();
@@ -51,13 +64,17 @@ pub async fn handle_plain_connection(
         let security = security.clone();
         let client_pool = client_pool.clone();
         let upstream = upstream.clone();
+        let memo = memo.clone();
+        let timing = timing.clone();
+        let fingerprint_export = fingerprint_export.clone();
 
         async move {
             let preserve_host = config.preserve_host;
             let metrics_for_match = metrics.clone();
             let http_result = handle_proxy_request(
                 req,
-                domains,
+                routing,
+                ip_filters,
                 backends,
                 None,
                 None,
@@ -71,6 +88,9 @@ pub async fn handle_plain_connection(
                 &client_pool,
                 &upstream,
                 None,
+                &memo,
+                &timing,
+                fingerprint_export.as_deref(),
             )
             .await;
 
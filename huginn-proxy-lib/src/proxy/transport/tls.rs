@@ -3,26 +3,37 @@ use std::sync::Arc;
 use super::timeout_helper::serve_with_timeout;
 use crate::backend::UpstreamGateway;
 use crate::fingerprinting::TcpObservation;
-use crate::fingerprinting::{read_client_hello, CapturingStream};
-use crate::proxy::connection::{PrefixedStream, TlsConnectionGuard};
+use crate::fingerprinting::{
+    read_client_hello_buffered, CapturingStream, ClientHello, Http2Fingerprint,
+};
+use crate::proxy::connection::{ConnectionMemo, TlsConnectionGuard};
 use crate::proxy::handler::request::handle_proxy_request;
 use crate::proxy::synthetic_response::synthetic_error_response;
 use crate::proxy::ClientPool;
-use crate::telemetry::Metrics;
+use crate::telemetry::values;
+use crate::telemetry::{ConnectionTiming, FingerprintExporter, Metrics, Phase};
+use crate::tls::ktls;
 use crate::tls::record_tls_handshake_metrics;
 use crate::tls::setup::SharedTlsAcceptor;
+use crate::tls::ClientTlsStream;
+use crate::tls::SharedSessionCache;
 use http::StatusCode;
 use hyper_util::rt::{TokioExecutor, TokioIo};
 use hyper_util::server::conn::auto::Builder as ConnBuilder;
+use tokio::io::AsyncWriteExt;
 use tokio::net::TcpStream;
 use tokio::time::Instant;
+use tokio_rustls::rustls::ServerConnection;
 use tracing::warn;
 
 /// Configuration for handling TLS connections
 pub struct TlsConnectionConfig {
     pub tls_acceptor: SharedTlsAcceptor,
+    /// Shared TLS 1.2 session store; `None` without `session_resumption.shared_cache`.
+    pub session_cache: Option<Arc<SharedSessionCache>>,
     pub fingerprint_config: crate::config::FingerprintConfig,
-    pub domains: Arc<Vec<crate::config::Domain>>,
+    pub routing: Arc<crate::proxy::router::RoutingTable>,
+    pub ip_filters: Arc<crate::security::IpFilterIndex>,
     pub backends: Arc<Vec<crate::config::Backend>>,
     pub keep_alive: crate::config::KeepAliveConfig,
     pub security: crate::proxy::SecurityContext,
@@ -34,20 +45,49 @@ pub struct TlsConnectionConfig {
     pub client_pool: Arc<ClientPool>,
     pub syn_fingerprint: Option<TcpObservation>,
     pub upstream: UpstreamGateway,
+    pub timing: ConnectionTiming,
+    /// `[telemetry.fingerprint_export]` queue; `None` when disabled.
+    pub fingerprint_export: Option<Arc<FingerprintExporter>>,
+}
+
+/// Push bytes already read from the client (the ClientHello and anything after it) into a
+/// fresh rustls session, as if rustls had read them from the socket itself.
+fn feed_client_hello(conn: &mut ServerConnection, mut bytes: &[u8]) -> std::io::Result<()> {
+    while !bytes.is_empty() {
+        if conn.read_tls(&mut bytes)? == 0 {
+            break;
+        }
+        conn.process_new_packets()
+            .map_err(|e| std::io::Error::new(std::io::ErrorKind::InvalidData, e))?;
+    }
+    Ok(())
+}
+
+/// The alert rustls queued after a failed handshake step.
+fn take_alert(conn: &mut ServerConnection) -> Vec<u8> {
+    let mut alert = Vec::new();
+    while conn.wants_write() && conn.write_tls(&mut alert).is_ok() {}
+    alert
 }
 
 /// Handle a TLS connection
+///
+/// `client_hello` holds whatever the PROXY header stage already read past the header; the
+/// ClientHello read continues from it.
 pub async fn handle_tls_connection(
     mut stream: TcpStream,
     peer: std::net::SocketAddr,
+    client_hello: ClientHello,
     config: TlsConnectionConfig,
 ) {
     let metrics = config.metrics.clone();
     let acc = config.tls_acceptor.load_full();
+    let mut timing = config.timing;
     {
         let handshake_start = Instant::now();
-        let (prefix, ja4_fingerprints) =
-            match read_client_hello(&mut stream, Arc::clone(&metrics)).await {
+        let (client_hello, ja4_fingerprints) =
+            match read_client_hello_buffered(&mut stream, client_hello, Arc::clone(&metrics)).await
+            {
                 Ok(v) => v,
                 Err(e) => {
                     warn!(?peer, error = %e, "failed to read client hello");
@@ -55,10 +95,66 @@ pub async fn handle_tls_connection(
                     return;
                 }
             };
+        timing.record(Phase::ClientHello, handshake_start.elapsed(), &metrics);
+        let accept_start = Instant::now();
 
-        let prefixed = PrefixedStream::new(prefix, stream);
-        let tls_accept_result =
-            tokio::time::timeout(config.tls_handshake_timeout, acc.accept(prefixed)).await;
+        // rustls looks sessions up synchronously: one issued by another replica has to be in
+        // the local cache before the handshake starts.
+        if let Some(session_cache) = &config.session_cache {
+            session_cache.prefetch(client_hello.bytes()).await;
+        }
+
+        // The bytes already read are handed to rustls before the handshake starts, so the
+        // session wraps the bare socket and the ClientHello buffer goes back to the pool.
+        let kernel_tls = acc.config().enable_secret_extraction;
+        let tls_accept_result = if kernel_tls {
+            // kTLS needs every byte after the handshake left on the socket: only whole records
+            // are fed here, and the rest of the handshake is read record by record.
+            let mut conn = match ServerConnection::new(Arc::clone(acc.config())) {
+                Ok(conn) => conn,
+                Err(e) => {
+                    warn!(?peer, error = %e, "TLS accept failed");
+                    metrics.record_tls_handshake_error();
+                    return;
+                }
+            };
+            let bytes = client_hello.bytes();
+            let (records, pending) = bytes.split_at(ktls::complete_records_len(bytes));
+            let fed = feed_client_hello(&mut conn, records);
+            let pending = pending.to_vec();
+            drop(client_hello);
+            if let Err(e) = fed {
+                let _ = stream.write_all(&take_alert(&mut conn)).await;
+                warn!(?peer, error = %e, "TLS accept failed");
+                metrics.record_tls_handshake_error();
+                return;
+            }
+            tokio::time::timeout(
+                config.tls_handshake_timeout,
+                ktls::finish_handshake(&acc, stream, conn, pending),
+            )
+            .await
+        } else {
+            let mut fed = Ok(());
+            let mut alert = Vec::new();
+            let mut accept = acc.accept_with(stream, |conn| {
+                fed = feed_client_hello(conn, client_hello.bytes());
+                if fed.is_err() {
+                    alert = take_alert(conn);
+                }
+            });
+            drop(client_hello);
+            if let Err(e) = fed {
+                if let Some(stream) = accept.get_mut() {
+                    let _ = stream.write_all(&alert).await;
+                }
+                warn!(?peer, error = %e, "TLS accept failed");
+                metrics.record_tls_handshake_error();
+                return;
+            }
+
+            tokio::time::timeout(config.tls_handshake_timeout, accept).await
+        };
 
         let tls = match tls_accept_result {
             Ok(Ok(tls)) => tls,
@@ -79,9 +175,31 @@ pub async fn handle_tls_connection(
         record_tls_handshake_metrics(&tls, handshake_duration, &metrics);
 
         // SNI negotiated by the TLS connection (the name that selected the served cert).
-        // Captured once here; HTTP/2 may carry many requests with differing `:authority`,
-        // and the always-on misdirected-request (421) check compares each against this value.
-        let connection_sni: Option<Arc<str>> = tls.get_ref().1.server_name().map(Arc::from);
+        // Captured (and lowercased) once here; HTTP/2 may carry many requests with differing
+        // `:authority`, and the always-on misdirected-request (421) check compares each against it.
+        let connection_sni: Option<Arc<str>> = tls
+            .get_ref()
+            .1
+            .server_name()
+            .map(|sni| Arc::from(sni.to_ascii_lowercase()));
+
+        let tls = if kernel_tls {
+            match ktls::offload(tls) {
+                Ok(offload) => {
+                    metrics.record_tls_ktls_offload(offload.result);
+                    offload.stream
+                }
+                Err(e) => {
+                    warn!(?peer, error = %e, "kTLS offload failed, closing connection");
+                    metrics.record_tls_ktls_offload(values::KTLS_ERROR);
+                    return;
+                }
+            }
+        } else {
+            ClientTlsStream::Rustls(tls)
+        };
+        timing.record(Phase::TlsAccept, accept_start.elapsed(), &metrics);
+        let timing = Arc::new(timing);
 
         // Guard decrements TLS connection metrics counter when connection closes.
         // The main active_connections counter is handled by ConnectionGuard.
@@ -100,25 +218,32 @@ pub async fn handle_tls_connection(
 
         if config.fingerprint_config.http_enabled {
             let (fingerprint_tx, fingerprint_rx) =
-                tokio::sync::watch::channel(None::<huginn_net_http::AkamaiFingerprint>);
+                tokio::sync::watch::channel(None::<Http2Fingerprint>);
 
-            let (capturing_stream, _fingerprint_extracted) = CapturingStream::new(
+            let capturing_stream = CapturingStream::new(
                 tls,
                 config.fingerprint_config.max_capture,
-                fingerprint_tx.clone(),
+                fingerprint_tx,
                 Arc::clone(&metrics),
             );
 
             let backends = config.backends.clone();
-            let domains = config.domains.clone();
+            let routing = config.routing.clone();
+            let ip_filters = config.ip_filters.clone();
             let keep_alive = config.keep_alive.clone();
             let security = config.security.clone();
             let client_pool = config.client_pool.clone();
             let upstream = config.upstream.clone();
 
+            // Per-connection routing/security memo shared by every request (HTTP/2 stream or
+            // keep-alive request) this service handles.
+            let memo = Arc::new(ConnectionMemo::new());
+            let fingerprint_export = config.fingerprint_export.clone();
+
             let svc =
                 hyper::service::service_fn(move |req: hyper::Request<hyper::body::Incoming>| {
-                    let domains = domains.clone();
+                    let routing = routing.clone();
+                    let ip_filters = ip_filters.clone();
                     let backends = backends.clone();
                     let ja4_fingerprints = ja4_fingerprints.clone();
                     let fingerprint_rx = fingerprint_rx.clone();
@@ -128,14 +253,18 @@ pub async fn handle_tls_connection(
                     let security = security.clone();
                     let client_pool_for_request = client_pool.clone();
                     let upstream = upstream.clone();
+                    let memo = memo.clone();
                     let connection_sni = connection_sni.clone();
+                    let timing = timing.clone();
+                    let fingerprint_export = fingerprint_export.clone();
 
                     async move {
                         let metrics_for_match = metrics.clone();
                         let preserve_host = config.preserve_host;
                         let http_result = handle_proxy_request(
                             req,
-                            domains,
+                            routing,
+                            ip_filters,
                             backends,
                             ja4_fingerprints,
                             Some(fingerprint_rx),
@@ -149,6 +278,9 @@ pub async fn handle_tls_connection(
                             &client_pool_for_request,
                             &upstream,
                             connection_sni.as_deref(),
+                            &memo,
+                            &timing,
+                            fingerprint_export.as_deref(),
                         )
                         .await;
 
@@ -178,15 +310,22 @@ pub async fn handle_tls_connection(
                 .await;
         } else {
             let backends = config.backends.clone();
-            let domains = config.domains.clone();
+            let routing = config.routing.clone();
+            let ip_filters = config.ip_filters.clone();
             let keep_alive = config.keep_alive.clone();
             let security = config.security.clone();
             let client_pool = config.client_pool.clone();
             let upstream = config.upstream.clone();
 
+            // Per-connection routing/security memo shared by every request (HTTP/2 stream or
+            // keep-alive request) this service handles.
+            let memo = Arc::new(ConnectionMemo::new());
+            let fingerprint_export = config.fingerprint_export.clone();
+
             let svc =
                 hyper::service::service_fn(move |req: hyper::Request<hyper::body::Incoming>| {
-                    let domains = domains.clone();
+                    let routing = routing.clone();
+                    let ip_filters = ip_filters.clone();
                     let backends = backends.clone();
                     let ja4_fingerprints = ja4_fingerprints.clone();
                     let syn_fingerprint = syn_fingerprint.clone();
@@ -195,14 +334,18 @@ pub async fn handle_tls_connection(
                     let security = security.clone();
                     let client_pool = client_pool.clone();
                     let upstream = upstream.clone();
+                    let memo = memo.clone();
                     let connection_sni = connection_sni.clone();
+                    let timing = timing.clone();
+                    let fingerprint_export = fingerprint_export.clone();
 
                     async move {
                         let preserve_host = config.preserve_host;
                         let metrics_for_match = metrics.clone();
                         let http_result = handle_proxy_request(
                             req,
-                            domains,
+                            routing,
+                            ip_filters,
                             backends,
                             ja4_fingerprints,
                             None,
@@ -216,6 +359,9 @@ pub async fn handle_tls_connection(
                             &client_pool,
                             &upstream,
                             connection_sni.as_deref(),
+                            &memo,
+                            &timing,
+                            fingerprint_export.as_deref(),
                         )
                         .await;
 
@@ -0,0 +1,228 @@
+//! Prewarmed upstream connections for [`ClientPool`](super::ClientPool)
+//! (`[backend_pool.prewarm]`).
+//!
+//! hyper's pooled `Client` only dials when a request finds no idle connection, so a freshly
+//! built pool pays TCP connect latency on its first wave of requests. [`WarmConnector`] sits in
+//! front of the dialer: when the client needs a new connection to a prewarmed backend it takes
+//! an already established socket from the [`WarmStash`] instead, and the stash is refilled in
+//! the background.
+
+use std::collections::HashMap;
+use std::future::Future;
+use std::io::ErrorKind;
+use std::pin::Pin;
+use std::sync::atomic::{AtomicBool, Ordering};
+use std::sync::{Arc, Mutex, OnceLock};
+use std::task::{Context, Poll};
+use std::time::Duration;
+
+use http::Uri;
+use hyper_util::client::legacy::connect::HttpConnector;
+use hyper_util::rt::TokioIo;
+use tokio::net::TcpStream;
+use tokio::sync::Notify;
+use tokio::task::JoinSet;
+use tower_service::Service;
+use tracing::debug;
+
+use crate::telemetry::Metrics;
+
+type BoxError = Box<dyn std::error::Error + Send + Sync>;
+
+/// Connector of the pooled backend clients: serves a prewarmed connection when the stash holds
+/// one for the target backend, otherwise dials like the wrapped [`HttpConnector`].
+#[derive(Clone)]
+pub struct WarmConnector {
+    dial: HttpConnector,
+    stash: Option<Arc<WarmStash>>,
+}
+
+impl WarmConnector {
+    pub(crate) fn new(dial: HttpConnector, stash: Option<Arc<WarmStash>>) -> Self {
+        Self { dial, stash }
+    }
+}
+
+impl Service<Uri> for WarmConnector {
+    type Response = TokioIo<TcpStream>;
+    type Error = BoxError;
+    type Future = Pin<Box<dyn Future<Output = Result<Self::Response, Self::Error>> + Send>>;
+
+    fn poll_ready(&mut self, cx: &mut Context<'_>) -> Poll<Result<(), Self::Error>> {
+        self.dial.poll_ready(cx).map_err(Into::into)
+    }
+
+    fn call(&mut self, uri: Uri) -> Self::Future {
+        let warm = self
+            .stash
+            .as_ref()
+            .zip(uri.authority())
+            .and_then(|(stash, authority)| stash.take(authority.as_str()));
+        if let Some(stream) = warm {
+            return Box::pin(std::future::ready(Ok(TokioIo::new(stream))));
+        }
+        let connecting = self.dial.call(uri);
+        Box::pin(async move { connecting.await.map_err(Into::into) })
+    }
+}
+
+/// Spare connections of one pooled client (HTTP/1.1 or HTTP/2), per backend address.
+pub(crate) struct WarmStash {
+    /// `protocol` metric label of the owning client.
+    protocol: &'static str,
+    dial: HttpConnector,
+    state: Mutex<StashState>,
+    /// Woken when a spare is taken, so the refill task replaces it right away. Shared with that
+    /// task, which waits on it without holding the stash.
+    wake: Arc<Notify>,
+    refill_started: AtomicBool,
+    metrics: OnceLock<Arc<Metrics>>,
+}
+
+#[derive(Default)]
+struct StashState {
+    /// Spares to keep per backend address (`host:port`, as in request URIs).
+    targets: HashMap<String, usize>,
+    idle: HashMap<String, Vec<TcpStream>>,
+}
+
+impl WarmStash {
+    pub(crate) fn new(protocol: &'static str, dial: HttpConnector) -> Self {
+        Self {
+            protocol,
+            dial,
+            state: Mutex::new(StashState::default()),
+            wake: Arc::new(Notify::new()),
+            refill_started: AtomicBool::new(false),
+            metrics: OnceLock::new(),
+        }
+    }
+
+    /// Replace the prewarmed backends; spares of addresses no longer listed are closed.
+    pub(crate) fn set_targets(&self, targets: HashMap<String, usize>) {
+        let mut state = self.state.lock().unwrap_or_else(|e| e.into_inner());
+        state
+            .idle
+            .retain(|address, _| targets.contains_key(address));
+        state.targets = targets;
+    }
+
+    /// Take a live spare for `address`. Counts a hit or miss for prewarmed addresses only.
+    fn take(&self, address: &str) -> Option<TcpStream> {
+        let (stream, remaining) = {
+            let mut state = self.state.lock().unwrap_or_else(|e| e.into_inner());
+            if !state.targets.contains_key(address) {
+                return None;
+            }
+            let idle = state.idle.get_mut(address);
+            let stream = idle.and_then(|idle| {
+                // Most recently opened last; older spares are the likeliest to be closed.
+                std::iter::from_fn(|| idle.pop()).find(is_alive)
+            });
+            let remaining = state.idle.get(address).map_or(0, Vec::len);
+            (stream, remaining)
+        };
+        if let Some(metrics) = self.metrics.get() {
+            metrics.record_backend_pool_checkout(address, self.protocol, stream.is_some());
+            metrics.record_backend_pool_warm_connections(address, self.protocol, remaining);
+        }
+        self.wake.notify_one();
+        stream
+    }
+
+    /// Drop closed spares and dial until every backend has its target count. Dial failures are
+    /// retried on the next refill.
+    pub(crate) async fn fill(&self) {
+        let deficits: Vec<(String, usize)> = {
+            let mut state = self.state.lock().unwrap_or_else(|e| e.into_inner());
+            let StashState { targets, idle } = &mut *state;
+            targets
+                .iter()
+                .filter_map(|(address, &target)| {
+                    let spares = idle.entry(address.clone()).or_default();
+                    spares.retain(is_alive);
+                    let missing = target.saturating_sub(spares.len());
+                    (missing > 0).then(|| (address.clone(), missing))
+                })
+                .collect()
+        };
+
+        let mut dials = JoinSet::new();
+        for (address, missing) in deficits {
+            let Ok(uri) = format!("http://{address}").parse::<Uri>() else {
+                continue;
+            };
+            for _ in 0..missing {
+                let mut dial = self.dial.clone();
+                let uri = uri.clone();
+                let address = address.clone();
+                dials.spawn(async move { (address, dial.call(uri).await) });
+            }
+        }
+        while let Some(joined) = dials.join_next().await {
+            let Ok((address, dialed)) = joined else {
+                continue;
+            };
+            match dialed {
+                Ok(io) => {
+                    let mut state = self.state.lock().unwrap_or_else(|e| e.into_inner());
+                    let target = state.targets.get(&address).copied().unwrap_or(0);
+                    let spares = state.idle.entry(address).or_default();
+                    if spares.len() < target {
+                        spares.push(io.into_inner());
+                    }
+                }
+                Err(e) => debug!(backend = %address, error = %e, "Prewarm connect failed"),
+            }
+        }
+        self.record_sizes();
+    }
+
+    /// Start the background refill for this stash (once). The task only holds the stash for
+    /// each `fill`, so it ends at the first wake-up after the stash, i.e. the pool owning it,
+    /// is dropped.
+    pub(crate) fn spawn_refill(self: &Arc<Self>, interval: Duration, metrics: &Arc<Metrics>) {
+        let _ = self.metrics.set(Arc::clone(metrics));
+        if self.refill_started.swap(true, Ordering::AcqRel) {
+            return;
+        }
+        let weak = Arc::downgrade(self);
+        let wake = Arc::clone(&self.wake);
+        tokio::spawn(async move {
+            loop {
+                tokio::select! {
+                    _ = wake.notified() => {}
+                    _ = tokio::time::sleep(interval) => {}
+                }
+                let Some(stash) = weak.upgrade() else {
+                    break;
+                };
+                stash.fill().await;
+            }
+        });
+    }
+
+    fn record_sizes(&self) {
+        let Some(metrics) = self.metrics.get() else {
+            return;
+        };
+        let sizes: Vec<(String, usize)> = {
+            let state = self.state.lock().unwrap_or_else(|e| e.into_inner());
+            state
+                .targets
+                .keys()
+                .map(|address| (address.clone(), state.idle.get(address).map_or(0, Vec::len)))
+                .collect()
+        };
+        for (address, size) in sizes {
+            metrics.record_backend_pool_warm_connections(&address, self.protocol, size);
+        }
+    }
+}
+
+/// An idle spare must have nothing to read: EOF means the backend closed it, and unsolicited
+/// bytes mean it is unusable for a new request.
+fn is_alive(stream: &TcpStream) -> bool {
+    let mut probe = [0u8; 1];
+    matches!(stream.try_read(&mut probe), Err(e) if e.kind() == ErrorKind::WouldBlock)
+}
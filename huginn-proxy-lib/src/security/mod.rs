@@ -3,5 +3,7 @@ pub mod ip_filter;
 pub mod rate_limit;
 
 pub use headers::apply_security_headers;
-pub use ip_filter::is_ip_allowed;
-pub use rate_limit::{extract_rate_limit_key, RateLimitManager, RateLimitResult};
+pub use ip_filter::{is_ip_allowed, CompiledIpFilter, IpFilterEntries, IpFilterIndex};
+pub use rate_limit::{
+    extract_rate_limit_key, rate_limit_key, RateLimitKey, RateLimitManager, RateLimitResult,
+};
@@ -0,0 +1,419 @@
+//! Cluster-wide rate limiting.
+//!
+//! Every node admits requests from its own buckets, so the request path never waits on the
+//! network. Every `sync_interval_ms` each node pushes the requests its limiters admitted per key
+//! to its peers over UDP, and debits what the peers push from its own buckets. The configured
+//! limits thereby become the budget of the whole cluster (each node's share is whatever it does
+//! not see the others use). The overshoot is bounded by what peers admit within one sync interval
+//! plus the network delay.
+//!
+//! A datagram is `"HRL2" || node id || sequence || sent at (ms) || count || count * (scope, key,
+//! requests) || HMAC-SHA256`, big-endian. The tag covers everything before it. Replays are
+//! dropped: a datagram must be sent within [`MAX_AGE_MS`] of the receiver's clock (either way),
+//! and its sequence must not have been accepted from its node before. As in IPsec and DTLS, the
+//! receiver tracks the last [`REPLAY_WINDOW`] sequences of each node in a bitmap, so datagrams
+//! reordered by the network are still applied and only those older than the window are dropped.
+//! Each node numbers its datagrams from 1 under a node id drawn at startup, so a restarted node
+//! starts a new sequence.
+
+use std::collections::HashMap;
+use std::net::SocketAddr;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex};
+use std::time::{Duration, SystemTime, UNIX_EPOCH};
+
+use aws_lc_rs::digest::{digest, SHA256};
+use aws_lc_rs::hmac;
+use aws_lc_rs::rand::{SecureRandom, SystemRandom};
+use tokio::net::UdpSocket;
+use tokio::time::MissedTickBehavior;
+use tracing::{debug, info};
+
+use super::limiter::seed_key_hasher;
+use super::RateLimitKey;
+use crate::config::RateLimitClusterConfig;
+use crate::error::{ProxyError, Result};
+use crate::proxy::reload::SharedRateLimiter;
+use crate::proxy::shutdown::{ServiceHandle, ServiceName, ShutdownWatch};
+use crate::telemetry::metrics::values;
+use crate::telemetry::Metrics;
+
+const MAGIC: [u8; 4] = *b"HRL2";
+/// Magic, node id, sequence, send time, entry count
+const HEADER_LEN: usize = 4 + 8 + 8 + 8 + 2;
+/// Scope, key, requests
+const ENTRY_LEN: usize = 8 + 8 + 4;
+const TAG_LEN: usize = 32;
+/// Stays below common path MTUs, so datagrams are not fragmented
+const MAX_DATAGRAM_LEN: usize = 1200;
+const MAX_ENTRIES: usize = (MAX_DATAGRAM_LEN - HEADER_LEN - TAG_LEN) / ENTRY_LEN;
+/// Datagrams whose send time (by the sender's clock) is further than this from the receiver's
+/// clock, in the past or the future, are dropped
+pub const MAX_AGE_MS: u64 = 2_000;
+/// Sequences below the highest one accepted from a node that are still tracked, and so can
+/// arrive out of order; anything older is dropped as a possible replay
+pub const REPLAY_WINDOW: u64 = u64::BITS as u64;
+/// A node silent for this long is forgotten: any datagram of it still replayable by then is
+/// outside [`MAX_AGE_MS`] (it was sent at most `MAX_AGE_MS` ahead of its receipt).
+const FORGET_AFTER_MS: u64 = 2 * MAX_AGE_MS;
+pub const MIN_SECRET_LEN: usize = 16;
+/// Domain separation between the key-hashing seeds and the HMAC key
+const SEED_CONTEXT: &[u8] = b"huginn rate limit key seeds";
+
+/// Requests a limiter of one node admitted for one key.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub struct Delta {
+    /// Limiter the requests were admitted by (global, a domain, or a route)
+    pub scope: u64,
+    pub key: RateLimitKey,
+    pub count: u32,
+}
+
+/// Why a datagram was not applied.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum DecodeError {
+    /// Sent by this node (it is listed among its own peers)
+    Own,
+    /// Sent more than [`MAX_AGE_MS`] before or after now
+    Stale,
+    /// Sequence already accepted from its node, or older than its last [`REPLAY_WINDOW`]
+    Replayed,
+    /// Malformed, or not authenticated by the cluster secret
+    Invalid,
+}
+
+/// Wire format of the cluster sync datagrams.
+pub struct ClusterCodec {
+    node_id: u64,
+    key: hmac::Key,
+    /// Sequence of the last datagram encoded
+    sequence: AtomicU64,
+    /// Per peer node id: replay window and when it last moved (receiver's clock)
+    last_seen: Mutex<HashMap<u64, LastSeen>>,
+}
+
+#[derive(Debug, Clone, Copy)]
+struct LastSeen {
+    /// Highest sequence accepted
+    sequence: u64,
+    /// Bit `i` set: `sequence - i` was accepted
+    window: u64,
+    at_ms: u64,
+}
+
+impl LastSeen {
+    fn new(sequence: u64, at_ms: u64) -> Self {
+        Self { sequence, window: 1, at_ms }
+    }
+
+    /// Mark `sequence` accepted, or `false` when it already was or is older than the window.
+    fn accept(&mut self, sequence: u64, now_ms: u64) -> bool {
+        if sequence > self.sequence {
+            let advance = u32::try_from(sequence.saturating_sub(self.sequence)).unwrap_or(u32::MAX);
+            self.window = self.window.checked_shl(advance).unwrap_or(0) | 1;
+            self.sequence = sequence;
+        } else {
+            let age = u32::try_from(self.sequence.saturating_sub(sequence)).unwrap_or(u32::MAX);
+            let Some(bit) = 1u64.checked_shl(age) else {
+                return false;
+            };
+            if self.window & bit != 0 {
+                return false;
+            }
+            self.window |= bit;
+        }
+        self.at_ms = now_ms;
+        true
+    }
+}
+
+impl ClusterCodec {
+    pub fn new(secret: &[u8], node_id: u64) -> Self {
+        Self {
+            node_id,
+            key: hmac::Key::new(hmac::HMAC_SHA256, secret),
+            sequence: AtomicU64::new(0),
+            last_seen: Mutex::new(HashMap::new()),
+        }
+    }
+
+    /// Datagrams carrying `deltas`, at most [`MAX_DATAGRAM_LEN`] bytes each, numbered in order.
+    pub fn encode(&self, deltas: &[Delta], now_ms: u64) -> Vec<Vec<u8>> {
+        deltas
+            .chunks(MAX_ENTRIES)
+            .map(|chunk| {
+                let sequence = self
+                    .sequence
+                    .fetch_add(1, Ordering::Relaxed)
+                    .saturating_add(1);
+                let mut datagram = Vec::with_capacity(MAX_DATAGRAM_LEN);
+                datagram.extend_from_slice(&MAGIC);
+                datagram.extend_from_slice(&self.node_id.to_be_bytes());
+                datagram.extend_from_slice(&sequence.to_be_bytes());
+                datagram.extend_from_slice(&now_ms.to_be_bytes());
+                // `MAX_ENTRIES` fits in a u16.
+                let count = u16::try_from(chunk.len()).unwrap_or(u16::MAX);
+                datagram.extend_from_slice(&count.to_be_bytes());
+                for delta in chunk {
+                    datagram.extend_from_slice(&delta.scope.to_be_bytes());
+                    datagram.extend_from_slice(&delta.key.as_u64().to_be_bytes());
+                    datagram.extend_from_slice(&delta.count.to_be_bytes());
+                }
+                let tag = hmac::sign(&self.key, &datagram);
+                datagram.extend_from_slice(tag.as_ref());
+                datagram
+            })
+            .collect()
+    }
+
+    /// Verify a datagram and return its deltas. Only an accepted datagram is recorded in the
+    /// replay window of its node; every check comes before that.
+    pub fn decode(
+        &self,
+        datagram: &[u8],
+        now_ms: u64,
+    ) -> std::result::Result<Vec<Delta>, DecodeError> {
+        let body_len = datagram
+            .len()
+            .checked_sub(TAG_LEN)
+            .ok_or(DecodeError::Invalid)?;
+        let (body, tag) = datagram.split_at(body_len);
+        hmac::verify(&self.key, body, tag).map_err(|_| DecodeError::Invalid)?;
+
+        let (header, entries) = body
+            .split_at_checked(HEADER_LEN)
+            .ok_or(DecodeError::Invalid)?;
+        let (magic, header) = header.split_at(MAGIC.len());
+        if magic != MAGIC {
+            return Err(DecodeError::Invalid);
+        }
+        let (node_id, header) = header.split_at(8);
+        let (sequence, header) = header.split_at(8);
+        let (sent_ms, count) = header.split_at(8);
+        let (node_id, sequence, sent_ms) = (be_u64(node_id), be_u64(sequence), be_u64(sent_ms));
+        if node_id == self.node_id {
+            return Err(DecodeError::Own);
+        }
+        if now_ms.saturating_sub(sent_ms) > MAX_AGE_MS
+            || sent_ms.saturating_sub(now_ms) > MAX_AGE_MS
+        {
+            return Err(DecodeError::Stale);
+        }
+        let count = usize::try_from(be_u64(count)).unwrap_or(usize::MAX);
+        if entries.len() != count.saturating_mul(ENTRY_LEN) {
+            return Err(DecodeError::Invalid);
+        }
+        self.accept_sequence(node_id, sequence, now_ms)?;
+
+        Ok(entries
+            .chunks_exact(ENTRY_LEN)
+            .map(|entry| {
+                let (scope, rest) = entry.split_at(8);
+                let (key, requests) = rest.split_at(8);
+                Delta {
+                    scope: be_u64(scope),
+                    key: RateLimitKey::from_hash(be_u64(key)),
+                    count: u32::try_from(be_u64(requests)).unwrap_or(u32::MAX),
+                }
+            })
+            .collect())
+    }
+}
+
+impl ClusterCodec {
+    /// Record `sequence` in the replay window of `node_id`, unless it was already accepted or is
+    /// older than the window.
+    fn accept_sequence(
+        &self,
+        node_id: u64,
+        sequence: u64,
+        now_ms: u64,
+    ) -> std::result::Result<(), DecodeError> {
+        let mut last_seen = self.last_seen.lock().unwrap_or_else(|e| e.into_inner());
+        match last_seen.get_mut(&node_id) {
+            Some(last) => {
+                if !last.accept(sequence, now_ms) {
+                    return Err(DecodeError::Replayed);
+                }
+            }
+            None => {
+                // New node ids only appear when a peer (re)starts: drop the ones gone silent.
+                last_seen.retain(|_, last| now_ms.saturating_sub(last.at_ms) <= FORGET_AFTER_MS);
+                last_seen.insert(node_id, LastSeen::new(sequence, now_ms));
+            }
+        }
+        Ok(())
+    }
+}
+
+/// Big-endian integer of up to 8 bytes.
+fn be_u64(bytes: &[u8]) -> u64 {
+    bytes
+        .iter()
+        .fold(0u64, |value, &byte| (value << 8) | u64::from(byte))
+}
+
+/// Key-hashing seeds derived from the cluster secret, identical on every node.
+fn key_seeds(secret: &[u8]) -> [u64; 4] {
+    let mut input = Vec::with_capacity(SEED_CONTEXT.len().saturating_add(secret.len()));
+    input.extend_from_slice(SEED_CONTEXT);
+    input.extend_from_slice(secret);
+    let hash = digest(&SHA256, &input);
+    let mut seeds = [0u64; 4];
+    for (seed, bytes) in seeds.iter_mut().zip(hash.as_ref().chunks_exact(8)) {
+        *seed = be_u64(bytes);
+    }
+    seeds
+}
+
+fn unix_ms() -> u64 {
+    SystemTime::now()
+        .duration_since(UNIX_EPOCH)
+        .map_or(0, |elapsed| u64::try_from(elapsed.as_millis()).unwrap_or(u64::MAX))
+}
+
+/// The sync endpoint of one node. See the module docs.
+pub struct ClusterSync {
+    socket: UdpSocket,
+    peers: Vec<SocketAddr>,
+    codec: ClusterCodec,
+    interval: Duration,
+}
+
+impl ClusterSync {
+    /// Seed key hashing from the cluster secret, bind the sync socket and resolve the peers.
+    ///
+    /// Must run before any rate-limit key is hashed (before the first [`super::RateLimitManager`]
+    /// is built), so that every node maps a client to the same key.
+    pub async fn bind(config: &RateLimitClusterConfig) -> Result<Self> {
+        let secret = config.secret.expose().as_bytes();
+        if !seed_key_hasher(key_seeds(secret)) {
+            return Err(ProxyError::Config(
+                "Rate-limit cluster must be set up before any rate-limit key is hashed".to_string(),
+            ));
+        }
+
+        let socket = UdpSocket::bind(config.bind).await.map_err(|e| {
+            ProxyError::Config(format!(
+                "Failed to bind rate-limit cluster socket {}: {e}",
+                config.bind
+            ))
+        })?;
+        let mut peers = Vec::with_capacity(config.peers.len());
+        for peer in &config.peers {
+            let addr = tokio::net::lookup_host(peer.as_str())
+                .await
+                .map_err(|e| {
+                    ProxyError::Config(format!(
+                        "Failed to resolve rate-limit cluster peer '{peer}': {e}"
+                    ))
+                })?
+                .next()
+                .ok_or_else(|| {
+                    ProxyError::Config(format!(
+                        "Rate-limit cluster peer '{peer}' resolved to no address"
+                    ))
+                })?;
+            peers.push(addr);
+        }
+
+        let mut node_id = [0u8; 8];
+        SystemRandom::new().fill(&mut node_id).map_err(|_| {
+            ProxyError::Config("Failed to generate rate-limit cluster node id".to_string())
+        })?;
+
+        Ok(Self {
+            socket,
+            peers,
+            codec: ClusterCodec::new(secret, u64::from_be_bytes(node_id)),
+            interval: Duration::from_millis(config.sync_interval_ms.max(1)),
+        })
+    }
+
+    /// Push local deltas every interval and apply incoming ones until shutdown, then push the
+    /// last batch.
+    pub fn spawn(
+        self,
+        rate_limiter: SharedRateLimiter,
+        metrics: Arc<Metrics>,
+        mut shutdown_rx: ShutdownWatch,
+    ) -> ServiceHandle {
+        info!(
+            bind = ?self.socket.local_addr().ok(),
+            peers = self.peers.len(),
+            sync_interval_ms = self.interval.as_millis(),
+            "Rate-limit cluster sync started"
+        );
+        let handle = tokio::spawn(async move {
+            let mut tick = tokio::time::interval(self.interval);
+            tick.set_missed_tick_behavior(MissedTickBehavior::Delay);
+            // One byte more than a valid datagram, so oversized ones fail to decode.
+            let mut buf = vec![0u8; MAX_DATAGRAM_LEN.saturating_add(1)];
+            let mut deltas = Vec::new();
+            loop {
+                tokio::select! {
+                    biased;
+                    _ = shutdown_rx.wait_for(|v| *v) => {
+                        self.push(&rate_limiter, &mut deltas, &metrics).await;
+                        info!("Rate-limit cluster sync shutting down");
+                        break;
+                    }
+                    _ = tick.tick() => self.push(&rate_limiter, &mut deltas, &metrics).await,
+                    received = self.socket.recv_from(&mut buf) => match received {
+                        Ok((len, _)) => {
+                            self.apply(buf.get(..len).unwrap_or_default(), &rate_limiter, &metrics)
+                        }
+                        Err(e) => debug!(error = %e, "Rate-limit cluster receive failed"),
+                    },
+                }
+            }
+        });
+        ServiceHandle { handle, name: ServiceName::RateLimitCluster }
+    }
+
+    async fn push(
+        &self,
+        rate_limiter: &SharedRateLimiter,
+        deltas: &mut Vec<Delta>,
+        metrics: &Metrics,
+    ) {
+        deltas.clear();
+        if let Some(manager) = &**rate_limiter.load() {
+            manager.drain_deltas(deltas);
+        }
+        if deltas.is_empty() {
+            return;
+        }
+        for datagram in self.codec.encode(deltas, unix_ms()) {
+            for peer in &self.peers {
+                match self.socket.send_to(&datagram, peer).await {
+                    Ok(_) => metrics.record_rate_limit_cluster_datagram(values::CLUSTER_SENT),
+                    Err(e) => {
+                        debug!(%peer, error = %e, "Rate-limit cluster send failed");
+                        metrics.record_rate_limit_cluster_datagram(values::CLUSTER_SEND_FAILED);
+                    }
+                }
+            }
+        }
+    }
+
+    fn apply(&self, datagram: &[u8], rate_limiter: &SharedRateLimiter, metrics: &Metrics) {
+        match self.codec.decode(datagram, unix_ms()) {
+            Ok(deltas) => {
+                metrics.record_rate_limit_cluster_datagram(values::CLUSTER_RECEIVED);
+                if let Some(manager) = &**rate_limiter.load() {
+                    manager.apply_deltas(&deltas);
+                }
+                let requests = deltas
+                    .iter()
+                    .fold(0u64, |sum, delta| sum.saturating_add(u64::from(delta.count)));
+                metrics.record_rate_limit_cluster_debited(requests);
+            }
+            Err(DecodeError::Own) => {}
+            Err(reason) => {
+                debug!(?reason, "Rate-limit cluster datagram rejected");
+                metrics.record_rate_limit_cluster_datagram(values::CLUSTER_REJECTED);
+            }
+        }
+    }
+}
@@ -1,11 +1,14 @@
 //! High-level rate limiter implementation.
 //!
-//! This module provides a convenient wrapper around the low-level Rate tracker
-//! with rate limiting logic and result types.
+//! A GCRA (generic cell rate algorithm) token bucket per key: `requests_per_second` refills the
+//! bucket and `burst` is its depth. Each key's state is a single atomic timestamp, kept in
+//! cache-padded shards so concurrent checks on different keys do not contend.
 
-use pingora_limits::rate::Rate;
-use std::hash::Hash;
-use std::time::Duration;
+use ahash::{AHashMap, RandomState};
+use std::hash::{BuildHasher, Hash};
+use std::sync::atomic::{AtomicU32, AtomicU64, Ordering};
+use std::sync::{Mutex, OnceLock, RwLock};
+use std::time::{Duration, Instant};
 
 /// Result of a rate limit check.
 #[derive(Debug, Clone, PartialEq, Eq)]
@@ -64,7 +67,103 @@ impl RateLimitResult {
     }
 }
 
-/// A rate limiter that enforces request limits over time windows.
+/// Seed of [`RateLimitKey`]: random per process, so clients cannot precompute keys that share a
+/// bucket with someone else's, unless [`seed_key_hasher`] installed a cluster-wide one first.
+static KEY_HASHER: OnceLock<RandomState> = OnceLock::new();
+
+/// Make every node of a cluster hash keys alike. Must run before the first key is hashed;
+/// returns `false` (and changes nothing) otherwise.
+pub(crate) fn seed_key_hasher(seeds: [u64; 4]) -> bool {
+    let [k0, k1, k2, k3] = seeds;
+    KEY_HASHER
+        .set(RandomState::with_seeds(k0, k1, k2, k3))
+        .is_ok()
+}
+
+fn key_hasher() -> &'static RandomState {
+    KEY_HASHER.get_or_init(RandomState::new)
+}
+
+/// Shards per limiter; a power of two, indexed by the top bits of the key.
+const SHARD_BITS: u32 = 6;
+const SHARDS: usize = 1 << SHARD_BITS;
+/// A shard sweeps idle keys once it holds this many, and then whenever it doubles.
+const MIN_SWEEP_LEN: usize = 1024;
+const NANOS_PER_SEC: u64 = 1_000_000_000;
+
+/// A pre-hashed rate limiting key.
+///
+/// Hash the request's key once and check it against every limiter that applies; the check
+/// itself never allocates.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub struct RateLimitKey(u64);
+
+impl RateLimitKey {
+    /// Key for any hashable value (IP, header value, route, ...).
+    pub fn of<T: Hash + ?Sized>(key: &T) -> Self {
+        Self(key_hasher().hash_one(key))
+    }
+
+    /// Key built by feeding a hasher from [`RateLimitKey::hasher`].
+    pub fn from_hash(hash: u64) -> Self {
+        Self(hash)
+    }
+
+    /// Hasher seeded like [`RateLimitKey::of`], for keys hashed piecewise.
+    pub fn hasher() -> ahash::AHasher {
+        key_hasher().build_hasher()
+    }
+
+    pub fn as_u64(self) -> u64 {
+        self.0
+    }
+
+    /// Top bits, so shards stay independent of the bits each shard's map hashes on.
+    fn shard(self) -> usize {
+        usize::try_from(self.0 >> (u64::BITS - SHARD_BITS)).unwrap_or(0)
+    }
+}
+
+/// State of one key.
+struct Bucket {
+    /// Theoretical arrival time (TAT) of the key's next request, in nanoseconds since the
+    /// limiter was created
+    tat: AtomicU64,
+    /// Requests admitted since the last [`RateLimiter::drain_deltas`] (delta tracking only)
+    pending: AtomicU32,
+}
+
+impl Bucket {
+    fn new() -> Self {
+        // A TAT in the past is a full bucket.
+        Self { tat: AtomicU64::new(0), pending: AtomicU32::new(0) }
+    }
+}
+
+#[derive(Default)]
+struct Buckets {
+    map: AHashMap<u64, Bucket>,
+    sweep_at: usize,
+}
+
+/// Aligned to its own cache lines so neighbouring shard locks do not false-share.
+#[repr(align(128))]
+#[derive(Default)]
+struct Shard {
+    buckets: RwLock<Buckets>,
+    /// Keys whose `pending` went from zero since the last drain
+    dirty: Mutex<Vec<u64>>,
+}
+
+/// A token-bucket rate limiter (GCRA) keyed by client.
+///
+/// A key may send `burst` requests at once and then `requests_per_second` sustained. Memory is
+/// bounded by the keys active in the last `burst / requests_per_second` seconds: a key whose
+/// bucket has refilled carries no state, and each shard drops such keys as it grows.
+///
+/// Built [`with_delta_tracking`](Self::with_delta_tracking), it also counts the requests it
+/// admits per key for [`drain_deltas`](Self::drain_deltas), and takes requests admitted
+/// elsewhere through [`debit`](Self::debit); see [`super::cluster`].
 ///
 /// # Example
 /// ```
@@ -83,7 +182,14 @@ impl RateLimitResult {
 /// }
 /// ```
 pub struct RateLimiter {
-    rate_tracker: Rate,
+    shards: Box<[Shard]>,
+    epoch: Instant,
+    /// Nanoseconds between two requests at the sustained rate
+    interval: u64,
+    /// How far ahead of now a key's TAT may run: `burst * interval`
+    tolerance: u64,
+    track_deltas: bool,
+    requests_per_second: u32,
     max_requests: isize,
     window: Duration,
 }
@@ -92,9 +198,11 @@ impl RateLimiter {
     /// Create a new rate limiter.
     ///
     /// # Parameters
-    /// - `requests_per_second`: Base rate limit (used for rate calculation)
-    /// - `burst`: Maximum number of requests allowed in a burst
-    /// - `window`: Time window for rate limiting
+    /// - `requests_per_second`: Sustained rate each key's bucket refills at (`0` is treated
+    ///   as `1`)
+    /// - `burst`: Bucket depth, the requests a key may send at once
+    /// - `window`: The configured `window_seconds`; the bucket needs no window, it is kept
+    ///   for reporting only
     ///
     /// # Example
     /// ```
@@ -104,8 +212,27 @@ impl RateLimiter {
     /// // Allow 100 requests per second with burst of 200
     /// let limiter = RateLimiter::new(100, 200, Duration::from_secs(1));
     /// ```
-    pub fn new(_requests_per_second: u32, burst: u32, window: Duration) -> Self {
-        Self { rate_tracker: Rate::new(window), max_requests: burst as isize, window }
+    pub fn new(requests_per_second: u32, burst: u32, window: Duration) -> Self {
+        let interval = NANOS_PER_SEC
+            .checked_div(u64::from(requests_per_second.max(1)))
+            .unwrap_or(NANOS_PER_SEC);
+        Self {
+            shards: (0..SHARDS).map(|_| Shard::default()).collect(),
+            epoch: Instant::now(),
+            interval,
+            tolerance: interval.saturating_mul(u64::from(burst)),
+            track_deltas: false,
+            requests_per_second,
+            max_requests: isize::try_from(burst).unwrap_or(isize::MAX),
+            window,
+        }
+    }
+
+    /// Count admitted requests per key for [`RateLimiter::drain_deltas`]. Keys with undrained
+    /// requests are not evicted, so something must drain them.
+    pub fn with_delta_tracking(mut self) -> Self {
+        self.track_deltas = true;
+        self
     }
 
     /// Check if a request should be allowed or rate limited.
@@ -119,20 +246,26 @@ impl RateLimiter {
     /// # Returns
     /// `RateLimitResult` indicating whether the request is allowed or limited
     pub fn check<T: Hash + ?Sized>(&self, key: &T) -> RateLimitResult {
-        let current = self.rate_tracker.observe(&key, 1);
+        self.check_key(RateLimitKey::of(key))
+    }
 
-        if current > self.max_requests {
-            RateLimitResult::Limited {
-                limit: self.max_requests,
-                remaining: 0,
-                reset_after: self.window,
-            }
-        } else {
-            RateLimitResult::Allowed {
-                limit: self.max_requests,
-                remaining: self.max_requests.saturating_sub(current),
+    /// [`RateLimiter::check`] for a pre-hashed key.
+    pub fn check_key(&self, key: RateLimitKey) -> RateLimitResult {
+        let now = self.now();
+        self.with_bucket(key, now, |bucket| {
+            let result = self.acquire(&bucket.tat, now);
+            if self.track_deltas
+                && result.is_allowed()
+                && bucket.pending.fetch_add(1, Ordering::Relaxed) == 0
+            {
+                self.shard(key)
+                    .dirty
+                    .lock()
+                    .unwrap_or_else(|e| e.into_inner())
+                    .push(key.0);
             }
-        }
+            result
+        })
     }
 
     /// Check rate limit without recording the request.
@@ -146,27 +279,90 @@ impl RateLimiter {
     /// # Returns
     /// `RateLimitResult` indicating whether a request would be allowed
     pub fn check_only<T: Hash + ?Sized>(&self, key: &T) -> RateLimitResult {
-        let current = self.rate_tracker.observe(&key, 0); // Observe with 0 to not increment
+        self.check_key_only(RateLimitKey::of(key))
+    }
 
-        if current >= self.max_requests {
-            RateLimitResult::Limited {
-                limit: self.max_requests,
-                remaining: 0,
-                reset_after: self.window,
+    /// [`RateLimiter::check_only`] for a pre-hashed key.
+    pub fn check_key_only(&self, key: RateLimitKey) -> RateLimitResult {
+        let now = self.now();
+        let tat = self
+            .shard(key)
+            .buckets
+            .read()
+            .unwrap_or_else(|e| e.into_inner())
+            .map
+            .get(&key.0)
+            .map_or(0, |bucket| bucket.tat.load(Ordering::Acquire));
+        self.decide(tat, now)
+    }
+
+    /// Take `count` requests admitted elsewhere (another node) from `key`'s bucket. Unlike a
+    /// check this never fails: the bucket may run into debt, which then limits local requests
+    /// until it refills.
+    pub fn debit(&self, key: RateLimitKey, count: u32) {
+        let now = self.now();
+        let cost = self.interval.saturating_mul(u64::from(count));
+        self.with_bucket(key, now, |bucket| {
+            let _ = bucket
+                .tat
+                .fetch_update(Ordering::AcqRel, Ordering::Acquire, |tat| {
+                    Some(tat.max(now).saturating_add(cost))
+                });
+        });
+    }
+
+    /// Move the requests admitted since the last drain into `out` as `(key, count)` pairs.
+    /// Always empty without [`RateLimiter::with_delta_tracking`].
+    pub fn drain_deltas(&self, out: &mut Vec<(RateLimitKey, u32)>) {
+        if !self.track_deltas {
+            return;
+        }
+        for shard in self.shards.iter() {
+            let keys = std::mem::take(&mut *shard.dirty.lock().unwrap_or_else(|e| e.into_inner()));
+            if keys.is_empty() {
+                continue;
             }
-        } else {
-            RateLimitResult::Allowed {
-                limit: self.max_requests,
-                remaining: self.max_requests.saturating_sub(current),
+            let buckets = shard.buckets.read().unwrap_or_else(|e| e.into_inner());
+            for key in keys {
+                let count = buckets
+                    .map
+                    .get(&key)
+                    .map_or(0, |bucket| bucket.pending.swap(0, Ordering::Relaxed));
+                if count != 0 {
+                    out.push((RateLimitKey(key), count));
+                }
             }
         }
     }
 
-    /// Get the current rate for a key (requests per second).
+    /// Drop every key whose bucket has refilled, returning how many keys remain tracked.
     ///
-    /// This returns the rate from the previous completed window.
-    pub fn current_rate<T: Hash + ?Sized>(&self, key: &T) -> f64 {
-        self.rate_tracker.rate(&key)
+    /// Shards already do this as they grow; this sweeps all of them, e.g. from a periodic task.
+    pub fn evict_idle(&self) -> usize {
+        let now = self.now();
+        self.shards
+            .iter()
+            .map(|shard| {
+                let mut buckets = shard.buckets.write().unwrap_or_else(|e| e.into_inner());
+                sweep(&mut buckets, now);
+                buckets.map.len()
+            })
+            .sum()
+    }
+
+    /// Number of keys currently holding state.
+    pub fn tracked_keys(&self) -> usize {
+        self.shards
+            .iter()
+            .map(|shard| {
+                shard
+                    .buckets
+                    .read()
+                    .unwrap_or_else(|e| e.into_inner())
+                    .map
+                    .len()
+            })
+            .sum()
     }
 
     /// Get the configured maximum requests (burst limit).
@@ -174,8 +370,94 @@ impl RateLimiter {
         self.max_requests
     }
 
+    /// Get the configured sustained rate.
+    pub fn requests_per_second(&self) -> u32 {
+        self.requests_per_second
+    }
+
     /// Get the configured window duration.
     pub fn window(&self) -> Duration {
         self.window
     }
+
+    fn shard(&self, key: RateLimitKey) -> &Shard {
+        &self.shards[key.shard()]
+    }
+
+    fn now(&self) -> u64 {
+        u64::try_from(self.epoch.elapsed().as_nanos()).unwrap_or(u64::MAX)
+    }
+
+    /// Run `f` on `key`'s bucket, creating it when missing. Known keys only take the shard's
+    /// read lock.
+    fn with_bucket<R>(&self, key: RateLimitKey, now: u64, f: impl FnOnce(&Bucket) -> R) -> R {
+        let shard = self.shard(key);
+        {
+            let buckets = shard.buckets.read().unwrap_or_else(|e| e.into_inner());
+            if let Some(bucket) = buckets.map.get(&key.0) {
+                return f(bucket);
+            }
+        }
+
+        let mut buckets = shard.buckets.write().unwrap_or_else(|e| e.into_inner());
+        if buckets.map.len() >= buckets.sweep_at {
+            sweep(&mut buckets, now);
+        }
+        // A new key starts with a full bucket; so does one evicted in between.
+        f(buckets.map.entry(key.0).or_insert_with(Bucket::new))
+    }
+
+    /// Take one request from the bucket whose TAT is `tat`, if it has room.
+    fn acquire(&self, tat: &AtomicU64, now: u64) -> RateLimitResult {
+        let mut current = tat.load(Ordering::Acquire);
+        loop {
+            let result = self.decide(current, now);
+            if result.is_limited() {
+                return result;
+            }
+            let next = current.max(now).saturating_add(self.interval);
+            match tat.compare_exchange_weak(current, next, Ordering::AcqRel, Ordering::Acquire) {
+                Ok(_) => return result,
+                Err(actual) => current = actual,
+            }
+        }
+    }
+
+    /// Outcome of one more request for a key whose TAT is `tat`.
+    fn decide(&self, tat: u64, now: u64) -> RateLimitResult {
+        let ahead = tat
+            .max(now)
+            .saturating_add(self.interval)
+            .saturating_sub(now);
+        if ahead > self.tolerance {
+            // `X-RateLimit-Reset` has whole-second resolution; round up so a client honouring it
+            // does not come back early.
+            let wait = ahead.saturating_sub(self.tolerance);
+            let secs = wait.div_ceil(NANOS_PER_SEC);
+            RateLimitResult::Limited {
+                limit: self.max_requests,
+                remaining: 0,
+                reset_after: Duration::from_secs(secs),
+            }
+        } else {
+            let remaining = self
+                .tolerance
+                .saturating_sub(ahead)
+                .checked_div(self.interval)
+                .unwrap_or(0);
+            RateLimitResult::Allowed {
+                limit: self.max_requests,
+                remaining: isize::try_from(remaining).unwrap_or(isize::MAX),
+            }
+        }
+    }
+}
+
+/// Drop the keys whose bucket is full again (TAT not after `now`): they behave exactly like
+/// keys never seen. Keys with undrained deltas stay until they are drained.
+fn sweep(buckets: &mut Buckets, now: u64) {
+    buckets.map.retain(|_, bucket| {
+        bucket.tat.load(Ordering::Relaxed) > now || bucket.pending.load(Ordering::Relaxed) != 0
+    });
+    buckets.sweep_at = buckets.map.len().saturating_mul(2).max(MIN_SWEEP_LEN);
 }
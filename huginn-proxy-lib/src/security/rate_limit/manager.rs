@@ -1,19 +1,110 @@
-use super::{RateLimitResult, RateLimiter};
+use super::{Delta, RateLimitKey, RateLimitResult, RateLimiter};
 use crate::config::{Domain, LimitBy, RateLimitConfig, TrustedProxiesConfig};
 use ahash::AHashMap;
+use std::fmt::{self, Write as _};
+use std::hash::Hasher;
 use std::net::IpAddr;
+use std::sync::Arc;
 use std::time::Duration;
 
 /// Build the limiter for a fully-resolved config (`None` when disabled).
-fn build_limiter(config: &RateLimitConfig) -> Option<RateLimiter> {
+fn build_limiter(config: &RateLimitConfig, clustered: bool) -> Option<Arc<RateLimiter>> {
     if config.enabled {
         let window = Duration::from_secs(config.window_seconds);
-        Some(RateLimiter::new(config.requests_per_second, config.burst, window))
+        let limiter = RateLimiter::new(config.requests_per_second, config.burst, window);
+        Some(Arc::new(if clustered {
+            limiter.with_delta_tracking()
+        } else {
+            limiter
+        }))
     } else {
         None
     }
 }
 
+/// How many limiters a [`RateLimitManager::rebuild`] carried over from the previous manager
+/// (counters intact) and how many it built from scratch.
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct LimiterReuse {
+    pub reused: usize,
+    pub rebuilt: usize,
+}
+
+/// Builds the limiters of one manager, taking over the previous manager's limiter of a scope
+/// whose config did not change.
+struct LimiterBuilder<'a> {
+    clustered: bool,
+    previous: Option<&'a RateLimitManager>,
+    scopes: AHashMap<u64, ScopeEntry>,
+    reuse: LimiterReuse,
+}
+
+impl LimiterBuilder<'_> {
+    fn limiter(&mut self, scope: Scope, config: &RateLimitConfig) -> Option<Arc<RateLimiter>> {
+        if !config.enabled {
+            return None;
+        }
+        let id = scope.id();
+        let reusable = self
+            .previous
+            .and_then(|previous| match previous.scopes.get(&id) {
+                Some(entry) if entry.scope == scope && entry.config == *config => {
+                    previous.limiter(&scope).map(Arc::clone)
+                }
+                _ => None,
+            });
+        let limiter = match reusable {
+            Some(limiter) => {
+                self.reuse.reused = self.reuse.reused.saturating_add(1);
+                limiter
+            }
+            None => {
+                self.reuse.rebuilt = self.reuse.rebuilt.saturating_add(1);
+                build_limiter(config, self.clustered)?
+            }
+        };
+        self.scopes
+            .insert(id, ScopeEntry { scope, config: config.clone() });
+        Some(limiter)
+    }
+}
+
+/// Where a limiter sits in the manager.
+#[derive(PartialEq, Eq)]
+enum Scope {
+    Global,
+    Domain(String),
+    Route(String, String),
+}
+
+impl Scope {
+    /// Identifies the limiter to other nodes. Derived from the domain label and route prefix,
+    /// so nodes running the same config agree on it.
+    fn id(&self) -> u64 {
+        let mut hasher = RateLimitKey::hasher();
+        match self {
+            Scope::Global => hasher.write_u8(0),
+            Scope::Domain(label) => {
+                hasher.write_u8(1);
+                hasher.write(label.as_bytes());
+            }
+            Scope::Route(label, prefix) => {
+                hasher.write_u8(2);
+                hasher.write(label.as_bytes());
+                hasher.write_u8(0xff);
+                hasher.write(prefix.as_bytes());
+            }
+        }
+        hasher.finish()
+    }
+}
+
+/// An enabled limiter's scope and the config it was built from.
+struct ScopeEntry {
+    scope: Scope,
+    config: RateLimitConfig,
+}
+
 /// Manager for rate limiters (global, per-domain, and per-route).
 ///
 /// This struct holds rate limiters for:
@@ -23,18 +114,23 @@ fn build_limiter(config: &RateLimitConfig) -> Option<RateLimiter> {
 ///
 /// Limiters are keyed by domain label so the same route prefix under two different
 /// domains stays isolated. The manager is immutable after construction. Hot reload
-/// swaps the entire manager atomically via `proxy::reload::SharedRateLimiter`.
+/// swaps the entire manager atomically via `proxy::reload::SharedRateLimiter`, after a
+/// [`RateLimitManager::rebuild`] that keeps the limiters (and counters) of unchanged scopes.
 pub struct RateLimitManager {
     /// Global rate limiter (optional)
-    global: Option<RateLimiter>,
+    global: Option<Arc<RateLimiter>>,
     /// Per-domain limiters keyed by domain label. Present only when the domain overrides
     /// rate limiting: `Some` = enabled limiter, `None` = explicitly disabled (does NOT fall
     /// through to the global limiter). Domains without an override are absent from the map.
-    domain_limiters: AHashMap<String, Option<RateLimiter>>,
+    domain_limiters: AHashMap<String, Option<Arc<RateLimiter>>>,
     /// Per-route limiters: domain label -> route prefix -> slot. Present only when the route
     /// overrides rate limiting: `Some` = enabled limiter, `None` = explicitly disabled (does NOT
     /// fall through to the domain/global limiter). Routes without an override are absent from the map.
-    route_limiters: AHashMap<String, AHashMap<String, Option<RateLimiter>>>,
+    route_limiters: AHashMap<String, AHashMap<String, Option<Arc<RateLimiter>>>>,
+    /// Every enabled limiter by [`Scope::id`], for exchanging deltas with other nodes and for
+    /// matching limiters across a [`RateLimitManager::rebuild`]
+    scopes: AHashMap<u64, ScopeEntry>,
+    clustered: bool,
 }
 
 impl RateLimitManager {
@@ -45,10 +141,42 @@ impl RateLimitManager {
     /// Each present override is recorded as an explicit slot (enabled limiter or explicit
     /// disable) so it never silently inherits the level it replaced.
     pub fn new(global_config: &RateLimitConfig, domains: &[Domain]) -> Self {
-        let global = build_limiter(global_config);
+        Self::build(global_config, domains, false, None).0
+    }
+
+    /// [`RateLimitManager::new`] for a node of a rate-limit cluster: limiters count the
+    /// requests they admit for [`RateLimitManager::drain_deltas`].
+    pub fn clustered(global_config: &RateLimitConfig, domains: &[Domain]) -> Self {
+        Self::build(global_config, domains, true, None).0
+    }
+
+    /// Build the manager for a reloaded config. A scope (global, domain label, or domain label
+    /// plus route prefix) whose config is unchanged shares this manager's limiter, so its
+    /// clients keep their counters; only added or changed scopes start from a full bucket.
+    pub fn rebuild(
+        &self,
+        global_config: &RateLimitConfig,
+        domains: &[Domain],
+    ) -> (Self, LimiterReuse) {
+        Self::build(global_config, domains, self.clustered, Some(self))
+    }
+
+    fn build(
+        global_config: &RateLimitConfig,
+        domains: &[Domain],
+        clustered: bool,
+        previous: Option<&Self>,
+    ) -> (Self, LimiterReuse) {
+        let mut builder = LimiterBuilder {
+            clustered,
+            previous,
+            scopes: AHashMap::new(),
+            reuse: LimiterReuse::default(),
+        };
+        let global = builder.limiter(Scope::Global, global_config);
 
         let mut domain_limiters = AHashMap::new();
-        let mut route_limiters: AHashMap<String, AHashMap<String, Option<RateLimiter>>> =
+        let mut route_limiters: AHashMap<String, AHashMap<String, Option<Arc<RateLimiter>>>> =
             AHashMap::new();
 
         for domain in domains {
@@ -58,20 +186,25 @@ impl RateLimitManager {
             // Record an explicit domain slot only when the domain overrides rate limiting, so a
             // disabled override (`enabled = false`) does not fall through to the global limiter.
             if let Some(cfg) = domain_override {
-                domain_limiters.insert(label.clone(), build_limiter(cfg));
+                let limiter = builder.limiter(Scope::Domain(label.clone()), cfg);
+                domain_limiters.insert(label.clone(), limiter);
             }
 
             for route in &domain.routes {
                 if let Some(cfg) = route.security.as_ref().and_then(|s| s.rate_limit.as_ref()) {
+                    let scope = Scope::Route(label.clone(), route.prefix.clone());
+                    let limiter = builder.limiter(scope, cfg);
                     route_limiters
                         .entry(label.clone())
                         .or_default()
-                        .insert(route.prefix.clone(), build_limiter(cfg));
+                        .insert(route.prefix.clone(), limiter);
                 }
             }
         }
 
-        Self { global, domain_limiters, route_limiters }
+        let manager =
+            Self { global, domain_limiters, route_limiters, scopes: builder.scopes, clustered };
+        (manager, builder.reuse)
     }
 
     /// Check if a request is allowed (not rate limited)
@@ -92,6 +225,16 @@ impl RateLimitManager {
         key: &str,
         domain_label: &str,
         route_prefix: Option<&str>,
+    ) -> RateLimitResult {
+        self.check_key(RateLimitKey::of(key), domain_label, route_prefix)
+    }
+
+    /// [`RateLimitManager::check`] for a pre-hashed key (see [`rate_limit_key`]).
+    pub fn check_key(
+        &self,
+        key: RateLimitKey,
+        domain_label: &str,
+        route_prefix: Option<&str>,
     ) -> RateLimitResult {
         // A route-level override is authoritative: an enabled limiter is checked, an explicit
         // disable allows the request, and neither falls through to the domain/global limiter.
@@ -99,7 +242,7 @@ impl RateLimitManager {
             if let Some(by_prefix) = self.route_limiters.get(domain_label) {
                 if let Some(slot) = by_prefix.get(prefix) {
                     return match slot {
-                        Some(limiter) => limiter.check(key),
+                        Some(limiter) => limiter.check_key(key),
                         None => {
                             RateLimitResult::Allowed { remaining: isize::MAX, limit: isize::MAX }
                         }
@@ -112,17 +255,60 @@ impl RateLimitManager {
         // disable allows the request, and neither falls through to the global limiter.
         if let Some(slot) = self.domain_limiters.get(domain_label) {
             return match slot {
-                Some(limiter) => limiter.check(key),
+                Some(limiter) => limiter.check_key(key),
                 None => RateLimitResult::Allowed { remaining: isize::MAX, limit: isize::MAX },
             };
         }
 
         match &self.global {
-            Some(global_limiter) => global_limiter.check(key),
+            Some(global_limiter) => global_limiter.check_key(key),
             None => RateLimitResult::Allowed { remaining: isize::MAX, limit: isize::MAX },
         }
     }
 
+    /// Move the requests every limiter admitted since the last drain into `out`. Empty unless
+    /// the manager was built [`clustered`](RateLimitManager::clustered).
+    pub fn drain_deltas(&self, out: &mut Vec<Delta>) {
+        let mut admitted = Vec::new();
+        for (&scope, entry) in &self.scopes {
+            if let Some(limiter) = self.limiter(&entry.scope) {
+                limiter.drain_deltas(&mut admitted);
+                out.extend(
+                    admitted
+                        .drain(..)
+                        .map(|(key, count)| Delta { scope, key, count }),
+                );
+            }
+        }
+    }
+
+    /// Debit requests admitted by other nodes. Deltas for limiters this node does not have
+    /// (a peer running a different config) are ignored.
+    pub fn apply_deltas(&self, deltas: &[Delta]) {
+        for delta in deltas {
+            if let Some(limiter) = self
+                .scopes
+                .get(&delta.scope)
+                .and_then(|entry| self.limiter(&entry.scope))
+            {
+                limiter.debit(delta.key, delta.count);
+            }
+        }
+    }
+
+    fn limiter(&self, scope: &Scope) -> Option<&Arc<RateLimiter>> {
+        match scope {
+            Scope::Global => self.global.as_ref(),
+            Scope::Domain(label) => self.domain_limiters.get(label)?.as_ref(),
+            Scope::Route(label, prefix) => self.route_limiters.get(label)?.get(prefix)?.as_ref(),
+        }
+    }
+
+    /// Number of enabled limiters.
+    pub fn limiter_count(&self) -> usize {
+        self.scopes.len()
+    }
+
     pub fn is_enabled(&self) -> bool {
         self.global.is_some()
             || self.domain_limiters.values().any(Option::is_some)
@@ -145,23 +331,131 @@ fn resolve_client_ip(
     peer: std::net::SocketAddr,
     headers: &http::HeaderMap,
     trusted_proxies: &TrustedProxiesConfig,
-) -> String {
+) -> IpAddr {
     let peer_ip = peer.ip();
     if !trusted_proxies.trusts(&peer_ip) {
-        return peer_ip.to_string();
+        return peer_ip;
     }
     if let Some(xff) = headers.get("x-forwarded-for") {
         if let Ok(xff_str) = xff.to_str() {
             for raw in xff_str.rsplit(',') {
                 if let Ok(ip) = raw.trim().parse::<IpAddr>() {
                     if !trusted_proxies.trusts(&ip) {
-                        return ip.to_string();
+                        return ip;
                     }
                 }
             }
         }
     }
-    peer_ip.to_string()
+    peer_ip
+}
+
+/// What a request is limited by, borrowed from the request.
+enum KeyMaterial<'a> {
+    Ip(IpAddr),
+    Header(&'a str),
+    Route(&'a str),
+    IpRoute(IpAddr, &'a str),
+    Ja4(&'a dyn fmt::Display),
+    Ja4Ip(&'a dyn fmt::Display, IpAddr),
+}
+
+impl<'a> KeyMaterial<'a> {
+    fn extract(
+        limit_by: LimitBy,
+        peer: std::net::SocketAddr,
+        route_prefix: &'a str,
+        header_name: Option<&str>,
+        headers: &'a http::HeaderMap,
+        trusted_proxies: &TrustedProxiesConfig,
+        ja4: Option<&'a dyn fmt::Display>,
+    ) -> Self {
+        match (limit_by, ja4) {
+            (LimitBy::Ip, _) => Self::Ip(resolve_client_ip(peer, headers, trusted_proxies)),
+            (LimitBy::Header, _) => header_name
+                .and_then(|name| headers.get(name))
+                .and_then(|value| value.to_str().ok())
+                .map_or(Self::Ip(peer.ip()), Self::Header),
+            (LimitBy::Route, _) => Self::Route(route_prefix),
+            (LimitBy::Combined, _) => {
+                Self::IpRoute(resolve_client_ip(peer, headers, trusted_proxies), route_prefix)
+            }
+            (LimitBy::Ja4, Some(ja4)) => Self::Ja4(ja4),
+            (LimitBy::Ja4Ip, Some(ja4)) => {
+                Self::Ja4Ip(ja4, resolve_client_ip(peer, headers, trusted_proxies))
+            }
+            // Connections without a fingerprint (plain HTTP) are limited by client IP.
+            (LimitBy::Ja4 | LimitBy::Ja4Ip, None) => {
+                Self::Ip(resolve_client_ip(peer, headers, trusted_proxies))
+            }
+        }
+    }
+
+    /// Hash the material in place. Each kind is tagged so that, say, a header value spelling an
+    /// IP does not share that IP's bucket.
+    fn key(&self) -> RateLimitKey {
+        let mut hasher = RateLimitKey::hasher();
+        match self {
+            Self::Ip(ip) => {
+                hasher.write_u8(0);
+                write_ip(&mut hasher, *ip);
+            }
+            Self::Header(value) => {
+                hasher.write_u8(1);
+                hasher.write(value.as_bytes());
+            }
+            Self::Route(route) => {
+                hasher.write_u8(2);
+                hasher.write(route.as_bytes());
+            }
+            Self::IpRoute(ip, route) => {
+                hasher.write_u8(3);
+                write_ip(&mut hasher, *ip);
+                hasher.write(route.as_bytes());
+            }
+            Self::Ja4(ja4) => {
+                hasher.write_u8(4);
+                // `HashWriter::write_str` never fails.
+                let _ = write!(HashWriter(&mut hasher), "{ja4}");
+            }
+            Self::Ja4Ip(ja4, ip) => {
+                hasher.write_u8(5);
+                write_ip(&mut hasher, *ip);
+                let _ = write!(HashWriter(&mut hasher), "{ja4}");
+            }
+        }
+        RateLimitKey::from_hash(hasher.finish())
+    }
+}
+
+impl fmt::Display for KeyMaterial<'_> {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        match self {
+            Self::Ip(ip) => write!(f, "{ip}"),
+            Self::Header(value) => f.write_str(value),
+            Self::Route(route) => f.write_str(route),
+            Self::IpRoute(ip, route) => write!(f, "{ip}:{route}"),
+            Self::Ja4(ja4) => write!(f, "{ja4}"),
+            Self::Ja4Ip(ja4, ip) => write!(f, "{ja4}:{ip}"),
+        }
+    }
+}
+
+fn write_ip(hasher: &mut impl Hasher, ip: IpAddr) {
+    match ip {
+        IpAddr::V4(ip) => hasher.write(&ip.octets()),
+        IpAddr::V6(ip) => hasher.write(&ip.octets()),
+    }
+}
+
+/// Feeds `Display` output straight into a hasher, without building the string.
+struct HashWriter<'a, H>(&'a mut H);
+
+impl<H: Hasher> fmt::Write for HashWriter<'_, H> {
+    fn write_str(&mut self, s: &str) -> fmt::Result {
+        self.0.write(s.as_bytes());
+        Ok(())
+    }
 }
 
 /// Extract rate limiting key from request context.
@@ -173,9 +467,12 @@ fn resolve_client_ip(
 /// * `header_name` - Custom header name (for `LimitBy::Header`)
 /// * `headers` - HTTP request headers
 /// * `trusted_proxies` - CIDRs whose XFF additions are trusted (see `resolve_client_ip`)
+/// * `ja4` - Connection JA4 (for `LimitBy::Ja4` / `LimitBy::Ja4Ip`); without one those
+///   strategies key by client IP
 ///
 /// # Returns
-/// Rate limiting key as a string
+/// Rate limiting key as a string. The request path uses [`rate_limit_key`], which hashes the
+/// same key without building it.
 pub fn extract_rate_limit_key(
     limit_by: LimitBy,
     peer: std::net::SocketAddr,
@@ -183,23 +480,24 @@ pub fn extract_rate_limit_key(
     header_name: Option<&str>,
     headers: &http::HeaderMap,
     trusted_proxies: &TrustedProxiesConfig,
+    ja4: Option<&dyn fmt::Display>,
 ) -> String {
-    match limit_by {
-        LimitBy::Ip => resolve_client_ip(peer, headers, trusted_proxies),
-        LimitBy::Header => {
-            if let Some(name) = header_name {
-                if let Some(value) = headers.get(name) {
-                    if let Ok(value_str) = value.to_str() {
-                        return value_str.to_string();
-                    }
-                }
-            }
-            peer.ip().to_string()
-        }
-        LimitBy::Route => route_prefix.to_string(),
-        LimitBy::Combined => {
-            let ip_str = resolve_client_ip(peer, headers, trusted_proxies);
-            format!("{ip_str}:{route_prefix}")
-        }
-    }
+    KeyMaterial::extract(limit_by, peer, route_prefix, header_name, headers, trusted_proxies, ja4)
+        .to_string()
+}
+
+/// Hashed rate limiting key for a request; the arguments are those of
+/// [`extract_rate_limit_key`]. Nothing is allocated: the IP, header value, route, or JA4 is
+/// hashed where it lies.
+pub fn rate_limit_key(
+    limit_by: LimitBy,
+    peer: std::net::SocketAddr,
+    route_prefix: &str,
+    header_name: Option<&str>,
+    headers: &http::HeaderMap,
+    trusted_proxies: &TrustedProxiesConfig,
+    ja4: Option<&dyn fmt::Display>,
+) -> RateLimitKey {
+    KeyMaterial::extract(limit_by, peer, route_prefix, header_name, headers, trusted_proxies, ja4)
+        .key()
 }
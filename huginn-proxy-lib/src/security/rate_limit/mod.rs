@@ -1,14 +1,16 @@
 //! Rate limiting implementation for Huginn Proxy.
 //!
-//! The low-level Count-Min Sketch ([`Estimator`]) and the dual-buffer sliding
-//! window ([`Rate`]) come from Cloudflare's [`pingora_limits`] crate. This
-//! module provides a thin, opinionated wrapper:
-//!
-//! - [`RateLimiter`] (`limiter.rs`): high-level limiter that combines a
-//!   [`Rate`] tracker with limit enforcement and the result type
-//!   [`RateLimitResult`].
+//! - [`RateLimiter`] (`limiter.rs`): per-key GCRA token bucket (`requests_per_second`
+//!   refill, `burst` depth) over sharded atomic state, checked with a pre-hashed
+//!   [`RateLimitKey`], plus the result type [`RateLimitResult`].
 //! - [`RateLimitManager`] (`manager.rs`): registry of global and per-route
-//!   limiters plus key extraction (IP, header, route, combined).
+//!   limiters plus key extraction (IP, header, route, combined, JA4, JA4 + IP).
+//! - [`ClusterSync`] (`cluster.rs`): cluster-wide limits. Nodes admit locally and push the
+//!   requests they admitted per key to their peers every few milliseconds as [`Delta`]s.
+//!
+//! The Count-Min Sketch ([`Estimator`]) and the dual-buffer sliding window
+//! ([`Rate`]) from Cloudflare's [`pingora_limits`] crate are re-exported for
+//! callers that want an approximate counter.
 //!
 //! # Example Usage
 //!
@@ -46,11 +48,15 @@
 //! rate_limit = { requests_per_second = 50, burst = 100 }
 //! ```
 
+mod cluster;
 mod limiter;
 mod manager;
 
-pub use limiter::{RateLimitResult, RateLimiter};
-pub use manager::{extract_rate_limit_key, RateLimitManager};
+pub use cluster::{
+    ClusterCodec, ClusterSync, DecodeError, Delta, MAX_AGE_MS, MIN_SECRET_LEN, REPLAY_WINDOW,
+};
+pub use limiter::{RateLimitKey, RateLimitResult, RateLimiter};
+pub use manager::{extract_rate_limit_key, rate_limit_key, LimiterReuse, RateLimitManager};
 
 pub use pingora_limits::estimator::Estimator;
 pub use pingora_limits::rate::Rate;
@@ -0,0 +1,99 @@
+//! Metric attributes of the request path, interned ahead of time.
+//!
+//! Labels that come from the config (route, domain) are built once per routing snapshot and
+//! those with a fixed value set (method, status code, protocol) once per process, all as static
+//! or reference-counted [`Value`]s. Recording a request then clones a handful of `Arc`s into a
+//! stack array instead of allocating a `String` per label.
+
+use std::sync::{Arc, LazyLock};
+
+use http::{Method, Version};
+use opentelemetry::{KeyValue, Value};
+
+use super::metrics::labels;
+use crate::utils::http::version_label;
+
+/// Methods whose label is a static string; any other method is copied per request.
+const STANDARD_METHODS: [&str; 9] =
+    ["GET", "HEAD", "POST", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE", "PATCH"];
+
+const FIRST_STATUS: u16 = 100;
+const LAST_STATUS: u16 = 599;
+
+/// `status_code` values for every valid status, indexed by `code - FIRST_STATUS`.
+static STATUS_CODES: LazyLock<Box<[Value]>> = LazyLock::new(|| {
+    (FIRST_STATUS..=LAST_STATUS)
+        .map(|code| Value::from(Arc::<str>::from(code.to_string())))
+        .collect()
+});
+
+/// Interned `value` for a label that is shared across requests.
+fn interned(value: &str) -> Value {
+    Value::from(Arc::<str>::from(value))
+}
+
+/// `status_code` attribute of `code`.
+pub fn status_code(code: u16) -> KeyValue {
+    let value = code
+        .checked_sub(FIRST_STATUS)
+        .and_then(|index| STATUS_CODES.get(usize::from(index)))
+        .cloned()
+        .unwrap_or_else(|| Value::from(code.to_string()));
+    KeyValue::new(labels::STATUS_CODE, value)
+}
+
+/// `backend_address` attribute; `address` is the selector's shared copy, so this only bumps its
+/// reference count.
+pub fn backend_address(address: &Arc<str>) -> KeyValue {
+    KeyValue::new(labels::BACKEND_ADDRESS, Value::from(Arc::clone(address)))
+}
+
+/// Labels of one request that do not depend on the matched route, built once per request.
+#[derive(Debug, Clone)]
+pub struct RequestAttributes {
+    pub method: KeyValue,
+    pub protocol: KeyValue,
+}
+
+impl RequestAttributes {
+    pub fn new(method: &Method, version: Version) -> Self {
+        let method = match STANDARD_METHODS
+            .iter()
+            .find(|&&name| name == method.as_str())
+        {
+            Some(&name) => Value::from(name),
+            None => Value::from(method.as_str().to_string()),
+        };
+        Self {
+            method: KeyValue::new(labels::METHOD, method),
+            protocol: KeyValue::new(labels::PROTOCOL, version_label(version)),
+        }
+    }
+}
+
+/// `route` and `domain` labels of one route, interned when the routing table is compiled.
+#[derive(Debug, Clone, PartialEq)]
+pub struct RouteAttributes {
+    pub route: KeyValue,
+    pub domain: KeyValue,
+}
+
+impl RouteAttributes {
+    pub fn new(route: &str, domain: &str) -> Self {
+        Self::with_domain(route, interned(domain))
+    }
+
+    /// Attributes of a route whose domain label is already interned (shared by every route of
+    /// the domain).
+    pub fn with_domain(route: &str, domain: Value) -> Self {
+        Self {
+            route: KeyValue::new(labels::ROUTE, interned(route)),
+            domain: KeyValue::new(labels::DOMAIN, domain),
+        }
+    }
+
+    /// The interned `domain` value, for [`Self::with_domain`].
+    pub fn domain_value(domain: &str) -> Value {
+        interned(domain)
+    }
+}
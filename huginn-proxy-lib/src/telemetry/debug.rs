@@ -0,0 +1,170 @@
+//! Runtime introspection endpoints (`[telemetry.debug]`).
+//!
+//! Served by the observability server under [`DEBUG_PREFIX`] when enabled, to requests with
+//! `Authorization: Bearer <token>`:
+//! - `/debug/runtime?seconds=N` - tokio runtime stats, with worker busy ratios measured over N
+//!   seconds (default 1).
+
+use aws_lc_rs::constant_time::verify_slices_are_equal;
+use hyper::header::{HeaderValue, AUTHORIZATION, WWW_AUTHENTICATE};
+use hyper::{HeaderMap, Response, StatusCode};
+use serde::Serialize;
+use tokio::runtime::RuntimeMetrics;
+use tokio::time::{Duration, Instant};
+use tracing::debug;
+
+use crate::config::DebugConfig;
+use crate::telemetry::status::{Status, StatusBody};
+use crate::utils::http::{json_response, RespBody};
+
+/// Path prefix of the debug endpoints on the observability server.
+pub const DEBUG_PREFIX: &str = "/debug/";
+
+const DEFAULT_RUNTIME_SECONDS: u64 = 1;
+
+/// The `/debug/` endpoints of an enabled `[telemetry.debug]`.
+pub struct DebugEndpoints {
+    token: Vec<u8>,
+    max_seconds: u64,
+}
+
+impl DebugEndpoints {
+    /// `None` unless `[telemetry.debug]` is enabled.
+    pub fn new(config: &DebugConfig) -> Option<Self> {
+        config.enabled.then(|| Self {
+            token: config.token.expose().as_bytes().to_vec(),
+            max_seconds: config.max_window_seconds,
+        })
+    }
+
+    /// Serve a request for `path` (under [`DEBUG_PREFIX`]). Runtime samples take the requested
+    /// number of seconds to answer.
+    pub async fn handle(
+        &self,
+        path: &str,
+        query: Option<&str>,
+        headers: &HeaderMap,
+    ) -> Response<RespBody> {
+        let response = if !self.authorized(headers) {
+            unauthorized()
+        } else {
+            match path {
+                "/debug/runtime" => match self.window(query, DEFAULT_RUNTIME_SECONDS) {
+                    Some(window) => json_response(StatusCode::OK, runtime_stats(window).await),
+                    None => bad_window(),
+                },
+                _ => json_response(StatusCode::NOT_FOUND, StatusBody::new(Status::NotFound)),
+            }
+        };
+
+        debug!(path, status = response.status().as_u16(), "Debug request handled");
+        response
+    }
+
+    fn authorized(&self, headers: &HeaderMap) -> bool {
+        headers
+            .get(AUTHORIZATION)
+            .and_then(|value| value.as_bytes().strip_prefix(b"Bearer "))
+            .is_some_and(|token| verify_slices_are_equal(token, &self.token).is_ok())
+    }
+
+    /// The `seconds` query parameter, or `default`; `None` unless it is 1 to `max_window_seconds`.
+    fn window(&self, query: Option<&str>, default: u64) -> Option<Duration> {
+        let seconds = match query_param(query, "seconds") {
+            None => default.min(self.max_seconds),
+            Some(value) => value
+                .parse::<u64>()
+                .ok()
+                .filter(|seconds| (1..=self.max_seconds).contains(seconds))?,
+        };
+        Some(Duration::from_secs(seconds))
+    }
+}
+
+fn bad_window() -> Response<RespBody> {
+    json_response(
+        StatusCode::BAD_REQUEST,
+        StatusBody::with_reason(
+            Status::BadRequest,
+            "seconds must be between 1 and max_window_seconds",
+        ),
+    )
+}
+
+fn unauthorized() -> Response<RespBody> {
+    let mut resp = json_response(StatusCode::UNAUTHORIZED, StatusBody::new(Status::Unauthorized));
+    resp.headers_mut()
+        .insert(WWW_AUTHENTICATE, HeaderValue::from_static("Bearer"));
+    resp
+}
+
+fn query_param<'a>(query: Option<&'a str>, name: &str) -> Option<&'a str> {
+    query?
+        .split('&')
+        .find_map(|pair| pair.strip_prefix(name)?.strip_prefix('='))
+}
+
+/// Tokio runtime stats returned by `/debug/runtime`.
+///
+/// Only the runtime's stable metrics are reported: per-worker queue depths and poll counts need
+/// a `tokio_unstable` build.
+#[derive(Debug, Serialize)]
+pub struct RuntimeStats {
+    pub workers: usize,
+    /// Tasks spawned and not yet completed.
+    pub alive_tasks: usize,
+    /// Tasks waiting in the runtime's global (injection) queue.
+    pub global_queue_depth: usize,
+    /// How long the per-worker figures were measured over.
+    pub window_seconds: f64,
+    pub worker: Vec<WorkerStats>,
+}
+
+/// One worker thread over the sampling window.
+#[derive(Debug, Serialize)]
+pub struct WorkerStats {
+    /// Share of the window the worker spent running tasks, from 0 to 1.
+    pub busy_ratio: f64,
+    /// Times the worker ran out of work and parked.
+    pub parks: u64,
+}
+
+/// Sample the current runtime's stats over `window`.
+pub async fn runtime_stats(window: Duration) -> RuntimeStats {
+    let metrics = tokio::runtime::Handle::current().metrics();
+    let workers = metrics.num_workers();
+    let before: Vec<_> = (0..workers)
+        .map(|worker| sample(&metrics, worker))
+        .collect();
+    let start = Instant::now();
+    tokio::time::sleep(window).await;
+    let elapsed = start.elapsed();
+
+    let worker = before
+        .into_iter()
+        .enumerate()
+        .map(|(worker, (busy, parks))| {
+            let (busy_now, parks_now) = sample(&metrics, worker);
+            let busy = busy_now.saturating_sub(busy).as_secs_f64();
+            WorkerStats {
+                busy_ratio: if elapsed.is_zero() {
+                    0.0
+                } else {
+                    (busy / elapsed.as_secs_f64()).min(1.0)
+                },
+                parks: parks_now.saturating_sub(parks),
+            }
+        })
+        .collect();
+    RuntimeStats {
+        workers,
+        alive_tasks: metrics.num_alive_tasks(),
+        global_queue_depth: metrics.global_queue_depth(),
+        window_seconds: elapsed.as_secs_f64(),
+        worker,
+    }
+}
+
+fn sample(metrics: &RuntimeMetrics, worker: usize) -> (Duration, u64) {
+    (metrics.worker_total_busy_duration(worker), metrics.worker_park_count(worker))
+}
@@ -0,0 +1,366 @@
+//! Off-hot-path export of connection fingerprints (`[telemetry.fingerprint_export]`).
+//!
+//! Request handlers hand a [`FingerprintRecord`] to [`FingerprintExporter::push`], which never
+//! blocks: the bounded queue drops the record when it is full. The [`ExportTask`] drains the
+//! queue, folds identical records seen within one flush interval into a single line with a
+//! count, and writes each batch as newline-delimited JSON in one write. Encoding the JA4
+//! variants and the SYN signature happens in the task, not on the request path.
+//!
+//! One line per distinct record and interval:
+//!
+//! ```json
+//! {"first_seen_ms":1760400000000,"last_seen_ms":1760400000950,"count":3,"client_ip":"198.51.100.7",
+//!  "host":"api.example.com","sni":"api.example.com","ja4":"t13d1516h2_...","akamai":"1:65536;...",
+//!  "tcp_syn":"4:64+0:0:1460:...","spoofed":["x-tls-ja4"]}
+//! ```
+
+use std::net::IpAddr;
+use std::path::Path;
+use std::sync::Arc;
+use std::time::{Duration, SystemTime, UNIX_EPOCH};
+
+use http::HeaderValue;
+use serde::Serialize;
+use tokio::io::AsyncWriteExt;
+use tokio::net::TcpStream;
+use tokio::sync::mpsc;
+use tokio::sync::mpsc::error::TrySendError;
+use tracing::{info, warn};
+
+use crate::config::FingerprintExportConfig;
+use crate::error::Result;
+use crate::fingerprinting::{Ja4Fingerprints, TcpObservation};
+use crate::proxy::shutdown::{ServiceHandle, ServiceName, ShutdownWatch};
+use crate::telemetry::metrics::values;
+use crate::telemetry::Metrics;
+
+/// Fingerprints of one connection (or one spoofing request), as queued by the handler.
+///
+/// Built from values the handler already holds, so queuing costs the `host` copy and a few
+/// reference-count bumps.
+pub struct FingerprintRecord {
+    pub time: SystemTime,
+    pub client_ip: IpAddr,
+    pub host: Box<str>,
+    pub ja4: Option<Ja4Fingerprints>,
+    pub akamai: Option<HeaderValue>,
+    pub tcp_syn: Option<TcpObservation>,
+    /// Proxy-authoritative headers the client supplied (`x-fingerprint-spoofing-detected`).
+    pub spoofed: Vec<&'static str>,
+}
+
+/// Producer side of the export queue, shared by every connection.
+pub struct FingerprintExporter {
+    tx: mpsc::Sender<FingerprintRecord>,
+    metrics: Arc<Metrics>,
+}
+
+impl FingerprintExporter {
+    /// The exporter and the task that drains it; `None` when export is disabled.
+    pub fn new(
+        config: &FingerprintExportConfig,
+        metrics: Arc<Metrics>,
+    ) -> Option<(Arc<Self>, ExportTask)> {
+        if !config.enabled {
+            return None;
+        }
+        let target = match (&config.path, &config.endpoint) {
+            (Some(path), _) => Target::File(path.clone()),
+            (None, Some(endpoint)) => Target::Tcp(endpoint.clone()),
+            (None, None) => return None,
+        };
+        let (tx, rx) = mpsc::channel(config.queue_capacity.max(1));
+        let task = ExportTask {
+            rx,
+            target,
+            batch_size: config.batch_size.max(1),
+            flush_interval: Duration::from_millis(config.flush_interval_ms.max(1)),
+            metrics: Arc::clone(&metrics),
+        };
+        Some((Arc::new(Self { tx, metrics }), task))
+    }
+
+    /// Queue `record` without waiting. Returns whether it was queued: a full queue drops it and
+    /// counts the drop, and after shutdown (the task has stopped) it is dropped silently.
+    pub fn push(&self, record: FingerprintRecord) -> bool {
+        match self.tx.try_send(record) {
+            Ok(()) => true,
+            Err(TrySendError::Full(_)) => {
+                self.metrics
+                    .record_fingerprint_export_dropped(values::EXPORT_DROP_QUEUE_FULL, 1);
+                false
+            }
+            Err(TrySendError::Closed(_)) => false,
+        }
+    }
+}
+
+/// Where the export task writes.
+#[derive(Debug)]
+enum Target {
+    File(std::path::PathBuf),
+    Tcp(String),
+}
+
+/// Consumer side of the export queue; run as a background service with [`ExportTask::spawn`].
+pub struct ExportTask {
+    rx: mpsc::Receiver<FingerprintRecord>,
+    target: Target,
+    batch_size: usize,
+    flush_interval: Duration,
+    metrics: Arc<Metrics>,
+}
+
+impl ExportTask {
+    /// Open the sink and spawn the task. A file that cannot be opened fails startup; a TCP
+    /// collector is connected on the first write and reconnected after a failed one.
+    pub async fn spawn(self, shutdown_rx: ShutdownWatch) -> Result<ServiceHandle> {
+        let sink = match &self.target {
+            Target::File(path) => Sink::File(open_append(path).await?),
+            Target::Tcp(endpoint) => Sink::Tcp { endpoint: endpoint.clone(), stream: None },
+        };
+        info!(
+            sink = %sink,
+            batch_size = self.batch_size,
+            flush_interval_ms = self.flush_interval.as_millis(),
+            "Fingerprint export enabled"
+        );
+        let handle = tokio::spawn(self.run(sink, shutdown_rx));
+        Ok(ServiceHandle { handle, name: ServiceName::FingerprintExport })
+    }
+
+    async fn run(mut self, mut sink: Sink, mut shutdown_rx: ShutdownWatch) {
+        let mut window = Window::default();
+        let mut batch = Vec::with_capacity(self.batch_size);
+        let mut buf = Vec::new();
+        let mut tick = tokio::time::interval(self.flush_interval);
+        tick.set_missed_tick_behavior(tokio::time::MissedTickBehavior::Delay);
+        loop {
+            tokio::select! {
+                biased;
+                _ = shutdown_rx.wait_for(|v| *v) => break,
+                _ = tick.tick() => {
+                    self.metrics.record_fingerprint_export_queue_depth(self.rx.len() as u64);
+                    self.flush(&mut window, &mut sink, &mut buf).await;
+                }
+                received = self.rx.recv_many(&mut batch, self.batch_size) => {
+                    if received == 0 {
+                        break;
+                    }
+                    for record in batch.drain(..) {
+                        window.add(record);
+                    }
+                    if window.len() >= self.batch_size {
+                        self.flush(&mut window, &mut sink, &mut buf).await;
+                    }
+                }
+            }
+        }
+        // Write what was queued before shutdown.
+        while let Ok(record) = self.rx.try_recv() {
+            window.add(record);
+        }
+        self.flush(&mut window, &mut sink, &mut buf).await;
+    }
+
+    /// Write the window's lines in one write and start a new window.
+    async fn flush(&self, window: &mut Window, sink: &mut Sink, buf: &mut Vec<u8>) {
+        if window.is_empty() {
+            return;
+        }
+        buf.clear();
+        let (lines, records) = window.drain_into(buf);
+        match sink.write(buf).await {
+            Ok(()) => self.metrics.record_fingerprint_export_lines(lines),
+            Err(e) => {
+                warn!(
+                    sink = %sink,
+                    error = %e,
+                    lines,
+                    "Fingerprint export write failed; batch dropped"
+                );
+                self.metrics
+                    .record_fingerprint_export_dropped(values::EXPORT_DROP_SINK_ERROR, records);
+            }
+        }
+    }
+}
+
+async fn open_append(path: &Path) -> std::io::Result<tokio::fs::File> {
+    tokio::fs::OpenOptions::new()
+        .create(true)
+        .append(true)
+        .open(path)
+        .await
+}
+
+enum Sink {
+    File(tokio::fs::File),
+    Tcp {
+        endpoint: String,
+        stream: Option<TcpStream>,
+    },
+}
+
+impl Sink {
+    async fn write(&mut self, bytes: &[u8]) -> std::io::Result<()> {
+        match self {
+            Self::File(file) => {
+                file.write_all(bytes).await?;
+                file.flush().await
+            }
+            Self::Tcp { endpoint, stream } => {
+                let mut conn = match stream.take() {
+                    Some(conn) => conn,
+                    None => TcpStream::connect(endpoint.as_str()).await?,
+                };
+                // A failed write drops the connection; the next batch reconnects.
+                conn.write_all(bytes).await?;
+                *stream = Some(conn);
+                Ok(())
+            }
+        }
+    }
+}
+
+impl std::fmt::Display for Sink {
+    fn fmt(&self, f: &mut std::fmt::Formatter<'_>) -> std::fmt::Result {
+        match self {
+            Self::File(_) => f.write_str("file"),
+            Self::Tcp { endpoint, .. } => write!(f, "tcp://{endpoint}"),
+        }
+    }
+}
+
+/// The exported fields of a record; identical values within a window are written once.
+#[derive(Debug, Serialize, PartialEq, Eq, Hash)]
+struct Fingerprints {
+    client_ip: IpAddr,
+    host: Box<str>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    sni: Option<String>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    ja4: Option<String>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    ja4_r: Option<String>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    ja4_o: Option<String>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    ja4_or: Option<String>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    ja4_s1: Option<String>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    ja4_s1r: Option<String>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    akamai: Option<String>,
+    #[serde(skip_serializing_if = "Option::is_none")]
+    tcp_syn: Option<String>,
+    #[serde(skip_serializing_if = "Vec::is_empty")]
+    spoofed: Vec<&'static str>,
+}
+
+impl From<FingerprintRecord> for Fingerprints {
+    fn from(record: FingerprintRecord) -> Self {
+        let mut fingerprints = Self {
+            client_ip: record.client_ip,
+            host: record.host,
+            sni: None,
+            ja4: None,
+            ja4_r: None,
+            ja4_o: None,
+            ja4_or: None,
+            ja4_s1: None,
+            ja4_s1r: None,
+            akamai: text(record.akamai.as_ref()),
+            tcp_syn: record.tcp_syn.map(|syn| syn.to_string()),
+            spoofed: record.spoofed,
+        };
+        if let Some(ja4) = record.ja4 {
+            let [ja4_h, ja4_r, ja4_o, ja4_or, ja4_s1, ja4_s1r] =
+                ja4.header_values().map(|(_, value)| text(value));
+            fingerprints.sni = ja4.sni().map(str::to_string);
+            fingerprints.ja4 = ja4_h;
+            fingerprints.ja4_r = ja4_r;
+            fingerprints.ja4_o = ja4_o;
+            fingerprints.ja4_or = ja4_or;
+            fingerprints.ja4_s1 = ja4_s1;
+            fingerprints.ja4_s1r = ja4_s1r;
+        }
+        fingerprints
+    }
+}
+
+fn text(value: Option<&HeaderValue>) -> Option<String> {
+    value.and_then(|v| v.to_str().ok()).map(str::to_string)
+}
+
+/// When and how often a distinct record was seen in the current window.
+#[derive(Debug, Clone, Copy)]
+struct Seen {
+    first_ms: u64,
+    last_ms: u64,
+    count: u64,
+}
+
+#[derive(Serialize)]
+struct Line<'a> {
+    first_seen_ms: u64,
+    last_seen_ms: u64,
+    count: u64,
+    #[serde(flatten)]
+    fingerprints: &'a Fingerprints,
+}
+
+/// Distinct records of one flush interval.
+#[derive(Default)]
+struct Window {
+    seen: std::collections::HashMap<Fingerprints, Seen, ahash::RandomState>,
+}
+
+impl Window {
+    fn add(&mut self, record: FingerprintRecord) {
+        let ms = unix_millis(record.time);
+        let seen = self.seen.entry(Fingerprints::from(record)).or_insert(Seen {
+            first_ms: ms,
+            last_ms: ms,
+            count: 0,
+        });
+        seen.first_ms = seen.first_ms.min(ms);
+        seen.last_ms = seen.last_ms.max(ms);
+        seen.count = seen.count.saturating_add(1);
+    }
+
+    fn len(&self) -> usize {
+        self.seen.len()
+    }
+
+    fn is_empty(&self) -> bool {
+        self.seen.is_empty()
+    }
+
+    /// Append one JSON line per distinct record, oldest first, and empty the window. Returns
+    /// the lines written and the records they stand for.
+    fn drain_into(&mut self, buf: &mut Vec<u8>) -> (u64, u64) {
+        let mut entries: Vec<(Fingerprints, Seen)> = self.seen.drain().collect();
+        entries.sort_by_key(|(_, seen)| seen.first_ms);
+        let mut records = 0u64;
+        for (fingerprints, seen) in &entries {
+            let line = Line {
+                first_seen_ms: seen.first_ms,
+                last_seen_ms: seen.last_ms,
+                count: seen.count,
+                fingerprints,
+            };
+            if serde_json::to_writer(&mut *buf, &line).is_ok() {
+                buf.push(b'\n');
+            }
+            records = records.saturating_add(seen.count);
+        }
+        (entries.len() as u64, records)
+    }
+}
+
+fn unix_millis(time: SystemTime) -> u64 {
+    time.duration_since(UNIX_EPOCH)
+        .map_or(0, |d| u64::try_from(d.as_millis()).unwrap_or(u64::MAX))
+}
@@ -1,10 +1,13 @@
 use opentelemetry::global;
 use opentelemetry::metrics::{Counter, Gauge, Histogram, Meter, UpDownCounter};
-use opentelemetry::KeyValue;
+use opentelemetry::{KeyValue, Value};
 use opentelemetry_sdk::metrics::SdkMeterProvider;
 use prometheus::Registry;
 use std::sync::Arc;
 
+use super::attributes::{self, RequestAttributes, RouteAttributes};
+use crate::security::IpFilterIndex;
+
 pub mod labels {
     pub const ERROR_TYPE: &str = "error_type";
     pub const STRATEGY: &str = "strategy";
@@ -26,6 +29,10 @@ pub mod labels {
     pub const RESULT: &str = "result";
     pub const DOMAIN: &str = "domain";
     pub const FAMILY: &str = "family";
+    pub const SCOPE: &str = "scope";
+    pub const MODE: &str = "mode";
+    pub const RUNTIME: &str = "runtime";
+    pub const PHASE: &str = "phase";
 }
 
 pub mod values {
@@ -41,12 +48,50 @@ pub mod values {
     pub const REASON_NOT_HTTP2: &str = "not_http2";
     pub const REASON_LIMIT_EXCEEDED: &str = "limit_exceeded";
     pub const REASON_SHUTDOWN: &str = "shutdown";
+    pub const REASON_PER_IP_LIMIT: &str = "per_ip_limit";
+    pub const REASON_SCHEDULER_LAG: &str = "scheduler_lag";
     pub const HEALTH_PROBE_OK: &str = "ok";
     pub const HEALTH_PROBE_FAIL: &str = "fail";
     /// PROXY protocol drop reasons for `proxy_protocol_dropped_total{reason=...}`.
     pub const PROXY_PROTOCOL_DROP_UNTRUSTED_REQUIRE: &str = "untrusted_require";
     pub const PROXY_PROTOCOL_DROP_BAD_HEADER: &str = "bad_header";
     pub const PROXY_PROTOCOL_DROP_TIMEOUT: &str = "timeout";
+    /// Policy scopes for `ip_filter_entries{scope=...}`.
+    pub const SCOPE_GLOBAL: &str = "global";
+    pub const SCOPE_DOMAIN: &str = "domain";
+    pub const SCOPE_ROUTE: &str = "route";
+    pub const SCOPE_BACKEND: &str = "backend";
+    pub const POOL_HIT: &str = "hit";
+    pub const POOL_MISS: &str = "miss";
+    /// Outcomes for `tls_session_resumptions_total{result=...}`.
+    pub const RESUMPTION_HIT: &str = "hit";
+    pub const RESUMPTION_MISS: &str = "miss";
+
+    /// Outcomes for `tls_ktls_offload_total{result=...}`.
+    pub const KTLS_OFFLOADED: &str = "offloaded";
+    pub const KTLS_UNSUPPORTED_CIPHER: &str = "unsupported_cipher";
+    pub const KTLS_UNAVAILABLE: &str = "unavailable";
+    pub const KTLS_ERROR: &str = "error";
+
+    /// Outcomes for `rate_limit_cluster_datagrams_total{result=...}`.
+    pub const CLUSTER_SENT: &str = "sent";
+    pub const CLUSTER_SEND_FAILED: &str = "send_failed";
+    pub const CLUSTER_RECEIVED: &str = "received";
+    pub const CLUSTER_REJECTED: &str = "rejected";
+
+    /// Outcomes for `cache_requests_total{result=...}`.
+    pub const CACHE_HIT: &str = "hit";
+    pub const CACHE_MISS: &str = "miss";
+    pub const CACHE_BYPASS: &str = "bypass";
+
+    /// Outcomes for `coalesce_requests_total{result=...}`.
+    pub const COALESCE_LEADER: &str = "leader";
+    pub const COALESCE_FOLLOWER: &str = "follower";
+    pub const COALESCE_FALLBACK: &str = "fallback";
+
+    /// Reasons for `fingerprint_export_dropped_total{reason=...}`.
+    pub const EXPORT_DROP_QUEUE_FULL: &str = "queue_full";
+    pub const EXPORT_DROP_SINK_ERROR: &str = "sink_error";
 }
 
 #[derive(Clone)]
@@ -85,6 +130,14 @@ pub struct Metrics {
     // header label: the proxy-authoritative header name the client attempted to supply
     pub fingerprint_spoofing_attempts_total: Counter<u64>,
 
+    // Fingerprint export (`[telemetry.fingerprint_export]`)
+    /// Records waiting in the export queue, sampled by the export task.
+    pub fingerprint_export_queue_depth: Gauge<u64>,
+    /// Records lost before reaching the sink. reason=queue_full|sink_error
+    pub fingerprint_export_dropped_total: Counter<u64>,
+    /// Lines written to the sink (one per distinct record per flush interval).
+    pub fingerprint_export_lines_total: Counter<u64>,
+
     // PROXY protocol (source address recovery for L4-forwarded connections)
     /// Real client address recovered from a PROXY header sent by a trusted peer.
     pub proxy_protocol_accepted_total: Counter<u64>,
@@ -99,6 +152,17 @@ pub struct Metrics {
     pub backend_requests_total: Counter<u64>,
     pub backend_errors_total: Counter<u64>,
     pub backend_duration_seconds: Histogram<f64>,
+    /// Requests forwarded to a backend and awaiting its response headers.
+    pub backend_in_flight_requests: UpDownCounter<i64>,
+    /// Backend latency EWMA used by the `p2c_ewma` load-balance strategy.
+    pub backend_latency_ewma_seconds: Gauge<f64>,
+
+    // Backend pool prewarming (`[backend_pool.prewarm]`)
+    /// Spare prewarmed connections currently held per backend and client protocol.
+    pub backend_pool_warm_connections: Gauge<u64>,
+    /// New upstream connections needed by the pooled clients for a prewarmed backend.
+    /// result=hit (served from the spares) | miss (dialed on demand)
+    pub backend_pool_checkouts_total: Counter<u64>,
 
     // Backend throughput metrics
     pub backend_bytes_received_total: Counter<u64>,
@@ -112,9 +176,36 @@ pub struct Metrics {
     pub tls_handshake_duration_seconds: Histogram<f64>,
     pub tls_handshake_errors_total: Counter<u64>,
     pub tls_connections_active: UpDownCounter<i64>,
+    /// Completed handshakes by session resumption outcome. result=hit|miss
+    pub tls_session_resumptions_total: Counter<u64>,
+    pub tls_ktls_offload_total: Counter<u64>,
 
     // Connection limit metrics
     pub connections_rejected_total: Counter<u64>,
+    /// How late each runtime polls its timers, as probed for `[admission].max_scheduler_lag_ms`.
+    pub scheduler_lag_seconds: Gauge<f64>,
+
+    // Adaptive concurrency metrics (`[admission.adaptive_concurrency]`)
+    /// Requests answered 503 by an adaptive limit. scope=route|backend
+    pub requests_shed_total: Counter<u64>,
+    /// Current adaptive limit of a route (route, domain) or backend (backend_address).
+    pub concurrency_limit: Gauge<u64>,
+
+    // Response cache metrics (`[cache]`, routes with `cache`)
+    /// Lookups on cached routes. result=hit|miss|bypass
+    pub cache_requests_total: Counter<u64>,
+    /// Entries evicted to make room, by the route that stored them.
+    pub cache_evictions_total: Counter<u64>,
+    /// Bytes held by the response cache.
+    pub cache_size_bytes: Gauge<u64>,
+
+    // Request coalescing metrics (routes with `coalesce`)
+    /// Coalescable requests. result=leader|follower|fallback
+    pub coalesce_requests_total: Counter<u64>,
+
+    // Latency breakdown (`[telemetry.timing]`)
+    /// Duration of one connection or request phase. phase=proxy_protocol|syn_probe|...
+    pub phase_duration_seconds: Histogram<f64>,
 
     // Timeout metrics
     pub timeouts_total: Counter<u64>,
@@ -123,11 +214,19 @@ pub struct Metrics {
     pub rate_limit_requests_total: Counter<u64>,
     pub rate_limit_allowed_total: Counter<u64>,
     pub rate_limit_rejected_total: Counter<u64>,
+    /// Cluster sync datagrams. result=sent|send_failed|received|rejected
+    pub rate_limit_cluster_datagrams_total: Counter<u64>,
+    /// Requests admitted by peers and debited locally
+    pub rate_limit_cluster_debited_total: Counter<u64>,
 
     // IP filtering metrics
     pub ip_filter_requests_total: Counter<u64>,
     pub ip_filter_allowed_total: Counter<u64>,
     pub ip_filter_denied_total: Counter<u64>,
+    /// Prefixes in the active allow/deny lists of the live config. scope=global|domain|route
+    pub ip_filter_entries: Gauge<u64>,
+    /// Time to compile the IP filter lists of a config snapshot into its lookup index.
+    pub ip_filter_build_duration_seconds: Histogram<f64>,
 
     // Header manipulation metrics
     pub headers_added_total: Counter<u64>,
@@ -234,7 +333,7 @@ impl Metrics {
                 .build(),
             tcp_syn_fingerprint_duration_seconds: meter
                 .f64_histogram("huginn_tcp_syn_fingerprint_duration_seconds")
-                .with_description("TCP SYN fingerprint BPF map lookup and parse duration in seconds")
+                .with_description("TCP SYN fingerprint BPF map lookup and parse duration in seconds, by reason and lookup mode")
                 .build(),
             tcp_syn_fingerprint_failures_total: meter
                 .u64_counter("huginn_tcp_syn_fingerprint_failures_total")
@@ -249,6 +348,18 @@ impl Metrics {
                 .u64_counter("huginn_fingerprint_spoofing_attempts_total")
                 .with_description("Total number of proxy-authoritative fingerprint headers supplied by clients (spoofing attempts). header=the stripped header name")
                 .build(),
+            fingerprint_export_queue_depth: meter
+                .u64_gauge("huginn_fingerprint_export_queue_depth")
+                .with_description("Fingerprint records waiting in the export queue")
+                .build(),
+            fingerprint_export_dropped_total: meter
+                .u64_counter("huginn_fingerprint_export_dropped_total")
+                .with_description("Total fingerprint records dropped before export, by reason (queue_full, sink_error)")
+                .build(),
+            fingerprint_export_lines_total: meter
+                .u64_counter("huginn_fingerprint_export_lines_total")
+                .with_description("Total deduplicated fingerprint lines written to the export sink")
+                .build(),
 
             proxy_protocol_accepted_total: meter
                 .u64_counter("huginn_proxy_protocol_accepted_total")
@@ -279,6 +390,23 @@ impl Metrics {
                 .f64_histogram("huginn_backend_duration_seconds")
                 .with_description("Backend request duration in seconds")
                 .build(),
+            backend_in_flight_requests: meter
+                .i64_up_down_counter("huginn_backend_in_flight_requests")
+                .with_description("Requests forwarded to a backend and awaiting its response")
+                .build(),
+            backend_latency_ewma_seconds: meter
+                .f64_gauge("huginn_backend_latency_ewma_seconds")
+                .with_description("Exponentially weighted moving average of backend response time in seconds")
+                .build(),
+
+            backend_pool_warm_connections: meter
+                .u64_gauge("huginn_backend_pool_warm_connections")
+                .with_description("Spare prewarmed upstream connections held per backend")
+                .build(),
+            backend_pool_checkouts_total: meter
+                .u64_counter("huginn_backend_pool_checkouts_total")
+                .with_description("New upstream connections requested for prewarmed backends. result=hit|miss")
+                .build(),
 
             backend_bytes_received_total: meter
                 .u64_counter("huginn_backend_bytes_received_total")
@@ -315,11 +443,64 @@ impl Metrics {
                 .i64_up_down_counter("huginn_tls_connections_active")
                 .with_description("Number of active TLS connections")
                 .build(),
+            tls_session_resumptions_total: meter
+                .u64_counter("huginn_tls_session_resumptions_total")
+                .with_description(
+                    "Completed TLS handshakes by session resumption outcome (hit = resumed, miss = full handshake)",
+                )
+                .build(),
+            tls_ktls_offload_total: meter
+                .u64_counter("huginn_tls_ktls_offload_total")
+                .with_description(
+                    "kTLS offload attempts after the handshake by result (offloaded, or why the connection stayed on rustls)",
+                )
+                .build(),
 
             connections_rejected_total: meter
                 .u64_counter("huginn_connections_rejected_total")
                 .with_description("Total number of connections rejected due to connection limit")
                 .build(),
+            scheduler_lag_seconds: meter
+                .f64_gauge("huginn_scheduler_lag_seconds")
+                .with_description("Smoothed delay between a runtime's timer deadline and the probe task running (main or shard-N)")
+                .build(),
+
+            requests_shed_total: meter
+                .u64_counter("huginn_requests_shed_total")
+                .with_description("Total requests answered 503 because a route or backend adaptive concurrency limit was reached")
+                .build(),
+            concurrency_limit: meter
+                .u64_gauge("huginn_concurrency_limit")
+                .with_description("Current adaptive concurrency limit of a route or backend")
+                .build(),
+
+            cache_requests_total: meter
+                .u64_counter("huginn_cache_requests_total")
+                .with_description("Total response cache lookups on cached routes by result (hit, miss, bypass)")
+                .build(),
+            cache_evictions_total: meter
+                .u64_counter("huginn_cache_evictions_total")
+                .with_description("Total response cache entries evicted to make room")
+                .build(),
+            cache_size_bytes: meter
+                .u64_gauge("huginn_cache_size_bytes")
+                .with_description("Bytes held by the response cache (bodies, headers and keys)")
+                .build(),
+
+            coalesce_requests_total: meter
+                .u64_counter("huginn_coalesce_requests_total")
+                .with_description("Total coalescable requests by result (leader, follower, fallback)")
+                .build(),
+
+            phase_duration_seconds: meter
+                .f64_histogram("huginn_phase_duration_seconds")
+                .with_description("Duration of one connection or request phase in seconds")
+                // Most phases take microseconds; the SDK default buckets start at 5 (seconds here).
+                .with_boundaries(vec![
+                    0.000_05, 0.000_1, 0.000_25, 0.000_5, 0.001, 0.002_5, 0.005, 0.01, 0.025,
+                    0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0,
+                ])
+                .build(),
 
             timeouts_total: meter
                 .u64_counter("huginn_timeouts_total")
@@ -338,6 +519,18 @@ impl Metrics {
                 .u64_counter("huginn_rate_limit_rejected_total")
                 .with_description("Total number of requests rejected by rate limiter (429)")
                 .build(),
+            rate_limit_cluster_datagrams_total: meter
+                .u64_counter("huginn_rate_limit_cluster_datagrams_total")
+                .with_description(
+                    "Rate-limit cluster sync datagrams by result (sent, send_failed, received, rejected)",
+                )
+                .build(),
+            rate_limit_cluster_debited_total: meter
+                .u64_counter("huginn_rate_limit_cluster_debited_total")
+                .with_description(
+                    "Requests admitted by other cluster nodes and debited from local rate-limit buckets",
+                )
+                .build(),
 
             ip_filter_requests_total: meter
                 .u64_counter("huginn_ip_filter_requests_total")
@@ -351,6 +544,14 @@ impl Metrics {
                 .u64_counter("huginn_ip_filter_denied_total")
                 .with_description("Total number of requests denied by IP filter (403)")
                 .build(),
+            ip_filter_entries: meter
+                .u64_gauge("huginn_ip_filter_entries")
+                .with_description("Prefixes in the active IP filter allow/deny lists of the live config. scope=global|domain|route")
+                .build(),
+            ip_filter_build_duration_seconds: meter
+                .f64_histogram("huginn_ip_filter_build_duration_seconds")
+                .with_description("IP filter index compile duration in seconds, per config load or reload")
+                .build(),
 
             headers_added_total: meter
                 .u64_counter("huginn_headers_added_total")
@@ -444,52 +645,44 @@ impl Metrics {
             .add(1, &[KeyValue::new(labels::BACKEND, backend.to_string())]);
     }
 
-    pub fn record_rate_limit_rejection(&self, strategy: &str, route: &str, domain: &str) {
+    pub fn record_rate_limit_rejection(&self, strategy: &'static str, route: &RouteAttributes) {
         self.errors_total
             .add(1, &[KeyValue::new(labels::ERROR_TYPE, values::ERROR_RATE_LIMITED)]);
-        self.rate_limit_rejected_total.add(
-            1,
-            &[
-                KeyValue::new(labels::STRATEGY, strategy.to_string()),
-                KeyValue::new(labels::ROUTE, route.to_string()),
-                KeyValue::new(labels::DOMAIN, domain.to_string()),
-            ],
-        );
+        self.rate_limit_rejected_total
+            .add(1, &rate_limit_attributes(strategy, route));
     }
 
-    pub fn record_rate_limit_allowed(&self, strategy: &str, route: &str, domain: &str) {
-        self.rate_limit_allowed_total.add(
-            1,
-            &[
-                KeyValue::new(labels::STRATEGY, strategy.to_string()),
-                KeyValue::new(labels::ROUTE, route.to_string()),
-                KeyValue::new(labels::DOMAIN, domain.to_string()),
-            ],
-        );
+    pub fn record_rate_limit_allowed(&self, strategy: &'static str, route: &RouteAttributes) {
+        self.rate_limit_allowed_total
+            .add(1, &rate_limit_attributes(strategy, route));
     }
 
-    pub fn record_rate_limit_request(&self, strategy: &str, route: &str, domain: &str) {
-        self.rate_limit_requests_total.add(
-            1,
-            &[
-                KeyValue::new(labels::STRATEGY, strategy.to_string()),
-                KeyValue::new(labels::ROUTE, route.to_string()),
-                KeyValue::new(labels::DOMAIN, domain.to_string()),
-            ],
-        );
+    pub fn record_rate_limit_request(&self, strategy: &'static str, route: &RouteAttributes) {
+        self.rate_limit_requests_total
+            .add(1, &rate_limit_attributes(strategy, route));
+    }
+
+    /// `result` is one of the `values::CLUSTER_*` outcomes.
+    pub fn record_rate_limit_cluster_datagram(&self, result: &'static str) {
+        self.rate_limit_cluster_datagrams_total
+            .add(1, &[KeyValue::new(labels::RESULT, result)]);
+    }
+
+    pub fn record_rate_limit_cluster_debited(&self, requests: u64) {
+        self.rate_limit_cluster_debited_total.add(requests, &[]);
     }
 
-    pub fn record_headers_added(&self, count: u64, context: &str) {
+    pub fn record_headers_added(&self, count: u64, context: &'static str) {
         if count > 0 {
             self.headers_added_total
-                .add(count, &[KeyValue::new(labels::CONTEXT, context.to_string())]);
+                .add(count, &[KeyValue::new(labels::CONTEXT, context)]);
         }
     }
 
-    pub fn record_headers_removed(&self, count: u64, context: &str) {
+    pub fn record_headers_removed(&self, count: u64, context: &'static str) {
         if count > 0 {
             self.headers_removed_total
-                .add(count, &[KeyValue::new(labels::CONTEXT, context.to_string())]);
+                .add(count, &[KeyValue::new(labels::CONTEXT, context)]);
         }
     }
 
@@ -503,155 +696,172 @@ impl Metrics {
         self.ip_filter_denied_total.add(1, &[]);
     }
 
-    pub fn record_bytes_received(&self, bytes: u64, protocol: &str) {
+    /// Record the list sizes and compile time of a freshly built IP filter index (startup and
+    /// every successful reload).
+    pub fn record_ip_filter_index(&self, index: &IpFilterIndex) {
+        let entries = index.entries();
+        for (scope, count) in [
+            (values::SCOPE_GLOBAL, entries.global),
+            (values::SCOPE_DOMAIN, entries.domain),
+            (values::SCOPE_ROUTE, entries.route),
+        ] {
+            self.ip_filter_entries.record(
+                u64::try_from(count).unwrap_or(u64::MAX),
+                &[KeyValue::new(labels::SCOPE, scope)],
+            );
+        }
+        self.ip_filter_build_duration_seconds
+            .record(index.build_duration().as_secs_f64(), &[]);
+    }
+
+    pub fn record_bytes_received(&self, bytes: u64, protocol: &'static str) {
         if bytes > 0 {
             self.bytes_received_total
-                .add(bytes, &[KeyValue::new(labels::PROTOCOL, protocol.to_string())]);
+                .add(bytes, &[KeyValue::new(labels::PROTOCOL, protocol)]);
         }
     }
 
-    pub fn record_bytes_sent(&self, bytes: u64, protocol: &str) {
+    pub fn record_bytes_sent(&self, bytes: u64, protocol: &'static str) {
         if bytes > 0 {
             self.bytes_sent_total
-                .add(bytes, &[KeyValue::new(labels::PROTOCOL, protocol.to_string())]);
+                .add(bytes, &[KeyValue::new(labels::PROTOCOL, protocol)]);
         }
     }
 
+    /// `backend` is built by [`attributes::backend_address`].
     pub fn record_backend_bytes_received(
         &self,
         bytes: u64,
-        backend: &str,
-        route: &str,
-        domain: &str,
+        backend: &KeyValue,
+        route: &RouteAttributes,
     ) {
         if bytes > 0 {
-            self.backend_bytes_received_total.add(
-                bytes,
-                &[
-                    KeyValue::new(labels::BACKEND_ADDRESS, backend.to_string()),
-                    KeyValue::new(labels::ROUTE, route.to_string()),
-                    KeyValue::new(labels::DOMAIN, domain.to_string()),
-                ],
-            );
+            self.backend_bytes_received_total
+                .add(bytes, &[backend.clone(), route.route.clone(), route.domain.clone()]);
         }
     }
 
-    pub fn record_backend_bytes_sent(&self, bytes: u64, backend: &str, route: &str, domain: &str) {
+    pub fn record_backend_bytes_sent(
+        &self,
+        bytes: u64,
+        backend: &KeyValue,
+        route: &RouteAttributes,
+    ) {
         if bytes > 0 {
-            self.backend_bytes_sent_total.add(
-                bytes,
-                &[
-                    KeyValue::new(labels::BACKEND_ADDRESS, backend.to_string()),
-                    KeyValue::new(labels::ROUTE, route.to_string()),
-                    KeyValue::new(labels::DOMAIN, domain.to_string()),
-                ],
-            );
+            self.backend_bytes_sent_total
+                .add(bytes, &[backend.clone(), route.route.clone(), route.domain.clone()]);
         }
     }
 
-    pub fn record_backend_request(
+    /// One backend response: `backend_requests_total` and `backend_duration_seconds`, sharing one
+    /// attribute set.
+    pub fn record_backend_response(
         &self,
-        backend: &str,
+        duration: f64,
+        backend: &KeyValue,
         status_code: u16,
-        protocol: &str,
-        route: &str,
-        domain: &str,
+        request: &RequestAttributes,
+        route: &RouteAttributes,
     ) {
-        self.backend_requests_total.add(
-            1,
-            &[
-                KeyValue::new(labels::BACKEND_ADDRESS, backend.to_string()),
-                KeyValue::new(labels::STATUS_CODE, status_code.to_string()),
-                KeyValue::new(labels::PROTOCOL, protocol.to_string()),
-                KeyValue::new(labels::ROUTE, route.to_string()),
-                KeyValue::new(labels::DOMAIN, domain.to_string()),
-            ],
-        );
+        let attributes = [
+            backend.clone(),
+            attributes::status_code(status_code),
+            request.protocol.clone(),
+            route.route.clone(),
+            route.domain.clone(),
+        ];
+        self.backend_requests_total.add(1, &attributes);
+        self.backend_duration_seconds.record(duration, &attributes);
+    }
+
+    pub fn record_backend_in_flight(&self, backend: &KeyValue, delta: i64) {
+        self.backend_in_flight_requests
+            .add(delta, std::slice::from_ref(backend));
     }
 
-    pub fn record_backend_duration(
+    pub fn record_backend_latency_ewma(&self, ewma_seconds: f64, backend: &KeyValue) {
+        self.backend_latency_ewma_seconds
+            .record(ewma_seconds, std::slice::from_ref(backend));
+    }
+
+    pub fn record_backend_pool_warm_connections(
         &self,
-        duration: f64,
         backend: &str,
-        status_code: u16,
         protocol: &str,
-        route: &str,
-        domain: &str,
+        count: usize,
     ) {
-        self.backend_duration_seconds.record(
-            duration,
+        self.backend_pool_warm_connections.record(
+            u64::try_from(count).unwrap_or(u64::MAX),
             &[
                 KeyValue::new(labels::BACKEND_ADDRESS, backend.to_string()),
-                KeyValue::new(labels::STATUS_CODE, status_code.to_string()),
                 KeyValue::new(labels::PROTOCOL, protocol.to_string()),
-                KeyValue::new(labels::ROUTE, route.to_string()),
-                KeyValue::new(labels::DOMAIN, domain.to_string()),
             ],
         );
     }
 
-    pub fn record_backend_error(&self, backend: &str, error_type: &str, route: &str, domain: &str) {
-        self.backend_errors_total.add(
+    pub fn record_backend_pool_checkout(&self, backend: &str, protocol: &str, hit: bool) {
+        let result = if hit {
+            values::POOL_HIT
+        } else {
+            values::POOL_MISS
+        };
+        self.backend_pool_checkouts_total.add(
             1,
             &[
                 KeyValue::new(labels::BACKEND_ADDRESS, backend.to_string()),
-                KeyValue::new(labels::ERROR_TYPE, error_type.to_string()),
-                KeyValue::new(labels::ROUTE, route.to_string()),
-                KeyValue::new(labels::DOMAIN, domain.to_string()),
+                KeyValue::new(labels::PROTOCOL, protocol.to_string()),
+                KeyValue::new(labels::RESULT, result),
             ],
         );
     }
 
-    pub fn record_entrypoint_request(&self, method: &str, status_code: u16, protocol: &str) {
-        self.entrypoint_requests_total.add(
+    pub fn record_backend_error(
+        &self,
+        backend: &KeyValue,
+        error_type: &'static str,
+        route: &RouteAttributes,
+    ) {
+        self.backend_errors_total.add(
             1,
             &[
-                KeyValue::new(labels::METHOD, method.to_string()),
-                KeyValue::new(labels::STATUS_CODE, status_code.to_string()),
-                KeyValue::new(labels::PROTOCOL, protocol.to_string()),
+                backend.clone(),
+                KeyValue::new(labels::ERROR_TYPE, error_type),
+                route.route.clone(),
+                route.domain.clone(),
             ],
         );
     }
 
-    pub fn record_request(
-        &self,
-        method: &str,
-        status_code: u16,
-        protocol: &str,
-        route: &str,
-        domain: &str,
-    ) {
-        self.requests_total.add(
+    /// Every request reaching the entrypoint, routed or not.
+    pub fn record_entrypoint_request(&self, request: &RequestAttributes, status_code: u16) {
+        self.entrypoint_requests_total.add(
             1,
             &[
-                KeyValue::new(labels::METHOD, method.to_string()),
-                KeyValue::new(labels::STATUS_CODE, status_code.to_string()),
-                KeyValue::new(labels::PROTOCOL, protocol.to_string()),
-                KeyValue::new(labels::ROUTE, route.to_string()),
-                KeyValue::new(labels::DOMAIN, domain.to_string()),
+                request.method.clone(),
+                attributes::status_code(status_code),
+                request.protocol.clone(),
             ],
         );
     }
 
-    pub fn record_request_duration(
+    /// One routed request: `requests_total` and `requests_duration_seconds`, sharing one
+    /// attribute set.
+    pub fn record_request(
         &self,
         duration: f64,
-        method: &str,
         status_code: u16,
-        protocol: &str,
-        route: &str,
-        domain: &str,
+        request: &RequestAttributes,
+        route: &RouteAttributes,
     ) {
-        self.requests_duration_seconds.record(
-            duration,
-            &[
-                KeyValue::new(labels::METHOD, method.to_string()),
-                KeyValue::new(labels::STATUS_CODE, status_code.to_string()),
-                KeyValue::new(labels::PROTOCOL, protocol.to_string()),
-                KeyValue::new(labels::ROUTE, route.to_string()),
-                KeyValue::new(labels::DOMAIN, domain.to_string()),
-            ],
-        );
+        let attributes = [
+            request.method.clone(),
+            attributes::status_code(status_code),
+            request.protocol.clone(),
+            route.route.clone(),
+            route.domain.clone(),
+        ];
+        self.requests_total.add(1, &attributes);
+        self.requests_duration_seconds.record(duration, &attributes);
     }
 
     pub fn record_tls_handshake(&self, tls_version: &str, cipher_suite: &str, duration: f64) {
@@ -671,6 +881,27 @@ impl Metrics {
         );
     }
 
+    pub fn record_tls_session_resumption(&self, tls_version: &str, resumed: bool) {
+        let result = if resumed {
+            values::RESUMPTION_HIT
+        } else {
+            values::RESUMPTION_MISS
+        };
+        self.tls_session_resumptions_total.add(
+            1,
+            &[
+                KeyValue::new(labels::TLS_VERSION, tls_version.to_string()),
+                KeyValue::new(labels::RESULT, result),
+            ],
+        );
+    }
+
+    /// `result` is one of the `values::KTLS_*` outcomes.
+    pub fn record_tls_ktls_offload(&self, result: &'static str) {
+        self.tls_ktls_offload_total
+            .add(1, &[KeyValue::new(labels::RESULT, result)]);
+    }
+
     pub fn record_tls_connection_active(&self) {
         self.tls_connections_active.add(1, &[]);
     }
@@ -680,23 +911,23 @@ impl Metrics {
             .add(1, &[KeyValue::new(labels::PROTOCOL, protocol.to_string())]);
     }
 
-    pub fn record_error(&self, error_type: &str) {
+    pub fn record_error(&self, error_type: &'static str) {
         self.errors_total
-            .add(1, &[KeyValue::new(labels::ERROR_TYPE, error_type.to_string())]);
+            .add(1, &[KeyValue::new(labels::ERROR_TYPE, error_type)]);
     }
 
     pub fn record_tls_handshake_error(&self) {
         self.tls_handshake_errors_total.add(1, &[]);
     }
 
-    pub fn record_timeout(&self, timeout_type: &str) {
+    pub fn record_timeout(&self, timeout_type: &'static str) {
         self.timeouts_total
-            .add(1, &[KeyValue::new(labels::TIMEOUT_TYPE, timeout_type.to_string())]);
+            .add(1, &[KeyValue::new(labels::TIMEOUT_TYPE, timeout_type)]);
     }
 
-    pub fn record_backend_selection(&self, backend: &str) {
+    pub fn record_backend_selection(&self, backend: &Arc<str>) {
         self.backend_selections_total
-            .add(1, &[KeyValue::new(labels::BACKEND, backend.to_string())]);
+            .add(1, &[KeyValue::new(labels::BACKEND, Value::from(Arc::clone(backend)))]);
     }
 
     /// Record a successful config reload.
@@ -756,11 +987,64 @@ impl Metrics {
     /// `reason` is one of:
     /// - `"limit_exceeded"` active connection count hit `max_connections`
     /// - `"shutdown"`       proxy is shutting down
+    /// - `"per_ip_limit"`   the client IP already holds `max_connections_per_ip`
+    /// - `"scheduler_lag"`  the runtime is lagging past `max_scheduler_lag_ms`
     pub fn record_connection_rejected(&self, reason: &'static str) {
         self.connections_rejected_total
             .add(1, &[KeyValue::new(labels::REASON, reason)]);
     }
 
+    /// `runtime` is the probe's interned `runtime` attribute.
+    pub fn record_scheduler_lag(&self, seconds: f64, runtime: &KeyValue) {
+        self.scheduler_lag_seconds
+            .record(seconds, std::slice::from_ref(runtime));
+    }
+
+    /// Record a request shed by the route or backend (`scope`) adaptive limit.
+    pub fn record_request_shed(&self, scope: &'static str, route: &RouteAttributes) {
+        self.requests_shed_total.add(
+            1,
+            &[KeyValue::new(labels::SCOPE, scope), route.route.clone(), route.domain.clone()],
+        );
+    }
+
+    /// `attributes` are the limit's interned labels (scope plus route/domain or backend address).
+    pub fn record_concurrency_limit(&self, limit: u32, attributes: &[KeyValue]) {
+        self.concurrency_limit.record(u64::from(limit), attributes);
+    }
+
+    /// Record a response cache lookup (`result` is one of `values::CACHE_*`).
+    pub fn record_cache_lookup(&self, result: &'static str, route: &RouteAttributes) {
+        self.cache_requests_total.add(
+            1,
+            &[KeyValue::new(labels::RESULT, result), route.route.clone(), route.domain.clone()],
+        );
+    }
+
+    /// Record a response cache entry stored by `route` evicted to make room.
+    pub fn record_cache_eviction(&self, route: &RouteAttributes) {
+        self.cache_evictions_total
+            .add(1, &[route.route.clone(), route.domain.clone()]);
+    }
+
+    pub fn record_cache_size(&self, bytes: u64) {
+        self.cache_size_bytes.record(bytes, &[]);
+    }
+
+    /// Record a coalescable request (`result` is one of `values::COALESCE_*`).
+    pub fn record_coalesce(&self, result: &'static str, route: &RouteAttributes) {
+        self.coalesce_requests_total.add(
+            1,
+            &[KeyValue::new(labels::RESULT, result), route.route.clone(), route.domain.clone()],
+        );
+    }
+
+    /// Record the duration of one phase (a [`Phase`](super::timing::Phase) name).
+    pub fn record_phase(&self, phase: &'static str, seconds: f64) {
+        self.phase_duration_seconds
+            .record(seconds, &[KeyValue::new(labels::PHASE, phase)]);
+    }
+
     /// Record an HTTP/2 fingerprint extraction failure (HTTP/2 connection where
     /// the Akamai fingerprint could not be extracted, e.g. malformed frames).
     pub fn record_http2_fingerprint_failure(&self) {
@@ -781,17 +1065,38 @@ impl Metrics {
             .add(1, &[KeyValue::new(labels::HEADER, header)]);
     }
 
+    /// Record the number of fingerprint records waiting in the export queue.
+    pub fn record_fingerprint_export_queue_depth(&self, depth: u64) {
+        self.fingerprint_export_queue_depth.record(depth, &[]);
+    }
+
+    /// Record fingerprint records lost before export (`reason` is one of
+    /// `values::EXPORT_DROP_*`).
+    pub fn record_fingerprint_export_dropped(&self, reason: &'static str, records: u64) {
+        self.fingerprint_export_dropped_total
+            .add(records, &[KeyValue::new(labels::REASON, reason)]);
+    }
+
+    /// Record deduplicated fingerprint lines written to the export sink.
+    pub fn record_fingerprint_export_lines(&self, lines: u64) {
+        self.fingerprint_export_lines_total.add(lines, &[]);
+    }
+
     /// Record a TCP SYN fingerprint lookup result and its duration.
     ///
     /// `result` is one of:
     /// - `"hit"`       - fingerprint found and injected (`SynResult::Hit`)
     /// - `"miss"`      - no BPF map entry (keep-alive reuse, IPv6 peer, stale)
     /// - `"malformed"` - BPF map entry present but TCP options bytes were undecodable
-    pub fn record_tcp_syn_fingerprint(&self, result: &str, duration_secs: f64) {
-        let attrs = &[KeyValue::new(labels::REASON, result.to_string())];
-        self.tcp_syn_fingerprints_total.add(1, attrs);
+    ///
+    /// `mode` is the probe's lookup mode (`direct` or `coalesced`), a label of the duration
+    /// histogram only.
+    pub fn record_tcp_syn_fingerprint(&self, result: &str, mode: &'static str, duration_secs: f64) {
+        let reason = KeyValue::new(labels::REASON, result.to_string());
+        self.tcp_syn_fingerprints_total
+            .add(1, std::slice::from_ref(&reason));
         self.tcp_syn_fingerprint_duration_seconds
-            .record(duration_secs, attrs);
+            .record(duration_secs, &[reason, KeyValue::new(labels::MODE, mode)]);
         if result == "malformed" {
             self.tcp_syn_fingerprint_failures_total.add(1, &[]);
         }
@@ -827,6 +1132,14 @@ impl Metrics {
     }
 }
 
+fn rate_limit_attributes(strategy: &'static str, route: &RouteAttributes) -> [KeyValue; 3] {
+    [
+        KeyValue::new(labels::STRATEGY, strategy),
+        route.route.clone(),
+        route.domain.clone(),
+    ]
+}
+
 pub fn init_metrics() -> Result<(Arc<Metrics>, Registry), Box<dyn std::error::Error + Send + Sync>>
 {
     let registry = Registry::default();
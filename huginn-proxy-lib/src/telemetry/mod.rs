@@ -1,3 +1,6 @@
+pub mod attributes;
+pub mod debug;
+pub mod export;
 pub mod health;
 pub mod metrics;
 pub mod metrics_handler;
@@ -5,11 +8,16 @@ pub mod readiness;
 pub mod router;
 pub mod server;
 pub mod status;
+pub mod timing;
 pub mod tracing;
 
+pub use attributes::{RequestAttributes, RouteAttributes};
+pub use debug::DebugEndpoints;
+pub use export::{ExportTask, FingerprintExporter, FingerprintRecord};
 pub use health::{health_check_response, live_check_response, ready_check_response};
 pub use metrics::{init_metrics, values, Metrics};
 pub use metrics_handler::handle_metrics;
 pub use readiness::Readiness;
 pub use server::start_observability_server;
+pub use timing::{ConnectionTiming, Phase, RequestTiming, TimingPolicy};
 pub use tracing::{init_tracing_with_otel, init_validation_tracing, shutdown_tracing};
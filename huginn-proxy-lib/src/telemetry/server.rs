@@ -1,3 +1,4 @@
+use crate::telemetry::debug::{DebugEndpoints, DEBUG_PREFIX};
 use crate::telemetry::router::dispatch;
 use crate::telemetry::Readiness;
 use hyper::body::Incoming;
@@ -17,6 +18,7 @@ use tracing::{info, warn};
 /// - `/health` - Health check endpoint
 /// - `/ready` - Readiness check endpoint
 /// - `/live` - Liveness check endpoint
+/// - `/debug/...` - Profiling and runtime stats, when `debug` is set (see [`DebugEndpoints`])
 ///
 /// `readiness` is flipped to `true` by the proxy once its listeners are accepting
 /// connections and back to `false` during graceful shutdown; `/ready` reflects it.
@@ -24,8 +26,10 @@ pub async fn start_observability_server(
     port: u16,
     registry: Registry,
     readiness: Readiness,
+    debug: Option<DebugEndpoints>,
 ) -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
     let registry = Arc::new(registry);
+    let debug = debug.map(Arc::new);
     let addr = SocketAddr::from(([0, 0, 0, 0], port));
     let listener = TcpListener::bind(addr).await?;
 
@@ -57,16 +61,21 @@ pub async fn start_observability_server(
 
                 let registry = registry.clone();
                 let readiness = readiness.clone();
+                let debug = debug.clone();
                 tokio::spawn(async move {
                     let svc = hyper::service::service_fn(move |req: Request<Incoming>| {
                         let registry = registry.clone();
                         let readiness = readiness.clone();
+                        let debug = debug.clone();
                         async move {
-                            Ok::<_, hyper::Error>(dispatch(
-                                req.uri().path(),
-                                &registry,
-                                &readiness,
-                            ))
+                            let path = req.uri().path();
+                            let response = match debug.as_deref() {
+                                Some(debug) if path.starts_with(DEBUG_PREFIX) => {
+                                    debug.handle(path, req.uri().query(), req.headers()).await
+                                }
+                                _ => dispatch(path, &registry, &readiness),
+                            };
+                            Ok::<_, hyper::Error>(response)
                         }
                     });
 
@@ -8,6 +8,8 @@ pub(crate) enum Status {
     Ready,
     NotReady,
     NotFound,
+    Unauthorized,
+    BadRequest,
     Error,
 }
 
@@ -0,0 +1,259 @@
+//! Per-phase latency of connections and requests (`[telemetry.timing]`).
+//!
+//! A connection times the phases before its first request (PROXY header, SYN lookup, TLS), and
+//! each request marks its own phases as it passes through the handler: each mark closes the
+//! phase that ran since the previous one. Every phase is recorded in
+//! `huginn_phase_duration_seconds`. One request's breakdown, together with its connection's
+//! phases on the first request of a connection, can also be returned to trusted clients in a
+//! `Server-Timing` header and logged when the request is slow.
+
+use std::fmt::Write;
+use std::net::IpAddr;
+use std::sync::atomic::{AtomicBool, AtomicU64, Ordering};
+use std::sync::Arc;
+
+use http::{HeaderMap, HeaderName, HeaderValue};
+use ipnet::IpNet;
+use tokio::time::{Duration, Instant};
+
+use super::tracing::log_slow_request;
+use super::Metrics;
+use crate::config::TimingConfig;
+
+pub const SERVER_TIMING: HeaderName = HeaderName::from_static("server-timing");
+
+const PHASES: usize = 10;
+
+/// One timed step. The order is the order a request goes through them; the name is both the
+/// `phase` metric label and the `Server-Timing` metric name.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum Phase {
+    /// Reading the PROXY protocol header (`resolve_peer`). On TLS listeners this includes any
+    /// ClientHello bytes that arrive in the same reads.
+    ProxyProtocol,
+    /// The eBPF SYN fingerprint lookup.
+    SynProbe,
+    /// Reading the ClientHello and computing JA4.
+    ClientHello,
+    /// The rest of the TLS handshake (rustls accept, kTLS setup).
+    TlsAccept,
+    /// Host and route lookup, SNI and IP filter checks.
+    Routing,
+    RateLimit,
+    /// Response cache lookup (routes with `cache`).
+    Cache,
+    /// Backend selection and request header rewriting.
+    Prepare,
+    /// Waiting for another request's response (routes with `coalesce`).
+    Coalesce,
+    /// Concurrency permit, backend connect and time to the response head.
+    Upstream,
+}
+
+impl Phase {
+    const ALL: [Self; PHASES] = [
+        Self::ProxyProtocol,
+        Self::SynProbe,
+        Self::ClientHello,
+        Self::TlsAccept,
+        Self::Routing,
+        Self::RateLimit,
+        Self::Cache,
+        Self::Prepare,
+        Self::Coalesce,
+        Self::Upstream,
+    ];
+
+    pub const fn name(self) -> &'static str {
+        match self {
+            Self::ProxyProtocol => "proxy_protocol",
+            Self::SynProbe => "syn_probe",
+            Self::ClientHello => "client_hello",
+            Self::TlsAccept => "tls_accept",
+            Self::Routing => "routing",
+            Self::RateLimit => "rate_limit",
+            Self::Cache => "cache",
+            Self::Prepare => "prepare",
+            Self::Coalesce => "coalesce",
+            Self::Upstream => "upstream",
+        }
+    }
+}
+
+/// Durations of the phases that ran, indexed by [`Phase`].
+#[derive(Debug, Clone, Copy, Default, PartialEq)]
+pub struct Timings([Option<Duration>; PHASES]);
+
+impl Timings {
+    /// Set `phase` and record it in `huginn_phase_duration_seconds`.
+    pub fn record(&mut self, phase: Phase, duration: Duration, metrics: &Metrics) {
+        self.0[phase as usize] = Some(duration);
+        metrics.record_phase(phase.name(), duration.as_secs_f64());
+    }
+
+    pub fn get(&self, phase: Phase) -> Option<Duration> {
+        self.0[phase as usize]
+    }
+
+    fn iter(&self) -> impl Iterator<Item = (Phase, Duration)> + '_ {
+        Phase::ALL
+            .into_iter()
+            .filter_map(|phase| self.get(phase).map(|duration| (phase, duration)))
+    }
+}
+
+/// Process-wide `[telemetry.timing]` settings, plus the slow-request sampling counter.
+#[derive(Debug)]
+pub struct TimingPolicy {
+    server_timing_cidrs: Vec<IpNet>,
+    slow_request: Option<Duration>,
+    sample: u64,
+    slow_requests: AtomicU64,
+}
+
+impl TimingPolicy {
+    pub fn new(config: &TimingConfig) -> Self {
+        Self {
+            server_timing_cidrs: config.server_timing_cidrs.clone(),
+            slow_request: (config.slow_request_ms > 0)
+                .then(|| Duration::from_millis(config.slow_request_ms)),
+            sample: config.slow_request_sample,
+            slow_requests: AtomicU64::new(0),
+        }
+    }
+
+    /// Whether responses to `client` carry a `Server-Timing` header.
+    pub fn server_timing(&self, client: IpAddr) -> bool {
+        self.server_timing_cidrs
+            .iter()
+            .any(|net| net.contains(&client))
+    }
+
+    /// Whether a request that took `total` is slow and its turn in the sample.
+    fn sample_slow(&self, total: Duration) -> bool {
+        self.slow_request.is_some_and(|slow| total >= slow)
+            && self
+                .slow_requests
+                .fetch_add(1, Ordering::Relaxed)
+                .checked_rem(self.sample)
+                == Some(0)
+    }
+}
+
+impl Default for TimingPolicy {
+    fn default() -> Self {
+        Self::new(&TimingConfig::default())
+    }
+}
+
+/// Phases of one client connection, shared by the requests it carries.
+#[derive(Debug)]
+pub struct ConnectionTiming {
+    policy: Arc<TimingPolicy>,
+    /// The policy's verdict for this connection's client, computed once.
+    server_timing: bool,
+    phases: Timings,
+    /// Set once a request has reported the connection phases; only the first one does.
+    reported: AtomicBool,
+}
+
+impl ConnectionTiming {
+    pub fn new(policy: Arc<TimingPolicy>, client: IpAddr) -> Self {
+        let server_timing = policy.server_timing(client);
+        Self {
+            policy,
+            server_timing,
+            phases: Timings::default(),
+            reported: AtomicBool::new(false),
+        }
+    }
+
+    pub fn record(&mut self, phase: Phase, duration: Duration, metrics: &Metrics) {
+        self.phases.record(phase, duration, metrics);
+    }
+
+    pub fn phases(&self) -> &Timings {
+        &self.phases
+    }
+
+    /// Start timing a request that arrived at `start`.
+    pub fn request(&self, start: Instant) -> RequestTiming<'_> {
+        let first = !self.reported.swap(true, Ordering::Relaxed);
+        RequestTiming {
+            connection: self,
+            connection_phases: first.then_some(&self.phases),
+            last: start,
+            start,
+            phases: Timings::default(),
+        }
+    }
+}
+
+/// Phases of one request, closed by [`RequestTiming::mark`] as the handler passes them.
+pub struct RequestTiming<'a> {
+    connection: &'a ConnectionTiming,
+    /// The connection's phases, reported with the first request of the connection only.
+    connection_phases: Option<&'a Timings>,
+    start: Instant,
+    /// End of the last marked phase.
+    last: Instant,
+    phases: Timings,
+}
+
+impl RequestTiming<'_> {
+    /// Close `phase`: it ran from the previous mark (or the request start) until now.
+    pub fn mark(&mut self, phase: Phase, metrics: &Metrics) {
+        let now = Instant::now();
+        self.phases
+            .record(phase, now.saturating_duration_since(self.last), metrics);
+        self.last = now;
+    }
+
+    pub fn phases(&self) -> &Timings {
+        &self.phases
+    }
+
+    /// `Server-Timing` value of the request: the connection phases (first request only), the
+    /// request phases, and `total`, in milliseconds.
+    pub fn server_timing(&self, total: Duration) -> String {
+        let mut value = String::new();
+        let connection = self.connection_phases.into_iter().flat_map(Timings::iter);
+        for (name, duration) in connection
+            .chain(self.phases.iter())
+            .map(|(phase, duration)| (phase.name(), duration))
+            .chain([("total", total)])
+        {
+            if !value.is_empty() {
+                value.push_str(", ");
+            }
+            let _ = write!(value, "{name};dur={:.3}", duration.as_secs_f64() * 1000.0);
+        }
+        value
+    }
+
+    /// End the request: add `Server-Timing` to `response` (when there is one and the client is
+    /// trusted), and log the breakdown when the request is slow.
+    pub fn finish(
+        &self,
+        response: Option<&mut HeaderMap>,
+        status_code: u16,
+        route: &str,
+        domain: &str,
+    ) {
+        let total = self.start.elapsed();
+        let slow = self.connection.policy.sample_slow(total);
+        let headers = response.filter(|_| self.connection.server_timing);
+        if !slow && headers.is_none() {
+            return;
+        }
+        let value = self.server_timing(total);
+        if slow {
+            log_slow_request(total, &value, status_code, route, domain);
+        }
+        if let Some(headers) = headers {
+            if let Ok(value) = HeaderValue::try_from(value) {
+                headers.insert(SERVER_TIMING, value);
+            }
+        }
+    }
+}
@@ -1,6 +1,32 @@
+use tokio::time::Duration;
+use tracing::warn;
 use tracing_subscriber::layer::SubscriberExt;
 use tracing_subscriber::Registry;
 
+/// Target of slow-request events, so they can be filtered on their own (e.g.
+/// `RUST_LOG=info,huginn_proxy::slow_request=off`).
+pub const SLOW_REQUEST_TARGET: &str = "huginn_proxy::slow_request";
+
+/// Log one sampled slow request (`[telemetry.timing].slow_request_ms`) with its phase breakdown,
+/// in the `Server-Timing` format the client would see.
+pub fn log_slow_request(
+    total: Duration,
+    phases: &str,
+    status_code: u16,
+    route: &str,
+    domain: &str,
+) {
+    warn!(
+        target: SLOW_REQUEST_TARGET,
+        duration_ms = u64::try_from(total.as_millis()).unwrap_or(u64::MAX),
+        status_code,
+        route,
+        domain,
+        phases,
+        "Slow request"
+    );
+}
+
 /// Initialize warning-level tracing for one-shot CLI validation.
 ///
 /// Diagnostics go to stderr so stdout remains valid machine-readable output when printing the
@@ -15,7 +15,11 @@ use crate::tls::cipher_suites::{
     is_cipher_suite_supported, resolve_cipher_suites, supported_cipher_suites,
 };
 use crate::tls::curves::{is_curve_supported, supported_curves};
-use crate::tls::session_resumption::configure_session_resumption;
+use crate::tls::session_cache::SharedSessionCache;
+use crate::tls::session_resumption::{
+    configure_session_resumption, configure_shared_session_resumption,
+};
+use crate::tls::ticket_keys::SharedTicketer;
 
 /// Loads CA certificates from a PEM file for client authentication
 fn load_ca_certs(path: &str) -> Result<Vec<CertificateDer<'static>>> {
@@ -31,12 +35,17 @@ fn load_ca_certs(path: &str) -> Result<Vec<CertificateDer<'static>>> {
 ///
 /// Cipher suites, ALPN, client auth, and session resumption are all applied here; cert
 /// provisioning is delegated to the resolver (populated via `DynamicCertResolver::update`).
+/// `ticketer` carries the shared ticket keys; it is kept by the caller so key rotation can
+/// reach it without rebuilding the config. `session_cache` is the shared TLS 1.2 session
+/// store, which the accept path prefetches into before the handshake.
 pub fn build_server_config_with_resolver(
     resolver: Arc<dyn ResolvesServerCert>,
     alpn: &[String],
     options: &TlsOptions,
     client_auth: &ClientAuth,
     session_resumption: &crate::config::SessionResumptionConfig,
+    ticketer: Option<Arc<SharedTicketer>>,
+    session_cache: Option<Arc<SharedSessionCache>>,
 ) -> Result<TlsAcceptor> {
     validate_tls_options(options)?;
 
@@ -77,6 +86,10 @@ pub fn build_server_config_with_resolver(
     }
 
     configure_session_resumption(&mut server, session_resumption);
+    configure_shared_session_resumption(&mut server, session_resumption, ticketer, session_cache);
+
+    // Connections accepted with secret extraction enabled are offloaded to kernel TLS.
+    server.enable_secret_extraction = options.ktls && cfg!(target_os = "linux");
 
     Ok(TlsAcceptor::from(Arc::new(server)))
 }
@@ -9,19 +9,23 @@ use tokio_rustls::rustls::sign::CertifiedKey;
 use crate::config::Domain;
 use crate::error::{ProxyError, Result};
 use crate::telemetry::Metrics;
-use crate::tls::cert_source::{cert_chain_hash, read_certs_and_keys};
+use crate::tls::cert_source::{cert_chain_hash, CertFiles};
 use tracing::{info, warn};
 
 /// Outcome of a [`DynamicCertResolver::update`] call.
 ///
 /// `update()` is best-effort per-domain: it always performs the atomic swap and
-/// loads as many certs as it can. `loaded` counts domains whose cert went live
-/// in this call; `failed` counts domains whose cert could not be loaded (those
-/// keep their previously serving cert, if any). `failed > 0` is a *partial* reload.
+/// loads as many certs as it can. `loaded` counts domains whose cert was built
+/// from its files and went live in this call; `failed` counts domains whose cert
+/// could not be loaded (those keep their previously serving cert, if any).
+/// `failed > 0` is a *partial* reload.
+/// `reused` counts domains whose cert and key files were unchanged, so the cert
+/// already in service was kept without parsing them again.
 #[derive(Debug, Default, Clone, Copy, PartialEq, Eq)]
 pub struct CertReloadReport {
     pub loaded: usize,
     pub failed: usize,
+    pub reused: usize,
 }
 
 impl CertReloadReport {
@@ -62,6 +66,17 @@ struct CertMap {
     /// disables this fallback so those connections are rejected (rustls sends
     /// `unrecognized_name`), equivalent to Traefik `sniStrict: true`.
     default: Option<Arc<CertifiedKey>>,
+    /// Every cert in the map by its `(cert_path, key_path)`, for reuse on the next update.
+    sources: HashMap<(String, String), LoadedCert>,
+}
+
+/// A cert built from a cert/key file pair.
+#[derive(Clone)]
+struct LoadedCert {
+    /// [`CertFiles::content_hash`] of the files it was built from.
+    files_hash: u64,
+    key: Arc<CertifiedKey>,
+    cert_hash: u64,
 }
 
 impl CertMap {
@@ -128,6 +143,9 @@ impl DynamicCertResolver {
 
     /// Reload cert maps from `domains`. Domains without `cert_path`/`key_path` are skipped.
     ///
+    /// Every cert and key file is read, but a pair whose paths and content hash match the cert
+    /// in service is not parsed again: that cert is kept and counted as `reused`.
+    ///
     /// Best-effort, per-domain: a domain whose cert fails to load does **not** abort the
     /// reload. The atomic swap always runs with every cert that loaded successfully, and a
     /// failing domain keeps its *previously serving* cert (carried over from the old map) so
@@ -142,9 +160,10 @@ impl DynamicCertResolver {
     pub async fn update(&self, domains: &[Domain], metrics: &Metrics) -> CertReloadReport {
         let old = self.inner.load();
         let mut next = CertMap::default();
-        // Buffered until after the swap; (host, cert_hash) per successfully loaded cert.
-        let mut loaded: Vec<(String, u64)> = Vec::new();
+        // Buffered until after the swap; (host, cert_hash) per cert loaded or reused.
+        let mut live: Vec<(String, u64)> = Vec::new();
         let mut failed: usize = 0;
+        let mut reused: usize = 0;
 
         for domain in domains {
             // Label for metrics/logs; the catch-all domain has no host string.
@@ -161,10 +180,15 @@ impl DynamicCertResolver {
             };
 
             let slot = classify(domain.host.as_deref());
-            match load_certified_key(cert_path, key_path, host).await {
-                Ok((certified_key, cert_hash)) => {
-                    next.place(&slot, certified_key);
-                    loaded.push((host.to_string(), cert_hash));
+            let source = (cert_path.to_string(), key_path.to_string());
+            match load_certified_key(&source, old.sources.get(&source), host).await {
+                Ok((cert, fresh)) => {
+                    next.place(&slot, Arc::clone(&cert.key));
+                    live.push((host.to_string(), cert.cert_hash));
+                    if !fresh {
+                        reused = reused.saturating_add(1);
+                    }
+                    next.sources.insert(source, cert);
                 }
                 Err(e) => {
                     metrics.record_tls_cert_reload_error(host);
@@ -188,11 +212,11 @@ impl DynamicCertResolver {
 
         // Emit success metrics only now that the new map is live, so the gauges
         // never advertise a cert that didn't actually go into service.
-        for (host, cert_hash) in &loaded {
+        for (host, cert_hash) in &live {
             metrics.record_tls_cert_reload_success(host, *cert_hash);
         }
 
-        CertReloadReport { loaded: loaded.len(), failed }
+        CertReloadReport { loaded: live.len().saturating_sub(reused), failed, reused }
     }
 
     /// Core SNI → cert resolution. Separated from [`ResolvesServerCert::resolve`]
@@ -262,16 +286,23 @@ impl ResolvesServerCert for DynamicCertResolver {
     }
 }
 
-/// Read a cert/key pair from disk and build a `(CertifiedKey, chain_hash)`.
+/// Read a cert/key pair from disk and build its [`LoadedCert`], or return `previous` (and
+/// `false`) when the files' content is what it was built from.
 ///
 /// `host` is used only to label the signing-key error. Errors are returned, not
 /// recorded as metrics, so the caller decides how to treat the failure.
 async fn load_certified_key(
-    cert_path: &str,
-    key_path: &str,
+    (cert_path, key_path): &(String, String),
+    previous: Option<&LoadedCert>,
     host: &str,
-) -> Result<(Arc<CertifiedKey>, u64)> {
-    let certs_keys = read_certs_and_keys(Path::new(cert_path), Path::new(key_path)).await?;
+) -> Result<(LoadedCert, bool)> {
+    let files = CertFiles::read(Path::new(cert_path), Path::new(key_path)).await?;
+    let files_hash = files.content_hash();
+    if let Some(previous) = previous.filter(|p| p.files_hash == files_hash) {
+        return Ok((previous.clone(), false));
+    }
+
+    let certs_keys = files.parse()?;
     let signing_key =
         tokio_rustls::rustls::crypto::aws_lc_rs::sign::any_supported_type(&certs_keys.key)
             .map_err(|e| {
@@ -297,5 +328,5 @@ async fn load_certified_key(
         }
     }
 
-    Ok((certified_key, cert_hash))
+    Ok((LoadedCert { files_hash, key: certified_key, cert_hash }, true))
 }
@@ -37,50 +37,71 @@ pub fn cert_chain_hash(certs: &[CertificateDer<'static>]) -> u64 {
     hasher.finish()
 }
 
-/// Read the certificate and private key from the disk.
+/// Raw PEM contents of a certificate chain and private key file pair.
 ///
-/// Used by [`DynamicCertResolver`](crate::tls::cert_resolver::DynamicCertResolver)
-/// to load each domain's cert material during startup and hot-reload.
-pub(crate) async fn read_certs_and_keys(
-    cert_path: &Path,
-    key_path: &Path,
-) -> Result<ServerCertsKeys, ProxyError> {
-    debug!("Reading TLS server certificates and private key");
+/// Read on every reload; [`Self::content_hash`] lets
+/// [`DynamicCertResolver`](crate::tls::cert_resolver::DynamicCertResolver) skip parsing and
+/// signing-key setup for a pair whose files did not change.
+pub(crate) struct CertFiles {
+    cert: Vec<u8>,
+    key: Vec<u8>,
+}
 
-    let cert_bytes = fs::read(cert_path).await.map_err(|e| {
-        ProxyError::Tls(format!("Unable to load the certificates [{}]: {e}", cert_path.display()))
-    })?;
+impl CertFiles {
+    /// Read the certificate and private key from the disk.
+    pub(crate) async fn read(cert_path: &Path, key_path: &Path) -> Result<Self, ProxyError> {
+        debug!("Reading TLS server certificates and private key");
 
-    let certs: Vec<CertificateDer<'static>> = CertificateDer::pem_slice_iter(&cert_bytes)
-        .collect::<Result<Vec<_>, rustls_pki_types::pem::Error>>()
-        .map_err(|e| ProxyError::Tls(format!("Unable to parse the certificates: {e}")))?
-        .into_iter()
-        .map(|c| c.into_owned())
-        .collect();
+        let cert = fs::read(cert_path).await.map_err(|e| {
+            ProxyError::Tls(format!(
+                "Unable to load the certificates [{}]: {e}",
+                cert_path.display()
+            ))
+        })?;
+        let key = fs::read(key_path).await.map_err(|e| {
+            ProxyError::Tls(format!(
+                "Unable to load the certificate keys [{}]: {e}",
+                key_path.display()
+            ))
+        })?;
+        Ok(Self { cert, key })
+    }
 
-    if certs.is_empty() {
-        return Err(ProxyError::Tls("No certificates found".to_string()));
+    /// Hash of both files' bytes.
+    pub(crate) fn content_hash(&self) -> u64 {
+        use std::collections::hash_map::DefaultHasher;
+        let mut hasher = DefaultHasher::new();
+        self.cert.hash(&mut hasher);
+        self.key.hash(&mut hasher);
+        hasher.finish()
     }
 
-    let key_bytes = fs::read(key_path).await.map_err(|e| {
-        ProxyError::Tls(format!(
-            "Unable to load the certificate keys [{}]: {e}",
-            key_path.display()
-        ))
-    })?;
+    /// Parse the certificate chain and the (last) private key.
+    pub(crate) fn parse(&self) -> Result<ServerCertsKeys, ProxyError> {
+        let certs: Vec<CertificateDer<'static>> = CertificateDer::pem_slice_iter(&self.cert)
+            .collect::<Result<Vec<_>, rustls_pki_types::pem::Error>>()
+            .map_err(|e| ProxyError::Tls(format!("Unable to parse the certificates: {e}")))?
+            .into_iter()
+            .map(|c| c.into_owned())
+            .collect();
 
-    let mut keys: Vec<PrivateKeyDer<'static>> = PrivateKeyDer::pem_slice_iter(&key_bytes)
-        .collect::<Result<Vec<_>, rustls_pki_types::pem::Error>>()
-        .map_err(|e| ProxyError::Tls(format!("Unable to parse the private keys: {e}")))?
-        .into_iter()
-        .map(|k| k.clone_key())
-        .collect();
+        if certs.is_empty() {
+            return Err(ProxyError::Tls("No certificates found".to_string()));
+        }
 
-    let key = keys.pop().ok_or_else(|| {
-        ProxyError::Tls(
-            "No private keys found - Make sure they are in PKCS#8/PEM format".to_string(),
-        )
-    })?;
+        let mut keys: Vec<PrivateKeyDer<'static>> = PrivateKeyDer::pem_slice_iter(&self.key)
+            .collect::<Result<Vec<_>, rustls_pki_types::pem::Error>>()
+            .map_err(|e| ProxyError::Tls(format!("Unable to parse the private keys: {e}")))?
+            .into_iter()
+            .map(|k| k.clone_key())
+            .collect();
 
-    Ok(ServerCertsKeys { certs, key })
+        let key = keys.pop().ok_or_else(|| {
+            ProxyError::Tls(
+                "No private keys found - Make sure they are in PKCS#8/PEM format".to_string(),
+            )
+        })?;
+
+        Ok(ServerCertsKeys { certs, key })
+    }
 }
@@ -0,0 +1,500 @@
+use std::io::{self, Read};
+use std::pin::Pin;
+use std::task::{Context, Poll};
+
+use tokio::io::{AsyncRead, AsyncReadExt, AsyncWrite, AsyncWriteExt, ReadBuf};
+use tokio::net::TcpStream;
+use tokio_rustls::rustls::ServerConnection;
+use tokio_rustls::server::TlsStream;
+use tokio_rustls::TlsAcceptor;
+
+use crate::telemetry::values;
+
+/// TLS record header: 1 content type + 2 version + 2 length
+const RECORD_HEADER_LEN: usize = 5;
+
+/// Length of the leading run of complete TLS records in `bytes`.
+///
+/// Bytes already read from the socket before a kTLS handshake are split here: complete records
+/// go to rustls, the partial tail is finished by [`finish_handshake`].
+pub fn complete_records_len(bytes: &[u8]) -> usize {
+    let mut offset = 0usize;
+    while let Some(header) = bytes.get(offset..offset.saturating_add(RECORD_HEADER_LEN)) {
+        let len = u16::from_be_bytes([header[3], header[4]]) as usize;
+        let end = offset.saturating_add(RECORD_HEADER_LEN).saturating_add(len);
+        if end > bytes.len() {
+            break;
+        }
+        offset = end;
+    }
+    offset
+}
+
+/// Complete a handshake reading exactly one TLS record at a time, then wrap the session in a
+/// regular `TlsStream`.
+///
+/// tokio-rustls keeps reading while rustls wants data, so a handshake it drives can leave the
+/// start of the client's first application record inside rustls, where the kernel never sees it.
+/// Here nothing past the record that completes the handshake is read, so every later byte is
+/// still on the socket when the keys are handed to the kernel by [`offload`]. `pending` holds the
+/// partial record already read, if any.
+pub async fn finish_handshake(
+    acceptor: &TlsAcceptor,
+    mut stream: TcpStream,
+    mut conn: ServerConnection,
+    mut pending: Vec<u8>,
+) -> io::Result<TlsStream<TcpStream>> {
+    loop {
+        flush_tls(&mut stream, &mut conn).await?;
+        if !conn.is_handshaking() {
+            break;
+        }
+        read_record(&mut stream, &mut pending).await?;
+        let mut record = pending.as_slice();
+        while !record.is_empty() {
+            if conn.read_tls(&mut record)? == 0 {
+                break;
+            }
+        }
+        if let Err(e) = conn.process_new_packets() {
+            // Send the alert rustls queued for the failure.
+            let _ = flush_tls(&mut stream, &mut conn).await;
+            return Err(io::Error::new(io::ErrorKind::InvalidData, e));
+        }
+        pending.clear();
+    }
+    // The handshake is over, so the acceptor only adopts the session (nothing left to flush).
+    acceptor
+        .accept_with(stream, move |fresh| *fresh = conn)
+        .await
+}
+
+async fn flush_tls(stream: &mut TcpStream, conn: &mut ServerConnection) -> io::Result<()> {
+    let mut out = Vec::new();
+    while conn.wants_write() {
+        conn.write_tls(&mut out)?;
+    }
+    if !out.is_empty() {
+        stream.write_all(&out).await?;
+    }
+    Ok(())
+}
+
+/// Grow `record` (empty, or a partial record) to exactly one complete record.
+async fn read_record(stream: &mut TcpStream, record: &mut Vec<u8>) -> io::Result<()> {
+    let have = record.len();
+    if have < RECORD_HEADER_LEN {
+        record.resize(RECORD_HEADER_LEN, 0);
+        stream.read_exact(&mut record[have..]).await?;
+    }
+    let len = u16::from_be_bytes([record[3], record[4]]) as usize;
+    let total = RECORD_HEADER_LEN.saturating_add(len);
+    let have = record.len();
+    if have < total {
+        record.resize(total, 0);
+        stream.read_exact(&mut record[have..]).await?;
+    }
+    Ok(())
+}
+
+/// Client connection after the handshake: records processed by rustls, or by the kernel.
+// Not boxed: the rustls variant is what most connections use, and it was held inline before.
+#[allow(clippy::large_enum_variant)]
+pub enum ClientTlsStream {
+    Rustls(TlsStream<TcpStream>),
+    #[cfg(target_os = "linux")]
+    Kernel(kernel::KtlsStream),
+}
+
+/// Outcome of [`offload`]: the stream to serve, and the `huginn_tls_ktls_offload_total` result.
+pub struct Offload {
+    pub stream: ClientTlsStream,
+    pub result: &'static str,
+}
+
+/// Hand the record layer of an established session to the kernel (kTLS).
+///
+/// Falls back to rustls, with the reason as `result`, when the kernel has no `tls` ULP or
+/// lacks the negotiated cipher; those checks happen before the secrets are extracted. Once
+/// they are, rustls can no longer serve the connection, so a later failure is an error and the
+/// connection is closed.
+pub fn offload(tls: TlsStream<TcpStream>) -> io::Result<Offload> {
+    #[cfg(target_os = "linux")]
+    {
+        kernel::offload(tls)
+    }
+    #[cfg(not(target_os = "linux"))]
+    {
+        Ok(Offload { stream: ClientTlsStream::Rustls(tls), result: values::KTLS_UNAVAILABLE })
+    }
+}
+
+/// Plaintext rustls decrypted before the handoff; served before the first socket read.
+fn take_plaintext(conn: &mut ServerConnection) -> io::Result<Vec<u8>> {
+    let mut plaintext = Vec::new();
+    match conn.reader().read_to_end(&mut plaintext) {
+        Ok(_) => Ok(plaintext),
+        Err(e) if e.kind() == io::ErrorKind::WouldBlock => Ok(plaintext),
+        Err(e) => Err(e),
+    }
+}
+
+impl AsyncRead for ClientTlsStream {
+    fn poll_read(
+        self: Pin<&mut Self>,
+        cx: &mut Context<'_>,
+        buf: &mut ReadBuf<'_>,
+    ) -> Poll<io::Result<()>> {
+        match self.get_mut() {
+            Self::Rustls(stream) => Pin::new(stream).poll_read(cx, buf),
+            #[cfg(target_os = "linux")]
+            Self::Kernel(stream) => Pin::new(stream).poll_read(cx, buf),
+        }
+    }
+}
+
+impl AsyncWrite for ClientTlsStream {
+    fn poll_write(
+        self: Pin<&mut Self>,
+        cx: &mut Context<'_>,
+        data: &[u8],
+    ) -> Poll<io::Result<usize>> {
+        match self.get_mut() {
+            Self::Rustls(stream) => Pin::new(stream).poll_write(cx, data),
+            #[cfg(target_os = "linux")]
+            Self::Kernel(stream) => Pin::new(stream).poll_write(cx, data),
+        }
+    }
+
+    fn poll_write_vectored(
+        self: Pin<&mut Self>,
+        cx: &mut Context<'_>,
+        bufs: &[io::IoSlice<'_>],
+    ) -> Poll<io::Result<usize>> {
+        match self.get_mut() {
+            Self::Rustls(stream) => Pin::new(stream).poll_write_vectored(cx, bufs),
+            #[cfg(target_os = "linux")]
+            Self::Kernel(stream) => Pin::new(stream).poll_write_vectored(cx, bufs),
+        }
+    }
+
+    fn is_write_vectored(&self) -> bool {
+        match self {
+            Self::Rustls(stream) => stream.is_write_vectored(),
+            #[cfg(target_os = "linux")]
+            Self::Kernel(stream) => stream.is_write_vectored(),
+        }
+    }
+
+    fn poll_flush(self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<io::Result<()>> {
+        match self.get_mut() {
+            Self::Rustls(stream) => Pin::new(stream).poll_flush(cx),
+            #[cfg(target_os = "linux")]
+            Self::Kernel(stream) => Pin::new(stream).poll_flush(cx),
+        }
+    }
+
+    fn poll_shutdown(self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<io::Result<()>> {
+        match self.get_mut() {
+            Self::Rustls(stream) => Pin::new(stream).poll_shutdown(cx),
+            #[cfg(target_os = "linux")]
+            Self::Kernel(stream) => Pin::new(stream).poll_shutdown(cx),
+        }
+    }
+}
+
+#[cfg(target_os = "linux")]
+mod kernel {
+    use std::io::{self, IoSliceMut};
+    use std::os::fd::AsRawFd;
+    use std::pin::Pin;
+    use std::sync::atomic::{AtomicBool, Ordering};
+    use std::task::{ready, Context, Poll};
+
+    use nix::errno::Errno;
+    use nix::sys::socket::sockopt::{TcpTlsRx, TcpTlsTx, TcpUlp, TlsCryptoInfo};
+    use nix::sys::socket::{recvmsg, setsockopt, ControlMessageOwned, MsgFlags, TlsGetRecordType};
+    use tokio::io::{AsyncRead, AsyncWrite, Interest, ReadBuf};
+    use tokio::net::TcpStream;
+    use tokio_rustls::rustls::{CipherSuite, ConnectionTrafficSecrets, ProtocolVersion};
+    use tokio_rustls::server::TlsStream;
+
+    use super::{take_plaintext, values, ClientTlsStream, Offload};
+
+    /// Alert description of a graceful `close_notify`
+    const ALERT_CLOSE_NOTIFY: u8 = 0;
+    /// Room for the single `TLS_GET_RECORD_TYPE` control message
+    const CMSG_BUFFER_LEN: usize = 64;
+
+    /// The kernel has no `tls` ULP (module not loaded or not built); checked once per process.
+    static ULP_UNAVAILABLE: AtomicBool = AtomicBool::new(false);
+    /// Ciphers the kernel refused, indexed by [`Cipher`]; those connections stay on rustls.
+    static CIPHER_UNSUPPORTED: [AtomicBool; 3] =
+        [AtomicBool::new(false), AtomicBool::new(false), AtomicBool::new(false)];
+
+    #[derive(Clone, Copy)]
+    enum Cipher {
+        Aes128Gcm = 0,
+        Aes256Gcm = 1,
+        Chacha20Poly1305 = 2,
+    }
+
+    fn cipher_of(suite: CipherSuite) -> Option<Cipher> {
+        match suite {
+            CipherSuite::TLS13_AES_128_GCM_SHA256
+            | CipherSuite::TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256
+            | CipherSuite::TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256 => Some(Cipher::Aes128Gcm),
+            CipherSuite::TLS13_AES_256_GCM_SHA384
+            | CipherSuite::TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384
+            | CipherSuite::TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384 => Some(Cipher::Aes256Gcm),
+            CipherSuite::TLS13_CHACHA20_POLY1305_SHA256
+            | CipherSuite::TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256
+            | CipherSuite::TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256 => {
+                Some(Cipher::Chacha20Poly1305)
+            }
+            _ => None,
+        }
+    }
+
+    pub(super) fn offload(tls: TlsStream<TcpStream>) -> io::Result<Offload> {
+        let userspace = |tls, result| Ok(Offload { stream: ClientTlsStream::Rustls(tls), result });
+
+        if ULP_UNAVAILABLE.load(Ordering::Relaxed) {
+            return userspace(tls, values::KTLS_UNAVAILABLE);
+        }
+        let (io, conn) = tls.get_ref();
+        let version = match conn.protocol_version() {
+            Some(ProtocolVersion::TLSv1_2) => libc::TLS_1_2_VERSION,
+            Some(ProtocolVersion::TLSv1_3) => libc::TLS_1_3_VERSION,
+            _ => return userspace(tls, values::KTLS_UNSUPPORTED_CIPHER),
+        };
+        let cipher = conn
+            .negotiated_cipher_suite()
+            .and_then(|suite| cipher_of(suite.suite()));
+        let Some(cipher) =
+            cipher.filter(|c| !CIPHER_UNSUPPORTED[*c as usize].load(Ordering::Relaxed))
+        else {
+            return userspace(tls, values::KTLS_UNSUPPORTED_CIPHER);
+        };
+        if let Err(e) = setsockopt(io, TcpUlp::default(), b"tls") {
+            if matches!(e, Errno::ENOENT | Errno::ENOPROTOOPT | Errno::EOPNOTSUPP) {
+                ULP_UNAVAILABLE.store(true, Ordering::Relaxed);
+                tracing::warn!(error = %e, "kTLS unavailable (is the `tls` module loaded?), using rustls");
+            }
+            return userspace(tls, values::KTLS_UNAVAILABLE);
+        }
+
+        // Point of no return: the session keys leave rustls.
+        let (io, mut conn) = tls.into_inner();
+        let plaintext = take_plaintext(&mut conn)?;
+        let secrets = conn
+            .dangerous_extract_secrets()
+            .map_err(|e| io::Error::new(io::ErrorKind::InvalidInput, e))?;
+        let (tx_seq, tx) = secrets.tx;
+        let (rx_seq, rx) = secrets.rx;
+
+        if let Err(e) = setsockopt(&io, TcpTlsTx, &crypto_info(version, tx_seq, &tx)?) {
+            if matches!(e, Errno::EINVAL | Errno::ENOPROTOOPT | Errno::EOPNOTSUPP) {
+                CIPHER_UNSUPPORTED[cipher as usize].store(true, Ordering::Relaxed);
+            }
+            return Err(io::Error::from(e));
+        }
+        setsockopt(&io, TcpTlsRx, &crypto_info(version, rx_seq, &rx)?)?;
+
+        Ok(Offload {
+            stream: ClientTlsStream::Kernel(KtlsStream {
+                io,
+                plaintext,
+                offset: 0,
+                read_closed: false,
+            }),
+            result: values::KTLS_OFFLOADED,
+        })
+    }
+
+    fn crypto_info(
+        version: u16,
+        seq: u64,
+        secrets: &ConnectionTrafficSecrets,
+    ) -> io::Result<TlsCryptoInfo> {
+        let invalid = |_| io::Error::new(io::ErrorKind::InvalidData, "unexpected kTLS key size");
+        let rec_seq = seq.to_be_bytes();
+        // The AEAD nonce is salt || explicit IV for AES-GCM, one 12-byte IV for ChaCha20.
+        Ok(match secrets {
+            ConnectionTrafficSecrets::Aes128Gcm { key, iv } => {
+                let (salt, iv) = iv.as_ref().split_at(libc::TLS_CIPHER_AES_GCM_128_SALT_SIZE);
+                TlsCryptoInfo::Aes128Gcm(libc::tls12_crypto_info_aes_gcm_128 {
+                    info: libc::tls_crypto_info {
+                        version,
+                        cipher_type: libc::TLS_CIPHER_AES_GCM_128,
+                    },
+                    iv: iv.try_into().map_err(invalid)?,
+                    key: key.as_ref().try_into().map_err(invalid)?,
+                    salt: salt.try_into().map_err(invalid)?,
+                    rec_seq,
+                })
+            }
+            ConnectionTrafficSecrets::Aes256Gcm { key, iv } => {
+                let (salt, iv) = iv.as_ref().split_at(libc::TLS_CIPHER_AES_GCM_256_SALT_SIZE);
+                TlsCryptoInfo::Aes256Gcm(libc::tls12_crypto_info_aes_gcm_256 {
+                    info: libc::tls_crypto_info {
+                        version,
+                        cipher_type: libc::TLS_CIPHER_AES_GCM_256,
+                    },
+                    iv: iv.try_into().map_err(invalid)?,
+                    key: key.as_ref().try_into().map_err(invalid)?,
+                    salt: salt.try_into().map_err(invalid)?,
+                    rec_seq,
+                })
+            }
+            ConnectionTrafficSecrets::Chacha20Poly1305 { key, iv } => {
+                TlsCryptoInfo::Chacha20Poly1305(libc::tls12_crypto_info_chacha20_poly1305 {
+                    info: libc::tls_crypto_info {
+                        version,
+                        cipher_type: libc::TLS_CIPHER_CHACHA20_POLY1305,
+                    },
+                    iv: iv.as_ref().try_into().map_err(invalid)?,
+                    key: key.as_ref().try_into().map_err(invalid)?,
+                    salt: [],
+                    rec_seq,
+                })
+            }
+            _ => {
+                return Err(io::Error::new(
+                    io::ErrorKind::InvalidInput,
+                    "cipher not supported by kTLS",
+                ))
+            }
+        })
+    }
+
+    /// Socket whose TLS records are encrypted and decrypted by the kernel.
+    ///
+    /// Writes are plain socket writes. Reads use `recvmsg` to learn each record's type: a
+    /// `close_notify` alert ends the stream; other alerts and post-handshake messages (TLS 1.3
+    /// KeyUpdate, which the kernel cannot rekey for) close the connection with an error. No
+    /// `close_notify` is sent on shutdown, only a TCP FIN.
+    pub struct KtlsStream {
+        io: TcpStream,
+        /// Plaintext rustls decrypted before the handoff
+        plaintext: Vec<u8>,
+        offset: usize,
+        read_closed: bool,
+    }
+
+    enum Record {
+        Data(usize),
+        CloseNotify,
+        Alert(u8),
+        Other(TlsGetRecordType),
+    }
+
+    fn recv_record(fd: i32, dst: &mut [u8]) -> io::Result<Record> {
+        let mut cmsg = [0u8; CMSG_BUFFER_LEN];
+        let mut iov = [IoSliceMut::new(dst)];
+        let msg = recvmsg::<()>(fd, &mut iov, Some(&mut cmsg), MsgFlags::empty())?;
+        let bytes = msg.bytes;
+        let mut record_type = TlsGetRecordType::ApplicationData;
+        for cmsg in msg.cmsgs()? {
+            if let ControlMessageOwned::TlsGetRecordType(t) = cmsg {
+                record_type = t;
+            }
+        }
+        Ok(match record_type {
+            TlsGetRecordType::ApplicationData => Record::Data(bytes),
+            TlsGetRecordType::Alert => match iov[0].get(..bytes) {
+                Some([_, ALERT_CLOSE_NOTIFY]) => Record::CloseNotify,
+                Some([_, description]) => Record::Alert(*description),
+                _ => Record::Alert(u8::MAX),
+            },
+            other => Record::Other(other),
+        })
+    }
+
+    impl AsyncRead for KtlsStream {
+        fn poll_read(
+            self: Pin<&mut Self>,
+            cx: &mut Context<'_>,
+            buf: &mut ReadBuf<'_>,
+        ) -> Poll<io::Result<()>> {
+            let this = self.get_mut();
+            if let Some(rest) = this
+                .plaintext
+                .get(this.offset..)
+                .filter(|rest| !rest.is_empty())
+            {
+                let n = rest.len().min(buf.remaining());
+                buf.put_slice(&rest[..n]);
+                this.offset = this.offset.saturating_add(n);
+                if this.offset == this.plaintext.len() {
+                    this.plaintext = Vec::new();
+                    this.offset = 0;
+                }
+                return Poll::Ready(Ok(()));
+            }
+            if this.read_closed || buf.remaining() == 0 {
+                return Poll::Ready(Ok(()));
+            }
+
+            loop {
+                ready!(this.io.poll_read_ready(cx))?;
+                let fd = this.io.as_raw_fd();
+                let dst = buf.initialize_unfilled();
+                match this.io.try_io(Interest::READABLE, || recv_record(fd, dst)) {
+                    Ok(Record::Data(n)) => {
+                        buf.advance(n);
+                        return Poll::Ready(Ok(()));
+                    }
+                    Ok(Record::CloseNotify) => {
+                        this.read_closed = true;
+                        return Poll::Ready(Ok(()));
+                    }
+                    Ok(Record::Alert(description)) => {
+                        return Poll::Ready(Err(io::Error::new(
+                            io::ErrorKind::ConnectionAborted,
+                            format!("TLS alert from client: {description}"),
+                        )))
+                    }
+                    Ok(Record::Other(record_type)) => {
+                        return Poll::Ready(Err(io::Error::new(
+                            io::ErrorKind::InvalidData,
+                            format!("unsupported TLS record on kTLS connection: {record_type:?}"),
+                        )))
+                    }
+                    Err(e) if e.kind() == io::ErrorKind::WouldBlock => continue,
+                    Err(e) => return Poll::Ready(Err(e)),
+                }
+            }
+        }
+    }
+
+    impl AsyncWrite for KtlsStream {
+        fn poll_write(
+            mut self: Pin<&mut Self>,
+            cx: &mut Context<'_>,
+            data: &[u8],
+        ) -> Poll<io::Result<usize>> {
+            Pin::new(&mut self.io).poll_write(cx, data)
+        }
+
+        fn poll_write_vectored(
+            mut self: Pin<&mut Self>,
+            cx: &mut Context<'_>,
+            bufs: &[io::IoSlice<'_>],
+        ) -> Poll<io::Result<usize>> {
+            Pin::new(&mut self.io).poll_write_vectored(cx, bufs)
+        }
+
+        fn is_write_vectored(&self) -> bool {
+            self.io.is_write_vectored()
+        }
+
+        fn poll_flush(mut self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<io::Result<()>> {
+            Pin::new(&mut self.io).poll_flush(cx)
+        }
+
+        fn poll_shutdown(mut self: Pin<&mut Self>, cx: &mut Context<'_>) -> Poll<io::Result<()>> {
+            Pin::new(&mut self.io).poll_shutdown(cx)
+        }
+    }
+}
@@ -1,5 +1,7 @@
 use std::sync::Arc;
 
+use tokio_rustls::rustls::HandshakeKind;
+
 use crate::telemetry::Metrics;
 
 pub fn extract_tls_info<S>(tls: &tokio_rustls::server::TlsStream<S>) -> (String, String) {
@@ -27,6 +29,8 @@ pub fn record_tls_handshake_metrics<S>(
     let (_, connection) = tls.get_ref();
 
     metrics.record_tls_handshake(&tls_version, &cipher_suite, handshake_duration);
+    let resumed = matches!(connection.handshake_kind(), Some(HandshakeKind::Resumed));
+    metrics.record_tls_session_resumption(&tls_version, resumed);
     metrics.record_tls_connection_active();
 
     if connection.peer_certificates().is_some() {
@@ -3,13 +3,19 @@ pub mod cert_resolver;
 pub mod cert_source;
 pub mod cipher_suites;
 pub mod curves;
+pub mod ktls;
 pub mod metrics;
+pub mod session_cache;
 pub mod session_resumption;
 pub mod setup;
+pub mod ticket_keys;
 pub use acceptor::build_server_config_with_resolver;
 pub use cert_resolver::{CertReloadReport, DynamicCertResolver};
 pub use cert_source::{cert_chain_hash, ServerCertsKeys};
 pub use cipher_suites::{is_cipher_suite_supported, supported_cipher_suites};
 pub use curves::{is_curve_supported, supported_curves};
+pub use ktls::ClientTlsStream;
 pub use metrics::{extract_tls_info, record_tls_handshake_metrics};
+pub use session_cache::SharedSessionCache;
 pub use setup::build_tls_acceptor;
+pub use ticket_keys::SharedTicketer;
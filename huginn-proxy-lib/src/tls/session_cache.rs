@@ -0,0 +1,418 @@
+use std::fmt::Write as _;
+use std::io::{self, Write};
+use std::net::{SocketAddr, TcpStream, ToSocketAddrs};
+use std::sync::mpsc::{self, Receiver, SyncSender, TrySendError};
+use std::sync::Arc;
+use std::time::Duration;
+
+use tokio::io::{AsyncBufReadExt, AsyncReadExt, AsyncWriteExt, BufReader};
+use tokio::sync::Semaphore;
+use tokio_rustls::rustls::server::{ServerSessionMemoryCache, StoresServerSessions};
+use tracing::debug;
+
+use crate::config::{SessionResumptionConfig, SharedSessionCacheConfig};
+use crate::error::{ProxyError, Result};
+use crate::tls::ticket_keys::SharedTicketer;
+
+/// Writes waiting for the background writer; beyond this they are dropped (the session stays
+/// resumable on this replica).
+const WRITE_QUEUE_LEN: usize = 1024;
+/// Memcached lookups in flight; ClientHellos past this resume only from the local cache.
+const MAX_REMOTE_LOOKUPS: usize = 64;
+/// Larger values are not TLS sessions; the lookup is treated as a miss.
+const MAX_VALUE_LEN: usize = 64 * 1024;
+/// Associated data of a sealed session, followed by its session ID.
+const SEAL_CONTEXT: &[u8] = b"huginn tls session cache\0";
+
+const CONTENT_TYPE_HANDSHAKE: u8 = 22;
+const HANDSHAKE_CLIENT_HELLO: u8 = 1;
+const EXT_SESSION_TICKET: usize = 35;
+const EXT_SUPPORTED_VERSIONS: usize = 43;
+const TLS13: [u8; 2] = [0x03, 0x04];
+
+/// TLS session store shared across replicas: a local in-memory cache in front of memcached.
+///
+/// - `put` stores locally and queues the write to memcached on a background thread, so the
+///   handshake never waits on the network to issue a session.
+/// - `get`/`take` (called by rustls during the handshake) only read the local cache. Sessions
+///   issued by other replicas are brought into it beforehand by [`Self::prefetch`], which the
+///   accept path awaits with the ClientHello, so no lookup ever blocks a runtime thread.
+///
+/// Sessions hold the TLS 1.2 master secret, so memcached only ever sees them sealed with the
+/// shared ticket keys ([`SharedTicketer`]), bound to their session ID. A value that does not
+/// open (tampered, planted, moved to another ID, or sealed by a retired key) is a miss, like
+/// memcached errors and timeouts; the client falls back to a full handshake.
+#[derive(Debug)]
+pub struct SharedSessionCache {
+    local: Arc<ServerSessionMemoryCache>,
+    remote: Arc<Memcached>,
+    writes: SyncSender<RemoteWrite>,
+    sealer: Arc<SharedTicketer>,
+    lookups: Semaphore,
+}
+
+#[derive(Debug)]
+enum RemoteWrite {
+    Set { key: Vec<u8>, value: Vec<u8> },
+    Delete { key: Vec<u8> },
+}
+
+impl SharedSessionCache {
+    /// Cache for the configured `shared_cache`, or `None` when resumption is disabled or no
+    /// shared cache is configured. Sessions are sealed with the shared ticket keys, so
+    /// `ticketer` is required with it.
+    pub fn from_config(
+        config: &SessionResumptionConfig,
+        ticketer: Option<Arc<SharedTicketer>>,
+    ) -> Result<Option<Arc<Self>>> {
+        let Some(shared_cache) = config.shared_cache.as_ref().filter(|_| config.enabled) else {
+            return Ok(None);
+        };
+        let Some(sealer) = ticketer else {
+            return Err(ProxyError::Tls(
+                "session_resumption.shared_cache requires ticket_keys_path".to_string(),
+            ));
+        };
+        Self::connect(shared_cache, config.max_sessions, sealer).map(Some)
+    }
+
+    /// Resolve the memcached address and start the background writer. The server does not
+    /// have to be reachable yet. `sealer` holds the keys sessions are sealed with.
+    pub fn connect(
+        config: &SharedSessionCacheConfig,
+        max_sessions: usize,
+        sealer: Arc<SharedTicketer>,
+    ) -> Result<Arc<Self>> {
+        let addrs: Vec<SocketAddr> = config
+            .memcached
+            .to_socket_addrs()
+            .map_err(|e| {
+                ProxyError::Tls(format!(
+                    "Failed to resolve shared session cache '{}': {e}",
+                    config.memcached
+                ))
+            })?
+            .collect();
+        if addrs.is_empty() {
+            return Err(ProxyError::Tls(format!(
+                "Shared session cache '{}' resolved to no address",
+                config.memcached
+            )));
+        }
+
+        let remote = Arc::new(Memcached {
+            addrs,
+            timeout: Duration::from_millis(config.timeout_ms.max(1)),
+            ttl_secs: config.ttl_secs,
+            key_prefix: config.key_prefix.clone(),
+        });
+        let (writes, queue) = mpsc::sync_channel(WRITE_QUEUE_LEN);
+        let writer = Arc::clone(&remote);
+        std::thread::Builder::new()
+            .name("tls-session-cache".to_string())
+            .spawn(move || writer.run_writes(queue))
+            .map_err(|e| {
+                ProxyError::Tls(format!("Failed to start shared session cache writer: {e}"))
+            })?;
+
+        Ok(Arc::new(Self {
+            local: ServerSessionMemoryCache::new(max_sessions),
+            remote,
+            writes,
+            sealer,
+            lookups: Semaphore::new(MAX_REMOTE_LOOKUPS),
+        }))
+    }
+
+    /// Bring the session a ClientHello asks to resume into the local cache, so the handshake
+    /// that follows finds it there.
+    ///
+    /// Only TLS 1.2 session-ID resumption reads the store ([`stateful_session_id`]); other
+    /// ClientHellos, and sessions already held locally, return at once. The lookup is bounded
+    /// by `timeout_ms`, and at most [`MAX_REMOTE_LOOKUPS`] run at a time: past that, and on
+    /// any memcached error, the handshake goes ahead without the session.
+    pub async fn prefetch(&self, client_hello: &[u8]) {
+        let Some(key) = stateful_session_id(client_hello) else {
+            return;
+        };
+        if self.local.get(key).is_some() {
+            return;
+        }
+        let Ok(_permit) = self.lookups.try_acquire() else {
+            debug!("Shared session cache lookups saturated, lookup skipped");
+            return;
+        };
+
+        let sealed = match tokio::time::timeout(self.remote.timeout, self.remote.get(key)).await {
+            Ok(Ok(Some(sealed))) => sealed,
+            Ok(Ok(None)) => return,
+            Ok(Err(e)) => {
+                debug!(error = %e, "Shared session cache lookup failed");
+                return;
+            }
+            Err(_) => {
+                debug!("Shared session cache lookup timed out");
+                return;
+            }
+        };
+        match self.sealer.open(&sealed, &seal_context(key)) {
+            Some(value) => {
+                self.local.put(key.to_vec(), value);
+            }
+            None => debug!("Shared session cache value did not open, treated as a miss"),
+        }
+    }
+
+    fn queue(&self, write: RemoteWrite) {
+        match self.writes.try_send(write) {
+            Ok(()) => {}
+            Err(TrySendError::Full(_)) => {
+                debug!("Shared session cache write queue full, write dropped");
+            }
+            Err(TrySendError::Disconnected(_)) => {
+                debug!("Shared session cache writer stopped, write dropped");
+            }
+        }
+    }
+}
+
+/// [`SEAL_CONTEXT`] followed by the session ID the value is stored under.
+fn seal_context(key: &[u8]) -> Vec<u8> {
+    let mut context = Vec::with_capacity(SEAL_CONTEXT.len().saturating_add(key.len()));
+    context.extend_from_slice(SEAL_CONTEXT);
+    context.extend_from_slice(key);
+    context
+}
+
+/// Session ID of a ClientHello that rustls would look up in the session store: a non-empty
+/// legacy session ID, with no session ticket (which takes precedence) and no TLS 1.3 among the
+/// supported versions (TLS 1.3 resumes from tickets, and the server always offers it).
+///
+/// `bytes` starts at the first TLS record; only that record is parsed, and extensions that run
+/// past it are not seen. `None` for anything that is not a ClientHello.
+fn stateful_session_id(bytes: &[u8]) -> Option<&[u8]> {
+    let mut record = Cursor(bytes);
+    if record.u8()? != usize::from(CONTENT_TYPE_HANDSHAKE) {
+        return None;
+    }
+    record.take(2)?;
+    let len = record.u16()?;
+    let mut hello = Cursor(record.0.get(..len).unwrap_or(record.0));
+
+    if hello.u8()? != usize::from(HANDSHAKE_CLIENT_HELLO) {
+        return None;
+    }
+    // Handshake length, legacy version and random.
+    hello.take(3)?;
+    hello.take(2)?;
+    hello.take(32)?;
+    let session_id_len = hello.u8()?;
+    let session_id = hello.take(session_id_len)?;
+    if session_id.is_empty() {
+        return None;
+    }
+    let cipher_suites_len = hello.u16()?;
+    hello.take(cipher_suites_len)?;
+    let compression_len = hello.u8()?;
+    hello.take(compression_len)?;
+
+    let Some(extensions_len) = hello.u16() else {
+        return Some(session_id);
+    };
+    let mut extensions = Cursor(hello.0.get(..extensions_len).unwrap_or(hello.0));
+    while let (Some(kind), Some(len)) = (extensions.u16(), extensions.u16()) {
+        let Some(data) = extensions.take(len) else {
+            break;
+        };
+        match kind {
+            EXT_SESSION_TICKET if !data.is_empty() => return None,
+            EXT_SUPPORTED_VERSIONS if offers_tls13(data) => return None,
+            _ => {}
+        }
+    }
+    Some(session_id)
+}
+
+fn offers_tls13(supported_versions: &[u8]) -> bool {
+    let mut cursor = Cursor(supported_versions);
+    cursor
+        .u8()
+        .and_then(|len| cursor.take(len))
+        .is_some_and(|versions| versions.chunks_exact(2).any(|version| version == TLS13))
+}
+
+/// Big-endian reader over a byte slice; every read fails past the end.
+struct Cursor<'a>(&'a [u8]);
+
+impl<'a> Cursor<'a> {
+    fn take(&mut self, len: usize) -> Option<&'a [u8]> {
+        let head = self.0.get(..len)?;
+        self.0 = self.0.get(len..)?;
+        Some(head)
+    }
+
+    fn u8(&mut self) -> Option<usize> {
+        self.take(1)?.first().copied().map(usize::from)
+    }
+
+    fn u16(&mut self) -> Option<usize> {
+        let bytes: [u8; 2] = self.take(2)?.try_into().ok()?;
+        Some(usize::from(u16::from_be_bytes(bytes)))
+    }
+}
+
+impl StoresServerSessions for SharedSessionCache {
+    fn put(&self, key: Vec<u8>, value: Vec<u8>) -> bool {
+        match self.sealer.seal(&value, &seal_context(&key)) {
+            Some(sealed) => self.queue(RemoteWrite::Set { key: key.clone(), value: sealed }),
+            None => debug!("Shared session cache value could not be sealed, not shared"),
+        }
+        self.local.put(key, value)
+    }
+
+    fn get(&self, key: &[u8]) -> Option<Vec<u8>> {
+        self.local.get(key)
+    }
+
+    fn take(&self, key: &[u8]) -> Option<Vec<u8>> {
+        let value = self.local.take(key)?;
+        self.queue(RemoteWrite::Delete { key: key.to_vec() });
+        Some(value)
+    }
+
+    fn can_cache(&self) -> bool {
+        true
+    }
+}
+
+/// Minimal memcached text-protocol client (`get`, `set`, `delete`).
+#[derive(Debug)]
+struct Memcached {
+    addrs: Vec<SocketAddr>,
+    timeout: Duration,
+    ttl_secs: u32,
+    key_prefix: String,
+}
+
+impl Memcached {
+    /// Blocking connection for the writer thread.
+    fn connect(&self) -> io::Result<TcpStream> {
+        let mut last_error = None;
+        for addr in &self.addrs {
+            match TcpStream::connect_timeout(addr, self.timeout) {
+                Ok(stream) => {
+                    stream.set_read_timeout(Some(self.timeout))?;
+                    stream.set_write_timeout(Some(self.timeout))?;
+                    stream.set_nodelay(true)?;
+                    return Ok(stream);
+                }
+                Err(e) => last_error = Some(e),
+            }
+        }
+        Err(last_error.unwrap_or_else(|| io::Error::other("no memcached address")))
+    }
+
+    /// `{key_prefix}{hex(session key)}`; memcached keys must be printable.
+    fn cache_key(&self, key: &[u8]) -> String {
+        let mut cache_key = String::with_capacity(
+            self.key_prefix
+                .len()
+                .saturating_add(key.len().saturating_mul(2)),
+        );
+        cache_key.push_str(&self.key_prefix);
+        for byte in key {
+            let _ = write!(cache_key, "{byte:02x}");
+        }
+        cache_key
+    }
+
+    /// Look a session up on a connection of its own. Lookups only happen for TLS 1.2
+    /// session-ID resumption from another replica, so connections are not pooled: a
+    /// `tokio` socket stays registered with the runtime that opened it, and with
+    /// `thread_per_core` every shard has its own. The caller bounds it with `timeout`.
+    async fn get(&self, key: &[u8]) -> io::Result<Option<Vec<u8>>> {
+        let key = self.cache_key(key);
+        let mut stream = tokio::net::TcpStream::connect(self.addrs.as_slice()).await?;
+        stream.set_nodelay(true)?;
+        read_value(&mut stream, &key).await
+    }
+
+    fn run_writes(&self, queue: Receiver<RemoteWrite>) {
+        let mut stream: Option<TcpStream> = None;
+        // Ends when the cache (and with it every rustls ServerConfig using it) is dropped.
+        for write in queue {
+            let mut command = Vec::new();
+            match &write {
+                RemoteWrite::Set { key, value } => {
+                    let key = self.cache_key(key);
+                    let _ = write!(
+                        command,
+                        "set {key} 0 {} {} noreply\r\n",
+                        self.ttl_secs,
+                        value.len()
+                    );
+                    command.extend_from_slice(value);
+                    command.extend_from_slice(b"\r\n");
+                }
+                RemoteWrite::Delete { key } => {
+                    let key = self.cache_key(key);
+                    let _ = write!(command, "delete {key} noreply\r\n");
+                }
+            }
+
+            let result = match stream.as_mut() {
+                Some(stream) => stream.write_all(&command),
+                None => self.connect().and_then(|mut fresh| {
+                    fresh.write_all(&command)?;
+                    stream = Some(fresh);
+                    Ok(())
+                }),
+            };
+            if let Err(e) = result {
+                debug!(error = %e, "Shared session cache write failed");
+                stream = None;
+            }
+        }
+    }
+}
+
+/// Send `get` and read the reply: `END`, or one `VALUE <key> <flags> <bytes>` block then `END`.
+async fn read_value(stream: &mut tokio::net::TcpStream, key: &str) -> io::Result<Option<Vec<u8>>> {
+    stream
+        .write_all(format!("get {key}\r\n").as_bytes())
+        .await?;
+
+    let mut reader = BufReader::new(stream);
+    let mut line = String::new();
+    reader.read_line(&mut line).await?;
+    if line == "END\r\n" {
+        return Ok(None);
+    }
+
+    let len = match line.trim_end().split(' ').collect::<Vec<_>>().as_slice() {
+        ["VALUE", reply_key, _flags, len] if *reply_key == key => {
+            len.parse::<usize>().map_err(|_| {
+                io::Error::new(io::ErrorKind::InvalidData, "bad memcached value length")
+            })?
+        }
+        _ => {
+            return Err(io::Error::new(
+                io::ErrorKind::InvalidData,
+                format!("unexpected memcached reply: {}", line.trim_end()),
+            ))
+        }
+    };
+    if len > MAX_VALUE_LEN {
+        return Err(io::Error::new(io::ErrorKind::InvalidData, "memcached value too large"));
+    }
+
+    let mut value = vec![0u8; len.saturating_add(2)];
+    reader.read_exact(&mut value).await?;
+    line.clear();
+    reader.read_line(&mut line).await?;
+    if !value.ends_with(b"\r\n") || line != "END\r\n" {
+        return Err(io::Error::new(io::ErrorKind::InvalidData, "malformed memcached value"));
+    }
+    value.truncate(len);
+    Ok(Some(value))
+}
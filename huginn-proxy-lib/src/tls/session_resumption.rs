@@ -5,6 +5,8 @@ use tokio_rustls::rustls::server::{
 use tokio_rustls::rustls::ServerConfig;
 
 use crate::config::SessionResumptionConfig;
+use crate::tls::session_cache::SharedSessionCache;
+use crate::tls::ticket_keys::SharedTicketer;
 
 /// Configures session resumption in ServerConfig
 ///
@@ -31,6 +33,31 @@ pub fn configure_session_resumption(server: &mut ServerConfig, config: &SessionR
     server.session_storage = cache;
 }
 
+/// Replace the per-process resumption state set by [`configure_session_resumption`] with the
+/// cluster-shared backends, so a client resumes on whichever replica the load balancer picks:
+/// - `ticketer`: TLS 1.3 tickets (and TLS 1.2 RFC 5077 tickets) sealed with the shared keys
+/// - `session_cache`: TLS 1.2 session IDs mirrored to memcached behind the local cache
+///   ([`SharedSessionCache::from_config`]); the accept path prefetches into it
+///
+/// Both are created once by the caller and shared by every `ServerConfig`. No-op when
+/// resumption is disabled.
+pub fn configure_shared_session_resumption(
+    server: &mut ServerConfig,
+    config: &SessionResumptionConfig,
+    ticketer: Option<Arc<SharedTicketer>>,
+    session_cache: Option<Arc<SharedSessionCache>>,
+) {
+    if !config.enabled {
+        return;
+    }
+    if let Some(session_cache) = session_cache {
+        server.session_storage = session_cache;
+    }
+    if let Some(ticketer) = ticketer {
+        server.ticketer = ticketer;
+    }
+}
+
 // Implementations to disable session resumption
 
 /// No-op session storage that disables TLS 1.2 session ID resumption
@@ -7,6 +7,8 @@ use crate::config::TlsConfig;
 use crate::error::Result;
 use crate::tls::acceptor::build_server_config_with_resolver;
 use crate::tls::cert_resolver::DynamicCertResolver;
+use crate::tls::session_cache::SharedSessionCache;
+use crate::tls::ticket_keys::SharedTicketer;
 
 pub type SharedTlsAcceptor = Arc<ArcSwap<TlsAcceptor>>;
 
@@ -17,10 +19,13 @@ pub type SharedTlsAcceptor = Arc<ArcSwap<TlsAcceptor>>;
 /// proxy, but it is never swapped: certificate rotation happens *inside* the
 /// resolver via [`DynamicCertResolver::update`] (driven by the config hot-reload
 /// path in `proxy/reload.rs`), which swaps its own cert map without touching the
-/// acceptor.
+/// acceptor. Shared session ticket keys rotate the same way, inside `ticketer`
+/// ([`SharedTicketer::reload`]); `session_cache` is the shared TLS 1.2 session store.
 pub async fn build_tls_acceptor(
     tls_config: &TlsConfig,
     resolver: Arc<DynamicCertResolver>,
+    ticketer: Option<Arc<SharedTicketer>>,
+    session_cache: Option<Arc<SharedSessionCache>>,
 ) -> Result<SharedTlsAcceptor> {
     let acceptor = build_server_config_with_resolver(
         resolver,
@@ -28,6 +33,8 @@ pub async fn build_tls_acceptor(
         &tls_config.options,
         &tls_config.client_auth,
         &tls_config.session_resumption,
+        ticketer,
+        session_cache,
     )?;
 
     Ok(Arc::new(ArcSwap::new(Arc::new(acceptor))))
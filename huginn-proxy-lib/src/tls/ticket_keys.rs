@@ -0,0 +1,223 @@
+use std::fmt;
+use std::path::{Path, PathBuf};
+use std::sync::Arc;
+
+use arc_swap::ArcSwap;
+use aws_lc_rs::aead::{Aad, LessSafeKey, Nonce, UnboundKey, AES_256_GCM, NONCE_LEN};
+use aws_lc_rs::digest::{digest, SHA256};
+use aws_lc_rs::rand::{SecureRandom, SystemRandom};
+use tokio_rustls::rustls::server::ProducesTickets;
+
+use crate::config::SessionResumptionConfig;
+use crate::error::{ProxyError, Result};
+
+/// AES-256-GCM key size
+const KEY_LEN: usize = 32;
+const KEY_HEX_LEN: usize = KEY_LEN * 2;
+/// Leading bytes of a ticket naming the key that sealed it
+const KEY_ID_LEN: usize = 8;
+const TAG_LEN: usize = 16;
+const HEADER_LEN: usize = KEY_ID_LEN + NONCE_LEN;
+const MIN_TICKET_LEN: usize = HEADER_LEN + TAG_LEN;
+
+struct TicketKey {
+    /// First bytes of SHA-256(key); identifies the key without revealing it
+    id: [u8; KEY_ID_LEN],
+    key: LessSafeKey,
+}
+
+/// Session ticketer whose keys come from a file shared by every replica, so a ticket issued
+/// by one instance resumes on any other.
+///
+/// Tickets are `key id || nonce || AES-256-GCM(session state)` with the key id as associated
+/// data. The first key of the file seals new tickets and every key opens them, so keys roll
+/// without breaking outstanding sessions:
+///
+/// 1. append the new key on every replica, so all of them accept it;
+/// 2. move it to the top, so replicas start sealing with it;
+/// 3. drop the previous key once its tickets have expired (`ticket_lifetime_secs`).
+///
+/// The same keys seal the sessions the shared session cache writes to memcached
+/// ([`crate::tls::SharedSessionCache`]), so they roll the same way.
+///
+/// Keys are swapped atomically by [`SharedTicketer::reload`], called from the config hot-reload
+/// path; handshakes in flight keep the key set they loaded.
+pub struct SharedTicketer {
+    path: PathBuf,
+    lifetime: u32,
+    keys: ArcSwap<Vec<TicketKey>>,
+    rng: SystemRandom,
+}
+
+impl SharedTicketer {
+    /// Ticketer for the configured `ticket_keys_path`, or `None` when resumption is disabled or
+    /// no shared keys are configured (rustls' per-process ticketer is kept).
+    pub fn from_config(config: &SessionResumptionConfig) -> Result<Option<Arc<Self>>> {
+        match &config.ticket_keys_path {
+            Some(path) if config.enabled => Self::load(path, config.ticket_lifetime_secs).map(Some),
+            _ => Ok(None),
+        }
+    }
+
+    pub fn load(path: impl Into<PathBuf>, lifetime: u32) -> Result<Arc<Self>> {
+        let path = path.into();
+        let keys = read_ticket_keys(&path)?;
+        Ok(Arc::new(Self {
+            path,
+            lifetime,
+            keys: ArcSwap::from_pointee(keys),
+            rng: SystemRandom::new(),
+        }))
+    }
+
+    /// Re-read the key file and return the number of keys now in use. On error the current
+    /// keys stay active.
+    pub fn reload(&self) -> Result<usize> {
+        let keys = read_ticket_keys(&self.path)?;
+        let count = keys.len();
+        self.keys.store(Arc::new(keys));
+        Ok(count)
+    }
+
+    pub fn path(&self) -> &Path {
+        &self.path
+    }
+
+    pub fn key_count(&self) -> usize {
+        self.keys.load().len()
+    }
+}
+
+impl ProducesTickets for SharedTicketer {
+    fn enabled(&self) -> bool {
+        true
+    }
+
+    fn lifetime(&self) -> u32 {
+        self.lifetime
+    }
+
+    fn encrypt(&self, plain: &[u8]) -> Option<Vec<u8>> {
+        self.seal(plain, &[])
+    }
+
+    fn decrypt(&self, ticket: &[u8]) -> Option<Vec<u8>> {
+        self.open(ticket, &[])
+    }
+}
+
+impl SharedTicketer {
+    /// Seal `plain` with the current key, in the ticket format. `context` is added to the
+    /// associated data: a value sealed for one context (tickets use none) only opens for the
+    /// same one.
+    pub(crate) fn seal(&self, plain: &[u8], context: &[u8]) -> Option<Vec<u8>> {
+        let keys = self.keys.load();
+        let current = keys.first()?;
+
+        let mut nonce = [0u8; NONCE_LEN];
+        self.rng.fill(&mut nonce).ok()?;
+
+        let mut sealed = Vec::with_capacity(
+            plain
+                .len()
+                .saturating_add(HEADER_LEN)
+                .saturating_add(TAG_LEN),
+        );
+        sealed.extend_from_slice(&current.id);
+        sealed.extend_from_slice(&nonce);
+        sealed.extend_from_slice(plain);
+        let tag = current
+            .key
+            .seal_in_place_separate_tag(
+                Nonce::assume_unique_for_key(nonce),
+                associated_data(&current.id, context),
+                sealed.get_mut(HEADER_LEN..)?,
+            )
+            .ok()?;
+        sealed.extend_from_slice(tag.as_ref());
+        Some(sealed)
+    }
+
+    /// Open a value from [`Self::seal`] with whichever key sealed it; `None` when that key is
+    /// unknown or retired, or the value or `context` differ from what was sealed.
+    pub(crate) fn open(&self, sealed: &[u8], context: &[u8]) -> Option<Vec<u8>> {
+        if sealed.len() < MIN_TICKET_LEN {
+            return None;
+        }
+        let (id, rest) = sealed.split_at(KEY_ID_LEN);
+        let (nonce, sealed) = rest.split_at(NONCE_LEN);
+
+        let keys = self.keys.load();
+        // Tickets sealed by a retired (or unknown) key fall back to a full handshake.
+        let key = keys.iter().find(|key| key.id == id)?;
+        let nonce = Nonce::try_assume_unique_for_key(nonce).ok()?;
+        let mut plain = sealed.to_vec();
+        let len = key
+            .key
+            .open_in_place(nonce, associated_data(id, context), &mut plain)
+            .ok()?
+            .len();
+        plain.truncate(len);
+        Some(plain)
+    }
+}
+
+/// `key id || context`; with no context this is the key id alone, as in tickets.
+fn associated_data(id: &[u8], context: &[u8]) -> Aad<Vec<u8>> {
+    let mut aad = Vec::with_capacity(id.len().saturating_add(context.len()));
+    aad.extend_from_slice(id);
+    aad.extend_from_slice(context);
+    Aad::from(aad)
+}
+
+impl fmt::Debug for SharedTicketer {
+    fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
+        f.debug_struct("SharedTicketer")
+            .field("path", &self.path)
+            .field("lifetime", &self.lifetime)
+            .field("keys", &self.key_count())
+            .finish()
+    }
+}
+
+fn read_ticket_keys(path: &Path) -> Result<Vec<TicketKey>> {
+    let contents = std::fs::read_to_string(path).map_err(|e| {
+        ProxyError::Tls(format!("Failed to read TLS ticket keys '{}': {e}", path.display()))
+    })?;
+    parse_ticket_keys(&contents)
+        .map_err(|e| ProxyError::Tls(format!("Invalid TLS ticket keys '{}': {e}", path.display())))
+}
+
+/// Parse one hex-encoded 32-byte key per line; blank lines and `#` comments are ignored.
+fn parse_ticket_keys(contents: &str) -> std::result::Result<Vec<TicketKey>, String> {
+    let mut keys = Vec::new();
+    for (index, line) in contents.lines().enumerate() {
+        let line = line.split('#').next().unwrap_or_default().trim();
+        if line.is_empty() {
+            continue;
+        }
+        let line_number = index.saturating_add(1);
+        let bytes = decode_key(line)
+            .ok_or_else(|| format!("line {line_number}: expected {KEY_HEX_LEN} hex characters"))?;
+        let key = UnboundKey::new(&AES_256_GCM, &bytes)
+            .map_err(|_| format!("line {line_number}: unusable key"))?;
+        let mut id = [0u8; KEY_ID_LEN];
+        id.copy_from_slice(&digest(&SHA256, &bytes).as_ref()[..KEY_ID_LEN]);
+        keys.push(TicketKey { id, key: LessSafeKey::new(key) });
+    }
+    if keys.is_empty() {
+        return Err("no keys found".to_string());
+    }
+    Ok(keys)
+}
+
+fn decode_key(hex: &str) -> Option<[u8; KEY_LEN]> {
+    if hex.len() != KEY_HEX_LEN || !hex.bytes().all(|b| b.is_ascii_hexdigit()) {
+        return None;
+    }
+    let mut key = [0u8; KEY_LEN];
+    for (byte, pair) in key.iter_mut().zip(hex.as_bytes().chunks_exact(2)) {
+        *byte = u8::from_str_radix(std::str::from_utf8(pair).ok()?, 16).ok()?;
+    }
+    Some(key)
+}
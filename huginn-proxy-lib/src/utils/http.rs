@@ -1,11 +1,23 @@
 use http_body_util::{combinators::BoxBody, BodyExt, Full};
 use hyper::body::Bytes;
 use hyper::header::{HeaderValue, CONTENT_TYPE};
-use hyper::{Response, StatusCode};
+use hyper::{Response, StatusCode, Version};
 use serde::Serialize;
 
 pub(crate) type RespBody = BoxBody<Bytes, hyper::Error>;
 
+/// `protocol` metric label of `version`: its `Debug` output, without formatting per request.
+pub(crate) fn version_label(version: Version) -> &'static str {
+    match version {
+        Version::HTTP_09 => "HTTP/0.9",
+        Version::HTTP_10 => "HTTP/1.0",
+        Version::HTTP_11 => "HTTP/1.1",
+        Version::HTTP_2 => "HTTP/2.0",
+        Version::HTTP_3 => "HTTP/3.0",
+        _ => "HTTP/unknown",
+    }
+}
+
 pub(crate) fn full_body(bytes: impl Into<Bytes>) -> RespBody {
     Full::new(bytes.into())
         .map_err(|never| match never {})
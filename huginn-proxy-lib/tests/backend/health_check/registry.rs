@@ -85,3 +85,14 @@ fn clone_shares_state() {
     assert!(!r2.is_healthy("shared:1"));
     assert_eq!(r2.len(), 1);
 }
+
+#[test]
+fn get_returns_registered_handle_only() {
+    let r = HealthRegistry::new();
+    assert!(r.get("backend:9000").is_none());
+    let h = r.get_or_create("backend:9000");
+    let Some(got) = r.get("backend:9000") else {
+        panic!("expected registered handle");
+    };
+    assert!(Arc::ptr_eq(&h, &got));
+}
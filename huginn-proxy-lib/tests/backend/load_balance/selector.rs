@@ -1,5 +1,14 @@
+use std::collections::HashSet;
+use std::net::{IpAddr, Ipv4Addr};
+use std::sync::Arc;
+
+use huginn_proxy_lib::backend::{ClientKey, SelectedBackend};
+use huginn_proxy_lib::config::{sort_domain_routes, Domain, HashKey, LoadBalance, Route};
+use huginn_proxy_lib::proxy::router::RoutingTable;
 use huginn_proxy_lib::{BackendSelector, HealthRegistry};
 
+const CLIENT_IP: IpAddr = IpAddr::V4(Ipv4Addr::new(192, 0, 2, 1));
+
 #[test]
 fn select_round_robin_across_healthy_candidates() {
     let selector = BackendSelector::new();
@@ -48,3 +57,303 @@ fn select_returns_none_when_all_candidates_unhealthy() {
 
     assert!(selector.select("/api", &candidates, &registry).is_none());
 }
+
+fn route(prefix: &str, backend: &str) -> Route {
+    Route {
+        prefix: prefix.to_string(),
+        backend: backend.to_string(),
+        fingerprinting: None,
+        force_new_connection: false,
+        load_balance: Default::default(),
+        replace_path: None,
+        security: None,
+        headers: None,
+        cache: None,
+        coalesce: None,
+    }
+}
+
+fn balanced(prefix: &str, backend: &str, load_balance: LoadBalance) -> Route {
+    Route { load_balance, ..route(prefix, backend) }
+}
+
+fn table(routes: Vec<Route>) -> Arc<RoutingTable> {
+    let mut domains = vec![Domain {
+        host: None,
+        cert_path: None,
+        key_path: None,
+        headers: None,
+        security: None,
+        fingerprinting: None,
+        routes,
+    }];
+    sort_domain_routes(&mut domains);
+    Arc::new(RoutingTable::new(Arc::new(domains)))
+}
+
+fn select_as(
+    selector: &BackendSelector,
+    routing: &Arc<RoutingTable>,
+    path: &str,
+    client: &ClientKey<'_>,
+    registry: &HealthRegistry,
+) -> Option<SelectedBackend> {
+    let route_match = routing
+        .pick_route(0, path)
+        .unwrap_or_else(|| panic!("expected a route for {path}"));
+    selector.select_route(routing, 0, &route_match, client, registry)
+}
+
+fn select_path(
+    selector: &BackendSelector,
+    routing: &Arc<RoutingTable>,
+    path: &str,
+    registry: &HealthRegistry,
+) -> Option<Arc<str>> {
+    select_as(selector, routing, path, &ClientKey::new(CLIENT_IP, None), registry)
+        .map(|selected| selected.address)
+}
+
+fn started(selected: Option<SelectedBackend>) -> SelectedBackend {
+    let Some(selected) = selected else {
+        panic!("expected a healthy backend");
+    };
+    let Some(stats) = selected.stats.as_ref() else {
+        panic!("published backend should carry stats");
+    };
+    stats.start();
+    selected
+}
+
+#[test]
+fn select_route_round_robins_published_group() {
+    let selector = BackendSelector::new();
+    let registry = HealthRegistry::new();
+    let routing = table(vec![
+        route("/api", "backend-a:9000"),
+        route("/", "root:9000"),
+        route("/api", "backend-b:9000"),
+    ]);
+    selector.publish(&routing, &registry);
+
+    let picks: Vec<_> = (0..3)
+        .filter_map(|_| select_path(&selector, &routing, "/api/users", &registry))
+        .collect();
+    assert_eq!(
+        picks,
+        [Arc::from("backend-a:9000"), "backend-b:9000".into(), "backend-a:9000".into()]
+    );
+    assert_eq!(select_path(&selector, &routing, "/", &registry).as_deref(), Some("root:9000"));
+}
+
+#[test]
+fn select_route_reads_pinned_health_live() {
+    let selector = BackendSelector::new();
+    let registry = HealthRegistry::new();
+    let a = registry.get_or_create("backend-a:9000");
+    let b = registry.get_or_create("backend-b:9000");
+    let routing = table(vec![route("/api", "backend-a:9000"), route("/api", "backend-b:9000")]);
+    selector.publish(&routing, &registry);
+
+    // Health transitions after publish are observed without republishing.
+    a.set(false);
+    for _ in 0..3 {
+        assert_eq!(
+            select_path(&selector, &routing, "/api", &registry).as_deref(),
+            Some("backend-b:9000")
+        );
+    }
+    b.set(false);
+    assert!(select_path(&selector, &routing, "/api", &registry).is_none());
+}
+
+#[test]
+fn select_route_falls_back_for_unpublished_routing_table() {
+    let selector = BackendSelector::new();
+    let registry = HealthRegistry::new();
+    let a = registry.get_or_create("backend-a:9000");
+    let published = table(vec![route("/other", "other:9000")]);
+    selector.publish(&published, &registry);
+
+    // A connection still on another config generation, on a group the published config no
+    // longer has, gets the by-address path.
+    let stale = table(vec![route("/api", "backend-a:9000"), route("/api", "backend-b:9000")]);
+    a.set(false);
+    assert_eq!(
+        select_path(&selector, &stale, "/api", &registry).as_deref(),
+        Some("backend-b:9000")
+    );
+}
+
+#[test]
+fn least_outstanding_prefers_idle_backend_and_keeps_counts_across_publish() {
+    let selector = BackendSelector::new();
+    let registry = HealthRegistry::new();
+    let lo = LoadBalance::LeastOutstanding;
+    let routing = table(vec![
+        balanced("/api", "backend-a:9000", lo),
+        balanced("/api", "backend-b:9000", lo),
+        balanced("/api", "backend-c:9000", lo),
+    ]);
+    selector.publish(&routing, &registry);
+    let client = ClientKey::new(CLIENT_IP, None);
+
+    let first = started(select_as(&selector, &routing, "/api", &client, &registry));
+    let second = started(select_as(&selector, &routing, "/api", &client, &registry));
+    let Some(third) = select_as(&selector, &routing, "/api", &client, &registry) else {
+        panic!("expected a healthy backend");
+    };
+    let picked: HashSet<_> = [&first.address, &second.address, &third.address]
+        .into_iter()
+        .cloned()
+        .collect();
+    assert_eq!(picked.len(), 3, "each pick should go to an idle backend");
+
+    // A reload republishes the same addresses: in-flight requests are still counted.
+    selector.publish(&routing, &registry);
+    let Some(again) = select_as(&selector, &routing, "/api", &client, &registry) else {
+        panic!("expected a healthy backend");
+    };
+    assert_eq!(again.address, third.address);
+
+    for selected in [&first, &second] {
+        if let Some(stats) = &selected.stats {
+            stats.finish();
+            assert_eq!(stats.in_flight(), 0);
+        }
+    }
+}
+
+#[test]
+fn p2c_ewma_avoids_slow_backend() {
+    let selector = BackendSelector::new();
+    let registry = HealthRegistry::new();
+    let routing = table(vec![
+        balanced("/api", "slow:9000", LoadBalance::P2cEwma),
+        balanced("/api", "fast:9000", LoadBalance::P2cEwma),
+    ]);
+    selector.publish(&routing, &registry);
+    let client = ClientKey::new(CLIENT_IP, None);
+
+    for _ in 0..2 {
+        let Some(selected) = select_as(&selector, &routing, "/api", &client, &registry) else {
+            panic!("expected a healthy backend");
+        };
+        let latency = if &*selected.address == "slow:9000" {
+            1.0
+        } else {
+            0.01
+        };
+        if let Some(stats) = &selected.stats {
+            stats.observe_latency(latency);
+        }
+    }
+    for _ in 0..4 {
+        assert_eq!(
+            select_path(&selector, &routing, "/api", &registry).as_deref(),
+            Some("fast:9000")
+        );
+    }
+}
+
+#[test]
+fn consistent_hash_is_sticky_and_spreads_clients() {
+    let selector = BackendSelector::new();
+    let registry = HealthRegistry::new();
+    let hash = LoadBalance::ConsistentHash { key: HashKey::Ja4 };
+    let backends = ["backend-a:9000", "backend-b:9000", "backend-c:9000"];
+    let routing = table(backends.iter().map(|b| balanced("/", b, hash)).collect());
+    selector.publish(&routing, &registry);
+
+    let mut owners = HashSet::new();
+    for i in 0..64u8 {
+        let ja4 = format!("t13d1516h2_8daaf6152771_{i:012}");
+        let client = ClientKey::new(CLIENT_IP, Some(&ja4));
+        let pick = |client: &ClientKey<'_>| {
+            select_as(&selector, &routing, "/", client, &registry).map(|s| s.address)
+        };
+        let owner = pick(&client);
+        assert_eq!(pick(&client), owner, "same JA4 must map to the same backend");
+        owners.extend(owner);
+    }
+    assert_eq!(owners.len(), backends.len());
+}
+
+#[test]
+fn consistent_hash_only_moves_clients_of_unhealthy_backend() {
+    let selector = BackendSelector::new();
+    let registry = HealthRegistry::new();
+    let hash = LoadBalance::ConsistentHash { key: HashKey::Ip };
+    let backends = ["backend-a:9000", "backend-b:9000", "backend-c:9000"];
+    let health: Vec<_> = backends.iter().map(|b| registry.get_or_create(b)).collect();
+    let routing = table(backends.iter().map(|b| balanced("/", b, hash)).collect());
+    selector.publish(&routing, &registry);
+
+    let clients: Vec<_> = (1..=64u8)
+        .map(|i| ClientKey::new(IpAddr::V4(Ipv4Addr::new(198, 51, 100, i)), None))
+        .collect();
+    let owners = |registry: &HealthRegistry| -> Vec<Option<Arc<str>>> {
+        clients
+            .iter()
+            .map(|c| select_as(&selector, &routing, "/", c, registry).map(|s| s.address))
+            .collect()
+    };
+    let before = owners(&registry);
+    health[0].set(false);
+    let after = owners(&registry);
+    for (old, new) in before.iter().zip(&after) {
+        if old.as_deref() == Some(backends[0]) {
+            assert_ne!(new.as_deref(), Some(backends[0]));
+        } else {
+            assert_eq!(old, new, "clients of healthy backends keep their backend");
+        }
+    }
+}
+
+#[test]
+fn consistent_hash_holds_on_connection_opened_before_reload() {
+    let selector = BackendSelector::new();
+    let registry = HealthRegistry::new();
+    let hash = LoadBalance::ConsistentHash { key: HashKey::Ip };
+    let backends = ["backend-a:9000", "backend-b:9000", "backend-c:9000"];
+    let routes = || backends.iter().map(|b| balanced("/", b, hash)).collect();
+    let before_reload = table(routes());
+    selector.publish(&before_reload, &registry);
+
+    let clients: Vec<_> = (1..=64u8)
+        .map(|i| ClientKey::new(IpAddr::V4(Ipv4Addr::new(198, 51, 100, i)), None))
+        .collect();
+    let owners = |routing: &Arc<RoutingTable>| -> Vec<Option<Arc<str>>> {
+        clients
+            .iter()
+            .map(|c| select_as(&selector, routing, "/", c, &registry).map(|s| s.address))
+            .collect()
+    };
+    let before = owners(&before_reload);
+
+    // A reload compiles a new table; connections accepted earlier keep matching on the old one.
+    let after_reload = table(routes());
+    selector.publish(&after_reload, &registry);
+    assert_eq!(owners(&before_reload), before, "existing connections keep their backend");
+    assert_eq!(owners(&after_reload), before);
+}
+
+#[test]
+fn consistent_hash_holds_for_group_removed_by_reload() {
+    let selector = BackendSelector::new();
+    let registry = HealthRegistry::new();
+    let hash = LoadBalance::ConsistentHash { key: HashKey::Ip };
+    let backends = ["backend-a:9000", "backend-b:9000", "backend-c:9000"];
+    let stale = table(backends.iter().map(|b| balanced("/api", b, hash)).collect());
+    selector.publish(&table(vec![route("/other", "other:9000")]), &registry);
+
+    let mut owners = HashSet::new();
+    for i in 1..=64u8 {
+        let client = ClientKey::new(IpAddr::V4(Ipv4Addr::new(198, 51, 100, i)), None);
+        let owner = select_as(&selector, &stale, "/api", &client, &registry).map(|s| s.address);
+        let again = select_as(&selector, &stale, "/api", &client, &registry).map(|s| s.address);
+        assert_eq!(again, owner, "same client must map to the same backend");
+        owners.extend(owner);
+    }
+    assert_eq!(owners.len(), backends.len());
+}
@@ -206,9 +206,12 @@ async fn capture_fingerprint_values() -> Result<(), Box<dyn std::error::Error +
                 backend: backend_addr.to_string(),
                 fingerprinting: Some(true),
                 force_new_connection: false,
+                load_balance: Default::default(),
                 replace_path: None,
                 security: None,
                 headers: None,
+                cache: None,
+                coalesce: None,
             }],
         }],
         tls: Some(TlsConfig {
@@ -233,7 +236,13 @@ async fn capture_fingerprint_values() -> Result<(), Box<dyn std::error::Error +
             keep_alive: KeepAliveConfig::default(),
         },
         security: SecurityConfig::default(),
-        telemetry: TelemetryConfig { metrics_port: None, otel_log_level: "warn".to_string() },
+        telemetry: TelemetryConfig {
+            metrics_port: None,
+            otel_log_level: "warn".to_string(),
+            timing: Default::default(),
+            debug: Default::default(),
+            fingerprint_export: Default::default(),
+        },
         reload: huginn_proxy_lib::config::ReloadConfig::default(),
         headers: None,
         preserve_host: false,
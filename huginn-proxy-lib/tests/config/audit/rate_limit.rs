@@ -7,15 +7,15 @@ use crate::config::tmp_path;
 type TestResult = Result<(), Box<dyn std::error::Error + Send + Sync>>;
 
 #[test]
-fn warns_on_enabled_rate_limit_with_zero_window() -> TestResult {
-    let path = tmp_path("rl-zero-window");
+fn warns_on_enabled_rate_limit_with_zero_rate() -> TestResult {
+    let path = tmp_path("rl-zero-rate");
     let toml = r#"
 listen = { addrs = ["127.0.0.1:0"] }
 backends = [{ address = "backend:9000" }]
 
 [security.rate_limit]
 enabled = true
-window_seconds = 0
+requests_per_second = 0
 "#;
     fs::write(&path, toml)?;
     let cfg = load_from_path(&path)?;
@@ -23,15 +23,15 @@ window_seconds = 0
     let warnings = rate_limit_warnings(&cfg);
     assert_eq!(warnings.len(), 1, "expected one finding, got: {warnings:?}");
     assert_eq!(warnings[0].scope, "global rate_limit");
-    assert!(warnings[0].message.contains("window_seconds"));
+    assert!(warnings[0].message.contains("requests_per_second"));
 
     let _ = fs::remove_file(&path);
     Ok(())
 }
 
 #[test]
-fn warns_per_scope_for_zero_window() -> TestResult {
-    let path = tmp_path("rl-zero-window-route");
+fn warns_per_scope_for_zero_rate() -> TestResult {
+    let path = tmp_path("rl-zero-rate-route");
     let toml = r#"
 listen = { addrs = ["127.0.0.1:0"] }
 backends = [{ address = "backend:9000" }]
@@ -45,7 +45,7 @@ backend = "backend:9000"
 
 [domains.routes.security.rate_limit]
 enabled = true
-window_seconds = 0
+requests_per_second = 0
 "#;
     fs::write(&path, toml)?;
     let cfg = load_from_path(&path)?;
@@ -107,16 +107,17 @@ limit_by_header = "X-Api-Key"
 }
 
 #[test]
-fn silent_when_disabled_or_positive_window() -> TestResult {
+fn silent_when_disabled_or_positive_rate() -> TestResult {
     let path = tmp_path("rl-ok");
-    // Disabled block with a zero window (inert), and an enabled block with a valid window.
+    // Disabled block with a zero rate (inert), and an enabled block with a valid rate. The
+    // window is not used by the token bucket, so a zero window does not warn.
     let toml = r#"
 listen = { addrs = ["127.0.0.1:0"] }
 backends = [{ address = "backend:9000" }]
 
 [security.rate_limit]
 enabled = false
-window_seconds = 0
+requests_per_second = 0
 
 [[domains]]
 host = "api.example.com"
@@ -124,14 +125,15 @@ routes = [{ prefix = "/", backend = "backend:9000" }]
 
 [domains.security.rate_limit]
 enabled = true
-window_seconds = 1
+requests_per_second = 10
+window_seconds = 0
 "#;
     fs::write(&path, toml)?;
     let cfg = load_from_path(&path)?;
 
     assert!(
         rate_limit_warnings(&cfg).is_empty(),
-        "disabled or positive-window limiters must not warn: {:?}",
+        "disabled or positive-rate limiters must not warn: {:?}",
         rate_limit_warnings(&cfg)
     );
 
@@ -81,6 +81,8 @@ fn effective_config_reports_applied_values_and_defaults() -> TestResult {
     assert_eq!(value["static"]["listen"]["proxy_protocol"]["mode"], "optional");
     assert_eq!(value["static"]["listen"]["proxy_protocol"]["header_timeout_ms"], 100);
     assert_eq!(value["static"]["max_connections"], 512);
+    assert_eq!(value["static"]["admission"]["adaptive_concurrency"]["enabled"], false);
+    assert_eq!(value["static"]["cache"]["max_size_bytes"], 64 * 1024 * 1024);
     assert_eq!(value["static"]["tls"]["client_auth"]["mode"], "required");
     assert_eq!(value["static"]["tls"]["client_auth"]["ca_certificate_configured"], true);
     assert_eq!(value["dynamic"]["domains"][0]["cert_configured"], true);
@@ -1,6 +1,6 @@
 use std::fs;
 
-use huginn_proxy_lib::config::load_from_path;
+use huginn_proxy_lib::config::{load_from_path, AcceptMode};
 
 use super::tmp_path;
 
@@ -304,3 +304,402 @@ backends = [
     let _ = fs::remove_file(&path);
     Ok(())
 }
+
+#[cfg(target_os = "linux")]
+#[test]
+fn loads_accept_sharding() -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let path = tmp_path("accept-sharding");
+    let toml = r#"
+backends = [{ address = "b:9000" }]
+
+[listen]
+addrs = ["127.0.0.1:0"]
+
+[listen.accept]
+mode = "thread_per_core"
+shards = 4
+cpu_steering = true
+"#;
+    fs::write(&path, toml)?;
+    let cfg = load_from_path(&path)?;
+    assert_eq!(cfg.listen.accept.mode, AcceptMode::ThreadPerCore);
+    assert_eq!(cfg.listen.accept.shards, 4);
+    assert!(cfg.listen.accept.cpu_steering);
+    let _ = fs::remove_file(&path);
+    Ok(())
+}
+
+#[test]
+fn rejects_cpu_steering_without_sharding() -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let path = tmp_path("steering-single");
+    let toml = r#"
+listen = { addrs = ["127.0.0.1:0"], accept = { cpu_steering = true } }
+backends = [{ address = "b:9000" }]
+"#;
+    fs::write(&path, toml)?;
+    let err = match load_from_path(&path) {
+        Ok(_) => panic!("should reject cpu_steering in single accept mode"),
+        Err(e) => e.to_string(),
+    };
+    assert!(err.contains("cpu_steering requires"), "got: {err}");
+    let _ = fs::remove_file(&path);
+    Ok(())
+}
+
+#[test]
+fn validates_rate_limit_cluster() -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let path = tmp_path("rate-limit-cluster");
+    let config = |cluster: &str| {
+        format!(
+            r#"
+listen = {{ addrs = ["127.0.0.1:0"] }}
+backends = [{{ address = "b:9000" }}]
+[security.rate_limit_cluster]
+enabled = true
+{cluster}
+"#
+        )
+    };
+
+    fs::write(
+        &path,
+        config(
+            r#"peers = ["10.0.0.2:7420"]
+secret = "0123456789abcdef""#,
+        ),
+    )?;
+    let cfg = load_from_path(&path)?;
+    assert!(cfg.security.rate_limit_cluster.enabled);
+    assert_eq!(cfg.security.rate_limit_cluster.sync_interval_ms, 10);
+
+    for (cluster, expected) in [
+        (
+            r#"peers = ["10.0.0.2:7420"]
+secret = "short""#,
+            "at least 16 bytes",
+        ),
+        (r#"secret = "0123456789abcdef""#, "at least one peer"),
+        (
+            r#"peers = ["10.0.0.2:7420"]
+secret = "0123456789abcdef"
+sync_interval_ms = 0"#,
+            "greater than 0",
+        ),
+    ] {
+        fs::write(&path, config(cluster))?;
+        let err = match load_from_path(&path) {
+            Ok(_) => panic!("should reject rate_limit_cluster: {cluster}"),
+            Err(e) => e.to_string(),
+        };
+        assert!(err.contains(expected), "got: {err}");
+    }
+    let _ = fs::remove_file(&path);
+    Ok(())
+}
+
+#[test]
+fn validates_adaptive_concurrency() -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let path = tmp_path("adaptive-concurrency");
+    let config = |adaptive: &str| {
+        format!(
+            r#"
+listen = {{ addrs = ["127.0.0.1:0"] }}
+backends = [{{ address = "b:9000" }}]
+[admission]
+max_connections_per_ip = 64
+[admission.adaptive_concurrency]
+enabled = true
+{adaptive}
+"#
+        )
+    };
+
+    fs::write(&path, config(""))?;
+    let cfg = load_from_path(&path)?;
+    assert_eq!(cfg.admission.max_connections_per_ip, 64);
+    assert_eq!(cfg.admission.max_scheduler_lag_ms, 0);
+    assert_eq!(cfg.admission.retry_after_secs, 1);
+    assert!(cfg.admission.adaptive_concurrency.enabled);
+    assert_eq!(cfg.admission.adaptive_concurrency.initial_limit, 20);
+
+    for (adaptive, expected) in [
+        ("min_limit = 0", "0 < min_limit"),
+        ("initial_limit = 2000", "initial_limit"),
+        ("latency_tolerance = 1.0", "greater than 1.0"),
+        ("backoff_ratio = 1.0", "between 0.0 and 1.0"),
+    ] {
+        fs::write(&path, config(adaptive))?;
+        let err = match load_from_path(&path) {
+            Ok(_) => panic!("should reject adaptive_concurrency: {adaptive}"),
+            Err(e) => e.to_string(),
+        };
+        assert!(err.contains(expected), "got: {err}");
+    }
+    let _ = fs::remove_file(&path);
+    Ok(())
+}
+
+#[test]
+fn validates_cache() -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let path = tmp_path("cache");
+    let config = |cache: &str| {
+        format!(
+            r#"
+listen = {{ addrs = ["127.0.0.1:0"] }}
+backends = [{{ address = "b:9000" }}]
+[cache]
+{cache}
+[[domains]]
+host = "example.com"
+[[domains.routes]]
+prefix = "/static"
+backend = "b:9000"
+cache = {{ default_ttl_secs = 30 }}
+"#
+        )
+    };
+
+    fs::write(&path, config(""))?;
+    let cfg = load_from_path(&path)?;
+    assert_eq!(cfg.cache.max_size_bytes, 64 * 1024 * 1024);
+    assert_eq!(cfg.cache.max_object_bytes, 1024 * 1024);
+    let route_cache = cfg.domains[0].routes[0]
+        .cache
+        .as_ref()
+        .ok_or("route cache missing")?;
+    assert_eq!(route_cache.default_ttl_secs, 30);
+    assert!(!route_cache.key_fingerprints);
+
+    fs::write(&path, config("max_size_bytes = 0\nmax_object_bytes = 0"))?;
+    assert_eq!(load_from_path(&path)?.cache.max_size_bytes, 0);
+
+    for cache in ["max_object_bytes = 0", "max_size_bytes = 1600\nmax_object_bytes = 101"] {
+        fs::write(&path, config(cache))?;
+        let err = match load_from_path(&path) {
+            Ok(_) => panic!("should reject cache: {cache}"),
+            Err(e) => e.to_string(),
+        };
+        assert!(err.contains("cache.max_object_bytes"), "got: {err}");
+    }
+    let _ = fs::remove_file(&path);
+    Ok(())
+}
+
+#[test]
+fn parses_route_coalesce() -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let path = tmp_path("coalesce");
+    let config = |coalesce: &str| {
+        format!(
+            r#"
+listen = {{ addrs = ["127.0.0.1:0"] }}
+backends = [{{ address = "b:9000" }}]
+[[domains]]
+host = "example.com"
+[[domains.routes]]
+prefix = "/"
+backend = "b:9000"
+coalesce = {{ {coalesce} }}
+"#
+        )
+    };
+
+    fs::write(&path, config(r#"vary = ["Accept-Encoding"]"#))?;
+    let cfg = load_from_path(&path)?;
+    let coalesce = cfg.domains[0].routes[0]
+        .coalesce
+        .as_ref()
+        .ok_or("route coalesce missing")?;
+    assert_eq!(coalesce.vary, [http::header::ACCEPT_ENCODING]);
+    assert_eq!(coalesce.max_wait_ms, 2000);
+    assert_eq!(coalesce.max_body_bytes, 1024 * 1024);
+
+    fs::write(&path, config(r#"vary = ["bad header"]"#))?;
+    let err = match load_from_path(&path) {
+        Ok(_) => panic!("should reject an invalid vary header name"),
+        Err(e) => e.to_string(),
+    };
+    assert!(err.contains("Invalid header name 'bad header'"), "got: {err}");
+    let _ = fs::remove_file(&path);
+    Ok(())
+}
+
+#[test]
+fn validates_telemetry_timing() -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let path = tmp_path("timing");
+    let config = |timing: &str| {
+        format!(
+            r#"
+listen = {{ addrs = ["127.0.0.1:0"] }}
+backends = [{{ address = "b:9000" }}]
+[telemetry.timing]
+{timing}
+[[domains]]
+host = "example.com"
+[[domains.routes]]
+prefix = "/"
+backend = "b:9000"
+"#
+        )
+    };
+
+    fs::write(&path, config(""))?;
+    let timing = load_from_path(&path)?.telemetry.timing;
+    assert!(timing.server_timing_cidrs.is_empty());
+    assert_eq!(timing.slow_request_ms, 0);
+    assert_eq!(timing.slow_request_sample, 1);
+
+    fs::write(&path, config("server_timing_cidrs = [\"10.0.0.0/8\"]\nslow_request_ms = 250"))?;
+    let timing = load_from_path(&path)?.telemetry.timing;
+    assert_eq!(timing.server_timing_cidrs, ["10.0.0.0/8".parse::<ipnet::IpNet>()?]);
+    assert_eq!(timing.slow_request_ms, 250);
+
+    for (timing, expected) in [
+        ("slow_request_sample = 0", "telemetry.timing.slow_request_sample"),
+        ("server_timing_cidrs = [\"10.0.0.0/33\"]", "Invalid IP network '10.0.0.0/33'"),
+    ] {
+        fs::write(&path, config(timing))?;
+        let err = match load_from_path(&path) {
+            Ok(_) => panic!("should reject timing: {timing}"),
+            Err(e) => e.to_string(),
+        };
+        assert!(err.contains(expected), "got: {err}");
+    }
+    let _ = fs::remove_file(&path);
+    Ok(())
+}
+
+#[test]
+fn validates_telemetry_debug() -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let path = tmp_path("debug");
+    let config = |debug: &str| {
+        format!(
+            r#"
+listen = {{ addrs = ["127.0.0.1:0"] }}
+backends = [{{ address = "b:9000" }}]
+[telemetry.debug]
+{debug}
+[[domains]]
+host = "example.com"
+[[domains.routes]]
+prefix = "/"
+backend = "b:9000"
+"#
+        )
+    };
+
+    fs::write(&path, config(""))?;
+    let debug = load_from_path(&path)?.telemetry.debug;
+    assert!(!debug.enabled);
+    assert_eq!(debug.max_window_seconds, 60);
+
+    fs::write(&path, config("enabled = true\ntoken = \"0123456789abcdef\""))?;
+    let debug = load_from_path(&path)?.telemetry.debug;
+    assert!(debug.enabled);
+    assert_eq!(debug.token.expose(), "0123456789abcdef");
+
+    for (debug, expected) in [
+        ("enabled = true", "telemetry.debug.token must be at least 16 bytes"),
+        (
+            "enabled = true\ntoken = \"short\"",
+            "telemetry.debug.token must be at least 16 bytes",
+        ),
+        (
+            "enabled = true\ntoken = \"0123456789abcdef\"\nmax_window_seconds = 0",
+            "telemetry.debug.max_window_seconds",
+        ),
+    ] {
+        fs::write(&path, config(debug))?;
+        let err = match load_from_path(&path) {
+            Ok(_) => panic!("should reject debug: {debug}"),
+            Err(e) => e.to_string(),
+        };
+        assert!(err.contains(expected), "got: {err}");
+    }
+    let _ = fs::remove_file(&path);
+    Ok(())
+}
+
+#[test]
+fn validates_shared_session_cache() -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let path = tmp_path("shared-session-cache");
+    let config = |resumption: &str| {
+        format!(
+            r#"
+listen = {{ addrs = ["127.0.0.1:8443"] }}
+backends = [{{ address = "b:9000" }}]
+[tls.session_resumption]
+{resumption}
+[tls.session_resumption.shared_cache]
+memcached = "memcached:11211"
+"#
+        )
+    };
+
+    fs::write(&path, config("ticket_keys_path = \"/run/secrets/tls-ticket-keys\""))?;
+    assert!(load_from_path(&path)?.tls.is_some());
+    fs::write(&path, config("enabled = false"))?;
+    assert!(load_from_path(&path).is_ok());
+
+    fs::write(&path, config(""))?;
+    let err = match load_from_path(&path) {
+        Ok(_) => panic!("should reject shared_cache without ticket keys"),
+        Err(e) => e.to_string(),
+    };
+    assert!(err.contains("shared_cache requires ticket_keys_path"), "got: {err}");
+    let _ = fs::remove_file(&path);
+    Ok(())
+}
+
+#[test]
+fn validates_telemetry_fingerprint_export() -> Result<(), Box<dyn std::error::Error + Send + Sync>>
+{
+    let path = tmp_path("fingerprint_export");
+    let config = |export: &str| {
+        format!(
+            r#"
+listen = {{ addrs = ["127.0.0.1:0"] }}
+backends = [{{ address = "b:9000" }}]
+[telemetry.fingerprint_export]
+{export}
+[[domains]]
+host = "example.com"
+[[domains.routes]]
+prefix = "/"
+backend = "b:9000"
+"#
+        )
+    };
+
+    fs::write(&path, config(""))?;
+    let export = load_from_path(&path)?.telemetry.fingerprint_export;
+    assert!(!export.enabled);
+    assert_eq!(export.queue_capacity, 65_536);
+    assert_eq!(export.batch_size, 1_024);
+    assert_eq!(export.flush_interval_ms, 1_000);
+
+    fs::write(&path, config("enabled = true\nendpoint = \"127.0.0.1:9000\""))?;
+    let export = load_from_path(&path)?.telemetry.fingerprint_export;
+    assert!(export.enabled);
+    assert_eq!(export.endpoint.as_deref(), Some("127.0.0.1:9000"));
+
+    for (export, expected) in [
+        ("enabled = true", "exactly one of path or endpoint"),
+        (
+            "enabled = true\npath = \"/tmp/fp.ndjson\"\nendpoint = \"127.0.0.1:9000\"",
+            "exactly one of path or endpoint",
+        ),
+        (
+            "enabled = true\npath = \"/tmp/fp.ndjson\"\nqueue_capacity = 0",
+            "queue_capacity, batch_size and flush_interval_ms",
+        ),
+    ] {
+        fs::write(&path, config(export))?;
+        let err = match load_from_path(&path) {
+            Ok(_) => panic!("should reject fingerprint_export: {export}"),
+            Err(e) => e.to_string(),
+        };
+        assert!(err.contains(expected), "got: {err}");
+    }
+    let _ = fs::remove_file(&path);
+    Ok(())
+}
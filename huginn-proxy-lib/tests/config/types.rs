@@ -1,5 +1,6 @@
 use huginn_proxy_lib::config::{
-    Backend, BackendHttpVersion, ClientAuth, Config, HealthCheckConfig, HealthCheckType, TlsConfig,
+    Backend, BackendHttpVersion, ClientAuth, Config, HashKey, HealthCheckConfig, HealthCheckType,
+    LoadBalance, TlsConfig,
 };
 
 #[test]
@@ -316,3 +317,82 @@ backends = [
     config.validate_cross_refs()?;
     Ok(())
 }
+
+#[test]
+fn test_route_load_balance_parsing() -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let toml = r#"
+listen = { addrs = ["0.0.0.0:7000"] }
+backends = [{ address = "a:1" }, { address = "b:1" }]
+
+[[domains]]
+routes = [
+  { prefix = "/rr", backend = "a:1" },
+  { prefix = "/lo", backend = "a:1", load_balance = { strategy = "least_outstanding" } },
+  { prefix = "/p2c", backend = "a:1", load_balance = { strategy = "p2c_ewma" } },
+  { prefix = "/ip", backend = "a:1", load_balance = { strategy = "consistent_hash" } },
+  { prefix = "/ja4", backend = "a:1", load_balance = { strategy = "consistent_hash", hash_key = "ja4" } },
+  { prefix = "/ja4", backend = "b:1", load_balance = { strategy = "consistent_hash", hash_key = "ja4" } },
+]
+"#;
+    let config: Config = toml::from_str(toml)?;
+    let strategies: Vec<_> = config.domains[0]
+        .routes
+        .iter()
+        .map(|r| r.load_balance)
+        .collect();
+    assert_eq!(
+        strategies,
+        [
+            LoadBalance::RoundRobin,
+            LoadBalance::LeastOutstanding,
+            LoadBalance::P2cEwma,
+            LoadBalance::ConsistentHash { key: HashKey::Ip },
+            LoadBalance::ConsistentHash { key: HashKey::Ja4 },
+            LoadBalance::ConsistentHash { key: HashKey::Ja4 },
+        ]
+    );
+    config.validate_cross_refs()?;
+    Ok(())
+}
+
+#[test]
+fn test_route_load_balance_rejects_invalid_tables() {
+    let parse = |load_balance: &str| {
+        let toml = format!(
+            r#"
+listen = {{ addrs = ["0.0.0.0:7000"] }}
+backends = [{{ address = "a:1" }}]
+
+[[domains]]
+routes = [{{ prefix = "/", backend = "a:1", load_balance = {load_balance} }}]
+"#
+        );
+        toml::from_str::<Config>(&toml)
+    };
+    assert!(parse(r#"{ strategy = "random" }"#).is_err());
+    assert!(parse(r#"{ strategy = "round_robin", hash_key = "ip" }"#).is_err());
+    assert!(parse(r#"{ strategy = "consistent_hash", hash_key = "cookie" }"#).is_err());
+    assert!(parse(r#"{ strategy = "p2c_ewma", weight = 2 }"#).is_err());
+    assert!(parse("{}").is_ok());
+}
+
+#[test]
+fn test_route_group_with_mixed_load_balance_is_rejected(
+) -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let toml = r#"
+listen = { addrs = ["0.0.0.0:7000"] }
+backends = [{ address = "a:1" }, { address = "b:1" }]
+
+[[domains]]
+routes = [
+  { prefix = "/api", backend = "a:1", load_balance = { strategy = "least_outstanding" } },
+  { prefix = "/api", backend = "b:1" },
+]
+"#;
+    let config: Config = toml::from_str(toml)?;
+    let Err(err) = config.validate_cross_refs() else {
+        panic!("routes of one group with different strategies must be rejected");
+    };
+    assert!(err.to_string().contains("load_balance"), "{err}");
+    Ok(())
+}
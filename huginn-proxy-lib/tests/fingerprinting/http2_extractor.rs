@@ -72,7 +72,7 @@ fn http2_preface_and_settings() -> Vec<u8> {
 async fn test_capturing_stream_basic() -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
     let (tx, _rx) = watch::channel(None);
     let mock_stream = MockStream::new(http2_preface_and_settings());
-    let (mut capturing, _extracted) =
+    let mut capturing =
         CapturingStream::new(mock_stream, 64 * 1024, tx, huginn_proxy_lib::Metrics::new_noop());
 
     let mut buf = vec![0u8; 1024];
@@ -94,7 +94,7 @@ async fn test_capturing_stream_max_capture() -> Result<(), Box<dyn std::error::E
     let large_data = vec![0u8; 100 * 1024]; // 100KB
     let mock_stream = MockStream::new(large_data);
     let max_capture = 64 * 1024; // 64KB limit
-    let (mut capturing, _extracted) =
+    let mut capturing =
         CapturingStream::new(mock_stream, max_capture, tx, huginn_proxy_lib::Metrics::new_noop());
 
     let mut buf = vec![0u8; 1024];
@@ -120,7 +120,7 @@ async fn test_capturing_stream_write_passthrough(
 ) -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
     let (tx, _rx) = watch::channel(None);
     let mock_stream = MockStream::new(vec![]);
-    let (mut capturing, _extracted) =
+    let mut capturing =
         CapturingStream::new(mock_stream, 64 * 1024, tx, huginn_proxy_lib::Metrics::new_noop());
 
     // Write should pass through
@@ -133,3 +133,146 @@ async fn test_capturing_stream_write_passthrough(
 
     Ok(())
 }
+
+type TestResult = Result<(), Box<dyn std::error::Error + Send + Sync>>;
+
+const WINDOW_UPDATE_INCREMENT: u32 = 15_663_105;
+
+fn frame(frame_type: u8, flags: u8, stream_id: u32, payload: &[u8]) -> Vec<u8> {
+    let len = u32::try_from(payload.len())
+        .unwrap_or(u32::MAX)
+        .to_be_bytes();
+    let mut data = vec![len[1], len[2], len[3], frame_type, flags];
+    data.extend_from_slice(&stream_id.to_be_bytes());
+    data.extend_from_slice(payload);
+    data
+}
+
+/// HPACK block for `:method GET`, `:path /`, `:scheme https`, `:authority localhost`.
+fn request_header_block() -> Vec<u8> {
+    let mut block = vec![0x82, 0x84, 0x87, 0x41, 0x09];
+    block.extend_from_slice(b"localhost");
+    block
+}
+
+/// Client first flight up to the first HEADERS frame, built from `header_frames`.
+fn client_first_flight(header_frames: &[Vec<u8>]) -> Vec<u8> {
+    let mut data = b"PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n".to_vec();
+    // SETTINGS: HEADER_TABLE_SIZE = 65536, INITIAL_WINDOW_SIZE = 6291456
+    data.extend(frame(
+        0x4,
+        0,
+        0,
+        &[0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x04, 0x00, 0x60, 0x00, 0x00],
+    ));
+    data.extend(frame(0x8, 0, 0, &WINDOW_UPDATE_INCREMENT.to_be_bytes()));
+    for header_frame in header_frames {
+        data.extend_from_slice(header_frame);
+    }
+    // A DATA frame after the header block is passed through untouched.
+    data.extend(frame(0x0, 0x1, 1, b"body"));
+    data
+}
+
+async fn read_all<S: AsyncRead + Unpin>(stream: &mut S, chunk: usize) -> std::io::Result<Vec<u8>> {
+    use tokio::io::AsyncReadExt;
+    let mut out = Vec::new();
+    let mut buf = vec![0u8; chunk];
+    loop {
+        let read = stream.read(&mut buf).await?;
+        if read == 0 {
+            return Ok(out);
+        }
+        out.extend_from_slice(buf.get(..read).ok_or(std::io::ErrorKind::InvalidData)?);
+    }
+}
+
+async fn assert_fingerprint_extracted(data: Vec<u8>, chunk: usize) -> TestResult {
+    let (tx, rx) = watch::channel(None);
+    let mut capturing = CapturingStream::new(
+        MockStream::new(data.clone()),
+        64 * 1024,
+        tx,
+        huginn_proxy_lib::Metrics::new_noop(),
+    );
+
+    let passed_through = read_all(&mut capturing, chunk).await?;
+
+    assert_eq!(passed_through, data);
+    assert!(!capturing.is_capturing());
+    let fingerprint = rx
+        .borrow()
+        .clone()
+        .ok_or("expected an Akamai fingerprint")?;
+    assert!(fingerprint
+        .akamai
+        .fingerprint
+        .contains(&WINDOW_UPDATE_INCREMENT.to_string()));
+    let header_value = fingerprint
+        .header_value
+        .ok_or("expected an encoded header value")?;
+    assert_eq!(header_value.as_bytes(), fingerprint.akamai.fingerprint.as_bytes());
+    Ok(())
+}
+
+#[tokio::test]
+async fn test_capturing_stream_extracts_fingerprint() -> TestResult {
+    let headers = frame(0x1, 0x5, 1, &request_header_block());
+    assert_fingerprint_extracted(client_first_flight(&[headers]), 1024).await
+}
+
+#[tokio::test]
+async fn test_capturing_stream_extracts_fingerprint_across_reads() -> TestResult {
+    // One byte per read: the preface, every frame header and payload are split.
+    let headers = frame(0x1, 0x5, 1, &request_header_block());
+    assert_fingerprint_extracted(client_first_flight(&[headers]), 1).await
+}
+
+#[tokio::test]
+async fn test_capturing_stream_header_block_with_continuation() -> TestResult {
+    let block = request_header_block();
+    let (first, rest) = block.split_at(3);
+    let headers = frame(0x1, 0x1, 1, first);
+    let continuation = frame(0x9, 0x4, 1, rest);
+    assert_fingerprint_extracted(client_first_flight(&[headers, continuation]), 1024).await
+}
+
+#[tokio::test]
+async fn test_capturing_stream_http11_passthrough() -> TestResult {
+    let (tx, rx) = watch::channel(None);
+    let request = b"GET / HTTP/1.1\r\nHost: localhost\r\n\r\n".to_vec();
+    let mut capturing = CapturingStream::new(
+        MockStream::new(request.clone()),
+        64 * 1024,
+        tx,
+        huginn_proxy_lib::Metrics::new_noop(),
+    );
+
+    let passed_through = read_all(&mut capturing, 1024).await?;
+
+    assert_eq!(passed_through, request);
+    assert!(!capturing.is_capturing());
+    assert!(rx.borrow().is_none());
+    Ok(())
+}
+
+#[tokio::test]
+async fn test_capturing_stream_gives_up_at_max_capture() -> TestResult {
+    let (tx, rx) = watch::channel(None);
+    let headers = frame(0x1, 0x5, 1, &request_header_block());
+    let data = client_first_flight(&[headers]);
+    // Limit ends inside the WINDOW_UPDATE frame, before the first HEADERS frame.
+    let mut capturing = CapturingStream::new(
+        MockStream::new(data.clone()),
+        50,
+        tx,
+        huginn_proxy_lib::Metrics::new_noop(),
+    );
+
+    let passed_through = read_all(&mut capturing, 1024).await?;
+
+    assert_eq!(passed_through, data);
+    assert!(!capturing.is_capturing());
+    assert!(rx.borrow().is_none());
+    Ok(())
+}
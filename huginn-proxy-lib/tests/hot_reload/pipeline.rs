@@ -49,9 +49,12 @@ fn minimal_config(backend_addr: std::net::SocketAddr, listen_port: u16) -> Confi
                 backend: backend_addr.to_string(),
                 fingerprinting: Some(false),
                 force_new_connection: false,
+                load_balance: Default::default(),
                 replace_path: None,
                 security: None,
                 headers: None,
+                cache: None,
+                coalesce: None,
             }],
         }],
         tls: None,
@@ -71,7 +74,13 @@ fn minimal_config(backend_addr: std::net::SocketAddr, listen_port: u16) -> Confi
             keep_alive: KeepAliveConfig::default(),
         },
         security: SecurityConfig::default(),
-        telemetry: TelemetryConfig { metrics_port: None, otel_log_level: "warn".to_string() },
+        telemetry: TelemetryConfig {
+            metrics_port: None,
+            otel_log_level: "warn".to_string(),
+            timing: Default::default(),
+            debug: Default::default(),
+            fingerprint_export: Default::default(),
+        },
         reload: ReloadConfig::default(),
         headers: None,
         preserve_host: false,
@@ -90,8 +99,8 @@ fn into_shared(
     let huginn_proxy_lib::config::ConfigParts { static_cfg, dynamic_cfg } = config.into_parts();
     let static_cfg = Arc::new(static_cfg);
     let shared_dyn = Arc::new(ArcSwap::from_pointee(dynamic_cfg));
-    let rate_limiter = initial_rate_limiter(&shared_dyn.load());
-    let client_pool = initial_client_pool(&static_cfg, &shared_dyn.load().backend_pool);
+    let rate_limiter = initial_rate_limiter(&shared_dyn.load(), false);
+    let client_pool = initial_client_pool(&static_cfg, &shared_dyn.load());
     (static_cfg, shared_dyn, rate_limiter, client_pool)
 }
 
@@ -121,6 +130,7 @@ async fn reload_invalid_toml_keeps_current_config() -> TestResult {
         &metrics,
         &health_supervisor,
         None,
+        None,
     )
     .await;
 
@@ -168,6 +178,7 @@ async fn drain_removed_backend_replaces_pool() -> TestResult {
         &metrics,
         &health_supervisor,
         None,
+        None,
     )
     .await;
 
@@ -214,6 +225,7 @@ async fn reload_static_change_proceeds_without_crash() -> TestResult {
         &metrics,
         &health_supervisor,
         None,
+        None,
     )
     .await;
 
@@ -264,6 +276,7 @@ async fn concurrent_reloads_are_serialized() -> TestResult {
                 &metrics,
                 health_supervisor.as_ref(),
                 None,
+                None,
             )
             .await;
         }));
@@ -312,6 +325,7 @@ async fn reload_toggles_rate_limiter() -> TestResult {
         &metrics,
         &health_supervisor,
         None,
+        None,
     )
     .await;
 
@@ -332,6 +346,7 @@ async fn reload_toggles_rate_limiter() -> TestResult {
         &metrics,
         &health_supervisor,
         None,
+        None,
     )
     .await;
 
@@ -33,7 +33,13 @@ fn create_test_config(listen: &str, backends: Vec<Backend>) -> Config {
             keep_alive: KeepAliveConfig::default(),
         },
         security: SecurityConfig::default(),
-        telemetry: TelemetryConfig { metrics_port: None, otel_log_level: "warn".to_string() },
+        telemetry: TelemetryConfig {
+            metrics_port: None,
+            otel_log_level: "warn".to_string(),
+            timing: Default::default(),
+            debug: Default::default(),
+            fingerprint_export: Default::default(),
+        },
         reload: ReloadConfig::default(),
         headers: None,
     }
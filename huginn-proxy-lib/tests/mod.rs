@@ -5,4 +5,5 @@ mod helpers;
 mod hot_reload;
 mod proxy;
 mod security;
+mod telemetry;
 mod tls;
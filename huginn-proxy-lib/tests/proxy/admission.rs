@@ -0,0 +1,222 @@
+use std::net::{IpAddr, Ipv4Addr, SocketAddr};
+use std::sync::atomic::AtomicUsize;
+use std::sync::{Arc, Barrier};
+use std::time::Duration;
+
+use huginn_proxy_lib::config::AdaptiveConcurrencyConfig;
+use huginn_proxy_lib::proxy::admission::{AdaptiveLimit, PerIpLimit, SchedulerLag};
+use huginn_proxy_lib::proxy::connection::{ConnectionError, ConnectionManager};
+use huginn_proxy_lib::telemetry::Metrics;
+
+fn config() -> AdaptiveConcurrencyConfig {
+    AdaptiveConcurrencyConfig {
+        enabled: true,
+        initial_limit: 10,
+        min_limit: 2,
+        max_limit: 12,
+        latency_tolerance: 2.0,
+        backoff_ratio: 0.5,
+    }
+}
+
+fn ip(last: u8) -> IpAddr {
+    IpAddr::V4(Ipv4Addr::new(198, 51, 100, last))
+}
+
+#[test]
+fn adaptive_limit_admits_up_to_limit() {
+    let limit = AdaptiveLimit::new(2, Box::new([]));
+    assert!(limit.try_acquire());
+    assert!(limit.try_acquire());
+    assert!(!limit.try_acquire());
+    limit.release();
+    assert!(limit.try_acquire());
+    assert_eq!(limit.in_flight(), 2);
+}
+
+#[test]
+fn adaptive_limit_grows_only_when_saturated() {
+    let config = config();
+    let limit = AdaptiveLimit::new(10, Box::new([]));
+
+    // One request in flight out of ten: the limit is not what bounds concurrency.
+    assert!(limit.try_acquire());
+    for _ in 0..100 {
+        assert_eq!(limit.observe(Duration::from_millis(10), false, &config), None);
+    }
+    assert_eq!(limit.limit(), 10);
+    assert_eq!(limit.baseline(), 0.010);
+
+    for _ in 1..10 {
+        assert!(limit.try_acquire());
+    }
+    // +1/limit per response: about ten fast responses raise it by one.
+    let mut raised = None;
+    for _ in 0..11 {
+        raised = raised.or(limit.observe(Duration::from_millis(10), false, &config));
+    }
+    assert_eq!(raised, Some(11));
+
+    // Capped at max_limit.
+    for _ in 0..1000 {
+        limit.observe(Duration::from_millis(10), false, &config);
+    }
+    assert_eq!(limit.limit(), 12);
+}
+
+#[test]
+fn adaptive_limit_backs_off_once_per_round_trip() {
+    let config = config();
+    let limit = AdaptiveLimit::new(10, Box::new([]));
+    limit.observe(Duration::from_millis(5), false, &config);
+
+    // Slower than tolerance × baseline: multiplicative decrease, baseline untouched.
+    assert_eq!(limit.observe(Duration::from_secs(30), false, &config), Some(5));
+    assert_eq!(limit.baseline(), 0.005);
+    // The requests already in flight answer just as slowly; they must not decrease it again.
+    assert_eq!(limit.observe(Duration::from_secs(30), true, &config), None);
+    assert_eq!(limit.limit(), 5);
+}
+
+#[test]
+fn adaptive_limit_never_backs_off_below_min() {
+    let config = config();
+    let limit = AdaptiveLimit::new(3, Box::new([]));
+    assert_eq!(limit.observe(Duration::ZERO, true, &config), Some(2));
+    assert_eq!(limit.limit(), 2);
+}
+
+#[test]
+fn per_ip_limit_caps_each_client() {
+    let table = Arc::new(PerIpLimit::new(2));
+    let first = table.try_acquire(ip(1));
+    let second = table.try_acquire(ip(1));
+    assert!(first.is_some() && second.is_some());
+    assert!(table.try_acquire(ip(1)).is_none());
+    assert_eq!(table.count(ip(1)), 2);
+
+    // Other clients keep their own budget.
+    assert!(table.try_acquire(ip(2)).is_some());
+
+    drop(first);
+    assert_eq!(table.count(ip(1)), 1);
+    assert!(table.try_acquire(ip(1)).is_some());
+}
+
+#[test]
+fn per_ip_limit_releases_on_drop() {
+    let table = Arc::new(PerIpLimit::new(1));
+    let guards: Vec<_> = (0..=255)
+        .filter_map(|last| table.try_acquire(ip(last)))
+        .collect();
+    assert_eq!(guards.len(), 256);
+    assert_eq!(table.clients(), 256);
+    drop(guards);
+    for last in 0..=255 {
+        assert_eq!(table.count(ip(last)), 0);
+    }
+    // Clients without connections are not kept.
+    assert_eq!(table.clients(), 0);
+}
+
+#[test]
+fn per_ip_limit_is_exact_for_clients_sharing_a_shard() {
+    // More clients than shards, so some of them share a shard's map; each still gets its full
+    // cap, and refused attempts do not count against anyone.
+    const _: () = assert!(PerIpLimit::SHARDS < 256);
+    let table = Arc::new(PerIpLimit::new(2));
+    let mut guards = Vec::new();
+    for last in 0..=255 {
+        guards.push(table.try_acquire(ip(last)));
+        guards.push(table.try_acquire(ip(last)));
+        assert!(table.try_acquire(ip(last)).is_none());
+    }
+    assert!(guards.iter().all(Option::is_some));
+    for last in 0..=255 {
+        assert_eq!(table.count(ip(last)), 2);
+    }
+    assert_eq!(table.clients(), 256);
+}
+
+#[test]
+fn scheduler_lag_smooths_samples() {
+    let lag = SchedulerLag::new(Duration::from_millis(20));
+    // A single slow poll does not cross the threshold.
+    lag.observe(Duration::from_millis(60));
+    assert!(!lag.saturated());
+    for _ in 0..10 {
+        lag.observe(Duration::from_millis(60));
+    }
+    assert!(lag.saturated());
+    for _ in 0..20 {
+        lag.observe(Duration::ZERO);
+    }
+    assert!(!lag.saturated());
+}
+
+#[test]
+fn try_accept_enforces_limits() {
+    let metrics = Metrics::new_noop();
+    let (closed_tx, _closed_rx) = tokio::sync::watch::channel(());
+    let manager =
+        ConnectionManager::new(2, Arc::new(AtomicUsize::new(0)), closed_tx).with_per_ip_limit(1);
+    let peer = SocketAddr::new(ip(1), 40000);
+
+    let first = manager.try_accept(peer, None, &metrics);
+    let second = manager.try_accept(peer, None, &metrics);
+    assert!(first.is_ok() && second.is_ok());
+    assert!(matches!(
+        manager.try_accept(peer, None, &metrics),
+        Err(ConnectionError::LimitExceeded { current: 2, limit: 2 })
+    ));
+    drop(first);
+
+    let lagging = SchedulerLag::new(Duration::from_millis(1));
+    for _ in 0..20 {
+        lagging.observe(Duration::from_millis(50));
+    }
+    assert!(matches!(
+        manager.try_accept(peer, Some(&lagging), &metrics),
+        Err(ConnectionError::SchedulerLag { .. })
+    ));
+    assert!(manager.try_accept(peer, None, &metrics).is_ok());
+
+    let client = manager.try_accept_client(peer.ip(), &metrics);
+    assert!(matches!(client, Ok(Some(_))));
+    assert!(matches!(
+        manager.try_accept_client(peer.ip(), &metrics),
+        Err(ConnectionError::PerIpLimitExceeded { limit: 1, .. })
+    ));
+}
+
+#[test]
+fn try_accept_never_exceeds_max_connections_under_contention() {
+    let metrics = Metrics::new_noop();
+    let (closed_tx, _closed_rx) = tokio::sync::watch::channel(());
+    let manager = Arc::new(ConnectionManager::new(8, Arc::new(AtomicUsize::new(0)), closed_tx));
+    let peer = SocketAddr::new(ip(1), 40000);
+    let done = Arc::new(Barrier::new(16));
+
+    let accepted: usize = std::thread::scope(|scope| {
+        let workers: Vec<_> = (0..16)
+            .map(|_| {
+                let manager = Arc::clone(&manager);
+                let metrics = Arc::clone(&metrics);
+                let done = Arc::clone(&done);
+                scope.spawn(move || {
+                    let guards: Vec<_> = (0..4)
+                        .filter_map(|_| manager.try_accept(peer, None, &metrics).ok())
+                        .collect();
+                    // Held until every worker is done trying.
+                    done.wait();
+                    guards.len()
+                })
+            })
+            .collect();
+        workers
+            .into_iter()
+            .map(|worker| worker.join().unwrap_or(0))
+            .sum()
+    });
+    assert_eq!(accepted, 8);
+}
@@ -0,0 +1,265 @@
+use bytes::Bytes;
+use http::header::{ACCEPT_ENCODING, AGE, AUTHORIZATION, CACHE_CONTROL, CONTENT_LENGTH, VARY};
+use http::{HeaderMap, HeaderValue, Method, Request, Response, StatusCode};
+use http_body_util::{combinators::BoxBody, BodyExt, Full};
+use huginn_proxy_lib::config::{CacheConfig, RouteCacheConfig};
+use huginn_proxy_lib::proxy::cache::policy::{self, RequestPolicy};
+use huginn_proxy_lib::proxy::cache::{CacheKey, Lookup, ResponseCache};
+use huginn_proxy_lib::telemetry::{Metrics, RouteAttributes};
+use tokio::time::Duration;
+
+type R = Result<(), Box<dyn std::error::Error + Send + Sync>>;
+
+fn key(path_and_query: &str) -> CacheKey<'_> {
+    CacheKey {
+        https: true,
+        host: "example.com",
+        backend: "backend:80",
+        path_and_query,
+        fingerprint: None,
+    }
+}
+
+fn request(method: Method, headers: &[(&'static str, &'static str)]) -> Request<()> {
+    let mut req = Request::new(());
+    *req.method_mut() = method;
+    for (name, value) in headers {
+        req.headers_mut()
+            .insert(*name, HeaderValue::from_static(value));
+    }
+    req
+}
+
+fn response(
+    headers: &[(&'static str, &'static str)],
+    body: impl Into<Bytes>,
+) -> Response<BoxBody<Bytes, hyper::Error>> {
+    let mut resp = Response::new(
+        Full::new(body.into())
+            .map_err(|never| match never {})
+            .boxed(),
+    );
+    for (name, value) in headers {
+        resp.headers_mut()
+            .insert(*name, HeaderValue::from_static(value));
+    }
+    resp
+}
+
+fn cache_control(value: &'static str) -> HeaderMap {
+    let mut headers = HeaderMap::new();
+    headers.insert(CACHE_CONTROL, HeaderValue::from_static(value));
+    headers
+}
+
+/// Look `req` up and, on a miss, store `resp` for it. Returns whether the lookup hit.
+async fn fetch(
+    cache: &ResponseCache,
+    req: &Request<()>,
+    key: &CacheKey<'_>,
+    resp: Response<BoxBody<Bytes, hyper::Error>>,
+) -> Result<bool, Box<dyn std::error::Error + Send + Sync>> {
+    let metrics = Metrics::new_noop();
+    let route = RouteAttributes::new("/", "example.com");
+    match cache.lookup(req, key, &RouteCacheConfig::default(), &route, &metrics) {
+        Lookup::Hit(_) => Ok(true),
+        Lookup::Forward(Some(pending)) => {
+            cache.store(pending, resp, &metrics).await?;
+            Ok(false)
+        }
+        Lookup::Forward(None) => Ok(false),
+    }
+}
+
+#[test]
+fn test_request_policy() {
+    let none = HeaderMap::new();
+    assert_eq!(policy::request_policy(&Method::GET, &none), RequestPolicy::Cacheable);
+    assert_eq!(policy::request_policy(&Method::HEAD, &none), RequestPolicy::Cacheable);
+    assert_eq!(policy::request_policy(&Method::POST, &none), RequestPolicy::Bypass);
+
+    let mut auth = HeaderMap::new();
+    auth.insert(AUTHORIZATION, HeaderValue::from_static("Bearer x"));
+    assert_eq!(policy::request_policy(&Method::GET, &auth), RequestPolicy::Bypass);
+
+    assert_eq!(
+        policy::request_policy(&Method::GET, &cache_control("no-store")),
+        RequestPolicy::Bypass
+    );
+    assert_eq!(
+        policy::request_policy(&Method::GET, &cache_control("max-age=0")),
+        RequestPolicy::Revalidate
+    );
+    assert_eq!(
+        policy::request_policy(&Method::GET, &cache_control("no-cache")),
+        RequestPolicy::Revalidate
+    );
+    assert_eq!(
+        policy::request_policy(&Method::GET, &cache_control("max-age=60")),
+        RequestPolicy::Cacheable
+    );
+}
+
+#[test]
+fn test_freshness() {
+    let ttl = Duration::from_secs(5);
+    assert_eq!(
+        policy::freshness(StatusCode::OK, &cache_control("public, max-age=60"), ttl),
+        Some(Duration::from_secs(60))
+    );
+    assert_eq!(
+        policy::freshness(StatusCode::OK, &cache_control("max-age=60, s-maxage=\"120\""), ttl),
+        Some(Duration::from_secs(120))
+    );
+    assert_eq!(policy::freshness(StatusCode::OK, &HeaderMap::new(), ttl), Some(ttl));
+    assert_eq!(policy::freshness(StatusCode::OK, &HeaderMap::new(), Duration::ZERO), None);
+    assert_eq!(
+        policy::freshness(StatusCode::OK, &cache_control("private, max-age=60"), ttl),
+        None
+    );
+    assert_eq!(policy::freshness(StatusCode::OK, &cache_control("no-store"), ttl), None);
+    assert_eq!(
+        policy::freshness(StatusCode::INTERNAL_SERVER_ERROR, &cache_control("max-age=60"), ttl),
+        None
+    );
+
+    let mut expires = HeaderMap::new();
+    expires.insert(http::header::EXPIRES, HeaderValue::from_static("0"));
+    assert_eq!(policy::freshness(StatusCode::OK, &expires, ttl), None);
+
+    let mut aged = cache_control("max-age=60");
+    aged.insert(AGE, HeaderValue::from_static("50"));
+    assert_eq!(policy::freshness(StatusCode::OK, &aged, ttl), Some(Duration::from_secs(10)));
+    aged.insert(AGE, HeaderValue::from_static("60"));
+    assert_eq!(policy::freshness(StatusCode::OK, &aged, ttl), None);
+}
+
+#[test]
+fn test_vary() {
+    let mut headers = HeaderMap::new();
+    assert_eq!(policy::vary(&headers), Some(vec![]));
+
+    headers.insert(VARY, HeaderValue::from_static("Accept-Encoding, x-tls-ja4"));
+    assert_eq!(policy::vary(&headers), Some(vec![ACCEPT_ENCODING]));
+
+    headers.insert(VARY, HeaderValue::from_static("Accept-Encoding, *"));
+    assert_eq!(policy::vary(&headers), None);
+}
+
+#[tokio::test]
+async fn test_store_then_hit() -> R {
+    let cache = ResponseCache::new(&CacheConfig::default());
+    let get = request(Method::GET, &[]);
+    let metrics = Metrics::new_noop();
+    let route = RouteAttributes::new("/", "example.com");
+    let config = RouteCacheConfig::default();
+
+    let Lookup::Forward(Some(pending)) = cache.lookup(&get, &key("/a"), &config, &route, &metrics)
+    else {
+        return Err("first lookup should miss and store".into());
+    };
+    let forwarded = cache
+        .store(pending, response(&[("cache-control", "max-age=60")], "hello"), &metrics)
+        .await?;
+    assert_eq!(forwarded.headers().get(CONTENT_LENGTH), Some(&HeaderValue::from(5)));
+    assert_eq!(forwarded.into_body().collect().await?.to_bytes(), "hello");
+    assert_eq!(cache.len(), 1);
+    assert!(cache.size_bytes() > 5);
+
+    let Lookup::Hit(hit) = cache.lookup(&get, &key("/a"), &config, &route, &metrics) else {
+        return Err("second lookup should hit".into());
+    };
+    assert_eq!(hit.status(), StatusCode::OK);
+    assert_eq!(hit.headers().get(AGE), Some(&HeaderValue::from(0)));
+    assert_eq!(hit.into_body().collect().await?.to_bytes(), "hello");
+
+    let head = request(Method::HEAD, &[]);
+    let Lookup::Hit(hit) = cache.lookup(&head, &key("/a"), &config, &route, &metrics) else {
+        return Err("HEAD should be served from the GET entry".into());
+    };
+    assert_eq!(hit.headers().get(CONTENT_LENGTH), Some(&HeaderValue::from(5)));
+    assert!(hit.into_body().collect().await?.to_bytes().is_empty());
+
+    assert!(matches!(
+        cache.lookup(&get, &key("/a?b"), &config, &route, &metrics),
+        Lookup::Forward(Some(_))
+    ));
+    assert!(matches!(
+        cache.lookup(&request(Method::POST, &[]), &key("/a"), &config, &route, &metrics),
+        Lookup::Forward(None)
+    ));
+    Ok(())
+}
+
+#[tokio::test]
+async fn test_uncacheable_responses_are_not_stored() -> R {
+    let cache = ResponseCache::new(&CacheConfig::default());
+    let get = request(Method::GET, &[]);
+    let cases: [&[(&'static str, &'static str)]; 4] = [
+        &[],
+        &[("cache-control", "private, max-age=60")],
+        &[("cache-control", "max-age=60"), ("set-cookie", "a=b")],
+        &[("cache-control", "max-age=60"), ("vary", "*")],
+    ];
+    for headers in cases {
+        assert!(!fetch(&cache, &get, &key("/"), response(headers, "x")).await?);
+    }
+    assert!(cache.is_empty());
+
+    let small = ResponseCache::new(&CacheConfig { max_size_bytes: 1 << 20, max_object_bytes: 4 });
+    let resp = response(&[("cache-control", "max-age=60")], "too large");
+    assert!(!fetch(&small, &get, &key("/"), resp).await?);
+    assert!(small.is_empty());
+    Ok(())
+}
+
+#[tokio::test]
+async fn test_vary_mismatch_misses() -> R {
+    let cache = ResponseCache::new(&CacheConfig::default());
+    let gzip = request(Method::GET, &[("accept-encoding", "gzip")]);
+    let br = request(Method::GET, &[("accept-encoding", "br")]);
+    let resp = || response(&[("cache-control", "max-age=60"), ("vary", "accept-encoding")], "x");
+
+    assert!(!fetch(&cache, &gzip, &key("/"), resp()).await?);
+    assert!(fetch(&cache, &gzip, &key("/"), resp()).await?);
+    assert!(!fetch(&cache, &br, &key("/"), resp()).await?);
+    // The `br` response replaced the `gzip` one.
+    assert!(fetch(&cache, &br, &key("/"), resp()).await?);
+    assert!(!fetch(&cache, &gzip, &key("/"), resp()).await?);
+    Ok(())
+}
+
+#[tokio::test]
+async fn test_fingerprint_keys_are_separate() -> R {
+    let cache = ResponseCache::new(&CacheConfig::default());
+    let get = request(Method::GET, &[]);
+    let resp = || response(&[("cache-control", "max-age=60")], "x");
+    let a = CacheKey { fingerprint: Some(b"t13d1516h2_a"), ..key("/") };
+    let b = CacheKey { fingerprint: Some(b"t13d1516h2_b"), ..key("/") };
+
+    assert!(!fetch(&cache, &get, &a, resp()).await?);
+    assert!(!fetch(&cache, &get, &b, resp()).await?);
+    assert!(fetch(&cache, &get, &a, resp()).await?);
+    assert!(fetch(&cache, &get, &b, resp()).await?);
+    assert!(!fetch(&cache, &get, &key("/"), resp()).await?);
+    Ok(())
+}
+
+#[tokio::test]
+async fn test_eviction_bounds_size_and_keeps_hot_entries() -> R {
+    let config = CacheConfig { max_size_bytes: 16 * 64 * 1024, max_object_bytes: 8192 };
+    let cache = ResponseCache::new(&config);
+    let get = request(Method::GET, &[]);
+    let resp = || response(&[("cache-control", "max-age=60")], vec![b'x'; 4096]);
+
+    assert!(!fetch(&cache, &get, &key("/hot"), resp()).await?);
+    let paths: Vec<String> = (0..1000).map(|i| format!("/cold/{i}")).collect();
+    for path in &paths {
+        assert!(fetch(&cache, &get, &key("/hot"), resp()).await?);
+        assert!(!fetch(&cache, &get, &key(path), resp()).await?);
+        assert!(cache.size_bytes() <= config.max_size_bytes);
+    }
+    assert!(cache.len() < paths.len());
+    assert!(fetch(&cache, &get, &key("/hot"), resp()).await?);
+    Ok(())
+}
@@ -1,6 +1,23 @@
-use http::Version;
-use huginn_proxy_lib::config::{BackendPoolConfig, KeepAliveConfig, TimeoutConfig};
-use huginn_proxy_lib::proxy::ClientPool;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::Arc;
+use std::time::Duration;
+
+use bytes::Bytes;
+use http::{Request, StatusCode, Version};
+use http_body_util::Empty;
+use huginn_proxy_lib::config::{
+    Backend, BackendPoolConfig, KeepAliveConfig, PrewarmConfig, TimeoutConfig,
+};
+use huginn_proxy_lib::proxy::{BackendReuse, ClientPool};
+use huginn_proxy_lib::telemetry::Metrics;
+use tokio::io::{AsyncReadExt, AsyncWriteExt};
+use tokio::net::TcpListener;
+
+const BACKEND: &str = "127.0.0.1:9001";
+
+fn backend(address: &str) -> Backend {
+    Backend { address: address.to_string(), http_version: None, health_check: None }
+}
 
 fn default_keep_alive_config() -> KeepAliveConfig {
     KeepAliveConfig { enabled: true, upstream_idle_timeout: 90 }
@@ -23,7 +40,7 @@ fn test_get_client_http11_pooled() {
     let pool_config = BackendPoolConfig::default();
     let pool = ClientPool::new(&config, pool_config, default_upstream_connect_ms());
 
-    let client = pool.get_client(Version::HTTP_11, false);
+    let client = pool.get_client(BACKEND, Version::HTTP_11, false);
     assert!(client.is_some(), "HTTP/1.1 pooled client should be returned");
 }
 
@@ -33,7 +50,7 @@ fn test_get_client_http2_pooled() {
     let pool_config = BackendPoolConfig::default();
     let pool = ClientPool::new(&config, pool_config, default_upstream_connect_ms());
 
-    let client = pool.get_client(Version::HTTP_2, false);
+    let client = pool.get_client(BACKEND, Version::HTTP_2, false);
     assert!(client.is_some(), "HTTP/2 pooled client should be returned");
 }
 
@@ -43,7 +60,7 @@ fn test_get_client_http09_defaults_to_http11() {
     let pool_config = BackendPoolConfig::default();
     let pool = ClientPool::new(&config, pool_config, default_upstream_connect_ms());
 
-    let client = pool.get_client(Version::HTTP_09, false);
+    let client = pool.get_client(BACKEND, Version::HTTP_09, false);
     assert!(client.is_some(), "HTTP/0.9 should fallback to HTTP/1.1 client");
 }
 
@@ -53,23 +70,13 @@ fn test_get_client_force_new_returns_none() {
     let pool_config = BackendPoolConfig::default();
     let pool = ClientPool::new(&config, pool_config, default_upstream_connect_ms());
 
-    let client_http11 = pool.get_client(Version::HTTP_11, true);
-    let client_http2 = pool.get_client(Version::HTTP_2, true);
+    let client_http11 = pool.get_client(BACKEND, Version::HTTP_11, true);
+    let client_http2 = pool.get_client(BACKEND, Version::HTTP_2, true);
 
     assert!(client_http11.is_none(), "force_new should return None for HTTP/1.1");
     assert!(client_http2.is_none(), "force_new should return None for HTTP/2");
 }
 
-#[test]
-fn test_create_oneoff_client() {
-    let config = default_keep_alive_config();
-    let pool_config = BackendPoolConfig::default();
-    let pool = ClientPool::new(&config, pool_config, default_upstream_connect_ms());
-
-    let _oneoff_http11 = pool.create_oneoff_client(Version::HTTP_11);
-    let _oneoff_http2 = pool.create_oneoff_client(Version::HTTP_2);
-}
-
 #[test]
 fn test_pool_config_default() {
     let config = BackendPoolConfig::default();
@@ -90,8 +97,10 @@ fn test_client_pool_clone() {
     let pool_clone = pool.clone();
 
     // Verify both pools work correctly
-    assert!(pool.get_client(Version::HTTP_11, false).is_some());
-    assert!(pool_clone.get_client(Version::HTTP_11, false).is_some());
+    assert!(pool.get_client(BACKEND, Version::HTTP_11, false).is_some());
+    assert!(pool_clone
+        .get_client(BACKEND, Version::HTTP_11, false)
+        .is_some());
 }
 
 #[test]
@@ -101,5 +110,173 @@ fn test_keep_alive_disabled() {
     let pool = ClientPool::new(&config, pool_config, default_upstream_connect_ms());
 
     // Pool should still be created, but without keep-alive
-    assert!(pool.get_client(Version::HTTP_11, false).is_some());
+    assert!(pool.get_client(BACKEND, Version::HTTP_11, false).is_some());
+}
+
+#[test]
+fn test_with_backends_keeps_clients_of_remaining_backends(
+) -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let pool = ClientPool::new(
+        &default_keep_alive_config(),
+        BackendPoolConfig::default(),
+        default_upstream_connect_ms(),
+    );
+    let (pool, reuse) = pool.with_backends(&[backend(BACKEND), backend("127.0.0.1:9002")]);
+    assert_eq!(reuse, BackendReuse { reused: 0, added: 2, removed: 0 });
+
+    let client = |pool: &ClientPool, address: &str| {
+        pool.get_client(address, Version::HTTP_11, false)
+            .map(Arc::as_ptr)
+            .ok_or("pooled client expected")
+    };
+    let kept = client(&pool, BACKEND)?;
+    let removed = client(&pool, "127.0.0.1:9002")?;
+    let unknown = client(&pool, "127.0.0.1:9999")?;
+    assert_ne!(kept, removed, "every backend has its own client");
+    assert_ne!(kept, unknown, "unconfigured addresses use the shared client");
+
+    let (next, reuse) = pool.with_backends(&[backend(BACKEND), backend("127.0.0.1:9003")]);
+    assert_eq!(reuse, BackendReuse { reused: 1, added: 1, removed: 1 });
+    assert_eq!(client(&next, BACKEND)?, kept, "a remaining backend keeps its client");
+    assert_eq!(client(&next, "127.0.0.1:9002")?, unknown, "a removed backend loses its client");
+    assert_ne!(client(&next, "127.0.0.1:9003")?, unknown);
+    Ok(())
+}
+
+#[test]
+fn test_pool_config_prewarm_defaults() -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let config: BackendPoolConfig = toml::from_str("prewarm = {}")?;
+    assert_eq!(config.prewarm, Some(PrewarmConfig::default()));
+    let Some(prewarm) = config.prewarm else {
+        panic!("prewarm table should be present");
+    };
+    assert_eq!(prewarm.min_idle_per_backend, 2);
+    assert!(prewarm.http2);
+    assert!(BackendPoolConfig::default().prewarm.is_none(), "prewarming is opt-in");
+    Ok(())
+}
+
+/// Accepts connections and counts them without ever answering.
+async fn counting_listener() -> std::io::Result<(String, Arc<AtomicUsize>)> {
+    let listener = TcpListener::bind("127.0.0.1:0").await?;
+    let address = listener.local_addr()?.to_string();
+    let accepted = Arc::new(AtomicUsize::new(0));
+    let counter = Arc::clone(&accepted);
+    tokio::spawn(async move {
+        let mut open = Vec::new();
+        while let Ok((stream, _)) = listener.accept().await {
+            counter.fetch_add(1, Ordering::SeqCst);
+            open.push(stream);
+        }
+    });
+    Ok((address, accepted))
+}
+
+#[tokio::test]
+async fn test_prewarm_opens_spare_connections(
+) -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let (address, accepted) = counting_listener().await?;
+    let pool_config = BackendPoolConfig {
+        prewarm: Some(PrewarmConfig { min_idle_per_backend: 3, ..PrewarmConfig::default() }),
+        ..BackendPoolConfig::default()
+    };
+    let pool = ClientPool::new(&default_keep_alive_config(), pool_config, Some(1000));
+    let backends = [backend(&address)];
+
+    pool.prewarm(&backends, &Metrics::new_noop()).await;
+    // The client side is connected once `prewarm` returns; give the listener time to accept.
+    tokio::time::sleep(Duration::from_millis(100)).await;
+    assert_eq!(
+        accepted.load(Ordering::SeqCst),
+        3,
+        "HTTP/1.1 spares only for http_version unset"
+    );
+    Ok(())
+}
+
+#[tokio::test]
+async fn test_prewarm_is_noop_when_not_configured(
+) -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let (address, accepted) = counting_listener().await?;
+    let pool =
+        ClientPool::new(&default_keep_alive_config(), BackendPoolConfig::default(), Some(1000));
+    let backends = [backend(&address)];
+
+    pool.prewarm(&backends, &Metrics::new_noop()).await;
+    tokio::time::sleep(Duration::from_millis(50)).await;
+    assert_eq!(accepted.load(Ordering::SeqCst), 0);
+    Ok(())
+}
+
+/// Answers every request with an empty `200`, recording the request head of each connection.
+async fn recording_backend() -> std::io::Result<(String, Arc<std::sync::Mutex<Vec<String>>>)> {
+    let listener = TcpListener::bind("127.0.0.1:0").await?;
+    let address = listener.local_addr()?.to_string();
+    let heads = Arc::new(std::sync::Mutex::new(Vec::new()));
+    let recorded = Arc::clone(&heads);
+    tokio::spawn(async move {
+        while let Ok((mut stream, _)) = listener.accept().await {
+            let recorded = Arc::clone(&recorded);
+            tokio::spawn(async move {
+                let mut buf = [0u8; 4096];
+                while let Ok(n @ 1..) = stream.read(&mut buf).await {
+                    let head = String::from_utf8_lossy(buf.get(..n).unwrap_or_default());
+                    recorded
+                        .lock()
+                        .unwrap_or_else(|e| e.into_inner())
+                        .push(head.into_owned());
+                    let response = b"HTTP/1.1 200 OK\r\ncontent-length: 0\r\n\r\n";
+                    if stream.write_all(response).await.is_err() {
+                        break;
+                    }
+                }
+            });
+        }
+    });
+    Ok((address, heads))
+}
+
+#[tokio::test]
+async fn test_direct_client_opens_connection_per_request(
+) -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let (address, heads) = recording_backend().await?;
+    let pool =
+        ClientPool::new(&default_keep_alive_config(), BackendPoolConfig::default(), Some(1000));
+
+    for _ in 0..2 {
+        let request =
+            Request::get(format!("http://{address}/path?q=1")).body(Empty::<Bytes>::new())?;
+        let response = pool.direct_client().send(request, Version::HTTP_11).await?;
+        assert_eq!(response.status(), StatusCode::OK);
+    }
+
+    let heads = heads.lock().unwrap_or_else(|e| e.into_inner()).clone();
+    assert_eq!(heads.len(), 2, "one connection and request per send");
+    for head in &heads {
+        assert!(head.starts_with("GET /path?q=1 HTTP/1.1\r\n"), "origin-form request: {head}");
+        assert!(
+            head.to_ascii_lowercase()
+                .contains(&format!("host: {address}")),
+            "{head}"
+        );
+    }
+    Ok(())
+}
+
+#[tokio::test]
+async fn test_direct_client_connect_error() -> Result<(), Box<dyn std::error::Error + Send + Sync>>
+{
+    let listener = TcpListener::bind("127.0.0.1:0").await?;
+    let address = listener.local_addr()?;
+    drop(listener);
+    let pool =
+        ClientPool::new(&default_keep_alive_config(), BackendPoolConfig::default(), Some(1000));
+
+    let request = Request::get(format!("http://{address}/")).body(Empty::<Bytes>::new())?;
+    assert!(pool
+        .direct_client()
+        .send(request, Version::HTTP_11)
+        .await
+        .is_err());
+    Ok(())
 }
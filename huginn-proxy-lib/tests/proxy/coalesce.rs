@@ -0,0 +1,269 @@
+use bytes::Bytes;
+use http::header::{AUTHORIZATION, CONTENT_LENGTH};
+use http::{HeaderName, HeaderValue, Method, Request, Response, StatusCode};
+use http_body_util::channel::Channel;
+use http_body_util::{combinators::BoxBody, BodyExt, Full};
+use huginn_proxy_lib::config::RouteCoalesceConfig;
+use huginn_proxy_lib::proxy::coalesce::{CoalesceKey, Coalescer, Join};
+use huginn_proxy_lib::proxy::http_result::HttpError;
+use huginn_proxy_lib::telemetry::{Metrics, RouteAttributes};
+
+type R = Result<(), Box<dyn std::error::Error + Send + Sync>>;
+type Body = BoxBody<Bytes, hyper::Error>;
+
+const KEY: CoalesceKey<'static> = CoalesceKey {
+    https: true,
+    host: "example.com",
+    backend: "backend:80",
+    route: "/",
+    path_and_query: "/popular",
+};
+
+fn config(vary: &[&'static str], max_wait_ms: u64) -> RouteCoalesceConfig {
+    RouteCoalesceConfig {
+        vary: vary.iter().map(|v| HeaderName::from_static(v)).collect(),
+        max_wait_ms,
+        ..RouteCoalesceConfig::default()
+    }
+}
+
+fn request(method: Method, headers: &[(&'static str, &'static str)]) -> Request<()> {
+    let mut req = Request::new(());
+    *req.method_mut() = method;
+    for (name, value) in headers {
+        req.headers_mut()
+            .insert(*name, HeaderValue::from_static(value));
+    }
+    req
+}
+
+fn response(headers: &[(&'static str, &'static str)], body: &'static str) -> Response<Body> {
+    let mut resp = Response::new(
+        Full::new(Bytes::from_static(body.as_bytes()))
+            .map_err(|never| match never {})
+            .boxed(),
+    );
+    resp.headers_mut()
+        .insert(CONTENT_LENGTH, HeaderValue::from(body.len()));
+    for (name, value) in headers {
+        resp.headers_mut()
+            .insert(*name, HeaderValue::from_static(value));
+    }
+    resp
+}
+
+fn route() -> RouteAttributes {
+    RouteAttributes::new("/", "example.com")
+}
+
+#[tokio::test]
+async fn test_followers_share_the_leader_response() -> R {
+    let coalescer = Coalescer::new();
+    let config = config(&[], 5000);
+    let metrics = Metrics::new_noop();
+    let get = request(Method::GET, &[]);
+
+    let Join::Leader(leader) = coalescer.join(&get, &KEY, &config, &route(), &metrics) else {
+        return Err("first request should lead".into());
+    };
+    let Join::Follower(first) = coalescer.join(&get, &KEY, &config, &route(), &metrics) else {
+        return Err("second request should follow".into());
+    };
+    let Join::Follower(second) = coalescer.join(&get, &KEY, &config, &route(), &metrics) else {
+        return Err("third request should follow".into());
+    };
+    assert_eq!(coalescer.len(), 1);
+
+    let route = route();
+    let waiting = tokio::spawn(async move {
+        let route = RouteAttributes::new("/", "example.com");
+        let metrics = Metrics::new_noop();
+        first.wait(&route, &metrics).await
+    });
+    let own = leader.complete(Ok(response(&[("x-backend", "b1")], "shared body")))?;
+    assert!(coalescer.is_empty());
+
+    let followed = waiting.await?.ok_or("first follower should be served")??;
+    let followed_too = second
+        .wait(&route, &metrics)
+        .await
+        .ok_or("second follower should be served")??;
+    for resp in [own, followed, followed_too] {
+        assert_eq!(resp.status(), StatusCode::OK);
+        assert_eq!(resp.headers().get("x-backend"), Some(&HeaderValue::from_static("b1")));
+        assert_eq!(resp.into_body().collect().await?.to_bytes(), "shared body");
+    }
+
+    // The flight has landed: the next request leads a new one.
+    assert!(matches!(coalescer.join(&get, &KEY, &config, &route, &metrics), Join::Leader(_)));
+    Ok(())
+}
+
+#[tokio::test]
+async fn test_streamed_body_reaches_every_reader() -> R {
+    let coalescer = Coalescer::new();
+    let config = config(&[], 5000);
+    let metrics = Metrics::new_noop();
+    let get = request(Method::GET, &[]);
+
+    let Join::Leader(leader) = coalescer.join(&get, &KEY, &config, &route(), &metrics) else {
+        return Err("first request should lead".into());
+    };
+    let Join::Follower(follower) = coalescer.join(&get, &KEY, &config, &route(), &metrics) else {
+        return Err("second request should follow".into());
+    };
+
+    let (mut tx, body) = Channel::<Bytes, hyper::Error>::new(1);
+    let mut upstream = Response::new(body.boxed());
+    upstream
+        .headers_mut()
+        .insert(CONTENT_LENGTH, HeaderValue::from(10));
+    let own = leader.complete(Ok(upstream))?;
+    let followed = follower
+        .wait(&route(), &metrics)
+        .await
+        .ok_or("follower should be served")??;
+
+    let readers = tokio::spawn(async move {
+        let own = own.into_body().collect().await.map(|c| c.to_bytes());
+        let followed = followed.into_body().collect().await.map(|c| c.to_bytes());
+        (own, followed)
+    });
+    tx.send_data(Bytes::from_static(b"01234")).await?;
+    tx.send_data(Bytes::from_static(b"56789")).await?;
+    drop(tx);
+
+    let (own, followed) = readers.await?;
+    assert_eq!(own?, "0123456789");
+    assert_eq!(followed?, "0123456789");
+    Ok(())
+}
+
+#[tokio::test]
+async fn test_unshareable_response_sends_followers_upstream() -> R {
+    let coalescer = Coalescer::new();
+    let config = config(&[], 5000);
+    let metrics = Metrics::new_noop();
+    let get = request(Method::GET, &[]);
+
+    for headers in [
+        &[("set-cookie", "session=1")][..],
+        &[("cache-control", "private")],
+        &[("vary", "accept-language")],
+    ] {
+        let Join::Leader(leader) = coalescer.join(&get, &KEY, &config, &route(), &metrics) else {
+            return Err("first request should lead".into());
+        };
+        let Join::Follower(follower) = coalescer.join(&get, &KEY, &config, &route(), &metrics)
+        else {
+            return Err("second request should follow".into());
+        };
+        let own = leader.complete(Ok(response(headers, "private")))?;
+        assert_eq!(own.into_body().collect().await?.to_bytes(), "private");
+        assert!(follower.wait(&route(), &metrics).await.is_none());
+    }
+
+    // Without a known length the body is not buffered for followers either.
+    let Join::Leader(leader) = coalescer.join(&get, &KEY, &config, &route(), &metrics) else {
+        return Err("first request should lead".into());
+    };
+    let Join::Follower(follower) = coalescer.join(&get, &KEY, &config, &route(), &metrics) else {
+        return Err("second request should follow".into());
+    };
+    let (_tx, body) = Channel::<Bytes, hyper::Error>::new(1);
+    leader.complete(Ok(Response::new(body.boxed())))?;
+    assert!(follower.wait(&route(), &metrics).await.is_none());
+    Ok(())
+}
+
+#[tokio::test]
+async fn test_leader_error_is_shared() -> R {
+    let coalescer = Coalescer::new();
+    let config = config(&[], 5000);
+    let metrics = Metrics::new_noop();
+    let get = request(Method::GET, &[]);
+
+    let Join::Leader(leader) = coalescer.join(&get, &KEY, &config, &route(), &metrics) else {
+        return Err("first request should lead".into());
+    };
+    let Join::Follower(follower) = coalescer.join(&get, &KEY, &config, &route(), &metrics) else {
+        return Err("second request should follow".into());
+    };
+    let error = HttpError::FailedToGetResponseFromBackend("refused".to_string());
+    assert!(leader.complete(Err(error)).is_err());
+    assert!(matches!(
+        follower.wait(&route(), &metrics).await,
+        Some(Err(HttpError::FailedToGetResponseFromBackend(_)))
+    ));
+    Ok(())
+}
+
+#[tokio::test]
+async fn test_followers_fall_back_on_timeout_or_cancelled_leader() -> R {
+    let coalescer = Coalescer::new();
+    let metrics = Metrics::new_noop();
+    let get = request(Method::GET, &[]);
+
+    let short = config(&[], 10);
+    let Join::Leader(leader) = coalescer.join(&get, &KEY, &short, &route(), &metrics) else {
+        return Err("first request should lead".into());
+    };
+    let Join::Follower(follower) = coalescer.join(&get, &KEY, &short, &route(), &metrics) else {
+        return Err("second request should follow".into());
+    };
+    assert!(follower.wait(&route(), &metrics).await.is_none());
+
+    let long = config(&[], 5000);
+    let Join::Follower(follower) = coalescer.join(&get, &KEY, &long, &route(), &metrics) else {
+        return Err("request should follow the pending flight".into());
+    };
+    drop(leader);
+    assert!(coalescer.is_empty());
+    assert!(follower.wait(&route(), &metrics).await.is_none());
+    Ok(())
+}
+
+#[test]
+fn test_key_and_bypass() {
+    let coalescer = Coalescer::new();
+    let metrics = Metrics::new_noop();
+    let route = route();
+    let plain = config(&[], 5000);
+    let by_encoding = config(&["accept-encoding"], 5000);
+
+    let post = request(Method::POST, &[]);
+    assert!(matches!(coalescer.join(&post, &KEY, &plain, &route, &metrics), Join::Bypass));
+    let head = request(Method::HEAD, &[]);
+    assert!(matches!(coalescer.join(&head, &KEY, &plain, &route, &metrics), Join::Bypass));
+
+    let auth = request(Method::GET, &[("authorization", "Bearer a")]);
+    assert!(matches!(coalescer.join(&auth, &KEY, &plain, &route, &metrics), Join::Bypass));
+    let per_user = config(&[AUTHORIZATION.as_str()], 5000);
+    let _leader = coalescer.join(&auth, &KEY, &per_user, &route, &metrics);
+    let other_user = request(Method::GET, &[("authorization", "Bearer b")]);
+    assert!(matches!(
+        coalescer.join(&other_user, &KEY, &per_user, &route, &metrics),
+        Join::Leader(_)
+    ));
+
+    let gzip = request(Method::GET, &[("accept-encoding", "gzip")]);
+    let br = request(Method::GET, &[("accept-encoding", "br")]);
+    let _gzip_leader = coalescer.join(&gzip, &KEY, &by_encoding, &route, &metrics);
+    assert!(matches!(
+        coalescer.join(&br, &KEY, &by_encoding, &route, &metrics),
+        Join::Leader(_)
+    ));
+    assert!(matches!(
+        coalescer.join(&gzip, &KEY, &by_encoding, &route, &metrics),
+        Join::Follower(_)
+    ));
+    // Without `vary` the header does not split flights.
+    let _plain_leader = coalescer.join(&gzip, &KEY, &plain, &route, &metrics);
+    assert!(matches!(coalescer.join(&br, &KEY, &plain, &route, &metrics), Join::Follower(_)));
+
+    let other_path = CoalesceKey { path_and_query: "/other", ..KEY };
+    assert!(matches!(
+        coalescer.join(&gzip, &other_path, &plain, &route, &metrics),
+        Join::Leader(_)
+    ));
+}
@@ -0,0 +1,52 @@
+use huginn_proxy_lib::proxy::connection::{ConnectionMemo, HostDecision};
+use std::cell::Cell;
+
+fn decision(domain_index: usize) -> HostDecision {
+    HostDecision {
+        domain_index: Some(domain_index),
+        authoritative: true,
+        defer_ip_check: false,
+        ip_allowed: true,
+    }
+}
+
+#[test]
+fn host_decision_is_computed_once_per_host() {
+    let memo = ConnectionMemo::new();
+    let calls = Cell::new(0);
+    for _ in 0..3 {
+        let d = memo.host_decision("api.example.com", || {
+            calls.set(calls.get().saturating_add(1));
+            decision(0)
+        });
+        assert_eq!(d, decision(0));
+    }
+    assert_eq!(calls.get(), 1);
+
+    let other = memo.host_decision("docs.example.com", || decision(1));
+    assert_eq!(other.domain_index, Some(1));
+}
+
+#[test]
+fn route_ip_verdict_is_keyed_by_domain_and_prefix() {
+    let memo = ConnectionMemo::new();
+    assert!(!memo.route_ip_allowed(0, "/admin", || false));
+    assert!(!memo.route_ip_allowed(0, "/admin", || true));
+    assert!(memo.route_ip_allowed(1, "/admin", || true));
+    assert!(memo.route_ip_allowed(0, "/api", || true));
+}
+
+#[test]
+fn memo_is_bounded_but_still_answers() {
+    let memo = ConnectionMemo::new();
+    for i in 0..64 {
+        memo.host_decision(&format!("h{i}.example.com"), || decision(i));
+    }
+    let calls = Cell::new(0);
+    let late = memo.host_decision("h63.example.com", || {
+        calls.set(calls.get().saturating_add(1));
+        decision(63)
+    });
+    assert_eq!(late, decision(63));
+    assert_eq!(calls.get(), 1, "entries past the bound are recomputed, not stored");
+}
@@ -1 +1,2 @@
 mod connection_limit;
+mod memo;
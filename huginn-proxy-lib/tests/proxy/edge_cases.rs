@@ -14,6 +14,9 @@ fn test_pick_route_no_match() {
             security: None,
             headers: None,
             force_new_connection: false,
+            load_balance: Default::default(),
+            cache: None,
+            coalesce: None,
         },
         Route {
             prefix: "/static".to_string(),
@@ -23,6 +26,9 @@ fn test_pick_route_no_match() {
             security: None,
             headers: None,
             force_new_connection: false,
+            load_balance: Default::default(),
+            cache: None,
+            coalesce: None,
         },
     ];
 
@@ -40,6 +46,9 @@ fn test_pick_route_exact_match() {
             security: None,
             headers: None,
             force_new_connection: false,
+            load_balance: Default::default(),
+            cache: None,
+            coalesce: None,
         },
         Route {
             prefix: "/".to_string(),
@@ -49,6 +58,9 @@ fn test_pick_route_exact_match() {
             security: None,
             headers: None,
             force_new_connection: false,
+            load_balance: Default::default(),
+            cache: None,
+            coalesce: None,
         },
     ];
 
@@ -67,6 +79,9 @@ fn test_pick_route_longest_prefix() {
             security: None,
             headers: None,
             force_new_connection: false,
+            load_balance: Default::default(),
+            cache: None,
+            coalesce: None,
         },
         Route {
             prefix: "/api".to_string(),
@@ -76,6 +91,9 @@ fn test_pick_route_longest_prefix() {
             security: None,
             headers: None,
             force_new_connection: false,
+            load_balance: Default::default(),
+            cache: None,
+            coalesce: None,
         },
         Route {
             prefix: "/".to_string(),
@@ -85,6 +103,9 @@ fn test_pick_route_longest_prefix() {
             security: None,
             headers: None,
             force_new_connection: false,
+            load_balance: Default::default(),
+            cache: None,
+            coalesce: None,
         },
     ];
 
@@ -149,6 +170,9 @@ fn test_pick_route_with_empty_prefix() {
         security: None,
         headers: None,
         force_new_connection: false,
+        load_balance: Default::default(),
+        cache: None,
+        coalesce: None,
     }];
 
     assert_eq!(pick_route("/any/path", &routes), Some("backend-default:9000"));
@@ -1,6 +1,10 @@
-use http::Version;
+use http::uri::Authority;
+use http::{Uri, Version};
 use huginn_proxy_lib::config::{Backend, BackendHttpVersion};
-use huginn_proxy_lib::proxy::forwarding::{determine_http_version, find_backend_config};
+use huginn_proxy_lib::proxy::forwarding::{
+    determine_http_version, find_backend_config, upstream_uri,
+};
+use huginn_proxy_lib::proxy::HttpError;
 
 #[test]
 fn test_find_backend_config() {
@@ -108,3 +112,47 @@ fn test_determine_http_version_no_backend() {
     assert_eq!(determine_http_version(None, Version::HTTP_2, false), Version::HTTP_11);
     assert_eq!(determine_http_version(None, Version::HTTP_2, true), Version::HTTP_2);
 }
+
+fn rewrite(
+    original: &str,
+    matched_prefix: &str,
+    replace_path: Option<&str>,
+) -> Result<String, Box<dyn std::error::Error + Send + Sync>> {
+    let authority = Authority::from_static("backend:9000");
+    let original: Uri = original.parse()?;
+    Ok(upstream_uri(authority, &original, matched_prefix, replace_path)?.to_string())
+}
+
+#[test]
+fn test_upstream_uri_keeps_path_and_query() -> Result<(), Box<dyn std::error::Error + Send + Sync>>
+{
+    assert_eq!(rewrite("/api/users?id=1", "/api", None)?, "http://backend:9000/api/users?id=1");
+    assert_eq!(
+        rewrite("https://client.example/x?y", "/", None)?,
+        "http://backend:9000/x?y",
+        "absolute-form requests keep only their path and query"
+    );
+    Ok(())
+}
+
+#[test]
+fn test_upstream_uri_replaces_matched_prefix(
+) -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    assert_eq!(rewrite("/api/users?id=1", "/api", Some(""))?, "http://backend:9000/users?id=1");
+    assert_eq!(rewrite("/api/users", "/api", Some("/v2"))?, "http://backend:9000/v2/users");
+    assert_eq!(rewrite("/api", "/api", Some(""))?, "http://backend:9000/");
+    assert_eq!(rewrite("/api?id=1", "/api", Some(""))?, "http://backend:9000/?id=1");
+    Ok(())
+}
+
+#[test]
+fn test_upstream_uri_rejects_broken_prefix() -> Result<(), Box<dyn std::error::Error + Send + Sync>>
+{
+    let original: Uri = "/a".parse()?;
+    let authority = Authority::from_static("backend:9000");
+    let result = upstream_uri(authority.clone(), &original, "/api", Some("/"));
+    assert!(matches!(result, Err(HttpError::InvalidUri(_))));
+    let result = upstream_uri(authority, &original, "", Some("/"));
+    assert!(matches!(result, Err(HttpError::InvalidUri(_))));
+    Ok(())
+}
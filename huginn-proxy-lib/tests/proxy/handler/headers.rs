@@ -0,0 +1,49 @@
+use std::net::SocketAddr;
+
+use http::Request;
+use huginn_proxy_lib::proxy::handler::add_forwarded_headers;
+
+fn forwarded(
+    existing_for: Option<&str>,
+    peer: &str,
+) -> Result<Request<()>, Box<dyn std::error::Error + Send + Sync>> {
+    let mut builder = Request::get("/");
+    if let Some(value) = existing_for {
+        builder = builder.header("x-forwarded-for", value);
+    }
+    let mut req = builder.body(())?;
+    let peer: SocketAddr = peer.parse()?;
+    add_forwarded_headers(&mut req, peer, true, "example.com");
+    Ok(req)
+}
+
+fn header<'a>(req: &'a Request<()>, name: &str) -> Option<&'a str> {
+    req.headers().get(name).and_then(|v| v.to_str().ok())
+}
+
+#[test]
+fn sets_forwarded_headers() -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let req = forwarded(None, "203.0.113.7:51234")?;
+    assert_eq!(header(&req, "x-forwarded-for"), Some("203.0.113.7"));
+    assert_eq!(header(&req, "x-forwarded-host"), Some("example.com"));
+    assert_eq!(header(&req, "x-forwarded-port"), Some("51234"));
+    assert_eq!(header(&req, "x-forwarded-proto"), Some("https"));
+    Ok(())
+}
+
+#[test]
+fn appends_to_existing_forwarded_for() -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let req = forwarded(Some("198.51.100.1"), "[2001:db8::1]:443")?;
+    assert_eq!(header(&req, "x-forwarded-for"), Some("198.51.100.1, 2001:db8::1"));
+    Ok(())
+}
+
+#[test]
+fn formats_longest_ipv6_address() -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let ip = "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff";
+    let req = forwarded(None, &format!("[{ip}]:1"))?;
+    assert_eq!(header(&req, "x-forwarded-for"), Some(ip));
+    let req = forwarded(None, "[::ffff:255.255.255.255]:1")?;
+    assert_eq!(header(&req, "x-forwarded-for"), Some("::ffff:255.255.255.255"));
+    Ok(())
+}
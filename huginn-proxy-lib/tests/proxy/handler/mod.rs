@@ -1,3 +1,4 @@
 mod fingerprint_spoofing;
 mod header_manipulation;
+mod headers;
 mod host;
@@ -0,0 +1,59 @@
+use std::io::Write;
+use std::net::{SocketAddr, TcpStream};
+
+use huginn_proxy_lib::proxy::listener::{bind_listener, bind_reuseport_listeners};
+
+#[tokio::test]
+async fn test_bind_listener_accepts() -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let listener = bind_listener(SocketAddr::from(([127, 0, 0, 1], 0)), 16)?;
+    let addr = listener.local_addr()?;
+    let client = tokio::net::TcpStream::connect(addr).await?;
+    let (_, peer) = listener.accept().await?;
+    assert_eq!(peer, client.local_addr()?);
+    Ok(())
+}
+
+#[cfg(target_os = "linux")]
+#[test]
+fn test_reuseport_group_shares_port() -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let first = bind_reuseport_listeners(SocketAddr::from(([127, 0, 0, 1], 0)), 16, 1, false)?;
+    let addr = first.first().ok_or("no listener")?.local_addr()?;
+    drop(first);
+
+    let shards = bind_reuseport_listeners(addr, 16, 4, true)?;
+    assert_eq!(shards.len(), 4);
+    for shard in &shards {
+        assert_eq!(shard.local_addr()?, addr);
+    }
+
+    let connections = 8;
+    for _ in 0..connections {
+        TcpStream::connect(addr)?.write_all(b"x")?;
+    }
+    // Sockets are non-blocking: collect whatever each queue holds until all have arrived.
+    let mut accepted = 0usize;
+    for _ in 0..100 {
+        for shard in &shards {
+            while shard.accept().is_ok() {
+                accepted = accepted.saturating_add(1);
+            }
+        }
+        if accepted == connections {
+            break;
+        }
+        std::thread::sleep(std::time::Duration::from_millis(10));
+    }
+    assert_eq!(accepted, connections);
+    Ok(())
+}
+
+#[cfg(target_os = "linux")]
+#[test]
+fn test_plain_listener_rejects_reuseport_peer(
+) -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let group = bind_reuseport_listeners(SocketAddr::from(([127, 0, 0, 1], 0)), 16, 2, false)?;
+    let addr = group.first().ok_or("no listener")?.local_addr()?;
+    // Sockets without SO_REUSEPORT cannot join the group.
+    assert!(std::net::TcpListener::bind(addr).is_err());
+    Ok(())
+}
@@ -1,10 +1,14 @@
+mod admission;
+mod cache;
 mod client_pool;
+mod coalesce;
 mod connection;
 mod edge_cases;
 mod forwarding;
 mod h2c_forwarding;
 mod handler;
 mod http_result;
+mod listener;
 mod path_manipulation;
 mod peer_resolution;
 mod protocol;
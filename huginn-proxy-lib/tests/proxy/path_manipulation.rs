@@ -13,6 +13,9 @@ fn test_path_stripping_basic() {
         security: None,
         headers: None,
         force_new_connection: false,
+        load_balance: Default::default(),
+        cache: None,
+        coalesce: None,
     }];
 
     let result = pick_route_with_fingerprinting("/api/users", &routes);
@@ -36,6 +39,9 @@ fn test_path_stripping_with_query_params() {
         security: None,
         headers: None,
         force_new_connection: false,
+        load_balance: Default::default(),
+        cache: None,
+        coalesce: None,
     }];
 
     let result = pick_route_with_fingerprinting("/api/users?id=123&name=test", &routes);
@@ -60,6 +66,9 @@ fn test_path_rewriting_basic() {
         security: None,
         headers: None,
         force_new_connection: false,
+        load_balance: Default::default(),
+        cache: None,
+        coalesce: None,
     }];
 
     let result = pick_route_with_fingerprinting("/maps/org/any.ext", &routes);
@@ -83,6 +92,9 @@ fn test_path_rewriting_with_versioned_api() {
         security: None,
         headers: None,
         force_new_connection: false,
+        load_balance: Default::default(),
+        cache: None,
+        coalesce: None,
     }];
 
     let result = pick_route_with_fingerprinting("/api/users", &routes);
@@ -106,6 +118,9 @@ fn test_no_path_manipulation() {
         security: None,
         headers: None,
         force_new_connection: false,
+        load_balance: Default::default(),
+        cache: None,
+        coalesce: None,
     }];
 
     let result = pick_route_with_fingerprinting("/api/users", &routes);
@@ -128,6 +143,9 @@ fn test_path_manipulation_with_nested_paths() {
         security: None,
         headers: None,
         force_new_connection: false,
+        load_balance: Default::default(),
+        cache: None,
+        coalesce: None,
     }];
 
     let result = pick_route_with_fingerprinting("/api/v1/users/123", &routes);
@@ -150,6 +168,9 @@ fn test_path_manipulation_root_path() {
         security: None,
         headers: None,
         force_new_connection: false,
+        load_balance: Default::default(),
+        cache: None,
+        coalesce: None,
     }];
 
     let result = pick_route_with_fingerprinting("/users", &routes);
@@ -173,6 +194,9 @@ fn test_multiple_routes_matching_priority() {
             security: None,
             headers: None,
             force_new_connection: false,
+            load_balance: Default::default(),
+            cache: None,
+            coalesce: None,
         },
         Route {
             prefix: "/api".to_string(),
@@ -182,6 +206,9 @@ fn test_multiple_routes_matching_priority() {
             security: None,
             headers: None,
             force_new_connection: false,
+            load_balance: Default::default(),
+            cache: None,
+            coalesce: None,
         },
     ];
 
@@ -208,6 +235,9 @@ fn test_path_manipulation_exact_prefix_match() {
         security: None,
         headers: None,
         force_new_connection: false,
+        load_balance: Default::default(),
+        cache: None,
+        coalesce: None,
     }];
 
     let result = pick_route_with_fingerprinting("/api", &routes);
@@ -231,6 +261,9 @@ fn test_path_stripping_to_root() {
         security: None,
         headers: None,
         force_new_connection: false,
+        load_balance: Default::default(),
+        cache: None,
+        coalesce: None,
     }];
 
     let result = pick_route_with_fingerprinting("/api/health", &routes);
@@ -254,6 +287,9 @@ fn test_path_manipulation_with_special_characters() {
         security: None,
         headers: None,
         force_new_connection: false,
+        load_balance: Default::default(),
+        cache: None,
+        coalesce: None,
     }];
 
     let result = pick_route_with_fingerprinting("/api/users%20info", &routes);
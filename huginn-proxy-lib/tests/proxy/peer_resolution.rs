@@ -3,8 +3,9 @@ use std::str::FromStr;
 use std::time::{Duration, Instant};
 
 use huginn_proxy_lib::config::{ProxyProtocolMode, TrustedProxiesConfig};
-use huginn_proxy_lib::proxy::peer_resolution::resolve_peer;
+use huginn_proxy_lib::proxy::peer_resolution::{resolve_peer, resolve_peer_buffered};
 use huginn_proxy_lib::telemetry::Metrics;
+use huginn_proxy_lib::{read_client_hello_buffered, ClientHello};
 use ipnet::IpNet;
 use tokio::io::AsyncWriteExt;
 use tokio::net::{TcpListener, TcpStream};
@@ -167,3 +168,55 @@ async fn resolve_peer_require_trusted_no_header_short_timeout_drops() -> TestRes
     );
     Ok(())
 }
+
+#[tokio::test]
+async fn resolve_peer_buffered_keeps_the_bytes_after_the_header() -> TestResult {
+    // Header and TLS record in one write, as a load balancer forwards them.
+    let input = b"PROXY TCP4 192.168.1.1 10.0.0.2 12345 443\r\n\x16\x03\x01\x00\x02hi";
+    let (mut stream, socket_peer) = accept_one(input).await?;
+    let metrics = Metrics::new_noop();
+    let trusted = localhost_trusted()?;
+    let mut hello = ClientHello::new();
+
+    let result = resolve_peer_buffered(
+        ProxyProtocolMode::Require,
+        Duration::from_secs(5),
+        &metrics,
+        &trusted,
+        &mut stream,
+        socket_peer,
+        &mut hello,
+    )
+    .await;
+
+    let expected: SocketAddr = SocketAddr::new(IpAddr::from_str("192.168.1.1")?, 12345);
+    assert_eq!(result, Some(expected));
+    // The ClientHello read picks up where the header stage stopped.
+    let (hello, _) = read_client_hello_buffered(&mut stream, hello, Metrics::new_noop()).await?;
+    assert_eq!(hello.bytes(), b"\x16\x03\x01\x00\x02hi".as_slice());
+    Ok(())
+}
+
+#[tokio::test]
+async fn resolve_peer_buffered_untrusted_reads_nothing() -> TestResult {
+    let (mut stream, socket_peer) =
+        accept_one(b"PROXY TCP4 192.168.1.1 10.0.0.2 12345 443\r\n").await?;
+    let metrics = Metrics::new_noop();
+    let mut hello = ClientHello::new();
+
+    let result = resolve_peer_buffered(
+        ProxyProtocolMode::Optional,
+        Duration::from_secs(5),
+        &metrics,
+        &no_trust(),
+        &mut stream,
+        socket_peer,
+        &mut hello,
+    )
+    .await;
+
+    // Never parsed: the header is left for the handshake, which rejects it.
+    assert_eq!(result, Some(socket_peer));
+    assert!(hello.bytes().is_empty());
+    Ok(())
+}
@@ -1,3 +1,4 @@
+mod preamble;
 mod v1;
 mod v2;
 
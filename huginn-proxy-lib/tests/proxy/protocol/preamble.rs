@@ -0,0 +1,109 @@
+use huginn_proxy_lib::proxy::protocol::{
+    read_proxy_preamble, ProxyHeader, ProxyProtocolError, ProxySource, V2_SIGNATURE,
+};
+use std::io::Cursor;
+use tokio::io::AsyncReadExt;
+
+type TestResult = Result<(), Box<dyn std::error::Error>>;
+
+/// Start of a TLS ClientHello record, standing in for the handshake behind the header.
+const CLIENT_HELLO: &[u8] = b"\x16\x03\x01\x00\x05hello";
+
+/// v2 PROXY/TCP4 header declaring `192.168.1.100:51234`, with a 12-byte address block.
+fn v2_header() -> Vec<u8> {
+    let mut header = V2_SIGNATURE.to_vec();
+    header.extend_from_slice(&[0x21, 0x11, 0x00, 0x0C]);
+    header.extend_from_slice(&[192, 168, 1, 100, 10, 0, 0, 1]);
+    header.extend_from_slice(&51234u16.to_be_bytes());
+    header.extend_from_slice(&443u16.to_be_bytes());
+    header
+}
+
+#[tokio::test]
+async fn v2_header_is_parsed_in_place_keeping_the_client_hello() -> TestResult {
+    let header = v2_header();
+    let mut input = header.clone();
+    input.extend_from_slice(CLIENT_HELLO);
+    let mut buf = Vec::new();
+
+    let parsed = read_proxy_preamble(&mut Cursor::new(input.clone()), &mut buf).await?;
+
+    let expected = ProxySource::Client("192.168.1.100:51234".parse()?);
+    assert_eq!(parsed, Some(ProxyHeader { source: expected, len: header.len() }));
+    assert_eq!(buf, input);
+    assert_eq!(&buf[header.len()..], CLIENT_HELLO);
+    Ok(())
+}
+
+#[tokio::test]
+async fn v1_header_is_parsed_in_place_keeping_the_client_hello() -> TestResult {
+    let header = b"PROXY TCP4 192.168.1.100 10.0.0.1 45000 443\r\n";
+    let mut input = header.to_vec();
+    input.extend_from_slice(CLIENT_HELLO);
+    let mut buf = Vec::new();
+
+    let parsed = read_proxy_preamble(&mut Cursor::new(input), &mut buf).await?;
+
+    let expected = ProxySource::Client("192.168.1.100:45000".parse()?);
+    assert_eq!(parsed, Some(ProxyHeader { source: expected, len: header.len() }));
+    assert_eq!(&buf[header.len()..], CLIENT_HELLO);
+    Ok(())
+}
+
+#[tokio::test]
+async fn header_split_across_reads_is_completed() -> TestResult {
+    let header = v2_header();
+    // Each part of the chain is returned by its own read: signature first, then the rest.
+    let (first, rest) = header.split_at(10);
+    let mut stream = first.chain(rest);
+    let mut buf = Vec::new();
+
+    let parsed = read_proxy_preamble(&mut stream, &mut buf).await?;
+
+    assert_eq!(parsed.map(|h| h.len), Some(header.len()));
+    Ok(())
+}
+
+#[tokio::test]
+async fn no_header_leaves_the_bytes_buffered() -> TestResult {
+    let mut buf = Vec::new();
+
+    let parsed = read_proxy_preamble(&mut Cursor::new(CLIENT_HELLO.to_vec()), &mut buf).await?;
+
+    assert_eq!(parsed, None);
+    assert_eq!(buf, CLIENT_HELLO);
+    Ok(())
+}
+
+#[tokio::test]
+async fn eof_before_a_signature_is_not_a_header() -> TestResult {
+    let mut buf = Vec::new();
+    assert_eq!(read_proxy_preamble(&mut Cursor::new(b"PRO".to_vec()), &mut buf).await?, None);
+    Ok(())
+}
+
+#[tokio::test]
+async fn truncated_header_errors() {
+    let header = v2_header();
+    let mut buf = Vec::new();
+    let result = read_proxy_preamble(&mut Cursor::new(header[..20].to_vec()), &mut buf).await;
+    assert!(matches!(result, Err(ProxyProtocolError::Io(_))));
+}
+
+#[tokio::test]
+async fn oversized_addr_len_is_rejected_before_buffering_it() {
+    let mut header = V2_SIGNATURE.to_vec();
+    header.extend_from_slice(&[0x21, 0x11, 0xFF, 0xFF]);
+    let mut buf = Vec::new();
+    let result = read_proxy_preamble(&mut Cursor::new(header), &mut buf).await;
+    assert!(matches!(result, Err(ProxyProtocolError::AddrLenTooLarge(0xFFFF))));
+}
+
+#[tokio::test]
+async fn unterminated_v1_header_is_rejected() {
+    let mut line = b"PROXY TCP4 ".to_vec();
+    line.resize(200, b'1');
+    let mut buf = Vec::new();
+    let result = read_proxy_preamble(&mut Cursor::new(line), &mut buf).await;
+    assert!(matches!(result, Err(ProxyProtocolError::V1HeaderTooLong)));
+}
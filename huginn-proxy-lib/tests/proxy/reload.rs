@@ -1,7 +1,10 @@
 use std::sync::Arc;
 
 use arc_swap::ArcSwap;
+use http::Version;
 use huginn_proxy_lib::config::{load_from_path, ConfigParts, DynamicConfig};
+use huginn_proxy_lib::proxy::ClientPool;
+use huginn_proxy_lib::security::RateLimitResult;
 use huginn_proxy_lib::{
     initial_client_pool, initial_rate_limiter, try_reload, HealthCheckSupervisor, HealthRegistry,
     Metrics, SharedClientPool, SharedRateLimiter, StaticConfig,
@@ -135,8 +138,8 @@ impl Harness {
         let ConfigParts { static_cfg, dynamic_cfg } = config.into_parts();
         let static_cfg = Arc::new(static_cfg);
         let dynamic = Arc::new(ArcSwap::from_pointee(dynamic_cfg));
-        let rate_limiter = initial_rate_limiter(&dynamic.load());
-        let client_pool = initial_client_pool(&static_cfg, &dynamic.load().backend_pool);
+        let rate_limiter = initial_rate_limiter(&dynamic.load(), false);
+        let client_pool = initial_client_pool(&static_cfg, &dynamic.load());
         Ok(Self { tmp, static_cfg, dynamic, rate_limiter, client_pool })
     }
 
@@ -155,6 +158,7 @@ impl Harness {
             &metrics,
             &health,
             None,
+            None,
         )
         .await;
         Ok(())
@@ -204,6 +208,37 @@ async fn assert_client_pool_preserved(before: &Spec, after: &Spec) -> TestResult
     Ok(())
 }
 
+async fn assert_backend_clients_preserved(
+    before: &Spec,
+    after: &Spec,
+    backend: &str,
+) -> TestResult {
+    let h = Harness::start(before)?;
+    let client = |pool: &ClientPool| {
+        pool.get_client(backend, Version::HTTP_11, false)
+            .map(Arc::as_ptr)
+            .ok_or("pooled client expected")
+    };
+    let client_before = client(&h.client_pool.load_full())?;
+    h.reload_spec(after).await?;
+    assert_eq!(client_before, client(&h.client_pool.load_full())?);
+    Ok(())
+}
+
+/// Whether a request from `ip` to `host` (default route) is admitted right now.
+fn admits(
+    h: &Harness,
+    ip: &str,
+    host: &str,
+) -> Result<bool, Box<dyn std::error::Error + Send + Sync>> {
+    let manager = h.rate_limiter.load_full();
+    let manager = manager
+        .as_ref()
+        .as_ref()
+        .ok_or("rate limiting should be enabled")?;
+    Ok(matches!(manager.check(ip, host, Some("/")), RateLimitResult::Allowed { .. }))
+}
+
 #[tokio::test]
 async fn reload_rebuilds_rate_limiter_when_global_rate_limit_value_changes() -> TestResult {
     let before = rate_limited();
@@ -328,7 +363,7 @@ async fn reload_rebuilds_client_pool_when_backend_pool_config_changes() -> TestR
 }
 
 #[tokio::test]
-async fn reload_preserves_client_pool_when_backend_added() -> TestResult {
+async fn reload_preserves_backend_clients_when_backend_added() -> TestResult {
     let before = base();
     let mut after = before.clone();
     after.backends = vec!["127.0.0.1:9001", "127.0.0.1:9002"];
@@ -337,7 +372,20 @@ async fn reload_preserves_client_pool_when_backend_added() -> TestResult {
         backend: "127.0.0.1:9002",
         rate_limit_rps: None,
     });
-    assert_client_pool_preserved(&before, &after).await
+    assert_backend_clients_preserved(&before, &after, "127.0.0.1:9001").await
+}
+
+#[tokio::test]
+async fn reload_preserves_remaining_backend_clients_when_backend_removed() -> TestResult {
+    let mut before = base();
+    before.backends = vec!["127.0.0.1:9001", "127.0.0.1:9002"];
+    before.domains[0].routes.push(RouteSpec {
+        prefix: "/b",
+        backend: "127.0.0.1:9002",
+        rate_limit_rps: None,
+    });
+    let after = base();
+    assert_backend_clients_preserved(&before, &after, "127.0.0.1:9001").await
 }
 
 #[tokio::test]
@@ -439,3 +487,24 @@ async fn reload_preserves_rate_limiter_when_domain_ip_filter_changes() -> TestRe
     after.domains[0].ip_deny = Some("10.0.0.0/8");
     assert_rate_limiter_preserved(&before, &after).await
 }
+
+#[tokio::test]
+async fn reload_keeps_counters_of_unchanged_rate_limit_scopes() -> TestResult {
+    let mut before = rate_limited();
+    before
+        .domains
+        .push(domain("example.com", Some(1), "127.0.0.1:9001"));
+    let h = Harness::start(&before)?;
+    for host in ["127.0.0.1", "example.com"] {
+        assert!(admits(&h, "10.0.0.1", host)?);
+        assert!(!admits(&h, "10.0.0.1", host)?, "burst = 1");
+    }
+
+    // Only the example.com policy changes: its bucket starts over, the global one does not.
+    let mut after = before.clone();
+    after.domains[1].rate_limit_rps = Some(2);
+    h.reload_spec(&after).await?;
+    assert!(!admits(&h, "10.0.0.1", "127.0.0.1")?, "global counter survives the reload");
+    assert!(admits(&h, "10.0.0.1", "example.com")?, "changed domain policy starts fresh");
+    Ok(())
+}
@@ -39,9 +39,12 @@ fn route(security: Option<RouteSecurityConfig>, fingerprinting: Option<bool>) ->
         backend: "backend:80".to_string(),
         fingerprinting,
         force_new_connection: false,
+        load_balance: Default::default(),
         replace_path: None,
         security,
         headers: None,
+        cache: None,
+        coalesce: None,
     }
 }
 
@@ -1,7 +1,12 @@
-use huginn_proxy_lib::config::{sort_domain_routes, sort_routes, Domain, Route};
+use huginn_proxy_lib::config::{
+    sort_domain_routes, sort_routes, Backend, Domain, Route, DEFAULT_DOMAIN_LABEL,
+};
 use huginn_proxy_lib::proxy::router::{
     authority_matches_sni, pick_domain, pick_route, pick_route_with_fingerprinting, prefix_matches,
+    RoutingTable,
 };
+use huginn_proxy_lib::telemetry::RouteAttributes;
+use std::sync::Arc;
 
 fn route(prefix: &str, backend: &str) -> Route {
     Route {
@@ -9,9 +14,12 @@ fn route(prefix: &str, backend: &str) -> Route {
         backend: backend.to_string(),
         fingerprinting: Some(true),
         force_new_connection: false,
+        load_balance: Default::default(),
         replace_path: None,
         security: None,
         headers: None,
+        cache: None,
+        coalesce: None,
     }
 }
 
@@ -108,6 +116,9 @@ fn test_pick_route_with_fingerprinting_with_replace_path() {
         security: None,
         headers: None,
         force_new_connection: false,
+        load_balance: Default::default(),
+        cache: None,
+        coalesce: None,
     }];
 
     let result = pick_route_with_fingerprinting("/api/users", &routes);
@@ -129,6 +140,9 @@ fn test_pick_route_with_fingerprinting_path_stripping() {
         security: None,
         headers: None,
         force_new_connection: false,
+        load_balance: Default::default(),
+        cache: None,
+        coalesce: None,
     }];
 
     let result = pick_route_with_fingerprinting("/api/users", &routes);
@@ -532,3 +546,163 @@ fn authority_matches_sni_certless_host_uses_default_cert() {
     // SNI=api.example.com -> certless -> default cert; authority=other -> catch-all -> default cert.
     assert!(authority_matches_sni(&domains, "api.example.com", "other.com"));
 }
+
+fn table(domains: Vec<Domain>) -> RoutingTable {
+    RoutingTable::new(Arc::new(sorted_domains(domains)))
+}
+
+#[test]
+fn sort_routes_groups_equal_prefixes_in_declaration_order() {
+    let routes = sorted_routes(vec![
+        route("/api", "api-a:9000"),
+        route("/web", "web:9000"),
+        route("/api", "api-b:9000"),
+    ]);
+    let order: Vec<&str> = routes.iter().map(|r| r.backend.as_str()).collect();
+    assert_eq!(order, vec!["api-a:9000", "api-b:9000", "web:9000"]);
+}
+
+#[test]
+fn routing_table_domain_precedence_matches_pick_domain() {
+    let t = table(vec![
+        domain("*.example.com", vec![]),
+        domain("api.example.com", vec![]),
+        catch_all(vec![]),
+    ]);
+    let host_of = |h: &str| t.pick_domain(h).and_then(|(_, d)| d.host.as_deref());
+    assert_eq!(host_of("api.example.com"), Some("api.example.com"));
+    assert_eq!(host_of("sub.example.com"), Some("*.example.com"));
+    assert_eq!(host_of("a.b.example.com"), None);
+    assert_eq!(host_of("localhost"), None);
+    assert!(t
+        .pick_domain("localhost")
+        .is_some_and(|(_, d)| d.host.is_none()));
+}
+
+#[test]
+fn routing_table_without_catch_all_returns_none() {
+    let t = table(vec![domain("api.example.com", vec![])]);
+    assert!(t.pick_domain("example.com").is_none());
+    assert!(t.pick_domain("127.0.0.1").is_none());
+}
+
+#[test]
+fn routing_table_first_duplicate_host_wins() {
+    let t = table(vec![
+        domain("api.example.com", vec![route("/", "first:9000")]),
+        domain("api.example.com", vec![route("/", "second:9000")]),
+    ]);
+    let Some((index, _)) = t.pick_domain("api.example.com") else {
+        panic!("expected exact match for api.example.com");
+    };
+    assert_eq!(index, 0);
+}
+
+#[test]
+fn routing_table_longest_prefix_and_boundaries() {
+    let t = table(vec![domain(
+        "api.example.com",
+        vec![
+            route("/", "root:9000"),
+            route("/api", "api:9000"),
+            route("/api/v1", "apiv1:9000"),
+            route("/api2", "api2:9000"),
+        ],
+    )]);
+    let backend = |path: &str| t.pick_route(0, path).map(|r| r.backend);
+    assert_eq!(backend("/api/v1/users"), Some("apiv1:9000"));
+    assert_eq!(backend("/api/v2/users"), Some("api:9000"));
+    assert_eq!(backend("/api"), Some("api:9000"));
+    assert_eq!(backend("/api2/x"), Some("api2:9000"));
+    assert_eq!(backend("/apiv2"), Some("root:9000"));
+    assert_eq!(backend("/other"), Some("root:9000"));
+    assert_eq!(backend(""), None);
+}
+
+#[test]
+fn routing_table_no_root_returns_none() {
+    let t = table(vec![domain("api.example.com", vec![route("/api", "api:9000")])]);
+    assert!(t.pick_route(0, "/static/file.js").is_none());
+    assert!(t.pick_route(1, "/api").is_none());
+}
+
+#[test]
+fn routing_table_candidates_match_linear_scan() {
+    let domains = sorted_domains(vec![domain(
+        "api.example.com",
+        vec![
+            route("/api", "api-a:9000"),
+            route("/web", "web:9000"),
+            route("/api", "api-b:9000"),
+            route("/", "root:9000"),
+        ],
+    )]);
+    let t = RoutingTable::new(Arc::new(domains.clone()));
+    for path in ["/api/users", "/web", "/", "/unknown"] {
+        let linear = pick_route_with_fingerprinting(path, &domains[0].routes);
+        let indexed = t.pick_route(0, path);
+        assert_eq!(format!("{linear:?}"), format!("{indexed:?}"), "path {path}");
+    }
+    let Some(r) = t.pick_route(0, "/api/users") else {
+        panic!("Expected a route match for /api/users");
+    };
+    assert_eq!(r.backend_candidates, vec!["api-a:9000", "api-b:9000"]);
+    assert_eq!(r.route_index, 0);
+    assert_eq!(t.pick_route(0, "/web").map(|r| r.route_index), Some(2));
+}
+
+#[test]
+fn routing_table_resolves_route_upstreams() {
+    let domains = sorted_domains(vec![domain(
+        "api.example.com",
+        vec![
+            route("/api", "api-a:9000"),
+            route("/api", "api-b:9000"),
+            route("/", "api-a:9000"),
+        ],
+    )]);
+    let backends =
+        vec![Backend { address: "api-b:9000".to_string(), http_version: None, health_check: None }];
+    let t = RoutingTable::with_backends(Arc::new(domains), &backends);
+
+    let Some(api_a) = t.upstream(0, 0) else {
+        panic!("Expected an upstream for route 0");
+    };
+    assert_eq!(api_a.authority.as_ref().map(|a| a.as_str()), Some("api-a:9000"));
+    assert_eq!(api_a.backend_index, None, "address not declared in backends");
+    assert_eq!(t.upstream(0, 1).and_then(|u| u.backend_index), Some(0));
+    let shared = t
+        .upstream(0, 2)
+        .is_some_and(|root| Arc::ptr_eq(root, api_a));
+    assert!(shared, "routes of one address share its target");
+    assert!(t.upstream(0, 3).is_none());
+    assert!(t.upstream(1, 0).is_none());
+}
+
+#[test]
+fn routing_table_interns_route_attributes() {
+    let t = table(vec![
+        domain("api.example.com", vec![route("/api", "a:9000"), route("/", "b:9000")]),
+        catch_all(vec![route("/", "c:9000")]),
+    ]);
+    assert_eq!(t.route_attributes(0, 0), Some(&RouteAttributes::new("/api", "api.example.com")));
+    assert_eq!(t.route_attributes(0, 1), Some(&RouteAttributes::new("/", "api.example.com")));
+    assert_eq!(t.route_attributes(1, 0), Some(&RouteAttributes::new("/", DEFAULT_DOMAIN_LABEL)));
+    assert!(t.route_attributes(0, 2).is_none());
+    assert!(t.route_attributes(2, 0).is_none());
+}
+
+#[test]
+fn routing_table_authority_matches_sni() {
+    let t = table(vec![
+        domain_with_cert("api.example.com", "/certs/san.pem"),
+        domain_with_cert("docs.example.com", "/certs/san.pem"),
+        domain_with_cert("other.com", "/certs/other.pem"),
+        domain("*.example.com", vec![]),
+    ]);
+    assert!(t.authority_matches_sni("api.example.com", "api.example.com"));
+    assert!(t.authority_matches_sni("api.example.com", "docs.example.com"));
+    assert!(!t.authority_matches_sni("api.example.com", "other.com"));
+    assert!(!t.authority_matches_sni("api.example.com", "evil.com"));
+    assert!(t.authority_matches_sni("a.example.com", "b.example.com"));
+}
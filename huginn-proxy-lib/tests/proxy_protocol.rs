@@ -362,9 +362,12 @@ async fn spawn_proxy_tls(
                 backend: backend.to_string(),
                 fingerprinting: None,
                 force_new_connection: false,
+                load_balance: Default::default(),
                 replace_path: None,
                 security: None,
                 headers: None,
+                cache: None,
+                coalesce: None,
             }],
         }],
         tls: Some(TlsConfig {
@@ -389,7 +392,13 @@ async fn spawn_proxy_tls(
             keep_alive: KeepAliveConfig::default(),
         },
         security: SecurityConfig { trusted_proxies, ..Default::default() },
-        telemetry: TelemetryConfig { metrics_port: None, otel_log_level: "error".to_string() },
+        telemetry: TelemetryConfig {
+            metrics_port: None,
+            otel_log_level: "error".to_string(),
+            timing: Default::default(),
+            debug: Default::default(),
+            fingerprint_export: Default::default(),
+        },
         reload: huginn_proxy_lib::config::ReloadConfig::default(),
         headers: None,
         preserve_host: false,
@@ -1,5 +1,7 @@
-use huginn_proxy_lib::config::{IpFilterConfig, IpFilterMode};
-use huginn_proxy_lib::security::is_ip_allowed;
+use huginn_proxy_lib::config::{
+    Domain, DomainSecurityConfig, IpFilterConfig, IpFilterMode, Route, RouteSecurityConfig,
+};
+use huginn_proxy_lib::security::{is_ip_allowed, CompiledIpFilter, IpFilterEntries, IpFilterIndex};
 use ipnet::IpNet;
 use std::net::IpAddr;
 use std::str::FromStr;
@@ -144,3 +146,161 @@ fn test_empty_denylist_allows_all() {
     let ip = IpAddr::from_str("192.168.1.1").unwrap_or(IpAddr::from([0, 0, 0, 0]));
     assert!(is_ip_allowed(ip, &config));
 }
+
+type R = Result<(), Box<dyn std::error::Error + Send + Sync>>;
+
+fn denylist(addrs: &[&str]) -> IpFilterConfig {
+    IpFilterConfig {
+        mode: IpFilterMode::Denylist,
+        allowlist: vec![],
+        denylist: parse_networks(addrs),
+    }
+}
+
+fn allowlist(addrs: &[&str]) -> IpFilterConfig {
+    IpFilterConfig {
+        mode: IpFilterMode::Allowlist,
+        allowlist: parse_networks(addrs),
+        denylist: vec![],
+    }
+}
+
+#[test]
+fn test_compiled_matches_reference() -> R {
+    // Overlapping, nested, adjacent and family-edge prefixes, in no particular order.
+    let nets = [
+        "10.0.0.0/8",
+        "10.1.0.0/16",
+        "192.168.1.0/25",
+        "192.168.1.128/25",
+        "0.0.0.0/32",
+        "255.255.255.255/32",
+        "172.16.0.5/32",
+        "2001:db8::/32",
+        "2001:db8:1::/48",
+        "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ff00/120",
+    ];
+    let probes = [
+        "10.0.0.0",
+        "10.255.255.255",
+        "11.0.0.0",
+        "9.255.255.255",
+        "192.168.1.0",
+        "192.168.1.127",
+        "192.168.1.128",
+        "192.168.1.255",
+        "192.168.2.0",
+        "0.0.0.0",
+        "0.0.0.1",
+        "255.255.255.255",
+        "255.255.255.254",
+        "172.16.0.4",
+        "172.16.0.5",
+        "172.16.0.6",
+        "2001:db8::1",
+        "2001:db9::",
+        "2001:db7:ffff:ffff:ffff:ffff:ffff:ffff",
+        "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff",
+        "::1",
+        "::ffff:10.0.0.1",
+    ];
+    for mode in [IpFilterMode::Disabled, IpFilterMode::Allowlist, IpFilterMode::Denylist] {
+        let config = IpFilterConfig {
+            mode,
+            allowlist: parse_networks(&nets),
+            denylist: parse_networks(&nets),
+        };
+        let compiled = CompiledIpFilter::compile(&config);
+        for probe in probes {
+            let ip = IpAddr::from_str(probe)?;
+            assert_eq!(compiled.allows(ip), is_ip_allowed(ip, &config), "{mode:?} {probe}");
+        }
+    }
+    Ok(())
+}
+
+#[test]
+fn test_compiled_merges_overlapping_and_adjacent_prefixes() {
+    let compiled = CompiledIpFilter::compile(&denylist(&[
+        "10.0.0.0/8",
+        "10.1.0.0/16",
+        "192.168.1.0/25",
+        "192.168.1.128/25",
+        "2001:db8::/32",
+    ]));
+    assert_eq!(compiled.entries(), 5);
+    // 10/8 swallows 10.1/16; the two /25 halves join into one /24.
+    assert_eq!(compiled.ranges(), 3);
+}
+
+#[test]
+fn test_compiled_empty_lists_keep_reference_semantics() -> R {
+    let ip = IpAddr::from_str("192.168.1.1")?;
+    assert!(!CompiledIpFilter::compile(&allowlist(&[])).allows(ip));
+    assert!(CompiledIpFilter::compile(&denylist(&[])).allows(ip));
+    Ok(())
+}
+
+fn route(prefix: &str, ip_filter: Option<IpFilterConfig>) -> Route {
+    Route {
+        prefix: prefix.to_string(),
+        backend: "backend:80".to_string(),
+        fingerprinting: None,
+        force_new_connection: false,
+        load_balance: Default::default(),
+        replace_path: None,
+        security: ip_filter
+            .map(|f| RouteSecurityConfig { ip_filter: Some(f), ..RouteSecurityConfig::default() }),
+        headers: None,
+        cache: None,
+        coalesce: None,
+    }
+}
+
+fn domain(ip_filter: Option<IpFilterConfig>, routes: Vec<Route>) -> Domain {
+    Domain {
+        host: Some("a.com".to_string()),
+        cert_path: None,
+        key_path: None,
+        headers: None,
+        security: ip_filter.map(|f| DomainSecurityConfig {
+            ip_filter: Some(f),
+            ..DomainSecurityConfig::default()
+        }),
+        fingerprinting: None,
+        routes,
+    }
+}
+
+#[test]
+fn test_index_resolves_route_over_domain_over_global() -> R {
+    let ten = IpAddr::from_str("10.1.2.3")?;
+    let domains = vec![
+        // Route group "/a": its first route's override supplies the policy.
+        domain(
+            None,
+            vec![
+                route("/a", Some(allowlist(&["10.0.0.0/8"]))),
+                route("/a", Some(denylist(&["10.0.0.0/8"]))),
+                route("/", None),
+            ],
+        ),
+        domain(Some(allowlist(&["10.0.0.0/8"])), vec![route("/", None)]),
+    ];
+    let index = IpFilterIndex::new(&denylist(&["10.0.0.0/8"]), &domains);
+
+    assert!(!index.domain(None).allows(ten));
+    assert!(!index.domain(Some(0)).allows(ten));
+    assert!(index.domain(Some(1)).allows(ten));
+    assert!(index.route(Some(0), 0).allows(ten));
+    assert!(!index.route(Some(0), 2).allows(ten));
+    assert!(index.route(Some(1), 0).allows(ten));
+    // Out-of-range indices fall back to the parent scope.
+    assert!(!index.domain(Some(9)).allows(ten));
+    assert!(index.route(Some(1), 9).allows(ten));
+
+    // Only the group's first route override is compiled; the domain without an override
+    // shares the global filter.
+    assert_eq!(index.entries(), IpFilterEntries { global: 1, domain: 1, route: 1 });
+    Ok(())
+}
@@ -1,6 +1,7 @@
 pub mod headers;
 pub mod ip_filter;
 pub mod rate_limit;
+pub mod rate_limit_cluster;
 pub mod rate_limit_config;
 pub mod rate_limit_estimator;
 pub mod rate_limit_key;
@@ -0,0 +1,167 @@
+use huginn_proxy_lib::config::{Domain, DomainSecurityConfig, RateLimitConfig};
+use huginn_proxy_lib::security::rate_limit::{
+    ClusterCodec, DecodeError, Delta, MAX_AGE_MS, REPLAY_WINDOW,
+};
+use huginn_proxy_lib::security::{RateLimitKey, RateLimitManager};
+
+const SECRET: &[u8] = b"0123456789abcdef0123456789abcdef";
+const NOW_MS: u64 = 1_700_000_000_000;
+
+fn rl(rps: u32, burst: u32) -> RateLimitConfig {
+    RateLimitConfig { enabled: true, requests_per_second: rps, burst, ..RateLimitConfig::default() }
+}
+
+fn deltas(n: u64) -> Vec<Delta> {
+    (0..n)
+        .map(|i| Delta {
+            scope: i % 3,
+            key: RateLimitKey::from_hash(i.wrapping_mul(0x9e37_79b9_7f4a_7c15)),
+            count: u32::try_from(i).unwrap_or(u32::MAX).saturating_add(1),
+        })
+        .collect()
+}
+
+#[test]
+fn roundtrips_deltas_across_datagrams() -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let sender = ClusterCodec::new(SECRET, 1);
+    let receiver = ClusterCodec::new(SECRET, 2);
+    let sent = deltas(200);
+
+    let datagrams = sender.encode(&sent, NOW_MS);
+    assert!(datagrams.len() > 1, "200 deltas should not fit one datagram");
+    assert!(datagrams.iter().all(|d| d.len() <= 1200));
+
+    let mut received = Vec::new();
+    for datagram in &datagrams {
+        received.extend(
+            receiver
+                .decode(datagram, NOW_MS)
+                .map_err(|e| format!("{e:?}"))?,
+        );
+    }
+    assert_eq!(received, sent);
+    Ok(())
+}
+
+#[test]
+fn rejects_tampered_and_foreign_datagrams() {
+    let sender = ClusterCodec::new(SECRET, 1);
+    let receiver = ClusterCodec::new(SECRET, 2);
+    let foreign = ClusterCodec::new(b"another secret of sixteen bytes", 3);
+
+    let mut tampered = sender.encode(&deltas(4), NOW_MS).remove(0);
+    if let Some(byte) = tampered.get_mut(30) {
+        *byte ^= 1;
+    }
+    assert_eq!(receiver.decode(&tampered, NOW_MS), Err(DecodeError::Invalid));
+
+    let other = foreign.encode(&deltas(4), NOW_MS).remove(0);
+    assert_eq!(receiver.decode(&other, NOW_MS), Err(DecodeError::Invalid));
+    assert_eq!(receiver.decode(b"HRL2", NOW_MS), Err(DecodeError::Invalid));
+}
+
+#[test]
+fn ignores_own_and_stale_datagrams() {
+    let codec = ClusterCodec::new(SECRET, 1);
+    let peer = ClusterCodec::new(SECRET, 2);
+    let datagram = codec.encode(&deltas(2), NOW_MS).remove(0);
+
+    assert_eq!(codec.decode(&datagram, NOW_MS), Err(DecodeError::Own));
+    assert_eq!(
+        peer.decode(&datagram, NOW_MS.saturating_add(MAX_AGE_MS).saturating_add(1)),
+        Err(DecodeError::Stale)
+    );
+    // Dated further ahead than the receiver's clock allows.
+    assert_eq!(
+        peer.decode(&datagram, NOW_MS.saturating_sub(MAX_AGE_MS).saturating_sub(1)),
+        Err(DecodeError::Stale)
+    );
+    assert!(peer
+        .decode(&datagram, NOW_MS.saturating_sub(MAX_AGE_MS))
+        .is_ok());
+}
+
+#[test]
+fn drops_replayed_datagrams_and_accepts_reordered_ones() {
+    let sender = ClusterCodec::new(SECRET, 1);
+    let other = ClusterCodec::new(SECRET, 3);
+    let receiver = ClusterCodec::new(SECRET, 2);
+    let first = sender.encode(&deltas(2), NOW_MS).remove(0);
+    let second = sender.encode(&deltas(2), NOW_MS).remove(0);
+
+    // A rejected datagram is not recorded.
+    let late = NOW_MS.saturating_add(MAX_AGE_MS).saturating_add(1);
+    assert_eq!(receiver.decode(&second, late), Err(DecodeError::Stale));
+
+    assert!(receiver.decode(&second, NOW_MS).is_ok());
+    assert_eq!(receiver.decode(&second, NOW_MS), Err(DecodeError::Replayed));
+    // Reordered by the network: still inside the window, applied once.
+    assert!(receiver.decode(&first, NOW_MS).is_ok());
+    assert_eq!(receiver.decode(&first, NOW_MS), Err(DecodeError::Replayed));
+
+    // Sequences are per node.
+    let from_other = other.encode(&deltas(2), NOW_MS).remove(0);
+    assert!(receiver.decode(&from_other, NOW_MS).is_ok());
+    let third = sender.encode(&deltas(2), NOW_MS).remove(0);
+    assert!(receiver.decode(&third, NOW_MS).is_ok());
+}
+
+#[test]
+fn drops_datagrams_older_than_the_replay_window() {
+    let sender = ClusterCodec::new(SECRET, 1);
+    let receiver = ClusterCodec::new(SECRET, 2);
+    let mut datagrams: Vec<Vec<u8>> = (0..=REPLAY_WINDOW)
+        .map(|_| sender.encode(&deltas(1), NOW_MS).remove(0))
+        .collect();
+    let Some(newest) = datagrams.pop() else {
+        panic!("expected {REPLAY_WINDOW} + 1 datagrams");
+    };
+    assert!(receiver.decode(&newest, NOW_MS).is_ok());
+
+    // `REPLAY_WINDOW` sequences behind the newest: just outside the window.
+    let (oldest, in_window) = datagrams.split_at(1);
+    assert_eq!(receiver.decode(&oldest[0], NOW_MS), Err(DecodeError::Replayed));
+    for datagram in in_window.iter().rev() {
+        assert!(receiver.decode(datagram, NOW_MS).is_ok());
+    }
+}
+
+/// Requests admitted by one node are debited from the same scope and key on another, so the
+/// configured burst is shared rather than granted per node.
+#[test]
+fn peer_deltas_consume_the_shared_budget() {
+    let global = rl(1, 10);
+    let domains: Vec<Domain> = vec![Domain {
+        host: Some("a.com".to_string()),
+        cert_path: None,
+        key_path: None,
+        headers: None,
+        security: Some(DomainSecurityConfig {
+            rate_limit: Some(rl(1, 4)),
+            ..DomainSecurityConfig::default()
+        }),
+        fingerprinting: None,
+        routes: vec![],
+    }];
+    let node_a = RateLimitManager::clustered(&global, &domains);
+    let node_b = RateLimitManager::clustered(&global, &domains);
+
+    for _ in 0..3 {
+        assert!(node_a.check("ip", "a.com", None).is_allowed());
+    }
+    let mut pushed = Vec::new();
+    node_a.drain_deltas(&mut pushed);
+    assert_eq!(pushed.iter().map(|d| d.count).sum::<u32>(), 3);
+    node_b.apply_deltas(&pushed);
+
+    // Node B has one request of the domain's burst of 4 left.
+    assert!(node_b.check("ip", "a.com", None).is_allowed());
+    assert!(node_b.check("ip", "a.com", None).is_limited());
+    // Other domains use the untouched global limiter.
+    assert!(node_b.check("ip", "b.com", None).is_allowed());
+
+    // Drained deltas are not pushed twice.
+    pushed.clear();
+    node_a.drain_deltas(&mut pushed);
+    assert!(pushed.is_empty());
+}
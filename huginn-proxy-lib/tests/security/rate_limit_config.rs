@@ -1,4 +1,4 @@
-use huginn_proxy_lib::config::SecurityConfig;
+use huginn_proxy_lib::config::{LimitBy, RateLimitConfig, SecurityConfig};
 use ipnet::IpNet;
 
 #[test]
@@ -52,3 +52,13 @@ fn deserialize_unknown_field_errors() {
     "#;
     assert!(toml::from_str::<SecurityConfig>(toml).is_err());
 }
+
+#[test]
+fn deserialize_ja4_limit_by() -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    for (spelling, expected) in [("ja4", LimitBy::Ja4), ("ja4_ip", LimitBy::Ja4Ip)] {
+        let config: RateLimitConfig = toml::from_str(&format!("limit_by = \"{spelling}\""))?;
+        assert_eq!(config.limit_by, expected);
+        assert_eq!(config.limit_by.as_str(), spelling);
+    }
+    Ok(())
+}
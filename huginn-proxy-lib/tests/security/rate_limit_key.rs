@@ -1,5 +1,5 @@
 use huginn_proxy_lib::config::{LimitBy, TrustedProxiesConfig};
-use huginn_proxy_lib::security::extract_rate_limit_key;
+use huginn_proxy_lib::security::{extract_rate_limit_key, rate_limit_key};
 
 fn peer(s: &str) -> std::net::SocketAddr {
     s.parse()
@@ -30,7 +30,7 @@ fn key_ip(
     headers: &http::HeaderMap,
     proxies: &TrustedProxiesConfig,
 ) -> String {
-    extract_rate_limit_key(LimitBy::Ip, peer_addr, "/", None, headers, proxies)
+    extract_rate_limit_key(LimitBy::Ip, peer_addr, "/", None, headers, proxies, None)
 }
 
 #[test]
@@ -138,6 +138,7 @@ fn combined_no_trusted_uses_peer() {
         None,
         &headers_with_xff("9.9.9.9"),
         &none(),
+        None,
     );
     assert_eq!(key, "1.2.3.4:/api");
 }
@@ -152,6 +153,7 @@ fn combined_trusted_returns_real_client() {
         None,
         &headers_with_xff("203.0.113.5"),
         &proxies,
+        None,
     );
     assert_eq!(key, "203.0.113.5:/api");
 }
@@ -170,6 +172,7 @@ fn header_strategy_unchanged() {
         Some("x-api-key"),
         &h,
         &none(),
+        None,
     );
     assert_eq!(key, "secret-token");
 }
@@ -183,6 +186,81 @@ fn route_strategy_unchanged() {
         None,
         &headers_with_xff("9.9.9.9"),
         &none(),
+        None,
     );
     assert_eq!(key, "/api");
 }
+
+#[test]
+fn ja4_strategy_keys_by_fingerprint() {
+    let ja4 = "t13d1516h2_8daaf6152771_02713d6af862";
+    let key = extract_rate_limit_key(
+        LimitBy::Ja4,
+        peer("1.2.3.4:1234"),
+        "/",
+        None,
+        &http::HeaderMap::new(),
+        &none(),
+        Some(&ja4),
+    );
+    assert_eq!(key, ja4);
+
+    let key = extract_rate_limit_key(
+        LimitBy::Ja4Ip,
+        peer("1.2.3.4:1234"),
+        "/",
+        None,
+        &http::HeaderMap::new(),
+        &none(),
+        Some(&ja4),
+    );
+    assert_eq!(key, format!("{ja4}:1.2.3.4"));
+}
+
+#[test]
+fn ja4_strategy_without_fingerprint_uses_ip() {
+    for limit_by in [LimitBy::Ja4, LimitBy::Ja4Ip] {
+        let key = extract_rate_limit_key(
+            limit_by,
+            peer("1.2.3.4:1234"),
+            "/",
+            None,
+            &headers_with_xff("9.9.9.9"),
+            &none(),
+            None,
+        );
+        assert_eq!(key, "1.2.3.4");
+    }
+}
+
+#[test]
+fn hashed_key_shares_bucket_per_fingerprint_across_ips() {
+    let ja4 = "t13d1516h2_8daaf6152771_02713d6af862";
+    let headers = http::HeaderMap::new();
+    let hashed = |limit_by, addr: &str| {
+        rate_limit_key(limit_by, peer(addr), "/", None, &headers, &none(), Some(&ja4))
+    };
+    assert_eq!(hashed(LimitBy::Ja4, "1.2.3.4:1"), hashed(LimitBy::Ja4, "5.6.7.8:2"));
+    assert_ne!(hashed(LimitBy::Ja4Ip, "1.2.3.4:1"), hashed(LimitBy::Ja4Ip, "5.6.7.8:2"));
+    assert_eq!(hashed(LimitBy::Ip, "1.2.3.4:1"), hashed(LimitBy::Ip, "1.2.3.4:2"));
+}
+
+#[test]
+fn hashed_header_value_does_not_collide_with_ip() {
+    let mut h = http::HeaderMap::new();
+    h.insert(
+        http::header::HeaderName::from_static("x-api-key"),
+        http::header::HeaderValue::from_static("1.2.3.4"),
+    );
+    let by_header = rate_limit_key(
+        LimitBy::Header,
+        peer("5.6.7.8:1"),
+        "/",
+        Some("x-api-key"),
+        &h,
+        &none(),
+        None,
+    );
+    let by_ip = rate_limit_key(LimitBy::Ip, peer("1.2.3.4:1"), "/", None, &h, &none(), None);
+    assert_ne!(by_header, by_ip);
+}
@@ -1,4 +1,4 @@
-use huginn_proxy_lib::security::rate_limit::{RateLimitResult, RateLimiter};
+use huginn_proxy_lib::security::rate_limit::{RateLimitKey, RateLimitResult, RateLimiter};
 use std::thread::sleep;
 use std::time::Duration;
 
@@ -161,3 +161,41 @@ fn test_concurrent_limiting() {
     // Most requests should still be limited
     assert!(total_limited >= 40, "Limited {} requests, expected ≥40", total_limited);
 }
+
+#[test]
+fn test_refills_at_requests_per_second() {
+    // 20 rps, burst 1: one request every 50 ms.
+    let limiter = RateLimiter::new(20, 1, Duration::from_secs(1));
+    assert!(limiter.check(&"key").is_allowed());
+    assert!(limiter.check(&"key").is_limited());
+
+    sleep(Duration::from_millis(60));
+    assert!(limiter.check(&"key").is_allowed());
+    assert!(limiter.check(&"key").is_limited());
+}
+
+#[test]
+fn test_check_key_matches_check() {
+    let limiter = RateLimiter::new(10, 2, Duration::from_secs(1));
+    let key = RateLimitKey::of("client");
+    assert!(limiter.check(&"client").is_allowed());
+    assert!(limiter.check_key(key).is_allowed());
+    assert!(limiter.check_key(key).is_limited());
+    assert!(limiter.check_key_only(key).is_limited());
+}
+
+#[test]
+fn test_evicts_refilled_keys() {
+    // 1000 rps, burst 1: every bucket is full again after 1 ms.
+    let limiter = RateLimiter::new(1000, 1, Duration::from_secs(1));
+    for i in 0..100u32 {
+        assert!(limiter.check(&i).is_allowed());
+    }
+    assert_eq!(limiter.tracked_keys(), 100);
+
+    sleep(Duration::from_millis(5));
+    assert_eq!(limiter.evict_idle(), 0);
+    // An evicted key starts over with a full bucket.
+    assert!(limiter.check(&0u32).is_allowed());
+    assert_eq!(limiter.tracked_keys(), 1);
+}
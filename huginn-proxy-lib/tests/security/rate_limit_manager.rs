@@ -15,12 +15,15 @@ fn route(prefix: &str, rate_limit: Option<RateLimitConfig>) -> Route {
         backend: "backend:80".to_string(),
         fingerprinting: None,
         force_new_connection: false,
+        load_balance: Default::default(),
         replace_path: None,
         security: rate_limit.map(|rl| RouteSecurityConfig {
             rate_limit: Some(rl),
             ..RouteSecurityConfig::default()
         }),
         headers: None,
+        cache: None,
+        coalesce: None,
     }
 }
 
@@ -0,0 +1,91 @@
+use http::header::{AUTHORIZATION, WWW_AUTHENTICATE};
+use http::{HeaderMap, HeaderValue, StatusCode};
+use http_body_util::BodyExt;
+use huginn_proxy_lib::config::DebugConfig;
+use huginn_proxy_lib::telemetry::DebugEndpoints;
+
+type R = Result<(), Box<dyn std::error::Error + Send + Sync>>;
+
+const TOKEN: &str = "0123456789abcdef";
+
+fn endpoints() -> Result<DebugEndpoints, &'static str> {
+    let config =
+        DebugConfig { enabled: true, token: TOKEN.to_string().into(), max_window_seconds: 5 };
+    DebugEndpoints::new(&config).ok_or("enabled config should serve the endpoints")
+}
+
+fn bearer(token: &str) -> Result<HeaderMap, http::header::InvalidHeaderValue> {
+    let mut headers = HeaderMap::new();
+    headers.insert(AUTHORIZATION, HeaderValue::try_from(format!("Bearer {token}"))?);
+    Ok(headers)
+}
+
+#[test]
+fn test_disabled_config_serves_nothing() {
+    assert!(DebugEndpoints::new(&DebugConfig::default()).is_none());
+}
+
+#[tokio::test]
+async fn test_requests_need_the_token() -> R {
+    let debug = endpoints()?;
+
+    let response = debug
+        .handle("/debug/runtime", None, &HeaderMap::new())
+        .await;
+    assert_eq!(response.status(), StatusCode::UNAUTHORIZED);
+    assert_eq!(
+        response.headers().get(WWW_AUTHENTICATE),
+        Some(&HeaderValue::from_static("Bearer"))
+    );
+
+    for token in ["0123456789abcdeX", "0123456789abcde", ""] {
+        let response = debug.handle("/debug/runtime", None, &bearer(token)?).await;
+        assert_eq!(response.status(), StatusCode::UNAUTHORIZED, "token {token:?}");
+    }
+    // The token is checked before the path: unknown paths don't reveal themselves either.
+    let response = debug
+        .handle("/debug/unknown", None, &HeaderMap::new())
+        .await;
+    assert_eq!(response.status(), StatusCode::UNAUTHORIZED);
+    let response = debug.handle("/debug/unknown", None, &bearer(TOKEN)?).await;
+    assert_eq!(response.status(), StatusCode::NOT_FOUND);
+    Ok(())
+}
+
+#[tokio::test(flavor = "multi_thread", worker_threads = 2)]
+async fn test_runtime_stats() -> R {
+    let debug = endpoints()?;
+    let headers = bearer(TOKEN)?;
+
+    for seconds in ["0", "6", "soon"] {
+        let query = format!("seconds={seconds}");
+        let response = debug.handle("/debug/runtime", Some(&query), &headers).await;
+        assert_eq!(response.status(), StatusCode::BAD_REQUEST, "seconds={seconds}");
+    }
+
+    let response = debug
+        .handle("/debug/runtime", Some("seconds=1"), &headers)
+        .await;
+    assert_eq!(response.status(), StatusCode::OK);
+    let body = response.into_body().collect().await?.to_bytes();
+    let stats: serde_json::Value = serde_json::from_slice(&body)?;
+    assert_eq!(stats["workers"], 2);
+    assert!(stats["window_seconds"].as_f64().ok_or("missing window")? >= 1.0);
+    let workers = stats["worker"].as_array().ok_or("missing worker stats")?;
+    assert_eq!(workers.len(), 2);
+    for worker in workers {
+        let busy = worker["busy_ratio"].as_f64().ok_or("missing busy_ratio")?;
+        assert!((0.0..=1.0).contains(&busy), "busy_ratio {busy}");
+    }
+    Ok(())
+}
+
+#[tokio::test]
+async fn test_profiles_are_not_served() -> R {
+    let debug = endpoints()?;
+    for path in ["/debug/pprof/profile", "/debug/pprof/heap"] {
+        let response = debug.handle(path, None, &bearer(TOKEN)?).await;
+        assert_eq!(response.status(), StatusCode::NOT_FOUND, "{path}");
+    }
+    Ok(())
+}
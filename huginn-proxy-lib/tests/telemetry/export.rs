@@ -0,0 +1,128 @@
+use std::net::{IpAddr, Ipv4Addr};
+use std::time::{Duration, SystemTime};
+
+use http::HeaderValue;
+use huginn_proxy_lib::config::FingerprintExportConfig;
+use huginn_proxy_lib::shutdown_channel;
+use huginn_proxy_lib::telemetry::{ExportTask, FingerprintExporter, FingerprintRecord, Metrics};
+use serde_json::Value;
+use tokio::io::{AsyncBufReadExt, BufReader};
+use tokio::net::TcpListener;
+
+type R = Result<(), Box<dyn std::error::Error + Send + Sync>>;
+
+fn record(host: &str, at: SystemTime, spoofed: Vec<&'static str>) -> FingerprintRecord {
+    FingerprintRecord {
+        time: at,
+        client_ip: IpAddr::V4(Ipv4Addr::new(198, 51, 100, 7)),
+        host: host.into(),
+        ja4: None,
+        akamai: Some(HeaderValue::from_static("1:65536;4:6291456|15663105|0|m,a,s,p")),
+        tcp_syn: None,
+        spoofed,
+    }
+}
+
+fn exporter(
+    config: FingerprintExportConfig,
+) -> Result<(std::sync::Arc<FingerprintExporter>, ExportTask), &'static str> {
+    FingerprintExporter::new(&config, Metrics::new_noop()).ok_or("enabled config should export")
+}
+
+/// Run `task` until shutdown, after the records already pushed are queued.
+async fn run_to_shutdown(task: ExportTask) -> R {
+    let (shutdown_tx, shutdown_rx) = shutdown_channel();
+    let service = task.spawn(shutdown_rx).await?;
+    shutdown_tx.send(true)?;
+    service.handle.await?;
+    Ok(())
+}
+
+#[test]
+fn test_disabled_config_exports_nothing() {
+    let config = FingerprintExportConfig::default();
+    assert!(FingerprintExporter::new(&config, Metrics::new_noop()).is_none());
+}
+
+#[tokio::test]
+async fn test_identical_records_are_written_once_with_a_count() -> R {
+    let dir = tempfile::tempdir()?;
+    let path = dir.path().join("fingerprints.ndjson");
+    let (exporter, task) = exporter(FingerprintExportConfig {
+        enabled: true,
+        path: Some(path.clone()),
+        ..FingerprintExportConfig::default()
+    })?;
+
+    let start = SystemTime::now();
+    let later = start
+        .checked_add(Duration::from_millis(250))
+        .ok_or("time overflow")?;
+    assert!(exporter.push(record("api.example.com", start, Vec::new())));
+    assert!(exporter.push(record("api.example.com", later, Vec::new())));
+    assert!(exporter.push(record("www.example.com", later, vec!["x-tls-ja4"])));
+    run_to_shutdown(task).await?;
+
+    let contents = tokio::fs::read_to_string(&path).await?;
+    let lines: Vec<Value> = contents
+        .lines()
+        .map(serde_json::from_str)
+        .collect::<Result<_, _>>()?;
+    assert_eq!(lines.len(), 2, "got: {contents}");
+
+    let api = lines
+        .iter()
+        .find(|line| line["host"] == "api.example.com")
+        .ok_or("missing api.example.com")?;
+    assert_eq!(api["count"], 2);
+    assert_eq!(api["client_ip"], "198.51.100.7");
+    assert_eq!(api["akamai"], "1:65536;4:6291456|15663105|0|m,a,s,p");
+    assert!(api["last_seen_ms"].as_u64() > api["first_seen_ms"].as_u64());
+    assert!(api.get("spoofed").is_none());
+    assert!(api.get("ja4").is_none());
+
+    let www = lines
+        .iter()
+        .find(|line| line["host"] == "www.example.com")
+        .ok_or("missing www.example.com")?;
+    assert_eq!(www["count"], 1);
+    assert_eq!(www["spoofed"], serde_json::json!(["x-tls-ja4"]));
+    Ok(())
+}
+
+#[tokio::test]
+async fn test_full_queue_drops_instead_of_blocking() -> R {
+    let dir = tempfile::tempdir()?;
+    let (exporter, _task) = exporter(FingerprintExportConfig {
+        enabled: true,
+        path: Some(dir.path().join("fingerprints.ndjson")),
+        queue_capacity: 1,
+        ..FingerprintExportConfig::default()
+    })?;
+
+    // Nothing drains the queue: the first record fills it.
+    assert!(exporter.push(record("api.example.com", SystemTime::now(), Vec::new())));
+    assert!(!exporter.push(record("api.example.com", SystemTime::now(), Vec::new())));
+    Ok(())
+}
+
+#[tokio::test]
+async fn test_tcp_endpoint_receives_ndjson() -> R {
+    let collector = TcpListener::bind("127.0.0.1:0").await?;
+    let (exporter, task) = exporter(FingerprintExportConfig {
+        enabled: true,
+        endpoint: Some(collector.local_addr()?.to_string()),
+        ..FingerprintExportConfig::default()
+    })?;
+
+    assert!(exporter.push(record("api.example.com", SystemTime::now(), Vec::new())));
+    run_to_shutdown(task).await?;
+
+    let (socket, _) = collector.accept().await?;
+    let mut line = String::new();
+    BufReader::new(socket).read_line(&mut line).await?;
+    let line: Value = serde_json::from_str(&line)?;
+    assert_eq!(line["host"], "api.example.com");
+    assert_eq!(line["count"], 1);
+    Ok(())
+}
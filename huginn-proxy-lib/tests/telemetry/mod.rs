@@ -0,0 +1,3 @@
+mod debug;
+mod export;
+mod timing;
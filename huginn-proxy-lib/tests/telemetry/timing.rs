@@ -0,0 +1,94 @@
+use std::net::IpAddr;
+use std::sync::Arc;
+
+use http::HeaderMap;
+use huginn_proxy_lib::config::TimingConfig;
+use huginn_proxy_lib::telemetry::timing::SERVER_TIMING;
+use huginn_proxy_lib::telemetry::{ConnectionTiming, Metrics, Phase, TimingPolicy};
+use tokio::time::{Duration, Instant};
+
+type R = Result<(), Box<dyn std::error::Error + Send + Sync>>;
+
+fn policy(server_timing_cidrs: &[&str]) -> Result<Arc<TimingPolicy>, ipnet::AddrParseError> {
+    let config = TimingConfig {
+        server_timing_cidrs: server_timing_cidrs
+            .iter()
+            .map(|cidr| cidr.parse())
+            .collect::<Result<_, _>>()?,
+        ..TimingConfig::default()
+    };
+    Ok(Arc::new(TimingPolicy::new(&config)))
+}
+
+/// Names of the `Server-Timing` metrics, in order.
+fn names(headers: &HeaderMap) -> Result<Vec<String>, Box<dyn std::error::Error + Send + Sync>> {
+    let value = headers
+        .get(SERVER_TIMING)
+        .ok_or("missing Server-Timing")?
+        .to_str()?;
+    Ok(value
+        .split(", ")
+        .filter_map(|metric| metric.split(";dur=").next())
+        .map(str::to_string)
+        .collect())
+}
+
+#[test]
+fn test_phases_are_reported_in_order() -> R {
+    let metrics = Metrics::new_noop();
+    let client: IpAddr = "10.1.2.3".parse()?;
+    let mut connection = ConnectionTiming::new(policy(&["10.0.0.0/8"])?, client);
+    connection.record(Phase::ProxyProtocol, Duration::from_millis(2), &metrics);
+    connection.record(Phase::TlsAccept, Duration::from_micros(1500), &metrics);
+    assert_eq!(connection.phases().get(Phase::ProxyProtocol), Some(Duration::from_millis(2)));
+    assert_eq!(connection.phases().get(Phase::SynProbe), None);
+
+    let mut first = connection.request(Instant::now());
+    first.mark(Phase::Routing, &metrics);
+    first.mark(Phase::Upstream, &metrics);
+    assert!(first.phases().get(Phase::Routing).is_some());
+    assert_eq!(first.phases().get(Phase::Cache), None);
+
+    let mut headers = HeaderMap::new();
+    first.finish(Some(&mut headers), 200, "/", "example.com");
+    assert_eq!(
+        names(&headers)?,
+        ["proxy_protocol", "tls_accept", "routing", "upstream", "total"]
+    );
+    let value = headers.get(SERVER_TIMING).ok_or("missing Server-Timing")?;
+    assert!(value
+        .to_str()?
+        .starts_with("proxy_protocol;dur=2.000, tls_accept;dur=1.500, "));
+
+    // Later requests on the connection only report their own phases.
+    let mut second = connection.request(Instant::now());
+    second.mark(Phase::Routing, &metrics);
+    let mut headers = HeaderMap::new();
+    second.finish(Some(&mut headers), 200, "/", "example.com");
+    assert_eq!(names(&headers)?, ["routing", "total"]);
+    Ok(())
+}
+
+#[test]
+fn test_server_timing_only_for_listed_clients() -> R {
+    let metrics = Metrics::new_noop();
+    let policy = policy(&["10.0.0.0/8", "::1/128"])?;
+    assert!(policy.server_timing("::1".parse()?));
+    assert!(!policy.server_timing("192.0.2.1".parse()?));
+
+    let connection = ConnectionTiming::new(Arc::clone(&policy), "192.0.2.1".parse()?);
+    let mut request = connection.request(Instant::now());
+    request.mark(Phase::Routing, &metrics);
+    let mut headers = HeaderMap::new();
+    request.finish(Some(&mut headers), 200, "/", "example.com");
+    assert!(headers.get(SERVER_TIMING).is_none());
+
+    // Off by default.
+    let default = ConnectionTiming::new(Arc::new(TimingPolicy::default()), "10.1.2.3".parse()?);
+    let mut headers = HeaderMap::new();
+    default
+        .request(Instant::now())
+        .finish(Some(&mut headers), 200, "/", "example.com");
+    assert!(headers.is_empty());
+    Ok(())
+}
@@ -101,3 +101,14 @@ fn test_client_auth_enum_default() {
     let default_auth = ClientAuth::default();
     assert!(matches!(default_auth, ClientAuth::Disabled));
 }
+
+#[test]
+fn test_ktls_enables_secret_extraction() -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let acceptor = build_acceptor(&[], &TlsOptions::default(), &ClientAuth::Disabled)?;
+    assert!(!acceptor.config().enable_secret_extraction, "kTLS is opt-in");
+
+    let options = TlsOptions { ktls: true, ..Default::default() };
+    let acceptor = build_acceptor(&[], &options, &ClientAuth::Disabled)?;
+    assert_eq!(acceptor.config().enable_secret_extraction, cfg!(target_os = "linux"));
+    Ok(())
+}
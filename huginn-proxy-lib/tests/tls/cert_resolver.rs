@@ -245,3 +245,29 @@ async fn failed_reload_keeps_previous_cert() -> Result<(), Box<dyn std::error::E
     );
     Ok(())
 }
+
+/// Unchanged cert files keep the cert already in service; rewritten files are loaded again.
+#[tokio::test]
+async fn unchanged_cert_files_are_reused() -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let (cert, key) = create_valid_test_cert()?;
+    let (other_cert, other_key) = create_valid_test_cert()?;
+    let resolver = DynamicCertResolver::new(false);
+    let domains = vec![domain(Some("api.example.com"), &cert, &key)];
+
+    let first = resolver.update(&domains, &Metrics::new_noop()).await;
+    assert_eq!((first.loaded, first.reused), (1, 0), "first load parses the files");
+    let second = resolver.update(&domains, &Metrics::new_noop()).await;
+    assert_eq!((second.loaded, second.reused), (0, 1), "same content is not parsed again");
+
+    // Rotation: new content at the same paths.
+    std::fs::copy(&other_cert, &cert)?;
+    std::fs::copy(&other_key, &key)?;
+    let third = resolver.update(&domains, &Metrics::new_noop()).await;
+
+    for path in [&cert, &key, &other_cert, &other_key] {
+        let _ = std::fs::remove_file(path);
+    }
+    assert_eq!((third.loaded, third.reused, third.failed), (1, 0, 0), "rotated files load");
+    assert!(resolver.resolves_for(Some("api.example.com")));
+    Ok(())
+}
@@ -19,7 +19,8 @@ async fn build_tls_acceptor_produces_usable_acceptor(
         session_resumption: Default::default(),
     };
 
-    let acceptor = build_tls_acceptor(&config, Arc::new(DynamicCertResolver::new(false))).await?;
+    let acceptor =
+        build_tls_acceptor(&config, Arc::new(DynamicCertResolver::new(false)), None, None).await?;
     // Acceptor must have been built successfully and be loadable.
     let _ = acceptor.load();
     Ok(())
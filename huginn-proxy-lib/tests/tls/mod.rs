@@ -27,5 +27,7 @@ pub fn build_acceptor(
         options,
         client_auth,
         &Default::default(),
+        None,
+        None,
     )
 }
@@ -169,4 +169,13 @@ fn test_tls_options_default_values() {
         !options.curve_preferences.is_empty(),
         "Default curve_preferences should contain all supported curves"
     );
+    assert!(!options.ktls, "kTLS offload should be opt-in");
+}
+
+#[test]
+fn test_tls_options_ktls_toml() -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let options: TlsOptions = toml::from_str("ktls = true")?;
+    assert!(options.ktls);
+    assert!(validate_tls_options(&options).is_ok());
+    Ok(())
 }
@@ -18,7 +18,11 @@ fn test_session_resumption_disabled() {
         alpn: vec![],
         options: Default::default(),
         client_auth: ClientAuth::Disabled,
-        session_resumption: SessionResumptionConfig { enabled: false, max_sessions: 256 },
+        session_resumption: SessionResumptionConfig {
+            enabled: false,
+            max_sessions: 256,
+            ..Default::default()
+        },
     };
     assert!(!config.session_resumption.enabled);
 }
@@ -29,7 +33,11 @@ fn test_session_resumption_custom_cache_size() {
         alpn: vec![],
         options: Default::default(),
         client_auth: ClientAuth::Disabled,
-        session_resumption: SessionResumptionConfig { enabled: true, max_sessions: 512 },
+        session_resumption: SessionResumptionConfig {
+            enabled: true,
+            max_sessions: 512,
+            ..Default::default()
+        },
     };
     assert_eq!(config.session_resumption.max_sessions, 512);
 }
@@ -41,6 +49,9 @@ fn test_session_resumption_config_defaults() {
     // Verify defaults
     assert!(config.enabled);
     assert_eq!(config.max_sessions, 256);
+    assert!(config.ticket_keys_path.is_none());
+    assert_eq!(config.ticket_lifetime_secs, 21600);
+    assert!(config.shared_cache.is_none());
 }
 
 #[test]
@@ -71,7 +82,8 @@ fn test_session_storage_configuration() -> Result<(), Box<dyn std::error::Error
         .with_no_client_auth()
         .with_single_cert(vec![cert.clone()], key.clone_key())?;
 
-    let config_enabled = SessionResumptionConfig { enabled: true, max_sessions: 512 };
+    let config_enabled =
+        SessionResumptionConfig { enabled: true, max_sessions: 512, ..Default::default() };
 
     configure_session_resumption(&mut server, &config_enabled);
 
@@ -79,7 +91,8 @@ fn test_session_storage_configuration() -> Result<(), Box<dyn std::error::Error
         .with_no_client_auth()
         .with_single_cert(vec![cert], key)?;
 
-    let config_disabled = SessionResumptionConfig { enabled: false, max_sessions: 256 };
+    let config_disabled =
+        SessionResumptionConfig { enabled: false, max_sessions: 256, ..Default::default() };
 
     configure_session_resumption(&mut server_disabled, &config_disabled);
 
@@ -104,7 +117,8 @@ fn test_ticket_producer_configuration() -> Result<(), Box<dyn std::error::Error
     // Check default ticketer state before configuration
     let default_ticketer_enabled = server.ticketer.enabled();
 
-    let config_enabled = SessionResumptionConfig { enabled: true, max_sessions: 256 };
+    let config_enabled =
+        SessionResumptionConfig { enabled: true, max_sessions: 256, ..Default::default() };
 
     configure_session_resumption(&mut server, &config_enabled);
 
@@ -116,7 +130,8 @@ fn test_ticket_producer_configuration() -> Result<(), Box<dyn std::error::Error
         .with_no_client_auth()
         .with_single_cert(vec![cert], key)?;
 
-    let config_disabled = SessionResumptionConfig { enabled: false, max_sessions: 256 };
+    let config_disabled =
+        SessionResumptionConfig { enabled: false, max_sessions: 256, ..Default::default() };
 
     configure_session_resumption(&mut server_disabled, &config_disabled);
 
@@ -125,3 +140,301 @@ fn test_ticket_producer_configuration() -> Result<(), Box<dyn std::error::Error
     assert_eq!(server_disabled.ticketer.lifetime(), 0);
     Ok(())
 }
+
+const KEY_A: &str = "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f";
+const KEY_B: &str = "ffeeddccbbaa99887766554433221100ffeeddccbbaa99887766554433221100";
+
+fn ticket_key_file(contents: &str) -> Result<tempfile::NamedTempFile, std::io::Error> {
+    let file = tempfile::NamedTempFile::new()?;
+    std::fs::write(file.path(), contents)?;
+    Ok(file)
+}
+
+#[test]
+fn test_shared_resumption_toml_deserialization(
+) -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    let toml_str = r#"
+ticket_keys_path = "/run/secrets/tls-ticket-keys"
+ticket_lifetime_secs = 7200
+
+[shared_cache]
+memcached = "memcached:11211"
+timeout_ms = 5
+"#;
+
+    let config: SessionResumptionConfig = toml::from_str(toml_str)?;
+
+    assert_eq!(config.ticket_keys_path.as_deref(), Some("/run/secrets/tls-ticket-keys"));
+    assert_eq!(config.ticket_lifetime_secs, 7200);
+    let cache = config.shared_cache.ok_or("expected shared_cache")?;
+    assert_eq!(cache.memcached, "memcached:11211");
+    assert_eq!(cache.timeout_ms, 5);
+    assert_eq!(cache.ttl_secs, 3600);
+    assert_eq!(cache.key_prefix, "huginn:tls:");
+    Ok(())
+}
+
+#[test]
+fn test_shared_ticketer_resumes_across_instances(
+) -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    use huginn_proxy_lib::tls::SharedTicketer;
+    use tokio_rustls::rustls::server::ProducesTickets;
+
+    let file = ticket_key_file(&format!("# current\n{KEY_A}\n"))?;
+    let replica_a = SharedTicketer::load(file.path(), 3600)?;
+    let replica_b = SharedTicketer::load(file.path(), 3600)?;
+
+    let ticket = replica_a
+        .encrypt(b"session state")
+        .ok_or("encrypt failed")?;
+    assert_eq!(replica_b.decrypt(&ticket).as_deref(), Some(b"session state".as_slice()));
+    assert_eq!(replica_b.lifetime(), 3600);
+
+    // A tampered ticket is rejected.
+    let mut tampered = ticket.clone();
+    let last = tampered.last_mut().ok_or("empty ticket")?;
+    *last ^= 1;
+    assert!(replica_b.decrypt(&tampered).is_none());
+    Ok(())
+}
+
+#[test]
+fn test_shared_ticketer_key_rotation() -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    use huginn_proxy_lib::tls::SharedTicketer;
+    use tokio_rustls::rustls::server::ProducesTickets;
+
+    let file = ticket_key_file(&format!("{KEY_A}\n"))?;
+    let ticketer = SharedTicketer::load(file.path(), 3600)?;
+    let old_ticket = ticketer.encrypt(b"old").ok_or("encrypt failed")?;
+
+    // New key on top: it seals new tickets, the previous key still opens old ones.
+    std::fs::write(file.path(), format!("{KEY_B}\n{KEY_A} # previous\n"))?;
+    assert_eq!(ticketer.reload()?, 2);
+    let new_ticket = ticketer.encrypt(b"new").ok_or("encrypt failed")?;
+    assert_eq!(ticketer.decrypt(&old_ticket).as_deref(), Some(b"old".as_slice()));
+
+    // Retiring the previous key invalidates its tickets only.
+    std::fs::write(file.path(), format!("{KEY_B}\n"))?;
+    ticketer.reload()?;
+    assert!(ticketer.decrypt(&old_ticket).is_none());
+    assert_eq!(ticketer.decrypt(&new_ticket).as_deref(), Some(b"new".as_slice()));
+
+    // A broken file keeps the keys in use.
+    std::fs::write(file.path(), "not-a-key\n")?;
+    assert!(ticketer.reload().is_err());
+    assert_eq!(ticketer.key_count(), 1);
+    assert_eq!(ticketer.decrypt(&new_ticket).as_deref(), Some(b"new".as_slice()));
+    Ok(())
+}
+
+#[test]
+fn test_shared_ticketer_rejects_invalid_files(
+) -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    use huginn_proxy_lib::tls::SharedTicketer;
+
+    let empty = ticket_key_file("# no keys yet\n\n")?;
+    assert!(SharedTicketer::load(empty.path(), 3600).is_err());
+
+    let short = ticket_key_file("0011\n")?;
+    assert!(SharedTicketer::load(short.path(), 3600).is_err());
+
+    assert!(SharedTicketer::load("/nonexistent/ticket-keys", 3600).is_err());
+    Ok(())
+}
+
+#[test]
+fn test_shared_session_resumption_configuration(
+) -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    use huginn_proxy_lib::config::SharedSessionCacheConfig;
+    use huginn_proxy_lib::tls::session_resumption::{
+        configure_session_resumption, configure_shared_session_resumption,
+    };
+    use huginn_proxy_lib::tls::{SharedSessionCache, SharedTicketer};
+    use tokio_rustls::rustls::ServerConfig;
+
+    let (cert, key) = generate_valid_test_cert_der()?;
+    let mut server = ServerConfig::builder()
+        .with_no_client_auth()
+        .with_single_cert(vec![cert], key)?;
+
+    let file = ticket_key_file(&format!("{KEY_A}\n"))?;
+    let config = SessionResumptionConfig {
+        ticket_keys_path: Some(file.path().display().to_string()),
+        ticket_lifetime_secs: 1234,
+        // Nothing listens here: lookups miss and sessions stay in the local cache.
+        shared_cache: Some(SharedSessionCacheConfig {
+            memcached: "127.0.0.1:1".to_string(),
+            timeout_ms: 10,
+            ttl_secs: 60,
+            key_prefix: "test:".to_string(),
+        }),
+        ..Default::default()
+    };
+    let ticketer = SharedTicketer::from_config(&config)?.ok_or("expected a shared ticketer")?;
+
+    configure_session_resumption(&mut server, &config);
+    // Cached sessions are sealed with the ticket keys: there is no cache without them.
+    assert!(SharedSessionCache::from_config(&config, None).is_err());
+    let session_cache = SharedSessionCache::from_config(&config, Some(ticketer.clone()))?;
+    assert!(session_cache.is_some());
+    configure_shared_session_resumption(&mut server, &config, Some(ticketer), session_cache);
+
+    assert!(server.ticketer.enabled());
+    assert_eq!(server.ticketer.lifetime(), 1234);
+    assert!(server.session_storage.can_cache());
+    assert!(server.session_storage.get(b"session-id").is_none());
+    assert!(server
+        .session_storage
+        .put(b"session-id".to_vec(), b"state".to_vec()));
+    assert_eq!(server.session_storage.get(b"session-id").as_deref(), Some(b"state".as_slice()));
+    assert_eq!(server.session_storage.take(b"session-id").as_deref(), Some(b"state".as_slice()));
+    Ok(())
+}
+
+/// Sessions stored by the fake memcached, by key.
+type Stored = std::sync::Arc<std::sync::Mutex<std::collections::HashMap<String, Vec<u8>>>>;
+
+/// In-process memcached speaking the text commands of the shared session cache (`get`,
+/// `set … noreply`, `delete … noreply`).
+fn fake_memcached() -> Result<(String, Stored), std::io::Error> {
+    use std::io::{BufRead, BufReader, Read, Write};
+
+    let listener = std::net::TcpListener::bind("127.0.0.1:0")?;
+    let addr = listener.local_addr()?.to_string();
+    let stored = Stored::default();
+    let shared = std::sync::Arc::clone(&stored);
+    std::thread::spawn(move || {
+        for stream in listener.incoming().flatten() {
+            let stored = std::sync::Arc::clone(&shared);
+            std::thread::spawn(move || -> std::io::Result<()> {
+                let mut writer = stream.try_clone()?;
+                let mut reader = BufReader::new(stream);
+                let mut line = String::new();
+                while reader.read_line(&mut line)? > 0 {
+                    let words: Vec<String> = line.split_whitespace().map(String::from).collect();
+                    let mut stored = stored.lock().unwrap_or_else(|e| e.into_inner());
+                    match words
+                        .iter()
+                        .map(String::as_str)
+                        .collect::<Vec<_>>()
+                        .as_slice()
+                    {
+                        ["get", key] => {
+                            if let Some(value) = stored.get(*key) {
+                                write!(writer, "VALUE {key} 0 {}\r\n", value.len())?;
+                                writer.write_all(value)?;
+                                writer.write_all(b"\r\n")?;
+                            }
+                            writer.write_all(b"END\r\n")?;
+                        }
+                        ["set", key, _flags, _ttl, len, "noreply"] => {
+                            let len: usize = len.parse().map_err(std::io::Error::other)?;
+                            let mut value = vec![0u8; len.saturating_add(2)];
+                            reader.read_exact(&mut value)?;
+                            value.truncate(len);
+                            stored.insert((*key).to_string(), value);
+                        }
+                        ["delete", key, "noreply"] => {
+                            stored.remove(*key);
+                        }
+                        _ => return Ok(()),
+                    }
+                    line.clear();
+                }
+                Ok(())
+            });
+        }
+    });
+    Ok((addr, stored))
+}
+
+/// A ClientHello record offering `session_id`, followed by `extensions` (type, data) pairs.
+fn client_hello(session_id: &[u8], extensions: &[(u16, &[u8])]) -> Vec<u8> {
+    let mut extension_bytes = Vec::new();
+    for (kind, data) in extensions {
+        extension_bytes.extend_from_slice(&kind.to_be_bytes());
+        extension_bytes.extend_from_slice(&(data.len() as u16).to_be_bytes());
+        extension_bytes.extend_from_slice(data);
+    }
+
+    let mut body = vec![0x03, 0x03];
+    body.extend_from_slice(&[0x42; 32]);
+    body.push(session_id.len() as u8);
+    body.extend_from_slice(session_id);
+    // TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256, no compression.
+    body.extend_from_slice(&[0x00, 0x02, 0xc0, 0x2f, 0x01, 0x00]);
+    body.extend_from_slice(&(extension_bytes.len() as u16).to_be_bytes());
+    body.extend_from_slice(&extension_bytes);
+
+    let mut handshake = vec![0x01];
+    handshake.extend_from_slice(&(body.len() as u32).to_be_bytes()[1..]);
+    handshake.extend_from_slice(&body);
+
+    let mut record = vec![0x16, 0x03, 0x01];
+    record.extend_from_slice(&(handshake.len() as u16).to_be_bytes());
+    record.extend_from_slice(&handshake);
+    record
+}
+
+#[tokio::test]
+async fn test_shared_session_cache_seals_values(
+) -> Result<(), Box<dyn std::error::Error + Send + Sync>> {
+    use huginn_proxy_lib::config::SharedSessionCacheConfig;
+    use huginn_proxy_lib::tls::{SharedSessionCache, SharedTicketer};
+    use tokio_rustls::rustls::server::StoresServerSessions;
+
+    let (memcached, stored) = fake_memcached()?;
+    let config = SharedSessionCacheConfig {
+        memcached,
+        timeout_ms: 500,
+        ttl_secs: 60,
+        key_prefix: "t:".into(),
+    };
+    let file = ticket_key_file(&format!("{KEY_A}\n"))?;
+    let replica_a =
+        SharedSessionCache::connect(&config, 16, SharedTicketer::load(file.path(), 60)?)?;
+    let replica_b =
+        SharedSessionCache::connect(&config, 16, SharedTicketer::load(file.path(), 60)?)?;
+
+    assert!(replica_a.put(b"\x01\x02".to_vec(), b"master secret".to_vec()));
+    let written = (0..200)
+        .find_map(|_| {
+            let value = stored.lock().ok()?.get("t:0102").cloned();
+            if value.is_none() {
+                std::thread::sleep(std::time::Duration::from_millis(10));
+            }
+            value
+        })
+        .ok_or("session was not written to memcached")?;
+    assert!(!written
+        .windows(b"master secret".len())
+        .any(|w| w == b"master secret"));
+
+    // rustls only reads the local cache; the accept path prefetches from the ClientHello.
+    assert!(replica_b.get(b"\x01\x02").is_none());
+    // Clients offering TLS 1.3 or a session ticket don't resume by session ID: no lookup.
+    replica_b
+        .prefetch(&client_hello(b"\x01\x02", &[(43, &[0x04, 0x03, 0x04, 0x03, 0x03])]))
+        .await;
+    replica_b
+        .prefetch(&client_hello(b"\x01\x02", &[(35, b"ticket")]))
+        .await;
+    assert!(replica_b.get(b"\x01\x02").is_none());
+
+    // Another replica with the same keys opens it.
+    replica_b
+        .prefetch(&client_hello(b"\x01\x02", &[(35, b""), (43, &[0x02, 0x03, 0x03])]))
+        .await;
+    assert_eq!(replica_b.get(b"\x01\x02").as_deref(), Some(b"master secret".as_slice()));
+
+    // A planted plaintext value, or a sealed one moved to another session ID, is a miss.
+    if let Ok(mut stored) = stored.lock() {
+        stored.insert("t:0a0b".to_string(), b"forged state".to_vec());
+        stored.insert("t:0c0d".to_string(), written);
+    }
+    replica_b.prefetch(&client_hello(b"\x0a\x0b", &[])).await;
+    replica_b.prefetch(&client_hello(b"\x0c\x0d", &[])).await;
+    assert!(replica_b.get(b"\x0a\x0b").is_none());
+    assert!(replica_b.get(b"\x0c\x0d").is_none());
+    Ok(())
+}
@@ -1,6 +1,20 @@
 /// Default interval for detecting eBPF maps replaced by the agent.
 pub const DEFAULT_RECONNECT_POLL_SECS: u64 = 5;
 
+/// Default SYN tick coalescing window: 0 = read the tick on every lookup.
+pub const DEFAULT_TICK_COALESCE_US: u64 = 0;
+
+/// Where the proxy gets captured SYNs from (`HUGINN_EBPF_SYN_SOURCE`).
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Default)]
+pub enum SynSource {
+    /// Look up the pinned LRU maps on every accept (default).
+    #[default]
+    Map,
+    /// Drain the pinned `syn_events` ring buffer into an in-process cache and look up there,
+    /// falling back to the LRU maps on a cache miss.
+    RingBuf,
+}
+
 #[derive(Debug, thiserror::Error, PartialEq, Eq)]
 pub enum ParseError {
     #[error("environment variable {name}: invalid value '{value}': {reason}")]
@@ -23,3 +37,42 @@ pub fn reconnect_poll_secs_from_env(raw: Option<String>) -> Result<u64, ParseErr
     .transpose()
     .map(|opt| opt.unwrap_or(DEFAULT_RECONNECT_POLL_SECS))
 }
+
+/// Parse `HUGINN_EBPF_TICK_COALESCE_US`, defaulting when unset.
+pub fn tick_coalesce_us_from_env(raw: Option<String>) -> Result<u64, ParseError> {
+    raw.map(|value| {
+        value.parse().map_err(|_| ParseError::Invalid {
+            name: "HUGINN_EBPF_TICK_COALESCE_US",
+            value,
+            reason: "must be a non-negative integer",
+        })
+    })
+    .transpose()
+    .map(|opt| opt.unwrap_or(DEFAULT_TICK_COALESCE_US))
+}
+
+/// Parse `HUGINN_EBPF_SYN_SOURCE` (`map` or `ringbuf`), defaulting when unset.
+pub fn syn_source_from_env(raw: Option<String>) -> Result<SynSource, ParseError> {
+    match raw.as_deref() {
+        None | Some("map") => Ok(SynSource::Map),
+        Some("ringbuf") => Ok(SynSource::RingBuf),
+        Some(_) => Err(ParseError::Invalid {
+            name: "HUGINN_EBPF_SYN_SOURCE",
+            value: raw.unwrap_or_default(),
+            reason: "must be `map` or `ringbuf`",
+        }),
+    }
+}
+
+/// Parse `HUGINN_EBPF_SYN_DENYLIST` (`true` or `false`), defaulting to `false` when unset.
+pub fn syn_denylist_from_env(raw: Option<String>) -> Result<bool, ParseError> {
+    match raw.as_deref() {
+        None | Some("false") => Ok(false),
+        Some("true") => Ok(true),
+        Some(_) => Err(ParseError::Invalid {
+            name: "HUGINN_EBPF_SYN_DENYLIST",
+            value: raw.unwrap_or_default(),
+            reason: "must be `true` or `false`",
+        }),
+    }
+}
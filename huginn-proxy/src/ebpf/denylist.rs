@@ -0,0 +1,165 @@
+//! Mirror of the global `[security.ip_filter]` denylist into the agent's kernel tries
+//! (`HUGINN_EBPF_SYN_DENYLIST=true`), so the capture program drops listed sources at the SYN.
+
+use arc_swap::ArcSwap;
+use huginn_proxy_lib::config::DynamicConfig;
+use huginn_proxy_lib::proxy::shutdown::{ServiceHandle, ShutdownWatch};
+use std::sync::Arc;
+
+#[cfg(feature = "ebpf-tcp")]
+use {
+    super::config::syn_denylist_from_env,
+    huginn_ebpf::SynDenylist,
+    huginn_proxy_lib::config::{IpFilterConfig, IpFilterMode},
+    huginn_proxy_lib::proxy::shutdown::ServiceName,
+    std::{
+        env,
+        net::{IpAddr, Ipv4Addr, Ipv6Addr},
+        time::Duration,
+    },
+    tokio::time::MissedTickBehavior,
+};
+
+/// How often the task checks for a reloaded filter or replaced tries.
+#[cfg(feature = "ebpf-tcp")]
+const SYNC_INTERVAL: Duration = Duration::from_secs(1);
+
+/// Start the denylist mirror when `HUGINN_EBPF_SYN_DENYLIST=true`; `None` otherwise.
+///
+/// The kernel sees neither SNI nor Host, so only the global denylist is mirrored, and it applies
+/// to every domain: a domain or route `ip_filter` cannot re-allow a source it lists. In
+/// `allowlist` or `disabled` mode the tries are kept empty.
+#[cfg(feature = "ebpf-tcp")]
+pub fn spawn_syn_denylist(
+    dynamic_cfg: Arc<ArcSwap<DynamicConfig>>,
+    shutdown_rx: ShutdownWatch,
+) -> Option<ServiceHandle> {
+    match syn_denylist_from_env(env::var("HUGINN_EBPF_SYN_DENYLIST").ok()) {
+        Ok(true) => {}
+        Ok(false) => return None,
+        Err(error) => {
+            tracing::error!(%error, "invalid eBPF configuration");
+            return None;
+        }
+    }
+    let pin_path = env::var("HUGINN_EBPF_PIN_PATH")
+        .unwrap_or_else(|_| huginn_ebpf::pin::DEFAULT_PIN_BASE.to_string());
+    let handle = tokio::spawn(sync_denylist(dynamic_cfg, pin_path, shutdown_rx));
+    Some(ServiceHandle { handle, name: ServiceName::EbpfDenylist })
+}
+
+/// Background task: (re)opens the pinned tries and writes the global denylist into them whenever
+/// it changed on reload or the agent recreated the tries (which come back empty).
+#[cfg(feature = "ebpf-tcp")]
+async fn sync_denylist(
+    dynamic_cfg: Arc<ArcSwap<DynamicConfig>>,
+    pin_path: String,
+    mut shutdown_rx: ShutdownWatch,
+) {
+    let mut interval = tokio::time::interval(SYNC_INTERVAL);
+    interval.set_missed_tick_behavior(MissedTickBehavior::Skip);
+    let mut writer: Option<SynDenylist> = None;
+    // The filter last written to the current tries.
+    let mut synced: Option<Arc<IpFilterConfig>> = None;
+
+    loop {
+        tokio::select! {
+            biased;
+            _ = shutdown_rx.wait_for(|shutting_down| *shutting_down) => {
+                tracing::info!("eBPF SYN denylist sync shutting down");
+                break;
+            }
+            _ = interval.tick() => {}
+        }
+
+        let replaced = writer.as_ref().is_some_and(|current| {
+            SynDenylist::map_ids_from_path(&pin_path).ok() != Some(current.map_ids())
+        });
+        if replaced {
+            writer = None;
+            synced = None;
+        }
+        if writer.is_none() {
+            match SynDenylist::from_pinned(&pin_path) {
+                Ok(opened) => writer = Some(opened),
+                Err(error) => {
+                    tracing::debug!(%error, pin_path, "eBPF SYN denylist maps not available yet");
+                    continue;
+                }
+            }
+        }
+        let Some(current) = writer.as_mut() else {
+            continue;
+        };
+
+        let cfg = dynamic_cfg.load();
+        let filter = &cfg.security.ip_filter;
+        if synced
+            .as_ref()
+            .is_some_and(|last| Arc::ptr_eq(last, filter) || last == filter)
+        {
+            continue;
+        }
+        let (v4, v6) = denylist_prefixes(filter);
+        match current.replace(&v4, &v6) {
+            Ok(update) => {
+                tracing::info!(
+                    added = update.added,
+                    removed = update.removed,
+                    entries = update.entries,
+                    "eBPF SYN denylist synced"
+                );
+                if update.entries > 0 && has_scoped_ip_filters(&cfg) {
+                    tracing::warn!(
+                        "the eBPF SYN denylist applies to every domain; domain and route \
+                         ip_filter overrides cannot re-allow the sources it lists"
+                    );
+                }
+                synced = Some(Arc::clone(filter));
+            }
+            Err(error) => {
+                tracing::warn!(%error, pin_path, "eBPF SYN denylist update failed; retrying");
+            }
+        }
+    }
+}
+
+/// The prefixes to drop in the kernel: the global denylist in `denylist` mode, none otherwise.
+#[cfg(feature = "ebpf-tcp")]
+fn denylist_prefixes(filter: &IpFilterConfig) -> (Vec<(Ipv4Addr, u8)>, Vec<(Ipv6Addr, u8)>) {
+    let mut v4 = Vec::new();
+    let mut v6 = Vec::new();
+    if filter.mode == IpFilterMode::Denylist {
+        for net in &filter.denylist {
+            match net.network() {
+                IpAddr::V4(addr) => v4.push((addr, net.prefix_len())),
+                IpAddr::V6(addr) => v6.push((addr, net.prefix_len())),
+            }
+        }
+    }
+    (v4, v6)
+}
+
+#[cfg(feature = "ebpf-tcp")]
+fn has_scoped_ip_filters(cfg: &DynamicConfig) -> bool {
+    cfg.domains.iter().any(|domain| {
+        domain
+            .security
+            .as_ref()
+            .is_some_and(|s| s.ip_filter.is_some())
+            || domain.routes.iter().any(|route| {
+                route
+                    .security
+                    .as_ref()
+                    .is_some_and(|s| s.ip_filter.is_some())
+            })
+    })
+}
+
+#[cfg(not(feature = "ebpf-tcp"))]
+pub fn spawn_syn_denylist(
+    _dynamic_cfg: Arc<ArcSwap<DynamicConfig>>,
+    _shutdown_rx: ShutdownWatch,
+) -> Option<ServiceHandle> {
+    None
+}
@@ -1,4 +1,5 @@
 pub mod config;
+mod denylist;
 
 use huginn_proxy_lib::config::StaticConfig;
 use huginn_proxy_lib::proxy::shutdown::{ServiceHandle, ShutdownWatch};
@@ -6,20 +7,37 @@ use huginn_proxy_lib::telemetry::Metrics;
 use huginn_proxy_lib::SynProbe;
 use std::sync::Arc;
 
+pub use denylist::spawn_syn_denylist;
+
 #[cfg(feature = "ebpf-tcp")]
 use {
-    self::config::reconnect_poll_secs_from_env,
+    self::config::{
+        reconnect_poll_secs_from_env, syn_source_from_env, tick_coalesce_us_from_env, SynSource,
+    },
     arc_swap::ArcSwap,
-    huginn_ebpf::{parse_syn_v4, parse_syn_v6, EbpfProbe},
+    huginn_ebpf::{parse_syn_v4, parse_syn_v6, EbpfProbe, LookupMode, SynCache, SynEventReader},
     huginn_proxy_lib::fingerprinting::SynResult,
     huginn_proxy_lib::proxy::shutdown::ServiceName,
     std::{env, net::SocketAddr, time::Duration},
-    tokio::time::MissedTickBehavior,
+    tokio::io::{unix::AsyncFd, Interest},
+    tokio::time::{Interval, MissedTickBehavior},
 };
 
 #[cfg(feature = "ebpf-tcp")]
 const RETRY_INTERVAL: Duration = Duration::from_secs(2);
 
+/// `mode` label of SYN lookups served from the `syn_events` cache.
+#[cfg(feature = "ebpf-tcp")]
+const RINGBUF_MODE: &str = "ringbuf";
+
+/// The `syn_events` consumer and the cache it fills (`HUGINN_EBPF_SYN_SOURCE=ringbuf`).
+#[cfg(feature = "ebpf-tcp")]
+struct SynEvents {
+    reader: AsyncFd<SynEventReader>,
+    /// Replaced together with the reader: a recreated ring restarts the tick counter.
+    cache: Arc<ArcSwap<SynCache>>,
+}
+
 #[cfg(feature = "ebpf-tcp")]
 pub async fn connect_syn_probe(
     static_cfg: &StaticConfig,
@@ -41,10 +59,26 @@ pub async fn connect_syn_probe(
                 return (None, None);
             }
         };
+    let lookup_mode = match tick_coalesce_us_from_env(env::var("HUGINN_EBPF_TICK_COALESCE_US").ok())
+    {
+        Ok(0) => LookupMode::Direct,
+        Ok(us) => LookupMode::Coalesced(Duration::from_micros(us)),
+        Err(error) => {
+            tracing::error!(%error, "invalid eBPF configuration");
+            return (None, None);
+        }
+    };
+    let syn_source = match syn_source_from_env(env::var("HUGINN_EBPF_SYN_SOURCE").ok()) {
+        Ok(value) => value,
+        Err(error) => {
+            tracing::error!(%error, "invalid eBPF configuration");
+            return (None, None);
+        }
+    };
 
     let probe = loop {
         match EbpfProbe::from_pinned(&pin_path) {
-            Ok(probe) => break probe,
+            Ok(probe) => break probe.with_lookup_mode(lookup_mode),
             Err(_) => {
                 tracing::warn!(
                     pin_path,
@@ -56,30 +90,80 @@ pub async fn connect_syn_probe(
         }
     };
 
+    let events = match syn_source {
+        SynSource::Map => None,
+        SynSource::RingBuf => match open_syn_events(&pin_path) {
+            Ok(reader) => {
+                let cache = SynCache::new(probe.syn_map_max_entries());
+                Some(SynEvents { reader, cache: Arc::new(ArcSwap::from_pointee(cache)) })
+            }
+            Err(error) => {
+                tracing::warn!(
+                    %error,
+                    pin_path,
+                    "eBPF SYN event ring unavailable; falling back to SYN map lookups"
+                );
+                None
+            }
+        },
+    };
+
     let probe = Arc::new(ArcSwap::from_pointee(probe));
     let lookup_probe = Arc::clone(&probe);
-    let syn_probe: SynProbe = Arc::new(move |peer| {
+    let lookup_cache = events.as_ref().map(|events| Arc::clone(&events.cache));
+    let mode = if lookup_cache.is_some() {
+        RINGBUF_MODE
+    } else {
+        lookup_mode.as_str()
+    };
+    let syn_probe = SynProbe::new(mode, move |peer| {
         let current = lookup_probe.load();
-        lookup_syn(current.as_ref(), peer)
+        let cache = lookup_cache.as_ref().map(|cache| cache.load());
+        lookup_syn(current.as_ref(), cache.as_deref().map(|cache| &**cache), peer)
     });
 
     if reconnect_poll_secs == 0 {
         tracing::info!("automatic eBPF pinned-map reconnection disabled");
-        return (Some(syn_probe), None);
+        if events.is_none() {
+            return (Some(syn_probe), None);
+        }
     }
 
-    let poll_interval = Duration::from_secs(reconnect_poll_secs);
-    let handle =
-        tokio::spawn(watch_pinned_maps(probe, pin_path, poll_interval, metrics, shutdown_rx));
-    let watcher = ServiceHandle { handle, name: ServiceName::EbpfReconnect };
+    let poll_interval =
+        (reconnect_poll_secs != 0).then(|| Duration::from_secs(reconnect_poll_secs));
+    let name = if events.is_some() {
+        ServiceName::EbpfSynEvents
+    } else {
+        ServiceName::EbpfReconnect
+    };
+    let handle = tokio::spawn(watch_pinned_maps(
+        probe,
+        pin_path,
+        lookup_mode,
+        poll_interval,
+        events,
+        metrics,
+        shutdown_rx,
+    ));
+    let watcher = ServiceHandle { handle, name };
     (Some(syn_probe), Some(watcher))
 }
 
 #[cfg(feature = "ebpf-tcp")]
-fn lookup_syn(probe: &EbpfProbe, peer: SocketAddr) -> SynResult {
+fn open_syn_events(pin_path: &str) -> std::io::Result<AsyncFd<SynEventReader>> {
+    let reader = SynEventReader::from_pinned(pin_path).map_err(std::io::Error::other)?;
+    AsyncFd::with_interest(reader, Interest::READABLE)
+}
+
+/// Resolve the SYN for `peer`: from the event cache when one is in use, otherwise (or on a
+/// cache miss, e.g. a sample the ring dropped or not drained yet) from the pinned LRU maps.
+#[cfg(feature = "ebpf-tcp")]
+fn lookup_syn(probe: &EbpfProbe, cache: Option<&SynCache>, peer: SocketAddr) -> SynResult {
     match peer {
         SocketAddr::V4(address) => {
-            let Some(raw) = probe.lookup(*address.ip(), address.port()) else {
+            let (ip, port) = (*address.ip(), address.port());
+            let cached = cache.and_then(|cache| cache.take_v4(ip, port));
+            let Some(raw) = cached.or_else(|| probe.lookup(ip, port)) else {
                 return SynResult::Miss;
             };
             match parse_syn_v4(&raw) {
@@ -88,7 +172,9 @@ fn lookup_syn(probe: &EbpfProbe, peer: SocketAddr) -> SynResult {
             }
         }
         SocketAddr::V6(address) => {
-            let Some(raw) = probe.lookup_v6(*address.ip(), address.port()) else {
+            let (ip, port) = (*address.ip(), address.port());
+            let cached = cache.and_then(|cache| cache.take_v6(ip, port));
+            let Some(raw) = cached.or_else(|| probe.lookup_v6(ip, port)) else {
                 return SynResult::Miss;
             };
             match parse_syn_v6(&raw) {
@@ -99,67 +185,132 @@ fn lookup_syn(probe: &EbpfProbe, peer: SocketAddr) -> SynResult {
     }
 }
 
+/// Background task: polls for replaced pinned maps every `poll_interval` (when set) and drains
+/// the SYN event ring whenever it is readable (when `events` is set).
 #[cfg(feature = "ebpf-tcp")]
 async fn watch_pinned_maps(
     probe: Arc<ArcSwap<EbpfProbe>>,
     pin_path: String,
-    poll_interval: Duration,
+    lookup_mode: LookupMode,
+    poll_interval: Option<Duration>,
+    mut events: Option<SynEvents>,
     metrics: Arc<Metrics>,
     mut shutdown_rx: ShutdownWatch,
 ) {
-    let mut interval = tokio::time::interval(poll_interval);
-    interval.set_missed_tick_behavior(MissedTickBehavior::Skip);
-    interval.tick().await;
+    let mut interval = poll_interval.map(|period| {
+        let mut interval = tokio::time::interval(period);
+        interval.set_missed_tick_behavior(MissedTickBehavior::Skip);
+        // First tick one period from now, not immediately.
+        interval.reset();
+        interval
+    });
 
     loop {
         tokio::select! {
             biased;
             _ = shutdown_rx.wait_for(|shutting_down| *shutting_down) => {
-                tracing::info!("eBPF pinned-map reconnect watcher shutting down");
+                tracing::info!("eBPF pinned-map watcher shutting down");
                 break;
             }
-            _ = interval.tick() => {
-                if let Err(error) = reconnect_if_changed(
-                    &probe,
-                    &pin_path,
-                    &metrics,
-                ) {
-                    tracing::debug!(
+            _ = next_tick(&mut interval) => {
+                match reconnect_if_changed(&probe, &pin_path, lookup_mode, &metrics) {
+                    Ok(true) => {
+                        let syn_map_max_entries = probe.load().syn_map_max_entries();
+                        if let Some(current) = events.as_mut() {
+                            if let Err(error) = current.reopen(&pin_path, syn_map_max_entries) {
+                                tracing::warn!(
+                                    %error,
+                                    pin_path,
+                                    "replacement eBPF SYN event ring unavailable; \
+                                     falling back to SYN map lookups"
+                                );
+                                events = None;
+                            }
+                        }
+                    }
+                    Ok(false) => {}
+                    Err(error) => {
+                        tracing::debug!(
+                            %error,
+                            pin_path,
+                            "eBPF pins unavailable or changing; retaining current maps"
+                        );
+                    }
+                }
+            }
+            drained = drain_syn_events(&mut events) => {
+                if let Err(error) = drained {
+                    tracing::warn!(
                         %error,
-                        pin_path,
-                        "eBPF pins unavailable or changing; retaining current maps"
+                        "eBPF SYN event ring readiness error; falling back to SYN map lookups"
                     );
+                    events = None;
                 }
             }
         }
     }
 }
 
+#[cfg(feature = "ebpf-tcp")]
+impl SynEvents {
+    fn reopen(&mut self, pin_path: &str, syn_map_max_entries: u32) -> std::io::Result<()> {
+        self.reader = open_syn_events(pin_path)?;
+        self.cache
+            .store(Arc::new(SynCache::new(syn_map_max_entries)));
+        Ok(())
+    }
+}
+
+/// Wait for the next reconnect poll; never completes when polling is disabled.
+#[cfg(feature = "ebpf-tcp")]
+async fn next_tick(interval: &mut Option<Interval>) {
+    match interval {
+        Some(interval) => {
+            interval.tick().await;
+        }
+        None => std::future::pending().await,
+    }
+}
+
+/// Wait until the SYN event ring is readable and move its samples into the cache; never
+/// completes without a ring.
+#[cfg(feature = "ebpf-tcp")]
+async fn drain_syn_events(events: &mut Option<SynEvents>) -> std::io::Result<()> {
+    let Some(SynEvents { reader, cache }) = events else {
+        return std::future::pending().await;
+    };
+    let mut guard = reader.readable_mut().await?;
+    guard.get_inner_mut().drain(&cache.load());
+    guard.clear_ready();
+    Ok(())
+}
+
 #[cfg(feature = "ebpf-tcp")]
 fn reconnect_if_changed(
     probe: &ArcSwap<EbpfProbe>,
     pin_path: &str,
+    lookup_mode: LookupMode,
     metrics: &Metrics,
-) -> Result<(), huginn_ebpf::EbpfError> {
+) -> Result<bool, huginn_ebpf::EbpfError> {
     let current = probe.load();
     let Some(old_ids) = current.pinned_map_ids() else {
-        return Ok(());
+        return Ok(false);
     };
     let published_ids = EbpfProbe::pinned_map_ids_from_path(pin_path)?;
     if published_ids == old_ids {
-        return Ok(());
+        return Ok(false);
     }
     drop(current);
 
-    let replacement = EbpfProbe::from_pinned(pin_path)?;
+    let replacement = EbpfProbe::from_pinned(pin_path)?.with_lookup_mode(lookup_mode);
     let Some(new_ids) = replacement.pinned_map_ids() else {
-        return Ok(());
+        return Ok(false);
     };
 
     // The agent removes and re-pins maps sequentially. Publish only a complete,
     // still-current snapshot; otherwise retry on the next tick.
     if EbpfProbe::pinned_map_ids_from_path(pin_path)? != new_ids {
-        return Ok(());
+        return Ok(false);
     }
 
     probe.store(Arc::new(replacement));
@@ -176,7 +327,7 @@ fn reconnect_if_changed(
         new_ipv6_map_id = new_ids.ipv6,
         "reconnected to replacement eBPF pinned maps"
     );
-    Ok(())
+    Ok(true)
 }
 
 #[cfg(not(feature = "ebpf-tcp"))]
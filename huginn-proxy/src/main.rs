@@ -13,7 +13,8 @@ use huginn_proxy_lib::config::load_from_path;
 use huginn_proxy_lib::proxy::shutdown::{shutdown_channel, ServiceHandle, ServiceName};
 use huginn_proxy_lib::run;
 use huginn_proxy_lib::telemetry::{
-    init_metrics, init_tracing_with_otel, shutdown_tracing, start_observability_server, Readiness,
+    init_metrics, init_tracing_with_otel, shutdown_tracing, start_observability_server,
+    DebugEndpoints, Readiness,
 };
 use huginn_proxy_lib::WatchOptions;
 use tokio::time::Duration;
@@ -97,6 +98,7 @@ async fn main() -> Result<(), BoxError> {
         if let Some(metrics_port) = static_cfg.telemetry.metrics_port {
             info!(port = metrics_port, "Metrics initialized, starting observability server");
             let readiness_for_observability = readiness.clone();
+            let debug_endpoints = DebugEndpoints::new(&static_cfg.telemetry.debug);
             let mut metrics_shutdown = shutdown_rx.clone();
             let handle = tokio::spawn(async move {
                 tokio::select! {
@@ -108,6 +110,7 @@ async fn main() -> Result<(), BoxError> {
                         metrics_port,
                         registry,
                         readiness_for_observability,
+                        debug_endpoints,
                     ) => {
                         if let Err(e) = result {
                             tracing::error!(error = %e, "Observability server error");
@@ -124,6 +127,8 @@ async fn main() -> Result<(), BoxError> {
 
     let (syn_probe, ebpf_reconnect_service) =
         ebpf::connect_syn_probe(&static_cfg, Arc::clone(&metrics), shutdown_rx.clone()).await;
+    let ebpf_denylist_service =
+        ebpf::spawn_syn_denylist(Arc::clone(&dynamic_cfg), shutdown_rx.clone());
 
     info!("huginn-proxy starting");
 
@@ -153,6 +158,9 @@ async fn main() -> Result<(), BoxError> {
     if let Some(svc) = ebpf_reconnect_service {
         svc.shutdown(Duration::from_secs(2)).await;
     }
+    if let Some(svc) = ebpf_denylist_service {
+        svc.shutdown(Duration::from_secs(2)).await;
+    }
 
     // All background tasks have exited and flushed their logs, safe to tear down tracing.
     shutdown_tracing();
@@ -1,5 +1,7 @@
 use huginn_proxy::ebpf::config::{
-    reconnect_poll_secs_from_env, ParseError, DEFAULT_RECONNECT_POLL_SECS,
+    reconnect_poll_secs_from_env, syn_denylist_from_env, syn_source_from_env,
+    tick_coalesce_us_from_env, ParseError, SynSource, DEFAULT_RECONNECT_POLL_SECS,
+    DEFAULT_TICK_COALESCE_US,
 };
 
 #[test]
@@ -24,3 +26,56 @@ fn reconnect_poll_accepts_zero_and_positive_values() {
     assert_eq!(reconnect_poll_secs_from_env(Some("0".to_string())), Ok(0));
     assert_eq!(reconnect_poll_secs_from_env(Some("17".to_string())), Ok(17));
 }
+
+#[test]
+fn tick_coalesce_defaults_to_per_lookup_reads() {
+    assert_eq!(tick_coalesce_us_from_env(None), Ok(DEFAULT_TICK_COALESCE_US));
+    assert_eq!(DEFAULT_TICK_COALESCE_US, 0);
+}
+
+#[test]
+fn tick_coalesce_parses_microseconds() {
+    assert_eq!(tick_coalesce_us_from_env(Some("250".to_string())), Ok(250));
+    assert_eq!(
+        tick_coalesce_us_from_env(Some("-1".to_string())),
+        Err(ParseError::Invalid {
+            name: "HUGINN_EBPF_TICK_COALESCE_US",
+            value: "-1".to_string(),
+            reason: "must be a non-negative integer",
+        })
+    );
+}
+
+#[test]
+fn syn_source_defaults_to_map_lookups() {
+    assert_eq!(syn_source_from_env(None), Ok(SynSource::Map));
+    assert_eq!(syn_source_from_env(Some("map".to_string())), Ok(SynSource::Map));
+    assert_eq!(syn_source_from_env(Some("ringbuf".to_string())), Ok(SynSource::RingBuf));
+}
+
+#[test]
+fn syn_source_rejects_unknown_values() {
+    assert_eq!(
+        syn_source_from_env(Some("RingBuf".to_string())),
+        Err(ParseError::Invalid {
+            name: "HUGINN_EBPF_SYN_SOURCE",
+            value: "RingBuf".to_string(),
+            reason: "must be `map` or `ringbuf`",
+        })
+    );
+}
+
+#[test]
+fn syn_denylist_defaults_to_off() {
+    assert_eq!(syn_denylist_from_env(None), Ok(false));
+    assert_eq!(syn_denylist_from_env(Some("false".to_string())), Ok(false));
+    assert_eq!(syn_denylist_from_env(Some("true".to_string())), Ok(true));
+    assert_eq!(
+        syn_denylist_from_env(Some("yes".to_string())),
+        Err(ParseError::Invalid {
+            name: "HUGINN_EBPF_SYN_DENYLIST",
+            value: "yes".to_string(),
+            reason: "must be `true` or `false`",
+        })
+    );
+}